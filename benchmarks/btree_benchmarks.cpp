@@ -0,0 +1,216 @@
+#include "benchmark_runner.h"
+#include "../src/storage/btree.h"
+#include "../src/storage/bplus_tree.h"
+#include "../src/storage/concurrent_bplus_tree.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+using namespace phantomdb::benchmark;
+using phantomdb::storage::BTree;
+using phantomdb::storage::BPlusTree;
+using phantomdb::storage::ConcurrentBPlusTree;
+
+namespace {
+
+const int KEYS_PER_RUN = 200000;
+const int OPERATIONS_PER_RUN = 400000;
+const int BULK_KEYS = 2000000;
+
+std::vector<int> shuffledKeys(int count, unsigned seed) {
+    std::vector<int> keys(count);
+    for (int i = 0; i < count; ++i) {
+        keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+    return keys;
+}
+
+// Keys with a shared prefix, as a tenant-scoped or URL-like column has
+std::string stringKey(int key) {
+    return "tenant-0042/orders/" + std::to_string(key);
+}
+
+BenchmarkResult finish(BenchmarkResult result, long operations) {
+    result.iterations = operations;
+    result.throughput_ops_per_sec = (operations / result.duration_ms) * 1000.0;
+    return result;
+}
+
+// Insert keys in the given order, then look every one of them up in another
+template<typename Tree, typename MakeKey>
+void runTree(const std::string& name, const std::vector<int>& insertOrder, const std::vector<int>& lookupOrder,
+             MakeKey makeKey, std::vector<BenchmarkResult>& results) {
+    Tree tree;
+    BenchmarkRunner insertRunner(name + " insert");
+    auto insert = insertRunner.run([&]() {
+        for (int key : insertOrder) {
+            tree.insert(makeKey(key), key);
+        }
+    }, 1);
+    results.push_back(finish(insert, static_cast<long>(insertOrder.size())));
+    
+    // Keys are built up front so the lookups measure only the tree
+    std::vector<decltype(makeKey(0))> probes;
+    probes.reserve(lookupOrder.size());
+    for (int key : lookupOrder) {
+        probes.push_back(makeKey(key));
+    }
+    long found = 0;
+    BenchmarkRunner searchRunner(name + " search");
+    auto search = searchRunner.run([&]() {
+        int value;
+        for (const auto& key : probes) {
+            found += tree.search(key, value) ? 1 : 0;
+        }
+    }, 1);
+    search = finish(search, static_cast<long>(probes.size()));
+    search.additional_metrics["hit_rate"] = static_cast<double>(found) / probes.size();
+    results.push_back(search);
+}
+
+// The single-threaded tree behind one reader-writer lock
+class LockedBPlusTree {
+public:
+    void insert(int key, int value) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        tree_.insert(key, value);
+    }
+    
+    bool search(int key, int& value) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return tree_.search(key, value);
+    }
+
+private:
+    mutable std::shared_mutex mutex_;
+    BPlusTree<int, int> tree_;
+};
+
+// Optimistic restarts per operation, where the tree keeps count
+double restartsPerOperation(const LockedBPlusTree&, int) {
+    return 0.0;
+}
+
+double restartsPerOperation(const ConcurrentBPlusTree<int, int>& tree, int operations) {
+    return static_cast<double>(tree.getRestarts()) / operations;
+}
+
+// insertPercent of the operations insert fresh keys, the rest look up
+// preloaded ones, spread over threadCount threads
+template<typename Tree>
+BenchmarkResult runMix(const std::string& name, int threadCount, int insertPercent) {
+    Tree tree;
+    for (int key = 0; key < KEYS_PER_RUN; ++key) {
+        tree.insert(key * 2, key);
+    }
+    
+    BenchmarkRunner runner(name + " " + std::to_string(100 - insertPercent) + "% lookups (" +
+                           std::to_string(threadCount) + " threads)");
+    std::atomic<long> hits(0);
+    auto result = runner.run([&]() {
+        std::vector<std::thread> threads;
+        int perThread = OPERATIONS_PER_RUN / threadCount;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&tree, &hits, t, perThread, insertPercent]() {
+                std::mt19937 rng(t);
+                int value;
+                long found = 0;
+                for (int i = 0; i < perThread; ++i) {
+                    if (static_cast<int>(rng() % 100) < insertPercent) {
+                        // Odd keys, disjoint between threads
+                        int key = (t * perThread + i) * 2 + 1;
+                        tree.insert(key, i);
+                    } else {
+                        found += tree.search(static_cast<int>(rng() % KEYS_PER_RUN) * 2, value) ? 1 : 0;
+                    }
+                }
+                hits += found;
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }, 1);
+    result = finish(result, OPERATIONS_PER_RUN);
+    result.additional_metrics["threads"] = threadCount;
+    result.additional_metrics["lookups_found"] = static_cast<double>(hits);
+    result.additional_metrics["restarts_per_op"] = restartsPerOperation(tree, OPERATIONS_PER_RUN);
+    return result;
+}
+
+// Build an index over unsorted rows one insert at a time, or bottom up
+BenchmarkResult runBuild(bool bulk, const std::vector<std::pair<int, int>>& rows) {
+    BPlusTree<int, int> tree;
+    BenchmarkRunner runner(bulk ? "BPlusTree build (bulk load)" : "BPlusTree build (inserts)");
+    auto result = runner.run([&]() {
+        if (bulk) {
+            tree.bulkLoad(rows);
+        } else {
+            for (const auto& row : rows) {
+                tree.insert(row.first, row.second);
+            }
+        }
+    }, 1);
+    result = finish(result, static_cast<long>(rows.size()));
+    result.additional_metrics["memory_mb"] = tree.getMemoryUsage() / (1024.0 * 1024.0);
+    result.additional_metrics["height"] = tree.getHeight();
+    return result;
+}
+
+} // anonymous namespace
+
+int main() {
+    std::cout << "Running PhantomDB B-tree Benchmarks..." << std::endl;
+    
+    std::vector<BenchmarkResult> results;
+    std::vector<int> ascending = shuffledKeys(KEYS_PER_RUN, 1);
+    std::sort(ascending.begin(), ascending.end());
+    std::vector<int> random = shuffledKeys(KEYS_PER_RUN, 2);
+    std::vector<int> lookups = shuffledKeys(KEYS_PER_RUN, 3);
+    auto intKey = [](int key) { return key; };
+    
+    // Benchmark 1: Integer keys in random order
+    runTree<BTree<int, int>>("BTree int random", random, lookups, intKey, results);
+    runTree<BPlusTree<int, int>>("BPlusTree int random", random, lookups, intKey, results);
+    
+    // Benchmark 2: Integer keys in ascending order (bulk appends)
+    runTree<BTree<int, int>>("BTree int ascending", ascending, lookups, intKey, results);
+    runTree<BPlusTree<int, int>>("BPlusTree int ascending", ascending, lookups, intKey, results);
+    
+    // Benchmark 3: String keys in random order
+    runTree<BTree<std::string, int>>("BTree string random", random, lookups, stringKey, results);
+    runTree<BPlusTree<std::string, int>>("BPlusTree string random", random, lookups, stringKey, results);
+    
+    // Benchmark 4: Lookup-heavy and insert-heavy mixes from many threads
+    for (int insertPercent : {5, 80}) {
+        for (int threads : {8, 16, 32}) {
+            results.push_back(runMix<LockedBPlusTree>("Locked BPlusTree", threads, insertPercent));
+            results.push_back(runMix<ConcurrentBPlusTree<int, int>>("ConcurrentBPlusTree", threads, insertPercent));
+        }
+    }
+    
+    // Benchmark 5: Building an index over existing rows
+    {
+        std::vector<int> keys = shuffledKeys(BULK_KEYS, 4);
+        std::vector<std::pair<int, int>> rows;
+        rows.reserve(keys.size());
+        for (int key : keys) {
+            rows.emplace_back(key, key);
+        }
+        results.push_back(runBuild(false, rows));
+        results.push_back(runBuild(true, rows));
+    }
+    
+    // Print results
+    BenchmarkRunner::printResults(results);
+    
+    std::cout << "B-tree benchmarks completed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include "benchmark_runner.h"
+#include "../src/core/database.h"
+#include <iostream>
+#include <streambuf>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <algorithm>
+
+using namespace phantomdb::benchmark;
+
+namespace {
+
+const int ROWS_PER_TABLE = 2000;
+const int OPS_PER_THREAD = 2000;
+
+// Discards everything written to it
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// Silence the per-operation progress output of core::Database while timing
+class QuietScope {
+public:
+    QuietScope() : previous_(std::cout.rdbuf(&sink_)) {}
+    ~QuietScope() { std::cout.rdbuf(previous_); }
+
+private:
+    NullBuffer sink_;
+    std::streambuf* previous_;
+};
+
+std::string tableNameFor(int index) {
+    return "bench_table_" + std::to_string(index);
+}
+
+void populateTable(phantomdb::core::Database& db, const std::string& tableName) {
+    std::vector<std::pair<std::string, std::string>> columns = {
+        {"id", "integer"},
+        {"name", "string"},
+        {"score", "float"}
+    };
+    db.createTable("concurrency_db", tableName, columns);
+    
+    for (int i = 0; i < ROWS_PER_TABLE; ++i) {
+        db.insertData("concurrency_db", tableName, {
+            {"id", std::to_string(i)},
+            {"name", "User " + std::to_string(i)},
+            {"score", std::to_string(i % 100) + ".5"}
+        });
+    }
+}
+
+// Each worker runs a 90% read / 10% write mix against the given table
+void runWorker(phantomdb::core::Database& db, const std::string& tableName, int seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<> keyDist(0, ROWS_PER_TABLE - 1);
+    std::uniform_int_distribution<> opDist(0, 9);
+    
+    for (int i = 0; i < OPS_PER_THREAD; ++i) {
+        std::string key = std::to_string(keyDist(gen));
+        if (opDist(gen) == 0) {
+            db.updateData("concurrency_db", tableName, {{"name", "Updated " + key}}, {{"id", key}});
+        } else {
+            auto rows = db.selectData("concurrency_db", tableName, {{"id", key}});
+            volatile size_t count = rows.size();
+            (void)count;
+        }
+    }
+}
+
+BenchmarkResult runScaling(const std::string& name, int threadCount, bool sharedTable) {
+    phantomdb::core::Database db;
+    QuietScope quiet;
+    
+    db.createDatabase("concurrency_db");
+    int tableCount = sharedTable ? 1 : threadCount;
+    for (int t = 0; t < tableCount; ++t) {
+        populateTable(db, tableNameFor(t));
+    }
+    
+    BenchmarkRunner runner(name + " (" + std::to_string(threadCount) + " threads)");
+    return runner.run([&]() {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threadCount; ++t) {
+            std::string tableName = tableNameFor(sharedTable ? 0 : t);
+            workers.emplace_back(runWorker, std::ref(db), tableName, t + 1);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }, 1);
+}
+
+// Readers of one table while a writer rewrites every row of another table
+BenchmarkResult runReadersBesideSlowWriter(int readerCount) {
+    phantomdb::core::Database db;
+    QuietScope quiet;
+    
+    db.createDatabase("concurrency_db");
+    populateTable(db, "hot_table");
+    populateTable(db, "bulk_table");
+    
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        int round = 0;
+        while (!done.load()) {
+            db.updateData("concurrency_db", "bulk_table", {{"name", "Round " + std::to_string(round++)}});
+        }
+    });
+    
+    BenchmarkRunner runner("Readers Beside Full-Table Writer (" + std::to_string(readerCount) + " readers)");
+    auto result = runner.run([&]() {
+        std::vector<std::thread> readers;
+        for (int t = 0; t < readerCount; ++t) {
+            readers.emplace_back([&db, t]() {
+                std::mt19937 gen(t + 1);
+                std::uniform_int_distribution<> keyDist(0, ROWS_PER_TABLE - 1);
+                for (int i = 0; i < OPS_PER_THREAD; ++i) {
+                    auto rows = db.selectData("concurrency_db", "hot_table",
+                                              {{"id", std::to_string(keyDist(gen))}});
+                    volatile size_t count = rows.size();
+                    (void)count;
+                }
+            });
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+    }, 1);
+    
+    done.store(true);
+    writer.join();
+    return result;
+}
+
+} // anonymous namespace
+
+int main() {
+    std::cout << "Running PhantomDB Concurrency Benchmarks..." << std::endl;
+    
+    unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> threadCounts;
+    for (unsigned t = 1; t <= std::max(8u, hardwareThreads); t *= 2) {
+        threadCounts.push_back(static_cast<int>(t));
+    }
+    std::cout << "Hardware threads: " << hardwareThreads << std::endl;
+    
+    std::vector<BenchmarkResult> results;
+    
+    // Benchmark 1: Each thread works on its own table
+    double baseline = 0.0;
+    for (int threads : threadCounts) {
+        auto result = runScaling("Mixed Read/Write, Table Per Thread", threads, false);
+        result.iterations = static_cast<long>(threads) * OPS_PER_THREAD;
+        result.throughput_ops_per_sec = (result.iterations / result.duration_ms) * 1000.0;
+        if (threads == 1) {
+            baseline = result.throughput_ops_per_sec;
+        }
+        result.additional_metrics["threads"] = threads;
+        result.additional_metrics["speedup_vs_1_thread"] = result.throughput_ops_per_sec / baseline;
+        results.push_back(result);
+    }
+    
+    // Benchmark 2: All threads share a single table
+    for (int threads : threadCounts) {
+        auto result = runScaling("Mixed Read/Write, Shared Table", threads, true);
+        result.iterations = static_cast<long>(threads) * OPS_PER_THREAD;
+        result.throughput_ops_per_sec = (result.iterations / result.duration_ms) * 1000.0;
+        if (threads == 1) {
+            baseline = result.throughput_ops_per_sec;
+        }
+        result.additional_metrics["threads"] = threads;
+        result.additional_metrics["speedup_vs_1_thread"] = result.throughput_ops_per_sec / baseline;
+        results.push_back(result);
+    }
+    
+    // Benchmark 3: Point readers are not stalled by a writer on another table
+    for (int threads : threadCounts) {
+        auto result = runReadersBesideSlowWriter(threads);
+        result.iterations = static_cast<long>(threads) * OPS_PER_THREAD;
+        result.throughput_ops_per_sec = (result.iterations / result.duration_ms) * 1000.0;
+        result.additional_metrics["readers"] = threads;
+        results.push_back(result);
+    }
+    
+    // Print results
+    BenchmarkRunner::printResults(results);
+    
+    std::cout << "Concurrency benchmarks completed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include "benchmark_runner.h"
+#include "../src/storage/hash_table.h"
+#include "../src/storage/swiss_table.h"
+#include "../src/storage/concurrent_hash_table.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <chrono>
+
+using namespace phantomdb::benchmark;
+using phantomdb::storage::HashTable;
+using phantomdb::storage::SwissTable;
+using phantomdb::storage::ConcurrentHashTable;
+
+namespace {
+
+// The chained table never grows past its 100 buckets, so keep this modest
+const int KEYS_PER_RUN = 100000;
+
+// Keys present before, and inserted during, the resize latency runs
+const int RESIZE_PRELOADED_KEYS = 100000;
+const int RESIZE_INSERTED_KEYS = 4000000;
+const int RESIZE_READERS = 2;
+
+BenchmarkResult finish(BenchmarkResult result, long operations) {
+    result.iterations = operations;
+    result.throughput_ops_per_sec = (operations / result.duration_ms) * 1000.0;
+    return result;
+}
+
+// Insert every key, then look up each one and as many absent ones
+template<typename Table, typename Key>
+void runTable(const std::string& name, const std::vector<Key>& keys, const std::vector<Key>& absent,
+              std::vector<BenchmarkResult>& results) {
+    Table table;
+    BenchmarkRunner insertRunner(name + " insert");
+    auto insert = insertRunner.run([&]() {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            table.insert(keys[i], static_cast<int>(i));
+        }
+    }, 1);
+    results.push_back(finish(insert, static_cast<long>(keys.size())));
+    
+    long found = 0;
+    BenchmarkRunner searchRunner(name + " search (hit)");
+    auto hit = searchRunner.run([&]() {
+        int value;
+        for (const auto& key : keys) {
+            found += table.search(key, value) ? 1 : 0;
+        }
+    }, 1);
+    hit = finish(hit, static_cast<long>(keys.size()));
+    hit.additional_metrics["hit_rate"] = static_cast<double>(found) / keys.size();
+    results.push_back(hit);
+    
+    found = 0;
+    BenchmarkRunner missRunner(name + " search (miss)");
+    auto miss = missRunner.run([&]() {
+        int value;
+        for (const auto& key : absent) {
+            found += table.search(key, value) ? 1 : 0;
+        }
+    }, 1);
+    miss = finish(miss, static_cast<long>(absent.size()));
+    miss.additional_metrics["hit_rate"] = static_cast<double>(found) / absent.size();
+    results.push_back(miss);
+}
+
+// The obvious thread-safe map: one lock, and a rehash of everything at once
+class LockedUnorderedMap {
+public:
+    void insert(int64_t key, int64_t value) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        map_[key] = value;
+    }
+    
+    bool search(int64_t key, int64_t& value) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<int64_t, int64_t> map_;
+};
+
+double elapsedMicroseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Time every lookup of existing keys while one writer grows the table 40 times over
+template<typename Table>
+BenchmarkResult runResizeLatency(const std::string& name) {
+    Table table;
+    for (int64_t key = 0; key < RESIZE_PRELOADED_KEYS; ++key) {
+        table.insert(key, key);
+    }
+    
+    std::vector<std::vector<double>> readerLatencies(RESIZE_READERS);
+    std::vector<double> insertLatencies(RESIZE_INSERTED_KEYS);
+    std::atomic<bool> done(false);
+    std::atomic<long> hits(0);
+    BenchmarkRunner runner(name + " lookups during resize");
+    auto result = runner.run([&]() {
+        std::vector<std::thread> readers;
+        for (int t = 0; t < RESIZE_READERS; ++t) {
+            readers.emplace_back([&table, &done, &hits, &readerLatencies, t]() {
+                std::mt19937 rng(t);
+                int64_t value;
+                long found = 0;
+                while (!done) {
+                    int64_t key = rng() % RESIZE_PRELOADED_KEYS;
+                    auto start = std::chrono::steady_clock::now();
+                    found += table.search(key, value) ? 1 : 0;
+                    readerLatencies[t].push_back(elapsedMicroseconds(start));
+                }
+                hits += found;
+            });
+        }
+        for (int64_t i = 0; i < RESIZE_INSERTED_KEYS; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            table.insert(RESIZE_PRELOADED_KEYS + i, i);
+            insertLatencies[i] = elapsedMicroseconds(start);
+        }
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+    }, 1);
+    
+    std::vector<double> lookups;
+    for (const auto& latencies : readerLatencies) {
+        lookups.insert(lookups.end(), latencies.begin(), latencies.end());
+    }
+    result = finish(result, static_cast<long>(lookups.size()));
+    result.additional_metrics["lookups_found"] = static_cast<double>(hits);
+    result.additional_metrics["lookup_p50_us"] = BenchmarkUtils::calculatePercentile(lookups, 50);
+    result.additional_metrics["lookup_p99_us"] = BenchmarkUtils::calculatePercentile(lookups, 99);
+    result.additional_metrics["lookup_p999_us"] = BenchmarkUtils::calculatePercentile(lookups, 99.9);
+    result.additional_metrics["lookup_max_us"] = *std::max_element(lookups.begin(), lookups.end());
+    result.additional_metrics["insert_p99_us"] = BenchmarkUtils::calculatePercentile(insertLatencies, 99);
+    result.additional_metrics["insert_max_us"] = *std::max_element(insertLatencies.begin(), insertLatencies.end());
+    return result;
+}
+
+} // anonymous namespace
+
+int main() {
+    std::cout << "Running PhantomDB hash index Benchmarks..." << std::endl;
+    
+    std::vector<BenchmarkResult> results;
+    std::vector<int> ints(KEYS_PER_RUN * 2);
+    for (int i = 0; i < KEYS_PER_RUN * 2; ++i) {
+        ints[i] = i;
+    }
+    std::shuffle(ints.begin(), ints.end(), std::mt19937(5));
+    std::vector<int> intKeys(ints.begin(), ints.begin() + KEYS_PER_RUN);
+    std::vector<int> intAbsent(ints.begin() + KEYS_PER_RUN, ints.end());
+    
+    std::vector<std::string> stringKeys;
+    std::vector<std::string> stringAbsent;
+    for (int key : intKeys) {
+        stringKeys.push_back("user-" + std::to_string(key) + "@example.com");
+    }
+    for (int key : intAbsent) {
+        stringAbsent.push_back("user-" + std::to_string(key) + "@example.com");
+    }
+    
+    // Benchmark 1: Integer keys
+    runTable<HashTable<int, int>>("HashTable int", intKeys, intAbsent, results);
+    runTable<SwissTable<int, int>>("SwissTable int", intKeys, intAbsent, results);
+    
+    // Benchmark 2: String keys
+    runTable<HashTable<std::string, int>>("HashTable string", stringKeys, stringAbsent, results);
+    runTable<SwissTable<std::string, int>>("SwissTable string", stringKeys, stringAbsent, results);
+    
+    // Benchmark 3: Lookup latency while the table grows
+    results.push_back(runResizeLatency<LockedUnorderedMap>("Locked unordered_map"));
+    results.push_back(runResizeLatency<ConcurrentHashTable<int64_t, int64_t>>("ConcurrentHashTable"));
+    
+    // Print results
+    BenchmarkRunner::printResults(results);
+    
+    std::cout << "Hash index benchmarks completed!" << std::endl;
+    return 0;
+}
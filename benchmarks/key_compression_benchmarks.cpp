@@ -0,0 +1,137 @@
+#include "benchmark_runner.h"
+#include "../src/storage/bplus_tree.h"
+#include "../src/storage/front_coded_btree.h"
+#include "../src/storage/sstable.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <filesystem>
+
+using namespace phantomdb::benchmark;
+using phantomdb::storage::BPlusTree;
+using phantomdb::storage::FrontCodedBTree;
+using phantomdb::storage::SSTableWriter;
+using phantomdb::storage::SSTableReader;
+using phantomdb::storage::SSTableLookup;
+using phantomdb::storage::BloomFilterLayout;
+
+namespace {
+
+const int KEYS = 500000;
+const int LOOKUPS = 500000;
+const std::string TABLE_DIRECTORY = "./key_compression_bench";
+
+// URL-shaped keys: long shared prefixes, short distinct tails
+std::string urlKey(int i) {
+    return "https://shop.example.com/tenants/" + std::to_string(i % 200) + "/orders/" + std::to_string(i);
+}
+
+BenchmarkResult finish(BenchmarkResult result, long operations) {
+    result.iterations = operations;
+    result.throughput_ops_per_sec = (operations / result.duration_ms) * 1000.0;
+    return result;
+}
+
+// Heap bytes of a string outside the node that holds it
+size_t heapBytes(const std::string& s) {
+    return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+}
+
+// Write every entry to a sorted table; returns the file size
+uint64_t writeTable(const std::string& path, const std::vector<std::pair<std::string, std::string>>& entries,
+                    bool frontCoding) {
+    SSTableWriter writer;
+    writer.open(path, SSTableWriter::DEFAULT_BLOCK_SIZE, SSTableWriter::DEFAULT_BLOOM_BITS_PER_KEY,
+                BloomFilterLayout::BLOCKED, frontCoding);
+    for (const auto& entry : entries) {
+        writer.add(entry.first, entry.second);
+    }
+    writer.finish();
+    return std::filesystem::file_size(path);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::cout << "Running PhantomDB key compression Benchmarks..." << std::endl;
+
+    std::vector<BenchmarkResult> results;
+    std::vector<std::pair<std::string, std::string>> entries;
+    size_t keyBytes = 0;
+    for (int i = 0; i < KEYS; ++i) {
+        entries.emplace_back(urlKey(i), std::to_string(i));
+        keyBytes += entries.back().first.size();
+    }
+    std::sort(entries.begin(), entries.end());
+    std::vector<std::string> probes;
+    std::mt19937 rng(21);
+    for (int i = 0; i < LOOKUPS; ++i) {
+        probes.push_back(urlKey(static_cast<int>(rng() % KEYS)));
+    }
+    double rawBytesPerKey = static_cast<double>(keyBytes) / KEYS;
+
+    // In-memory B-trees: whole strings in nodes vs front-coded pages
+    BPlusTree<std::string, std::string> plain;
+    FrontCodedBTree packed;
+    plain.bulkLoad(entries);
+    packed.bulkLoad(entries);
+    size_t plainBytes = plain.getMemoryUsage();
+    for (const auto& entry : entries) {
+        plainBytes += heapBytes(entry.first) + heapBytes(entry.second);
+    }
+
+    long hits = 0;
+    std::string value;
+    BenchmarkRunner plainRunner("B+tree lookups (plain string keys)");
+    auto plainResult = plainRunner.run([&]() {
+        for (const auto& probe : probes) {
+            hits += plain.search(probe, value) ? 1 : 0;
+        }
+    }, 1);
+    plainResult = finish(plainResult, LOOKUPS);
+    plainResult.additional_metrics["raw_key_bytes_per_key"] = rawBytesPerKey;
+    plainResult.additional_metrics["bytes_per_key"] = static_cast<double>(plainBytes) / KEYS;
+    results.push_back(plainResult);
+
+    BenchmarkRunner packedRunner("B+tree lookups (front-coded pages)");
+    auto packedResult = packedRunner.run([&]() {
+        for (const auto& probe : probes) {
+            hits += packed.search(probe, value) ? 1 : 0;
+        }
+    }, 1);
+    packedResult = finish(packedResult, LOOKUPS);
+    packedResult.additional_metrics["raw_key_bytes_per_key"] = rawBytesPerKey;
+    packedResult.additional_metrics["bytes_per_key"] = static_cast<double>(packed.getMemoryUsage()) / KEYS;
+    results.push_back(packedResult);
+
+    // Sorted tables: whole keys in data blocks vs front-coded blocks
+    std::filesystem::remove_all(TABLE_DIRECTORY);
+    std::filesystem::create_directories(TABLE_DIRECTORY);
+    for (bool frontCoding : {false, true}) {
+        std::string path = TABLE_DIRECTORY + (frontCoding ? "/front_coded.sst" : "/plain.sst");
+        uint64_t fileSize = writeTable(path, entries, frontCoding);
+        SSTableReader reader;
+        reader.open(path);
+        BenchmarkRunner tableRunner(frontCoding ? "Sorted table lookups (front-coded blocks)"
+                                                : "Sorted table lookups (plain blocks)");
+        auto tableResult = tableRunner.run([&]() {
+            for (const auto& probe : probes) {
+                hits += reader.get(probe, value) == SSTableLookup::FOUND ? 1 : 0;
+            }
+        }, 1);
+        tableResult = finish(tableResult, LOOKUPS);
+        tableResult.additional_metrics["raw_key_bytes_per_key"] = rawBytesPerKey;
+        tableResult.additional_metrics["bytes_per_key"] = static_cast<double>(fileSize) / KEYS;
+        results.push_back(tableResult);
+    }
+    std::filesystem::remove_all(TABLE_DIRECTORY);
+
+    // Print results
+    BenchmarkRunner::printResults(results);
+    std::cout << "Lookups answered: " << hits << std::endl;
+
+    std::cout << "Key compression benchmarks completed!" << std::endl;
+    return 0;
+}
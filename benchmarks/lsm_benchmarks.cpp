@@ -0,0 +1,202 @@
+#include "benchmark_runner.h"
+#include "../src/storage/lsm_tree.h"
+#include "../src/storage/memtable.h"
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <atomic>
+
+using namespace phantomdb::benchmark;
+using phantomdb::storage::LSMTREE;
+using phantomdb::storage::MemTable;
+
+namespace {
+
+const int OPERATIONS_PER_RUN = 200000;
+const int MEMTABLE_SIZE = 20000;
+
+// Keys spread over the key space so writers do not append to the same spot
+std::vector<int> shuffledKeys(int count) {
+    std::vector<int> keys(count);
+    for (int i = 0; i < count; ++i) {
+        keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    return keys;
+}
+
+// Run body(thread, begin, end) on threadCount threads over [0, operations)
+template<typename Body>
+void runThreads(int threadCount, int operations, Body body) {
+    std::vector<std::thread> threads;
+    int perThread = operations / threadCount;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&body, t, perThread]() {
+            body(t, t * perThread, (t + 1) * perThread);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+BenchmarkResult finish(BenchmarkResult result, int operations, int threadCount) {
+    result.iterations = operations;
+    result.throughput_ops_per_sec = (operations / result.duration_ms) * 1000.0;
+    result.additional_metrics["threads"] = threadCount;
+    return result;
+}
+
+// The previous memtable: an ordered map behind one mutex
+class LockedMapMemTable {
+public:
+    void add(const std::string& key, const std::string& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[key] = value;
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, std::string> entries_;
+};
+
+// Raw memtable inserts, without flushes
+BenchmarkResult runMemTableInserts(bool skiplist, int threadCount, const std::vector<int>& keys) {
+    std::string name = skiplist ? "MemTable Insert (skiplist)" : "MemTable Insert (locked map)";
+    BenchmarkRunner runner(name + " (" + std::to_string(threadCount) + " threads)");
+    MemTable memtable;
+    LockedMapMemTable lockedMap;
+    std::atomic<uint64_t> sequence(1);
+    auto result = runner.run([&]() {
+        runThreads(threadCount, OPERATIONS_PER_RUN, [&](int, int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                std::string key = std::to_string(keys[i]);
+                if (skiplist) {
+                    memtable.add(sequence++, key, "value", false);
+                } else {
+                    lockedMap.add(key, "value");
+                }
+            }
+        });
+    }, 1);
+    result = finish(result, OPERATIONS_PER_RUN, threadCount);
+    if (skiplist) {
+        result.additional_metrics["arena_mb"] = memtable.getMemoryUsage() / (1024.0 * 1024.0);
+    }
+    return result;
+}
+
+// Inserts through the tree, including memtable switches and background flushes
+BenchmarkResult runInserts(int threadCount, const std::vector<int>& keys) {
+    LSMTREE<int, std::string> tree(MEMTABLE_SIZE);
+    BenchmarkRunner runner("LSM Insert (" + std::to_string(threadCount) + " threads)");
+    auto result = runner.run([&]() {
+        runThreads(threadCount, OPERATIONS_PER_RUN, [&tree, &keys](int, int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                tree.insert(keys[i], "value" + std::to_string(keys[i]));
+            }
+        });
+    }, 1);
+    result = finish(result, OPERATIONS_PER_RUN, threadCount);
+    auto stats = tree.getCompactionStats();
+    result.additional_metrics["flushes"] = static_cast<double>(stats.flushes);
+    result.additional_metrics["write_stalls"] = static_cast<double>(stats.writeStalls);
+    result.additional_metrics["stall_ms"] = stats.stallMicros / 1000.0;
+    return result;
+}
+
+// Point lookups spread over the memtables and the tables
+BenchmarkResult runLookups(int threadCount, LSMTREE<int, std::string>& tree, const std::vector<int>& keys) {
+    BenchmarkRunner runner("LSM Lookup (" + std::to_string(threadCount) + " threads)");
+    std::atomic<long> hits(0);
+    auto result = runner.run([&]() {
+        runThreads(threadCount, OPERATIONS_PER_RUN, [&tree, &keys, &hits](int, int begin, int end) {
+            std::string value;
+            long found = 0;
+            for (int i = begin; i < end; ++i) {
+                found += tree.search(keys[i], value) ? 1 : 0;
+            }
+            hits += found;
+        });
+    }, 1);
+    result = finish(result, OPERATIONS_PER_RUN, threadCount);
+    result.additional_metrics["hit_rate"] = static_cast<double>(hits) / OPERATIONS_PER_RUN;
+    auto stats = tree.getLookupStats();
+    result.additional_metrics["tables_skipped_per_lookup"] =
+        stats.lookups > 0 ? static_cast<double>(stats.tablesSkipped()) / stats.lookups : 0.0;
+    result.additional_metrics["bloom_fp_rate"] = stats.bloomFalsePositiveRate();
+    return result;
+}
+
+// Nine lookups to one insert, on a tree that keeps flushing
+BenchmarkResult runMixed(int threadCount, const std::vector<int>& keys) {
+    LSMTREE<int, std::string> tree(MEMTABLE_SIZE);
+    for (int i = 0; i < OPERATIONS_PER_RUN / 2; ++i) {
+        tree.insert(keys[i], "value");
+    }
+    tree.waitForCompactions();
+    
+    BenchmarkRunner runner("LSM Mixed 90/10 (" + std::to_string(threadCount) + " threads)");
+    auto result = runner.run([&]() {
+        runThreads(threadCount, OPERATIONS_PER_RUN, [&tree, &keys](int, int begin, int end) {
+            std::string value;
+            for (int i = begin; i < end; ++i) {
+                if (i % 10 == 0) {
+                    tree.insert(keys[i], "updated");
+                } else {
+                    tree.search(keys[i / 2], value);
+                }
+            }
+        });
+    }, 1);
+    return finish(result, OPERATIONS_PER_RUN, threadCount);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::cout << "Running PhantomDB LSM-tree Benchmarks..." << std::endl;
+    
+    std::vector<BenchmarkResult> results;
+    std::vector<int> threadCounts = {1, 2, 4, 8};
+    std::vector<int> keys = shuffledKeys(OPERATIONS_PER_RUN);
+    
+    // Benchmark 1: Concurrent skiplist against the single-lock map it replaced
+    for (int threads : threadCounts) {
+        results.push_back(runMemTableInserts(false, threads, keys));
+        results.push_back(runMemTableInserts(true, threads, keys));
+    }
+    
+    // Benchmark 2: Inserts while full memtables flush in the background
+    for (int threads : threadCounts) {
+        results.push_back(runInserts(threads, keys));
+    }
+    
+    // Benchmark 3: Lookups, half of them for absent keys
+    {
+        LSMTREE<int, std::string> tree(MEMTABLE_SIZE);
+        for (int i = 0; i < OPERATIONS_PER_RUN; i += 2) {
+            tree.insert(keys[i], "value" + std::to_string(keys[i]));
+        }
+        tree.waitForCompactions();
+        for (int threads : threadCounts) {
+            results.push_back(runLookups(threads, tree, keys));
+        }
+    }
+    
+    // Benchmark 4: Mixed reads and writes
+    for (int threads : threadCounts) {
+        results.push_back(runMixed(threads, keys));
+    }
+    
+    // Print results
+    BenchmarkRunner::printResults(results);
+    
+    std::cout << "LSM-tree benchmarks completed!" << std::endl;
+    return 0;
+}
@@ -33,6 +33,30 @@ REM Run all benchmarks
 echo Running core benchmarks...
 benchmarks\Release\core_benchmarks.exe > %results_dir%\core_benchmarks.txt 2>&1
 
+echo Running concurrency benchmarks...
+benchmarks\Release\concurrency_benchmarks.exe > %results_dir%\concurrency_benchmarks.txt 2>&1
+
+echo Running recovery benchmarks...
+benchmarks\Release\recovery_benchmarks.exe > %results_dir%\recovery_benchmarks.txt 2>&1
+
+echo Running WAL benchmarks...
+benchmarks\Release\wal_benchmarks.exe > %results_dir%\wal_benchmarks.txt 2>&1
+
+echo Running LSM-tree benchmarks...
+benchmarks\Release\lsm_benchmarks.exe > %results_dir%\lsm_benchmarks.txt 2>&1
+
+echo Running B-tree benchmarks...
+benchmarks\Release\btree_benchmarks.exe > %results_dir%\btree_benchmarks.txt 2>&1
+
+echo Running hash index benchmarks...
+benchmarks\Release\hash_benchmarks.exe > %results_dir%\hash_benchmarks.txt 2>&1
+
+echo Running bitmap index benchmarks...
+benchmarks\Release\bitmap_benchmarks.exe > %results_dir%\bitmap_benchmarks.txt 2>&1
+
+echo Running key compression benchmarks...
+benchmarks\Release\key_compression_benchmarks.exe > %results_dir%\key_compression_benchmarks.txt 2>&1
+
 echo Running storage benchmarks...
 benchmarks\Release\storage_benchmarks.exe > %results_dir%\storage_benchmarks.txt 2>&1
 
@@ -32,6 +32,30 @@ mkdir -p $results_dir
 echo "Running core benchmarks..."
 ./benchmarks/core_benchmarks > $results_dir/core_benchmarks.txt 2>&1
 
+echo "Running concurrency benchmarks..."
+./benchmarks/concurrency_benchmarks > $results_dir/concurrency_benchmarks.txt 2>&1
+
+echo "Running recovery benchmarks..."
+./benchmarks/recovery_benchmarks > $results_dir/recovery_benchmarks.txt 2>&1
+
+echo "Running WAL benchmarks..."
+./benchmarks/wal_benchmarks > $results_dir/wal_benchmarks.txt 2>&1
+
+echo "Running LSM-tree benchmarks..."
+./benchmarks/lsm_benchmarks > $results_dir/lsm_benchmarks.txt 2>&1
+
+echo "Running B-tree benchmarks..."
+./benchmarks/btree_benchmarks > $results_dir/btree_benchmarks.txt 2>&1
+
+echo "Running hash index benchmarks..."
+./benchmarks/hash_benchmarks > $results_dir/hash_benchmarks.txt 2>&1
+
+echo "Running bitmap index benchmarks..."
+./benchmarks/bitmap_benchmarks > $results_dir/bitmap_benchmarks.txt 2>&1
+
+echo "Running key compression benchmarks..."
+./benchmarks/key_compression_benchmarks > $results_dir/key_compression_benchmarks.txt 2>&1
+
 echo "Running storage benchmarks..."
 ./benchmarks/storage_benchmarks > $results_dir/storage_benchmarks.txt 2>&1
 
@@ -0,0 +1,114 @@
+#include "benchmark_runner.h"
+#include "../src/storage/wal_manager.h"
+#include <iostream>
+#include <streambuf>
+#include <filesystem>
+#include <vector>
+#include <thread>
+#include <string>
+
+using namespace phantomdb::benchmark;
+using phantomdb::storage::WALManager;
+using phantomdb::storage::WALRecord;
+using phantomdb::storage::WALRecordType;
+
+namespace {
+
+const std::string DATA_DIRECTORY = "./wal_benchmark_data";
+const int COMMITS_PER_RUN = 8000;
+
+// Discards everything written to it
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// Silence the WAL manager's lifecycle output while timing
+class QuietScope {
+public:
+    QuietScope() : previous_(std::cout.rdbuf(&sink_)) {}
+    ~QuietScope() { std::cout.rdbuf(previous_); }
+
+private:
+    NullBuffer sink_;
+    std::streambuf* previous_;
+};
+
+// A row insert about the size the database logs for a small table
+WALRecord insertRecord(int thread, int i) {
+    WALRecord record;
+    record.type = WALRecordType::INSERT;
+    record.table = "table_" + std::to_string(thread);
+    record.data = {
+        {"id", std::to_string(i)},
+        {"name", "User " + std::to_string(i)},
+        {"score", "1.5"}
+    };
+    return record;
+}
+
+// Every thread appends one record and waits for it to be durable, as a
+// transaction commit does
+BenchmarkResult runCommits(const std::string& name, int threadCount, bool directIO) {
+    QuietScope quiet;
+    std::filesystem::remove_all(DATA_DIRECTORY);
+    std::filesystem::create_directories(DATA_DIRECTORY);
+    
+    WALManager log(DATA_DIRECTORY + "/bench.log");
+    log.setDirectIO(directIO);
+    log.open();
+    
+    int perThread = COMMITS_PER_RUN / threadCount;
+    BenchmarkRunner runner(name + " (" + std::to_string(threadCount) + " threads)");
+    auto result = runner.run([&]() {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&log, t, perThread]() {
+                for (int i = 0; i < perThread; ++i) {
+                    log.commit(log.appendRecord(insertRecord(t, i)));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }, 1);
+    
+    auto stats = log.getStats();
+    long commits = static_cast<long>(perThread) * threadCount;
+    result.iterations = commits;
+    result.throughput_ops_per_sec = (commits / result.duration_ms) * 1000.0;
+    result.additional_metrics["threads"] = threadCount;
+    result.additional_metrics["syncs"] = static_cast<double>(stats.syncs);
+    result.additional_metrics["records_per_sync"] =
+        stats.syncs > 0 ? static_cast<double>(stats.recordsAppended) / stats.syncs : 0.0;
+    result.additional_metrics["mb_written"] = stats.bytesWritten / (1024.0 * 1024.0);
+    return result;
+}
+
+} // anonymous namespace
+
+int main() {
+    std::cout << "Running PhantomDB WAL Benchmarks..." << std::endl;
+    
+    std::vector<BenchmarkResult> results;
+    std::vector<int> threadCounts = {1, 4, 16};
+    
+    // Benchmark 1: Durable commits through the page cache
+    for (int threads : threadCounts) {
+        results.push_back(runCommits("Group Commit (buffered)", threads, false));
+    }
+    
+    // Benchmark 2: Same workload with O_DIRECT writes
+    for (int threads : threadCounts) {
+        results.push_back(runCommits("Group Commit (O_DIRECT)", threads, true));
+    }
+    
+    std::filesystem::remove_all(DATA_DIRECTORY);
+    
+    // Print results
+    BenchmarkRunner::printResults(results);
+    
+    std::cout << "WAL benchmarks completed!" << std::endl;
+    return 0;
+}
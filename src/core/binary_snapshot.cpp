@@ -0,0 +1,548 @@
+#include "binary_snapshot.h"
+#include "utils.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <unordered_set>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace phantomdb {
+namespace core {
+
+namespace {
+
+using utils::putFixed32;
+using utils::putFixed64;
+using utils::getFixed;
+
+const char HEADER_MAGIC[8] = {'P', 'H', 'D', 'B', 'S', 'N', 'A', 'P'};
+const char TRAILER_MAGIC[8] = {'P', 'H', 'D', 'B', 'E', 'N', 'D', '\0'};
+const size_t HEADER_SIZE = 16;
+const size_t TRAILER_SIZE = 24;
+
+void putU8(std::string& out, uint8_t value) {
+    out.push_back(static_cast<char>(value));
+}
+
+void putString(std::string& out, const std::string& value) {
+    putFixed32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+// Bounds-checked reader over a mapped byte range
+class Cursor {
+public:
+    Cursor(const unsigned char* begin, const unsigned char* end) : pos_(begin), end_(end), ok_(true) {}
+    
+    bool ok() const { return ok_; }
+    
+    const unsigned char* take(size_t bytes) {
+        if (!ok_ || static_cast<size_t>(end_ - pos_) < bytes) {
+            ok_ = false;
+            return nullptr;
+        }
+        const unsigned char* start = pos_;
+        pos_ += bytes;
+        return start;
+    }
+    
+    uint64_t readFixed(int bytes) {
+        const unsigned char* in = take(bytes);
+        return in != nullptr ? getFixed(in, bytes) : 0;
+    }
+    
+    uint8_t readU8() { return static_cast<uint8_t>(readFixed(1)); }
+    uint32_t readU32() { return static_cast<uint32_t>(readFixed(4)); }
+    uint64_t readU64() { return readFixed(8); }
+    
+    std::string readString() {
+        uint32_t length = readU32();
+        const unsigned char* in = take(length);
+        return in != nullptr ? std::string(reinterpret_cast<const char*>(in), length) : std::string();
+    }
+
+private:
+    const unsigned char* pos_;
+    const unsigned char* end_;
+    bool ok_;
+};
+
+bool writeChunk(std::FILE* file, const std::string& chunk, uint32_t& crc, uint64_t& length) {
+    crc = utils::crc32(chunk.data(), chunk.size(), crc);
+    length += chunk.size();
+    return std::fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+}
+
+// Stream one table block to the file, one column at a time
+bool writeTableBlock(std::FILE* file, const TableData& table, uint32_t& crc, uint64_t& length) {
+    // Rows may carry values for columns that were never declared; keep them
+    std::vector<std::pair<std::string, std::string>> columns = table.columns;
+    std::vector<bool> declared(columns.size(), true);
+    std::unordered_set<std::string> known;
+    for (const auto& column : columns) {
+        known.insert(column.first);
+    }
+    for (const auto& row : table.rows) {
+        for (const auto& cell : row) {
+            if (known.insert(cell.first).second) {
+                columns.emplace_back(cell.first, "string");
+                declared.push_back(false);
+            }
+        }
+    }
+    
+    std::string buffer;
+    putFixed64(buffer, table.rows.size());
+    putFixed32(buffer, static_cast<uint32_t>(columns.size()));
+    for (size_t c = 0; c < columns.size(); ++c) {
+        putString(buffer, columns[c].first);
+        putString(buffer, columns[c].second);
+        putU8(buffer, declared[c] ? 1 : 0);
+    }
+    if (!writeChunk(file, buffer, crc, length)) {
+        return false;
+    }
+    
+    size_t rowCount = table.rows.size();
+    for (const auto& column : columns) {
+        buffer.assign((rowCount + 7) / 8, '\0');
+        std::string cells;
+        for (size_t r = 0; r < rowCount; ++r) {
+            auto it = table.rows[r].find(column.first);
+            if (it == table.rows[r].end()) {
+                continue;
+            }
+            buffer[r / 8] = static_cast<char>(buffer[r / 8] | (1 << (r % 8)));
+            putFixed32(buffer, static_cast<uint32_t>(it->second.size()));
+            cells.append(it->second);
+        }
+        putFixed64(buffer, cells.size());
+        buffer.append(cells);
+        if (!writeChunk(file, buffer, crc, length)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+BinarySnapshotWriter::BinarySnapshotWriter() : file_(nullptr), offset_(0), ok_(false) {}
+
+BinarySnapshotWriter::~BinarySnapshotWriter() {
+    abort();
+}
+
+bool BinarySnapshotWriter::open(const std::string& path, const std::string& databaseName) {
+    abort();
+    
+    std::filesystem::path pathObj(path);
+    if (pathObj.has_parent_path()) {
+        std::filesystem::create_directories(pathObj.parent_path());
+    }
+    
+    // Write next to the target and rename, so a crash never leaves a half-written snapshot
+    path_ = path;
+    tempPath_ = path + ".tmp";
+    databaseName_ = databaseName;
+    index_.clear();
+    file_ = std::fopen(tempPath_.c_str(), "wb");
+    if (file_ == nullptr) {
+        std::cerr << "Failed to open file for writing: " << tempPath_ << std::endl;
+        return false;
+    }
+    
+    std::string header(HEADER_MAGIC, sizeof(HEADER_MAGIC));
+    putFixed32(header, FORMAT_VERSION);
+    putFixed32(header, 0); // Flags, reserved
+    ok_ = std::fwrite(header.data(), 1, header.size(), file_) == header.size();
+    offset_ = HEADER_SIZE;
+    return ok_;
+}
+
+bool BinarySnapshotWriter::addTable(const std::string& tableName, const TableData& table) {
+    if (file_ == nullptr || !ok_) {
+        return false;
+    }
+    
+    SnapshotTableEntry entry{tableName, offset_, 0, table.rows.size(), 0};
+    ok_ = writeTableBlock(file_, table, entry.checksum, entry.length);
+    offset_ += entry.length;
+    index_.push_back(std::move(entry));
+    return ok_;
+}
+
+bool BinarySnapshotWriter::commit() {
+    if (file_ == nullptr) {
+        return false;
+    }
+    
+    std::string footer;
+    putString(footer, databaseName_);
+    putFixed32(footer, static_cast<uint32_t>(index_.size()));
+    for (const auto& entry : index_) {
+        putString(footer, entry.name);
+        putFixed64(footer, entry.offset);
+        putFixed64(footer, entry.length);
+        putFixed64(footer, entry.rowCount);
+        putFixed32(footer, entry.checksum);
+    }
+    
+    std::string trailer;
+    putFixed64(trailer, offset_);
+    putFixed32(trailer, static_cast<uint32_t>(footer.size()));
+    putFixed32(trailer, utils::crc32(footer.data(), footer.size()));
+    trailer.append(TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+    
+    bool ok = ok_;
+    ok = ok && std::fwrite(footer.data(), 1, footer.size(), file_) == footer.size();
+    ok = ok && std::fwrite(trailer.data(), 1, trailer.size(), file_) == trailer.size();
+    ok = ok && std::fflush(file_) == 0 && utils::syncFile(file_);
+    ok = (std::fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    
+    if (!ok) {
+        std::cerr << "Failed to write snapshot file: " << tempPath_ << std::endl;
+        std::error_code ec;
+        std::filesystem::remove(tempPath_, ec);
+        return false;
+    }
+    
+    std::error_code ec;
+    std::filesystem::rename(tempPath_, path_, ec);
+    if (ec) {
+        std::cerr << "Failed to move snapshot into place: " << path_ << " (" << ec.message() << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void BinarySnapshotWriter::abort() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+        std::error_code ec;
+        std::filesystem::remove(tempPath_, ec);
+    }
+    ok_ = false;
+}
+
+bool BinarySnapshotWriter::write(const std::string& path,
+                                 const std::string& databaseName,
+                                 const std::unordered_map<std::string, TableData>& tables) {
+    BinarySnapshotWriter writer;
+    if (!writer.open(path, databaseName)) {
+        return false;
+    }
+    
+    // Sorted table order keeps snapshots of the same data byte-identical
+    std::vector<std::string> tableNames;
+    for (const auto& tablePair : tables) {
+        tableNames.push_back(tablePair.first);
+    }
+    std::sort(tableNames.begin(), tableNames.end());
+    
+    for (const auto& tableName : tableNames) {
+        if (!writer.addTable(tableName, tables.at(tableName))) {
+            return false;
+        }
+    }
+    return writer.commit();
+}
+
+class BinarySnapshotReader::Impl {
+public:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+    std::string databaseName;
+    std::vector<SnapshotTableEntry> tables;
+    
+    bool map(const std::string& path) {
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+            unmap();
+            return false;
+        }
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle == nullptr) {
+            unmap();
+            return false;
+        }
+        data = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        size = static_cast<size_t>(fileSize.QuadPart);
+        if (data == nullptr) {
+            unmap();
+            return false;
+        }
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps the file alive
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<const unsigned char*>(mapped);
+        size = static_cast<size_t>(st.st_size);
+        return true;
+#endif
+    }
+    
+    void unmap() {
+#ifdef _WIN32
+        if (data != nullptr) {
+            UnmapViewOfFile(data);
+        }
+        if (mappingHandle != nullptr) {
+            CloseHandle(mappingHandle);
+        }
+        if (fileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(fileHandle);
+        }
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (data != nullptr) {
+            ::munmap(const_cast<unsigned char*>(data), size);
+        }
+#endif
+        data = nullptr;
+        size = 0;
+        databaseName.clear();
+        tables.clear();
+    }
+    
+    bool readIndex() {
+        if (size < HEADER_SIZE + TRAILER_SIZE ||
+            std::memcmp(data, HEADER_MAGIC, sizeof(HEADER_MAGIC)) != 0) {
+            return false;
+        }
+        
+        Cursor header(data + sizeof(HEADER_MAGIC), data + HEADER_SIZE);
+        if (header.readU32() != BinarySnapshotWriter::FORMAT_VERSION) {
+            std::cerr << "Unsupported snapshot format version" << std::endl;
+            return false;
+        }
+        
+        const unsigned char* trailerStart = data + size - TRAILER_SIZE;
+        if (std::memcmp(trailerStart + 16, TRAILER_MAGIC, sizeof(TRAILER_MAGIC)) != 0) {
+            return false;
+        }
+        Cursor trailer(trailerStart, trailerStart + 16);
+        uint64_t footerOffset = trailer.readU64();
+        uint32_t footerLength = trailer.readU32();
+        uint32_t footerChecksum = trailer.readU32();
+        if (footerOffset < HEADER_SIZE || footerOffset + footerLength != size - TRAILER_SIZE ||
+            utils::crc32(data + footerOffset, footerLength) != footerChecksum) {
+            return false;
+        }
+        
+        Cursor footer(data + footerOffset, data + footerOffset + footerLength);
+        databaseName = footer.readString();
+        uint32_t tableCount = footer.readU32();
+        for (uint32_t i = 0; i < tableCount && footer.ok(); ++i) {
+            SnapshotTableEntry entry;
+            entry.name = footer.readString();
+            entry.offset = footer.readU64();
+            entry.length = footer.readU64();
+            entry.rowCount = footer.readU64();
+            entry.checksum = footer.readU32();
+            if (entry.offset < HEADER_SIZE || entry.offset > footerOffset ||
+                entry.length > footerOffset - entry.offset) {
+                return false;
+            }
+            tables.push_back(std::move(entry));
+        }
+        return footer.ok();
+    }
+    
+    bool decodeTable(const SnapshotTableEntry& entry, TableData& table) const {
+        const unsigned char* block = data + entry.offset;
+        if (utils::crc32(block, entry.length) != entry.checksum) {
+            std::cerr << "Checksum mismatch in snapshot table '" << entry.name << "'" << std::endl;
+            return false;
+        }
+        
+        Cursor cursor(block, block + entry.length);
+        uint64_t rowCount = cursor.readU64();
+        uint32_t columnCount = cursor.readU32();
+        if (!cursor.ok() || rowCount != entry.rowCount) {
+            return false;
+        }
+        
+        std::vector<std::string> names;
+        table.columns.clear();
+        for (uint32_t c = 0; c < columnCount && cursor.ok(); ++c) {
+            std::string name = cursor.readString();
+            std::string type = cursor.readString();
+            if (cursor.readU8() != 0) {
+                table.columns.emplace_back(name, type);
+            }
+            names.push_back(std::move(name));
+        }
+        
+        table.rows.assign(static_cast<size_t>(rowCount), {});
+        for (auto& row : table.rows) {
+            row.reserve(columnCount);
+        }
+        
+        for (const auto& name : names) {
+            const unsigned char* bitmap = cursor.take(static_cast<size_t>((rowCount + 7) / 8));
+            if (bitmap == nullptr) {
+                return false;
+            }
+            
+            // Lengths of the present cells come first, then their bytes
+            size_t present = 0;
+            for (uint64_t r = 0; r < rowCount; ++r) {
+                present += (bitmap[r / 8] >> (r % 8)) & 1;
+            }
+            const unsigned char* lengths = cursor.take(present * 4);
+            uint64_t cellBytes = cursor.readU64();
+            const unsigned char* cells = cursor.take(static_cast<size_t>(cellBytes));
+            if (!cursor.ok()) {
+                return false;
+            }
+            
+            Cursor lengthCursor(lengths, lengths + present * 4);
+            Cursor cellCursor(cells, cells + cellBytes);
+            for (uint64_t r = 0; r < rowCount; ++r) {
+                if (((bitmap[r / 8] >> (r % 8)) & 1) == 0) {
+                    continue;
+                }
+                uint32_t length = lengthCursor.readU32();
+                const unsigned char* value = cellCursor.take(length);
+                if (value == nullptr) {
+                    return false;
+                }
+                table.rows[r].emplace(name, std::string(reinterpret_cast<const char*>(value), length));
+            }
+        }
+        return cursor.ok();
+    }
+};
+
+BinarySnapshotReader::BinarySnapshotReader() : pImpl(std::make_unique<Impl>()) {}
+
+BinarySnapshotReader::~BinarySnapshotReader() {
+    close();
+}
+
+bool BinarySnapshotReader::open(const std::string& path) {
+    close();
+    if (!pImpl->map(path)) {
+        return false;
+    }
+    if (!pImpl->readIndex()) {
+        std::cerr << "Invalid or corrupt snapshot file: " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void BinarySnapshotReader::close() {
+    pImpl->unmap();
+}
+
+bool BinarySnapshotReader::isOpen() const {
+    return pImpl->data != nullptr;
+}
+
+const std::string& BinarySnapshotReader::getDatabaseName() const {
+    return pImpl->databaseName;
+}
+
+std::vector<std::string> BinarySnapshotReader::getTableNames() const {
+    std::vector<std::string> names;
+    for (const auto& entry : pImpl->tables) {
+        names.push_back(entry.name);
+    }
+    return names;
+}
+
+bool BinarySnapshotReader::loadTable(const std::string& tableName, TableData& table) const {
+    for (const auto& entry : pImpl->tables) {
+        if (entry.name == tableName) {
+            return pImpl->decodeTable(entry, table);
+        }
+    }
+    return false;
+}
+
+bool BinarySnapshotReader::loadAll(const TableCallback& callback, size_t threadCount) const {
+    const auto& tables = pImpl->tables;
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = std::min(threadCount, tables.size());
+    
+    std::atomic<size_t> nextTable(0);
+    std::atomic<bool> ok(true);
+    auto worker = [&]() {
+        size_t i;
+        while (ok.load() && (i = nextTable.fetch_add(1)) < tables.size()) {
+            TableData table;
+            if (!pImpl->decodeTable(tables[i], table)) {
+                ok.store(false);
+                return;
+            }
+            callback(tables[i].name, std::move(table));
+        }
+    };
+    
+    if (threadCount <= 1) {
+        worker();
+        return ok.load();
+    }
+    
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    return ok.load();
+}
+
+bool BinarySnapshotReader::isSnapshotFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(HEADER_MAGIC)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, HEADER_MAGIC, sizeof(magic)) == 0;
+}
+
+} // namespace core
+} // namespace phantomdb
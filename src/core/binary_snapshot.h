@@ -0,0 +1,164 @@
+#ifndef PHANTOMDB_BINARY_SNAPSHOT_H
+#define PHANTOMDB_BINARY_SNAPSHOT_H
+
+#include "enhanced_persistence.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+
+namespace phantomdb {
+namespace core {
+
+// Footer index entry describing one table block
+struct SnapshotTableEntry {
+    std::string name;
+    uint64_t offset;
+    uint64_t length;
+    uint64_t rowCount;
+    uint32_t checksum;
+};
+
+/**
+ * Binary snapshot file layout (all integers little-endian):
+ * 
+ *   header   "PHDBSNAP" | u32 version | u32 flags
+ *   blocks   one block per table, back to back
+ *   footer   string database name | u32 table count |
+ *            per table: string name | u64 offset | u64 length | u64 rows | u32 crc32
+ *   trailer  u64 footer offset | u32 footer length | u32 footer crc32 | "PHDBEND\0"
+ * 
+ * A table block holds the column definitions followed by one column block
+ * per column: a presence bitmap, the u32 length of every present cell and
+ * the concatenated cell bytes. Values are stored verbatim, so nothing has to
+ * be escaped or parsed on load. Strings are u32 length + bytes.
+ */
+class BinarySnapshotWriter {
+public:
+    static const uint32_t FORMAT_VERSION = 1;
+    
+    BinarySnapshotWriter();
+    ~BinarySnapshotWriter();
+    
+    BinarySnapshotWriter(const BinarySnapshotWriter&) = delete;
+    BinarySnapshotWriter& operator=(const BinarySnapshotWriter&) = delete;
+    
+    /**
+     * @brief Start a snapshot; nothing is visible at the path until commit()
+     * 
+     * @param path The destination file
+     * @param databaseName The name recorded in the footer
+     * @return true if successful, false otherwise
+     */
+    bool open(const std::string& path, const std::string& databaseName);
+    
+    /**
+     * @brief Append one table block; tables are written in call order
+     * 
+     * @return true if successful, false otherwise
+     */
+    bool addTable(const std::string& tableName, const TableData& table);
+    
+    /**
+     * @brief Write the footer, fsync and rename the file into place
+     * 
+     * @return true if successful, false otherwise
+     */
+    bool commit();
+    
+    /**
+     * @brief Discard an uncommitted snapshot (also done by the destructor)
+     */
+    void abort();
+    
+    /**
+     * @brief Write a whole snapshot file atomically (temp file, fsync, rename)
+     * 
+     * @param path The destination file
+     * @param databaseName The name recorded in the footer
+     * @param tables The table data to write
+     * @return true if successful, false otherwise
+     */
+    static bool write(const std::string& path,
+                      const std::string& databaseName,
+                      const std::unordered_map<std::string, TableData>& tables);
+
+private:
+    std::FILE* file_;
+    std::string path_;
+    std::string tempPath_;
+    std::string databaseName_;
+    std::vector<SnapshotTableEntry> index_;
+    uint64_t offset_;
+    bool ok_;
+};
+
+/**
+ * Memory-mapped reader for binary snapshot files. Opening only validates
+ * the header and footer index; table blocks are checksummed and decoded on
+ * demand, so single tables can be materialized lazily and whole files can
+ * be decoded by several threads at once.
+ */
+class BinarySnapshotReader {
+public:
+    using TableCallback = TableLoadCallback;
+    
+    BinarySnapshotReader();
+    ~BinarySnapshotReader();
+    
+    BinarySnapshotReader(const BinarySnapshotReader&) = delete;
+    BinarySnapshotReader& operator=(const BinarySnapshotReader&) = delete;
+    
+    /**
+     * @brief Map a snapshot file and read its footer index
+     * 
+     * @param path The snapshot file
+     * @return false if the file is missing, not a snapshot or corrupt
+     */
+    bool open(const std::string& path);
+    
+    void close();
+    
+    bool isOpen() const;
+    
+    const std::string& getDatabaseName() const;
+    
+    std::vector<std::string> getTableNames() const;
+    
+    /**
+     * @brief Verify and decode a single table block
+     * 
+     * @param tableName The table to load
+     * @param table Receives the decoded table
+     * @return false if the table is unknown or its block is corrupt
+     */
+    bool loadTable(const std::string& tableName, TableData& table) const;
+    
+    /**
+     * @brief Decode every table, spreading the blocks across worker threads
+     * 
+     * The callback runs on the worker threads, once per table.
+     * 
+     * @param callback Receives each decoded table
+     * @param threadCount Number of workers (0 = hardware concurrency)
+     * @return false if any block is corrupt
+     */
+    bool loadAll(const TableCallback& callback, size_t threadCount = 0) const;
+    
+    /**
+     * @brief Check whether a file starts with the snapshot magic
+     */
+    static bool isSnapshotFile(const std::string& path);
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace core
+} // namespace phantomdb
+
+#endif // PHANTOMDB_BINARY_SNAPSHOT_H
@@ -0,0 +1,485 @@
+#include "columnar_table.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+
+namespace phantomdb {
+namespace core {
+
+namespace {
+
+// Largest number of fractional digits a FLOAT cell keeps in typed form
+const size_t MAX_FLOAT_SCALE = 17;
+
+// Parse an integer and report whether re-rendering it reproduces the text
+bool encodeInteger(const std::string& value, int64_t& out) {
+    const char* begin = value.data();
+    const char* end = begin + value.size();
+    auto parsed = std::from_chars(begin, end, out);
+    if (parsed.ec != std::errc() || parsed.ptr != end) {
+        return false;
+    }
+    
+    char buffer[32];
+    auto rendered = std::to_chars(buffer, buffer + sizeof(buffer), out);
+    return std::string_view(buffer, rendered.ptr - buffer) == value;
+}
+
+// Parse a fixed-notation float and report whether re-rendering it with the
+// same number of fractional digits reproduces the text
+bool encodeFloat(const std::string& value, double& out, uint8_t& scale) {
+    size_t dot = value.find('.');
+    size_t digits = (dot == std::string::npos) ? 0 : value.size() - dot - 1;
+    if (digits > MAX_FLOAT_SCALE) {
+        return false;
+    }
+    
+    const char* begin = value.data();
+    const char* end = begin + value.size();
+    auto parsed = std::from_chars(begin, end, out, std::chars_format::fixed);
+    if (parsed.ec != std::errc() || parsed.ptr != end) {
+        return false;
+    }
+    
+    char buffer[400];
+    auto rendered = std::to_chars(buffer, buffer + sizeof(buffer), out,
+                                  std::chars_format::fixed, static_cast<int>(digits));
+    if (rendered.ec != std::errc() || std::string_view(buffer, rendered.ptr - buffer) != value) {
+        return false;
+    }
+    
+    scale = static_cast<uint8_t>(digits);
+    return true;
+}
+
+std::string renderInteger(int64_t value) {
+    char buffer[32];
+    auto rendered = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, rendered.ptr - buffer);
+}
+
+std::string renderFloat(double value, uint8_t scale) {
+    char buffer[400];
+    auto rendered = std::to_chars(buffer, buffer + sizeof(buffer), value,
+                                  std::chars_format::fixed, static_cast<int>(scale));
+    return std::string(buffer, rendered.ptr - buffer);
+}
+
+} // anonymous namespace
+
+ColumnarTable::ColumnarTable(const ColumnDefinitions& columns) : rowCount_(0) {
+    for (const auto& column : columns) {
+        addColumn(column.first, column.second);
+    }
+}
+
+ColumnType ColumnarTable::columnTypeFromName(const std::string& typeName) {
+    std::string lowerType = typeName;
+    std::transform(lowerType.begin(), lowerType.end(), lowerType.begin(), ::tolower);
+    
+    if (lowerType == "integer" || lowerType == "int" || lowerType == "bigint" ||
+        lowerType == "smallint" || lowerType == "tinyint") {
+        return ColumnType::INTEGER;
+    }
+    
+    if (lowerType == "float" || lowerType == "double" || lowerType == "real" ||
+        lowerType == "decimal" || lowerType == "numeric") {
+        return ColumnType::FLOAT;
+    }
+    
+    if (lowerType == "boolean" || lowerType == "bool") {
+        return ColumnType::BOOLEAN;
+    }
+    
+    // Text, dates, times and unknown types are stored as strings
+    return ColumnType::STRING;
+}
+
+ColumnarTable::Column& ColumnarTable::addColumn(const std::string& name, const std::string& typeName) {
+    auto existing = columnIndex_.find(name);
+    if (existing != columnIndex_.end()) {
+        return columns_[existing->second];
+    }
+    
+    Column column;
+    column.name = name;
+    column.type = columnTypeFromName(typeName);
+    
+    definitions_.emplace_back(name, typeName);
+    columnIndex_[name] = columns_.size();
+    columns_.push_back(std::move(column));
+    
+    // Backfill nulls so every column has rowCount_ entries
+    Column& added = columns_.back();
+    for (size_t i = 0; i < rowCount_; ++i) {
+        appendNull(added);
+    }
+    return added;
+}
+
+void ColumnarTable::appendNull(Column& column) {
+    column.state.push_back(CELL_NULL);
+    switch (column.type) {
+        case ColumnType::INTEGER:
+            column.ints.push_back(0);
+            break;
+        case ColumnType::FLOAT:
+            column.floats.push_back(0.0);
+            column.scales.push_back(0);
+            break;
+        case ColumnType::BOOLEAN:
+            column.codes.push_back(0);
+            break;
+        case ColumnType::STRING:
+            column.offsets.push_back(0);
+            column.lengths.push_back(0);
+            break;
+    }
+}
+
+void ColumnarTable::setCell(Column& column, size_t rowIndex, const std::string& value) {
+    if (column.state[rowIndex] == CELL_RAW) {
+        column.raw.erase(rowIndex);
+    }
+    
+    bool typed = false;
+    switch (column.type) {
+        case ColumnType::INTEGER:
+            typed = encodeInteger(value, column.ints[rowIndex]);
+            break;
+        case ColumnType::FLOAT:
+            typed = encodeFloat(value, column.floats[rowIndex], column.scales[rowIndex]);
+            break;
+        case ColumnType::BOOLEAN: {
+            auto it = std::find(column.spellings.begin(), column.spellings.end(), value);
+            if (it != column.spellings.end()) {
+                column.codes[rowIndex] = static_cast<uint8_t>(it - column.spellings.begin());
+                typed = true;
+            } else if (column.spellings.size() < 255) {
+                column.codes[rowIndex] = static_cast<uint8_t>(column.spellings.size());
+                column.spellings.push_back(value);
+                typed = true;
+            }
+            break;
+        }
+        case ColumnType::STRING:
+            if (column.state[rowIndex] != CELL_NULL) {
+                column.arenaGarbage += column.lengths[rowIndex];
+            }
+            column.offsets[rowIndex] = column.arena.size();
+            column.lengths[rowIndex] = static_cast<uint32_t>(value.size());
+            column.arena.append(value);
+            typed = true;
+            break;
+    }
+    
+    if (typed) {
+        column.state[rowIndex] = CELL_TYPED;
+    } else {
+        column.state[rowIndex] = CELL_RAW;
+        column.raw[rowIndex] = value;
+    }
+    
+    // Reclaim the arena once most of it is overwritten values
+    if (column.type == ColumnType::STRING && column.arenaGarbage > column.arena.size() / 2 &&
+        column.arenaGarbage > 4096) {
+        compactArena(column);
+    }
+}
+
+std::string_view ColumnarTable::stringCell(const Column& column, size_t rowIndex) const {
+    return std::string_view(column.arena.data() + column.offsets[rowIndex], column.lengths[rowIndex]);
+}
+
+bool ColumnarTable::getCell(const Column& column, size_t rowIndex, std::string& value) const {
+    switch (column.state[rowIndex]) {
+        case CELL_NULL:
+            return false;
+        case CELL_RAW:
+            value = column.raw.at(rowIndex);
+            return true;
+        default:
+            break;
+    }
+    
+    switch (column.type) {
+        case ColumnType::INTEGER:
+            value = renderInteger(column.ints[rowIndex]);
+            break;
+        case ColumnType::FLOAT:
+            value = renderFloat(column.floats[rowIndex], column.scales[rowIndex]);
+            break;
+        case ColumnType::BOOLEAN:
+            value = column.spellings[column.codes[rowIndex]];
+            break;
+        case ColumnType::STRING:
+            value.assign(stringCell(column, rowIndex));
+            break;
+    }
+    return true;
+}
+
+void ColumnarTable::appendRow(const Row& row) {
+    for (auto& column : columns_) {
+        appendNull(column);
+    }
+    rowCount_++;
+    
+    for (const auto& pair : row) {
+        auto it = columnIndex_.find(pair.first);
+        Column& column = (it != columnIndex_.end()) ? columns_[it->second]
+                                                    : addColumn(pair.first, "string");
+        setCell(column, rowCount_ - 1, pair.second);
+    }
+}
+
+ColumnarTable::Row ColumnarTable::getRow(size_t rowIndex) const {
+    Row row;
+    std::string value;
+    for (const auto& column : columns_) {
+        if (getCell(column, rowIndex, value)) {
+            row.emplace(column.name, value);
+        }
+    }
+    return row;
+}
+
+std::vector<ColumnarTable::Row> ColumnarTable::toRows() const {
+    std::vector<Row> rows;
+    rows.reserve(rowCount_);
+    for (size_t i = 0; i < rowCount_; ++i) {
+        rows.push_back(getRow(i));
+    }
+    return rows;
+}
+
+void ColumnarTable::filterColumn(const Column& column, const std::string& value,
+                                 std::vector<uint8_t>& mask) const {
+    const size_t n = rowCount_;
+    const uint8_t* state = column.state.data();
+    uint8_t* out = mask.data();
+    
+    // Cells kept verbatim can only equal a value that has no typed form
+    auto matchRaw = [&]() {
+        for (size_t i = 0; i < n; ++i) {
+            if (out[i]) {
+                out[i] = state[i] == CELL_RAW && column.raw.at(i) == value;
+            }
+        }
+    };
+    
+    switch (column.type) {
+        case ColumnType::INTEGER: {
+            int64_t target;
+            if (!encodeInteger(value, target)) {
+                matchRaw();
+                break;
+            }
+            const int64_t* ints = column.ints.data();
+            for (size_t i = 0; i < n; ++i) {
+                out[i] &= (state[i] == CELL_TYPED) & (ints[i] == target);
+            }
+            break;
+        }
+        case ColumnType::FLOAT: {
+            double target;
+            uint8_t scale;
+            if (!encodeFloat(value, target, scale)) {
+                matchRaw();
+                break;
+            }
+            // Compare bit patterns, not values: cells match like their text,
+            // so -0.0 must not match 0.0 and nan must match nan
+            uint64_t targetBits;
+            std::memcpy(&targetBits, &target, sizeof(targetBits));
+            const double* floats = column.floats.data();
+            const uint8_t* scales = column.scales.data();
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t bits;
+                std::memcpy(&bits, &floats[i], sizeof(bits));
+                out[i] &= (state[i] == CELL_TYPED) & (bits == targetBits) & (scales[i] == scale);
+            }
+            break;
+        }
+        case ColumnType::BOOLEAN: {
+            auto it = std::find(column.spellings.begin(), column.spellings.end(), value);
+            if (it == column.spellings.end()) {
+                matchRaw();
+                break;
+            }
+            const uint8_t code = static_cast<uint8_t>(it - column.spellings.begin());
+            const uint8_t* codes = column.codes.data();
+            for (size_t i = 0; i < n; ++i) {
+                out[i] &= (state[i] == CELL_TYPED) & (codes[i] == code);
+            }
+            break;
+        }
+        case ColumnType::STRING: {
+            const uint32_t length = static_cast<uint32_t>(value.size());
+            const uint32_t* lengths = column.lengths.data();
+            for (size_t i = 0; i < n; ++i) {
+                if (out[i]) {
+                    out[i] = state[i] == CELL_TYPED && lengths[i] == length &&
+                             stringCell(column, i) == value;
+                }
+            }
+            break;
+        }
+    }
+}
+
+std::vector<size_t> ColumnarTable::findMatchingRows(const Row& condition) const {
+    std::vector<uint8_t> mask(rowCount_, 1);
+    for (const auto& cond : condition) {
+        auto it = columnIndex_.find(cond.first);
+        if (it == columnIndex_.end()) {
+            return {}; // No row has a value for an unknown column
+        }
+        filterColumn(columns_[it->second], cond.second, mask);
+    }
+    
+    std::vector<size_t> matches;
+    for (size_t i = 0; i < rowCount_; ++i) {
+        if (mask[i]) {
+            matches.push_back(i);
+        }
+    }
+    return matches;
+}
+
+std::vector<ColumnarTable::Row> ColumnarTable::selectRows(const Row& condition) const {
+    std::vector<Row> result;
+    for (size_t rowIndex : findMatchingRows(condition)) {
+        result.push_back(getRow(rowIndex));
+    }
+    return result;
+}
+
+size_t ColumnarTable::updateRows(const Row& data, const Row& condition) {
+    std::vector<size_t> matches = findMatchingRows(condition);
+    if (matches.empty()) {
+        return 0;
+    }
+    
+    for (const auto& pair : data) {
+        auto it = columnIndex_.find(pair.first);
+        Column& column = (it != columnIndex_.end()) ? columns_[it->second]
+                                                    : addColumn(pair.first, "string");
+        for (size_t rowIndex : matches) {
+            setCell(column, rowIndex, pair.second);
+        }
+    }
+    return matches.size();
+}
+
+size_t ColumnarTable::deleteRows(const Row& condition) {
+    if (condition.empty()) {
+        return 0;
+    }
+    
+    std::vector<size_t> matches = findMatchingRows(condition);
+    if (matches.empty()) {
+        return 0;
+    }
+    
+    std::vector<uint8_t> keep(rowCount_, 1);
+    for (size_t rowIndex : matches) {
+        keep[rowIndex] = 0;
+    }
+    eraseRows(keep);
+    return matches.size();
+}
+
+void ColumnarTable::eraseRows(const std::vector<uint8_t>& keep) {
+    size_t kept = 0;
+    for (auto& column : columns_) {
+        std::string arena;
+        std::unordered_map<size_t, std::string> raw;
+        size_t out = 0;
+        
+        for (size_t i = 0; i < rowCount_; ++i) {
+            if (!keep[i]) {
+                continue;
+            }
+            column.state[out] = column.state[i];
+            switch (column.type) {
+                case ColumnType::INTEGER:
+                    column.ints[out] = column.ints[i];
+                    break;
+                case ColumnType::FLOAT:
+                    column.floats[out] = column.floats[i];
+                    column.scales[out] = column.scales[i];
+                    break;
+                case ColumnType::BOOLEAN:
+                    column.codes[out] = column.codes[i];
+                    break;
+                case ColumnType::STRING: {
+                    std::string_view cell = stringCell(column, i);
+                    column.offsets[out] = arena.size();
+                    column.lengths[out] = column.lengths[i];
+                    arena.append(cell);
+                    break;
+                }
+            }
+            if (column.state[i] == CELL_RAW) {
+                raw[out] = std::move(column.raw[i]);
+            }
+            out++;
+        }
+        
+        column.state.resize(out);
+        column.ints.resize(column.type == ColumnType::INTEGER ? out : 0);
+        column.floats.resize(column.type == ColumnType::FLOAT ? out : 0);
+        column.scales.resize(column.type == ColumnType::FLOAT ? out : 0);
+        column.codes.resize(column.type == ColumnType::BOOLEAN ? out : 0);
+        column.offsets.resize(column.type == ColumnType::STRING ? out : 0);
+        column.lengths.resize(column.type == ColumnType::STRING ? out : 0);
+        if (column.type == ColumnType::STRING) {
+            column.arena = std::move(arena);
+            column.arenaGarbage = 0;
+        }
+        column.raw = std::move(raw);
+        kept = out;
+    }
+    
+    if (columns_.empty()) {
+        kept = static_cast<size_t>(std::count(keep.begin(), keep.end(), 1));
+    }
+    rowCount_ = kept;
+}
+
+void ColumnarTable::compactArena(Column& column) {
+    std::string arena;
+    arena.reserve(column.arena.size() - column.arenaGarbage);
+    for (size_t i = 0; i < rowCount_; ++i) {
+        std::string_view cell = stringCell(column, i);
+        column.offsets[i] = arena.size();
+        if (column.state[i] != CELL_NULL) {
+            arena.append(cell);
+        }
+    }
+    column.arena = std::move(arena);
+    column.arenaGarbage = 0;
+}
+
+size_t ColumnarTable::memoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& column : columns_) {
+        bytes += column.state.capacity();
+        bytes += column.ints.capacity() * sizeof(int64_t);
+        bytes += column.floats.capacity() * sizeof(double);
+        bytes += column.scales.capacity();
+        bytes += column.codes.capacity();
+        bytes += column.offsets.capacity() * sizeof(uint64_t);
+        bytes += column.lengths.capacity() * sizeof(uint32_t);
+        bytes += column.arena.capacity();
+        for (const auto& entry : column.raw) {
+            bytes += sizeof(entry) + entry.second.capacity();
+        }
+    }
+    return bytes;
+}
+
+} // namespace core
+} // namespace phantomdb
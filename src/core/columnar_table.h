@@ -0,0 +1,141 @@
+#ifndef PHANTOMDB_COLUMNAR_TABLE_H
+#define PHANTOMDB_COLUMNAR_TABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+namespace phantomdb {
+namespace core {
+
+// Physical storage class of a column, derived from the declared SQL type
+enum class ColumnType {
+    INTEGER,    // int64_t values
+    FLOAT,      // double values plus the number of fractional digits written
+    BOOLEAN,    // one-byte code into a per-column spelling dictionary
+    STRING      // offset + length into a per-column byte arena
+};
+
+/**
+ * @brief Typed, column-oriented row storage for a single table
+ *
+ * Each column is stored as a contiguous vector of fixed-width values
+ * (integers, floats, booleans) or as offsets into a byte arena (strings),
+ * so scans touch only the columns referenced by a predicate.
+ *
+ * The public interface speaks the same string-keyed row maps as the rest
+ * of core::Database. Cell text is reproduced exactly: values whose text
+ * differs from the canonical rendering of their typed form (for example
+ * "+5" or "007" in an integer column) are kept verbatim in a per-column
+ * side table.
+ */
+class ColumnarTable {
+public:
+    using Row = std::unordered_map<std::string, std::string>;
+    using ColumnDefinitions = std::vector<std::pair<std::string, std::string>>;
+    
+    explicit ColumnarTable(const ColumnDefinitions& columns = {});
+    
+    /**
+     * @brief Map a declared column type name to its physical storage class
+     */
+    static ColumnType columnTypeFromName(const std::string& typeName);
+    
+    // Schema and size
+    const ColumnDefinitions& getColumns() const { return definitions_; }
+    size_t rowCount() const { return rowCount_; }
+    size_t columnCount() const { return columns_.size(); }
+    
+    /**
+     * @brief Append a row; keys not in the schema create new string columns
+     */
+    void appendRow(const Row& row);
+    
+    /**
+     * @brief Materialize a single row back into a row map
+     */
+    Row getRow(size_t rowIndex) const;
+    
+    /**
+     * @brief Materialize every row back into row maps
+     */
+    std::vector<Row> toRows() const;
+    
+    /**
+     * @brief Indices of the rows whose cells equal every value in the condition
+     *
+     * An empty condition matches every row.
+     */
+    std::vector<size_t> findMatchingRows(const Row& condition) const;
+    
+    /**
+     * @brief Materialize the rows matching the condition
+     */
+    std::vector<Row> selectRows(const Row& condition) const;
+    
+    /**
+     * @brief Overwrite the given cells in every matching row
+     *
+     * @return Number of rows updated
+     */
+    size_t updateRows(const Row& data, const Row& condition);
+    
+    /**
+     * @brief Remove every matching row; an empty condition removes nothing
+     *
+     * @return Number of rows removed
+     */
+    size_t deleteRows(const Row& condition);
+    
+    /**
+     * @brief Approximate heap bytes used by the column vectors and arenas
+     */
+    size_t memoryUsage() const;
+
+private:
+    // Per-row cell state stored in Column::state
+    static constexpr uint8_t CELL_NULL = 0;
+    static constexpr uint8_t CELL_TYPED = 1;
+    static constexpr uint8_t CELL_RAW = 2;
+    
+    struct Column {
+        std::string name;
+        ColumnType type;
+        std::vector<uint8_t> state;
+        
+        std::vector<int64_t> ints;
+        std::vector<double> floats;
+        std::vector<uint8_t> scales;       // fractional digits for FLOAT
+        std::vector<uint8_t> codes;        // dictionary codes for BOOLEAN
+        std::vector<std::string> spellings;
+        std::vector<uint64_t> offsets;     // STRING arena offsets
+        std::vector<uint32_t> lengths;     // STRING lengths
+        std::string arena;
+        size_t arenaGarbage = 0;
+        
+        // Verbatim text of CELL_RAW cells, keyed by row index
+        std::unordered_map<size_t, std::string> raw;
+    };
+    
+    ColumnDefinitions definitions_;
+    std::vector<Column> columns_;
+    std::unordered_map<std::string, size_t> columnIndex_;
+    size_t rowCount_;
+    
+    Column& addColumn(const std::string& name, const std::string& typeName);
+    void appendNull(Column& column);
+    void setCell(Column& column, size_t rowIndex, const std::string& value);
+    bool getCell(const Column& column, size_t rowIndex, std::string& value) const;
+    std::string_view stringCell(const Column& column, size_t rowIndex) const;
+    void filterColumn(const Column& column, const std::string& value, std::vector<uint8_t>& mask) const;
+    void compactArena(Column& column);
+    void eraseRows(const std::vector<uint8_t>& keep);
+};
+
+} // namespace core
+} // namespace phantomdb
+
+#endif // PHANTOMDB_COLUMNAR_TABLE_H
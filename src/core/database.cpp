@@ -1,31 +1,229 @@
 #include "database.h"
 #include "utils.h"
 #include "enhanced_persistence.h"
+#include "columnar_table.h"
+#include "segmented_table.h"
 #include <iostream>
 #include <algorithm>
 #include <sstream>
 #include <mutex>
+#include <shared_mutex>
+#include <future>
+#include <thread>
+#include <atomic>
 
 namespace phantomdb {
 namespace core {
 
+namespace {
+
+// Below this many queued row changes per thread, recovery replays on fewer threads
+const size_t RECOVERY_RECORDS_PER_THREAD = 4096;
+
+} // anonymous namespace
+
 class Database::Impl {
 public:
-    Impl() : persistenceManager(std::make_unique<EnhancedPersistenceManager>()) {}
-    ~Impl() = default;
+    Impl() : persistenceManager(std::make_unique<EnhancedPersistenceManager>()), lastSnapshotResult(true) {}
     
+    ~Impl() {
+        // A background checkpoint still uses the persistence manager
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        collectSnapshot();
+    }
+    
+    // Locking is hierarchical: catalog_mutex guards the database map, each
+    // DatabaseEntry::mutex guards its table map and each Table::mutex guards
+    // its schema and rows. Locks are only ever taken in that order, and a
+    // lookup releases the outer lock as soon as it holds a shared_ptr to the
+    // inner object, so readers of one table never wait on writers of another.
+    //
+    // Changes are queued to the transaction log while the lock that orders
+    // them is still held, so each table's records are in apply order. lastLsn
+    // is the newest record already reflected in the object; checkpoints
+    // store it and recovery replays only what comes after.
+    //
+    // A writer may still hold a table that is being dropped (or replaced by
+    // a load or recovery). Dropping sets Table::dropped under the table's
+    // lock before the DROP record is queued, and writers check it once they
+    // hold the lock, so no change is applied to a dropped table or logged
+    // after its DROP.
     struct Table {
         std::vector<std::pair<std::string, std::string>> columns;
-        std::vector<std::unordered_map<std::string, std::string>> rows;
+        SegmentedTable storage;
+        uint64_t lastLsn = 0;
+        bool dropped = false;
+        mutable std::shared_mutex mutex;
     };
-
+    
+    struct DatabaseEntry {
+        std::unordered_map<std::string, std::shared_ptr<Table>> tables;
+        uint64_t lastLsn = 0;  // Newest CREATE/DROP record applied to the table map
+        mutable std::shared_mutex mutex;
+    };
+    
+    // A table as captured for a checkpoint
+    struct CapturedTable {
+        SegmentedTable::Snapshot snapshot;
+        uint64_t lsn;
+    };
+    
     // Database storage
-    std::unordered_map<std::string, std::unordered_map<std::string, Table>> databases;
+    std::unordered_map<std::string, std::shared_ptr<DatabaseEntry>> databases;
     
     std::unique_ptr<EnhancedPersistenceManager> persistenceManager;
     
-    // Concurrency control
-    mutable std::mutex db_mutex;
+    // Concurrency control for the database catalog
+    mutable std::shared_mutex catalog_mutex;
+    
+    // The background checkpoint, if one is running (guarded by snapshotMutex)
+    std::mutex snapshotMutex;
+    std::future<bool> pendingSnapshot;
+    bool lastSnapshotResult;
+    
+    // Wait for the running checkpoint, if any; caller holds snapshotMutex
+    bool collectSnapshot() {
+        if (pendingSnapshot.valid()) {
+            lastSnapshotResult = pendingSnapshot.get();
+        }
+        return lastSnapshotResult;
+    }
+    
+    std::shared_ptr<DatabaseEntry> findDatabase(const std::string& dbName) const {
+        std::shared_lock<std::shared_mutex> lock(catalog_mutex);
+        auto dbIt = databases.find(dbName);
+        if (dbIt == databases.end()) {
+            std::cout << "Database " << dbName << " not found" << std::endl;
+            return nullptr;
+        }
+        return dbIt->second;
+    }
+    
+    std::shared_ptr<Table> findTable(const std::string& dbName, const std::string& tableName) const {
+        auto database = findDatabase(dbName);
+        if (!database) {
+            return nullptr;
+        }
+        
+        std::shared_lock<std::shared_mutex> lock(database->mutex);
+        auto tableIt = database->tables.find(tableName);
+        if (tableIt == database->tables.end()) {
+            std::cout << "Table " << tableName << " not found in database " << dbName << std::endl;
+            return nullptr;
+        }
+        return tableIt->second;
+    }
+    
+    // Capture every table of a database; only segment pointers are copied
+    // while the locks are held
+    std::unordered_map<std::string, CapturedTable> captureTables(const DatabaseEntry& database,
+                                                                 uint64_t* databaseLsn = nullptr) const {
+        std::shared_lock<std::shared_mutex> dbLock(database.mutex);
+        if (databaseLsn != nullptr) {
+            *databaseLsn = database.lastLsn;
+        }
+        std::unordered_map<std::string, CapturedTable> tables;
+        for (const auto& tablePair : database.tables) {
+            std::shared_lock<std::shared_mutex> tableLock(tablePair.second->mutex);
+            tables[tablePair.first] = {tablePair.second->storage.snapshot(), tablePair.second->lastLsn};
+        }
+        return tables;
+    }
+    
+    // Copy every table of a database into the persistence format
+    std::unordered_map<std::string, TableData> exportTables(const DatabaseEntry& database) const {
+        std::unordered_map<std::string, TableData> tables;
+        for (auto& tablePair : captureTables(database)) {
+            TableData tableData;
+            tableData.columns = tablePair.second.snapshot.columns;
+            tableData.rows = tablePair.second.snapshot.toRows();
+            tables[tablePair.first] = std::move(tableData);
+        }
+        return tables;
+    }
+    
+    // Rebuild the tables of the latest checkpoint
+    bool loadCheckpointTables(const std::string& dbName,
+                              std::unordered_map<std::string, std::shared_ptr<Table>>& tables,
+                              uint64_t& databaseLsn) {
+        std::unordered_map<std::string, CheckpointTableData> loaded;
+        if (!persistenceManager->loadCheckpoint(dbName, loaded, &databaseLsn)) {
+            return false;
+        }
+        
+        for (auto& tablePair : loaded) {
+            auto& tableData = tablePair.second;
+            std::vector<SegmentedTable::SegmentView> segments;
+            for (auto& segment : tableData.segments) {
+                auto data = std::make_shared<ColumnarTable>(tableData.columns);
+                for (const auto& row : segment.data.rows) {
+                    data->appendRow(row);
+                }
+                segments.push_back({segment.id, segment.version, std::move(data)});
+            }
+            
+            auto table = std::make_shared<Table>();
+            table->columns = tableData.columns;
+            table->storage = SegmentedTable::fromSegments(tableData.columns, tableData.generation, std::move(segments));
+            table->lastLsn = tableData.lsn;
+            tables[tablePair.first] = std::move(table);
+        }
+        return true;
+    }
+    
+    // Refuse further writes through a table someone may still hold
+    static void markDropped(Table& table) {
+        std::unique_lock<std::shared_mutex> lock(table.mutex);
+        table.dropped = true;
+    }
+    
+    // Fail a write to a table dropped after the writer found it; the caller
+    // holds the table's lock
+    static bool checkNotDropped(const Table& table, const std::string& dbName, const std::string& tableName) {
+        if (table.dropped) {
+            std::cout << "Table " << tableName << " not found in database " << dbName << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // Install a table map as the contents of a database, creating it if needed
+    void installTables(const std::string& dbName,
+                       std::unordered_map<std::string, std::shared_ptr<Table>> tables,
+                       uint64_t databaseLsn) {
+        std::shared_ptr<DatabaseEntry> database;
+        {
+            std::unique_lock<std::shared_mutex> lock(catalog_mutex);
+            auto& entry = databases[dbName]; // Create entry if doesn't exist
+            if (!entry) {
+                entry = std::make_shared<DatabaseEntry>();
+            }
+            database = entry;
+        }
+        
+        std::unique_lock<std::shared_mutex> lock(database->mutex);
+        for (const auto& tablePair : database->tables) {
+            markDropped(*tablePair.second);
+        }
+        database->tables = std::move(tables);
+        database->lastLsn = databaseLsn;
+    }
+    
+    // Apply one table's share of replayed row changes, in log order
+    static void applyLogRecords(Table& table, const std::vector<const TransactionLogRecord*>& records) {
+        for (const auto* record : records) {
+            std::unordered_map<std::string, std::string> data(record->data.begin(), record->data.end());
+            std::unordered_map<std::string, std::string> condition(record->condition.begin(), record->condition.end());
+            if (record->operation == "INSERT") {
+                table.storage.appendRow(data);
+            } else if (record->operation == "UPDATE") {
+                table.storage.updateRows(data, condition);
+            } else if (record->operation == "DELETE") {
+                table.storage.deleteRows(condition);
+            }
+            table.lastLsn = record->lsn;
+        }
+    }
 };
 
 Database::Database() : pImpl(std::make_unique<Impl>()) {
@@ -37,42 +235,54 @@ Database::~Database() {
 }
 
 bool Database::createDatabase(const std::string& dbName) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    if (pImpl->databases.find(dbName) != pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " already exists" << std::endl;
-        return false;
+    uint64_t lsn;
+    {
+        std::unique_lock<std::shared_mutex> lock(pImpl->catalog_mutex);
+        if (pImpl->databases.find(dbName) != pImpl->databases.end()) {
+            std::cout << "Database " << dbName << " already exists" << std::endl;
+            return false;
+        }
+        
+        auto database = std::make_shared<Impl::DatabaseEntry>();
+        lsn = pImpl->persistenceManager->enqueueTransactionLog(dbName, "", "CREATE_DATABASE", {});
+        database->lastLsn = lsn;
+        pImpl->databases[dbName] = std::move(database);
     }
-    
-    pImpl->databases[dbName] = {};
     std::cout << "Created database " << dbName << std::endl;
     
-    // Log the operation
-    std::unordered_map<std::string, std::string> logData = {{"database", dbName}};
-    pImpl->persistenceManager->appendTransactionLog(dbName, "CREATE_DATABASE", logData);
+    pImpl->persistenceManager->commitTransactionLog(lsn);
     
     return true;
 }
 
 bool Database::dropDatabase(const std::string& dbName) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    auto it = pImpl->databases.find(dbName);
-    if (it == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
-        return false;
+    uint64_t lsn;
+    {
+        std::unique_lock<std::shared_mutex> lock(pImpl->catalog_mutex);
+        auto it = pImpl->databases.find(dbName);
+        if (it == pImpl->databases.end()) {
+            std::cout << "Database " << dbName << " not found" << std::endl;
+            return false;
+        }
+        
+        {
+            std::unique_lock<std::shared_mutex> databaseLock(it->second->mutex);
+            for (const auto& tablePair : it->second->tables) {
+                Impl::markDropped(*tablePair.second);
+            }
+        }
+        pImpl->databases.erase(it);
+        lsn = pImpl->persistenceManager->enqueueTransactionLog(dbName, "", "DROP_DATABASE", {});
     }
-    
-    pImpl->databases.erase(it);
     std::cout << "Dropped database " << dbName << std::endl;
     
-    // Log the operation
-    std::unordered_map<std::string, std::string> logData = {{"database", dbName}};
-    pImpl->persistenceManager->appendTransactionLog(dbName, "DROP_DATABASE", logData);
+    pImpl->persistenceManager->commitTransactionLog(lsn);
     
     return true;
 }
 
 std::vector<std::string> Database::listDatabases() const {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
+    std::shared_lock<std::shared_mutex> lock(pImpl->catalog_mutex);
     std::vector<std::string> result;
     result.reserve(pImpl->databases.size());
     
@@ -83,74 +293,82 @@ std::vector<std::string> Database::listDatabases() const {
     return result;
 }
 
-bool Database::createTable(const std::string& dbName, const std::string& tableName, 
+bool Database::createTable(const std::string& dbName, const std::string& tableName,
                           const std::vector<std::pair<std::string, std::string>>& columns) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    auto dbIt = pImpl->databases.find(dbName);
-    if (dbIt == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
+    auto database = pImpl->findDatabase(dbName);
+    if (!database) {
         return false;
     }
     
-    auto& tables = dbIt->second;
-    if (tables.find(tableName) != tables.end()) {
-        std::cout << "Table " << tableName << " already exists in database " << dbName << std::endl;
-        return false;
+    uint64_t lsn;
+    {
+        std::unique_lock<std::shared_mutex> lock(database->mutex);
+        auto& tables = database->tables;
+        if (tables.find(tableName) != tables.end()) {
+            std::cout << "Table " << tableName << " already exists in database " << dbName << std::endl;
+            return false;
+        }
+        
+        auto table = std::make_shared<Impl::Table>();
+        table->columns = columns;
+        table->storage = SegmentedTable(columns);
+        
+        // The schema is logged in declaration order so replay recreates it exactly
+        TransactionLogRecord record;
+        record.operation = "CREATE_TABLE";
+        record.table = tableName;
+        record.columns = columns;
+        lsn = pImpl->persistenceManager->enqueueTransactionLog(dbName, record);
+        table->lastLsn = lsn;
+        database->lastLsn = lsn;
+        tables[tableName] = std::move(table);
     }
-    
-    tables[tableName] = {columns, {}};
     std::cout << "Created table " << tableName << " in database " << dbName << std::endl;
     
-    // Log the operation
-    std::unordered_map<std::string, std::string> logData = {
-        {"database", dbName},
-        {"table", tableName}
-    };
-    pImpl->persistenceManager->appendTransactionLog(dbName, "CREATE_TABLE", logData);
+    pImpl->persistenceManager->commitTransactionLog(lsn);
     
     return true;
 }
 
 bool Database::dropTable(const std::string& dbName, const std::string& tableName) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    auto dbIt = pImpl->databases.find(dbName);
-    if (dbIt == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
+    auto database = pImpl->findDatabase(dbName);
+    if (!database) {
         return false;
     }
     
-    auto& tables = dbIt->second;
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cout << "Table " << tableName << " not found in database " << dbName << std::endl;
-        return false;
+    uint64_t lsn;
+    {
+        std::unique_lock<std::shared_mutex> lock(database->mutex);
+        auto& tables = database->tables;
+        auto tableIt = tables.find(tableName);
+        if (tableIt == tables.end()) {
+            std::cout << "Table " << tableName << " not found in database " << dbName << std::endl;
+            return false;
+        }
+        
+        Impl::markDropped(*tableIt->second);
+        tables.erase(tableIt);
+        lsn = pImpl->persistenceManager->enqueueTransactionLog(dbName, tableName, "DROP_TABLE", {});
+        database->lastLsn = lsn;
     }
-    
-    tables.erase(tableIt);
     std::cout << "Dropped table " << tableName << " from database " << dbName << std::endl;
     
-    // Log the operation
-    std::unordered_map<std::string, std::string> logData = {
-        {"database", dbName},
-        {"table", tableName}
-    };
-    pImpl->persistenceManager->appendTransactionLog(dbName, "DROP_TABLE", logData);
+    pImpl->persistenceManager->commitTransactionLog(lsn);
     
     return true;
 }
 
 std::vector<std::string> Database::listTables(const std::string& dbName) const {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    auto dbIt = pImpl->databases.find(dbName);
-    if (dbIt == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
+    auto database = pImpl->findDatabase(dbName);
+    if (!database) {
         return {};
     }
     
+    std::shared_lock<std::shared_mutex> lock(database->mutex);
     std::vector<std::string> result;
-    result.reserve(dbIt->second.size());
+    result.reserve(database->tables.size());
     
-    for (const auto& pair : dbIt->second) {
+    for (const auto& pair : database->tables) {
         result.push_back(pair.first);
     }
     
@@ -158,64 +376,48 @@ std::vector<std::string> Database::listTables(const std::string& dbName) const {
 }
 
 std::vector<std::pair<std::string, std::string>> Database::getTableSchema(const std::string& dbName, const std::string& tableName) const {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    auto dbIt = pImpl->databases.find(dbName);
-    if (dbIt == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
+    auto table = pImpl->findTable(dbName, tableName);
+    if (!table) {
         return {};
     }
     
-    auto& tables = dbIt->second;
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cout << "Table " << tableName << " not found in database " << dbName << std::endl;
-        return {};
-    }
-    
-    return tableIt->second.columns; // Return column definitions
+    std::shared_lock<std::shared_mutex> lock(table->mutex);
+    return table->columns; // Return column definitions
 }
 
 bool Database::insertData(const std::string& dbName, const std::string& tableName,
                          const std::unordered_map<std::string, std::string>& data) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    auto dbIt = pImpl->databases.find(dbName);
-    if (dbIt == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
-        return false;
-    }
-    
-    auto& tables = dbIt->second;
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cout << "Table " << tableName << " not found in database " << dbName << std::endl;
+    auto table = pImpl->findTable(dbName, tableName);
+    if (!table) {
         return false;
     }
     
-    // Get column definitions for schema validation
-    const auto& columnDefinitions = tableIt->second.columns;
-    
-    // Validate data against schema
-    std::string validationError;
-    if (!columnDefinitions.empty() && !utils::validateData(data, 
-        std::unordered_map<std::string, std::string>(columnDefinitions.begin(), columnDefinitions.end()), 
-        validationError)) {
-        std::cout << "Data validation failed: " << validationError << std::endl;
-        return false;
+    uint64_t lsn;
+    {
+        std::unique_lock<std::shared_mutex> lock(table->mutex);
+        if (!Impl::checkNotDropped(*table, dbName, tableName)) {
+            return false;
+        }
+        
+        // Get column definitions for schema validation
+        const auto& columnDefinitions = table->columns;
+        
+        // Validate data against schema
+        std::string validationError;
+        if (!columnDefinitions.empty() && !utils::validateData(data,
+            std::unordered_map<std::string, std::string>(columnDefinitions.begin(), columnDefinitions.end()),
+            validationError)) {
+            std::cout << "Data validation failed: " << validationError << std::endl;
+            return false;
+        }
+        
+        table->storage.appendRow(data);
+        lsn = pImpl->persistenceManager->enqueueTransactionLog(dbName, tableName, "INSERT", data);
+        table->lastLsn = lsn;
     }
-    
-    tableIt->second.rows.push_back(data);
     std::cout << "Inserted data into table " << tableName << " in database " << dbName << std::endl;
     
-    // Log the operation
-    std::unordered_map<std::string, std::string> logData = {
-        {"database", dbName},
-        {"table", tableName}
-    };
-    // Add data fields to log
-    for (const auto& pair : data) {
-        logData[pair.first] = pair.second;
-    }
-    pImpl->persistenceManager->appendTransactionLog(dbName, "INSERT", logData);
+    pImpl->persistenceManager->commitTransactionLog(lsn);
     
     return true;
 }
@@ -223,18 +425,8 @@ bool Database::insertData(const std::string& dbName, const std::string& tableNam
 std::vector<std::unordered_map<std::string, std::string>> Database::selectData(
     const std::string& dbName, const std::string& tableName,
     const std::unordered_map<std::string, std::string>& condition) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    
-    auto dbIt = pImpl->databases.find(dbName);
-    if (dbIt == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
-        return {};
-    }
-    
-    auto& tables = dbIt->second;
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cout << "Table " << tableName << " not found in database " << dbName << std::endl;
+    auto table = pImpl->findTable(dbName, tableName);
+    if (!table) {
         return {};
     }
     
@@ -243,122 +435,73 @@ std::vector<std::unordered_map<std::string, std::string>> Database::selectData(
     
     // Filter data based on condition
     std::vector<std::unordered_map<std::string, std::string>> result;
-    const auto& allData = tableIt->second.rows;
-    
-    for (const auto& row : allData) {
-        bool matches = true;
-        for (const auto& cond : condition) {
-            auto it = row.find(cond.first);
-            if (it == row.end() || it->second != cond.second) {
-                matches = false;
-                break;
-            }
-        }
-        if (matches) {
-            result.push_back(row);
-        }
+    {
+        std::shared_lock<std::shared_mutex> lock(table->mutex);
+        result = table->storage.selectRows(condition);
     }
     
-    std::cout << "Selected " << result.size() << " rows from table " << tableName 
+    std::cout << "Selected " << result.size() << " rows from table " << tableName
               << " in database " << dbName << std::endl;
     
-    // Log the operation
-    std::unordered_map<std::string, std::string> logData = {
-        {"database", dbName},
-        {"table", tableName},
-        {"result_count", std::to_string(result.size())}
-    };
-    pImpl->persistenceManager->appendTransactionLog(dbName, "SELECT", logData);
-    
+    // Reads change nothing, so they are not written to the transaction log
     return result;
 }
 
 bool Database::updateData(const std::string& dbName, const std::string& tableName,
                          const std::unordered_map<std::string, std::string>& data,
                          const std::unordered_map<std::string, std::string>& condition) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    
-    auto dbIt = pImpl->databases.find(dbName);
-    if (dbIt == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
+    auto table = pImpl->findTable(dbName, tableName);
+    if (!table) {
         return false;
     }
     
-    auto& tables = dbIt->second;
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cout << "Table " << tableName << " not found in database " << dbName << std::endl;
-        return false;
-    }
-    
-    // Get column definitions for schema validation
-    const auto& columnDefinitions = tableIt->second.columns;
-    
-    // Validate update data against schema
-    std::string validationError;
-    if (!columnDefinitions.empty() && !utils::validateData(data, 
-        std::unordered_map<std::string, std::string>(columnDefinitions.begin(), columnDefinitions.end()), 
-        validationError)) {
-        std::cout << "Update data validation failed: " << validationError << std::endl;
-        return false;
-    }
-    
-    // For now, we'll treat the condition map as a simple key-value filter
-    // In a more advanced implementation, we would parse a condition string
-    
-    // Update matching rows
-    auto& tableData = tableIt->second.rows;
     int updatedRows = 0;
-    
-    for (auto& row : tableData) {
-        bool matches = true;
-        if (!condition.empty()) {
-            for (const auto& cond : condition) {
-                auto it = row.find(cond.first);
-                if (it == row.end() || it->second != cond.second) {
-                    matches = false;
-                    break;
-                }
-            }
+    uint64_t lsn = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(table->mutex);
+        if (!Impl::checkNotDropped(*table, dbName, tableName)) {
+            return false;
         }
         
-        if (matches) {
-            // Update the row with new data
-            for (const auto& pair : data) {
-                row[pair.first] = pair.second;
-            }
-            updatedRows++;
+        // Get column definitions for schema validation
+        const auto& columnDefinitions = table->columns;
+        
+        // Validate update data against schema
+        std::string validationError;
+        if (!columnDefinitions.empty() && !utils::validateData(data,
+            std::unordered_map<std::string, std::string>(columnDefinitions.begin(), columnDefinitions.end()),
+            validationError)) {
+            std::cout << "Update data validation failed: " << validationError << std::endl;
+            return false;
+        }
+        
+        // For now, we'll treat the condition map as a simple key-value filter
+        // In a more advanced implementation, we would parse a condition string
+        
+        // Update matching rows
+        updatedRows = static_cast<int>(table->storage.updateRows(data, condition));
+        
+        // An update that matched nothing has nothing to replay
+        if (updatedRows > 0) {
+            lsn = pImpl->persistenceManager->enqueueTransactionLog(dbName, tableName, "UPDATE", data, condition);
+            table->lastLsn = lsn;
         }
     }
     
-    std::cout << "Updated " << updatedRows << " rows in table " << tableName 
+    std::cout << "Updated " << updatedRows << " rows in table " << tableName
               << " in database " << dbName << std::endl;
     
-    // Log the operation
-    std::unordered_map<std::string, std::string> logData = {
-        {"database", dbName},
-        {"table", tableName},
-        {"updated_rows", std::to_string(updatedRows)}
-    };
-    pImpl->persistenceManager->appendTransactionLog(dbName, "UPDATE", logData);
+    if (lsn != 0) {
+        pImpl->persistenceManager->commitTransactionLog(lsn);
+    }
     
     return true;
 }
 
 bool Database::deleteData(const std::string& dbName, const std::string& tableName,
                          const std::unordered_map<std::string, std::string>& condition) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    
-    auto dbIt = pImpl->databases.find(dbName);
-    if (dbIt == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
-        return false;
-    }
-    
-    auto& tables = dbIt->second;
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cout << "Table " << tableName << " not found in database " << dbName << std::endl;
+    auto table = pImpl->findTable(dbName, tableName);
+    if (!table) {
         return false;
     }
     
@@ -366,142 +509,327 @@ bool Database::deleteData(const std::string& dbName, const std::string& tableNam
     // In a more advanced implementation, we would parse a condition string
     
     // Remove matching rows
-    auto& tableData = tableIt->second.rows;
-    auto newEnd = std::remove_if(tableData.begin(), tableData.end(), 
-        [&condition](const std::unordered_map<std::string, std::string>& row) {
-            if (condition.empty()) return false; // Don't remove if no condition
-            for (const auto& cond : condition) {
-                auto it = row.find(cond.first);
-                if (it == row.end() || it->second != cond.second) {
-                    return false; // Don't remove if condition doesn't match
-                }
-            }
-            return true; // Remove if all conditions match
-        });
-    
-    int deletedRows = std::distance(newEnd, tableData.end());
-    tableData.erase(newEnd, tableData.end());
+    int deletedRows = 0;
+    uint64_t lsn = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(table->mutex);
+        if (!Impl::checkNotDropped(*table, dbName, tableName)) {
+            return false;
+        }
+        deletedRows = static_cast<int>(table->storage.deleteRows(condition));
+        if (deletedRows > 0) {
+            lsn = pImpl->persistenceManager->enqueueTransactionLog(dbName, tableName, "DELETE", {}, condition);
+            table->lastLsn = lsn;
+        }
+    }
     
-    std::cout << "Deleted " << deletedRows << " rows from table " << tableName 
+    std::cout << "Deleted " << deletedRows << " rows from table " << tableName
               << " in database " << dbName << std::endl;
     
-    // Log the operation
-    std::unordered_map<std::string, std::string> logData = {
-        {"database", dbName},
-        {"table", tableName},
-        {"deleted_rows", std::to_string(deletedRows)}
-    };
-    pImpl->persistenceManager->appendTransactionLog(dbName, "DELETE", logData);
+    if (lsn != 0) {
+        pImpl->persistenceManager->commitTransactionLog(lsn);
+    }
     
     return true;
 }
 
 bool Database::saveToDisk(const std::string& dbName, const std::string& filename) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    auto dbIt = pImpl->databases.find(dbName);
-    if (dbIt == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
+    auto database = pImpl->findDatabase(dbName);
+    if (!database) {
         return false;
     }
     
     // Convert to the format expected by EnhancedPersistenceManager
-    std::unordered_map<std::string, TableData> tables;
-    for (const auto& tablePair : dbIt->second) {
-        TableData tableData;
-        tableData.columns = tablePair.second.columns;
-        tableData.rows = tablePair.second.rows;
-        tables[tablePair.first] = tableData;
-    }
+    std::unordered_map<std::string, TableData> tables = pImpl->exportTables(*database);
     
     return pImpl->persistenceManager->saveDatabase(dbName, tables, filename);
 }
 
 bool Database::loadFromDisk(const std::string& dbName, const std::string& filename) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    auto& tables = pImpl->databases[dbName]; // Create entry if doesn't exist
-    
-    // Load using EnhancedPersistenceManager
-    std::unordered_map<std::string, TableData> loadedTables;
-    bool result = pImpl->persistenceManager->loadDatabase(dbName, loadedTables, filename);
+    // Tables are decoded and converted to columnar storage on the loader threads
+    std::unordered_map<std::string, std::shared_ptr<Impl::Table>> loadedTables;
+    std::mutex loadedMutex;
+    bool result = pImpl->persistenceManager->loadDatabase(dbName,
+        [&loadedTables, &loadedMutex](const std::string& tableName, TableData&& tableData) {
+            auto table = std::make_shared<Impl::Table>();
+            table->columns = std::move(tableData.columns);
+            table->storage = SegmentedTable(table->columns);
+            for (const auto& row : tableData.rows) {
+                table->storage.appendRow(row);
+            }
+            
+            std::lock_guard<std::mutex> lock(loadedMutex);
+            loadedTables[tableName] = std::move(table);
+        }, filename);
+    
+    std::shared_ptr<Impl::DatabaseEntry> database;
+    {
+        std::unique_lock<std::shared_mutex> lock(pImpl->catalog_mutex);
+        auto& entry = pImpl->databases[dbName]; // Create entry if doesn't exist
+        if (!entry) {
+            entry = std::make_shared<Impl::DatabaseEntry>();
+        }
+        database = entry;
+    }
     
     if (result) {
-        // Convert back to internal format
-        for (const auto& tablePair : loadedTables) {
-            Impl::Table table;
-            table.columns = tablePair.second.columns;
-            table.rows = tablePair.second.rows;
-            tables[tablePair.first] = table;
+        std::unique_lock<std::shared_mutex> lock(database->mutex);
+        for (auto& tablePair : loadedTables) {
+            auto& slot = database->tables[tablePair.first];
+            if (slot) {
+                Impl::markDropped(*slot);
+            }
+            slot = std::move(tablePair.second);
         }
     }
     
     return result;
 }
 
+bool Database::exportToCSV(const std::string& dbName, const std::string& filename) {
+    auto database = pImpl->findDatabase(dbName);
+    if (!database) {
+        return false;
+    }
+    
+    std::unordered_map<std::string, TableData> tables = pImpl->exportTables(*database);
+    
+    return pImpl->persistenceManager->exportDatabaseCSV(dbName, tables, filename);
+}
+
 bool Database::appendTransactionLog(const std::string& dbName, const std::string& operation,
                                    const std::unordered_map<std::string, std::string>& data) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
     return pImpl->persistenceManager->appendTransactionLog(dbName, operation, data);
 }
 
+bool Database::flushTransactionLog() {
+    return pImpl->persistenceManager->flushTransactionLog();
+}
+
 bool Database::createSnapshot(const std::string& dbName) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
-    auto dbIt = pImpl->databases.find(dbName);
-    if (dbIt == pImpl->databases.end()) {
-        std::cout << "Database " << dbName << " not found" << std::endl;
+    auto database = pImpl->findDatabase(dbName);
+    if (!database) {
         return false;
     }
+    if (!pImpl->persistenceManager->isSnapshotEnabled()) {
+        return true; // Not an error, just not enabled
+    }
     
-    // Convert to the format expected by EnhancedPersistenceManager
-    std::unordered_map<std::string, TableData> tables;
-    for (const auto& tablePair : dbIt->second) {
-        TableData tableData;
-        tableData.columns = tablePair.second.columns;
-        tableData.rows = tablePair.second.rows;
-        tables[tablePair.first] = tableData;
+    // Writers only wait while the segment pointers are copied; a segment
+    // they modify afterwards is cloned, so the capture stays unchanged
+    uint64_t databaseLsn;
+    std::unordered_map<std::string, CheckpointTable> tables;
+    for (auto& tablePair : pImpl->captureTables(*database, &databaseLsn)) {
+        auto& snapshot = tablePair.second.snapshot;
+        CheckpointTable table{snapshot.generation, snapshot.columns, {}, tablePair.second.lsn};
+        for (auto& segment : snapshot.segments) {
+            table.segments.push_back({segment.id, segment.version,
+                [data = segment.data, columns = snapshot.columns]() {
+                    TableData tableData;
+                    tableData.columns = columns;
+                    tableData.rows = data->toRows();
+                    return tableData;
+                }});
+        }
+        tables[tablePair.first] = std::move(table);
     }
     
-    return pImpl->persistenceManager->createSnapshot(dbName, tables);
+    std::lock_guard<std::mutex> lock(pImpl->snapshotMutex);
+    pImpl->collectSnapshot(); // One checkpoint at a time
+    
+    EnhancedPersistenceManager* persistenceManager = pImpl->persistenceManager.get();
+    pImpl->pendingSnapshot = std::async(std::launch::async,
+        [persistenceManager, dbName, databaseLsn, tables = std::move(tables)]() {
+            size_t written = 0;
+            bool result = persistenceManager->writeCheckpoint(dbName, databaseLsn, tables, &written);
+            if (result) {
+                std::cout << "Checkpoint of database " << dbName << " wrote " << written
+                          << " changed segments" << std::endl;
+            }
+            return result;
+        });
+    
+    return true;
+}
+
+bool Database::waitForSnapshot() {
+    std::lock_guard<std::mutex> lock(pImpl->snapshotMutex);
+    return pImpl->collectSnapshot();
 }
 
+bool Database::restoreSnapshot(const std::string& dbName) {
+    {
+        // Make sure a checkpoint still being written is included
+        std::lock_guard<std::mutex> lock(pImpl->snapshotMutex);
+        pImpl->collectSnapshot();
+    }
+    
+    std::unordered_map<std::string, std::shared_ptr<Impl::Table>> tables;
+    uint64_t databaseLsn = 0;
+    if (!pImpl->loadCheckpointTables(dbName, tables, databaseLsn)) {
+        std::cout << "No snapshot found for database " << dbName << std::endl;
+        return false;
+    }
+    
+    pImpl->installTables(dbName, std::move(tables), databaseLsn);
+    std::cout << "Restored database " << dbName << " from snapshot" << std::endl;
+    
+    return true;
+}
+
+bool Database::recover(const std::string& dbName) {
+    {
+        std::lock_guard<std::mutex> lock(pImpl->snapshotMutex);
+        pImpl->collectSnapshot();
+    }
+    
+    // Start from the latest checkpoint, if there is one
+    std::unordered_map<std::string, std::shared_ptr<Impl::Table>> tables;
+    uint64_t databaseLsn = 0;
+    bool fromCheckpoint = pImpl->loadCheckpointTables(dbName, tables, databaseLsn);
+    
+    // Nothing at or below the oldest checkpointed lsn needs to be read
+    uint64_t fromLsn = databaseLsn;
+    for (const auto& tablePair : tables) {
+        fromLsn = std::min(fromLsn, tablePair.second->lastLsn);
+    }
+    std::vector<TransactionLogRecord> records;
+    if (!pImpl->persistenceManager->replayTransactionLog(dbName,
+            [&records](const TransactionLogRecord& record) { records.push_back(record); }, fromLsn)) {
+        return false;
+    }
+    if (!fromCheckpoint && records.empty()) {
+        std::cout << "Nothing to recover for database " << dbName << std::endl;
+        return false;
+    }
+    
+    // Row changes of different tables are independent, so they are queued
+    // per table and applied in parallel. Catalog changes are barriers: the
+    // queued row changes are applied before the table map is modified.
+    std::unordered_map<std::string, std::vector<const TransactionLogRecord*>> pending;
+    size_t pendingCount = 0;
+    size_t applied = 0;
+    auto applyPending = [&]() {
+        std::vector<std::pair<Impl::Table*, const std::vector<const TransactionLogRecord*>*>> jobs;
+        for (const auto& tablePair : pending) {
+            jobs.emplace_back(tables.at(tablePair.first).get(), &tablePair.second);
+        }
+        
+        std::atomic<size_t> nextJob(0);
+        auto worker = [&]() {
+            size_t i;
+            while ((i = nextJob.fetch_add(1)) < jobs.size()) {
+                Impl::applyLogRecords(*jobs[i].first, *jobs[i].second);
+            }
+        };
+        size_t threadCount = std::min<size_t>({std::max(1u, std::thread::hardware_concurrency()),
+                                               jobs.size(), pendingCount / RECOVERY_RECORDS_PER_THREAD + 1});
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < threadCount; ++t) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : workers) {
+            thread.join();
+        }
+        
+        applied += pendingCount;
+        pending.clear();
+        pendingCount = 0;
+    };
+    
+    bool exists = true;
+    for (const auto& record : records) {
+        const std::string& operation = record.operation;
+        if (operation == "INSERT" || operation == "UPDATE" || operation == "DELETE") {
+            // Skip changes to tables that were dropped, or already in the checkpoint
+            auto it = tables.find(record.table);
+            if (it != tables.end() && record.lsn > it->second->lastLsn) {
+                pending[record.table].push_back(&record);
+                pendingCount++;
+            }
+            continue;
+        }
+        if (record.lsn <= databaseLsn ||
+            (operation != "CREATE_TABLE" && operation != "DROP_TABLE" &&
+             operation != "CREATE_DATABASE" && operation != "DROP_DATABASE")) {
+            continue;
+        }
+        
+        applyPending();
+        if (operation == "CREATE_TABLE") {
+            auto table = std::make_shared<Impl::Table>();
+            table->columns = record.columns;
+            table->storage = SegmentedTable(record.columns);
+            table->lastLsn = record.lsn;
+            tables[record.table] = std::move(table);
+        } else if (operation == "DROP_TABLE") {
+            tables.erase(record.table);
+        } else {
+            // A dropped database comes back empty if it is created again
+            tables.clear();
+            exists = operation == "CREATE_DATABASE";
+        }
+        databaseLsn = record.lsn;
+        applied++;
+    }
+    applyPending();
+    
+    if (exists) {
+        pImpl->installTables(dbName, std::move(tables), databaseLsn);
+    } else {
+        std::unique_lock<std::shared_mutex> lock(pImpl->catalog_mutex);
+        pImpl->databases.erase(dbName);
+    }
+    std::cout << "Recovered database " << dbName << (fromCheckpoint ? " from checkpoint" : "")
+              << " and " << applied << " log records" << std::endl;
+    
+    return true;
+}
+
+// The persistence manager serializes its own configuration, so these
+// accessors don't need to take any catalog or table lock.
 void Database::setDataDirectory(const std::string& directory) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
     pImpl->persistenceManager->setDataDirectory(directory);
 }
 
 std::string Database::getDataDirectory() const {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
     return pImpl->persistenceManager->getDataDirectory();
 }
 
 void Database::setSnapshotEnabled(bool enabled) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
     pImpl->persistenceManager->setSnapshotEnabled(enabled);
 }
 
 bool Database::isSnapshotEnabled() const {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
     return pImpl->persistenceManager->isSnapshotEnabled();
 }
 
 void Database::setSnapshotInterval(size_t interval) {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
     pImpl->persistenceManager->setSnapshotInterval(interval);
 }
 
 size_t Database::getSnapshotInterval() const {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
     return pImpl->persistenceManager->getSnapshotInterval();
 }
 
+void Database::setLogSyncPolicy(LogSyncPolicy policy, size_t intervalMs) {
+    pImpl->persistenceManager->setLogSyncPolicy(policy, intervalMs);
+}
+
+LogSyncPolicy Database::getLogSyncPolicy() const {
+    return pImpl->persistenceManager->getLogSyncPolicy();
+}
+
 bool Database::isHealthy() const {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
+    std::shared_lock<std::shared_mutex> lock(pImpl->catalog_mutex);
     return true;
 }
 
 std::string Database::getStats() const {
-    std::lock_guard<std::mutex> lock(pImpl->db_mutex);
+    std::shared_lock<std::shared_mutex> lock(pImpl->catalog_mutex);
     return "Database is healthy";
 }
 
 } // namespace core
-} // namespace phantomdb
\ No newline at end of file
+} // namespace phantomdb
@@ -11,6 +11,7 @@ namespace core {
 
 // Forward declaration
 class EnhancedPersistenceManager;
+enum class LogSyncPolicy;
 
 class Database {
 public:
@@ -44,11 +45,16 @@ public:
     // Persistence operations
     bool saveToDisk(const std::string& dbName, const std::string& filename = "");
     bool loadFromDisk(const std::string& dbName, const std::string& filename = "");
+    bool exportToCSV(const std::string& dbName, const std::string& filename = "");
     
     // Enhanced persistence operations
     bool appendTransactionLog(const std::string& dbName, const std::string& operation,
                              const std::unordered_map<std::string, std::string>& data);
-    bool createSnapshot(const std::string& dbName);
+    bool flushTransactionLog();
+    bool createSnapshot(const std::string& dbName);  // Incremental, written in the background
+    bool waitForSnapshot();
+    bool restoreSnapshot(const std::string& dbName);
+    bool recover(const std::string& dbName);  // Latest checkpoint plus the log records written after it
     
     // Configuration
     void setDataDirectory(const std::string& directory);
@@ -57,6 +63,8 @@ public:
     bool isSnapshotEnabled() const;
     void setSnapshotInterval(size_t interval);
     size_t getSnapshotInterval() const;
+    void setLogSyncPolicy(LogSyncPolicy policy, size_t intervalMs = 10);
+    LogSyncPolicy getLogSyncPolicy() const;
     
     // Status and health checks
     bool isHealthy() const;
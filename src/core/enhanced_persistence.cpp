@@ -5,23 +5,119 @@
 #include <algorithm>
 #include <chrono>
 #include <iomanip>
+#include <fstream>
+#include <unordered_set>
+#include "binary_snapshot.h"
+#include "utils.h"
+#include "wal_manager.h"
 
 namespace phantomdb {
 namespace core {
 
+namespace {
+
+// Records are framed and checksummed by storage::WALManager
+const size_t LOG_QUEUE_CAPACITY = 8192;
+const size_t LOG_MAX_BATCH = 1024;
+const uint64_t LSN_RESERVATION_BLOCK = 1 << 20;
+const char* const LSN_RESERVATION_FILE = "wal.lsn";
+
+const char* const CHECKPOINT_MANIFEST = "MANIFEST";
+const char* const CHECKPOINT_CHUNK_PREFIX = "chunks_";
+
+storage::WALRecord toWALRecord(const TransactionLogRecord& record) {
+    storage::WALRecord walRecord;
+    walRecord.lsn = record.lsn;
+    walRecord.timestamp = record.timestamp;
+    walRecord.type = storage::WALRecord::typeFromName(record.operation);
+    walRecord.operation = record.operation;
+    walRecord.table = record.table;
+    walRecord.columns = record.columns;
+    walRecord.data = record.data;
+    walRecord.condition = record.condition;
+    return walRecord;
+}
+
+TransactionLogRecord fromWALRecord(const storage::WALRecord& walRecord) {
+    TransactionLogRecord record;
+    record.lsn = walRecord.lsn;
+    record.timestamp = walRecord.timestamp;
+    record.operation = walRecord.operation;
+    record.table = walRecord.table;
+    record.columns = walRecord.columns;
+    record.data = walRecord.data;
+    record.condition = walRecord.condition;
+    return record;
+}
+
+std::string checkpointKey(const std::string& tableName, uint64_t generation, uint64_t segmentId) {
+    std::string key = tableName;
+    key.push_back('\0');
+    key += std::to_string(generation);
+    key.push_back('\0');
+    key += std::to_string(segmentId);
+    return key;
+}
+
+} // anonymous namespace
+
 EnhancedPersistenceManager::EnhancedPersistenceManager() 
     : dataDirectory_("./data"), 
       snapshotEnabled_(true), 
       snapshotInterval_(1000), 
-      operationCount_(0) {
+      operationCount_(0),
+      logQueue_(LOG_QUEUE_CAPACITY),
+      logStopping_(false),
+      logFailed_(false),
+      logSyncPolicy_(LogSyncPolicy::INTERVAL),
+      logSyncIntervalMs_(10),
+      lastQueuedLsn_(0),
+      durableLsn_(0),
+      requestedSyncLsn_(0),
+      lsnBase_(0),
+      reservedLsn_(0),
+      logPending_(0),
+      logWriterWake_(false) {
     // Create data directory if it doesn't exist
     std::filesystem::create_directories(dataDirectory_);
+    reservedLsn_ = readLsnReservation();
+    lsnBase_.store(reservedLsn_);
+    
+    logWriter_ = std::thread(&EnhancedPersistenceManager::logWriterLoop, this);
+}
+
+EnhancedPersistenceManager::~EnhancedPersistenceManager() {
+    // The writer drains and syncs everything still queued before exiting
+    logStopping_.store(true);
+    wakeLogWriter();
+    if (logWriter_.joinable()) {
+        logWriter_.join();
+    }
+    
+    std::lock_guard<std::mutex> filesLock(logFilesMutex_);
+    closeLogFiles();
 }
 
 void EnhancedPersistenceManager::setDataDirectory(const std::string& directory) {
+    // Hold producers off while the base moves, so no lsn handed out is
+    // computed from a different base than the writer stamps it with.
+    // Records already queued belong to the old directory
+    std::unique_lock<std::shared_mutex> baseLock(lsnBaseMutex_);
+    flushTransactionLog();
+    
+    std::lock_guard<std::mutex> checkpointLock(checkpointMutex_);
+    checkpointManifests_.clear();
+    
+    std::lock_guard<std::mutex> filesLock(logFilesMutex_);
+    closeLogFiles();
+    
     std::lock_guard<std::mutex> lock(mutex_);
     dataDirectory_ = directory;
     std::filesystem::create_directories(dataDirectory_);
+    
+    // Queue positions only grow, so raising the base keeps lsns increasing
+    reservedLsn_ = readLsnReservation();
+    lsnBase_.store(std::max(lsnBase_.load(), reservedLsn_));
 }
 
 std::string EnhancedPersistenceManager::getDataDirectory() const {
@@ -33,8 +129,94 @@ bool EnhancedPersistenceManager::saveDatabase(const std::string& databaseName,
                                             const std::unordered_map<std::string, TableData>& tables,
                                             const std::string& filename) {
     try {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::string filePath = getDatabaseFilePath(databaseName, filename);
+        std::string filePath;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            filePath = getDatabaseFilePath(databaseName, filename);
+        }
+        
+        if (!BinarySnapshotWriter::write(filePath, databaseName, tables)) {
+            return false;
+        }
+        std::cout << "Database '" << databaseName << "' saved to " << filePath << std::endl;
+        
+        // Increment operation count and check if snapshot is needed
+        bool snapshotNeeded;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            operationCount_++;
+            snapshotNeeded = isSnapshotNeeded();
+            if (snapshotNeeded) {
+                operationCount_ = 0; // Reset counter before the snapshot
+            }
+        }
+        if (snapshotNeeded) {
+            createSnapshot(databaseName, tables);
+        }
+        
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error saving database: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool EnhancedPersistenceManager::loadDatabase(const std::string& databaseName,
+                                            std::unordered_map<std::string, TableData>& tables,
+                                            const std::string& filename) {
+    // Clear existing data
+    tables.clear();
+    
+    std::mutex tablesMutex;
+    return loadDatabase(databaseName, [&tables, &tablesMutex](const std::string& tableName, TableData&& table) {
+        std::lock_guard<std::mutex> lock(tablesMutex);
+        tables[tableName] = std::move(table);
+    }, filename);
+}
+
+bool EnhancedPersistenceManager::loadDatabase(const std::string& databaseName,
+                                            const TableLoadCallback& onTable,
+                                            const std::string& filename) {
+    try {
+        std::string filePath;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            filePath = getDatabaseFilePath(databaseName, filename);
+        }
+        
+        if (!std::filesystem::exists(filePath)) {
+            std::cerr << "Failed to open file for reading: " << filePath << std::endl;
+            return false;
+        }
+        if (!BinarySnapshotReader::isSnapshotFile(filePath)) {
+            std::cerr << "Not a binary snapshot (CSV files are export-only): " << filePath << std::endl;
+            return false;
+        }
+        
+        BinarySnapshotReader reader;
+        if (!reader.open(filePath) || !reader.loadAll(onTable)) {
+            std::cerr << "Failed to load database from " << filePath << std::endl;
+            return false;
+        }
+        
+        std::cout << "Database '" << databaseName << "' loaded from " << filePath << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading database: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool EnhancedPersistenceManager::exportDatabaseCSV(const std::string& databaseName,
+                                                 const std::unordered_map<std::string, TableData>& tables,
+                                                 const std::string& filename) {
+    try {
+        std::string filePath;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            filePath = filename.empty() ? dataDirectory_ + "/" + databaseName + ".csv"
+                                        : getDatabaseFilePath(databaseName, filename);
+        }
         
         // Create directory structure if needed
         std::filesystem::path pathObj(filePath);
@@ -49,11 +231,11 @@ bool EnhancedPersistenceManager::saveDatabase(const std::string& databaseName,
         // Write database header with timestamp
         auto now = std::chrono::system_clock::now();
         auto time_t = std::chrono::system_clock::to_time_t(now);
-        file << "# PhantomDB Database File\n";
+        file << "# PhantomDB Database Export\n";
         file << "# Database: " << databaseName << "\n";
         file << "# Format: CSV\n";
         file << "# Generated: " << std::put_time(std::gmtime(&time_t), "%Y-%m-%d %H:%M:%S UTC") << "\n";
-        file << "# Type: Snapshot\n\n";
+        file << "# Type: Export\n\n";
         
         // Write each table
         for (const auto& tablePair : tables) {
@@ -105,247 +287,625 @@ bool EnhancedPersistenceManager::saveDatabase(const std::string& databaseName,
         }
         
         file.close();
-        std::cout << "Database '" << databaseName << "' saved to " << filePath << std::endl;
-        
-        // Increment operation count and check if snapshot is needed
-        operationCount_++;
-        if (isSnapshotNeeded()) {
-            createSnapshot(databaseName, tables);
-            operationCount_ = 0; // Reset counter after snapshot
-        }
-        
+        std::cout << "Database '" << databaseName << "' exported to " << filePath << std::endl;
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Error saving database: " << e.what() << std::endl;
+        std::cerr << "Error exporting database: " << e.what() << std::endl;
         return false;
     }
 }
 
-bool EnhancedPersistenceManager::loadDatabase(const std::string& databaseName,
-                                            std::unordered_map<std::string, TableData>& tables,
-                                            const std::string& filename) {
-    try {
+bool EnhancedPersistenceManager::appendTransactionLog(const std::string& databaseName,
+                                                     const std::string& operation,
+                                                     const std::unordered_map<std::string, std::string>& data) {
+    return appendTransactionLog(databaseName, "", operation, data);
+}
+
+bool EnhancedPersistenceManager::appendTransactionLog(const std::string& databaseName,
+                                                     const std::string& tableName,
+                                                     const std::string& operation,
+                                                     const std::unordered_map<std::string, std::string>& data,
+                                                     const std::unordered_map<std::string, std::string>& condition) {
+    return commitTransactionLog(enqueueTransactionLog(databaseName, tableName, operation, data, condition));
+}
+
+uint64_t EnhancedPersistenceManager::enqueueTransactionLog(const std::string& databaseName,
+                                                           const std::string& tableName,
+                                                           const std::string& operation,
+                                                           const std::unordered_map<std::string, std::string>& data,
+                                                           const std::unordered_map<std::string, std::string>& condition) {
+    TransactionLogRecord record;
+    record.operation = operation;
+    record.table = tableName;
+    record.data.assign(data.begin(), data.end());
+    record.condition.assign(condition.begin(), condition.end());
+    return enqueueTransactionLog(databaseName, record);
+}
+
+uint64_t EnhancedPersistenceManager::enqueueTransactionLog(const std::string& databaseName,
+                                                           const TransactionLogRecord& record) {
+    if (logFailed_.load() || logStopping_.load()) {
+        return 0;
+    }
+    
+    // Encode in the calling thread so the writer only copies bytes
+    storage::WALRecord walRecord = toWALRecord(record);
+    walRecord.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    PendingLogRecord pending;
+    pending.databaseName = databaseName;
+    pending.payload = walRecord.encode();
+    
+    std::shared_lock<std::shared_mutex> baseLock(lsnBaseMutex_);
+    size_t position;
+    while (!logQueue_.tryPush(std::move(pending), position)) {
+        // Queue is full: let the writer catch up
+        wakeLogWriter();
+        std::this_thread::yield();
+    }
+    
+    // Only the first record into an empty queue needs to wake the writer
+    if (logPending_.fetch_add(1) == 0) {
+        wakeLogWriter();
+    }
+    
+    // Records are written in queue order, so the queue position gives the LSN
+    uint64_t lsn = lsnBase_.load() + static_cast<uint64_t>(position) + 1;
+    uint64_t previous = lastQueuedLsn_.load(std::memory_order_relaxed);
+    while (previous < lsn && !lastQueuedLsn_.compare_exchange_weak(previous, lsn)) {
+    }
+    return lsn;
+}
+
+bool EnhancedPersistenceManager::commitTransactionLog(uint64_t lsn) {
+    if (lsn == 0) {
+        return false;
+    }
+    if (logSyncPolicy_.load(std::memory_order_relaxed) == LogSyncPolicy::PER_COMMIT) {
+        return waitForDurability(lsn);
+    }
+    return true;
+}
+
+bool EnhancedPersistenceManager::waitForDurability(uint64_t lsn) {
+    if (durableLsn_.load() >= lsn) {
+        return true;
+    }
+    
+    // Ask the writer to sync now instead of at the next interval
+    uint64_t requested = requestedSyncLsn_.load();
+    while (requested < lsn && !requestedSyncLsn_.compare_exchange_weak(requested, lsn)) {
+    }
+    wakeLogWriter();
+    
+    std::unique_lock<std::mutex> lock(durableMutex_);
+    durableCv_.wait(lock, [this, lsn]() {
+        return durableLsn_.load() >= lsn || logFailed_.load();
+    });
+    return durableLsn_.load() >= lsn;
+}
+
+bool EnhancedPersistenceManager::flushTransactionLog() {
+    uint64_t lsn = lastQueuedLsn_.load();
+    return lsn == 0 || waitForDurability(lsn);
+}
+
+std::vector<TransactionLogRecord> EnhancedPersistenceManager::readTransactionLog(const std::string& databaseName) {
+    std::vector<TransactionLogRecord> records;
+    replayTransactionLog(databaseName, [&records](const TransactionLogRecord& record) {
+        records.push_back(record);
+    });
+    return records;
+}
+
+bool EnhancedPersistenceManager::replayTransactionLog(const std::string& databaseName,
+                                                      const TransactionLogHandler& handler,
+                                                      uint64_t fromLsn) {
+    flushTransactionLog();
+    
+    // Going through the writer's own log truncates a torn tail on open and
+    // keeps the writer from appending while the file is read
+    std::lock_guard<std::mutex> filesLock(logFilesMutex_);
+    storage::WALManager* log = getLogFile(databaseName);
+    if (log == nullptr) {
+        return false;
+    }
+    return log->replay([&handler](const storage::WALRecord& record) {
+        handler(fromWALRecord(record));
+    }, fromLsn);
+}
+
+void EnhancedPersistenceManager::setLogSyncPolicy(LogSyncPolicy policy, size_t intervalMs) {
+    logSyncIntervalMs_.store(intervalMs);
+    logSyncPolicy_.store(policy);
+    wakeLogWriter();
+}
+
+LogSyncPolicy EnhancedPersistenceManager::getLogSyncPolicy() const {
+    return logSyncPolicy_.load();
+}
+
+storage::WALManager* EnhancedPersistenceManager::getLogFile(const std::string& databaseName) {
+    auto it = logFiles_.find(databaseName);
+    if (it != logFiles_.end()) {
+        return it->second.get();
+    }
+    
+    std::string logPath;
+    {
         std::lock_guard<std::mutex> lock(mutex_);
-        std::string filePath = getDatabaseFilePath(databaseName, filename);
-        
-        std::ifstream file(filePath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open file for reading: " << filePath << std::endl;
-            return false;
+        logPath = getTransactionLogPath(databaseName);
+    }
+    
+    auto log = std::make_unique<storage::WALManager>(logPath);
+    if (!log->open()) {
+        std::cerr << "Failed to open transaction log for appending: " << logPath << std::endl;
+        return nullptr;
+    }
+    return (logFiles_[databaseName] = std::move(log)).get();
+}
+
+bool EnhancedPersistenceManager::reserveLsns(uint64_t lsn) {
+    if (lsn <= reservedLsn_) {
+        return true;
+    }
+    
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path = getLsnReservationPath();
+    }
+    uint64_t reservation = lsn + LSN_RESERVATION_BLOCK;
+    std::string tempPath = path + ".tmp";
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Failed to write lsn reservation: " << tempPath << std::endl;
+        return false;
+    }
+    bool ok = std::fprintf(file, "%llu\n", static_cast<unsigned long long>(reservation)) > 0 &&
+              std::fflush(file) == 0 && utils::syncFile(file);
+    ok = std::fclose(file) == 0 && ok;
+    
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (!ok || ec) {
+        std::cerr << "Failed to write lsn reservation: " << path << std::endl;
+        return false;
+    }
+    reservedLsn_ = reservation;
+    return true;
+}
+
+uint64_t EnhancedPersistenceManager::readLsnReservation() const {
+    std::ifstream file(getLsnReservationPath());
+    unsigned long long reservation = 0;
+    if (file >> reservation) {
+        return reservation;
+    }
+    return 0;
+}
+
+void EnhancedPersistenceManager::closeLogFiles() {
+    // Sync before closing so records written after the last group commit
+    // are not left behind in the page cache
+    if (logSyncPolicy_.load() != LogSyncPolicy::NONE) {
+        for (auto& log : logFiles_) {
+            log.second->sync();
         }
+    }
+    logFiles_.clear();
+}
+
+void EnhancedPersistenceManager::wakeLogWriter() {
+    std::lock_guard<std::mutex> lock(logWriterMutex_);
+    logWriterWake_ = true;
+    logWriterCv_.notify_one();
+}
+
+void EnhancedPersistenceManager::logWriterLoop() {
+    uint64_t position = 0;
+    uint64_t writtenLsn = 0;
+    auto lastSync = std::chrono::steady_clock::now();
+    std::unordered_set<std::string> unsyncedDatabases;
+    std::vector<PendingLogRecord> batch;
+    
+    while (true) {
+        // Drain whatever producers have published so far
+        batch.clear();
+        PendingLogRecord record;
+        while (batch.size() < LOG_MAX_BATCH && logQueue_.tryPop(record)) {
+            batch.push_back(std::move(record));
+        }
+        logPending_.fetch_sub(static_cast<int64_t>(batch.size()));
         
-        std::string line;
-        std::string currentTable;
-        
-        // Clear existing data
-        tables.clear();
-        
-        while (std::getline(file, line)) {
-            // Skip empty lines and comments
-            if (line.empty() || line[0] == '#') {
-                continue;
+        if (!batch.empty()) {
+            std::lock_guard<std::mutex> filesLock(logFilesMutex_);
+            uint64_t firstLsn = lsnBase_.load() + position + 1;
+            if (!reserveLsns(firstLsn + batch.size() - 1)) {
+                logFailed_.store(true);
             }
             
-            // Check for table header
-            if (line.substr(0, 7) == "[TABLE:") {
-                currentTable = line.substr(7, line.length() - 8); // Remove [TABLE: and ]
-                tables[currentTable] = TableData();
-                continue;
+            std::unordered_map<std::string, storage::WALManager*> touchedLogs;
+            for (const auto& pending : batch) {
+                uint64_t lsn = lsnBase_.load() + position++ + 1;
+                storage::WALManager* log = getLogFile(pending.databaseName);
+                if (log == nullptr || !log->append(lsn, pending.payload)) {
+                    logFailed_.store(true);
+                    continue;
+                }
+                touchedLogs[pending.databaseName] = log;
             }
             
-            // Check for columns
-            if (line.substr(0, 8) == "COLUMNS:" && !currentTable.empty()) {
-                std::string columnsStr = line.substr(8);
-                std::stringstream ss(columnsStr);
-                std::string columnPair;
-                
-                while (std::getline(ss, columnPair, ',')) {
-                    size_t colonPos = columnPair.find(':');
-                    if (colonPos != std::string::npos) {
-                        std::string columnName = columnPair.substr(0, colonPos);
-                        std::string columnType = columnPair.substr(colonPos + 1);
-                        tables[currentTable].columns.emplace_back(columnName, columnType);
-                    }
+            // One write() per file per batch
+            for (const auto& touched : touchedLogs) {
+                if (!touched.second->flush()) {
+                    logFailed_.store(true);
                 }
-                continue;
+                unsyncedDatabases.insert(touched.first);
             }
+            writtenLsn = lsnBase_.load() + position;
+        }
+        
+        // Group commit: a single fsync covers every record written so far
+        LogSyncPolicy policy = logSyncPolicy_.load();
+        auto now = std::chrono::steady_clock::now();
+        auto interval = std::chrono::milliseconds(logSyncIntervalMs_.load());
+        bool pendingDurability = writtenLsn > durableLsn_.load();
+        
+        if (pendingDurability) {
+            bool syncNow = policy == LogSyncPolicy::PER_COMMIT ||
+                           requestedSyncLsn_.load() > durableLsn_.load() ||
+                           (policy == LogSyncPolicy::INTERVAL && now - lastSync >= interval) ||
+                           logStopping_.load();
             
-            // Check for data header
-            if (line.substr(0, 5) == "DATA:" && !currentTable.empty()) {
-                // We don't need to process the header line, just continue
-                continue;
+            if (policy == LogSyncPolicy::NONE) {
+                unsyncedDatabases.clear();
+                syncNow = true;
+            } else if (syncNow) {
+                std::lock_guard<std::mutex> filesLock(logFilesMutex_);
+                for (const auto& databaseName : unsyncedDatabases) {
+                    // Files closed by setDataDirectory were synced on close
+                    auto it = logFiles_.find(databaseName);
+                    if (it != logFiles_.end() && !it->second->sync()) {
+                        std::cerr << "Failed to sync transaction log for database '" << databaseName << "'" << std::endl;
+                        logFailed_.store(true);
+                    }
+                }
+                unsyncedDatabases.clear();
+                lastSync = now;
             }
             
-            // Check for data rows
-            if (line.substr(0, 4) == "ROW:" && !currentTable.empty()) {
-                std::string rowStr = line.substr(4);
-                std::stringstream ss(rowStr);
-                std::string cell;
-                std::vector<std::string> cells;
-                
-                while (std::getline(ss, cell, ',')) {
-                    cells.push_back(unescapeCSV(cell));
-                }
-                
-                // Create row map
-                std::unordered_map<std::string, std::string> row;
-                const auto& columnDefinitions = tables[currentTable].columns;
-                
-                for (size_t i = 0; i < std::min(cells.size(), columnDefinitions.size()); ++i) {
-                    row[columnDefinitions[i].first] = cells[i];
-                }
-                
-                tables[currentTable].rows.push_back(row);
-                continue;
+            if (syncNow) {
+                std::lock_guard<std::mutex> lock(durableMutex_);
+                durableLsn_.store(writtenLsn);
+                durableCv_.notify_all();
             }
         }
         
-        file.close();
-        std::cout << "Database '" << databaseName << "' loaded from " << filePath << std::endl;
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error loading database: " << e.what() << std::endl;
-        return false;
+        if (logFailed_.load()) {
+            std::lock_guard<std::mutex> lock(durableMutex_);
+            durableCv_.notify_all();
+        }
+        
+        if (batch.empty()) {
+            if (logStopping_.load() && writtenLsn == durableLsn_.load()) {
+                break;
+            }
+            
+            // Sleep until there is work, or until the interval sync of
+            // records already written is due
+            auto hasWork = [this]() {
+                return logWriterWake_ || logPending_.load() > 0;
+            };
+            std::unique_lock<std::mutex> lock(logWriterMutex_);
+            if (writtenLsn > durableLsn_.load() && policy == LogSyncPolicy::INTERVAL) {
+                logWriterCv_.wait_until(lock, lastSync + interval, hasWork);
+            } else {
+                logWriterCv_.wait(lock, hasWork);
+            }
+            logWriterWake_ = false;
+        }
     }
 }
 
-bool EnhancedPersistenceManager::appendTransactionLog(const std::string& databaseName,
-                                                     const std::string& operation,
-                                                     const std::unordered_map<std::string, std::string>& data) {
+bool EnhancedPersistenceManager::createSnapshot(const std::string& databaseName,
+                                              const std::unordered_map<std::string, TableData>& tables) {
     try {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::string logPath = getTransactionLogPath(databaseName);
-        
-        // Create directory structure if needed
-        std::filesystem::path pathObj(logPath);
-        std::filesystem::create_directories(pathObj.parent_path());
-        
-        // Open file in append mode
-        std::ofstream file(logPath, std::ios::app);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open transaction log for appending: " << logPath << std::endl;
-            return false;
+        std::string snapshotPath;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!snapshotEnabled_) {
+                return true; // Not an error, just not enabled
+            }
+            snapshotPath = getSnapshotPath(databaseName);
         }
         
-        // Write timestamp
+        // Create timestamped snapshot file
         auto now = std::chrono::system_clock::now();
         auto time_t = std::chrono::system_clock::to_time_t(now);
-        file << "[" << std::put_time(std::gmtime(&time_t), "%Y-%m-%d %H:%M:%S UTC") << "] ";
+        std::stringstream timestamp;
+        timestamp << std::put_time(std::gmtime(&time_t), "%Y%m%d_%H%M%S");
         
-        // Write operation
-        file << operation << " ";
+        std::string timestampedSnapshotPath = snapshotPath + "_" + timestamp.str();
         
-        // Write data
-        file << "{";
-        bool first = true;
-        for (const auto& pair : data) {
-            if (!first) file << ", ";
-            file << pair.first << ": " << escapeCSV(pair.second);
-            first = false;
+        if (!BinarySnapshotWriter::write(timestampedSnapshotPath, databaseName, tables)) {
+            std::cerr << "Failed to create snapshot file: " << timestampedSnapshotPath << std::endl;
+            return false;
         }
-        file << "}\n";
         
-        file.close();
+        std::cout << "Snapshot created for database '" << databaseName << "' at " << timestampedSnapshotPath << std::endl;
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Error appending to transaction log: " << e.what() << std::endl;
+        std::cerr << "Error creating snapshot: " << e.what() << std::endl;
         return false;
     }
 }
 
-bool EnhancedPersistenceManager::createSnapshot(const std::string& databaseName,
-                                              const std::unordered_map<std::string, TableData>& tables) {
-    if (!snapshotEnabled_) {
-        return true; // Not an error, just not enabled
-    }
-    
+bool EnhancedPersistenceManager::writeCheckpoint(const std::string& databaseName,
+                                                uint64_t lsn,
+                                                const std::unordered_map<std::string, CheckpointTable>& tables,
+                                                size_t* segmentsWritten) {
     try {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::string snapshotPath = getSnapshotPath(databaseName);
+        std::lock_guard<std::mutex> checkpointLock(checkpointMutex_);
+        std::string directory;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            directory = getCheckpointDirectory(databaseName);
+        }
+        std::filesystem::create_directories(directory);
         
-        // Create directory structure if needed
-        std::filesystem::path pathObj(snapshotPath);
-        std::filesystem::create_directories(pathObj.parent_path());
+        // Find out what the previous checkpoint already holds
+        auto& previous = checkpointManifests_[databaseName];
+        if (!previous.loaded) {
+            readCheckpointManifest(databaseName, previous, nullptr);
+            previous.loaded = true;
+        }
         
-        // Create timestamped snapshot file
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        std::stringstream timestamp;
-        timestamp << std::put_time(std::gmtime(&time_t), "%Y%m%d_%H%M%S");
+        CheckpointManifest next;
+        next.loaded = true;
+        next.sequence = previous.sequence + 1;
+        next.lsn = lsn;
+        std::string chunkFile = CHECKPOINT_CHUNK_PREFIX + std::to_string(next.sequence) + ".db";
         
-        std::string timestampedSnapshotPath = snapshotPath + "_" + timestamp.str();
+        // The manifest is itself a small snapshot file with four tables
+        std::unordered_map<std::string, TableData> manifestTables;
+        manifestTables["info"].rows.push_back({
+            {"sequence", std::to_string(next.sequence)},
+            {"lsn", std::to_string(lsn)}
+        });
+        auto& tableRows = manifestTables["tables"].rows;
+        auto& columnRows = manifestTables["columns"].rows;
+        auto& segmentRows = manifestTables["segments"].rows;
         
-        std::ofstream file(timestampedSnapshotPath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to create snapshot file: " << timestampedSnapshotPath << std::endl;
-            return false;
+        std::vector<std::string> tableNames;
+        for (const auto& tablePair : tables) {
+            tableNames.push_back(tablePair.first);
         }
+        std::sort(tableNames.begin(), tableNames.end());
         
-        // Write snapshot header
-        file << "# PhantomDB Database Snapshot\n";
-        file << "# Database: " << databaseName << "\n";
-        file << "# Format: CSV\n";
-        file << "# Timestamp: " << std::put_time(std::gmtime(&time_t), "%Y-%m-%d %H:%M:%S UTC") << "\n";
-        file << "# Type: Snapshot\n\n";
-        
-        // Write each table (similar to saveDatabase)
-        for (const auto& tablePair : tables) {
-            const std::string& tableName = tablePair.first;
-            const auto& tableData = tablePair.second;
-            const auto& columnDefinitions = tableData.columns;
-            const auto& rowData = tableData.rows;
-            
-            // Write table header
-            file << "[TABLE:" << tableName << "]\n";
-            
-            // Write column definitions
-            file << "COLUMNS:";
-            for (size_t i = 0; i < columnDefinitions.size(); ++i) {
-                if (i > 0) file << ",";
-                file << columnDefinitions[i].first << ":" << columnDefinitions[i].second;
+        BinarySnapshotWriter chunkWriter;
+        size_t written = 0;
+        for (const auto& tableName : tableNames) {
+            const auto& table = tables.at(tableName);
+            std::string generation = std::to_string(table.generation);
+            tableRows.push_back({
+                {"table", tableName},
+                {"generation", generation},
+                {"lsn", std::to_string(table.lsn)}
+            });
+            for (const auto& column : table.columns) {
+                columnRows.push_back({{"table", tableName}, {"name", column.first}, {"type", column.second}});
             }
-            file << "\n";
             
-            // Write row data
-            if (!rowData.empty()) {
-                // Write header row
-                file << "DATA:";
-                bool firstCol = true;
-                for (const auto& column : columnDefinitions) {
-                    if (!firstCol) file << ",";
-                    file << column.first;
-                    firstCol = false;
+            for (const auto& segment : table.segments) {
+                std::string key = checkpointKey(tableName, table.generation, segment.id);
+                auto it = previous.segments.find(key);
+                CheckpointManifest::Location location;
+                if (it != previous.segments.end() && it->second.version == segment.version) {
+                    location = it->second; // Unchanged since the last checkpoint
+                } else {
+                    if (written == 0 && !chunkWriter.open(directory + "/" + chunkFile, databaseName)) {
+                        return false;
+                    }
+                    location = {segment.version, chunkFile, "s" + std::to_string(written)};
+                    if (!chunkWriter.addTable(location.block, segment.materialize())) {
+                        return false;
+                    }
+                    written++;
                 }
-                file << "\n";
                 
-                // Write data rows
-                for (const auto& row : rowData) {
-                    file << "ROW:";
-                    firstCol = true;
-                    for (const auto& column : columnDefinitions) {
-                        if (!firstCol) file << ",";
-                        auto it = row.find(column.first);
-                        if (it != row.end()) {
-                            file << escapeCSV(it->second);
-                        }
-                        firstCol = false;
+                segmentRows.push_back({
+                    {"table", tableName},
+                    {"id", std::to_string(segment.id)},
+                    {"version", std::to_string(location.version)},
+                    {"file", location.file},
+                    {"block", location.block}
+                });
+                next.segments[key] = std::move(location);
+            }
+        }
+        
+        if (written > 0 && !chunkWriter.commit()) {
+            return false;
+        }
+        if (!BinarySnapshotWriter::write(directory + "/" + CHECKPOINT_MANIFEST, databaseName, manifestTables)) {
+            return false;
+        }
+        
+        // The new manifest is durable; chunk files it no longer references can go
+        std::unordered_set<std::string> referenced;
+        for (const auto& segment : next.segments) {
+            referenced.insert(segment.second.file);
+        }
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind(CHECKPOINT_CHUNK_PREFIX, 0) == 0 && referenced.count(name) == 0) {
+                std::error_code ec;
+                std::filesystem::remove(entry.path(), ec);
+            }
+        }
+        
+        // Log segments holding only records the checkpoint covers can be reused
+        uint64_t coveredLsn = lsn;
+        for (const auto& tablePair : tables) {
+            coveredLsn = std::min(coveredLsn, tablePair.second.lsn);
+        }
+        {
+            std::lock_guard<std::mutex> filesLock(logFilesMutex_);
+            storage::WALManager* log = getLogFile(databaseName);
+            if (log != nullptr) {
+                log->recycleSegments(coveredLsn);
+            }
+        }
+        
+        previous = std::move(next);
+        if (segmentsWritten != nullptr) {
+            *segmentsWritten = written;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error writing checkpoint: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool EnhancedPersistenceManager::loadCheckpoint(const std::string& databaseName,
+                                               std::unordered_map<std::string, CheckpointTableData>& tables,
+                                               uint64_t* lsn) {
+    try {
+        std::lock_guard<std::mutex> checkpointLock(checkpointMutex_);
+        tables.clear();
+        
+        CheckpointManifest manifest;
+        if (!readCheckpointManifest(databaseName, manifest, &tables)) {
+            return false;
+        }
+        
+        // Map every chunk file once, then decode the chunks in parallel
+        std::string directory;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            directory = getCheckpointDirectory(databaseName);
+        }
+        std::unordered_map<std::string, std::unique_ptr<BinarySnapshotReader>> readers;
+        struct Job {
+            const BinarySnapshotReader* reader;
+            std::string block;
+            TableData* target;
+        };
+        std::vector<Job> jobs;
+        for (auto& tablePair : tables) {
+            for (auto& segment : tablePair.second.segments) {
+                const auto& location = manifest.segments.at(
+                    checkpointKey(tablePair.first, tablePair.second.generation, segment.id));
+                auto& reader = readers[location.file];
+                if (!reader) {
+                    reader = std::make_unique<BinarySnapshotReader>();
+                    if (!reader->open(directory + "/" + location.file)) {
+                        std::cerr << "Missing checkpoint chunk file: " << location.file << std::endl;
+                        return false;
                     }
-                    file << "\n";
                 }
+                jobs.push_back({reader.get(), location.block, &segment.data});
             }
-            
-            file << "\n";
         }
         
-        file.close();
-        std::cout << "Snapshot created for database '" << databaseName << "' at " << timestampedSnapshotPath << std::endl;
+        std::atomic<size_t> nextJob(0);
+        std::atomic<bool> ok(true);
+        auto worker = [&]() {
+            size_t i;
+            while (ok.load() && (i = nextJob.fetch_add(1)) < jobs.size()) {
+                if (!jobs[i].reader->loadTable(jobs[i].block, *jobs[i].target)) {
+                    ok.store(false);
+                }
+            }
+        };
+        size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), jobs.size());
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < threadCount; ++t) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : workers) {
+            thread.join();
+        }
+        if (!ok.load()) {
+            tables.clear();
+            return false;
+        }
+        
+        if (lsn != nullptr) {
+            *lsn = manifest.lsn;
+        }
+        
+        // Continue incrementally from what was just loaded
+        manifest.loaded = true;
+        checkpointManifests_[databaseName] = std::move(manifest);
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Error creating snapshot: " << e.what() << std::endl;
+        std::cerr << "Error loading checkpoint: " << e.what() << std::endl;
         return false;
     }
 }
 
+bool EnhancedPersistenceManager::readCheckpointManifest(const std::string& databaseName,
+                                                       CheckpointManifest& manifest,
+                                                       std::unordered_map<std::string, CheckpointTableData>* tables) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path = getCheckpointDirectory(databaseName) + "/" + CHECKPOINT_MANIFEST;
+    }
+    if (!std::filesystem::exists(path)) {
+        return false;
+    }
+    
+    BinarySnapshotReader reader;
+    TableData info, tableList, columns, segments;
+    if (!reader.open(path) || !reader.loadTable("info", info) || !reader.loadTable("tables", tableList) ||
+        !reader.loadTable("columns", columns) || !reader.loadTable("segments", segments) ||
+        info.rows.empty()) {
+        std::cerr << "Corrupt checkpoint manifest: " << path << std::endl;
+        return false;
+    }
+    
+    // Manifests written before log sequence numbers were tracked have none
+    auto optionalNumber = [](const std::unordered_map<std::string, std::string>& row, const char* key) {
+        auto it = row.find(key);
+        return it == row.end() ? 0 : std::stoull(it->second);
+    };
+    
+    manifest.sequence = std::stoull(info.rows[0].at("sequence"));
+    manifest.lsn = optionalNumber(info.rows[0], "lsn");
+    std::unordered_map<std::string, uint64_t> generations;
+    for (const auto& row : tableList.rows) {
+        uint64_t generation = std::stoull(row.at("generation"));
+        generations[row.at("table")] = generation;
+        if (tables != nullptr) {
+            (*tables)[row.at("table")].generation = generation;
+            (*tables)[row.at("table")].lsn = optionalNumber(row, "lsn");
+        }
+    }
+    if (tables != nullptr) {
+        for (const auto& row : columns.rows) {
+            (*tables)[row.at("table")].columns.emplace_back(row.at("name"), row.at("type"));
+        }
+    }
+    for (const auto& row : segments.rows) {
+        const std::string& tableName = row.at("table");
+        uint64_t id = std::stoull(row.at("id"));
+        uint64_t version = std::stoull(row.at("version"));
+        manifest.segments[checkpointKey(tableName, generations[tableName], id)] = {
+            version, row.at("file"), row.at("block")
+        };
+        if (tables != nullptr) {
+            (*tables)[tableName].segments.push_back({id, version, TableData()});
+        }
+    }
+    return true;
+}
+
 void EnhancedPersistenceManager::setSnapshotEnabled(bool enabled) {
     std::lock_guard<std::mutex> lock(mutex_);
     snapshotEnabled_ = enabled;
@@ -377,10 +937,18 @@ std::string EnhancedPersistenceManager::getTransactionLogPath(const std::string&
     return dataDirectory_ + "/" + databaseName + ".log";
 }
 
+std::string EnhancedPersistenceManager::getLsnReservationPath() const {
+    return dataDirectory_ + "/" + LSN_RESERVATION_FILE;
+}
+
 std::string EnhancedPersistenceManager::getSnapshotPath(const std::string& databaseName) const {
     return dataDirectory_ + "/" + databaseName + "_snapshot";
 }
 
+std::string EnhancedPersistenceManager::getCheckpointDirectory(const std::string& databaseName) const {
+    return dataDirectory_ + "/" + databaseName + "_checkpoint";
+}
+
 std::string EnhancedPersistenceManager::escapeCSV(const std::string& str) const {
     // If string contains commas, quotes, or newlines, wrap in quotes and escape quotes
     if (str.find_first_of(",\"\n") != std::string::npos) {
@@ -396,20 +964,6 @@ std::string EnhancedPersistenceManager::escapeCSV(const std::string& str) const
     return str;
 }
 
-std::string EnhancedPersistenceManager::unescapeCSV(const std::string& str) const {
-    if (str.length() >= 2 && str.front() == '"' && str.back() == '"') {
-        std::string unescaped = str.substr(1, str.length() - 2);
-        // Replace all double quotes with single quotes
-        size_t pos = 0;
-        while ((pos = unescaped.find("\"\"", pos)) != std::string::npos) {
-            unescaped.replace(pos, 2, "\"");
-            pos += 1;
-        }
-        return unescaped;
-    }
-    return str;
-}
-
 bool EnhancedPersistenceManager::isSnapshotNeeded() const {
     return snapshotEnabled_ && operationCount_ >= snapshotInterval_;
 }
@@ -7,8 +7,20 @@
 #include <fstream>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include "mpsc_ring_buffer.h"
 
 namespace phantomdb {
+namespace storage {
+class WALManager;
+}
+
 namespace core {
 
 // Forward declaration
@@ -17,13 +29,69 @@ struct TableData {
     std::vector<std::unordered_map<std::string, std::string>> rows;
 };
 
+// Receives one decoded table; may be called concurrently from loader threads
+using TableLoadCallback = std::function<void(const std::string&, TableData&&)>;
+
+// One row chunk of a table handed to an incremental checkpoint
+struct CheckpointSegment {
+    uint64_t id;
+    uint64_t version;
+    std::function<TableData()> materialize;  // Only called if the chunk changed since the last checkpoint
+};
+
+// A table as captured for an incremental checkpoint
+struct CheckpointTable {
+    uint64_t generation;
+    std::vector<std::pair<std::string, std::string>> columns;
+    std::vector<CheckpointSegment> segments;
+    uint64_t lsn = 0;  // Last log record applied to the table before the capture
+};
+
+// A row chunk read back from a checkpoint
+struct CheckpointSegmentData {
+    uint64_t id;
+    uint64_t version;
+    TableData data;
+};
+
+// A table read back from a checkpoint, chunk by chunk
+struct CheckpointTableData {
+    uint64_t generation;
+    std::vector<std::pair<std::string, std::string>> columns;
+    std::vector<CheckpointSegmentData> segments;
+    uint64_t lsn = 0;
+};
+
+// Durability policy for the asynchronous transaction log
+enum class LogSyncPolicy {
+    PER_COMMIT,  // Each append waits until its record is fsynced (concurrent appends share one fsync)
+    INTERVAL,    // The log writer fsyncs every N milliseconds; appends return immediately
+    NONE         // Records are written to the OS but never explicitly fsynced
+};
+
+// A transaction log record; stored as a typed storage::WALRecord
+struct TransactionLogRecord {
+    uint64_t lsn = 0;        // Log sequence number, increasing across restarts
+    int64_t timestamp = 0;   // Microseconds since the Unix epoch
+    std::string operation;   // CREATE_TABLE, INSERT, ... or any custom name
+    std::string table;
+    std::vector<std::pair<std::string, std::string>> columns;  // CREATE_TABLE schema, in order
+    std::vector<std::pair<std::string, std::string>> data;
+    std::vector<std::pair<std::string, std::string>> condition;
+};
+
+// Receives replayed transaction log records in log order
+using TransactionLogHandler = std::function<void(const TransactionLogRecord&)>;
+
 class EnhancedPersistenceManager {
 public:
     EnhancedPersistenceManager();
-    ~EnhancedPersistenceManager() = default;
+    ~EnhancedPersistenceManager();
     
     /**
-     * @brief Save database to file with snapshot functionality
+     * @brief Save database to a binary snapshot file
+     * 
+     * The file is written to a temporary name, fsynced and renamed into place.
      * 
      * @param databaseName The name of the database to save
      * @param tables The table data to save
@@ -35,7 +103,9 @@ public:
                      const std::string& filename = "");
     
     /**
-     * @brief Load database from file
+     * @brief Load database from a binary snapshot file
+     * 
+     * The file is memory-mapped and its tables are decoded in parallel.
      * 
      * @param databaseName The name of the database to load
      * @param tables The table data to load into
@@ -46,6 +116,32 @@ public:
                      std::unordered_map<std::string, TableData>& tables,
                      const std::string& filename = "");
     
+    /**
+     * @brief Load database from a binary snapshot file, table by table
+     * 
+     * @param databaseName The name of the database to load
+     * @param onTable Called from the loader threads once per decoded table
+     * @param filename The file to load from (optional, defaults to database name)
+     * @return true if successful, false otherwise
+     */
+    bool loadDatabase(const std::string& databaseName,
+                     const TableLoadCallback& onTable,
+                     const std::string& filename = "");
+    
+    /**
+     * @brief Export database as a human-readable CSV file
+     * 
+     * CSV is an export format only; loadDatabase reads binary snapshots.
+     * 
+     * @param databaseName The name of the database to export
+     * @param tables The table data to export
+     * @param filename The file to write (optional, defaults to <database>.csv)
+     * @return true if successful, false otherwise
+     */
+    bool exportDatabaseCSV(const std::string& databaseName,
+                          const std::unordered_map<std::string, TableData>& tables,
+                          const std::string& filename = "");
+    
     /**
      * @brief Append transaction log entry
      * 
@@ -59,7 +155,116 @@ public:
                              const std::unordered_map<std::string, std::string>& data);
     
     /**
-     * @brief Create a snapshot of the database
+     * @brief Append a table-level transaction log entry
+     * 
+     * The record is encoded in the calling thread and handed to the log
+     * writer thread through a lock-free queue. Under LogSyncPolicy::PER_COMMIT
+     * this waits until the record is durable; otherwise it returns at once.
+     * 
+     * @param databaseName The name of the database
+     * @param tableName The table the operation applies to
+     * @param operation The operation to log
+     * @param data The values written by the operation
+     * @param condition The row filter of the operation
+     * @return true if successful, false otherwise
+     */
+    bool appendTransactionLog(const std::string& databaseName,
+                             const std::string& tableName,
+                             const std::string& operation,
+                             const std::unordered_map<std::string, std::string>& data,
+                             const std::unordered_map<std::string, std::string>& condition = {});
+    
+    /**
+     * @brief Queue a transaction log entry without waiting for durability
+     * 
+     * @return The log sequence number assigned to the record, or 0 on failure
+     */
+    uint64_t enqueueTransactionLog(const std::string& databaseName,
+                                   const std::string& tableName,
+                                   const std::string& operation,
+                                   const std::unordered_map<std::string, std::string>& data,
+                                   const std::unordered_map<std::string, std::string>& condition = {});
+    
+    /**
+     * @brief Queue a transaction log record without waiting for durability
+     * 
+     * The lsn and timestamp of the record are assigned here. Callers that
+     * need log order to match apply order enqueue while holding the lock
+     * that serializes the change, and wait for the commit after releasing it.
+     * 
+     * @param databaseName The name of the database
+     * @param record The record to log
+     * @return The log sequence number assigned to the record, or 0 on failure
+     */
+    uint64_t enqueueTransactionLog(const std::string& databaseName, const TransactionLogRecord& record);
+    
+    /**
+     * @brief Wait for a queued record as the sync policy requires
+     * 
+     * Waits for durability under LogSyncPolicy::PER_COMMIT and returns at
+     * once otherwise.
+     * 
+     * @param lsn The log sequence number returned by enqueueTransactionLog
+     * @return true if successful, false if the log writer failed
+     */
+    bool commitTransactionLog(uint64_t lsn);
+    
+    /**
+     * @brief Block until every record up to the given sequence number is durable
+     * 
+     * @param lsn The log sequence number to wait for
+     * @return true if the records are durable, false if the log writer failed
+     */
+    bool waitForDurability(uint64_t lsn);
+    
+    /**
+     * @brief Block until every record queued so far is durable
+     * 
+     * @return true if successful, false if the log writer failed
+     */
+    bool flushTransactionLog();
+    
+    /**
+     * @brief Read back every intact record of a database's transaction log
+     * 
+     * Reading stops at the first truncated or corrupt record.
+     * 
+     * @param databaseName The name of the database
+     * @return The decoded records in log order
+     */
+    std::vector<TransactionLogRecord> readTransactionLog(const std::string& databaseName);
+    
+    /**
+     * @brief Replay a database's transaction log
+     * 
+     * Queued records are flushed first. A torn or corrupt tail left by a
+     * crash is truncated before reading, and replay ends at the last intact
+     * record.
+     * 
+     * @param databaseName The name of the database
+     * @param handler Called for each record, in log order
+     * @param fromLsn Records up to and including this lsn are skipped
+     * @return false if the log could not be read
+     */
+    bool replayTransactionLog(const std::string& databaseName,
+                              const TransactionLogHandler& handler,
+                              uint64_t fromLsn = 0);
+    
+    /**
+     * @brief Set the durability policy of the transaction log
+     * 
+     * @param policy When records are fsynced
+     * @param intervalMs The fsync interval for LogSyncPolicy::INTERVAL
+     */
+    void setLogSyncPolicy(LogSyncPolicy policy, size_t intervalMs = 10);
+    
+    /**
+     * @brief Get the durability policy of the transaction log
+     */
+    LogSyncPolicy getLogSyncPolicy() const;
+    
+    /**
+     * @brief Create a timestamped binary snapshot of the database
      * 
      * @param databaseName The name of the database to snapshot
      * @param tables The table data to snapshot
@@ -68,6 +273,38 @@ public:
     bool createSnapshot(const std::string& databaseName,
                        const std::unordered_map<std::string, TableData>& tables);
     
+    /**
+     * @brief Write an incremental checkpoint of a database
+     * 
+     * Chunks whose (generation, id, version) already exist in the previous
+     * checkpoint are referenced, not rewritten; only changed chunks are
+     * materialized and appended to a new chunk file. The manifest is
+     * replaced atomically and unreferenced chunk files are removed, as are
+     * transaction log segments holding only records the checkpoint covers.
+     * 
+     * @param databaseName The name of the database
+     * @param lsn Last catalog-level (DDL) log record included in the capture
+     * @param tables The captured tables
+     * @param segmentsWritten Receives the number of chunks written (optional)
+     * @return true if successful, false otherwise
+     */
+    bool writeCheckpoint(const std::string& databaseName,
+                         uint64_t lsn,
+                         const std::unordered_map<std::string, CheckpointTable>& tables,
+                         size_t* segmentsWritten = nullptr);
+    
+    /**
+     * @brief Load the latest checkpoint of a database
+     * 
+     * @param databaseName The name of the database
+     * @param tables Receives the checkpointed tables
+     * @param lsn Receives the catalog-level lsn of the checkpoint (optional)
+     * @return false if there is no checkpoint or it is corrupt
+     */
+    bool loadCheckpoint(const std::string& databaseName,
+                        std::unordered_map<std::string, CheckpointTableData>& tables,
+                        uint64_t* lsn = nullptr);
+    
     /**
      * @brief Set the data directory for persistence
      * 
@@ -111,12 +348,101 @@ public:
     size_t getSnapshotInterval() const;
 
 private:
+    // An encoded record waiting for the log writer thread
+    struct PendingLogRecord {
+        std::string databaseName;
+        std::string payload;
+    };
+    
     std::string dataDirectory_;
     bool snapshotEnabled_;
     size_t snapshotInterval_;
     size_t operationCount_;
     mutable std::mutex mutex_;
     
+    // Asynchronous transaction log pipeline
+    MPSCRingBuffer<PendingLogRecord> logQueue_;
+    std::thread logWriter_;
+    std::atomic<bool> logStopping_;
+    std::atomic<bool> logFailed_;
+    std::atomic<LogSyncPolicy> logSyncPolicy_;
+    std::atomic<size_t> logSyncIntervalMs_;
+    std::atomic<uint64_t> lastQueuedLsn_;
+    std::atomic<uint64_t> durableLsn_;
+    std::atomic<uint64_t> requestedSyncLsn_;
+    
+    // LSNs are lsnBase_ + queue position + 1. Before writing a record the
+    // writer makes sure its lsn is covered by the reservation persisted in
+    // the data directory; a restarted manager starts above that reservation,
+    // so sequence numbers keep increasing across restarts. Producers hold
+    // lsnBaseMutex_ shared from claiming a position until they have read
+    // the base; setDataDirectory holds it exclusively while it drains the
+    // queue and moves the base.
+    std::atomic<uint64_t> lsnBase_;
+    uint64_t reservedLsn_;  // Guarded by logFilesMutex_
+    std::shared_mutex lsnBaseMutex_;
+    
+    // The writer sleeps until a record arrives in an empty queue, someone
+    // wakes it, or the next interval sync is due
+    std::atomic<int64_t> logPending_;  // Records pushed but not yet popped
+    bool logWriterWake_;  // Guarded by logWriterMutex_
+    std::mutex logWriterMutex_;
+    std::condition_variable logWriterCv_;
+    std::mutex durableMutex_;
+    std::condition_variable durableCv_;
+    
+    // Where each checkpointed chunk currently lives
+    struct CheckpointManifest {
+        struct Location {
+            uint64_t version;
+            std::string file;
+            std::string block;
+        };
+        
+        bool loaded = false;
+        uint64_t sequence = 0;
+        uint64_t lsn = 0;
+        std::unordered_map<std::string, Location> segments;  // Keyed by table, generation and chunk id
+    };
+    
+    // Serializes checkpoints; caches the last manifest of each database
+    std::mutex checkpointMutex_;
+    std::unordered_map<std::string, CheckpointManifest> checkpointManifests_;
+    
+    // Open logs, owned by the log writer thread
+    std::mutex logFilesMutex_;
+    std::unordered_map<std::string, std::unique_ptr<storage::WALManager>> logFiles_;
+    
+    /**
+     * @brief Main loop of the log writer thread: drain, write, group-commit
+     */
+    void logWriterLoop();
+    
+    /**
+     * @brief Wake the log writer (sync request, policy change or shutdown)
+     */
+    void wakeLogWriter();
+    
+    /**
+     * @brief Get (opening if needed) the log of a database (caller holds logFilesMutex_)
+     */
+    storage::WALManager* getLogFile(const std::string& databaseName);
+    
+    /**
+     * @brief Persist an lsn reservation covering at least the given lsn (caller holds logFilesMutex_)
+     */
+    bool reserveLsns(uint64_t lsn);
+    
+    /**
+     * @brief Read the lsn reservation of the data directory (caller holds mutex_)
+     */
+    uint64_t readLsnReservation() const;
+    
+    /**
+     * @brief Sync and close every open log file (caller holds logFilesMutex_)
+     */
+    void closeLogFiles();
+    
     /**
      * @brief Get the full path for a database file
      */
@@ -127,20 +453,32 @@ private:
      */
     std::string getTransactionLogPath(const std::string& databaseName) const;
     
+    /**
+     * @brief Get the full path for the lsn reservation file
+     */
+    std::string getLsnReservationPath() const;
+    
     /**
      * @brief Get the full path for a snapshot file
      */
     std::string getSnapshotPath(const std::string& databaseName) const;
     
     /**
-     * @brief Escape special characters in a string for CSV
+     * @brief Get the directory holding a database's checkpoint files
      */
-    std::string escapeCSV(const std::string& str) const;
+    std::string getCheckpointDirectory(const std::string& databaseName) const;
+    
+    /**
+     * @brief Read a checkpoint manifest, optionally with the table layouts it lists
+     */
+    bool readCheckpointManifest(const std::string& databaseName,
+                                CheckpointManifest& manifest,
+                                std::unordered_map<std::string, CheckpointTableData>* tables);
     
     /**
-     * @brief Unescape special characters from CSV
+     * @brief Escape special characters in a string for CSV
      */
-    std::string unescapeCSV(const std::string& str) const;
+    std::string escapeCSV(const std::string& str) const;
     
     /**
      * @brief Check if a snapshot is needed based on operation count
@@ -0,0 +1,136 @@
+#ifndef PHANTOMDB_MPSC_RING_BUFFER_H
+#define PHANTOMDB_MPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <utility>
+
+namespace phantomdb {
+namespace core {
+
+/**
+ * @brief Bounded lock-free multi-producer / single-consumer ring buffer
+ * 
+ * Every slot carries a sequence number. A producer claims a position with a
+ * single CAS on the enqueue counter, fills the slot and then publishes it by
+ * advancing the slot's sequence; the consumer only reads slots whose sequence
+ * says they are published. Positions are handed out in a total order, so the
+ * consumer sees items in exactly the order producers claimed them.
+ */
+template<typename T>
+class MPSCRingBuffer {
+public:
+    // Capacity is rounded up to a power of two
+    explicit MPSCRingBuffer(size_t capacity);
+    ~MPSCRingBuffer() = default;
+    
+    MPSCRingBuffer(const MPSCRingBuffer&) = delete;
+    MPSCRingBuffer& operator=(const MPSCRingBuffer&) = delete;
+    
+    /**
+     * @brief Try to enqueue a value (any thread)
+     * 
+     * @param value The value to move into the buffer
+     * @param position Receives the claimed position (0-based, strictly increasing)
+     * @return false if the buffer is full
+     */
+    bool tryPush(T&& value, size_t& position);
+    
+    /**
+     * @brief Try to dequeue the oldest published value (consumer thread only)
+     * 
+     * @return false if no published value is available
+     */
+    bool tryPop(T& value);
+    
+    // Number of slots in the buffer
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    
+    static size_t roundUpPowerOfTwo(size_t value);
+    
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    
+    // Producers and the consumer touch different counters; keep them on
+    // separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> enqueuePos_;
+    alignas(64) size_t dequeuePos_;
+};
+
+// Implementation
+template<typename T>
+size_t MPSCRingBuffer<T>::roundUpPowerOfTwo(size_t value) {
+    size_t result = 2;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+template<typename T>
+MPSCRingBuffer<T>::MPSCRingBuffer(size_t capacity)
+    : slots_(new Slot[roundUpPowerOfTwo(capacity)]),
+      mask_(roundUpPowerOfTwo(capacity) - 1),
+      enqueuePos_(0),
+      dequeuePos_(0) {
+    for (size_t i = 0; i <= mask_; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+bool MPSCRingBuffer<T>::tryPush(T&& value, size_t& position) {
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    
+    while (true) {
+        slot = &slots_[pos & mask_];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        
+        if (diff == 0) {
+            // Slot is free for this position; try to claim it
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The consumer has not released this slot yet: buffer is full
+            return false;
+        } else {
+            // Another producer claimed this position; reload and retry
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+    
+    slot->value = std::move(value);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    position = pos;
+    return true;
+}
+
+template<typename T>
+bool MPSCRingBuffer<T>::tryPop(T& value) {
+    Slot* slot = &slots_[dequeuePos_ & mask_];
+    size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    
+    if (sequence != dequeuePos_ + 1) {
+        return false; // Not yet published
+    }
+    
+    value = std::move(slot->value);
+    slot->sequence.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+    dequeuePos_++;
+    return true;
+}
+
+} // namespace core
+} // namespace phantomdb
+
+#endif // PHANTOMDB_MPSC_RING_BUFFER_H
@@ -0,0 +1,166 @@
+#include "segmented_table.h"
+#include <atomic>
+#include <random>
+#include <algorithm>
+
+namespace phantomdb {
+namespace core {
+
+namespace {
+
+uint64_t randomGeneration() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) ^ device();
+}
+
+} // anonymous namespace
+
+size_t SegmentedTable::Snapshot::rowCount() const {
+    size_t count = 0;
+    for (const auto& segment : segments) {
+        count += segment.data->rowCount();
+    }
+    return count;
+}
+
+std::vector<SegmentedTable::Row> SegmentedTable::Snapshot::toRows() const {
+    std::vector<Row> rows;
+    rows.reserve(rowCount());
+    for (const auto& segment : segments) {
+        auto segmentRows = segment.data->toRows();
+        std::move(segmentRows.begin(), segmentRows.end(), std::back_inserter(rows));
+    }
+    return rows;
+}
+
+SegmentedTable::SegmentedTable(const ColumnDefinitions& columns, size_t segmentRows)
+    : columns_(columns),
+      segmentRows_(std::max<size_t>(1, segmentRows)),
+      generation_(randomGeneration()),
+      nextSegmentId_(0),
+      lastVersion_(0) {
+}
+
+SegmentedTable SegmentedTable::fromSegments(const ColumnDefinitions& columns,
+                                            uint64_t generation,
+                                            std::vector<SegmentView> segments,
+                                            size_t segmentRows) {
+    SegmentedTable table(columns, segmentRows);
+    table.generation_ = generation;
+    for (auto& view : segments) {
+        table.nextSegmentId_ = std::max(table.nextSegmentId_, view.id + 1);
+        table.lastVersion_ = std::max(table.lastVersion_, view.version);
+        // The loaded data is owned by nobody else, so it can become writable
+        table.segments_.push_back({view.id, view.version,
+                                   std::const_pointer_cast<ColumnarTable>(std::move(view.data))});
+    }
+    return table;
+}
+
+size_t SegmentedTable::rowCount() const {
+    size_t count = 0;
+    for (const auto& segment : segments_) {
+        count += segment.data->rowCount();
+    }
+    return count;
+}
+
+SegmentedTable::Segment& SegmentedTable::newSegment() {
+    segments_.push_back({nextSegmentId_++, ++lastVersion_, std::make_shared<ColumnarTable>(columns_)});
+    return segments_.back();
+}
+
+ColumnarTable& SegmentedTable::writableSegment(Segment& segment) {
+    if (segment.data.use_count() > 1) {
+        // A snapshot still reads this segment; give the table its own copy
+        segment.data = std::make_shared<ColumnarTable>(*segment.data);
+    }
+    // Pairs with the release in the snapshot's shared_ptr destructor, so its
+    // last reads happen before our writes
+    std::atomic_thread_fence(std::memory_order_acquire);
+    segment.version = ++lastVersion_;
+    return *segment.data;
+}
+
+void SegmentedTable::appendRow(const Row& row) {
+    if (segments_.empty() || segments_.back().data->rowCount() >= segmentRows_) {
+        newSegment();
+    }
+    writableSegment(segments_.back()).appendRow(row);
+}
+
+std::vector<SegmentedTable::Row> SegmentedTable::toRows() const {
+    std::vector<Row> rows;
+    rows.reserve(rowCount());
+    for (const auto& segment : segments_) {
+        auto segmentRows = segment.data->toRows();
+        std::move(segmentRows.begin(), segmentRows.end(), std::back_inserter(rows));
+    }
+    return rows;
+}
+
+std::vector<SegmentedTable::Row> SegmentedTable::selectRows(const Row& condition) const {
+    std::vector<Row> rows;
+    for (const auto& segment : segments_) {
+        auto segmentRows = segment.data->selectRows(condition);
+        std::move(segmentRows.begin(), segmentRows.end(), std::back_inserter(rows));
+    }
+    return rows;
+}
+
+size_t SegmentedTable::updateRows(const Row& data, const Row& condition) {
+    size_t updated = 0;
+    for (auto& segment : segments_) {
+        // Only segments with a match are copied and re-versioned
+        if (segment.data->findMatchingRows(condition).empty()) {
+            continue;
+        }
+        updated += writableSegment(segment).updateRows(data, condition);
+    }
+    return updated;
+}
+
+size_t SegmentedTable::deleteRows(const Row& condition) {
+    if (condition.empty()) {
+        return 0;
+    }
+    
+    size_t deleted = 0;
+    for (auto& segment : segments_) {
+        if (segment.data->findMatchingRows(condition).empty()) {
+            continue;
+        }
+        deleted += writableSegment(segment).deleteRows(condition);
+    }
+    
+    // Drop emptied segments, but keep the last one as the append target
+    if (deleted > 0) {
+        auto last = segments_.empty() ? segments_.end() : segments_.end() - 1;
+        segments_.erase(std::remove_if(segments_.begin(), last, [](const Segment& segment) {
+            return segment.data->rowCount() == 0;
+        }), last);
+    }
+    return deleted;
+}
+
+size_t SegmentedTable::memoryUsage() const {
+    size_t bytes = segments_.capacity() * sizeof(Segment);
+    for (const auto& segment : segments_) {
+        bytes += segment.data->memoryUsage();
+    }
+    return bytes;
+}
+
+SegmentedTable::Snapshot SegmentedTable::snapshot() const {
+    Snapshot snapshot;
+    snapshot.generation = generation_;
+    snapshot.columns = columns_;
+    snapshot.segments.reserve(segments_.size());
+    for (const auto& segment : segments_) {
+        snapshot.segments.push_back({segment.id, segment.version, segment.data});
+    }
+    return snapshot;
+}
+
+} // namespace core
+} // namespace phantomdb
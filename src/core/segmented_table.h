@@ -0,0 +1,112 @@
+#ifndef PHANTOMDB_SEGMENTED_TABLE_H
+#define PHANTOMDB_SEGMENTED_TABLE_H
+
+#include "columnar_table.h"
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace phantomdb {
+namespace core {
+
+/**
+ * @brief Table storage split into reference-counted, copy-on-write row chunks
+ * 
+ * Rows live in fixed-size segments, each a ColumnarTable behind a
+ * shared_ptr. snapshot() only copies the segment pointers, so it is cheap
+ * enough to take under a read lock. A writer that touches a segment still
+ * referenced by a snapshot clones that one segment first; everything else
+ * stays shared. Every write stamps the segment with a new version, which
+ * lets incremental checkpoints skip segments that have not changed.
+ * 
+ * Like ColumnarTable, this class is not synchronized; core::Database
+ * guards it with the table lock.
+ */
+class SegmentedTable {
+public:
+    using Row = ColumnarTable::Row;
+    using ColumnDefinitions = ColumnarTable::ColumnDefinitions;
+    
+    static const size_t DEFAULT_SEGMENT_ROWS = 4096;
+    
+    // A segment as seen by a snapshot; never modified after capture
+    struct SegmentView {
+        uint64_t id;
+        uint64_t version;
+        std::shared_ptr<const ColumnarTable> data;
+    };
+    
+    // A point-in-time view of the whole table
+    struct Snapshot {
+        uint64_t generation;
+        ColumnDefinitions columns;
+        std::vector<SegmentView> segments;
+        
+        size_t rowCount() const;
+        std::vector<Row> toRows() const;
+    };
+    
+    explicit SegmentedTable(const ColumnDefinitions& columns = {},
+                            size_t segmentRows = DEFAULT_SEGMENT_ROWS);
+    
+    /**
+     * @brief Rebuild a table from previously captured segments
+     * 
+     * Segment ids, versions and the generation are preserved so the next
+     * incremental checkpoint recognizes unchanged segments.
+     */
+    static SegmentedTable fromSegments(const ColumnDefinitions& columns,
+                                       uint64_t generation,
+                                       std::vector<SegmentView> segments,
+                                       size_t segmentRows = DEFAULT_SEGMENT_ROWS);
+    
+    // Schema and size
+    const ColumnDefinitions& getColumns() const { return columns_; }
+    size_t rowCount() const;
+    size_t segmentCount() const { return segments_.size(); }
+    
+    // Random identifier of this table instance; distinguishes a re-created
+    // table from the one it replaced
+    uint64_t getGeneration() const { return generation_; }
+    
+    void appendRow(const Row& row);
+    std::vector<Row> toRows() const;
+    std::vector<Row> selectRows(const Row& condition) const;
+    size_t updateRows(const Row& data, const Row& condition);
+    
+    // An empty condition removes nothing
+    size_t deleteRows(const Row& condition);
+    
+    size_t memoryUsage() const;
+    
+    /**
+     * @brief Capture the current segments without copying any rows
+     */
+    Snapshot snapshot() const;
+
+private:
+    struct Segment {
+        uint64_t id;
+        uint64_t version;
+        std::shared_ptr<ColumnarTable> data;
+    };
+    
+    ColumnDefinitions columns_;
+    std::vector<Segment> segments_;
+    size_t segmentRows_;
+    uint64_t generation_;
+    uint64_t nextSegmentId_;
+    uint64_t lastVersion_;
+    
+    Segment& newSegment();
+    
+    // Make a segment private to the table (cloning it if a snapshot shares
+    // it) and stamp it with a new version
+    ColumnarTable& writableSegment(Segment& segment);
+};
+
+} // namespace core
+} // namespace phantomdb
+
+#endif // PHANTOMDB_SEGMENTED_TABLE_H
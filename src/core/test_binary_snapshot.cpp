@@ -0,0 +1,120 @@
+#include "binary_snapshot.h"
+#include "database.h"
+#include <iostream>
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+
+using phantomdb::core::BinarySnapshotReader;
+using phantomdb::core::BinarySnapshotWriter;
+using phantomdb::core::Database;
+using phantomdb::core::TableData;
+
+int main() {
+    std::cout << "Testing Binary Snapshot Format" << std::endl;
+    std::cout << "==============================" << std::endl;
+    
+    const std::string dataDir = "./test_binary_snapshot_data";
+    std::filesystem::remove_all(dataDir);
+    const std::string path = dataDir + "/snapshot.db";
+    
+    std::unordered_map<std::string, TableData> tables;
+    tables["users"].columns = {{"id", "integer"}, {"name", "string"}};
+    for (int i = 0; i < 1000; ++i) {
+        tables["users"].rows.push_back({{"id", std::to_string(i)}, {"name", "User, \"" + std::to_string(i) + "\"\n"}});
+    }
+    tables["users"].rows[7].erase("name");          // Missing cell
+    tables["users"].rows[8]["nickname"] = "eight";  // Undeclared column
+    tables["users"].rows[9]["name"] = "";           // Empty but present
+    tables["empty"].columns = {{"a", "string"}};
+    
+    // Test 1: Round trip through the writer and the mapped reader
+    std::cout << "\n1. Testing snapshot round trip..." << std::endl;
+    assert(BinarySnapshotWriter::write(path, "snap_db", tables));
+    assert(BinarySnapshotReader::isSnapshotFile(path));
+    assert(!std::filesystem::exists(path + ".tmp"));
+    {
+        BinarySnapshotReader reader;
+        assert(reader.open(path));
+        assert(reader.getDatabaseName() == "snap_db");
+        assert((reader.getTableNames() == std::vector<std::string>{"empty", "users"}));
+        
+        TableData users;
+        assert(reader.loadTable("users", users));
+        assert(users.columns == tables["users"].columns);
+        assert(users.rows == tables["users"].rows);
+        
+        TableData empty;
+        assert(reader.loadTable("empty", empty));
+        assert(empty.columns.size() == 1 && empty.rows.empty());
+        assert(!reader.loadTable("missing", empty));
+    }
+    std::cout << "✓ Snapshot round trip tests passed" << std::endl;
+    
+    // Test 2: Parallel load sees every table once
+    std::cout << "\n2. Testing parallel load..." << std::endl;
+    {
+        BinarySnapshotReader reader;
+        assert(reader.open(path));
+        std::mutex loadedMutex;
+        std::unordered_map<std::string, TableData> loaded;
+        assert(reader.loadAll([&](const std::string& name, TableData&& table) {
+            std::lock_guard<std::mutex> lock(loadedMutex);
+            assert(loaded.emplace(name, std::move(table)).second);
+        }, 4));
+        assert(loaded.size() == 2 && loaded["users"].rows == tables["users"].rows);
+    }
+    std::cout << "✓ Parallel load tests passed" << std::endl;
+    
+    // Test 3: Corruption is detected by the block and footer checksums
+    std::cout << "\n3. Testing corruption detection..." << std::endl;
+    {
+        std::string corruptPath = dataDir + "/corrupt.db";
+        std::filesystem::copy_file(path, corruptPath);
+        {
+            std::fstream file(corruptPath, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(200);
+            file.put('\x7f');
+        }
+        BinarySnapshotReader reader;
+        assert(reader.open(corruptPath)); // Footer is intact
+        TableData table;
+        assert(reader.loadTable("empty", table));  // First block is untouched
+        assert(!reader.loadTable("users", table));
+        assert(!reader.loadAll([](const std::string&, TableData&&) {}));
+        
+        std::filesystem::resize_file(corruptPath, std::filesystem::file_size(corruptPath) - 3);
+        assert(!reader.open(corruptPath));
+        assert(!reader.isOpen());
+    }
+    std::cout << "✓ Corruption detection tests passed" << std::endl;
+    
+    // Test 4: Database save/load uses the binary format; CSV is export-only
+    std::cout << "\n4. Testing database save and load..." << std::endl;
+    {
+        Database db;
+        db.setDataDirectory(dataDir);
+        assert(db.createDatabase("shop"));
+        assert(db.createTable("shop", "items", {{"id", "integer"}, {"price", "float"}}));
+        assert(db.createTable("shop", "tags", {{"tag", "string"}}));
+        assert(db.insertData("shop", "items", {{"id", "1"}, {"price", "9.99"}}));
+        assert(db.insertData("shop", "items", {{"id", "2"}, {"price", "1e2"}}));
+        assert(db.insertData("shop", "tags", {{"tag", "a,b"}}));
+        assert(db.saveToDisk("shop"));
+        assert(db.exportToCSV("shop"));
+        assert(std::filesystem::exists(dataDir + "/shop.csv"));
+        
+        Database db2;
+        db2.setDataDirectory(dataDir);
+        assert(db2.loadFromDisk("shop"));
+        assert(db2.selectData("shop", "items", {{"price", "1e2"}}).size() == 1);
+        assert(db2.selectData("shop", "tags")[0].at("tag") == "a,b");
+        assert(!db2.loadFromDisk("shop", "shop.csv"));
+    }
+    std::cout << "✓ Database save and load tests passed" << std::endl;
+    
+    std::filesystem::remove_all(dataDir);
+    
+    std::cout << "\nAll binary snapshot tests passed!" << std::endl;
+    return 0;
+}
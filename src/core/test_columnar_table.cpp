@@ -0,0 +1,109 @@
+#include "columnar_table.h"
+#include <iostream>
+#include <cassert>
+
+using phantomdb::core::ColumnarTable;
+using phantomdb::core::ColumnType;
+
+int main() {
+    std::cout << "Testing Columnar Table Storage" << std::endl;
+    std::cout << "==============================" << std::endl;
+    
+    // Test 1: Type mapping
+    std::cout << "\n1. Testing column type mapping..." << std::endl;
+    assert(ColumnarTable::columnTypeFromName("INTEGER") == ColumnType::INTEGER);
+    assert(ColumnarTable::columnTypeFromName("bigint") == ColumnType::INTEGER);
+    assert(ColumnarTable::columnTypeFromName("decimal") == ColumnType::FLOAT);
+    assert(ColumnarTable::columnTypeFromName("bool") == ColumnType::BOOLEAN);
+    assert(ColumnarTable::columnTypeFromName("timestamp") == ColumnType::STRING);
+    std::cout << "✓ Column type mapping tests passed" << std::endl;
+    
+    ColumnarTable table({
+        {"id", "integer"},
+        {"name", "string"},
+        {"score", "float"},
+        {"active", "boolean"}
+    });
+    
+    // Test 2: Round trip of typed and non-canonical values
+    std::cout << "\n2. Testing row round trip..." << std::endl;
+    table.appendRow({{"id", "1"}, {"name", "Alice"}, {"score", "10.50"}, {"active", "true"}});
+    table.appendRow({{"id", "+2"}, {"name", "Bob"}, {"score", "1e3"}, {"active", "yes"}});
+    table.appendRow({{"id", "3"}, {"name", "Carol"}});
+    assert(table.rowCount() == 3);
+    
+    auto row = table.getRow(0);
+    assert(row.size() == 4);
+    assert(row.at("id") == "1" && row.at("score") == "10.50" && row.at("active") == "true");
+    
+    row = table.getRow(1);
+    assert(row.at("id") == "+2" && row.at("score") == "1e3" && row.at("active") == "yes");
+    
+    row = table.getRow(2);
+    assert(row.size() == 2); // Missing cells stay absent
+    assert(row.find("score") == row.end());
+    std::cout << "✓ Row round trip tests passed" << std::endl;
+    
+    // Test 3: Filtering compares cell text exactly
+    std::cout << "\n3. Testing condition matching..." << std::endl;
+    assert(table.selectRows({{"id", "1"}}).size() == 1);
+    assert(table.selectRows({{"id", "2"}}).empty());
+    assert(table.selectRows({{"id", "+2"}}).size() == 1);
+    assert(table.selectRows({{"score", "10.5"}}).empty());
+    assert(table.selectRows({{"score", "10.50"}}).size() == 1);
+    assert(table.selectRows({{"active", "yes"}, {"name", "Bob"}}).size() == 1);
+    assert(table.selectRows({{"unknown", "x"}}).empty());
+    assert(table.selectRows({}).size() == 3);
+    
+    // Typed floats match like their text: -0.0 is not 0.0, nan is nan
+    ColumnarTable floats({{"x", "float"}, {"note", "string"}});
+    floats.appendRow({{"x", "0.0"}});
+    floats.appendRow({{"x", "-0.0"}});
+    floats.appendRow({{"x", "nan"}});
+    assert(floats.selectRows({{"x", "0.0"}}).size() == 1);
+    assert(floats.selectRows({{"x", "-0.0"}}).size() == 1);
+    assert(floats.selectRows({{"x", "-0.0"}})[0].at("x") == "-0.0");
+    assert(floats.selectRows({{"x", "nan"}}).size() == 1);
+    assert(floats.selectRows({{"x", "-nan"}}).empty());
+    std::cout << "✓ Condition matching tests passed" << std::endl;
+    
+    // Test 4: Update
+    std::cout << "\n4. Testing updates..." << std::endl;
+    assert(table.updateRows({{"name", "Caroline"}, {"score", "7.25"}}, {{"id", "3"}}) == 1);
+    row = table.getRow(2);
+    assert(row.at("name") == "Caroline" && row.at("score") == "7.25");
+    assert(table.updateRows({{"active", "false"}}, {}) == 3);
+    assert(table.selectRows({{"active", "false"}}).size() == 3);
+    std::cout << "✓ Update tests passed" << std::endl;
+    
+    // Test 5: Delete keeps remaining rows intact
+    std::cout << "\n5. Testing deletes..." << std::endl;
+    assert(table.deleteRows({}) == 0);
+    assert(table.deleteRows({{"name", "Bob"}}) == 1);
+    assert(table.rowCount() == 2);
+    auto rows = table.toRows();
+    assert(rows[0].at("name") == "Alice");
+    assert(rows[1].at("name") == "Caroline" && rows[1].at("id") == "3");
+    std::cout << "✓ Delete tests passed" << std::endl;
+    
+    // Test 6: Tables without a schema grow string columns on demand
+    std::cout << "\n6. Testing schemaless tables..." << std::endl;
+    ColumnarTable loose;
+    loose.appendRow({{"a", "1"}});
+    loose.appendRow({{"b", "2"}});
+    assert(loose.columnCount() == 2);
+    assert(loose.getRow(0).size() == 1 && loose.getRow(1).at("b") == "2");
+    std::cout << "✓ Schemaless table tests passed" << std::endl;
+    
+    // Test 7: Heavy string overwrites compact the arena
+    std::cout << "\n7. Testing string arena compaction..." << std::endl;
+    for (int i = 0; i < 200; ++i) {
+        table.updateRows({{"name", std::string(100, static_cast<char>('a' + i % 26))}}, {{"id", "1"}});
+    }
+    assert(table.getRow(0).at("name") == std::string(100, static_cast<char>('a' + 199 % 26)));
+    assert(table.memoryUsage() < 16384);
+    std::cout << "✓ String arena compaction tests passed" << std::endl;
+    
+    std::cout << "\nAll columnar table tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include "segmented_table.h"
+#include "database.h"
+#include "enhanced_persistence.h"
+#include <iostream>
+#include <cassert>
+#include <filesystem>
+
+using phantomdb::core::CheckpointTable;
+using phantomdb::core::CheckpointTableData;
+using phantomdb::core::Database;
+using phantomdb::core::EnhancedPersistenceManager;
+using phantomdb::core::SegmentedTable;
+using phantomdb::core::TableData;
+
+int main() {
+    std::cout << "Testing Segmented Copy-on-Write Tables" << std::endl;
+    std::cout << "======================================" << std::endl;
+    
+    const std::string dataDir = "./test_segmented_table_data";
+    std::filesystem::remove_all(dataDir);
+    
+    // Test 1: Rows are split into fixed-size segments
+    std::cout << "\n1. Testing segment layout..." << std::endl;
+    SegmentedTable table({{"id", "integer"}, {"name", "string"}}, 4);
+    for (int i = 0; i < 10; ++i) {
+        table.appendRow({{"id", std::to_string(i)}, {"name", "row" + std::to_string(i)}});
+    }
+    assert(table.rowCount() == 10 && table.segmentCount() == 3);
+    assert(table.selectRows({{"id", "9"}}).size() == 1);
+    assert(table.toRows()[5].at("name") == "row5");
+    std::cout << "✓ Segment layout tests passed" << std::endl;
+    
+    // Test 2: Snapshots are isolated from later writes
+    std::cout << "\n2. Testing snapshot isolation..." << std::endl;
+    auto before = table.snapshot();
+    assert(before.rowCount() == 10);
+    assert(table.updateRows({{"name", "changed"}}, {{"id", "1"}}) == 1);
+    assert(table.deleteRows({{"id", "9"}}) == 1);
+    table.appendRow({{"id", "10"}, {"name", "row10"}});
+    
+    auto after = table.snapshot();
+    assert(before.toRows()[1].at("name") == "row1");
+    assert(after.toRows()[1].at("name") == "changed");
+    assert(before.rowCount() == 10 && after.rowCount() == 10);
+    
+    // Only the touched segments got new versions and copies
+    assert(before.segments[0].version != after.segments[0].version);
+    assert(before.segments[0].data != after.segments[0].data);
+    assert(before.segments[1].version == after.segments[1].version);
+    assert(before.segments[1].data == after.segments[1].data);
+    assert(before.segments[2].version != after.segments[2].version);
+    std::cout << "✓ Snapshot isolation tests passed" << std::endl;
+    
+    // Test 3: Emptied segments are dropped, the append target is kept
+    std::cout << "\n3. Testing segment removal..." << std::endl;
+    for (int i = 4; i < 8; ++i) {
+        assert(table.deleteRows({{"id", std::to_string(i)}}) == 1);
+    }
+    assert(table.segmentCount() == 2 && table.rowCount() == 6);
+    assert(table.deleteRows({}) == 0);
+    std::cout << "✓ Segment removal tests passed" << std::endl;
+    
+    // Test 4: Checkpoints only write changed segments
+    std::cout << "\n4. Testing incremental checkpoints..." << std::endl;
+    {
+        auto capture = [](const SegmentedTable& source) {
+            auto snapshot = source.snapshot();
+            CheckpointTable captured{snapshot.generation, snapshot.columns, {}};
+            for (const auto& segment : snapshot.segments) {
+                captured.segments.push_back({segment.id, segment.version, [segment, snapshot]() {
+                    TableData data;
+                    data.columns = snapshot.columns;
+                    data.rows = segment.data->toRows();
+                    return data;
+                }});
+            }
+            return captured;
+        };
+        
+        EnhancedPersistenceManager manager;
+        manager.setDataDirectory(dataDir);
+        size_t written = 0;
+        assert(manager.writeCheckpoint("inc", 0, {{"t", capture(table)}}, &written));
+        assert(written == 2);
+        assert(manager.writeCheckpoint("inc", 0, {{"t", capture(table)}}, &written));
+        assert(written == 0);
+        
+        table.appendRow({{"id", "11"}, {"name", "row11"}});
+        assert(manager.writeCheckpoint("inc", 0, {{"t", capture(table)}}, &written));
+        assert(written == 1);
+        
+        // A fresh manager picks up where the manifest left off
+        EnhancedPersistenceManager reopened;
+        reopened.setDataDirectory(dataDir);
+        assert(reopened.writeCheckpoint("inc", 0, {{"t", capture(table)}}, &written));
+        assert(written == 0);
+        
+        std::unordered_map<std::string, CheckpointTableData> loaded;
+        assert(reopened.loadCheckpoint("inc", loaded));
+        assert(loaded["t"].generation == table.getGeneration());
+        assert(loaded["t"].segments.size() == table.segmentCount());
+        size_t rows = 0;
+        for (const auto& segment : loaded["t"].segments) {
+            rows += segment.data.rows.size();
+        }
+        assert(rows == table.rowCount());
+        
+        // Chunk files that are no longer referenced were removed
+        size_t chunkFiles = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(dataDir + "/inc_checkpoint")) {
+            chunkFiles += entry.path().filename().string().rfind("chunks_", 0) == 0 ? 1 : 0;
+        }
+        assert(chunkFiles == 2);
+    }
+    std::cout << "✓ Incremental checkpoint tests passed" << std::endl;
+    
+    // Test 5: Background snapshots run while writers continue
+    std::cout << "\n5. Testing background snapshot and restore..." << std::endl;
+    {
+        Database db;
+        db.setDataDirectory(dataDir);
+        assert(db.createDatabase("cow"));
+        assert(db.createTable("cow", "events", {{"id", "integer"}, {"kind", "string"}}));
+        for (int i = 0; i < 5000; ++i) {
+            db.insertData("cow", "events", {{"id", std::to_string(i)}, {"kind", "old"}});
+        }
+        
+        assert(db.createSnapshot("cow"));
+        // Modified while the checkpoint may still be writing
+        assert(db.updateData("cow", "events", {{"kind", "new"}}));
+        assert(db.insertData("cow", "events", {{"id", "5000"}, {"kind", "new"}}));
+        assert(db.waitForSnapshot());
+        
+        assert(db.restoreSnapshot("cow"));
+        assert(db.selectData("cow", "events").size() == 5000);
+        assert(db.selectData("cow", "events", {{"kind", "old"}}).size() == 5000);
+        
+        // Restored tables keep their segment identity, so writes stay incremental
+        assert(db.deleteData("cow", "events", {{"id", "4999"}}));
+        assert(db.createSnapshot("cow"));
+        assert(db.waitForSnapshot());
+        
+        Database db2;
+        db2.setDataDirectory(dataDir);
+        assert(db2.restoreSnapshot("cow"));
+        assert(db2.selectData("cow", "events").size() == 4999);
+        assert(!db2.restoreSnapshot("missing"));
+    }
+    std::cout << "✓ Background snapshot and restore tests passed" << std::endl;
+    
+    std::filesystem::remove_all(dataDir);
+    
+    std::cout << "\nAll segmented table tests passed!" << std::endl;
+    return 0;
+}
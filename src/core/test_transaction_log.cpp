@@ -0,0 +1,263 @@
+#include "database.h"
+#include "enhanced_persistence.h"
+#include "mpsc_ring_buffer.h"
+#include <iostream>
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <set>
+
+using phantomdb::core::Database;
+using phantomdb::core::EnhancedPersistenceManager;
+using phantomdb::core::LogSyncPolicy;
+using phantomdb::core::MPSCRingBuffer;
+
+namespace {
+
+// Zero out a marker string wherever it appears in a database's log segments,
+// leaving a record that fails its checksum as a crash during a write would
+bool tearLogRecord(const std::string& directory, const std::string& databaseName, const std::string& marker) {
+    bool found = false;
+    std::string prefix = databaseName + ".log.";
+    for (const auto& file : std::filesystem::directory_iterator(directory)) {
+        if (file.path().filename().string().compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        std::string bytes;
+        {
+            std::ifstream in(file.path(), std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        size_t pos = bytes.find(marker);
+        if (pos != std::string::npos) {
+            std::fstream out(file.path(), std::ios::binary | std::ios::in | std::ios::out);
+            out.seekp(static_cast<std::streamoff>(pos));
+            out.write(std::string(marker.size(), '\0').data(), static_cast<std::streamsize>(marker.size()));
+            found = true;
+        }
+    }
+    return found;
+}
+
+} // anonymous namespace
+
+int main() {
+    std::cout << "Testing Asynchronous Transaction Log" << std::endl;
+    std::cout << "====================================" << std::endl;
+    
+    const std::string dataDir = "./test_transaction_log_data";
+    std::filesystem::remove_all(dataDir);
+    
+    // Test 1: Ring buffer keeps claim order and reports full
+    std::cout << "\n1. Testing MPSC ring buffer..." << std::endl;
+    {
+        MPSCRingBuffer<int> ring(3);
+        assert(ring.capacity() == 4);
+        size_t position;
+        for (int i = 0; i < 4; ++i) {
+            int value = i;
+            assert(ring.tryPush(std::move(value), position));
+            assert(position == static_cast<size_t>(i));
+        }
+        int extra = 99;
+        assert(!ring.tryPush(std::move(extra), position));
+        
+        int value;
+        for (int i = 0; i < 4; ++i) {
+            assert(ring.tryPop(value) && value == i);
+        }
+        assert(!ring.tryPop(value));
+        
+        // Concurrent producers: every value arrives exactly once
+        MPSCRingBuffer<int> shared(64);
+        const int producers = 4;
+        const int perProducer = 1000;
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&shared, p]() {
+                for (int i = 0; i < perProducer; ++i) {
+                    int item = p * perProducer + i;
+                    size_t pos;
+                    while (!shared.tryPush(std::move(item), pos)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        std::set<int> seen;
+        while (seen.size() < static_cast<size_t>(producers * perProducer)) {
+            if (shared.tryPop(value)) {
+                assert(seen.insert(value).second);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    std::cout << "✓ MPSC ring buffer tests passed" << std::endl;
+    
+    // Test 2: Records round-trip through the binary log
+    std::cout << "\n2. Testing record round trip..." << std::endl;
+    {
+        EnhancedPersistenceManager manager;
+        manager.setDataDirectory(dataDir);
+        assert(manager.getLogSyncPolicy() == LogSyncPolicy::INTERVAL);
+        
+        assert(manager.appendTransactionLog("log_db", "users", "INSERT",
+                                            {{"id", "1"}, {"name", "Alice, \"A\"\n"}}));
+        assert(manager.appendTransactionLog("log_db", "users", "UPDATE",
+                                            {{"name", "Bob"}}, {{"id", "1"}}));
+        assert(manager.appendTransactionLog("log_db", "LEGACY_OPERATION", {{"key", "value"}}));
+        
+        auto records = manager.readTransactionLog("log_db");
+        assert(records.size() == 3);
+        assert(records[0].lsn < records[1].lsn && records[1].lsn < records[2].lsn);
+        assert(records[0].operation == "INSERT" && records[0].table == "users");
+        assert(records[0].data.size() == 2 && records[0].condition.empty());
+        for (const auto& field : records[0].data) {
+            assert(field.first != "name" || field.second == "Alice, \"A\"\n");
+        }
+        assert(records[1].condition.size() == 1 && records[1].condition[0].second == "1");
+        assert(records[2].table.empty() && records[2].data[0].first == "key");
+        assert(records[0].timestamp > 0);
+    }
+    std::cout << "✓ Record round trip tests passed" << std::endl;
+    
+    // Test 3: Concurrent committers share durable group commits
+    std::cout << "\n3. Testing per-commit durability..." << std::endl;
+    {
+        EnhancedPersistenceManager manager;
+        manager.setDataDirectory(dataDir);
+        manager.setLogSyncPolicy(LogSyncPolicy::PER_COMMIT);
+        
+        const int writers = 4;
+        const int perWriter = 200;
+        std::vector<std::thread> threads;
+        for (int w = 0; w < writers; ++w) {
+            threads.emplace_back([&manager, w]() {
+                for (int i = 0; i < perWriter; ++i) {
+                    assert(manager.appendTransactionLog("group_db", "t" + std::to_string(w), "INSERT",
+                                                        {{"id", std::to_string(i)}}));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        
+        uint64_t lsn = manager.enqueueTransactionLog("group_db", "t0", "DELETE", {}, {{"id", "0"}});
+        assert(lsn > 0);
+        assert(manager.waitForDurability(lsn));
+        
+        auto records = manager.readTransactionLog("group_db");
+        assert(records.size() == static_cast<size_t>(writers * perWriter + 1));
+        assert(records.back().lsn == lsn && records.back().operation == "DELETE");
+    }
+    std::cout << "✓ Per-commit durability tests passed" << std::endl;
+    
+    // Test 4: A torn tail record is ignored on read
+    std::cout << "\n4. Testing torn record handling..." << std::endl;
+    {
+        {
+            EnhancedPersistenceManager writer;
+            writer.setDataDirectory(dataDir);
+            assert(writer.appendTransactionLog("log_db", "users", "INSERT", {{"name", "TORN-RECORD-MARKER"}}));
+        }
+        assert(tearLogRecord(dataDir, "log_db", "TORN-RECORD-MARKER"));
+        EnhancedPersistenceManager manager;
+        manager.setDataDirectory(dataDir);
+        assert(manager.readTransactionLog("log_db").size() == 3);
+    }
+    std::cout << "✓ Torn record handling tests passed" << std::endl;
+    
+    // Test 5: Database logs writes but not reads
+    std::cout << "\n5. Testing database write logging..." << std::endl;
+    {
+        Database db;
+        db.setDataDirectory(dataDir);
+        db.setLogSyncPolicy(LogSyncPolicy::NONE);
+        assert(db.getLogSyncPolicy() == LogSyncPolicy::NONE);
+        
+        assert(db.createDatabase("db_log"));
+        assert(db.createTable("db_log", "items", {{"id", "integer"}, {"label", "string"}}));
+        assert(db.insertData("db_log", "items", {{"id", "1"}, {"label", "one"}}));
+        assert(db.selectData("db_log", "items").size() == 1);
+        assert(db.updateData("db_log", "items", {{"label", "uno"}}, {{"id", "1"}}));
+        assert(db.deleteData("db_log", "items", {{"id", "1"}}));
+        assert(db.flushTransactionLog());
+        
+        EnhancedPersistenceManager reader;
+        reader.setDataDirectory(dataDir);
+        auto records = reader.readTransactionLog("db_log");
+        std::vector<std::string> operations;
+        for (const auto& record : records) {
+            operations.push_back(record.operation);
+        }
+        assert((operations == std::vector<std::string>{
+            "CREATE_DATABASE", "CREATE_TABLE", "INSERT", "UPDATE", "DELETE"}));
+        assert(records[3].data[0].second == "uno" && records[3].condition[0].second == "1");
+    }
+    std::cout << "✓ Database write logging tests passed" << std::endl;
+    
+    // Test 6: Lsns handed out while the directory (and lsn base) changes
+    // are the ones the records are written with
+    std::cout << "\n6. Testing lsns across a directory change..." << std::endl;
+    {
+        const std::string otherDir = dataDir + "_other";
+        std::filesystem::remove_all(otherDir);
+        for (int i = 0; i < 3; ++i) {
+            // Each restart reserves a block above the last, raising the base
+            EnhancedPersistenceManager seeder;
+            seeder.setDataDirectory(otherDir);
+            assert(seeder.appendTransactionLog("seed_db", "LEGACY_OPERATION", {{"n", std::to_string(i)}}));
+        }
+        
+        EnhancedPersistenceManager manager;
+        manager.setDataDirectory(dataDir);
+        std::mutex lsnsMutex;
+        std::map<std::string, uint64_t> lsns;
+        std::vector<std::thread> threads;
+        for (int w = 0; w < 4; ++w) {
+            threads.emplace_back([&manager, &lsnsMutex, &lsns, w]() {
+                for (int i = 0; i < 500; ++i) {
+                    std::string id = std::to_string(w) + "-" + std::to_string(i);
+                    uint64_t lsn = manager.enqueueTransactionLog("race_db", "t", "INSERT", {{"id", id}});
+                    assert(lsn > 0);
+                    std::lock_guard<std::mutex> lock(lsnsMutex);
+                    lsns[id] = lsn;
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        manager.setDataDirectory(otherDir);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        assert(manager.flushTransactionLog());
+        
+        size_t checked = 0;
+        for (const auto& directory : {dataDir, otherDir}) {
+            EnhancedPersistenceManager reader;
+            reader.setDataDirectory(directory);
+            for (const auto& record : reader.readTransactionLog("race_db")) {
+                assert(record.lsn == lsns.at(record.data[0].second));
+                ++checked;
+            }
+        }
+        assert(checked == lsns.size());
+        std::filesystem::remove_all(otherDir);
+    }
+    std::cout << "✓ Directory change lsn tests passed" << std::endl;
+    
+    std::filesystem::remove_all(dataDir);
+    
+    std::cout << "\nAll transaction log tests passed!" << std::endl;
+    return 0;
+}
@@ -4,6 +4,13 @@
 #include <algorithm>
 #include <cctype>
 #include <regex>
+#include <array>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace phantomdb {
 namespace core {
@@ -248,6 +255,38 @@ bool validateValueType(const std::string& value, const std::string& type) {
     return true;
 }
 
+uint32_t crc32(const void* data, size_t length, uint32_t crc) {
+    // Table for the reflected polynomial 0xEDB88320, built on first use
+    static const auto table = []() {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+    
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool syncFile(std::FILE* file) {
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#elif defined(__APPLE__)
+    return ::fsync(fileno(file)) == 0;
+#else
+    return ::fdatasync(fileno(file)) == 0;
+#endif
+}
+
 } // namespace utils
 } // namespace core
 } // namespace phantomdb
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include <unordered_map>
 #include <vector>
 #include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
 
 namespace phantomdb {
 namespace core {
@@ -60,6 +63,100 @@ bool isValidDate(const std::string& value);
 bool isValidTime(const std::string& value);
 bool isValidTimestamp(const std::string& value);
 
+/**
+ * @brief Compute the CRC-32 (IEEE 802.3) checksum of a byte range
+ * 
+ * @param data Pointer to the first byte
+ * @param length Number of bytes to checksum
+ * @param crc Running checksum to continue from (0 for a new checksum)
+ * @return The updated checksum
+ */
+uint32_t crc32(const void* data, size_t length, uint32_t crc = 0);
+
+/**
+ * @brief Append a varint: 7 bits per byte, low bits first, with the high
+ *        bit set on every byte but the last
+ * 
+ * Used by every on-disk and in-memory format that stores lengths and
+ * deltas; defined here so the decoding loops stay inline.
+ */
+inline void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+/**
+ * @brief Read a varint written by putVarint, advancing pos past it
+ * 
+ * @return false if it runs past end or is longer than a uint64_t allows
+ */
+inline bool getVarint(const unsigned char*& pos, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+        unsigned char byte = *pos++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Same, reading from byte offset pos of in
+inline bool getVarint(const std::string& in, size_t& pos, uint64_t& value) {
+    const unsigned char* start = reinterpret_cast<const unsigned char*>(in.data());
+    const unsigned char* cursor = start + pos;
+    bool ok = getVarint(cursor, start + in.size(), value);
+    pos = static_cast<size_t>(cursor - start);
+    return ok;
+}
+
+// Append value as 4 little-endian bytes, the fixed-width fields of the
+// on-disk formats (lengths, checksums, offsets)
+inline void putFixed32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+// Same, as 8 bytes
+inline void putFixed64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+// Read a little-endian integer of bytes (at most 8) bytes; the caller
+// checks that they are there
+inline uint64_t getFixed(const unsigned char* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Flush a file's data to stable storage (fdatasync / _commit)
+ * 
+ * The caller must fflush the stream first.
+ * 
+ * @param file The open file
+ * @return true if successful, false otherwise
+ */
+bool syncFile(std::FILE* file);
+
 } // namespace utils
 } // namespace core
 } // namespace phantomdb
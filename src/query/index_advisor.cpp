@@ -0,0 +1,555 @@
+#include "index_advisor.h"
+#include "sql_parser.h"
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+namespace phantomdb {
+namespace query {
+
+namespace {
+
+// Selectivity of an equality predicate on a column without statistics
+// (as EnhancedStatisticsManager::estimateSelectivity assumes)
+const double DEFAULT_SELECTIVITY = 0.1;
+
+// Share of a table an open or bounded range predicate is assumed to match
+const double RANGE_SELECTIVITY = 1.0 / 3.0;
+
+// Aged predicate and write counts below this are forgotten
+const double FORGET_WEIGHT = 0.5;
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n(");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t\r\n);");
+    return s.substr(begin, end - begin + 1);
+}
+
+std::string toUpper(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return s;
+}
+
+// A column reference such as id or o.user_id (not a number or string)
+bool isColumn(const std::string& s) {
+    if (s.empty() || !(std::isalpha(static_cast<unsigned char>(s[0])) || s[0] == '_')) {
+        return false;
+    }
+    for (char c : s) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.') {
+            return false;
+        }
+    }
+    std::string upper = toUpper(s);
+    return upper != "NULL" && upper != "TRUE" && upper != "FALSE";
+}
+
+// Drop a table or alias qualifier: o.user_id -> user_id
+std::string columnName(const std::string& s) {
+    size_t dot = s.rfind('.');
+    return dot == std::string::npos ? s : s.substr(dot + 1);
+}
+
+// Split a WHERE clause at AND and OR, keeping BETWEEN a AND b whole
+std::vector<std::string> splitConjuncts(const std::string& condition) {
+    std::string text = condition;
+    std::replace_if(text.begin(), text.end(), [](char c) { return c == '\t' || c == '\r' || c == '\n'; }, ' ');
+    std::string upper = toUpper(text);
+
+    std::vector<std::string> terms;
+    size_t start = 0;
+    size_t searchFrom = 0;
+    bool betweenClosed = false;
+    while (true) {
+        size_t andPos = upper.find(" AND ", searchFrom);
+        size_t orPos = upper.find(" OR ", searchFrom);
+        size_t cut = std::min(andPos, orPos);
+        if (cut == std::string::npos) {
+            break;
+        }
+        size_t between = upper.find(" BETWEEN ", start);
+        if (cut == andPos && between != std::string::npos && between < cut && !betweenClosed) {
+            // The first AND after a BETWEEN is part of it
+            betweenClosed = true;
+            searchFrom = cut + 5;
+            continue;
+        }
+        terms.push_back(text.substr(start, cut - start));
+        start = cut + (cut == andPos ? 5 : 4);
+        searchFrom = start;
+        betweenClosed = false;
+    }
+    terms.push_back(text.substr(start));
+    return terms;
+}
+
+// The indexable column a single predicate filters on, if any
+bool parsePredicate(const std::string& term, std::string& column, PredicateKind& kind) {
+    std::string upper = toUpper(term);
+    size_t keyword;
+    if ((keyword = upper.find(" BETWEEN ")) != std::string::npos) {
+        column = trim(term.substr(0, keyword));
+        kind = PredicateKind::RANGE;
+        return isColumn(column);
+    }
+    if ((keyword = upper.find(" IN ")) != std::string::npos || (keyword = upper.find(" IN(")) != std::string::npos) {
+        column = trim(term.substr(0, keyword));
+        kind = PredicateKind::EQUALITY;
+        return upper.find(" NOT IN") == std::string::npos && isColumn(column);
+    }
+    if ((keyword = upper.find(" LIKE ")) != std::string::npos) {
+        // Only a fixed prefix narrows an ordered index to a range
+        std::string pattern = trim(term.substr(keyword + 6));
+        if (!pattern.empty() && (pattern[0] == '\'' || pattern[0] == '"')) {
+            pattern = pattern.substr(1);
+        }
+        column = trim(term.substr(0, keyword));
+        kind = PredicateKind::RANGE;
+        return !pattern.empty() && pattern[0] != '%' && pattern[0] != '_' && isColumn(column);
+    }
+
+    size_t op = term.find_first_of("<>=!");
+    if (op == std::string::npos) {
+        return false;
+    }
+    size_t opEnd = term.find_first_not_of("<>=!", op);
+    std::string symbol = term.substr(op, opEnd == std::string::npos ? std::string::npos : opEnd - op);
+    if (symbol == "!=" || symbol == "<>") {
+        return false;
+    }
+    std::string left = trim(term.substr(0, op));
+    std::string right = opEnd == std::string::npos ? "" : trim(term.substr(opEnd));
+    if (isColumn(left) == isColumn(right)) {
+        // Two columns (a join) or two constants: nothing to look up
+        return false;
+    }
+    column = isColumn(left) ? left : right;
+    kind = symbol == "=" || symbol == "==" ? PredicateKind::EQUALITY : PredicateKind::RANGE;
+    return true;
+}
+
+const char* typeName(storage::IndexType type) {
+    return type == storage::IndexType::HASH ? "hash" : "B-tree";
+}
+
+} // anonymous namespace
+
+class IndexAdvisor::Impl {
+public:
+    Impl(storage::EnhancedIndexManager* indexManager, EnhancedStatisticsManager* statsManager,
+         const IndexAdvisorConfig& config)
+        : indexManager_(indexManager), statsManager_(statsManager), config_(config),
+          observedQueries_(0), totalSavings_(0.0) {
+        if (config_.sampleInterval == 0) {
+            config_.sampleInterval = 1;
+        }
+    }
+
+    void setScanProvider(ScanProvider provider) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scanProvider_ = std::move(provider);
+    }
+
+    void observeQuery(const ASTNode* ast) {
+        if (auto select = dynamic_cast<const SelectStatement*>(ast)) {
+            if (!select->getTable().empty()) {
+                observeCondition(select->getTable(), select->getWhereClause());
+            }
+            for (const auto& subquery : select->getSubqueries()) {
+                observeQuery(subquery->getSelectStatement());
+            }
+        } else if (auto insert = dynamic_cast<const InsertStatement*>(ast)) {
+            recordWrites(insert->getTable(), insert->getValues().size());
+        } else if (auto update = dynamic_cast<const UpdateStatement*>(ast)) {
+            recordWrites(update->getTable(), 1);
+            observeCondition(update->getTable(), update->getWhereClause());
+        } else if (auto remove = dynamic_cast<const DeleteStatement*>(ast)) {
+            recordWrites(remove->getTable(), 1);
+            observeCondition(remove->getTable(), remove->getWhereClause());
+        }
+    }
+
+    void observeCondition(const std::string& tableName, const std::string& condition) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        double weight = sample();
+        if (weight == 0.0 || trim(condition).empty()) {
+            return;
+        }
+        for (const auto& term : splitConjuncts(condition)) {
+            std::string column;
+            PredicateKind kind;
+            if (parsePredicate(trim(term), column, kind)) {
+                addPredicate(tableName, columnName(column), kind, weight);
+            }
+        }
+    }
+
+    void recordPredicate(const std::string& tableName, const std::string& column, PredicateKind kind) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        double weight = sample();
+        if (weight > 0.0) {
+            addPredicate(tableName, column, kind, weight);
+        }
+    }
+
+    void recordWrites(const std::string& tableName, size_t rows) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        writes_[tableName] += static_cast<double>(rows);
+    }
+
+    std::vector<IndexDecision> recommend() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return recommendLocked();
+    }
+
+    std::vector<IndexDecision> apply() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finishBuilds();
+        std::vector<IndexDecision> applied;
+        for (auto& decision : recommendLocked()) {
+            bool ok;
+            if (decision.action == IndexDecision::Action::DROP) {
+                ok = indexManager_->dropIndex(decision.indexName);
+                if (ok) {
+                    owned_.erase(decision.indexName);
+                    building_.erase(decision.indexName);
+                }
+            } else {
+                ok = createIndex(decision);
+                if (ok) {
+                    owned_[decision.indexName] = decision.estimatedMemory;
+                    building_[decision.indexName] = decision.estimatedSavings;
+                }
+            }
+            if (!ok) {
+                std::cerr << "Index advisor could not " << (decision.action == IndexDecision::Action::DROP ? "drop " : "create ")
+                          << decision.indexName << std::endl;
+                continue;
+            }
+            log(decision);
+            decisionLog_.push_back(decision);
+            applied.push_back(decision);
+        }
+
+        // Age the workload so indexes follow it as it shifts, forgetting
+        // columns it has stopped filtering on
+        for (auto table = usage_.begin(); table != usage_.end();) {
+            for (auto column = table->second.begin(); column != table->second.end();) {
+                column->second.equality *= config_.decay;
+                column->second.range *= config_.decay;
+                if (column->second.equality + column->second.range < FORGET_WEIGHT) {
+                    column = table->second.erase(column);
+                } else {
+                    ++column;
+                }
+            }
+            table = table->second.empty() ? usage_.erase(table) : std::next(table);
+        }
+        for (auto table = writes_.begin(); table != writes_.end();) {
+            table->second *= config_.decay;
+            table = table->second < FORGET_WEIGHT ? writes_.erase(table) : std::next(table);
+        }
+        return applied;
+    }
+
+    std::vector<IndexDecision> getDecisionLog() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return decisionLog_;
+    }
+
+    double getEstimatedSavings() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return totalSavings_;
+    }
+
+    size_t getMemoryUsage() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t total = 0;
+        for (const auto& index : owned_) {
+            total += indexMemory(index.first, index.second);
+        }
+        return total;
+    }
+
+    size_t getObservedQueryCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return observedQueries_;
+    }
+
+private:
+    struct ColumnUsage {
+        double equality = 0.0;  // Sampled predicates, scaled by the sample interval
+        double range = 0.0;
+    };
+
+    // A column weighed by recommend()
+    struct Candidate {
+        IndexDecision decision;
+        bool owned;
+        double predicates;
+    };
+
+    // Weight of this query if it is sampled, 0 otherwise
+    double sample() {
+        observedQueries_++;
+        return observedQueries_ % config_.sampleInterval == 0 ? static_cast<double>(config_.sampleInterval) : 0.0;
+    }
+
+    void addPredicate(const std::string& tableName, const std::string& column, PredicateKind kind, double weight) {
+        ColumnUsage& columnUsage = usage_[tableName][column];
+        (kind == PredicateKind::EQUALITY ? columnUsage.equality : columnUsage.range) += weight;
+    }
+
+    static std::string indexName(const std::string& tableName, const std::string& column) {
+        return tableName + "_" + column + "_idx";
+    }
+
+    bool indexExists(const std::string& name) const {
+        return !indexManager_->getIndexStats(name).indexName.empty();
+    }
+
+    size_t indexMemory(const std::string& name, size_t estimate) const {
+        size_t measured = indexManager_->getIndexStats(name).memoryUsage;
+        return measured > 0 ? measured : estimate;
+    }
+
+    // Weigh one column; false if there are no statistics to go on
+    bool weigh(const std::string& tableName, const std::string& column, const ColumnUsage& columnUsage,
+               IndexDecision& decision) const {
+        auto stats = statsManager_ ? statsManager_->getTableStats(tableName) : nullptr;
+        if (!stats || stats->rowCount == 0) {
+            return false;
+        }
+        double rows = static_cast<double>(stats->rowCount);
+        double selectivity = DEFAULT_SELECTIVITY;
+        auto selectivityIt = stats->columnSelectivities.find(column);
+        auto cardinalityIt = stats->columnCardinalities.find(column);
+        if (selectivityIt != stats->columnSelectivities.end()) {
+            selectivity = selectivityIt->second;
+        } else if (cardinalityIt != stats->columnCardinalities.end() && cardinalityIt->second > 0) {
+            selectivity = 1.0 / static_cast<double>(cardinalityIt->second);
+        }
+
+        // A full scan reads every row; an index descends, then reads the matches
+        double probe = std::log2(rows + 1.0);
+        double equalitySaved = std::max(0.0, rows - (probe + selectivity * rows));
+        double rangeSaved = std::max(0.0, rows - (probe + RANGE_SELECTIVITY * rows));
+
+        auto writesIt = writes_.find(tableName);
+        double writes = writesIt == writes_.end() ? 0.0 : writesIt->second;
+
+        decision.indexName = indexName(tableName, column);
+        decision.tableName = tableName;
+        decision.columnName = column;
+        decision.type = columnUsage.range > 0.0 ? storage::IndexType::B_TREE : storage::IndexType::HASH;
+        decision.estimatedSavings = columnUsage.equality * equalitySaved + columnUsage.range * rangeSaved;
+        decision.maintenanceCost = writes * config_.writeCost;
+        decision.estimatedMemory = static_cast<size_t>(rows) * config_.entryBytes;
+        return true;
+    }
+
+    std::vector<IndexDecision> recommendLocked() const {
+        std::vector<Candidate> candidates;
+        std::vector<IndexDecision> drops;
+
+        // Columns the workload filters on
+        for (const auto& table : usage_) {
+            for (const auto& column : table.second) {
+                Candidate candidate;
+                candidate.predicates = column.second.equality + column.second.range;
+                if (!weigh(table.first, column.first, column.second, candidate.decision)) {
+                    continue;
+                }
+                candidate.owned = owned_.count(candidate.decision.indexName) > 0;
+                if (!candidate.owned && indexExists(candidate.decision.indexName)) {
+                    continue;  // Someone else's index: not ours to weigh
+                }
+                candidates.push_back(candidate);
+            }
+        }
+        // Our indexes the workload no longer filters on at all
+        for (const auto& index : owned_) {
+            bool seen = std::any_of(candidates.begin(), candidates.end(), [&index](const Candidate& candidate) {
+                return candidate.decision.indexName == index.first;
+            });
+            if (!seen) {
+                IndexDecision decision;
+                decision.action = IndexDecision::Action::DROP;
+                decision.indexName = index.first;
+                decision.estimatedMemory = indexMemory(index.first, index.second);
+                decision.reason = "no longer used by sampled queries";
+                drops.push_back(decision);
+            }
+        }
+
+        // Keep what pays for itself; new indexes must clear a higher bar
+        std::vector<Candidate> worthwhile;
+        for (auto& candidate : candidates) {
+            IndexDecision& decision = candidate.decision;
+            if (candidate.owned) {
+                decision.estimatedMemory = indexMemory(decision.indexName, owned_.at(decision.indexName));
+                if (decision.estimatedSavings <= decision.maintenanceCost) {
+                    decision.action = IndexDecision::Action::DROP;
+                    decision.reason = "maintenance cost exceeds savings";
+                    drops.push_back(decision);
+                    continue;
+                }
+            } else if (candidate.predicates < config_.minPredicates ||
+                       decision.estimatedSavings <= decision.maintenanceCost ||
+                       decision.estimatedSavings < config_.minBenefitRatio * decision.maintenanceCost) {
+                continue;
+            }
+            worthwhile.push_back(candidate);
+        }
+
+        // Fill the budget by net savings per byte
+        auto density = [](const Candidate& candidate) {
+            return (candidate.decision.estimatedSavings - candidate.decision.maintenanceCost) /
+                   static_cast<double>(std::max<size_t>(candidate.decision.estimatedMemory, 1));
+        };
+        std::sort(worthwhile.begin(), worthwhile.end(), [&density](const Candidate& a, const Candidate& b) {
+            return density(a) > density(b);
+        });
+        std::vector<IndexDecision> creates;
+        size_t used = 0;
+        for (auto& candidate : worthwhile) {
+            IndexDecision& decision = candidate.decision;
+            bool fits = used + decision.estimatedMemory <= config_.memoryBudget;
+            if (fits) {
+                used += decision.estimatedMemory;
+            }
+            if (candidate.owned && !fits) {
+                decision.action = IndexDecision::Action::DROP;
+                decision.reason = "evicted for indexes saving more per byte";
+                drops.push_back(decision);
+            } else if (!candidate.owned && fits) {
+                decision.action = IndexDecision::Action::CREATE;
+                decision.reason = std::to_string(static_cast<size_t>(candidate.predicates)) +
+                                  " sampled predicates on " + decision.columnName;
+                creates.push_back(decision);
+            }
+        }
+
+        drops.insert(drops.end(), creates.begin(), creates.end());
+        return drops;
+    }
+
+    // Switch the online builds it started that have caught up into use,
+    // counting their savings only once they serve lookups, and drop any
+    // whose scan failed
+    void finishBuilds() {
+        for (auto build = building_.begin(); build != building_.end();) {
+            if (indexManager_->finishIndexBuild(build->first)) {
+                totalSavings_ += build->second;
+            } else if (indexManager_->getIndexStats(build->first).buildPhase == storage::IndexBuildPhase::FAILED) {
+                std::cerr << "Index advisor dropping " << build->first << " after its build failed" << std::endl;
+                indexManager_->dropIndex(build->first);
+                owned_.erase(build->first);
+            } else {
+                ++build;
+                continue;
+            }
+            build = building_.erase(build);
+        }
+    }
+
+    bool createIndex(const IndexDecision& decision) {
+        if (!scanProvider_) {
+            std::cerr << "Index advisor has no scan provider to build " << decision.indexName << std::endl;
+            return false;
+        }
+        auto stats = statsManager_->getTableStats(decision.tableName);
+        return indexManager_->createIndexOnline(decision.tableName, decision.columnName, decision.type,
+                                                config_.indexConfig,
+                                                scanProvider_(decision.tableName, decision.columnName), 0,
+                                                stats ? stats->rowCount : 0);
+    }
+
+    void log(const IndexDecision& decision) const {
+        if (decision.action == IndexDecision::Action::CREATE) {
+            std::cout << "Index advisor: created " << typeName(decision.type) << " index " << decision.indexName
+                      << " (" << decision.reason << "); estimated savings " << decision.estimatedSavings
+                      << " row reads against " << decision.maintenanceCost << " for maintenance, "
+                      << decision.estimatedMemory << " bytes" << std::endl;
+        } else {
+            std::cout << "Index advisor: dropped index " << decision.indexName << " (" << decision.reason
+                      << "); estimated savings " << decision.estimatedSavings << " row reads against "
+                      << decision.maintenanceCost << " for maintenance, " << decision.estimatedMemory
+                      << " bytes freed" << std::endl;
+        }
+    }
+
+    storage::EnhancedIndexManager* indexManager_;
+    EnhancedStatisticsManager* statsManager_;
+    IndexAdvisorConfig config_;
+    ScanProvider scanProvider_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::unordered_map<std::string, ColumnUsage>> usage_;
+    std::unordered_map<std::string, double> writes_;
+    std::unordered_map<std::string, size_t> owned_;  // Indexes it created, with their estimated size
+    std::unordered_map<std::string, double> building_;  // Owned indexes still building, with their estimated savings
+    std::vector<IndexDecision> decisionLog_;
+    size_t observedQueries_;
+    double totalSavings_;
+};
+
+IndexAdvisor::IndexAdvisor(storage::EnhancedIndexManager* indexManager, EnhancedStatisticsManager* statsManager,
+                           const IndexAdvisorConfig& config)
+    : pImpl(std::make_unique<Impl>(indexManager, statsManager, config)) {}
+
+IndexAdvisor::~IndexAdvisor() = default;
+
+void IndexAdvisor::setScanProvider(ScanProvider provider) {
+    pImpl->setScanProvider(std::move(provider));
+}
+
+void IndexAdvisor::observeQuery(const ASTNode* ast) {
+    pImpl->observeQuery(ast);
+}
+
+void IndexAdvisor::observeCondition(const std::string& tableName, const std::string& condition) {
+    pImpl->observeCondition(tableName, condition);
+}
+
+void IndexAdvisor::recordPredicate(const std::string& tableName, const std::string& columnName, PredicateKind kind) {
+    pImpl->recordPredicate(tableName, columnName, kind);
+}
+
+void IndexAdvisor::recordWrites(const std::string& tableName, size_t rows) {
+    pImpl->recordWrites(tableName, rows);
+}
+
+std::vector<IndexDecision> IndexAdvisor::recommend() const {
+    return pImpl->recommend();
+}
+
+std::vector<IndexDecision> IndexAdvisor::apply() {
+    return pImpl->apply();
+}
+
+std::vector<IndexDecision> IndexAdvisor::getDecisionLog() const {
+    return pImpl->getDecisionLog();
+}
+
+double IndexAdvisor::getEstimatedSavings() const {
+    return pImpl->getEstimatedSavings();
+}
+
+size_t IndexAdvisor::getMemoryUsage() const {
+    return pImpl->getMemoryUsage();
+}
+
+size_t IndexAdvisor::getObservedQueryCount() const {
+    return pImpl->getObservedQueryCount();
+}
+
+} // namespace query
+} // namespace phantomdb
@@ -0,0 +1,143 @@
+#ifndef PHANTOMDB_INDEX_ADVISOR_H
+#define PHANTOMDB_INDEX_ADVISOR_H
+
+#include "enhanced_query_planner.h"
+#include "../storage/enhanced_index_manager.h"
+#include <string>
+#include <memory>
+#include <vector>
+#include <functional>
+
+namespace phantomdb {
+namespace query {
+
+class ASTNode;
+
+// How a sampled predicate uses its column
+enum class PredicateKind {
+    EQUALITY,  // column = value, column IN (...)
+    RANGE      // column < value, column BETWEEN a AND b, ...
+};
+
+// Tuning knobs for the index advisor
+struct IndexAdvisorConfig {
+    size_t memoryBudget = 64 * 1024 * 1024;  // Bytes all advisor-created indexes may use
+    size_t sampleInterval = 1;    // Sample one query in this many
+    double minPredicates = 10;    // Sampled predicates on a column before it is considered
+    double minBenefitRatio = 2.0; // Savings must exceed maintenance cost by this factor to create
+    double writeCost = 20.0;      // Row reads one index entry update costs
+    size_t entryBytes = 64;       // Index bytes per row when the index does not exist yet
+    double decay = 0.5;           // Share of the observed workload kept after each apply
+    storage::IndexConfig indexConfig;  // Configuration of the indexes it creates
+};
+
+// One create or drop the advisor recommends
+struct IndexDecision {
+    enum class Action {
+        CREATE,
+        DROP
+    };
+
+    Action action;
+    std::string indexName;
+    std::string tableName;
+    std::string columnName;
+    storage::IndexType type;
+    double estimatedSavings;  // Row reads the index saves over the observed workload
+    double maintenanceCost;   // Row-read equivalents spent keeping it up to date
+    size_t estimatedMemory;   // Bytes the index takes (or frees)
+    std::string reason;
+
+    IndexDecision()
+        : action(Action::CREATE), type(storage::IndexType::B_TREE), estimatedSavings(0.0),
+          maintenanceCost(0.0), estimatedMemory(0) {}
+};
+
+/**
+ * Workload-driven index advisor. Executed queries are sampled for the
+ * columns their predicates filter on, and writes are counted per table.
+ * recommend() weighs, for each column, the row reads an index would have
+ * saved the sampled queries against the cost of keeping it up to date
+ * under the observed writes, using row counts and column selectivities from
+ * EnhancedStatisticsManager; apply() carries the decisions out, keeping the
+ * indexes it creates within a memory budget and dropping them again when
+ * the workload no longer pays for them. Indexes it did not create are
+ * never dropped. Safe to call from concurrent query threads.
+ */
+class IndexAdvisor {
+public:
+    // Reads the snapshot for an advisor-created index on (table, column)
+    using ScanProvider = std::function<storage::IndexBuildScan(const std::string& tableName,
+                                                               const std::string& columnName)>;
+
+    IndexAdvisor(storage::EnhancedIndexManager* indexManager, EnhancedStatisticsManager* statsManager,
+                 const IndexAdvisorConfig& config = IndexAdvisorConfig{});
+    ~IndexAdvisor();
+
+    /**
+     * @brief Build indexes the advisor creates online from this scan
+     *
+     * Without one apply() creates nothing: an empty index would be ready
+     * for lookups and miss every existing row.
+     */
+    void setScanProvider(ScanProvider provider);
+
+    /**
+     * @brief Record an executed statement: the WHERE clause of a SELECT
+     *        (and of its subqueries), UPDATE or DELETE, and its writes
+     *        (each row of an INSERT, one per UPDATE or DELETE)
+     *
+     * QueryProcessor calls this for every statement it executes once an
+     * advisor is attached with setIndexAdvisor.
+     */
+    void observeQuery(const ASTNode* ast);
+
+    // Record the WHERE clause of an executed query on tableName
+    void observeCondition(const std::string& tableName, const std::string& condition);
+
+    // Record one predicate directly (counts toward sampling like a query)
+    void recordPredicate(const std::string& tableName, const std::string& columnName, PredicateKind kind);
+
+    // Record rows written to a table; each costs an update of every index on it
+    void recordWrites(const std::string& tableName, size_t rows = 1);
+
+    /**
+     * @brief Weigh the observed workload without changing anything
+     *
+     * @return Drops first, then creates in order of net savings per byte
+     */
+    std::vector<IndexDecision> recommend() const;
+
+    /**
+     * @brief Carry out recommend(), log each decision and age the
+     *        observed workload by config.decay
+     *
+     * Indexes are created with online builds; each call first switches
+     * the builds earlier calls started into use once they have caught up.
+     *
+     * @return The decisions that were carried out
+     */
+    std::vector<IndexDecision> apply();
+
+    // Every decision apply() has carried out, oldest first
+    std::vector<IndexDecision> getDecisionLog() const;
+
+    // Row reads the indexes it created were estimated to save, summed over
+    // those whose builds have finished
+    double getEstimatedSavings() const;
+
+    // Bytes its indexes currently take
+    size_t getMemoryUsage() const;
+
+    // Conditions and predicates offered for sampling (sampled or not)
+    size_t getObservedQueryCount() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace query
+} // namespace phantomdb
+
+#endif // PHANTOMDB_INDEX_ADVISOR_H
@@ -0,0 +1,350 @@
+#include "index_advisor.h"
+#include "sql_parser.h"
+#include "query_processor.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+using namespace phantomdb::query;
+using phantomdb::storage::EnhancedIndexManager;
+using phantomdb::storage::IndexType;
+using phantomdb::storage::IndexBuildPhase;
+
+namespace {
+
+// orders: 50,000 rows, user_id nearly unique, status with 4 values
+void loadStats(EnhancedStatisticsManager& stats) {
+    stats.updateTableStats("orders", 50000, 200);
+    stats.updateColumnStats("orders", "user_id", 8000, 0.000125);
+    stats.updateColumnStats("orders", "created_at", 40000, 0.000025);
+    stats.updateColumnStats("orders", "status", 4, 0.25);
+    stats.updateTableStats("events", 20000, 100);
+    stats.updateColumnStats("events", "session_id", 20000, 0.00005);
+}
+
+// Wait for an online build's scan to finish without switching the index
+// into use, leaving that to the advisor
+void waitForScan(const EnhancedIndexManager& indexes, const std::string& indexName) {
+    while (indexes.getIndexStats(indexName).buildPhase == IndexBuildPhase::SCANNING) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // With no writes to catch up on, the worker finishes right after
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+const IndexDecision* findDecision(const std::vector<IndexDecision>& decisions, const std::string& indexName) {
+    for (const auto& decision : decisions) {
+        if (decision.indexName == indexName) {
+            return &decision;
+        }
+    }
+    return nullptr;
+}
+
+} // anonymous namespace
+
+void testRecommendations() {
+    std::cout << "Testing index recommendations..." << std::endl;
+
+    EnhancedStatisticsManager stats;
+    EnhancedIndexManager indexes;
+    loadStats(stats);
+    IndexAdvisor advisor(&indexes, &stats);
+
+    // Too few samples to act on
+    advisor.observeCondition("orders", "user_id = 17");
+    assert(advisor.recommend().empty());
+
+    for (int i = 0; i < 20; ++i) {
+        advisor.observeCondition("orders", "o.user_id = " + std::to_string(i) +
+                                           " AND created_at BETWEEN '2024-01-01' AND '2024-02-01'"
+                                           " AND status <> 'open'");
+    }
+    // Unindexable conditions are ignored
+    for (int i = 0; i < 20; ++i) {
+        advisor.observeCondition("orders", "user_id = customer_id OR status LIKE '%ship%' OR status IS NULL");
+    }
+    assert(advisor.getObservedQueryCount() == 41);
+
+    auto decisions = advisor.recommend();
+    assert(decisions.size() == 2);
+    const IndexDecision* userId = findDecision(decisions, "orders_user_id_idx");
+    const IndexDecision* createdAt = findDecision(decisions, "orders_created_at_idx");
+    assert(userId && createdAt && !findDecision(decisions, "orders_status_idx"));
+
+    // Equality lookups get a hash index, ranges a B-tree
+    assert(userId->action == IndexDecision::Action::CREATE && userId->type == IndexType::HASH);
+    assert(createdAt->action == IndexDecision::Action::CREATE && createdAt->type == IndexType::B_TREE);
+
+    // An equality match reads a handful of rows instead of 50,000
+    assert(userId->estimatedSavings > 21 * 49000.0 && userId->maintenanceCost == 0.0);
+    assert(createdAt->estimatedSavings > 20 * 30000.0 && createdAt->estimatedSavings < 20 * 34000.0);
+
+    // The most savings per byte comes first
+    assert(decisions.front().indexName == "orders_user_id_idx");
+
+    // Nothing changes until apply
+    assert(indexes.getIndexStats("orders_user_id_idx").indexName.empty());
+
+    std::cout << "Index recommendations test passed!" << std::endl;
+}
+
+void testMaintenanceCost() {
+    std::cout << "Testing maintenance cost..." << std::endl;
+
+    EnhancedStatisticsManager stats;
+    EnhancedIndexManager indexes;
+    loadStats(stats);
+    IndexAdvisor advisor(&indexes, &stats);
+
+    // A write-heavy table: 20 lookups save ~400,000 row reads, while
+    // 100,000 inserts would cost 2,000,000 to index
+    for (int i = 0; i < 20; ++i) {
+        advisor.recordPredicate("events", "session_id", PredicateKind::EQUALITY);
+    }
+    advisor.recordWrites("events", 100000);
+    assert(advisor.recommend().empty());
+
+    // Savings must clear minBenefitRatio times the cost, not just the cost
+    IndexAdvisor balanced(&indexes, &stats);
+    for (int i = 0; i < 20; ++i) {
+        balanced.recordPredicate("events", "session_id", PredicateKind::EQUALITY);
+    }
+    balanced.recordWrites("events", 15000);
+    assert(balanced.recommend().empty());
+    balanced.recordWrites("events", 0);
+    for (int i = 0; i < 20; ++i) {
+        balanced.recordPredicate("events", "session_id", PredicateKind::EQUALITY);
+    }
+    auto decisions = balanced.recommend();
+    assert(decisions.size() == 1 && decisions[0].maintenanceCost == 15000 * 20.0);
+
+    // Tables without statistics are left alone
+    for (int i = 0; i < 50; ++i) {
+        balanced.observeCondition("unknown", "id = 1");
+    }
+    assert(balanced.recommend().size() == 1);
+
+    std::cout << "Maintenance cost test passed!" << std::endl;
+}
+
+void testMemoryBudget() {
+    std::cout << "Testing memory budget..." << std::endl;
+
+    EnhancedStatisticsManager stats;
+    EnhancedIndexManager indexes;
+    loadStats(stats);
+
+    // Room for one 50,000-row index at 64 bytes per entry
+    IndexAdvisorConfig config;
+    config.memoryBudget = 4 * 1024 * 1024;
+    IndexAdvisor advisor(&indexes, &stats, config);
+    for (int i = 0; i < 20; ++i) {
+        advisor.observeCondition("orders", "created_at > '2024-01-01' AND user_id = 3");
+    }
+    auto decisions = advisor.recommend();
+    assert(decisions.size() == 1 && decisions[0].indexName == "orders_user_id_idx");
+    assert(decisions[0].estimatedMemory == 50000 * config.entryBytes);
+
+    std::cout << "Memory budget test passed!" << std::endl;
+}
+
+void testApplyAndDrop() {
+    std::cout << "Testing applying and dropping indexes..." << std::endl;
+
+    EnhancedStatisticsManager stats;
+    EnhancedIndexManager indexes;
+    assert(indexes.initialize());
+    loadStats(stats);
+
+    // Someone else's index on a column the workload also filters on
+    assert(indexes.createIndex("orders", "status", IndexType::BITMAP));
+
+    // Indexes are built online from the table scan
+    IndexAdvisor advisor(&indexes, &stats);
+    advisor.setScanProvider([](const std::string& tableName, const std::string& columnName) {
+        assert(tableName == "orders" && columnName == "user_id");
+        return [](size_t partition, size_t partitionCount,
+                  const std::function<void(const std::string&, const std::string&)>& emit) {
+            for (size_t row = partition; row < 1000; row += partitionCount) {
+                emit("user-" + std::to_string(row), "row-" + std::to_string(row));
+            }
+        };
+    });
+    for (int i = 0; i < 20; ++i) {
+        advisor.observeCondition("orders", "user_id IN (1, 2, 3) AND status = 'open'");
+    }
+    auto applied = advisor.apply();
+    assert(applied.size() == 1 && applied[0].indexName == "orders_user_id_idx");
+
+    // Until the build finishes the index serves nothing and saves nothing
+    assert(!indexes.isIndexReady("orders_user_id_idx"));
+    assert(advisor.getEstimatedSavings() == 0.0);
+    waitForScan(indexes, "orders_user_id_idx");
+
+    // A still-useful index is kept, and the next apply switches it into use
+    for (int i = 0; i < 20; ++i) {
+        advisor.observeCondition("orders", "user_id = 5");
+    }
+    assert(advisor.apply().empty());
+    assert(indexes.isIndexReady("orders_user_id_idx"));
+    std::string value;
+    assert(indexes.searchInIndex("orders_user_id_idx", "user-42", value) && value == "row-42");
+    assert(indexes.getIndexType("orders_user_id_idx") == IndexType::HASH);
+    assert(advisor.getEstimatedSavings() == applied[0].estimatedSavings);
+    assert(advisor.getMemoryUsage() == indexes.getIndexStats("orders_user_id_idx").memoryUsage);
+
+    // Once writes dominate it is dropped; the other index is never touched
+    advisor.recordWrites("orders", 1000000);
+    applied = advisor.apply();
+    assert(applied.size() == 1 && applied[0].action == IndexDecision::Action::DROP);
+    assert(applied[0].reason == "maintenance cost exceeds savings");
+    assert(indexes.getIndexStats("orders_user_id_idx").indexName.empty());
+    assert(!indexes.getIndexStats("orders_status_idx").indexName.empty());
+    assert(advisor.getMemoryUsage() == 0);
+
+    // The log keeps every decision in order
+    auto log = advisor.getDecisionLog();
+    assert(log.size() == 2);
+    assert(log[0].action == IndexDecision::Action::CREATE && log[1].action == IndexDecision::Action::DROP);
+
+    std::cout << "Apply and drop test passed!" << std::endl;
+}
+
+void testUnusedIndexesDropped() {
+    std::cout << "Testing unused indexes are dropped..." << std::endl;
+
+    EnhancedStatisticsManager stats;
+    EnhancedIndexManager indexes;
+    loadStats(stats);
+
+    // Without a scan provider nothing is created: an empty index would
+    // be ready and miss every existing row
+    IndexAdvisor unbuildable(&indexes, &stats);
+    for (int i = 0; i < 20; ++i) {
+        unbuildable.recordPredicate("orders", "created_at", PredicateKind::RANGE);
+    }
+    assert(unbuildable.recommend().size() == 1);
+    assert(unbuildable.apply().empty() && unbuildable.getDecisionLog().empty());
+    assert(indexes.getIndexStats("orders_created_at_idx").indexName.empty());
+
+    IndexAdvisor advisor(&indexes, &stats);
+    advisor.setScanProvider([](const std::string&, const std::string&) {
+        return [](size_t, size_t, const std::function<void(const std::string&, const std::string&)>&) {};
+    });
+    for (int i = 0; i < 20; ++i) {
+        advisor.recordPredicate("orders", "created_at", PredicateKind::RANGE);
+    }
+    assert(advisor.apply().size() == 1);
+    waitForScan(indexes, "orders_created_at_idx");
+
+    // Decay fades the workload that asked for it until it is forgotten
+    for (int i = 0; i < 5; ++i) {
+        assert(advisor.apply().empty());
+        assert(indexes.isIndexReady("orders_created_at_idx"));
+    }
+    assert(indexes.getIndexType("orders_created_at_idx") == IndexType::B_TREE);
+    auto applied = advisor.apply();
+    assert(applied.size() == 1 && applied[0].action == IndexDecision::Action::DROP);
+    assert(applied[0].reason == "no longer used by sampled queries");
+    assert(indexes.getIndexStats("orders_created_at_idx").indexName.empty());
+
+    std::cout << "Unused indexes test passed!" << std::endl;
+}
+
+void testSamplingAndStatements() {
+    std::cout << "Testing sampling and statements..." << std::endl;
+
+    EnhancedStatisticsManager stats;
+    EnhancedIndexManager indexes;
+    loadStats(stats);
+
+    // One query in four is sampled and counted four times
+    IndexAdvisorConfig config;
+    config.sampleInterval = 4;
+    IndexAdvisor sampled(&indexes, &stats, config);
+    for (int i = 0; i < 9; ++i) {
+        sampled.recordPredicate("orders", "user_id", PredicateKind::EQUALITY);
+    }
+    assert(sampled.recommend().empty());  // 8 of 10 needed
+    for (int i = 0; i < 3; ++i) {
+        sampled.recordPredicate("orders", "user_id", PredicateKind::EQUALITY);
+    }
+    assert(sampled.getObservedQueryCount() == 12);
+    auto decisions = sampled.recommend();
+    assert(decisions.size() == 1 && decisions[0].reason == "12 sampled predicates on user_id");
+
+    // Parsed UPDATE and DELETE statements contribute predicates and writes
+    SQLParser parser;
+    std::string errorMsg;
+    IndexAdvisor advisor(&indexes, &stats);
+    for (int i = 0; i < 10; ++i) {
+        auto update = parser.parse("UPDATE orders SET status = 'shipped' WHERE user_id = 7;", errorMsg);
+        assert(update != nullptr);
+        advisor.observeQuery(update.get());
+    }
+    auto insert = parser.parse("INSERT INTO orders (user_id, status) VALUES (1, 'open');", errorMsg);
+    assert(insert != nullptr);
+    advisor.observeQuery(insert.get());
+    decisions = advisor.recommend();
+    assert(decisions.size() == 1 && decisions[0].indexName == "orders_user_id_idx");
+    assert(decisions[0].maintenanceCost == 11 * 20.0);
+
+    std::cout << "Sampling and statements test passed!" << std::endl;
+}
+
+void testQueryProcessorHook() {
+    std::cout << "Testing the query processor hook..." << std::endl;
+
+    EnhancedStatisticsManager stats;
+    EnhancedIndexManager indexes;
+    loadStats(stats);
+    IndexAdvisor advisor(&indexes, &stats);
+
+    // Executed SELECTs (subqueries included), UPDATEs and DELETEs feed the advisor
+    QueryProcessor processor;
+    assert(processor.initialize());
+    processor.setIndexAdvisor(&advisor);
+    std::vector<std::vector<std::string>> results;
+    std::string errorMsg;
+    for (int i = 0; i < 5; ++i) {
+        assert(processor.executeQuery("SELECT * FROM orders WHERE user_id = " + std::to_string(i) + ";",
+                                      results, errorMsg));
+        assert(processor.executeQuery("SELECT id FROM (SELECT id, user_id FROM orders WHERE user_id = 3) AS o",
+                                      results, errorMsg));
+    }
+    assert(processor.executeQuery("UPDATE orders SET status = 'shipped' WHERE user_id = 9;", results, errorMsg));
+    assert(processor.executeQuery("DELETE FROM orders WHERE created_at < '2020-01-01';", results, errorMsg));
+    assert(advisor.getObservedQueryCount() == 12);
+
+    auto decisions = advisor.recommend();
+    assert(decisions.size() == 1 && decisions[0].indexName == "orders_user_id_idx");
+    assert(decisions[0].reason == "11 sampled predicates on user_id");
+    assert(decisions[0].maintenanceCost == 2 * 20.0);
+
+    // Detached, statements are no longer observed
+    processor.setIndexAdvisor(nullptr);
+    assert(processor.executeQuery("SELECT * FROM orders WHERE user_id = 1;", results, errorMsg));
+    assert(advisor.getObservedQueryCount() == 12);
+    processor.shutdown();
+
+    std::cout << "Query processor hook test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running index advisor tests..." << std::endl;
+
+    testRecommendations();
+    testMaintenanceCost();
+    testMemoryBudget();
+    testApplyAndDrop();
+    testUnusedIndexesDropped();
+    testSamplingAndStatements();
+    testQueryProcessorHook();
+
+    std::cout << "All index advisor tests passed!" << std::endl;
+    return 0;
+}
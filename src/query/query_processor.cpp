@@ -3,6 +3,7 @@
 #include "query_planner.h"
 #include "query_optimizer.h"
 #include "execution_engine.h"
+#include "index_advisor.h"
 #include <iostream>
 #include <string>
 
@@ -11,7 +12,7 @@ namespace query {
 
 class QueryProcessor::Impl {
 public:
-    Impl() = default;
+    Impl() : indexAdvisor_(nullptr) {}
     ~Impl() = default;
     
     bool initialize() {
@@ -119,7 +120,19 @@ public:
         auto transaction = std::make_shared<transaction::Transaction>(1, transaction::IsolationLevel::READ_COMMITTED);
         
         // Execute the plan using the execution engine
-        return executionEngine_->executePlan(std::move(optimizedPlan), transaction, results, errorMsg);
+        if (!executionEngine_->executePlan(std::move(optimizedPlan), transaction, results, errorMsg)) {
+            return false;
+        }
+        
+        // Let the index advisor sample the workload
+        if (indexAdvisor_) {
+            indexAdvisor_->observeQuery(ast.get());
+        }
+        return true;
+    }
+    
+    void setIndexAdvisor(IndexAdvisor* advisor) {
+        indexAdvisor_ = advisor;
     }
     
 private:
@@ -128,6 +141,7 @@ private:
     std::unique_ptr<QueryOptimizer> optimizer_;
     std::unique_ptr<ExecutionEngine> executionEngine_;
     std::unique_ptr<ASTNode> lastAST_;
+    IndexAdvisor* indexAdvisor_;
 };
 
 QueryProcessor::QueryProcessor() : pImpl(std::make_unique<Impl>()) {
@@ -158,5 +172,9 @@ bool QueryProcessor::executeQuery(const std::string& sql, std::vector<std::vecto
     return pImpl->executeQuery(sql, results, errorMsg);
 }
 
+void QueryProcessor::setIndexAdvisor(IndexAdvisor* advisor) {
+    pImpl->setIndexAdvisor(advisor);
+}
+
 } // namespace query
 } // namespace phantomdb
\ No newline at end of file
@@ -9,6 +9,8 @@
 namespace phantomdb {
 namespace query {
 
+class IndexAdvisor;
+
 class QueryProcessor {
 public:
     QueryProcessor();
@@ -29,6 +31,9 @@ public:
     // Execute a query and return results
     bool executeQuery(const std::string& sql, std::vector<std::vector<std::string>>& results, std::string& errorMsg);
     
+    // Report every executed statement to an index advisor (nullptr to stop)
+    void setIndexAdvisor(IndexAdvisor* advisor);
+    
 private:
     class Impl;
     std::unique_ptr<Impl> pImpl;
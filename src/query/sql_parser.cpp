@@ -36,6 +36,10 @@ std::string SelectStatement::toString() const {
         oss << " " << subquery->toString();
     }
     
+    if (!whereClause_.empty()) {
+        oss << " WHERE " << whereClause_;
+    }
+    
     return oss.str();
 }
 
@@ -63,6 +67,14 @@ void SelectStatement::addSubquery(std::unique_ptr<Subquery> subquery) {
     subqueries_.push_back(std::move(subquery));
 }
 
+const std::string& SelectStatement::getWhereClause() const {
+    return whereClause_;
+}
+
+void SelectStatement::setWhereClause(std::string whereClause) {
+    whereClause_ = std::move(whereClause);
+}
+
 // Subquery implementation
 Subquery::Subquery(std::unique_ptr<SelectStatement> selectStmt, std::string alias)
     : selectStmt_(std::move(selectStmt)), alias_(std::move(alias)) {}
@@ -555,6 +567,28 @@ private:
             }
         }
         
+        // Parse WHERE clause (optional)
+        if (token.type == TokenType::WHERE) {
+            // Capture the rest of the statement, stopping at the parenthesis
+            // that closes a subquery
+            std::string whereClause;
+            int depth = 0;
+            while (position_ < sql_.length() && sql_[position_] != ';') {
+                if (sql_[position_] == '(') {
+                    depth++;
+                } else if (sql_[position_] == ')' && depth-- == 0) {
+                    break;
+                }
+                whereClause += sql_[position_];
+                position_++;
+            }
+            
+            // Trim whitespace from the condition
+            whereClause.erase(0, whereClause.find_first_not_of(" \t\n\r"));
+            whereClause.erase(whereClause.find_last_not_of(" \t\n\r") + 1);
+            selectStmt->setWhereClause(std::move(whereClause));
+        }
+        
         // Return the SELECT statement AST node
         return std::move(selectStmt);
     }
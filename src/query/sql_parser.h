@@ -109,15 +109,18 @@ public:
     const std::string& getTable() const;
     const std::vector<JoinClause>& getJoins() const;
     const std::vector<std::unique_ptr<Subquery>>& getSubqueries() const;
+    const std::string& getWhereClause() const;
     
     void addJoin(const JoinClause& join);
     void addSubquery(std::unique_ptr<Subquery> subquery);
+    void setWhereClause(std::string whereClause);
     
 private:
     std::vector<std::string> columns_;
     std::string table_;
     std::vector<JoinClause> joins_;
     std::vector<std::unique_ptr<Subquery>> subqueries_;
+    std::string whereClause_;
 };
 
 // Subquery structure
@@ -0,0 +1,90 @@
+#include "bitmap_index.h"
+
+namespace phantomdb {
+namespace storage {
+
+BitmapIndex::BitmapIndex() = default;
+
+BitmapIndex::~BitmapIndex() = default;
+
+bool BitmapIndex::insert(const std::string& value, uint32_t rowId) {
+    return bitmaps_[value].add(rowId);
+}
+
+bool BitmapIndex::remove(const std::string& value, uint32_t rowId) {
+    auto it = bitmaps_.find(value);
+    if (it == bitmaps_.end() || !it->second.remove(rowId)) {
+        return false;
+    }
+    if (it->second.isEmpty()) {
+        bitmaps_.erase(it);
+    }
+    return true;
+}
+
+bool BitmapIndex::removeValue(const std::string& value) {
+    return bitmaps_.erase(value) == 1;
+}
+
+const RoaringBitmap* BitmapIndex::find(const std::string& value) const {
+    auto it = bitmaps_.find(value);
+    return it == bitmaps_.end() ? nullptr : &it->second;
+}
+
+RoaringBitmap BitmapIndex::matchAny(const std::vector<std::string>& values) const {
+    RoaringBitmap result;
+    for (const auto& value : values) {
+        const RoaringBitmap* rows = find(value);
+        if (rows != nullptr) {
+            result = result.isEmpty() ? *rows : result.unite(*rows);
+        }
+    }
+    return result;
+}
+
+RoaringBitmap BitmapIndex::allRows() const {
+    RoaringBitmap result;
+    for (const auto& entry : bitmaps_) {
+        result = result.isEmpty() ? entry.second : result.unite(entry.second);
+    }
+    return result;
+}
+
+uint64_t BitmapIndex::estimateAny(const std::vector<std::string>& values) const {
+    // Bitmaps of distinct values are disjoint when each row has one value
+    uint64_t count = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        bool repeated = false;
+        for (size_t j = 0; j < i && !repeated; ++j) {
+            repeated = values[j] == values[i];
+        }
+        const RoaringBitmap* rows = find(values[i]);
+        if (rows != nullptr && !repeated) {
+            count += rows->cardinality();
+        }
+    }
+    return count;
+}
+
+size_t BitmapIndex::getDistinctValues() const {
+    return bitmaps_.size();
+}
+
+size_t BitmapIndex::runOptimize() {
+    size_t runContainers = 0;
+    for (auto& entry : bitmaps_) {
+        runContainers += entry.second.runOptimize();
+    }
+    return runContainers;
+}
+
+size_t BitmapIndex::getMemoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& entry : bitmaps_) {
+        bytes += entry.first.capacity() + sizeof(entry) + entry.second.getMemoryUsage();
+    }
+    return bytes;
+}
+
+} // namespace storage
+} // namespace phantomdb
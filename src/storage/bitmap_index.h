@@ -0,0 +1,60 @@
+#ifndef PHANTOMDB_BITMAP_INDEX_H
+#define PHANTOMDB_BITMAP_INDEX_H
+
+#include "roaring_bitmap.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * Bitmap index over one column: a Roaring bitmap of row ids per distinct
+ * column value. Meant for low-cardinality columns (status, region, flags),
+ * where a predicate is answered by combining a few bitmaps instead of
+ * checking every row.
+ */
+class BitmapIndex {
+public:
+    BitmapIndex();
+    ~BitmapIndex();
+    
+    // Record that row rowId has the given column value; false if already recorded
+    bool insert(const std::string& value, uint32_t rowId);
+    
+    // Forget one row of a value; false if it was not recorded
+    bool remove(const std::string& value, uint32_t rowId);
+    
+    // Forget every row of a value; false if there were none
+    bool removeValue(const std::string& value);
+    
+    // The rows with a value, or null if there are none
+    const RoaringBitmap* find(const std::string& value) const;
+    
+    // Rows with any of the values (column IN (...))
+    RoaringBitmap matchAny(const std::vector<std::string>& values) const;
+    
+    // Rows with any value at all
+    RoaringBitmap allRows() const;
+    
+    // Estimated size of matchAny(values) from the stored cardinalities,
+    // exact while each row has one value, as rows of a column do
+    uint64_t estimateAny(const std::vector<std::string>& values) const;
+    
+    size_t getDistinctValues() const;
+    
+    // Store runs of consecutive row ids compactly; returns the run containers
+    size_t runOptimize();
+    
+    size_t getMemoryUsage() const;
+
+private:
+    std::unordered_map<std::string, RoaringBitmap> bitmaps_;
+};
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_BITMAP_INDEX_H
@@ -0,0 +1,1036 @@
+#ifndef PHANTOMDB_BPLUS_TREE_H
+#define PHANTOMDB_BPLUS_TREE_H
+
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <iterator>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * @brief Fixed-size object pool for tree nodes
+ * 
+ * Objects are carved out of slabs of SLAB_OBJECTS and recycled through a
+ * free list, so a tree makes one allocation per slab instead of one per
+ * node. The pool only releases memory: objects still alive when it is
+ * destroyed are not destructed.
+ */
+template<typename T>
+class NodePool {
+public:
+    static const size_t SLAB_OBJECTS = 64;
+    
+    NodePool() : free_(nullptr), slabUsed_(SLAB_OBJECTS), liveObjects_(0) {}
+    
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+    
+    template<typename... Args>
+    T* create(Args&&... args) {
+        Slot* slot = free_;
+        if (slot != nullptr) {
+            free_ = slot->next;
+        } else {
+            if (slabUsed_ == SLAB_OBJECTS) {
+                slabs_.emplace_back(new Slot[SLAB_OBJECTS]);
+                slabUsed_ = 0;
+            }
+            slot = &slabs_.back()[slabUsed_++];
+        }
+        liveObjects_++;
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+    
+    void destroy(T* object) {
+        object->~T();
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->next = free_;
+        free_ = slot;
+        liveObjects_--;
+    }
+    
+    // Bytes held in slabs, free slots included
+    size_t getMemoryUsage() const {
+        return slabs_.size() * SLAB_OBJECTS * sizeof(Slot);
+    }
+    
+    size_t getLiveObjects() const {
+        return liveObjects_;
+    }
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+    
+    std::vector<std::unique_ptr<Slot[]>> slabs_;
+    Slot* free_;
+    size_t slabUsed_;
+    size_t liveObjects_;
+};
+
+/**
+ * @brief In-memory B+tree with page-sized nodes
+ * 
+ * Inner nodes hold only separator keys and child pointers, so a 4 KB node
+ * fans out to hundreds of children for integer keys and the tree stays a
+ * few levels deep. Values live in the leaves, which are linked in both
+ * directions for ordered scans. Keys and values are stored in flat arrays
+ * inside each node, nodes come from a NodePool, and nodes refer to each
+ * other by plain pointers, so a lookup is a handful of cache misses and
+ * no reference counting.
+ * 
+ * Within a node, a branch-free binary search narrows the range and a
+ * short linear count (vectorized by the compiler for arithmetic keys)
+ * finishes it. Keys are unique: inserting an existing key replaces its
+ * value. Cursors walk the leaf chain in either direction. Not thread safe.
+ */
+template<typename Key, typename Value>
+class BPlusTree {
+private:
+    struct Leaf;
+
+public:
+    // Arithmetic keys compare in registers, so wide nodes cost little; other
+    // keys (strings) are compared through pointers and do better in nodes
+    // of a few cache lines
+    static const size_t NODE_SIZE = std::is_arithmetic<Key>::value ? 4096 : 512;
+    static const size_t NODE_HEADER_SIZE = 64;
+    
+    // Entries per node, as many as fit in NODE_SIZE (at least 4)
+    static const int LEAF_CAPACITY = static_cast<int>(std::max<size_t>(
+        4, (NODE_SIZE - NODE_HEADER_SIZE) / (sizeof(Key) + sizeof(Value))));
+    static const int INNER_CAPACITY = static_cast<int>(std::max<size_t>(
+        4, (NODE_SIZE - NODE_HEADER_SIZE) / (sizeof(Key) + sizeof(void*))));
+    
+    /**
+     * @brief Position on an entry, moved in key order in either direction
+     * 
+     * A cursor remembers its key and the modification count of the tree.
+     * When the tree has changed since, the cursor finds its key again
+     * instead of trusting a leaf that may have been split, merged or freed:
+     * next() and prev() continue from the remembered key, so inserts and
+     * removals made while iterating (the cursor's own entry included) never
+     * leave it dangling. If its own entry was removed, valid() is false
+     * until the cursor is moved.
+     */
+    class Cursor {
+    public:
+        Cursor() : tree_(nullptr), leaf_(nullptr), index_(0), version_(0), hasKey_(false), pastEnd_(false) {}
+        
+        // On an entry; key() and value() may only be called then
+        bool valid() const;
+        
+        const Key& key() const;
+        const Value& value() const;
+        
+        // Move to the next larger key; invalid after the last one
+        void next();
+        
+        // Move to the next smaller key; invalid before the first one. A
+        // cursor past the last entry moves onto it
+        void prev();
+    
+    private:
+        friend class BPlusTree;
+        
+        Cursor(const BPlusTree* tree, const Leaf* leaf, int index);
+        
+        void refresh() const;
+        void moveTo(const Leaf* leaf, int index) const;
+        
+        const BPlusTree* tree_;
+        mutable const Leaf* leaf_;  // Null when not on an entry
+        mutable int index_;
+        mutable uint64_t version_;  // Tree modification count leaf_ is valid for
+        Key current_;               // Key of the entry the cursor was last on
+        bool hasKey_;
+        mutable bool pastEnd_;
+    };
+    
+    BPlusTree();
+    ~BPlusTree();
+    
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+    
+    // Insert a key-value pair, replacing the value of an existing key
+    void insert(const Key& key, const Value& value);
+    
+    // Search for a key
+    bool search(const Key& key, Value& value) const;
+    
+    // Search for the largest key <= key, also returned in foundKey if given
+    bool searchFloor(const Key& key, Value& value, Key* foundKey = nullptr) const;
+    
+    // Remove a key
+    bool remove(const Key& key);
+    
+    // Remove every key
+    void clear();
+    
+    /**
+     * @brief Replace the contents with entries, building the tree bottom up
+     * 
+     * The entries are sorted on up to sortThreads threads (a stable sort,
+     * so for a repeated key the last entry wins, as with insert), packed
+     * into leaves and then into each level of inner nodes in one pass.
+     * 
+     * @param fillFactor Share of each node to fill, clamped to [0.5, 1];
+     *        below 1 leaves room for later inserts without splits
+     * @param sortThreads Threads for the sort (0 for one per core)
+     */
+    void bulkLoad(std::vector<std::pair<Key, Value>> entries, double fillFactor = 1.0,
+                  size_t sortThreads = 0);
+    
+    // Call fn(key, value) for every entry in key order
+    template<typename Fn>
+    void forEach(Fn fn) const;
+    
+    /**
+     * @brief Call fn(key, value) for the keys in [low, high] in key order
+     * 
+     * @param limit Stop after this many entries
+     * @return The number of entries visited
+     */
+    template<typename Fn>
+    size_t scan(const Key& low, const Key& high, Fn fn,
+                size_t limit = std::numeric_limits<size_t>::max()) const;
+    
+    // Cursors on the smallest and largest keys (invalid when empty)
+    Cursor first() const;
+    Cursor last() const;
+    
+    // Cursor on the first key >= key (lower) or > key (upper); it is past
+    // the end when there is none, so prev() moves onto the last key
+    Cursor lowerBound(const Key& key) const;
+    Cursor upperBound(const Key& key) const;
+    
+    size_t getSize() const;
+    
+    // Levels from the root to the leaves (0 when empty)
+    int getHeight() const;
+    
+    // Bytes held by the node pools
+    size_t getMemoryUsage() const;
+    
+    // Print the tree (for debugging)
+    void print() const;
+
+private:
+    struct Node {
+        bool isLeaf;
+        int count;  // Keys in the node
+        
+        explicit Node(bool leaf) : isLeaf(leaf), count(0) {}
+    };
+    
+    static const int MIN_LEAF_KEYS = LEAF_CAPACITY / 2;
+    static const int MIN_INNER_KEYS = INNER_CAPACITY / 2;
+    static const int MAX_HEIGHT = 64;
+    
+    // Below this many candidates a node search counts instead of halving
+    static const int LINEAR_SEARCH_KEYS = 16;
+    
+    struct Leaf : Node {
+        Leaf* prev;
+        Leaf* next;
+        Key keys[LEAF_CAPACITY];
+        Value values[LEAF_CAPACITY];
+        
+        Leaf() : Node(true), prev(nullptr), next(nullptr) {}
+    };
+    
+    // children[i] holds the keys in [keys[i - 1], keys[i])
+    struct Inner : Node {
+        Key keys[INNER_CAPACITY];
+        Node* children[INNER_CAPACITY + 1];
+        
+        Inner() : Node(false) {}
+    };
+    
+    // The nodes visited on the way down and the child taken at each
+    struct Path {
+        Inner* nodes[MAX_HEIGHT];
+        int childIndex[MAX_HEIGHT];
+        int depth = 0;
+    };
+    
+    Node* root;
+    size_t size;
+    int height;
+    uint64_t version;  // Bumped whenever entries move: insert of a new key, remove, clear
+    NodePool<Leaf> leafPool;
+    NodePool<Inner> innerPool;
+    
+    // Number of keys before the first key >= key (lower) or > key (upper)
+    template<bool Upper>
+    static int searchNode(const Key* keys, int count, const Key& key);
+    
+    Leaf* findLeaf(const Key& key, Path* path) const;
+    
+    // Cursor on the first key >= key (or > key when upper is true)
+    Cursor seek(const Key& key, bool upper) const;
+    void insertIntoParent(Path& path, Node* left, const Key& separator, Node* right);
+    void rebalanceLeaf(Path& path, Leaf* leaf);
+    void rebalanceInner(Path& path, Inner* node);
+    void destroyRecursive(Node* node);
+    void printRecursive(const Node* node, int depth) const;
+    
+    // Stable merge sort by key, halves sorted on separate threads
+    template<typename Iterator>
+    static void sortEntries(Iterator first, Iterator last, size_t threads);
+    
+    // Number of nodes for count items at no more than perNode each; items
+    // are then spread evenly, so no node falls far below perNode
+    static size_t nodesFor(size_t count, size_t perNode);
+};
+
+// Implementation
+template<typename Key, typename Value>
+BPlusTree<Key, Value>::BPlusTree() : root(nullptr), size(0), height(0), version(0) {}
+
+template<typename Key, typename Value>
+BPlusTree<Key, Value>::~BPlusTree() {
+    clear();
+}
+
+template<typename Key, typename Value>
+template<bool Upper>
+int BPlusTree<Key, Value>::searchNode(const Key* keys, int count, const Key& key) {
+    // Every key before the result is < key (lower) or <= key (upper)
+    auto before = [&key](const Key& candidate) {
+        return Upper ? !(key < candidate) : candidate < key;
+    };
+    const Key* base = keys;
+    int n = count;
+    while (n > LINEAR_SEARCH_KEYS) {
+        int half = n / 2;
+        base = before(base[half]) ? base + half : base;
+        n -= half;
+    }
+    int index = static_cast<int>(base - keys);
+    for (int i = 0; i < n; ++i) {
+        index += before(base[i]) ? 1 : 0;
+    }
+    return index;
+}
+
+template<typename Key, typename Value>
+typename BPlusTree<Key, Value>::Leaf* BPlusTree<Key, Value>::findLeaf(const Key& key, Path* path) const {
+    Node* node = root;
+    while (!node->isLeaf) {
+        Inner* inner = static_cast<Inner*>(node);
+        int index = searchNode<true>(inner->keys, inner->count, key);
+        if (path != nullptr) {
+            path->nodes[path->depth] = inner;
+            path->childIndex[path->depth] = index;
+            path->depth++;
+        }
+        node = inner->children[index];
+    }
+    return static_cast<Leaf*>(node);
+}
+
+template<typename Key, typename Value>
+bool BPlusTree<Key, Value>::search(const Key& key, Value& value) const {
+    if (root == nullptr) {
+        return false;
+    }
+    const Leaf* leaf = findLeaf(key, nullptr);
+    int index = searchNode<false>(leaf->keys, leaf->count, key);
+    if (index < leaf->count && !(key < leaf->keys[index])) {
+        value = leaf->values[index];
+        return true;
+    }
+    return false;
+}
+
+template<typename Key, typename Value>
+bool BPlusTree<Key, Value>::searchFloor(const Key& key, Value& value, Key* foundKey) const {
+    if (root == nullptr) {
+        return false;
+    }
+    // Every key of the leaf may be larger; the answer is then the last key
+    // of the leaf before
+    const Leaf* leaf = findLeaf(key, nullptr);
+    int index = searchNode<true>(leaf->keys, leaf->count, key);
+    if (index == 0) {
+        leaf = leaf->prev;
+        if (leaf == nullptr) {
+            return false;
+        }
+        index = leaf->count;
+    }
+    value = leaf->values[index - 1];
+    if (foundKey != nullptr) {
+        *foundKey = leaf->keys[index - 1];
+    }
+    return true;
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::insert(const Key& key, const Value& value) {
+    if (root == nullptr) {
+        root = leafPool.create();
+        height = 1;
+    }
+    
+    Path path;
+    Leaf* leaf = findLeaf(key, &path);
+    int index = searchNode<false>(leaf->keys, leaf->count, key);
+    if (index < leaf->count && !(key < leaf->keys[index])) {
+        leaf->values[index] = value;
+        return;
+    }
+    size++;
+    version++;
+    
+    Leaf* target = leaf;
+    Leaf* right = nullptr;
+    if (leaf->count == LEAF_CAPACITY) {
+        // Split in half, except when appending to the last leaf: ascending
+        // inserts then leave full leaves behind instead of half-empty ones
+        int keep = (index == LEAF_CAPACITY && leaf->next == nullptr) ? LEAF_CAPACITY : (LEAF_CAPACITY + 1) / 2;
+        right = leafPool.create();
+        for (int i = keep; i < LEAF_CAPACITY; ++i) {
+            right->keys[i - keep] = std::move(leaf->keys[i]);
+            right->values[i - keep] = std::move(leaf->values[i]);
+        }
+        right->count = LEAF_CAPACITY - keep;
+        leaf->count = keep;
+        right->next = leaf->next;
+        right->prev = leaf;
+        if (leaf->next != nullptr) {
+            leaf->next->prev = right;
+        }
+        leaf->next = right;
+        if (index >= keep) {
+            target = right;
+            index -= keep;
+        }
+    }
+    
+    // Make room for the new key and value
+    for (int i = target->count; i > index; --i) {
+        target->keys[i] = std::move(target->keys[i - 1]);
+        target->values[i] = std::move(target->values[i - 1]);
+    }
+    target->keys[index] = key;
+    target->values[index] = value;
+    target->count++;
+    
+    if (right != nullptr) {
+        insertIntoParent(path, leaf, right->keys[0], right);
+    }
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::insertIntoParent(Path& path, Node* left, const Key& separator, Node* right) {
+    if (path.depth == 0) {
+        // The root split: the tree grows by one level
+        Inner* newRoot = innerPool.create();
+        newRoot->keys[0] = separator;
+        newRoot->children[0] = left;
+        newRoot->children[1] = right;
+        newRoot->count = 1;
+        root = newRoot;
+        height++;
+        return;
+    }
+    
+    path.depth--;
+    Inner* parent = path.nodes[path.depth];
+    int index = path.childIndex[path.depth];  // Where left hangs
+    Key promoted;
+    Inner* sibling = nullptr;
+    Inner* target = parent;
+    if (parent->count == INNER_CAPACITY) {
+        // Split around the middle key, which moves up, then add the new
+        // separator to whichever half it belongs in
+        int middle = INNER_CAPACITY / 2;
+        sibling = innerPool.create();
+        promoted = std::move(parent->keys[middle]);
+        for (int i = middle + 1; i < INNER_CAPACITY; ++i) {
+            sibling->keys[i - middle - 1] = std::move(parent->keys[i]);
+        }
+        for (int i = middle + 1; i <= INNER_CAPACITY; ++i) {
+            sibling->children[i - middle - 1] = parent->children[i];
+        }
+        sibling->count = INNER_CAPACITY - middle - 1;
+        parent->count = middle;
+        if (index > middle) {
+            target = sibling;
+            index -= middle + 1;
+        }
+    }
+    
+    for (int i = target->count; i > index; --i) {
+        target->keys[i] = std::move(target->keys[i - 1]);
+        target->children[i + 1] = target->children[i];
+    }
+    target->keys[index] = separator;
+    target->children[index + 1] = right;
+    target->count++;
+    
+    if (sibling != nullptr) {
+        insertIntoParent(path, parent, promoted, sibling);
+    }
+}
+
+template<typename Key, typename Value>
+bool BPlusTree<Key, Value>::remove(const Key& key) {
+    if (root == nullptr) {
+        return false;
+    }
+    Path path;
+    Leaf* leaf = findLeaf(key, &path);
+    int index = searchNode<false>(leaf->keys, leaf->count, key);
+    if (index == leaf->count || key < leaf->keys[index]) {
+        return false;
+    }
+    
+    for (int i = index + 1; i < leaf->count; ++i) {
+        leaf->keys[i - 1] = std::move(leaf->keys[i]);
+        leaf->values[i - 1] = std::move(leaf->values[i]);
+    }
+    leaf->count--;
+    size--;
+    version++;
+    rebalanceLeaf(path, leaf);
+    return true;
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::rebalanceLeaf(Path& path, Leaf* leaf) {
+    if (path.depth == 0) {
+        // The root leaf may shrink to nothing
+        if (leaf->count == 0) {
+            leafPool.destroy(leaf);
+            root = nullptr;
+            height = 0;
+        }
+        return;
+    }
+    if (leaf->count >= MIN_LEAF_KEYS) {
+        return;
+    }
+    
+    Inner* parent = path.nodes[path.depth - 1];
+    int index = path.childIndex[path.depth - 1];
+    Leaf* left = index > 0 ? static_cast<Leaf*>(parent->children[index - 1]) : nullptr;
+    Leaf* right = index < parent->count ? static_cast<Leaf*>(parent->children[index + 1]) : nullptr;
+    
+    // Borrow from a sibling with keys to spare
+    if (left != nullptr && left->count > MIN_LEAF_KEYS) {
+        for (int i = leaf->count; i > 0; --i) {
+            leaf->keys[i] = std::move(leaf->keys[i - 1]);
+            leaf->values[i] = std::move(leaf->values[i - 1]);
+        }
+        leaf->keys[0] = std::move(left->keys[left->count - 1]);
+        leaf->values[0] = std::move(left->values[left->count - 1]);
+        leaf->count++;
+        left->count--;
+        parent->keys[index - 1] = leaf->keys[0];
+        return;
+    }
+    if (right != nullptr && right->count > MIN_LEAF_KEYS) {
+        leaf->keys[leaf->count] = std::move(right->keys[0]);
+        leaf->values[leaf->count] = std::move(right->values[0]);
+        leaf->count++;
+        for (int i = 1; i < right->count; ++i) {
+            right->keys[i - 1] = std::move(right->keys[i]);
+            right->values[i - 1] = std::move(right->values[i]);
+        }
+        right->count--;
+        parent->keys[index] = right->keys[0];
+        return;
+    }
+    
+    // Merge with a sibling; the right one of the pair goes away
+    int leftIndex = left != nullptr ? index - 1 : index;
+    Leaf* into = left != nullptr ? left : leaf;
+    Leaf* from = left != nullptr ? leaf : right;
+    for (int i = 0; i < from->count; ++i) {
+        into->keys[into->count + i] = std::move(from->keys[i]);
+        into->values[into->count + i] = std::move(from->values[i]);
+    }
+    into->count += from->count;
+    into->next = from->next;
+    if (from->next != nullptr) {
+        from->next->prev = into;
+    }
+    leafPool.destroy(from);
+    
+    for (int i = leftIndex + 1; i < parent->count; ++i) {
+        parent->keys[i - 1] = std::move(parent->keys[i]);
+        parent->children[i] = parent->children[i + 1];
+    }
+    parent->count--;
+    path.depth--;
+    rebalanceInner(path, parent);
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::rebalanceInner(Path& path, Inner* node) {
+    if (path.depth == 0) {
+        // A root left with one child hands the root to it
+        if (node->count == 0) {
+            root = node->children[0];
+            innerPool.destroy(node);
+            height--;
+        }
+        return;
+    }
+    if (node->count >= MIN_INNER_KEYS) {
+        return;
+    }
+    
+    Inner* parent = path.nodes[path.depth - 1];
+    int index = path.childIndex[path.depth - 1];
+    Inner* left = index > 0 ? static_cast<Inner*>(parent->children[index - 1]) : nullptr;
+    Inner* right = index < parent->count ? static_cast<Inner*>(parent->children[index + 1]) : nullptr;
+    
+    // Borrow through the parent: the separator comes down, the sibling's
+    // outermost key goes up
+    if (left != nullptr && left->count > MIN_INNER_KEYS) {
+        for (int i = node->count; i > 0; --i) {
+            node->keys[i] = std::move(node->keys[i - 1]);
+        }
+        for (int i = node->count + 1; i > 0; --i) {
+            node->children[i] = node->children[i - 1];
+        }
+        node->keys[0] = std::move(parent->keys[index - 1]);
+        node->children[0] = left->children[left->count];
+        parent->keys[index - 1] = std::move(left->keys[left->count - 1]);
+        node->count++;
+        left->count--;
+        return;
+    }
+    if (right != nullptr && right->count > MIN_INNER_KEYS) {
+        node->keys[node->count] = std::move(parent->keys[index]);
+        node->children[node->count + 1] = right->children[0];
+        node->count++;
+        parent->keys[index] = std::move(right->keys[0]);
+        for (int i = 1; i < right->count; ++i) {
+            right->keys[i - 1] = std::move(right->keys[i]);
+        }
+        for (int i = 1; i <= right->count; ++i) {
+            right->children[i - 1] = right->children[i];
+        }
+        right->count--;
+        return;
+    }
+    
+    // Merge with a sibling around the separator between them
+    int leftIndex = left != nullptr ? index - 1 : index;
+    Inner* into = left != nullptr ? left : node;
+    Inner* from = left != nullptr ? node : right;
+    into->keys[into->count] = std::move(parent->keys[leftIndex]);
+    for (int i = 0; i < from->count; ++i) {
+        into->keys[into->count + 1 + i] = std::move(from->keys[i]);
+    }
+    for (int i = 0; i <= from->count; ++i) {
+        into->children[into->count + 1 + i] = from->children[i];
+    }
+    into->count += from->count + 1;
+    innerPool.destroy(from);
+    
+    for (int i = leftIndex + 1; i < parent->count; ++i) {
+        parent->keys[i - 1] = std::move(parent->keys[i]);
+        parent->children[i] = parent->children[i + 1];
+    }
+    parent->count--;
+    path.depth--;
+    rebalanceInner(path, parent);
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::clear() {
+    if (root != nullptr) {
+        destroyRecursive(root);
+    }
+    root = nullptr;
+    size = 0;
+    height = 0;
+    version++;
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::bulkLoad(std::vector<std::pair<Key, Value>> entries, double fillFactor,
+                                     size_t sortThreads) {
+    clear();
+    if (sortThreads == 0) {
+        sortThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    sortEntries(entries.begin(), entries.end(), sortThreads);
+    
+    // Keep the last entry of each run of equal keys
+    size_t unique = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (unique > 0 && !(entries[unique - 1].first < entries[i].first)) {
+            entries[unique - 1] = std::move(entries[i]);
+        } else {
+            if (unique != i) {
+                entries[unique] = std::move(entries[i]);
+            }
+            unique++;
+        }
+    }
+    if (unique == 0) {
+        return;
+    }
+    
+    fillFactor = std::min(1.0, std::max(0.5, fillFactor));
+    size_t perLeaf = std::max<size_t>(1, static_cast<size_t>(LEAF_CAPACITY * fillFactor));
+    size_t perInner = std::max<size_t>(4, static_cast<size_t>((INNER_CAPACITY + 1) * fillFactor));
+    
+    // Leaves, linked left to right; lowKeys[i] is the smallest key under level[i]
+    std::vector<Node*> level;
+    std::vector<Key> lowKeys;
+    size_t leafCount = nodesFor(unique, perLeaf);
+    level.reserve(leafCount);
+    lowKeys.reserve(leafCount);
+    Leaf* previous = nullptr;
+    size_t next = 0;
+    for (size_t i = 0; i < leafCount; ++i) {
+        size_t end = unique * (i + 1) / leafCount;
+        Leaf* leaf = leafPool.create();
+        for (size_t j = next; j < end; ++j) {
+            leaf->keys[j - next] = std::move(entries[j].first);
+            leaf->values[j - next] = std::move(entries[j].second);
+        }
+        leaf->count = static_cast<int>(end - next);
+        next = end;
+        leaf->prev = previous;
+        if (previous != nullptr) {
+            previous->next = leaf;
+        }
+        previous = leaf;
+        level.push_back(leaf);
+        lowKeys.push_back(leaf->keys[0]);
+    }
+    height = 1;
+    
+    // Each pass groups one level's nodes under new inner nodes
+    while (level.size() > 1) {
+        size_t innerCount = nodesFor(level.size(), perInner);
+        std::vector<Node*> parents;
+        std::vector<Key> parentLowKeys;
+        parents.reserve(innerCount);
+        parentLowKeys.reserve(innerCount);
+        size_t first = 0;
+        for (size_t i = 0; i < innerCount; ++i) {
+            size_t end = level.size() * (i + 1) / innerCount;
+            Inner* inner = innerPool.create();
+            inner->children[0] = level[first];
+            for (size_t j = first + 1; j < end; ++j) {
+                inner->keys[j - first - 1] = std::move(lowKeys[j]);
+                inner->children[j - first] = level[j];
+            }
+            inner->count = static_cast<int>(end - first - 1);
+            parents.push_back(inner);
+            parentLowKeys.push_back(std::move(lowKeys[first]));
+            first = end;
+        }
+        level.swap(parents);
+        lowKeys.swap(parentLowKeys);
+        height++;
+    }
+    root = level[0];
+    size = unique;
+}
+
+template<typename Key, typename Value>
+size_t BPlusTree<Key, Value>::nodesFor(size_t count, size_t perNode) {
+    return (count + perNode - 1) / perNode;
+}
+
+template<typename Key, typename Value>
+template<typename Iterator>
+void BPlusTree<Key, Value>::sortEntries(Iterator first, Iterator last, size_t threads) {
+    auto byKey = [](const std::pair<Key, Value>& a, const std::pair<Key, Value>& b) {
+        return a.first < b.first;
+    };
+    const ptrdiff_t minParallel = 1 << 16;
+    ptrdiff_t count = std::distance(first, last);
+    if (threads <= 1 || count < minParallel) {
+        std::stable_sort(first, last, byKey);
+        return;
+    }
+    Iterator middle = first + count / 2;
+    std::thread left([first, middle, threads]() {
+        sortEntries(first, middle, threads / 2);
+    });
+    sortEntries(middle, last, threads - threads / 2);
+    left.join();
+    std::inplace_merge(first, middle, last, byKey);
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::destroyRecursive(Node* node) {
+    if (node->isLeaf) {
+        leafPool.destroy(static_cast<Leaf*>(node));
+        return;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    for (int i = 0; i <= inner->count; ++i) {
+        destroyRecursive(inner->children[i]);
+    }
+    innerPool.destroy(inner);
+}
+
+template<typename Key, typename Value>
+template<typename Fn>
+void BPlusTree<Key, Value>::forEach(Fn fn) const {
+    if (root == nullptr) {
+        return;
+    }
+    const Node* node = root;
+    while (!node->isLeaf) {
+        node = static_cast<const Inner*>(node)->children[0];
+    }
+    for (const Leaf* leaf = static_cast<const Leaf*>(node); leaf != nullptr; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; ++i) {
+            fn(leaf->keys[i], leaf->values[i]);
+        }
+    }
+}
+
+template<typename Key, typename Value>
+template<typename Fn>
+size_t BPlusTree<Key, Value>::scan(const Key& low, const Key& high, Fn fn, size_t limit) const {
+    if (root == nullptr || high < low) {
+        return 0;
+    }
+    const Leaf* leaf = findLeaf(low, nullptr);
+    int index = searchNode<false>(leaf->keys, leaf->count, low);
+    size_t visited = 0;
+    for (; leaf != nullptr && visited < limit; leaf = leaf->next, index = 0) {
+        for (; index < leaf->count && visited < limit; ++index) {
+            if (high < leaf->keys[index]) {
+                return visited;
+            }
+            fn(leaf->keys[index], leaf->values[index]);
+            visited++;
+        }
+    }
+    return visited;
+}
+
+template<typename Key, typename Value>
+typename BPlusTree<Key, Value>::Cursor BPlusTree<Key, Value>::first() const {
+    if (root == nullptr) {
+        return Cursor(this, nullptr, 0);
+    }
+    const Node* node = root;
+    while (!node->isLeaf) {
+        node = static_cast<const Inner*>(node)->children[0];
+    }
+    return Cursor(this, static_cast<const Leaf*>(node), 0);
+}
+
+template<typename Key, typename Value>
+typename BPlusTree<Key, Value>::Cursor BPlusTree<Key, Value>::last() const {
+    if (root == nullptr) {
+        return Cursor(this, nullptr, 0);
+    }
+    const Node* node = root;
+    while (!node->isLeaf) {
+        const Inner* inner = static_cast<const Inner*>(node);
+        node = inner->children[inner->count];
+    }
+    return Cursor(this, static_cast<const Leaf*>(node), node->count - 1);
+}
+
+template<typename Key, typename Value>
+typename BPlusTree<Key, Value>::Cursor BPlusTree<Key, Value>::lowerBound(const Key& key) const {
+    return seek(key, false);
+}
+
+template<typename Key, typename Value>
+typename BPlusTree<Key, Value>::Cursor BPlusTree<Key, Value>::upperBound(const Key& key) const {
+    return seek(key, true);
+}
+
+template<typename Key, typename Value>
+typename BPlusTree<Key, Value>::Cursor BPlusTree<Key, Value>::seek(const Key& key, bool upper) const {
+    if (root == nullptr) {
+        Cursor cursor(this, nullptr, 0);
+        cursor.pastEnd_ = true;
+        return cursor;
+    }
+    const Leaf* leaf = findLeaf(key, nullptr);
+    int index = upper ? searchNode<true>(leaf->keys, leaf->count, key) : searchNode<false>(leaf->keys, leaf->count, key);
+    return Cursor(this, leaf, index);
+}
+
+template<typename Key, typename Value>
+BPlusTree<Key, Value>::Cursor::Cursor(const BPlusTree* tree, const Leaf* leaf, int index)
+    : tree_(tree), leaf_(nullptr), index_(0), version_(tree->version), hasKey_(false), pastEnd_(false) {
+    moveTo(leaf, index);
+    if (leaf_ != nullptr) {
+        current_ = leaf_->keys[index_];
+        hasKey_ = true;
+    }
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::Cursor::moveTo(const Leaf* leaf, int index) const {
+    // An index one past a leaf's last key means the first key of the next leaf
+    if (leaf != nullptr && index == leaf->count) {
+        pastEnd_ = leaf->next == nullptr;
+        leaf = leaf->next;
+        index = 0;
+    }
+    leaf_ = leaf;
+    index_ = index;
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::Cursor::refresh() const {
+    if (tree_ == nullptr || version_ == tree_->version) {
+        return;
+    }
+    version_ = tree_->version;
+    leaf_ = nullptr;
+    if (!hasKey_ || tree_->root == nullptr) {
+        return;
+    }
+    const Leaf* leaf = tree_->findLeaf(current_, nullptr);
+    int index = searchNode<false>(leaf->keys, leaf->count, current_);
+    if (index < leaf->count && !(current_ < leaf->keys[index])) {
+        leaf_ = leaf;
+        index_ = index;
+    }
+}
+
+template<typename Key, typename Value>
+bool BPlusTree<Key, Value>::Cursor::valid() const {
+    refresh();
+    return leaf_ != nullptr;
+}
+
+template<typename Key, typename Value>
+const Key& BPlusTree<Key, Value>::Cursor::key() const {
+    return current_;
+}
+
+template<typename Key, typename Value>
+const Value& BPlusTree<Key, Value>::Cursor::value() const {
+    refresh();
+    return leaf_->values[index_];
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::Cursor::next() {
+    if (tree_ == nullptr || !hasKey_) {
+        return;
+    }
+    if (version_ != tree_->version || leaf_ == nullptr) {
+        // Continue from the remembered key, whatever happened to its leaf
+        *this = tree_->upperBound(current_);
+        return;
+    }
+    moveTo(leaf_, index_ + 1);
+    if (leaf_ == nullptr) {
+        hasKey_ = false;
+        return;
+    }
+    current_ = leaf_->keys[index_];
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::Cursor::prev() {
+    if (tree_ == nullptr) {
+        return;
+    }
+    if (!hasKey_) {
+        if (pastEnd_) {
+            *this = tree_->last();
+        }
+        return;
+    }
+    if (version_ != tree_->version || leaf_ == nullptr) {
+        // Step back from the first key >= the remembered one
+        Cursor bound = tree_->lowerBound(current_);
+        if (!bound.hasKey_) {
+            *this = tree_->last();
+            return;
+        }
+        *this = bound;
+    }
+    if (index_ > 0) {
+        index_--;
+    } else {
+        leaf_ = leaf_->prev;
+        index_ = leaf_ != nullptr ? leaf_->count - 1 : 0;
+    }
+    if (leaf_ == nullptr) {
+        hasKey_ = false;
+        pastEnd_ = false;
+        return;
+    }
+    current_ = leaf_->keys[index_];
+}
+
+template<typename Key, typename Value>
+size_t BPlusTree<Key, Value>::getSize() const {
+    return size;
+}
+
+template<typename Key, typename Value>
+int BPlusTree<Key, Value>::getHeight() const {
+    return height;
+}
+
+template<typename Key, typename Value>
+size_t BPlusTree<Key, Value>::getMemoryUsage() const {
+    return leafPool.getMemoryUsage() + innerPool.getMemoryUsage();
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::print() const {
+    if (root != nullptr) {
+        printRecursive(root, 0);
+    }
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::printRecursive(const Node* node, int depth) const {
+    for (int i = 0; i < depth; i++) {
+        std::cout << "  ";
+    }
+    
+    const Key* keys = node->isLeaf ? static_cast<const Leaf*>(node)->keys : static_cast<const Inner*>(node)->keys;
+    std::cout << (node->isLeaf ? "(" : "[");
+    for (int i = 0; i < node->count; i++) {
+        std::cout << keys[i];
+        if (i < node->count - 1) {
+            std::cout << " ";
+        }
+    }
+    std::cout << (node->isLeaf ? ")" : "]") << std::endl;
+    
+    if (!node->isLeaf) {
+        const Inner* inner = static_cast<const Inner*>(node);
+        for (int i = 0; i <= inner->count; i++) {
+            printRecursive(inner->children[i], depth + 1);
+        }
+    }
+}
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_BPLUS_TREE_H
@@ -0,0 +1,366 @@
+#include "bplus_tree.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <map>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+using namespace phantomdb::storage;
+
+void testBasicOperations() {
+    std::cout << "Testing basic B+tree operations..." << std::endl;
+    
+    BPlusTree<int, std::string> tree;
+    std::string value;
+    assert(!tree.search(1, value));
+    assert(!tree.remove(1));
+    assert(tree.getHeight() == 0);
+    
+    tree.insert(2, "two");
+    tree.insert(1, "one");
+    tree.insert(3, "three");
+    assert(tree.search(1, value) && value == "one");
+    assert(tree.search(3, value) && value == "three");
+    assert(!tree.search(4, value));
+    
+    // Keys are unique; inserting again replaces the value
+    tree.insert(2, "TWO");
+    assert(tree.search(2, value) && value == "TWO");
+    assert(tree.getSize() == 3);
+    
+    assert(tree.remove(2));
+    assert(!tree.search(2, value));
+    assert(!tree.remove(2));
+    assert(tree.getSize() == 2);
+    
+    assert(tree.remove(1) && tree.remove(3));
+    assert(tree.getSize() == 0 && tree.getHeight() == 0);
+    
+    std::cout << "Basic operations test passed!" << std::endl;
+}
+
+void testSplitsAndLeafLinks() {
+    std::cout << "Testing splits and leaf links..." << std::endl;
+    
+    // Ascending inserts fill leaves completely
+    BPlusTree<int, int> ascending;
+    const int count = 100000;
+    for (int i = 0; i < count; ++i) {
+        ascending.insert(i, i * 2);
+    }
+    assert(ascending.getSize() == count);
+    assert(ascending.getHeight() >= 2);
+    int expected = 0;
+    ascending.forEach([&expected](int key, int value) {
+        assert(key == expected && value == key * 2);
+        expected++;
+    });
+    assert(expected == count);
+    
+    size_t leafBytes = sizeof(int) * 2;
+    size_t minimum = count * leafBytes;
+    assert(ascending.getMemoryUsage() < minimum * 2);
+    
+    // String keys in random order, checked against std::map
+    BPlusTree<std::string, std::string> tree;
+    std::map<std::string, std::string> reference;
+    std::mt19937 random(7);
+    for (int i = 0; i < 20000; ++i) {
+        std::string key = "key" + std::to_string(random() % 50000);
+        tree.insert(key, "value" + std::to_string(i));
+        reference[key] = "value" + std::to_string(i);
+    }
+    assert(tree.getSize() == reference.size());
+    auto it = reference.begin();
+    tree.forEach([&it](const std::string& key, const std::string& value) {
+        assert(key == it->first && value == it->second);
+        ++it;
+    });
+    assert(it == reference.end());
+    
+    std::cout << "Splits and leaf links test passed!" << std::endl;
+}
+
+void testRemoveRebalancing() {
+    std::cout << "Testing removal with merges and borrows..." << std::endl;
+    
+    // String entries keep nodes small enough for three levels
+    BPlusTree<std::string, std::string> tree;
+    std::map<std::string, std::string> reference;
+    std::mt19937 random(11);
+    const int count = 30000;
+    for (int i = 0; i < count; ++i) {
+        tree.insert("key" + std::to_string(i), std::to_string(i));
+        reference["key" + std::to_string(i)] = std::to_string(i);
+    }
+    int heightBefore = tree.getHeight();
+    assert(heightBefore >= 3);
+    
+    // Remove in random order with interleaved inserts
+    std::vector<int> keys;
+    for (int i = 0; i < count; ++i) {
+        keys.push_back(i);
+    }
+    std::shuffle(keys.begin(), keys.end(), random);
+    std::string value;
+    for (int i = 0; i < count; ++i) {
+        std::string key = "key" + std::to_string(keys[i]);
+        assert(tree.remove(key));
+        reference.erase(key);
+        if (i % 10 == 0) {
+            std::string added = "added" + std::to_string(i);
+            tree.insert(added, std::to_string(i));
+            reference[added] = std::to_string(i);
+        }
+        if (i % 1000 == 0) {
+            assert(!tree.search(key, value));
+            assert(tree.getSize() == reference.size());
+        }
+    }
+    assert(tree.getSize() == reference.size());
+    assert(tree.getHeight() < heightBefore);
+    for (const auto& entry : reference) {
+        assert(tree.search(entry.first, value) && value == entry.second);
+    }
+    auto it = reference.begin();
+    tree.forEach([&it](const std::string& key, const std::string& value) {
+        assert(key == it->first && value == it->second);
+        ++it;
+    });
+    assert(it == reference.end());
+    
+    // Removing everything empties the tree and its nodes are reused
+    size_t memory = tree.getMemoryUsage();
+    for (const auto& entry : reference) {
+        assert(tree.remove(entry.first));
+    }
+    assert(tree.getSize() == 0 && tree.getHeight() == 0);
+    for (int i = 0; i < 1000; ++i) {
+        tree.insert(std::to_string(i), "again");
+    }
+    assert(tree.getMemoryUsage() == memory);
+    
+    std::cout << "Removal test passed!" << std::endl;
+}
+
+void testCursorsAndRanges() {
+    std::cout << "Testing cursors and range scans..." << std::endl;
+    
+    BPlusTree<int, int> tree;
+    assert(!tree.first().valid());
+    assert(!tree.lowerBound(5).valid());
+    
+    // Even keys only, so odd probes fall between entries
+    const int count = 20000;
+    for (int i = 0; i < count; ++i) {
+        tree.insert(i * 2, i);
+    }
+    
+    auto cursor = tree.lowerBound(101);
+    assert(cursor.valid() && cursor.key() == 102 && cursor.value() == 51);
+    cursor = tree.lowerBound(102);
+    assert(cursor.valid() && cursor.key() == 102);
+    cursor = tree.upperBound(102);
+    assert(cursor.valid() && cursor.key() == 104);
+    assert(!tree.lowerBound(count * 2).valid());
+    
+    // Forward and reverse walks over every leaf
+    int expected = 0;
+    for (auto it = tree.first(); it.valid(); it.next()) {
+        assert(it.key() == expected);
+        expected += 2;
+    }
+    assert(expected == count * 2);
+    for (auto it = tree.last(); it.valid(); it.prev()) {
+        expected -= 2;
+        assert(it.key() == expected);
+    }
+    assert(expected == 0);
+    
+    // Reverse from a bound, and from past the end
+    cursor = tree.upperBound(501);
+    cursor.prev();
+    assert(cursor.valid() && cursor.key() == 500);
+    cursor = tree.upperBound(count * 2);
+    assert(!cursor.valid());
+    cursor.prev();
+    assert(cursor.valid() && cursor.key() == (count - 1) * 2);
+    cursor = tree.first();
+    cursor.prev();
+    assert(!cursor.valid());
+    cursor.prev();
+    assert(!cursor.valid());
+    
+    // Inclusive bounds and limits
+    std::vector<int> keys;
+    size_t visited = tree.scan(99, 120, [&keys](int key, int) { keys.push_back(key); });
+    assert(visited == 11 && keys.front() == 100 && keys.back() == 120);
+    keys.clear();
+    visited = tree.scan(100, 120, [&keys](int key, int) { keys.push_back(key); }, 3);
+    assert(visited == 3 && keys.back() == 104);
+    assert(tree.scan(120, 100, [](int, int) {}) == 0);
+    assert(tree.scan(count * 2, count * 4, [](int, int) {}) == 0);
+    
+    std::cout << "Cursors and range scans test passed!" << std::endl;
+}
+
+void testCursorsAcrossModifications() {
+    std::cout << "Testing cursors across modifications..." << std::endl;
+    
+    // String keys give small nodes, so the changes below split and merge leaves
+    auto key = [](int i) {
+        std::string text = std::to_string(i);
+        return std::string(6 - text.size(), '0') + text;
+    };
+    BPlusTree<std::string, int> tree;
+    std::map<std::string, int> reference;
+    for (int i = 0; i < 20000; i += 2) {
+        tree.insert(key(i), i);
+        reference[key(i)] = i;
+    }
+    
+    // Walk forward, removing every entry the cursor stands on in one
+    // stretch and inserting odd keys both behind and ahead of it
+    std::vector<std::string> seen;
+    for (auto it = tree.first(); it.valid(); it.next()) {
+        int current = it.value();
+        seen.push_back(it.key());
+        if (current >= 5000 && current < 10000) {
+            assert(tree.remove(it.key()));
+            assert(!it.valid());
+            reference.erase(key(current));
+        }
+        if (current % 100 == 0 && current + 51 < 20000) {
+            tree.insert(key(current + 51), current + 51);
+            reference[key(current + 51)] = current + 51;
+            if (current > 0) {
+                tree.insert(key(current - 1), current - 1);
+                reference[key(current - 1)] = current - 1;
+            }
+        }
+    }
+    
+    // Every even key was seen once and in order, plus the odd keys inserted ahead
+    assert(std::is_sorted(seen.begin(), seen.end()));
+    assert(std::adjacent_find(seen.begin(), seen.end()) == seen.end());
+    assert(seen.size() == 10000 + 200);
+    
+    // Walk backward the same way
+    size_t remaining = 0;
+    auto expected = reference.rbegin();
+    for (auto it = tree.last(); it.valid(); it.prev()) {
+        assert(expected != reference.rend() && it.key() == expected->first);
+        ++expected;
+        remaining++;
+        if (remaining % 3 == 0) {
+            std::string gone = it.key();
+            tree.remove(gone);
+            expected = std::make_reverse_iterator(reference.erase(reference.find(gone)));
+        }
+    }
+    assert(expected == reference.rend());
+    assert(tree.getSize() == reference.size());
+    
+    // A cleared tree ends the walk
+    auto it = tree.first();
+    tree.clear();
+    assert(!it.valid());
+    it.next();
+    assert(!it.valid());
+    
+    std::cout << "Cursors across modifications test passed!" << std::endl;
+}
+
+void testBulkLoad() {
+    std::cout << "Testing bulk loading..." << std::endl;
+    
+    // Random keys with repeats; the last value given for a key wins
+    std::vector<std::pair<int, int>> entries;
+    std::map<int, int> reference;
+    std::mt19937 rng(11);
+    for (int i = 0; i < 300000; ++i) {
+        int key = static_cast<int>(rng() % 200000);
+        entries.emplace_back(key, i);
+        reference[key] = i;
+    }
+    
+    BPlusTree<int, int> packed;
+    packed.insert(-1, -1);  // Replaced by the load
+    packed.bulkLoad(entries, 1.0, 4);
+    assert(packed.getSize() == reference.size());
+    auto expected = reference.begin();
+    packed.forEach([&expected](int key, int value) {
+        assert(key == expected->first && value == expected->second);
+        ++expected;
+    });
+    assert(expected == reference.end());
+    assert(packed.last().key() == reference.rbegin()->first);
+    
+    // Packed nodes take less memory than one-at-a-time inserts or a lower fill
+    BPlusTree<int, int> inserted;
+    for (const auto& entry : entries) {
+        inserted.insert(entry.first, entry.second);
+    }
+    BPlusTree<int, int> sparse;
+    sparse.bulkLoad(entries, 0.6);
+    assert(packed.getMemoryUsage() < inserted.getMemoryUsage());
+    assert(packed.getMemoryUsage() < sparse.getMemoryUsage());
+    
+    // The loaded tree takes inserts and removes like any other
+    for (int key = 200000; key < 220000; ++key) {
+        sparse.insert(key, key);
+        reference[key] = key;
+    }
+    for (auto it = reference.begin(); it != reference.end();) {
+        assert(sparse.remove(it->first));
+        it = reference.erase(it);
+        if (it != reference.end()) {
+            ++it;
+        }
+    }
+    int value;
+    for (const auto& entry : reference) {
+        assert(sparse.search(entry.first, value) && value == entry.second);
+    }
+    assert(sparse.getSize() == reference.size());
+    
+    // String keys, sorted on several threads
+    std::vector<std::pair<std::string, int>> words;
+    for (int i = 0; i < 100000; ++i) {
+        words.emplace_back("key" + std::to_string((i * 7919) % 100000), i);
+    }
+    BPlusTree<std::string, int> strings;
+    strings.bulkLoad(words, 1.0, 3);
+    assert(strings.getSize() == 100000);
+    std::string previous;
+    size_t visited = 0;
+    strings.forEach([&previous, &visited](const std::string& key, int) {
+        assert(visited == 0 || previous < key);
+        previous = key;
+        visited++;
+    });
+    assert(visited == 100000);
+    assert(strings.search("key7919", value) && value == 1);
+    
+    // Loading nothing leaves an empty tree
+    strings.bulkLoad({});
+    assert(strings.getSize() == 0 && strings.getHeight() == 0);
+    
+    std::cout << "Bulk loading test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running B+tree tests..." << std::endl;
+    
+    testBasicOperations();
+    testSplitsAndLeafLinks();
+    testRemoveRebalancing();
+    testCursorsAndRanges();
+    testCursorsAcrossModifications();
+    testBulkLoad();
+    
+    std::cout << "All B+tree tests passed!" << std::endl;
+    return 0;
+}
@@ -118,6 +118,10 @@ void BTree<Key, Value>::splitChild(std::shared_ptr<Node> parent, int childIndex,
         }
     }
     
+    // Keep the middle key of child; shrinking child below destroys it
+    Key middleKey = child->keys[degree - 1];
+    Value middleValue = child->values[degree - 1];
+    
     // Reduce the number of keys in child
     child->keyCount = degree - 1;
     child->keys.resize(degree - 1);
@@ -146,8 +150,8 @@ void BTree<Key, Value>::splitChild(std::shared_ptr<Node> parent, int childIndex,
     }
     
     // Copy the middle key of child to this node
-    parent->keys[childIndex] = child->keys[degree - 1];
-    parent->values[childIndex] = child->values[degree - 1];
+    parent->keys[childIndex] = middleKey;
+    parent->values[childIndex] = middleValue;
     parent->keyCount++;
 }
 
@@ -0,0 +1,505 @@
+#ifndef PHANTOMDB_CONCURRENT_BPLUS_TREE_H
+#define PHANTOMDB_CONCURRENT_BPLUS_TREE_H
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * @brief B+tree for many threads, synchronized by optimistic lock coupling
+ * 
+ * Every node carries a version word whose low bit is a write lock; a
+ * writer that unlocks a node advances its version. Readers take no locks:
+ * they note a node's version, read it, and check that the version has not
+ * moved before trusting what they read, restarting from the root if it
+ * has. Lookups therefore never write to shared memory, and threads
+ * working in different leaves do not touch each other's cache lines.
+ * 
+ * Writers descend the same way and lock only the leaf they change, plus
+ * its parent when it has to split. Full inner nodes are split on the way
+ * down, so a split never has to climb more than one level. Removal does
+ * not merge nodes, so no node is freed while a reader may be on it.
+ * 
+ * Readers copy keys and values that a writer may be changing, so both
+ * must be trivially copyable (integers, fixed-size keys). Keys are unique:
+ * inserting an existing key replaces its value.
+ */
+template<typename Key, typename Value>
+class ConcurrentBPlusTree {
+public:
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                  "optimistic readers copy keys and values while writers may change them");
+    
+    static const size_t NODE_SIZE = 4096;
+    static const size_t NODE_HEADER_SIZE = 64;
+    
+    // Entries per node, as many as fit in NODE_SIZE (at least 4)
+    static const int LEAF_CAPACITY = static_cast<int>(std::max<size_t>(
+        4, (NODE_SIZE - NODE_HEADER_SIZE) / (sizeof(Key) + sizeof(Value))));
+    static const int INNER_CAPACITY = static_cast<int>(std::max<size_t>(
+        4, (NODE_SIZE - NODE_HEADER_SIZE) / (sizeof(Key) + sizeof(void*))));
+    
+    ConcurrentBPlusTree();
+    ~ConcurrentBPlusTree();
+    
+    ConcurrentBPlusTree(const ConcurrentBPlusTree&) = delete;
+    ConcurrentBPlusTree& operator=(const ConcurrentBPlusTree&) = delete;
+    
+    // Insert a key-value pair, replacing the value of an existing key
+    void insert(const Key& key, const Value& value);
+    
+    // Search for a key
+    bool search(const Key& key, Value& value) const;
+    
+    // Remove a key
+    bool remove(const Key& key);
+    
+    // Entries in the tree; walks every leaf, so exact only without concurrent writers
+    size_t getSize() const;
+    
+    // Levels from the root to the leaves
+    int getHeight() const;
+    
+    // Operations that found a node changed under them and started over
+    uint64_t getRestarts() const;
+
+private:
+    // Aligned so that two nodes' version words never share a cache line
+    struct alignas(64) Node {
+        std::atomic<uint64_t> version;  // Odd while write locked
+        bool isLeaf;
+        int count;  // Keys in the node
+        
+        explicit Node(bool leaf) : version(0), isLeaf(leaf), count(0) {}
+    };
+    
+    struct Leaf : Node {
+        Key keys[LEAF_CAPACITY];
+        Value values[LEAF_CAPACITY];
+        
+        Leaf() : Node(true) {}
+    };
+    
+    // children[i] holds the keys in [keys[i - 1], keys[i])
+    struct Inner : Node {
+        Key keys[INNER_CAPACITY];
+        Node* children[INNER_CAPACITY + 1];
+        
+        Inner() : Node(false) {}
+    };
+    
+    std::atomic<Node*> root;
+    std::atomic<int> height;
+    mutable std::atomic<uint64_t> restarts;
+    
+    // Wait until the node is unlocked and return its version
+    static uint64_t readLock(const Node* node);
+    
+    // Whether the node is unchanged since version was read
+    static bool validate(const Node* node, uint64_t version);
+    
+    // Lock the node if it is still at version
+    static bool upgrade(Node* node, uint64_t version);
+    
+    static void writeUnlock(Node* node);
+    
+    // Number of keys before the first key >= key (lower) or > key (upper).
+    // The count may be torn by a concurrent writer, so it is clamped; the
+    // caller's validation then discards the result
+    template<bool Upper>
+    static int searchNode(const Key* keys, int count, int capacity, const Key& key);
+    
+    // One attempt at each operation; false means restart from the root
+    bool trySearch(const Key& key, Value& value, bool& found) const;
+    bool tryInsert(const Key& key, const Value& value);
+    bool tryRemove(const Key& key, bool& removed);
+    
+    // Split a locked full node, returning the new right sibling and the
+    // separator to add to the parent
+    Leaf* splitLeaf(Leaf* leaf, Key& separator);
+    Inner* splitInner(Inner* inner, Key& separator);
+    
+    // Add a separator and its right child to a locked parent (or a new root)
+    void insertChild(Inner* parent, Node* left, const Key& separator, Node* right);
+    
+    static void destroyRecursive(Node* node);
+    static size_t countRecursive(const Node* node);
+};
+
+// Implementation
+template<typename Key, typename Value>
+ConcurrentBPlusTree<Key, Value>::ConcurrentBPlusTree() : root(new Leaf()), height(1), restarts(0) {}
+
+template<typename Key, typename Value>
+ConcurrentBPlusTree<Key, Value>::~ConcurrentBPlusTree() {
+    destroyRecursive(root.load());
+}
+
+template<typename Key, typename Value>
+uint64_t ConcurrentBPlusTree<Key, Value>::readLock(const Node* node) {
+    uint64_t version = node->version.load(std::memory_order_acquire);
+    while ((version & 1) != 0) {
+        // Writers hold a lock for a few hundred instructions; let them run
+        std::this_thread::yield();
+        version = node->version.load(std::memory_order_acquire);
+    }
+    return version;
+}
+
+template<typename Key, typename Value>
+bool ConcurrentBPlusTree<Key, Value>::validate(const Node* node, uint64_t version) {
+    // Order the reads of the node's contents before the version check
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return node->version.load(std::memory_order_relaxed) == version;
+}
+
+template<typename Key, typename Value>
+bool ConcurrentBPlusTree<Key, Value>::upgrade(Node* node, uint64_t version) {
+    return node->version.compare_exchange_strong(version, version + 1, std::memory_order_acquire);
+}
+
+template<typename Key, typename Value>
+void ConcurrentBPlusTree<Key, Value>::writeUnlock(Node* node) {
+    node->version.fetch_add(1, std::memory_order_release);
+}
+
+template<typename Key, typename Value>
+template<bool Upper>
+int ConcurrentBPlusTree<Key, Value>::searchNode(const Key* keys, int count, int capacity, const Key& key) {
+    int n = std::min(std::max(count, 0), capacity);
+    const Key* base = keys;
+    while (n > 16) {
+        int half = n / 2;
+        base = (Upper ? !(key < base[half]) : base[half] < key) ? base + half : base;
+        n -= half;
+    }
+    int index = static_cast<int>(base - keys);
+    for (int i = 0; i < n; ++i) {
+        index += (Upper ? !(key < base[i]) : base[i] < key) ? 1 : 0;
+    }
+    return index;
+}
+
+template<typename Key, typename Value>
+bool ConcurrentBPlusTree<Key, Value>::search(const Key& key, Value& value) const {
+    bool found = false;
+    while (!trySearch(key, value, found)) {
+        restarts.fetch_add(1, std::memory_order_relaxed);
+    }
+    return found;
+}
+
+template<typename Key, typename Value>
+bool ConcurrentBPlusTree<Key, Value>::trySearch(const Key& key, Value& value, bool& found) const {
+    const Node* node = root.load(std::memory_order_acquire);
+    uint64_t version = readLock(node);
+    if (node != root.load(std::memory_order_acquire)) {
+        return false;
+    }
+    
+    const Inner* parent = nullptr;
+    uint64_t parentVersion = 0;
+    while (!node->isLeaf) {
+        const Inner* inner = static_cast<const Inner*>(node);
+        int index = searchNode<true>(inner->keys, inner->count, INNER_CAPACITY, key);
+        const Node* child = inner->children[index];
+        if (!validate(inner, version)) {
+            return false;
+        }
+        
+        // The child's version is read before the parent is let go, so a
+        // split of the child that moved our key elsewhere is noticed
+        uint64_t childVersion = readLock(child);
+        if (parent != nullptr && !validate(parent, parentVersion)) {
+            return false;
+        }
+        parent = inner;
+        parentVersion = version;
+        node = child;
+        version = childVersion;
+    }
+    
+    const Leaf* leaf = static_cast<const Leaf*>(node);
+    int index = searchNode<false>(leaf->keys, leaf->count, LEAF_CAPACITY, key);
+    bool match = index < leaf->count && index < LEAF_CAPACITY && !(key < leaf->keys[index]);
+    Value candidate;
+    if (match) {
+        candidate = leaf->values[index];
+    }
+    if (!validate(leaf, version) || (parent != nullptr && !validate(parent, parentVersion))) {
+        return false;
+    }
+    found = match;
+    if (match) {
+        value = candidate;
+    }
+    return true;
+}
+
+template<typename Key, typename Value>
+void ConcurrentBPlusTree<Key, Value>::insert(const Key& key, const Value& value) {
+    while (!tryInsert(key, value)) {
+        restarts.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+template<typename Key, typename Value>
+bool ConcurrentBPlusTree<Key, Value>::tryInsert(const Key& key, const Value& value) {
+    Node* node = root.load(std::memory_order_acquire);
+    uint64_t version = readLock(node);
+    if (node != root.load(std::memory_order_acquire)) {
+        return false;
+    }
+    
+    Inner* parent = nullptr;
+    uint64_t parentVersion = 0;
+    while (!node->isLeaf) {
+        Inner* inner = static_cast<Inner*>(node);
+        if (inner->count == INNER_CAPACITY) {
+            // Split full inner nodes on the way down, so the parent of any
+            // node that splits below has room for the new separator
+            if (parent != nullptr && !upgrade(parent, parentVersion)) {
+                return false;
+            }
+            if (!upgrade(inner, version)) {
+                if (parent != nullptr) {
+                    writeUnlock(parent);
+                }
+                return false;
+            }
+            if (parent == nullptr && inner != root.load(std::memory_order_acquire)) {
+                writeUnlock(inner);
+                return false;
+            }
+            Key separator;
+            Inner* sibling = splitInner(inner, separator);
+            insertChild(parent, inner, separator, sibling);
+            writeUnlock(inner);
+            if (parent != nullptr) {
+                writeUnlock(parent);
+            }
+            return tryInsert(key, value);
+        }
+        
+        int index = searchNode<true>(inner->keys, inner->count, INNER_CAPACITY, key);
+        Node* child = inner->children[index];
+        if (!validate(inner, version)) {
+            return false;
+        }
+        uint64_t childVersion = readLock(child);
+        if (parent != nullptr && !validate(parent, parentVersion)) {
+            return false;
+        }
+        parent = inner;
+        parentVersion = version;
+        node = child;
+        version = childVersion;
+    }
+    
+    Leaf* leaf = static_cast<Leaf*>(node);
+    if (leaf->count == LEAF_CAPACITY) {
+        // Split, then descend again to whichever half takes the key
+        if (parent != nullptr && !upgrade(parent, parentVersion)) {
+            return false;
+        }
+        if (!upgrade(leaf, version)) {
+            if (parent != nullptr) {
+                writeUnlock(parent);
+            }
+            return false;
+        }
+        if (parent == nullptr && leaf != root.load(std::memory_order_acquire)) {
+            writeUnlock(leaf);
+            return false;
+        }
+        Key separator;
+        Leaf* sibling = splitLeaf(leaf, separator);
+        insertChild(parent, leaf, separator, sibling);
+        writeUnlock(leaf);
+        if (parent != nullptr) {
+            writeUnlock(parent);
+        }
+        return tryInsert(key, value);
+    }
+    
+    if (!upgrade(leaf, version)) {
+        return false;
+    }
+    if (parent != nullptr && !validate(parent, parentVersion)) {
+        writeUnlock(leaf);
+        return false;
+    }
+    int index = searchNode<false>(leaf->keys, leaf->count, LEAF_CAPACITY, key);
+    if (index < leaf->count && !(key < leaf->keys[index])) {
+        leaf->values[index] = value;
+    } else {
+        for (int i = leaf->count; i > index; --i) {
+            leaf->keys[i] = leaf->keys[i - 1];
+            leaf->values[i] = leaf->values[i - 1];
+        }
+        leaf->keys[index] = key;
+        leaf->values[index] = value;
+        leaf->count++;
+    }
+    writeUnlock(leaf);
+    return true;
+}
+
+template<typename Key, typename Value>
+typename ConcurrentBPlusTree<Key, Value>::Leaf* ConcurrentBPlusTree<Key, Value>::splitLeaf(Leaf* leaf, Key& separator) {
+    int keep = LEAF_CAPACITY / 2;
+    Leaf* right = new Leaf();
+    std::copy(leaf->keys + keep, leaf->keys + LEAF_CAPACITY, right->keys);
+    std::copy(leaf->values + keep, leaf->values + LEAF_CAPACITY, right->values);
+    right->count = LEAF_CAPACITY - keep;
+    leaf->count = keep;
+    separator = right->keys[0];
+    return right;
+}
+
+template<typename Key, typename Value>
+typename ConcurrentBPlusTree<Key, Value>::Inner* ConcurrentBPlusTree<Key, Value>::splitInner(Inner* inner, Key& separator) {
+    // The middle key moves up to the parent
+    int middle = INNER_CAPACITY / 2;
+    Inner* right = new Inner();
+    separator = inner->keys[middle];
+    std::copy(inner->keys + middle + 1, inner->keys + INNER_CAPACITY, right->keys);
+    std::copy(inner->children + middle + 1, inner->children + INNER_CAPACITY + 1, right->children);
+    right->count = INNER_CAPACITY - middle - 1;
+    inner->count = middle;
+    return right;
+}
+
+template<typename Key, typename Value>
+void ConcurrentBPlusTree<Key, Value>::insertChild(Inner* parent, Node* left, const Key& separator, Node* right) {
+    if (parent == nullptr) {
+        // The root split: readers that still hold the old root notice its
+        // version change or the new root pointer and restart
+        Inner* newRoot = new Inner();
+        newRoot->keys[0] = separator;
+        newRoot->children[0] = left;
+        newRoot->children[1] = right;
+        newRoot->count = 1;
+        root.store(newRoot, std::memory_order_release);
+        height.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    int index = searchNode<true>(parent->keys, parent->count, INNER_CAPACITY, separator);
+    for (int i = parent->count; i > index; --i) {
+        parent->keys[i] = parent->keys[i - 1];
+        parent->children[i + 1] = parent->children[i];
+    }
+    parent->keys[index] = separator;
+    parent->children[index + 1] = right;
+    parent->count++;
+}
+
+template<typename Key, typename Value>
+bool ConcurrentBPlusTree<Key, Value>::remove(const Key& key) {
+    bool removed = false;
+    while (!tryRemove(key, removed)) {
+        restarts.fetch_add(1, std::memory_order_relaxed);
+    }
+    return removed;
+}
+
+template<typename Key, typename Value>
+bool ConcurrentBPlusTree<Key, Value>::tryRemove(const Key& key, bool& removed) {
+    Node* node = root.load(std::memory_order_acquire);
+    uint64_t version = readLock(node);
+    if (node != root.load(std::memory_order_acquire)) {
+        return false;
+    }
+    
+    Inner* parent = nullptr;
+    uint64_t parentVersion = 0;
+    while (!node->isLeaf) {
+        Inner* inner = static_cast<Inner*>(node);
+        int index = searchNode<true>(inner->keys, inner->count, INNER_CAPACITY, key);
+        Node* child = inner->children[index];
+        if (!validate(inner, version)) {
+            return false;
+        }
+        uint64_t childVersion = readLock(child);
+        if (parent != nullptr && !validate(parent, parentVersion)) {
+            return false;
+        }
+        parent = inner;
+        parentVersion = version;
+        node = child;
+        version = childVersion;
+    }
+    
+    // Leaves may run empty; they are only reclaimed with the tree
+    Leaf* leaf = static_cast<Leaf*>(node);
+    if (!upgrade(leaf, version)) {
+        return false;
+    }
+    if (parent != nullptr && !validate(parent, parentVersion)) {
+        writeUnlock(leaf);
+        return false;
+    }
+    int index = searchNode<false>(leaf->keys, leaf->count, LEAF_CAPACITY, key);
+    removed = index < leaf->count && !(key < leaf->keys[index]);
+    if (removed) {
+        for (int i = index + 1; i < leaf->count; ++i) {
+            leaf->keys[i - 1] = leaf->keys[i];
+            leaf->values[i - 1] = leaf->values[i];
+        }
+        leaf->count--;
+    }
+    writeUnlock(leaf);
+    return true;
+}
+
+template<typename Key, typename Value>
+size_t ConcurrentBPlusTree<Key, Value>::getSize() const {
+    return countRecursive(root.load(std::memory_order_acquire));
+}
+
+template<typename Key, typename Value>
+int ConcurrentBPlusTree<Key, Value>::getHeight() const {
+    return height.load(std::memory_order_relaxed);
+}
+
+template<typename Key, typename Value>
+uint64_t ConcurrentBPlusTree<Key, Value>::getRestarts() const {
+    return restarts.load(std::memory_order_relaxed);
+}
+
+template<typename Key, typename Value>
+void ConcurrentBPlusTree<Key, Value>::destroyRecursive(Node* node) {
+    if (node->isLeaf) {
+        delete static_cast<Leaf*>(node);
+        return;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    for (int i = 0; i <= inner->count; ++i) {
+        destroyRecursive(inner->children[i]);
+    }
+    delete inner;
+}
+
+template<typename Key, typename Value>
+size_t ConcurrentBPlusTree<Key, Value>::countRecursive(const Node* node) {
+    if (node->isLeaf) {
+        return static_cast<size_t>(node->count);
+    }
+    const Inner* inner = static_cast<const Inner*>(node);
+    size_t total = 0;
+    for (int i = 0; i <= inner->count; ++i) {
+        total += countRecursive(inner->children[i]);
+    }
+    return total;
+}
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_CONCURRENT_BPLUS_TREE_H
@@ -0,0 +1,153 @@
+#include "concurrent_bplus_tree.h"
+#include <iostream>
+#include <cassert>
+#include <map>
+#include <random>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+using namespace phantomdb::storage;
+
+void testBasicOperations() {
+    std::cout << "Testing basic concurrent B+tree operations..." << std::endl;
+    
+    ConcurrentBPlusTree<int, int> tree;
+    int value;
+    assert(!tree.search(1, value));
+    assert(!tree.remove(1));
+    assert(tree.getHeight() == 1);
+    
+    // Enough random keys for several levels, checked against std::map
+    std::map<int, int> reference;
+    std::mt19937 rng(7);
+    for (int i = 0; i < 200000; ++i) {
+        int key = static_cast<int>(rng() % 400000);
+        tree.insert(key, i);
+        reference[key] = i;
+    }
+    assert(tree.getHeight() >= 3);
+    assert(tree.getSize() == reference.size());
+    for (int key = 0; key < 400000; ++key) {
+        auto it = reference.find(key);
+        assert(tree.search(key, value) == (it != reference.end()));
+        if (it != reference.end()) {
+            assert(value == it->second);
+        }
+    }
+    
+    // Remove every other key; leaves may empty out but lookups stay right
+    for (auto it = reference.begin(); it != reference.end();) {
+        assert(tree.remove(it->first));
+        assert(!tree.remove(it->first));
+        it = reference.erase(it);
+        if (it != reference.end()) {
+            ++it;
+        }
+    }
+    assert(tree.getSize() == reference.size());
+    for (const auto& entry : reference) {
+        assert(tree.search(entry.first, value) && value == entry.second);
+    }
+    
+    // No restarts without contention
+    assert(tree.getRestarts() == 0);
+    
+    std::cout << "Basic operations test passed!" << std::endl;
+}
+
+void testConcurrentInserts() {
+    std::cout << "Testing concurrent inserts and lookups..." << std::endl;
+    
+    ConcurrentBPlusTree<int64_t, int64_t> tree;
+    const int preloaded = 50000;
+    for (int64_t key = 0; key < preloaded; ++key) {
+        tree.insert(key * 2, key);
+    }
+    
+    // Writers add the odd keys while readers keep finding the even ones
+    const int writers = 4;
+    const int perWriter = 50000;
+    std::atomic<bool> done(false);
+    std::atomic<long> missed(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writers; ++t) {
+        threads.emplace_back([&tree, t]() {
+            for (int64_t i = t; i < writers * perWriter; i += writers) {
+                tree.insert(i * 2 + 1, -i);
+            }
+        });
+    }
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&tree, &done, &missed, t]() {
+            std::mt19937 rng(t);
+            int64_t value;
+            while (!done) {
+                int64_t key = rng() % preloaded;
+                if (!tree.search(key * 2, value) || value != key) {
+                    missed++;
+                }
+            }
+        });
+    }
+    for (int t = 0; t < writers; ++t) {
+        threads[t].join();
+    }
+    done = true;
+    for (size_t t = writers; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    
+    assert(missed == 0);
+    assert(tree.getSize() == static_cast<size_t>(preloaded + writers * perWriter));
+    int64_t value;
+    for (int64_t i = 0; i < writers * perWriter; ++i) {
+        assert(tree.search(i * 2 + 1, value) && value == -i);
+    }
+    
+    std::cout << "Concurrent inserts test passed!" << std::endl;
+}
+
+void testConcurrentInsertsAndRemoves() {
+    std::cout << "Testing concurrent inserts and removes..." << std::endl;
+    
+    ConcurrentBPlusTree<int, int> tree;
+    
+    // Each thread owns the keys equal to its number modulo the thread count
+    const int threadCount = 8;
+    const int keysPerThread = 20000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&tree, t]() {
+            for (int i = 0; i < keysPerThread; ++i) {
+                tree.insert(i * threadCount + t, t);
+            }
+            for (int i = 0; i < keysPerThread; i += 2) {
+                assert(tree.remove(i * threadCount + t));
+            }
+            for (int i = 0; i < keysPerThread; ++i) {
+                int value;
+                assert(tree.search(i * threadCount + t, value) == (i % 2 == 1));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    assert(tree.getSize() == static_cast<size_t>(threadCount * keysPerThread / 2));
+    
+    std::cout << "Concurrent inserts and removes test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running concurrent B+tree tests..." << std::endl;
+    
+    testBasicOperations();
+    testConcurrentInserts();
+    testConcurrentInsertsAndRemoves();
+    
+    std::cout << "All concurrent B+tree tests passed!" << std::endl;
+    return 0;
+}
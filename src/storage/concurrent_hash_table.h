@@ -0,0 +1,182 @@
+#ifndef PHANTOMDB_CONCURRENT_HASH_TABLE_H
+#define PHANTOMDB_CONCURRENT_HASH_TABLE_H
+
+#include "swiss_table.h"
+#include "lock_striping.h"
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <cstddef>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * @brief Thread-safe hash map made of lock-striped Swiss tables
+ * 
+ * Keys are spread over a power-of-two number of stripes (see
+ * lock_striping.h), and each stripe is a SwissTable behind its own
+ * reader-writer lock. Lookups take a shared lock on one stripe, so readers never block
+ * each other, and a writer blocks only the keys of its own stripe.
+ * 
+ * Stripes grow independently and incrementally (see SwissTable), so there
+ * is no stop-the-world rehash: a write that triggers a resize allocates the
+ * larger table of one stripe and moves a couple of groups, and the rest of
+ * the move is spread over later writes to that stripe.
+ * 
+ * Keys are unique: inserting an existing key replaces its value.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class ConcurrentHashTable {
+public:
+    static const size_t DEFAULT_STRIPES = 64;
+    
+    /**
+     * @brief Construct an empty table
+     * @param requestedStripes Number of independently locked stripes, rounded
+     *        up to a power of two; more stripes mean less contention between writers
+     */
+    explicit ConcurrentHashTable(size_t requestedStripes = DEFAULT_STRIPES);
+    
+    ConcurrentHashTable(const ConcurrentHashTable&) = delete;
+    ConcurrentHashTable& operator=(const ConcurrentHashTable&) = delete;
+    
+    // Insert a key-value pair, replacing the value of an existing key
+    void insert(const Key& key, const Value& value);
+    
+    // Search for a key
+    bool search(const Key& key, Value& value) const;
+    
+    // Remove a key
+    bool remove(const Key& key);
+    
+    // Remove every key
+    void clear();
+    
+    // Call fn(key, value) for every entry, one stripe at a time; entries
+    // written concurrently may or may not be seen
+    template<typename Fn>
+    void forEach(Fn fn) const;
+    
+    // Number of entries
+    size_t getCount() const;
+    
+    // Bytes held by all stripes
+    size_t getMemoryUsage() const;
+    
+    // Number of stripes
+    size_t getStripeCount() const;
+    
+    // Number of stripes with an incremental resize under way
+    size_t getResizingStripes() const;
+
+private:
+    struct alignas(STRIPE_ALIGNMENT) Stripe {
+        mutable std::shared_mutex mutex;
+        SwissTable<Key, Value, Hash> table;
+    };
+    
+    using SharedLock = std::shared_lock<std::shared_mutex>;
+    using ExclusiveLock = std::unique_lock<std::shared_mutex>;
+    
+    std::unique_ptr<Stripe[]> stripes;
+    size_t stripeCount;
+    int stripeCountBits;  // log2(stripeCount)
+    
+    Stripe& stripeFor(size_t hash) const;
+};
+
+// Implementation
+template<typename Key, typename Value, typename Hash>
+ConcurrentHashTable<Key, Value, Hash>::ConcurrentHashTable(size_t requestedStripes)
+    : stripeCount(static_cast<size_t>(1) << stripeBits(requestedStripes)), stripeCountBits(stripeBits(requestedStripes)) {
+    stripes.reset(new Stripe[stripeCount]);
+}
+
+template<typename Key, typename Value, typename Hash>
+typename ConcurrentHashTable<Key, Value, Hash>::Stripe&
+ConcurrentHashTable<Key, Value, Hash>::stripeFor(size_t hash) const {
+    return stripes[stripeOf(hash, stripeCountBits)];
+}
+
+template<typename Key, typename Value, typename Hash>
+void ConcurrentHashTable<Key, Value, Hash>::insert(const Key& key, const Value& value) {
+    size_t hash = stripes[0].table.hashOf(key);
+    Stripe& stripe = stripeFor(hash);
+    ExclusiveLock lock(stripe.mutex);
+    stripe.table.insert(key, value, hash);
+}
+
+template<typename Key, typename Value, typename Hash>
+bool ConcurrentHashTable<Key, Value, Hash>::search(const Key& key, Value& value) const {
+    size_t hash = stripes[0].table.hashOf(key);
+    Stripe& stripe = stripeFor(hash);
+    SharedLock lock(stripe.mutex);
+    return stripe.table.search(key, value, hash);
+}
+
+template<typename Key, typename Value, typename Hash>
+bool ConcurrentHashTable<Key, Value, Hash>::remove(const Key& key) {
+    size_t hash = stripes[0].table.hashOf(key);
+    Stripe& stripe = stripeFor(hash);
+    ExclusiveLock lock(stripe.mutex);
+    return stripe.table.remove(key, hash);
+}
+
+template<typename Key, typename Value, typename Hash>
+void ConcurrentHashTable<Key, Value, Hash>::clear() {
+    for (size_t i = 0; i < stripeCount; ++i) {
+        ExclusiveLock lock(stripes[i].mutex);
+        stripes[i].table.clear();
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+template<typename Fn>
+void ConcurrentHashTable<Key, Value, Hash>::forEach(Fn fn) const {
+    for (size_t i = 0; i < stripeCount; ++i) {
+        SharedLock lock(stripes[i].mutex);
+        stripes[i].table.forEach(fn);
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t ConcurrentHashTable<Key, Value, Hash>::getCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < stripeCount; ++i) {
+        SharedLock lock(stripes[i].mutex);
+        count += stripes[i].table.getCount();
+    }
+    return count;
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t ConcurrentHashTable<Key, Value, Hash>::getMemoryUsage() const {
+    size_t bytes = sizeof(Stripe) * stripeCount;
+    for (size_t i = 0; i < stripeCount; ++i) {
+        SharedLock lock(stripes[i].mutex);
+        bytes += stripes[i].table.getMemoryUsage();
+    }
+    return bytes;
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t ConcurrentHashTable<Key, Value, Hash>::getStripeCount() const {
+    return stripeCount;
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t ConcurrentHashTable<Key, Value, Hash>::getResizingStripes() const {
+    size_t resizing = 0;
+    for (size_t i = 0; i < stripeCount; ++i) {
+        SharedLock lock(stripes[i].mutex);
+        resizing += stripes[i].table.isResizing() ? 1 : 0;
+    }
+    return resizing;
+}
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_CONCURRENT_HASH_TABLE_H
@@ -0,0 +1,159 @@
+#include "concurrent_hash_table.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <unordered_map>
+#include <random>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+using namespace phantomdb::storage;
+
+void testBasicOperations() {
+    std::cout << "Testing basic concurrent hash table operations..." << std::endl;
+    
+    ConcurrentHashTable<std::string, int> table(10);
+    assert(table.getStripeCount() == 16);
+    int value;
+    assert(!table.search("one", value));
+    assert(!table.remove("one"));
+    
+    // Random operations on one thread, checked against std::unordered_map
+    std::unordered_map<std::string, int> reference;
+    std::mt19937 rng(11);
+    for (int i = 0; i < 100000; ++i) {
+        std::string key = "key" + std::to_string(rng() % 20000);
+        switch (rng() % 3) {
+            case 0:
+                assert(table.remove(key) == (reference.erase(key) == 1));
+                break;
+            default:
+                table.insert(key, i);
+                reference[key] = i;
+                break;
+        }
+    }
+    assert(table.getCount() == reference.size());
+    for (const auto& entry : reference) {
+        assert(table.search(entry.first, value) && value == entry.second);
+    }
+    size_t visited = 0;
+    table.forEach([&reference, &visited](const std::string& key, int value) {
+        assert(reference.at(key) == value);
+        visited++;
+    });
+    assert(visited == reference.size());
+    
+    // A single stripe behaves like a plain Swiss table
+    ConcurrentHashTable<int, int> single(1);
+    assert(single.getStripeCount() == 1);
+    single.insert(7, 49);
+    assert(single.search(7, value) && value == 49);
+    
+    table.clear();
+    assert(table.getCount() == 0);
+    assert(!table.search("key1", value));
+    
+    std::cout << "Basic operations test passed!" << std::endl;
+}
+
+void testLookupsDuringResize() {
+    std::cout << "Testing lookups while stripes resize..." << std::endl;
+    
+    ConcurrentHashTable<int64_t, int64_t> table;
+    const int preloaded = 20000;
+    for (int64_t key = 0; key < preloaded; ++key) {
+        table.insert(key, key * 10);
+    }
+    
+    // Writers grow the table many times over; readers must keep finding the preloaded keys
+    const int writers = 4;
+    const int perWriter = 100000;
+    std::atomic<bool> done(false);
+    std::atomic<long> missed(0);
+    std::atomic<bool> sawResize(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writers; ++t) {
+        threads.emplace_back([&table, t]() {
+            for (int64_t i = t; i < writers * perWriter; i += writers) {
+                table.insert(preloaded + i, -i);
+            }
+        });
+    }
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&table, &done, &missed, &sawResize, t]() {
+            std::mt19937 rng(t);
+            int64_t value;
+            while (!done) {
+                int64_t key = rng() % preloaded;
+                if (!table.search(key, value) || value != key * 10) {
+                    missed++;
+                }
+                if (t == 0 && table.getResizingStripes() > 0) {
+                    sawResize = true;
+                }
+            }
+        });
+    }
+    for (int t = 0; t < writers; ++t) {
+        threads[t].join();
+    }
+    done = true;
+    for (size_t t = writers; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    
+    assert(missed == 0);
+    assert(sawResize);
+    assert(table.getCount() == static_cast<size_t>(preloaded + writers * perWriter));
+    int64_t value;
+    for (int64_t i = 0; i < writers * perWriter; ++i) {
+        assert(table.search(preloaded + i, value) && value == -i);
+    }
+    
+    std::cout << "Lookups during resize test passed!" << std::endl;
+}
+
+void testConcurrentInsertsAndRemoves() {
+    std::cout << "Testing concurrent inserts and removes..." << std::endl;
+    
+    ConcurrentHashTable<int, int> table(8);
+    
+    // Each thread owns the keys equal to its number modulo the thread count
+    const int threadCount = 8;
+    const int keysPerThread = 20000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&table, t]() {
+            for (int i = 0; i < keysPerThread; ++i) {
+                table.insert(i * threadCount + t, t);
+            }
+            for (int i = 0; i < keysPerThread; i += 2) {
+                assert(table.remove(i * threadCount + t));
+            }
+            for (int i = 0; i < keysPerThread; ++i) {
+                int value;
+                assert(table.search(i * threadCount + t, value) == (i % 2 == 1));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    assert(table.getCount() == static_cast<size_t>(threadCount * keysPerThread / 2));
+    
+    std::cout << "Concurrent inserts and removes test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running concurrent hash table tests..." << std::endl;
+    
+    testBasicOperations();
+    testLookupsDuringResize();
+    testConcurrentInsertsAndRemoves();
+    
+    std::cout << "All concurrent hash table tests passed!" << std::endl;
+    return 0;
+}
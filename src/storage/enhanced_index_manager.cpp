@@ -1,24 +1,38 @@
 #include "enhanced_index_manager.h"
-#include "btree.h"
-#include "hash_table.h"
+#include "bplus_tree.h"
+#include "front_coded_btree.h"
+#include "concurrent_hash_table.h"
 #include "lsm_tree.h"
+#include "bitmap_index.h"
+#include "fulltext_index.h"
+#include "lookup_cache.h"
+#include "index_file.h"
 #include <iostream>
 #include <unordered_map>
 #include <string>
 #include <memory>
 #include <chrono>
 #include <fstream>
+#include <filesystem>
 #include <sstream>
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <cerrno>
+#include <cstdlib>
 
 namespace phantomdb {
 namespace storage {
 
 // Forward declarations for index types
 template<typename Key, typename Value>
-class BTree;
+class BPlusTree;
 
-template<typename Key, typename Value>
-class HashTable;
+template<typename Key, typename Value, typename Hash>
+class ConcurrentHashTable;
 
 template<typename Key, typename Value>
 class LSMTREE;
@@ -26,7 +40,16 @@ class LSMTREE;
 class EnhancedIndexManager::Impl {
 public:
     Impl() = default;
-    ~Impl() = default;
+    
+    ~Impl() {
+        for (auto& build : builds) {
+            stopBuild(*build.second);
+        }
+        if (ownsIndexDirectory) {
+            std::error_code ec;
+            std::filesystem::remove_all(indexDirectory, ec);
+        }
+    }
     
     bool createIndex(const std::string& tableName, const std::string& columnName, 
                     IndexType type, const IndexConfig& config) {
@@ -45,9 +68,13 @@ public:
         switch (type) {
             case IndexType::B_TREE:
                 {
-                    // Create a B-tree index
-                    auto btreeIndex = std::make_unique<BTree<std::string, std::string>>();
-                    btreeIndexes[indexName] = std::move(btreeIndex);
+                    // Create a B-tree index, front-coded when compression is on
+                    if (config.useCompression) {
+                        frontCodedBtreeIndexes[indexName] = std::make_unique<FrontCodedBTree>();
+                    } else {
+                        btreeIndexes[indexName] = std::make_unique<BPlusTree<std::string, std::string>>();
+                    }
+                    lookupCaches[indexName] = std::make_unique<LookupCache<std::string, std::string>>(config.cacheSize);
                     indexes[indexName] = {tableName, columnName, type};
                     indexStats[indexName] = IndexStats{indexName, type, 0, 0, 0, 0.0, 0.0, 0.0, 0, 0};
                     std::cout << "Created B-tree index: " << indexName << std::endl;
@@ -56,7 +83,7 @@ public:
             case IndexType::HASH:
                 {
                     // Create a Hash table index
-                    auto hashIndex = std::make_unique<HashTable<std::string, std::string>>();
+                    auto hashIndex = std::make_unique<ConcurrentHashTable<std::string, std::string>>();
                     hashIndexes[indexName] = std::move(hashIndex);
                     indexes[indexName] = {tableName, columnName, type};
                     indexStats[indexName] = IndexStats{indexName, type, 0, 0, 0, 0.0, 0.0, 0.0, 0, 0};
@@ -66,21 +93,120 @@ public:
             case IndexType::LSM_TREE:
                 {
                     // Create an LSM-tree index
-                    auto lsmTreeIndex = std::make_unique<LSMTREE<std::string, std::string>>();
+                    LSMCompactionOptions options;
+                    options.style = config.compactionStyle;
+                    options.bloomBitsPerKey = config.bloomBitsPerKey;
+                    options.frontCoding = config.useCompression;
+                    auto lsmTreeIndex = std::make_unique<LSMTREE<std::string, std::string>>(
+                        LSMTREE<std::string, std::string>::DEFAULT_MEMTABLE_SIZE, "", options);
                     lsmTreeIndexes[indexName] = std::move(lsmTreeIndex);
+                    lookupCaches[indexName] = std::make_unique<LookupCache<std::string, std::string>>(config.cacheSize);
                     indexes[indexName] = {tableName, columnName, type};
                     indexStats[indexName] = IndexStats{indexName, type, 0, 0, 0, 0.0, 0.0, 0.0, 0, 0};
                     std::cout << "Created LSM-tree index: " << indexName << std::endl;
                 }
                 break;
+            case IndexType::BITMAP:
+                {
+                    // Create a bitmap index: column value -> row ids
+                    bitmapIndexes[indexName] = std::make_unique<BitmapIndex>();
+                    indexes[indexName] = {tableName, columnName, type};
+                    indexStats[indexName] = IndexStats{indexName, type, 0, 0, 0, 0.0, 0.0, 0.0, 0, 0};
+                    std::cout << "Created Bitmap index: " << indexName << std::endl;
+                }
+                break;
+            case IndexType::FULLTEXT:
+                {
+                    // Create a full-text index: document key -> text
+                    fullTextIndexes[indexName] = std::make_unique<FullTextIndex>();
+                    indexes[indexName] = {tableName, columnName, type};
+                    indexStats[indexName] = IndexStats{indexName, type, 0, 0, 0, 0.0, 0.0, 0.0, 0, 0};
+                    std::cout << "Created Full-text index: " << indexName << std::endl;
+                }
+                break;
             default:
                 std::cerr << "Unsupported index type: " << static_cast<int>(type) << std::endl;
                 return false;
         }
+        lookupCounters[indexName] = std::make_unique<LookupCounters>();
         
         return true;
     }
     
+    bool createIndexOnline(const std::string& tableName, const std::string& columnName, IndexType type,
+                           const IndexConfig& config, IndexBuildScan scan, size_t threads, uint64_t estimatedRows) {
+        if (type != IndexType::B_TREE && type != IndexType::HASH) {
+            std::cerr << "Online builds only supported for B-tree and hash indexes" << std::endl;
+            return false;
+        }
+        if (!scan) {
+            std::cerr << "Online index build needs a table scan" << std::endl;
+            return false;
+        }
+        
+        // Register the index empty; its trees stay placeholders until the
+        // build is switched in
+        if (!createIndex(tableName, columnName, type, config)) {
+            return false;
+        }
+        std::string indexName = tableName + "_" + columnName + "_idx";
+        auto build = std::make_unique<IndexBuild>();
+        IndexBuild* raw = build.get();
+        raw->fillFactor = config.fillFactor;
+        raw->partitions = threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        raw->estimatedRows = estimatedRows;
+        raw->scan = std::move(scan);
+        if (type == IndexType::HASH) {
+            raw->hash = std::make_unique<ConcurrentHashTable<std::string, std::string>>();
+            auto& slot = hashIndexes[indexName];
+            raw->install = [raw, &slot]() {
+                slot.swap(raw->hash);
+                return slot->getCount();
+            };
+        } else if (config.useCompression) {
+            raw->frontCodedBtree = std::make_unique<FrontCodedBTree>();
+            auto& slot = frontCodedBtreeIndexes[indexName];
+            raw->install = [raw, &slot]() {
+                slot.swap(raw->frontCodedBtree);
+                return slot->getSize();
+            };
+        } else {
+            raw->btree = std::make_unique<BPlusTree<std::string, std::string>>();
+            auto& slot = btreeIndexes[indexName];
+            raw->install = [raw, &slot]() {
+                slot.swap(raw->btree);
+                return slot->getSize();
+            };
+        }
+        raw->worker = std::thread(runBuild, raw);
+        builds[indexName] = std::move(build);
+        std::cout << "Started online build of index: " << indexName << " (" << raw->partitions
+                  << " partitions)" << std::endl;
+        return true;
+    }
+    
+    bool isIndexReady(const std::string& indexName) const {
+        return indexes.find(indexName) != indexes.end() && pendingBuild(indexName) == nullptr;
+    }
+    
+    bool finishIndexBuild(const std::string& indexName) {
+        return indexes.find(indexName) != indexes.end() && finishBuild(indexName) == nullptr;
+    }
+    
+    bool waitForIndexBuild(const std::string& indexName) {
+        auto buildIt = builds.find(indexName);
+        if (buildIt == builds.end()) {
+            return indexes.find(indexName) != indexes.end();
+        }
+        joinWorker(*buildIt->second);
+        if (finishBuild(indexName) != nullptr) {
+            std::cerr << "Online build failed for index: " << indexName << std::endl;
+            return false;
+        }
+        builds.erase(buildIt);
+        return true;
+    }
+    
     bool dropIndex(const std::string& indexName) {
         // Check if index exists
         if (indexes.find(indexName) == indexes.end()) {
@@ -88,11 +214,19 @@ public:
             return false;
         }
         
+        // Stop an online build before its trees go away
+        auto buildIt = builds.find(indexName);
+        if (buildIt != builds.end()) {
+            stopBuild(*buildIt->second);
+            builds.erase(buildIt);
+        }
+        
         // Remove from appropriate container based on type
         IndexInfo& info = indexes[indexName];
         switch (info.type) {
             case IndexType::B_TREE:
                 btreeIndexes.erase(indexName);
+                frontCodedBtreeIndexes.erase(indexName);
                 break;
             case IndexType::HASH:
                 hashIndexes.erase(indexName);
@@ -100,11 +234,27 @@ public:
             case IndexType::LSM_TREE:
                 lsmTreeIndexes.erase(indexName);
                 break;
+            case IndexType::BITMAP:
+                bitmapIndexes.erase(indexName);
+                break;
+            case IndexType::FULLTEXT:
+                fullTextIndexes.erase(indexName);
+                break;
             default:
                 break;
         }
         
         // Remove from tracking structures
+        mappedIndexes.erase(indexName);
+        lookupCaches.erase(indexName);
+        lookupCounters.erase(indexName);
+        compositeIndexes.erase(indexName);
+        
+        // Its file must not be loaded into a later index of the same name
+        if (!indexDirectory.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(std::filesystem::path(indexDirectory) / (indexName + ".idx"), ec);
+        }
         indexes.erase(indexName);
         indexConfigs.erase(indexName);
         indexStats.erase(indexName);
@@ -141,6 +291,15 @@ public:
             return false;
         }
         
+        // While an online build runs, writes go to its side log
+        bool captured;
+        if (logBuildWrite(indexName, SideLogEntry{false, key, value}, captured)) {
+            return captured;
+        }
+        if (!materialize(indexName)) {
+            return false;
+        }
+        
         // Start timing
         auto start = std::chrono::high_resolution_clock::now();
         
@@ -149,11 +308,10 @@ public:
         switch (it->second.type) {
             case IndexType::B_TREE:
                 {
-                    auto btreeIt = btreeIndexes.find(indexName);
-                    if (btreeIt != btreeIndexes.end()) {
-                        btreeIt->second->insert(key, value);
-                        result = true;
-                    }
+                    result = withBTree(indexName, [&key, &value](auto& tree) {
+                        tree.insert(key, value);
+                        return true;
+                    });
                 }
                 break;
             case IndexType::HASH:
@@ -174,9 +332,31 @@ public:
                     }
                 }
                 break;
+            case IndexType::BITMAP:
+                {
+                    // The key is the column value and the value a row id
+                    auto bitmapIt = bitmapIndexes.find(indexName);
+                    uint32_t rowId;
+                    if (bitmapIt != bitmapIndexes.end() && parseRowId(value, rowId)) {
+                        bitmapIt->second->insert(key, rowId);
+                        result = true;
+                    }
+                }
+                break;
+            case IndexType::FULLTEXT:
+                {
+                    // The key names the document and the value is its text
+                    auto fullTextIt = fullTextIndexes.find(indexName);
+                    if (fullTextIt != fullTextIndexes.end()) {
+                        fullTextIt->second->insert(key, value);
+                        result = true;
+                    }
+                }
+                break;
             default:
                 break;
         }
+        invalidateCached(indexName, key);
         
         // End timing
         auto end = std::chrono::high_resolution_clock::now();
@@ -202,6 +382,9 @@ public:
             std::cerr << "Index not found: " << indexName << std::endl;
             return false;
         }
+        if (!checkReady(indexName)) {
+            return false;
+        }
         
         // Start timing
         auto start = std::chrono::high_resolution_clock::now();
@@ -211,16 +394,20 @@ public:
         switch (it->second.type) {
             case IndexType::B_TREE:
                 {
-                    auto btreeIt = btreeIndexes.find(indexName);
-                    if (btreeIt != btreeIndexes.end()) {
-                        result = btreeIt->second->search(key, value);
-                    }
+                    result = withBTree(indexName, [this, &indexName, &key, &value](const auto& tree) {
+                        return cachedLookup(indexName, key, value, [&tree, &key](std::string& found) {
+                            return tree.search(key, found);
+                        });
+                    });
                 }
                 break;
             case IndexType::HASH:
                 {
+                    auto mappedIt = mappedIndexes.find(indexName);
                     auto hashIt = hashIndexes.find(indexName);
-                    if (hashIt != hashIndexes.end()) {
+                    if (mappedIt != mappedIndexes.end()) {
+                        result = mappedIt->second->get(key, value);
+                    } else if (hashIt != hashIndexes.end()) {
                         result = hashIt->second->search(key, value);
                     }
                 }
@@ -229,7 +416,44 @@ public:
                 {
                     auto lsmTreeIt = lsmTreeIndexes.find(indexName);
                     if (lsmTreeIt != lsmTreeIndexes.end()) {
-                        result = lsmTreeIt->second->search(key, value);
+                        const auto& lsmTree = *lsmTreeIt->second;
+                        result = cachedLookup(indexName, key, value, [&lsmTree, &key](std::string& found) {
+                            return lsmTree.search(key, found);
+                        });
+                    }
+                }
+                break;
+            case IndexType::BITMAP:
+                {
+                    // Every row with the value, as comma-separated row ids
+                    auto bitmapIt = bitmapIndexes.find(indexName);
+                    const RoaringBitmap* rows = bitmapIt != bitmapIndexes.end() ? bitmapIt->second->find(key) : nullptr;
+                    if (rows != nullptr) {
+                        value.clear();
+                        rows->forEach([&value](uint32_t rowId) {
+                            if (!value.empty()) {
+                                value += ',';
+                            }
+                            value += std::to_string(rowId);
+                        });
+                        result = true;
+                    }
+                }
+                break;
+            case IndexType::FULLTEXT:
+                {
+                    // The key is a query; every matching document key, best first
+                    auto fullTextIt = fullTextIndexes.find(indexName);
+                    if (fullTextIt != fullTextIndexes.end()) {
+                        std::vector<FullTextHit> hits = fullTextIt->second->search(key, 0, true);
+                        value.clear();
+                        for (const auto& hit : hits) {
+                            if (!value.empty()) {
+                                value += ',';
+                            }
+                            value += hit.key;
+                        }
+                        result = !hits.empty();
                     }
                 }
                 break;
@@ -241,15 +465,13 @@ public:
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
         
-        // Update statistics
-        auto statsIt = indexStats.find(indexName);
-        if (statsIt != indexStats.end()) {
-            if (result) {
-                statsIt->second.cacheHits++;
-            } else {
-                statsIt->second.cacheMisses++;
-            }
-            statsIt->second.avgLookupTime = (statsIt->second.avgLookupTime * (statsIt->second.cacheHits + statsIt->second.cacheMisses - 1) + duration.count()) / (statsIt->second.cacheHits + statsIt->second.cacheMisses);
+        // Update statistics; searches run concurrently, so only the
+        // atomic counters are touched here
+        auto countersIt = lookupCounters.find(indexName);
+        if (countersIt != lookupCounters.end()) {
+            countersIt->second->lookups.fetch_add(1, std::memory_order_relaxed);
+            countersIt->second->totalMicros.fetch_add(static_cast<uint64_t>(duration.count()),
+                                                      std::memory_order_relaxed);
         }
         
         if (!result) {
@@ -260,70 +482,324 @@ public:
     }
     
     bool rangeSearch(const std::string& indexName, const std::string& startKey, const std::string& endKey,
+                    std::vector<std::pair<std::string, std::string>>& results, size_t limit, bool descending) const {
+        if (limit == 0) {
+            limit = std::numeric_limits<size_t>::max();
+        }
+        return withOrderedIndex(indexName, "Range search", [&](const auto& tree) {
+            if (!descending) {
+                tree.scan(startKey, endKey, [&results](const auto& key, const auto& value) {
+                    results.emplace_back(key, value);
+                }, limit);
+                return true;
+            }
+            
+            // Walk back from the last key <= endKey
+            auto cursor = tree.upperBound(endKey);
+            cursor.prev();
+            for (size_t found = 0; found < limit && cursor.valid() && !(cursor.key() < startKey); ++found) {
+                results.emplace_back(cursor.key(), cursor.value());
+                cursor.prev();
+            }
+            return true;
+        });
+    }
+    
+    bool orderedScan(const std::string& indexName, size_t limit, bool descending,
                     std::vector<std::pair<std::string, std::string>>& results) const {
+        return withOrderedIndex(indexName, "Ordered scan", [&](const auto& tree) {
+            auto cursor = descending ? tree.last() : tree.first();
+            for (size_t found = 0; found < limit && cursor.valid(); ++found) {
+                results.emplace_back(cursor.key(), cursor.value());
+                if (descending) {
+                    cursor.prev();
+                } else {
+                    cursor.next();
+                }
+            }
+            return true;
+        });
+    }
+    
+    bool filterBitmap(const std::vector<BitmapPredicate>& predicates, std::vector<uint32_t>& rowIds) const {
+        RoaringBitmap rows;
+        if (!evaluateBitmapFilter(predicates, rows)) {
+            return false;
+        }
+        rowIds = rows.toVector();
+        return true;
+    }
+    
+    bool countBitmapFilter(const std::vector<BitmapPredicate>& predicates, uint64_t& count) const {
+        // One IN list is counted from the stored cardinalities alone
+        if (predicates.size() == 1 && !predicates[0].negate) {
+            const BitmapIndex* index = findBitmapIndex(predicates[0].indexName);
+            if (index == nullptr) {
+                return false;
+            }
+            count = index->estimateAny(predicates[0].values);
+            return true;
+        }
+        
+        RoaringBitmap rows;
+        if (!evaluateBitmapFilter(predicates, rows)) {
+            return false;
+        }
+        count = rows.cardinality();
+        return true;
+    }
+    
+    bool fullTextSearch(const std::string& indexName, const std::string& query,
+                        std::vector<std::pair<std::string, double>>& results, size_t limit, bool matchAll) const {
         auto it = indexes.find(indexName);
         if (it == indexes.end()) {
             std::cerr << "Index not found: " << indexName << std::endl;
             return false;
         }
+        auto fullTextIt = fullTextIndexes.find(indexName);
+        if (it->second.type != IndexType::FULLTEXT || fullTextIt == fullTextIndexes.end()) {
+            std::cerr << "Full-text search only supported for full-text indexes: " << indexName << std::endl;
+            return false;
+        }
         
-        // Only B-tree supports range search
-        if (it->second.type != IndexType::B_TREE) {
-            std::cerr << "Range search only supported for B-tree indexes: " << indexName << std::endl;
+        for (const auto& hit : fullTextIt->second->search(query, limit, matchAll)) {
+            results.emplace_back(hit.key, hit.score);
+        }
+        return true;
+    }
+    
+    bool createCompositeIndex(const std::string& tableName, const std::vector<IndexKeyColumn>& keyColumns,
+                              const std::vector<std::string>& includeColumns, const IndexConfig& config) {
+        if (keyColumns.empty()) {
+            std::cerr << "Composite index needs at least one key column" << std::endl;
             return false;
         }
+        std::string nameColumns;
+        std::string columnList;
+        CompositeIndexInfo info;
+        for (const auto& column : keyColumns) {
+            nameColumns += (nameColumns.empty() ? "" : "_") + column.name;
+            columnList += (columnList.empty() ? "" : ", ") + column.name;
+            info.keyColumns.push_back(column);
+            info.keyTypes.push_back(column.type);
+        }
+        info.keyTypes.push_back(KeyColumnType::STRING);  // The row id
+        info.includeColumns = includeColumns;
         
-        auto btreeIt = btreeIndexes.find(indexName);
-        if (btreeIt != btreeIndexes.end()) {
-            // For simplicity, we'll do a full scan and filter
-            // In a real implementation, we would use the B-tree's range search capabilities
-            std::cout << "Range search from '" << startKey << "' to '" << endKey << "' on index: " << indexName << std::endl;
-            return true;
+        if (!createIndex(tableName, nameColumns, IndexType::B_TREE, config)) {
+            return false;
+        }
+        std::string indexName = tableName + "_" + nameColumns + "_idx";
+        indexes[indexName].columnName = columnList;
+        compositeIndexes[indexName] = std::move(info);
+        return true;
+    }
+    
+    bool encodeIndexRow(const std::string& indexName, const std::vector<std::string>& keyValues,
+                        const std::string& rowId, const std::vector<std::string>& includeValues,
+                        std::string& key, std::string& value) const {
+        const CompositeIndexInfo* info = findCompositeIndex(indexName);
+        if (info == nullptr) {
+            return false;
+        }
+        if (includeValues.size() != info->includeColumns.size()) {
+            std::cerr << "Row does not match the INCLUDE columns of index: " << indexName << std::endl;
+            return false;
+        }
+        if (!encodeRowKey(indexName, *info, keyValues, rowId, key)) {
+            return false;
+        }
+        value = encodeValueList(includeValues);
+        return true;
+    }
+    
+    bool insertRow(const std::string& indexName, const std::vector<std::string>& keyValues,
+                   const std::string& rowId, const std::vector<std::string>& includeValues) {
+        std::string key;
+        std::string value;
+        return encodeIndexRow(indexName, keyValues, rowId, includeValues, key, value) &&
+               insertIntoIndex(indexName, key, value);
+    }
+    
+    bool deleteRow(const std::string& indexName, const std::vector<std::string>& keyValues,
+                   const std::string& rowId) {
+        const CompositeIndexInfo* info = findCompositeIndex(indexName);
+        std::string key;
+        return info != nullptr && encodeRowKey(indexName, *info, keyValues, rowId, key) &&
+               deleteFromIndex(indexName, key, nullptr, false);
+    }
+    
+    bool searchComposite(const std::string& indexName, const CompositeKeyRange& range,
+                         std::vector<IndexRow>& rows, size_t limit, bool descending) const {
+        const CompositeIndexInfo* info = findCompositeIndex(indexName);
+        if (info == nullptr) {
+            return false;
         }
         
-        std::cerr << "B-tree index not properly initialized: " << indexName << std::endl;
-        return false;
+        // Every row in range starts with the encoded prefix, then a bound
+        // on the next column; the upper end is excluded past all keys that
+        // start with the upper bound
+        size_t boundColumn = range.prefix.size();
+        bool bounded = range.hasLower || range.hasUpper;
+        std::string start;
+        if (boundColumn + (bounded ? 1 : 0) > info->keyColumns.size() ||
+            !encodeTupleKey(info->keyTypes, range.prefix, start)) {
+            std::cerr << "Invalid key range for index: " << indexName << std::endl;
+            return false;
+        }
+        std::string end = start;
+        if ((range.hasLower && !appendKeyColumn(start, info->keyTypes[boundColumn], range.lower)) ||
+            (range.hasUpper && !appendKeyColumn(end, info->keyTypes[boundColumn], range.upper))) {
+            std::cerr << "Invalid key range for index: " << indexName << std::endl;
+            return false;
+        }
+        end = prefixSuccessor(end);
+        
+        if (limit == 0) {
+            limit = std::numeric_limits<size_t>::max();
+        }
+        bool decoded = true;
+        auto emit = [&](const std::string& key, const std::string& value) {
+            IndexRow row;
+            std::vector<std::string> columns;
+            if (!decodeTupleKey(key, info->keyTypes, columns) || !decodeValueList(value, row.includeValues)) {
+                decoded = false;
+                return;
+            }
+            row.rowId = std::move(columns.back());
+            columns.pop_back();
+            row.keyValues = std::move(columns);
+            rows.push_back(std::move(row));
+        };
+        bool found = withOrderedIndex(indexName, "Composite search", [&](const auto& tree) {
+            if (!descending) {
+                auto cursor = tree.lowerBound(start);
+                for (size_t count = 0; count < limit && cursor.valid() && decoded &&
+                                       (end.empty() || cursor.key() < end); ++count) {
+                    emit(cursor.key(), cursor.value());
+                    cursor.next();
+                }
+                return true;
+            }
+            
+            // Walk back from the last key before end
+            auto cursor = end.empty() ? tree.last() : tree.lowerBound(end);
+            if (!end.empty()) {
+                cursor.prev();
+            }
+            for (size_t count = 0; count < limit && cursor.valid() && decoded && !(cursor.key() < start); ++count) {
+                emit(cursor.key(), cursor.value());
+                cursor.prev();
+            }
+            return true;
+        });
+        if (found && !decoded) {
+            std::cerr << "Corrupt entry in composite index: " << indexName << std::endl;
+            return false;
+        }
+        return found;
     }
     
-    bool deleteFromIndex(const std::string& indexName, const std::string& key) {
+    bool coversColumns(const std::string& indexName, const std::vector<std::string>& columns) const {
+        auto it = compositeIndexes.find(indexName);
+        if (it == compositeIndexes.end()) {
+            return false;
+        }
+        const CompositeIndexInfo& info = it->second;
+        for (const auto& column : columns) {
+            bool isKey = std::any_of(info.keyColumns.begin(), info.keyColumns.end(),
+                                     [&column](const IndexKeyColumn& key) { return key.name == column; });
+            if (!isKey && std::find(info.includeColumns.begin(), info.includeColumns.end(), column) ==
+                              info.includeColumns.end()) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    // Delete key, or for a bitmap index one row of it (value is the row id)
+    // or, with wholeValue, every row of it
+    bool deleteFromIndex(const std::string& indexName, const std::string& key, const std::string* value,
+                         bool wholeValue) {
         auto it = indexes.find(indexName);
         if (it == indexes.end()) {
             std::cerr << "Index not found: " << indexName << std::endl;
             return false;
         }
+        if (wholeValue && it->second.type != IndexType::BITMAP) {
+            std::cerr << "Only bitmap indexes hold several rows per key: " << indexName << std::endl;
+            return false;
+        }
+        bool captured;
+        if (logBuildWrite(indexName, SideLogEntry{true, key, std::string()}, captured)) {
+            return captured;
+        }
+        if (!materialize(indexName)) {
+            return false;
+        }
         
         // Start timing
         auto start = std::chrono::high_resolution_clock::now();
         
-        // Delete from appropriate index based on type
-        bool result = false;
+        // Delete from appropriate index based on type, counting the entries removed
+        uint64_t removed = 0;
         switch (it->second.type) {
             case IndexType::B_TREE:
                 {
-                    auto btreeIt = btreeIndexes.find(indexName);
-                    if (btreeIt != btreeIndexes.end()) {
-                        result = btreeIt->second->remove(key);
-                    }
+                    removed = withBTree(indexName, [&key](auto& tree) {
+                        return tree.remove(key);
+                    }) ? 1 : 0;
                 }
                 break;
             case IndexType::HASH:
                 {
                     auto hashIt = hashIndexes.find(indexName);
                     if (hashIt != hashIndexes.end()) {
-                        result = hashIt->second->remove(key);
+                        removed = hashIt->second->remove(key) ? 1 : 0;
                     }
                 }
                 break;
             case IndexType::LSM_TREE:
                 {
-                    // LSM-tree deletion is more complex, typically involves marking as deleted
-                    std::cout << "LSM-tree deletion not fully implemented for index: " << indexName << std::endl;
-                    result = true; // Simulate success
+                    // Writes a tombstone that hides the key in older sorted tables
+                    auto lsmTreeIt = lsmTreeIndexes.find(indexName);
+                    if (lsmTreeIt != lsmTreeIndexes.end()) {
+                        removed = lsmTreeIt->second->remove(key) ? 1 : 0;
+                    }
+                }
+                break;
+            case IndexType::BITMAP:
+                {
+                    // The key is the column value; each of its rows was one insert
+                    auto bitmapIt = bitmapIndexes.find(indexName);
+                    uint32_t rowId;
+                    if (bitmapIt == bitmapIndexes.end()) {
+                        break;
+                    }
+                    if (wholeValue) {
+                        const RoaringBitmap* rows = bitmapIt->second->find(key);
+                        removed = rows != nullptr ? rows->cardinality() : 0;
+                        bitmapIt->second->removeValue(key);
+                    } else if (value == nullptr) {
+                        std::cerr << "Bitmap index deletes need the row id: " << indexName << std::endl;
+                    } else if (parseRowId(*value, rowId)) {
+                        removed = bitmapIt->second->remove(key, rowId) ? 1 : 0;
+                    }
+                }
+                break;
+            case IndexType::FULLTEXT:
+                {
+                    auto fullTextIt = fullTextIndexes.find(indexName);
+                    if (fullTextIt != fullTextIndexes.end()) {
+                        removed = fullTextIt->second->remove(key) ? 1 : 0;
+                    }
                 }
                 break;
             default:
                 break;
         }
+        bool result = removed > 0;
+        invalidateCached(indexName, key);
         
         // End timing
         auto end = std::chrono::high_resolution_clock::now();
@@ -332,7 +808,7 @@ public:
         // Update statistics
         auto statsIt = indexStats.find(indexName);
         if (statsIt != indexStats.end() && result) {
-            statsIt->second.keyCount--;
+            statsIt->second.keyCount -= std::min<size_t>(removed, statsIt->second.keyCount);
             statsIt->second.avgDeleteTime = (statsIt->second.avgDeleteTime * (statsIt->second.keyCount) + duration.count()) / (statsIt->second.keyCount + 1);
         }
         
@@ -351,14 +827,49 @@ public:
             return false;
         }
         
+        if (!materialize(indexName)) {
+            return false;
+        }
+        
         // Start timing
         auto start = std::chrono::high_resolution_clock::now();
         
-        // Insert all key-value pairs
+        // A B-tree index taking a batch at least a quarter its size is
+        // rebuilt bottom up with the batch merged in (unless an online build
+        // is running; the batch then goes to its side log item by item)
         bool allSuccess = true;
-        for (const auto& pair : keyValuePairs) {
-            if (!insertIntoIndex(indexName, pair.first, pair.second)) {
-                allSuccess = false;
+        bool rebuilt = finishBuild(indexName) == nullptr && withBTree(indexName, [&](auto& tree) {
+            if (keyValuePairs.size() * 4 < tree.getSize()) {
+                return false;
+            }
+            IndexConfig config = getIndexConfig(indexName);
+            std::vector<std::pair<std::string, std::string>> entries = collectEntries(tree);
+            entries.reserve(entries.size() + keyValuePairs.size());
+            for (const auto& pair : keyValuePairs) {
+                if (pair.first.length() > config.maxKeySize || pair.second.length() > config.maxValueSize) {
+                    std::cerr << "Key or value exceeds size limits for index: " << indexName << std::endl;
+                    allSuccess = false;
+                    continue;
+                }
+                entries.push_back(pair);
+            }
+            tree.bulkLoad(std::move(entries), config.fillFactor);
+            auto cacheIt = lookupCaches.find(indexName);
+            if (cacheIt != lookupCaches.end()) {
+                cacheIt->second->clear();
+            }
+            auto statsIt = indexStats.find(indexName);
+            if (statsIt != indexStats.end()) {
+                statsIt->second.keyCount = tree.getSize();
+            }
+            return true;
+        });
+        if (!rebuilt) {
+            // Insert all key-value pairs
+            for (const auto& pair : keyValuePairs) {
+                if (!insertIntoIndex(indexName, pair.first, pair.second)) {
+                    allSuccess = false;
+                }
             }
         }
         
@@ -377,7 +888,16 @@ public:
         for (const auto& pair : indexes) {
             std::cout << "  " << pair.first << " (" << getIndexTypeName(pair.second.type) 
                       << ") on " << pair.second.tableName 
-                      << "(" << pair.second.columnName << ")" << std::endl;
+                      << "(" << pair.second.columnName << ")";
+            auto compositeIt = compositeIndexes.find(pair.first);
+            if (compositeIt != compositeIndexes.end() && !compositeIt->second.includeColumns.empty()) {
+                std::cout << " INCLUDE (";
+                for (size_t i = 0; i < compositeIt->second.includeColumns.size(); ++i) {
+                    std::cout << (i > 0 ? ", " : "") << compositeIt->second.includeColumns[i];
+                }
+                std::cout << ")";
+            }
+            std::cout << std::endl;
         }
         
         std::cout << "Auto-indexing enabled for tables:" << std::endl;
@@ -394,7 +914,56 @@ public:
     IndexStats getIndexStats(const std::string& indexName) const {
         auto it = indexStats.find(indexName);
         if (it != indexStats.end()) {
-            return it->second;
+            IndexStats stats = it->second;
+            auto countersIt = lookupCounters.find(indexName);
+            if (countersIt != lookupCounters.end()) {
+                uint64_t lookups = countersIt->second->lookups.load(std::memory_order_relaxed);
+                uint64_t totalMicros = countersIt->second->totalMicros.load(std::memory_order_relaxed);
+                stats.lookupCount = static_cast<size_t>(lookups);
+                stats.avgLookupTime = lookups > 0 ? static_cast<double>(totalMicros) / lookups : 0.0;
+            }
+            auto lsmTreeIt = lsmTreeIndexes.find(indexName);
+            if (lsmTreeIt != lsmTreeIndexes.end()) {
+                LSMCompactionStats compaction = lsmTreeIt->second->getCompactionStats();
+                stats.memoryUsage = lsmTreeIt->second->getMemoryUsage();
+                stats.diskUsage = lsmTreeIt->second->getDiskUsage();
+                stats.writeAmplification = compaction.writeAmplification();
+                stats.pendingCompactionBytes = compaction.pendingCompactionBytes;
+                stats.compactionCount = compaction.compactions;
+                LSMLookupStats lookups = lsmTreeIt->second->getLookupStats();
+                stats.bloomFalsePositiveRate = lookups.bloomFalsePositiveRate();
+                stats.tablesSkipped = lookups.tablesSkipped();
+            }
+            withBTree(indexName, [&stats](const auto& tree) {
+                stats.memoryUsage = tree.getMemoryUsage();
+                return true;
+            });
+            auto hashIt = hashIndexes.find(indexName);
+            if (hashIt != hashIndexes.end()) {
+                stats.memoryUsage = hashIt->second->getMemoryUsage();
+            }
+            auto mappedIt = mappedIndexes.find(indexName);
+            if (mappedIt != mappedIndexes.end()) {
+                stats.memoryUsage = mappedIt->second->getMemoryUsage();
+            }
+            auto bitmapIt = bitmapIndexes.find(indexName);
+            if (bitmapIt != bitmapIndexes.end()) {
+                stats.memoryUsage = bitmapIt->second->getMemoryUsage();
+            }
+            auto fullTextIt = fullTextIndexes.find(indexName);
+            if (fullTextIt != fullTextIndexes.end()) {
+                stats.memoryUsage = fullTextIt->second->getMemoryUsage();
+            }
+            if (const IndexBuild* build = pendingBuild(indexName)) {
+                reportBuild(*build, stats);
+            }
+            auto cacheIt = lookupCaches.find(indexName);
+            if (cacheIt != lookupCaches.end()) {
+                stats.cacheHits = cacheIt->second->getHits();
+                stats.cacheMisses = cacheIt->second->getMisses();
+                stats.memoryUsage += cacheIt->second->getMemoryUsage();
+            }
+            return stats;
         }
         return IndexStats{}; // Return default stats
     }
@@ -447,33 +1016,181 @@ public:
             std::cerr << "Index not found: " << indexName << std::endl;
             return false;
         }
+        if (finishBuild(indexName) != nullptr) {
+            std::cerr << "Index is still being built: " << indexName << std::endl;
+            return false;
+        }
+        if (!materialize(indexName)) {
+            return false;
+        }
         
+        IndexConfig previous = getIndexConfig(indexName);
         indexConfigs[indexName] = config;
+        
+        // Turning compression on or off rebuilds a B-tree index with
+        // front-coded or plain nodes; LSM-tree indexes keep the format they
+        // were created with
+        if (config.useCompression != previous.useCompression) {
+            if (config.useCompression) {
+                convertBTree(btreeIndexes, frontCodedBtreeIndexes, indexName, config.fillFactor);
+            } else {
+                convertBTree(frontCodedBtreeIndexes, btreeIndexes, indexName, config.fillFactor);
+            }
+        }
+        
+        // The lookup cache grows or shrinks in place, keeping its hottest keys
+        auto cacheIt = lookupCaches.find(indexName);
+        if (cacheIt != lookupCaches.end() && cacheIt->second->getCapacity() != config.cacheSize) {
+            cacheIt->second->setCapacity(config.cacheSize);
+        }
         std::cout << "Updated configuration for index: " << indexName << std::endl;
         return true;
     }
     
-    bool flushIndex(const std::string& indexName) {
+    bool setIndexDirectory(const std::string& directory) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            std::cerr << "Failed to create index directory: " << directory << " (" << ec.message() << ")" << std::endl;
+            return false;
+        }
+        if (ownsIndexDirectory) {
+            std::filesystem::remove_all(indexDirectory, ec);
+        }
+        indexDirectory = directory;
+        ownsIndexDirectory = false;
+        return true;
+    }
+    
+    const std::string& getIndexDirectory() const {
+        return indexDirectory;
+    }
+    
+    bool flushIndex(const std::string& indexName, uint64_t tableLsn) {
         auto it = indexes.find(indexName);
         if (it == indexes.end()) {
             std::cerr << "Index not found: " << indexName << std::endl;
             return false;
         }
+        if (finishBuild(indexName) != nullptr) {
+            std::cerr << "Index is still being built: " << indexName << std::endl;
+            return false;
+        }
+        if (!materialize(indexName)) {
+            return false;
+        }
+        
+        // LSM-tree indexes already live in sorted tables; flushing writes
+        // out the memtable
+        auto lsmTreeIt = lsmTreeIndexes.find(indexName);
+        if (lsmTreeIt != lsmTreeIndexes.end()) {
+            return lsmTreeIt->second->flush();
+        }
+        
+        IndexFileKind kind;
+        std::vector<std::pair<std::string, std::string>> entries;
+        if (withBTree(indexName, [&entries](const auto& tree) {
+                entries = collectEntries(tree);
+                return true;
+            })) {
+            kind = IndexFileKind::B_TREE;
+        } else if (hashIndexes.find(indexName) != hashIndexes.end()) {
+            // Written in key order too, so the file can be searched in place
+            kind = IndexFileKind::HASH;
+            hashIndexes[indexName]->forEach([&entries](const std::string& key, const std::string& value) {
+                entries.emplace_back(key, value);
+            });
+            std::sort(entries.begin(), entries.end());
+        } else {
+            std::cerr << "Index files only supported for B-tree and hash indexes: " << indexName << std::endl;
+            return false;
+        }
         
-        // In a real implementation, this would write the index to persistent storage
-        std::cout << "Flushing index to persistent storage: " << indexName << std::endl;
+        std::string path = indexFilePath(indexName);
+        IndexFileWriter writer;
+        if (path.empty() || !writer.open(path, kind, tableLsn)) {
+            return false;
+        }
+        for (const auto& entry : entries) {
+            if (!writer.add(entry.first, entry.second)) {
+                return false;
+            }
+        }
+        if (!writer.finish()) {
+            return false;
+        }
+        
+        std::error_code ec;
+        indexStats[indexName].diskUsage = static_cast<size_t>(std::filesystem::file_size(path, ec));
+        std::cout << "Flushed index to " << path << " at lsn " << tableLsn << std::endl;
         return true;
     }
     
-    bool loadIndex(const std::string& indexName) {
+    bool loadIndex(const std::string& indexName, uint64_t tableLsn) {
         auto it = indexes.find(indexName);
         if (it == indexes.end()) {
             std::cerr << "Index not found: " << indexName << std::endl;
             return false;
         }
+        if (finishBuild(indexName) != nullptr) {
+            std::cerr << "Index is still being built: " << indexName << std::endl;
+            return false;
+        }
+        
+        // LSM-tree indexes reopen their sorted tables when they are created
+        if (it->second.type == IndexType::LSM_TREE) {
+            return true;
+        }
+        IndexFileKind kind;
+        if (it->second.type == IndexType::B_TREE) {
+            kind = IndexFileKind::B_TREE;
+        } else if (it->second.type == IndexType::HASH) {
+            kind = IndexFileKind::HASH;
+        } else {
+            std::cerr << "Index files only supported for B-tree and hash indexes: " << indexName << std::endl;
+            return false;
+        }
         
-        // In a real implementation, this would load the index from persistent storage
-        std::cout << "Loading index from persistent storage: " << indexName << std::endl;
+        std::string path = indexFilePath(indexName);
+        auto reader = std::make_unique<IndexFileReader>();
+        if (path.empty() || !reader->open(path)) {
+            std::cerr << "No usable index file for: " << indexName << std::endl;
+            return false;
+        }
+        if (reader->getKind() != kind) {
+            std::cerr << "Index file was written for another index type: " << path << std::endl;
+            return false;
+        }
+        
+        // A file flushed before the table's last write is missing entries;
+        // the caller has to rebuild from the table instead
+        if (reader->getTableLsn() != tableLsn) {
+            std::cerr << "Index file is stale (lsn " << reader->getTableLsn() << ", table at " << tableLsn
+                      << "): " << indexName << std::endl;
+            return false;
+        }
+        
+        // Reads are served from the mapping from now on; the entries in
+        // memory are dropped and the file is copied in on the first write
+        if (kind == IndexFileKind::B_TREE) {
+            withBTree(indexName, [](auto& tree) {
+                tree.bulkLoad({});
+                return true;
+            });
+        } else {
+            hashIndexes[indexName] = std::make_unique<ConcurrentHashTable<std::string, std::string>>();
+        }
+        size_t keyCount = reader->getSize();
+        uint64_t fileSize = reader->getFileSize();
+        mappedIndexes[indexName] = std::move(reader);
+        auto cacheIt = lookupCaches.find(indexName);
+        if (cacheIt != lookupCaches.end()) {
+            cacheIt->second->clear();
+        }
+        IndexStats& stats = indexStats[indexName];
+        stats.keyCount = keyCount;
+        stats.diskUsage = static_cast<size_t>(fileSize);
+        std::cout << "Mapped index file " << path << " (" << keyCount << " keys)" << std::endl;
         return true;
     }
     
@@ -483,8 +1200,34 @@ public:
             std::cerr << "Index not found: " << indexName << std::endl;
             return false;
         }
+        if (finishBuild(indexName) != nullptr) {
+            std::cerr << "Index is still being built: " << indexName << std::endl;
+            return false;
+        }
+        if (!materialize(indexName)) {
+            return false;
+        }
         
         std::cout << "Rebuilding index for better performance: " << indexName << std::endl;
+        
+        // Repack B-tree nodes left half full by splits and removals
+        double fillFactor = getIndexConfig(indexName).fillFactor;
+        withBTree(indexName, [fillFactor](auto& tree) {
+            tree.bulkLoad(collectEntries(tree), fillFactor);
+            return true;
+        });
+        
+        // Store runs of consecutive row ids, common after bulk loads, as runs
+        auto bitmapIt = bitmapIndexes.find(indexName);
+        if (bitmapIt != bitmapIndexes.end()) {
+            bitmapIt->second->runOptimize();
+        }
+        
+        // Drop postings of removed and replaced documents
+        auto fullTextIt = fullTextIndexes.find(indexName);
+        if (fullTextIt != fullTextIndexes.end()) {
+            fullTextIt->second->compact();
+        }
         return true;
     }
     
@@ -501,7 +1244,7 @@ public:
             return;
         }
         
-        const auto& stats = statsIt->second;
+        const IndexStats stats = getIndexStats(indexName);
         std::cout << "Analysis for index: " << indexName << std::endl;
         std::cout << "  Type: " << getIndexTypeName(stats.type) << std::endl;
         std::cout << "  Key count: " << stats.keyCount << std::endl;
@@ -532,7 +1275,7 @@ public:
             }
         }
     }
-    
+
 private:
     struct IndexInfo {
         std::string tableName;
@@ -540,6 +1283,19 @@ private:
         IndexType type;
     };
     
+    // Columns of an index made by createCompositeIndex
+    struct CompositeIndexInfo {
+        std::vector<IndexKeyColumn> keyColumns;
+        std::vector<KeyColumnType> keyTypes;  // Key column types, then the row id's
+        std::vector<std::string> includeColumns;
+    };
+    
+    // Lookup statistics, counted by concurrent searches
+    struct LookupCounters {
+        std::atomic<uint64_t> lookups{0};
+        std::atomic<uint64_t> totalMicros{0};
+    };
+    
     struct AutoIndexConfig {
         std::vector<std::string> columns;
         IndexType type;
@@ -557,19 +1313,522 @@ private:
         }
     }
     
+    // Where an index's file lives; the first call without a directory set
+    // creates a private temporary one, removed with the manager
+    std::string indexFilePath(const std::string& indexName) {
+        if (indexDirectory.empty()) {
+            indexDirectory = createTemporaryTableDirectory("phantomdb_indexes_");
+            ownsIndexDirectory = !indexDirectory.empty();
+            if (indexDirectory.empty()) {
+                return std::string();
+            }
+        }
+        return (std::filesystem::path(indexDirectory) / (indexName + ".idx")).string();
+    }
+    
+    // Every entry of a B-tree index in key order
+    template<typename Tree>
+    static std::vector<std::pair<std::string, std::string>> collectEntries(const Tree& tree) {
+        std::vector<std::pair<std::string, std::string>> entries;
+        entries.reserve(tree.getSize());
+        tree.forEach([&entries](const auto& key, const auto& value) {
+            entries.emplace_back(key, value);
+        });
+        return entries;
+    }
+    
+    // Move a B-tree index from one node layout to the other
+    template<typename From, typename To>
+    static void convertBTree(std::unordered_map<std::string, std::unique_ptr<From>>& from,
+                             std::unordered_map<std::string, std::unique_ptr<To>>& to,
+                             const std::string& indexName, double fillFactor) {
+        auto fromIt = from.find(indexName);
+        if (fromIt == from.end()) {
+            return;
+        }
+        auto tree = std::make_unique<To>();
+        tree->bulkLoad(collectEntries(*fromIt->second), fillFactor);
+        to[indexName] = std::move(tree);
+        from.erase(fromIt);
+    }
+    
+    // Copy a loaded index out of its file ahead of the first change to it;
+    // false (leaving it mapped) if a page is corrupt
+    bool materialize(const std::string& indexName) {
+        auto mappedIt = mappedIndexes.find(indexName);
+        if (mappedIt == mappedIndexes.end()) {
+            return true;
+        }
+        const IndexFileReader& reader = *mappedIt->second;
+        std::vector<std::pair<std::string, std::string>> entries;
+        entries.reserve(reader.getSize());
+        if (!reader.forEach([&entries](std::string_view key, std::string_view value) {
+                entries.emplace_back(key, value);
+            })) {
+            std::cerr << "Failed to read index file for: " << indexName << std::endl;
+            return false;
+        }
+        
+        // Pages are in key order, so B-trees are built bottom up in one pass
+        if (reader.getKind() == IndexFileKind::B_TREE) {
+            double fillFactor = getIndexConfig(indexName).fillFactor;
+            withBTree(indexName, [&entries, fillFactor](auto& tree) {
+                tree.bulkLoad(std::move(entries), fillFactor);
+                return true;
+            });
+        } else {
+            auto& hashIndex = *hashIndexes[indexName];
+            for (const auto& entry : entries) {
+                hashIndex.insert(entry.first, entry.second);
+            }
+        }
+        mappedIndexes.erase(mappedIt);
+        return true;
+    }
+    
+    // Call fn with the tree behind a B-tree index, plain or front-coded;
+    // false if there is none, otherwise what fn returns
+    template<typename Fn>
+    bool withBTree(const std::string& indexName, Fn fn) {
+        auto btreeIt = btreeIndexes.find(indexName);
+        if (btreeIt != btreeIndexes.end()) {
+            return fn(*btreeIt->second);
+        }
+        auto frontCodedIt = frontCodedBtreeIndexes.find(indexName);
+        if (frontCodedIt != frontCodedBtreeIndexes.end()) {
+            return fn(*frontCodedIt->second);
+        }
+        return false;
+    }
+    
+    template<typename Fn>
+    bool withBTree(const std::string& indexName, Fn fn) const {
+        auto mappedIt = mappedIndexes.find(indexName);
+        if (mappedIt != mappedIndexes.end() && mappedIt->second->getKind() == IndexFileKind::B_TREE) {
+            return fn(static_cast<const IndexFileReader&>(*mappedIt->second));
+        }
+        auto btreeIt = btreeIndexes.find(indexName);
+        if (btreeIt != btreeIndexes.end()) {
+            return fn(static_cast<const BPlusTree<std::string, std::string>&>(*btreeIt->second));
+        }
+        auto frontCodedIt = frontCodedBtreeIndexes.find(indexName);
+        if (frontCodedIt != frontCodedBtreeIndexes.end()) {
+            return fn(static_cast<const FrontCodedBTree&>(*frontCodedIt->second));
+        }
+        return false;
+    }
+    
+    // Call fn with the tree behind a B-tree index; false (with an error)
+    // for other indexes
+    template<typename Fn>
+    bool withOrderedIndex(const std::string& indexName, const std::string& operation, Fn fn) const {
+        auto it = indexes.find(indexName);
+        if (it == indexes.end()) {
+            std::cerr << "Index not found: " << indexName << std::endl;
+            return false;
+        }
+        
+        // Only B-tree indexes keep their keys in order
+        if (it->second.type != IndexType::B_TREE) {
+            std::cerr << operation << " only supported for B-tree indexes: " << indexName << std::endl;
+            return false;
+        }
+        if (!checkReady(indexName)) {
+            return false;
+        }
+        
+        if (!withBTree(indexName, fn)) {
+            std::cerr << "B-tree index not properly initialized: " << indexName << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // Columns of a composite index, or null (with an error) for other indexes
+    const CompositeIndexInfo* findCompositeIndex(const std::string& indexName) const {
+        auto it = compositeIndexes.find(indexName);
+        if (it == compositeIndexes.end()) {
+            std::cerr << (indexes.count(indexName) ? "Not a composite index: " : "Index not found: ")
+                      << indexName << std::endl;
+            return nullptr;
+        }
+        return &it->second;
+    }
+    
+    // A composite index key: the key columns, then the row id
+    static bool encodeRowKey(const std::string& indexName, const CompositeIndexInfo& info,
+                             const std::vector<std::string>& keyValues, const std::string& rowId,
+                             std::string& key) {
+        if (keyValues.size() != info.keyColumns.size()) {
+            std::cerr << "Row does not match the key columns of index: " << indexName << std::endl;
+            return false;
+        }
+        if (!encodeTupleKey(info.keyTypes, keyValues, key) || !appendKeyColumn(key, KeyColumnType::STRING, rowId)) {
+            std::cerr << "Invalid key value for index: " << indexName << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // The bitmap index behind indexName, or null (with an error) for other indexes
+    const BitmapIndex* findBitmapIndex(const std::string& indexName) const {
+        auto it = indexes.find(indexName);
+        if (it == indexes.end()) {
+            std::cerr << "Index not found: " << indexName << std::endl;
+            return nullptr;
+        }
+        if (it->second.type != IndexType::BITMAP) {
+            std::cerr << "Bitmap filter only supported for bitmap indexes: " << indexName << std::endl;
+            return nullptr;
+        }
+        
+        auto bitmapIt = bitmapIndexes.find(indexName);
+        if (bitmapIt == bitmapIndexes.end()) {
+            std::cerr << "Bitmap index not properly initialized: " << indexName << std::endl;
+            return nullptr;
+        }
+        return bitmapIt->second.get();
+    }
+    
+    // AND of the predicates' bitmaps into rows
+    bool evaluateBitmapFilter(const std::vector<BitmapPredicate>& predicates, RoaringBitmap& rows) const {
+        if (predicates.empty()) {
+            std::cerr << "Bitmap filter needs at least one predicate" << std::endl;
+            return false;
+        }
+        
+        // Positive predicates, smallest estimated result first, so the running
+        // intersection is small from the start; negated ones come last
+        struct Term {
+            const BitmapIndex* index;
+            const BitmapPredicate* predicate;
+            uint64_t estimate;
+        };
+        std::vector<Term> terms;
+        for (const auto& predicate : predicates) {
+            const BitmapIndex* index = findBitmapIndex(predicate.indexName);
+            if (index == nullptr) {
+                return false;
+            }
+            uint64_t estimate = predicate.negate ? std::numeric_limits<uint64_t>::max()
+                                                 : index->estimateAny(predicate.values);
+            terms.push_back({index, &predicate, estimate});
+        }
+        std::stable_sort(terms.begin(), terms.end(), [](const Term& a, const Term& b) {
+            return a.estimate < b.estimate;
+        });
+        
+        // With only NOT IN predicates, start from every row the first index knows
+        const Term& first = terms.front();
+        if (first.predicate->negate) {
+            rows = first.index->allRows();
+        } else {
+            rows = first.index->matchAny(first.predicate->values);
+        }
+        for (size_t i = first.predicate->negate ? 0 : 1; i < terms.size() && !rows.isEmpty(); ++i) {
+            RoaringBitmap matches = terms[i].index->matchAny(terms[i].predicate->values);
+            rows = terms[i].predicate->negate ? rows.subtract(matches) : rows.intersect(matches);
+        }
+        return true;
+    }
+    
+    // Write captured while an online build runs
+    struct SideLogEntry {
+        bool remove;
+        std::string key;
+        std::string value;
+    };
+    
+    // An online index build, shared with its worker thread. The worker
+    // builds into the trees here and never touches the manager's maps; once
+    // it has caught up with the side log it sets caughtUp and exits, and
+    // finishBuild, on a writer's thread, runs install() to swap the finished
+    // tree into the index's slot. Readers only look at phase, which turns
+    // READY after the swap
+    struct IndexBuild {
+        double fillFactor = 1.0;
+        size_t partitions = 1;
+        uint64_t estimatedRows = 0;
+        IndexBuildScan scan;
+        
+        std::unique_ptr<BPlusTree<std::string, std::string>> btree;
+        std::unique_ptr<FrontCodedBTree> frontCodedBtree;
+        std::unique_ptr<ConcurrentHashTable<std::string, std::string>> hash;
+        std::function<size_t()> install;  // Returns the installed index's key count
+        
+        mutable std::mutex mutex;  // Guards sideLog and the final switch
+        std::vector<SideLogEntry> sideLog;
+        std::mutex joinMutex;  // Lets exactly one thread join the worker
+        std::atomic<IndexBuildPhase> phase{IndexBuildPhase::SCANNING};
+        std::atomic<bool> caughtUp{false};
+        std::atomic<bool> cancelled{false};
+        std::atomic<uint64_t> rowsScanned{0};
+        std::atomic<size_t> partitionsScanned{0};
+        std::thread worker;
+    };
+    
+    // Side log left when the worker hands over; the rest is applied with
+    // writers held off
+    static const size_t CATCH_UP_THRESHOLD = 1024;
+    static const int MAX_CATCH_UP_ROUNDS = 16;
+    
+    // Apply captured writes, in order, to the tree being built
+    static void applySideLog(IndexBuild& build, const std::vector<SideLogEntry>& entries) {
+        auto apply = [&entries](auto& tree) {
+            for (const auto& entry : entries) {
+                if (entry.remove) {
+                    tree.remove(entry.key);
+                } else {
+                    tree.insert(entry.key, entry.value);
+                }
+            }
+        };
+        if (build.hash) {
+            apply(*build.hash);
+        } else if (build.frontCodedBtree) {
+            apply(*build.frontCodedBtree);
+        } else {
+            apply(*build.btree);
+        }
+    }
+    
+    // Worker thread: scan the snapshot in parallel partitions, build the
+    // tree, then drain the side log until little is left
+    static void runBuild(IndexBuild* build) {
+        std::vector<std::vector<std::pair<std::string, std::string>>> scanned(build->partitions);
+        std::atomic<bool> failed{false};
+        std::vector<std::thread> scanners;
+        for (size_t partition = 0; partition < build->partitions; ++partition) {
+            scanners.emplace_back([build, partition, &scanned, &failed]() {
+                auto& entries = scanned[partition];
+                try {
+                    auto emit = [build, &entries](const std::string& key, const std::string& value) {
+                        if (build->cancelled.load(std::memory_order_relaxed)) {
+                            return;
+                        }
+                        // Hash tables take concurrent inserts; B-trees are built bottom up below
+                        if (build->hash) {
+                            build->hash->insert(key, value);
+                        } else {
+                            entries.emplace_back(key, value);
+                        }
+                        build->rowsScanned.fetch_add(1, std::memory_order_relaxed);
+                    };
+                    build->scan(partition, build->partitions, emit);
+                } catch (const std::exception& e) {
+                    std::cerr << "Online index build scan failed: " << e.what() << std::endl;
+                    failed = true;
+                }
+                build->partitionsScanned.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        for (auto& scanner : scanners) {
+            scanner.join();
+        }
+        if (failed || build->cancelled) {
+            build->phase = IndexBuildPhase::FAILED;
+            return;
+        }
+        
+        if (!build->hash) {
+            std::vector<std::pair<std::string, std::string>> entries;
+            for (auto& partition : scanned) {
+                std::move(partition.begin(), partition.end(), std::back_inserter(entries));
+                std::vector<std::pair<std::string, std::string>>().swap(partition);
+            }
+            if (build->frontCodedBtree) {
+                build->frontCodedBtree->bulkLoad(std::move(entries), build->fillFactor);
+            } else {
+                build->btree->bulkLoad(std::move(entries), build->fillFactor);
+            }
+        }
+        
+        build->phase = IndexBuildPhase::CATCHING_UP;
+        for (int round = 0; !build->cancelled; ++round) {
+            std::vector<SideLogEntry> batch;
+            {
+                std::lock_guard<std::mutex> lock(build->mutex);
+                if (build->sideLog.size() <= CATCH_UP_THRESHOLD || round >= MAX_CATCH_UP_ROUNDS) {
+                    build->caughtUp.store(true, std::memory_order_release);
+                    return;
+                }
+                batch.swap(build->sideLog);
+            }
+            applySideLog(*build, batch);
+        }
+    }
+    
+    // Wait for a build's worker to exit
+    static void joinWorker(IndexBuild& build) {
+        std::lock_guard<std::mutex> lock(build.joinMutex);
+        if (build.worker.joinable()) {
+            build.worker.join();
+        }
+    }
+    
+    // Cancel a build and wait for its worker
+    static void stopBuild(IndexBuild& build) {
+        build.cancelled = true;
+        joinWorker(build);
+    }
+    
+    // The online build of indexName if the index is not ready yet
+    const IndexBuild* pendingBuild(const std::string& indexName) const {
+        auto buildIt = builds.find(indexName);
+        if (buildIt == builds.end() ||
+            buildIt->second->phase.load(std::memory_order_acquire) == IndexBuildPhase::READY) {
+            return nullptr;
+        }
+        return buildIt->second.get();
+    }
+    
+    // Like pendingBuild, but a build whose worker has caught up is first
+    // switched into use, applying the rest of its side log with writers
+    // held off. Only the thread that makes the switch joins the worker
+    IndexBuild* finishBuild(const std::string& indexName) {
+        auto buildIt = builds.find(indexName);
+        if (buildIt == builds.end()) {
+            return nullptr;
+        }
+        IndexBuild& build = *buildIt->second;
+        if (build.phase.load(std::memory_order_acquire) == IndexBuildPhase::READY) {
+            return nullptr;
+        }
+        if (!build.caughtUp.load(std::memory_order_acquire)) {
+            return &build;
+        }
+        size_t keyCount;
+        {
+            std::lock_guard<std::mutex> lock(build.mutex);
+            if (build.phase.load(std::memory_order_relaxed) == IndexBuildPhase::READY) {
+                return nullptr;
+            }
+            applySideLog(build, build.sideLog);
+            build.sideLog.clear();
+            keyCount = build.install();
+            build.phase.store(IndexBuildPhase::READY, std::memory_order_release);
+        }
+        joinWorker(build);
+        auto statsIt = indexStats.find(indexName);
+        if (statsIt != indexStats.end()) {
+            statsIt->second.keyCount = keyCount;
+        }
+        std::cout << "Online build of index " << indexName << " complete (" << keyCount << " keys)" << std::endl;
+        return nullptr;
+    }
+    
+    // Capture a write to an index being built. Returns false if there is
+    // no build (or it was switched into use meanwhile) and the write should
+    // go to the index itself; otherwise captured tells whether it was logged
+    bool logBuildWrite(const std::string& indexName, SideLogEntry entry, bool& captured) {
+        IndexBuild* build = finishBuild(indexName);
+        if (build == nullptr) {
+            return false;
+        }
+        if (build->phase == IndexBuildPhase::FAILED) {
+            std::cerr << "Online build failed for index: " << indexName << std::endl;
+            captured = false;
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(build->mutex);
+        if (build->phase.load(std::memory_order_relaxed) == IndexBuildPhase::READY) {
+            return false;
+        }
+        build->sideLog.push_back(std::move(entry));
+        captured = true;
+        return true;
+    }
+    
+    // Reads of an index being built fail, so callers fall back to full scans
+    bool checkReady(const std::string& indexName) const {
+        if (pendingBuild(indexName) != nullptr) {
+            std::cerr << "Index not ready, use a full scan: " << indexName << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    static void reportBuild(const IndexBuild& build, IndexStats& stats) {
+        stats.buildPhase = build.phase;
+        stats.rowsScanned = build.rowsScanned.load(std::memory_order_relaxed);
+        if (stats.buildPhase != IndexBuildPhase::SCANNING) {
+            stats.buildProgress = 1.0;
+        } else if (build.estimatedRows > 0) {
+            stats.buildProgress = std::min(0.99, static_cast<double>(stats.rowsScanned) / build.estimatedRows);
+        } else {
+            stats.buildProgress = static_cast<double>(build.partitionsScanned.load(std::memory_order_relaxed)) /
+                                  build.partitions;
+        }
+        std::lock_guard<std::mutex> lock(build.mutex);
+        stats.sideLogEntries = build.sideLog.size();
+    }
+    
+    // Look key up through the index's lookup cache, calling load(value) on a miss
+    template<typename Loader>
+    bool cachedLookup(const std::string& indexName, const std::string& key, std::string& value, Loader load) const {
+        auto cacheIt = lookupCaches.find(indexName);
+        if (cacheIt == lookupCaches.end()) {
+            return load(value);
+        }
+        return cacheIt->second->lookup(key, value, load);
+    }
+    
+    // Forget a key the index has just changed, so no lookup sees its old value
+    void invalidateCached(const std::string& indexName, const std::string& key) {
+        auto cacheIt = lookupCaches.find(indexName);
+        if (cacheIt != lookupCaches.end()) {
+            cacheIt->second->erase(key);
+        }
+    }
+    
+    // Row ids are decimal integers that fit in 32 bits
+    static bool parseRowId(const std::string& text, uint32_t& rowId) {
+        char* end = nullptr;
+        errno = 0;
+        unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+        if (text.empty() || text[0] < '0' || text[0] > '9' || *end != '\0' || errno != 0 ||
+            parsed > std::numeric_limits<uint32_t>::max()) {
+            std::cerr << "Bitmap index values must be row ids: " << text << std::endl;
+            return false;
+        }
+        rowId = static_cast<uint32_t>(parsed);
+        return true;
+    }
+    
     std::unordered_map<std::string, IndexInfo> indexes;
-    std::unordered_map<std::string, std::unique_ptr<BTree<std::string, std::string>>> btreeIndexes;
-    std::unordered_map<std::string, std::unique_ptr<HashTable<std::string, std::string>>> hashIndexes;
+    std::unordered_map<std::string, std::unique_ptr<BPlusTree<std::string, std::string>>> btreeIndexes;
+    std::unordered_map<std::string, std::unique_ptr<FrontCodedBTree>> frontCodedBtreeIndexes;
+    std::unordered_map<std::string, std::unique_ptr<ConcurrentHashTable<std::string, std::string>>> hashIndexes;
     std::unordered_map<std::string, std::unique_ptr<LSMTREE<std::string, std::string>>> lsmTreeIndexes;
+    std::unordered_map<std::string, std::unique_ptr<BitmapIndex>> bitmapIndexes;
+    std::unordered_map<std::string, std::unique_ptr<FullTextIndex>> fullTextIndexes;
+    
+    // Loaded B-tree and hash indexes read from their files until the first
+    // write copies them into memory
+    std::unordered_map<std::string, std::unique_ptr<IndexFileReader>> mappedIndexes;
+    
+    // Key and INCLUDE columns of composite indexes
+    std::unordered_map<std::string, CompositeIndexInfo> compositeIndexes;
+    
+    // Hot-key caches in front of B-tree and LSM-tree indexes
+    std::unordered_map<std::string, std::unique_ptr<LookupCache<std::string, std::string>>> lookupCaches;
     
     // Index configurations
     std::unordered_map<std::string, IndexConfig> indexConfigs;
     
-    // Index statistics
+    // Index statistics; lookups are counted in lookupCounters instead
     std::unordered_map<std::string, IndexStats> indexStats;
+    std::unordered_map<std::string, std::unique_ptr<LookupCounters>> lookupCounters;
     
     // Auto-indexing configuration
     std::unordered_map<std::string, AutoIndexConfig> autoIndexConfig;
+    
+    // Online index builds, until waited for or dropped
+    std::unordered_map<std::string, std::unique_ptr<IndexBuild>> builds;
+    
+    // Where B-tree and hash index files are flushed
+    std::string indexDirectory;
+    bool ownsIndexDirectory = false;
 };
 
 EnhancedIndexManager::EnhancedIndexManager() : pImpl(std::make_unique<Impl>()) {
@@ -594,6 +1853,24 @@ bool EnhancedIndexManager::createIndex(const std::string& tableName, const std::
     return pImpl->createIndex(tableName, columnName, type, config);
 }
 
+bool EnhancedIndexManager::createIndexOnline(const std::string& tableName, const std::string& columnName,
+                                             IndexType type, const IndexConfig& config, IndexBuildScan scan,
+                                             size_t threads, uint64_t estimatedRows) {
+    return pImpl->createIndexOnline(tableName, columnName, type, config, std::move(scan), threads, estimatedRows);
+}
+
+bool EnhancedIndexManager::isIndexReady(const std::string& indexName) const {
+    return pImpl->isIndexReady(indexName);
+}
+
+bool EnhancedIndexManager::finishIndexBuild(const std::string& indexName) {
+    return pImpl->finishIndexBuild(indexName);
+}
+
+bool EnhancedIndexManager::waitForIndexBuild(const std::string& indexName) {
+    return pImpl->waitForIndexBuild(indexName);
+}
+
 bool EnhancedIndexManager::dropIndex(const std::string& indexName) {
     return pImpl->dropIndex(indexName);
 }
@@ -611,12 +1888,74 @@ bool EnhancedIndexManager::searchInIndex(const std::string& indexName, const std
 }
 
 bool EnhancedIndexManager::rangeSearch(const std::string& indexName, const std::string& startKey, const std::string& endKey,
+                                     std::vector<std::pair<std::string, std::string>>& results,
+                                     size_t limit, bool descending) const {
+    return pImpl->rangeSearch(indexName, startKey, endKey, results, limit, descending);
+}
+
+bool EnhancedIndexManager::orderedScan(const std::string& indexName, size_t limit, bool descending,
                                      std::vector<std::pair<std::string, std::string>>& results) const {
-    return pImpl->rangeSearch(indexName, startKey, endKey, results);
+    return pImpl->orderedScan(indexName, limit, descending, results);
+}
+
+bool EnhancedIndexManager::filterBitmap(const std::vector<BitmapPredicate>& predicates,
+                                       std::vector<uint32_t>& rowIds) const {
+    return pImpl->filterBitmap(predicates, rowIds);
+}
+
+bool EnhancedIndexManager::countBitmapFilter(const std::vector<BitmapPredicate>& predicates, uint64_t& count) const {
+    return pImpl->countBitmapFilter(predicates, count);
+}
+
+bool EnhancedIndexManager::fullTextSearch(const std::string& indexName, const std::string& query,
+                                         std::vector<std::pair<std::string, double>>& results,
+                                         size_t limit, bool matchAll) const {
+    return pImpl->fullTextSearch(indexName, query, results, limit, matchAll);
+}
+
+bool EnhancedIndexManager::createCompositeIndex(const std::string& tableName,
+                                               const std::vector<IndexKeyColumn>& keyColumns,
+                                               const std::vector<std::string>& includeColumns,
+                                               const IndexConfig& config) {
+    return pImpl->createCompositeIndex(tableName, keyColumns, includeColumns, config);
+}
+
+bool EnhancedIndexManager::encodeIndexRow(const std::string& indexName, const std::vector<std::string>& keyValues,
+                                         const std::string& rowId, const std::vector<std::string>& includeValues,
+                                         std::string& key, std::string& value) const {
+    return pImpl->encodeIndexRow(indexName, keyValues, rowId, includeValues, key, value);
+}
+
+bool EnhancedIndexManager::insertRow(const std::string& indexName, const std::vector<std::string>& keyValues,
+                                    const std::string& rowId, const std::vector<std::string>& includeValues) {
+    return pImpl->insertRow(indexName, keyValues, rowId, includeValues);
+}
+
+bool EnhancedIndexManager::deleteRow(const std::string& indexName, const std::vector<std::string>& keyValues,
+                                    const std::string& rowId) {
+    return pImpl->deleteRow(indexName, keyValues, rowId);
+}
+
+bool EnhancedIndexManager::searchComposite(const std::string& indexName, const CompositeKeyRange& range,
+                                          std::vector<IndexRow>& rows, size_t limit, bool descending) const {
+    return pImpl->searchComposite(indexName, range, rows, limit, descending);
+}
+
+bool EnhancedIndexManager::coversColumns(const std::string& indexName, const std::vector<std::string>& columns) const {
+    return pImpl->coversColumns(indexName, columns);
 }
 
 bool EnhancedIndexManager::deleteFromIndex(const std::string& indexName, const std::string& key) {
-    return pImpl->deleteFromIndex(indexName, key);
+    return pImpl->deleteFromIndex(indexName, key, nullptr, false);
+}
+
+bool EnhancedIndexManager::deleteFromIndex(const std::string& indexName, const std::string& key,
+                                           const std::string& value) {
+    return pImpl->deleteFromIndex(indexName, key, &value, false);
+}
+
+bool EnhancedIndexManager::deleteValueFromIndex(const std::string& indexName, const std::string& key) {
+    return pImpl->deleteFromIndex(indexName, key, nullptr, true);
 }
 
 bool EnhancedIndexManager::bulkInsert(const std::string& indexName, 
@@ -661,12 +2000,20 @@ bool EnhancedIndexManager::updateIndexConfig(const std::string& indexName, const
     return pImpl->updateIndexConfig(indexName, config);
 }
 
-bool EnhancedIndexManager::flushIndex(const std::string& indexName) {
-    return pImpl->flushIndex(indexName);
+bool EnhancedIndexManager::setIndexDirectory(const std::string& directory) {
+    return pImpl->setIndexDirectory(directory);
+}
+
+const std::string& EnhancedIndexManager::getIndexDirectory() const {
+    return pImpl->getIndexDirectory();
+}
+
+bool EnhancedIndexManager::flushIndex(const std::string& indexName, uint64_t tableLsn) {
+    return pImpl->flushIndex(indexName, tableLsn);
 }
 
-bool EnhancedIndexManager::loadIndex(const std::string& indexName) {
-    return pImpl->loadIndex(indexName);
+bool EnhancedIndexManager::loadIndex(const std::string& indexName, uint64_t tableLsn) {
+    return pImpl->loadIndex(indexName, tableLsn);
 }
 
 bool EnhancedIndexManager::rebuildIndex(const std::string& indexName) {
@@ -6,6 +6,9 @@
 #include <vector>
 #include <unordered_map>
 #include <functional>
+#include <cstdint>
+#include "lsm_compaction.h"
+#include "key_encoding.h"
 
 namespace phantomdb {
 namespace storage {
@@ -19,6 +22,14 @@ enum class IndexType {
     FULLTEXT     // Full-text search index
 };
 
+// Where an index is in an online build (see createIndexOnline)
+enum class IndexBuildPhase {
+    READY,        // Built and in use
+    SCANNING,     // Reading the table snapshot; writes go to the side log
+    CATCHING_UP,  // Applying writes captured in the side log
+    FAILED        // The snapshot scan failed; drop the index
+};
+
 // Index statistics for performance monitoring
 struct IndexStats {
     std::string indexName;
@@ -29,18 +40,76 @@ struct IndexStats {
     double avgLookupTime;
     double avgInsertTime;
     double avgDeleteTime;
-    size_t cacheHits;
-    size_t cacheMisses;
+    size_t cacheHits;       // Lookups answered by the index's lookup cache
+    size_t cacheMisses;     // Lookups the cache passed on to the index
+    size_t lookupCount = 0; // Every search, cached or not
+    
+    // LSM-tree compaction (zero for other index types)
+    double writeAmplification = 0.0;    // Bytes written to disk per byte flushed
+    uint64_t pendingCompactionBytes = 0; // Estimated bytes compaction still has to rewrite
+    size_t compactionCount = 0;
+    
+    // LSM-tree lookups (zero for other index types)
+    double bloomFalsePositiveRate = 0.0; // Filter checks for absent keys that still read a block
+    uint64_t tablesSkipped = 0;          // Tables ruled out by fence keys or bloom filters
+    
+    // Online builds (READY and zero otherwise)
+    IndexBuildPhase buildPhase = IndexBuildPhase::READY;
+    double buildProgress = 1.0;   // Share of the table snapshot scanned (0 to 1)
+    uint64_t rowsScanned = 0;     // Snapshot rows read so far
+    uint64_t sideLogEntries = 0;  // Concurrent writes captured and not yet applied
 };
 
 // Index configuration for optimization
 struct IndexConfig {
     bool enabled = true;
-    size_t cacheSize = 1000;  // Number of entries to cache
-    bool useCompression = false;
+    size_t cacheSize = 1000;  // B-tree and LSM-tree indexes: hot keys cached in front of the index (0 for none)
+    bool useCompression = false;  // B-tree and LSM-tree indexes: front-code keys that share prefixes
     bool allowDuplicates = false;
     size_t maxKeySize = 1024;
     size_t maxValueSize = 8192;
+    double fillFactor = 1.0;  // B-tree indexes only: node fill for bulk inserts and rebuilds
+    LSMCompactionStyle compactionStyle = LSMCompactionStyle::LEVELED;  // LSM-tree indexes only
+    int bloomBitsPerKey = SSTableWriter::DEFAULT_BLOOM_BITS_PER_KEY;   // LSM-tree indexes only
+};
+
+// Reads a snapshot of the indexed column for an online index build: called
+// once per partition on a background thread, passing emit the (key, value)
+// pair of every row in that share of the table
+using IndexBuildScan = std::function<void(size_t partition, size_t partitionCount,
+                                          const std::function<void(const std::string& key,
+                                                                   const std::string& value)>& emit)>;
+
+// One condition of a bitmap filter: the indexed column is one of values
+// (column IN (...)), or with negate set, none of them (NOT IN)
+struct BitmapPredicate {
+    std::string indexName;
+    std::vector<std::string> values;
+    bool negate = false;
+};
+
+// One key column of a composite index
+struct IndexKeyColumn {
+    std::string name;
+    KeyColumnType type = KeyColumnType::STRING;
+};
+
+// A row found through a composite index, read from the index alone
+struct IndexRow {
+    std::string rowId;
+    std::vector<std::string> keyValues;      // One per key column
+    std::vector<std::string> includeValues;  // One per INCLUDE column
+};
+
+// Rows of a composite index to look up: the leading key columns equal to
+// prefix, and optionally the key column after them between lower and upper
+// (inclusive)
+struct CompositeKeyRange {
+    std::vector<std::string> prefix;
+    bool hasLower = false;
+    std::string lower;
+    bool hasUpper = false;
+    std::string upper;
 };
 
 class EnhancedIndexManager {
@@ -58,7 +127,44 @@ public:
     bool createIndex(const std::string& tableName, const std::string& columnName, 
                     IndexType type = IndexType::B_TREE, const IndexConfig& config = IndexConfig{});
     
-    // Drop an index
+    /**
+     * @brief Create a B-tree or hash index on a live table without blocking writers
+     * 
+     * Background threads build the index from a snapshot scan while
+     * insertIntoIndex, deleteFromIndex and bulkInsert calls on it are
+     * captured in a side log. Once the scan is done the side log is applied
+     * in rounds until little is left; the rest is applied and the index
+     * switched into use in one step, stalling writers only for that last
+     * batch. The switch is made by the next write to the index, or by
+     * finishIndexBuild or waitForIndexBuild; lookups never make it, so
+     * they can run on other threads meanwhile. Until then lookups and scans
+     * on the index fail, so queries keep using full table scans;
+     * isIndexReady tells when to switch, and getIndexStats reports the
+     * build phase and progress.
+     * 
+     * Replaying the side log in order makes the result correct even if the
+     * scan also sees some of the captured writes.
+     * 
+     * @param scan Reads the snapshot, one partition per call
+     * @param threads Partitions scanned in parallel (0 for one per core)
+     * @param estimatedRows Rows expected from the scan, for buildProgress (0 if unknown)
+     * @return true if the build was started
+     */
+    bool createIndexOnline(const std::string& tableName, const std::string& columnName, IndexType type,
+                           const IndexConfig& config, IndexBuildScan scan,
+                           size_t threads = 0, uint64_t estimatedRows = 0);
+    
+    // Whether an index can serve lookups (false while an online build runs)
+    bool isIndexReady(const std::string& indexName) const;
+    
+    // Switch an online build that has caught up into use, without blocking;
+    // true if the index is ready
+    bool finishIndexBuild(const std::string& indexName);
+    
+    // Block until an online build finishes; false if it failed
+    bool waitForIndexBuild(const std::string& indexName);
+    
+    // Drop an index (waiting for an online build of it to stop)
     bool dropIndex(const std::string& indexName);
     
     // Get index type
@@ -70,14 +176,118 @@ public:
     // Search for a key in an index
     bool searchInIndex(const std::string& indexName, const std::string& key, std::string& value) const;
     
-    // Range search for B-tree indexes
+    /**
+     * @brief Range search for B-tree indexes
+     * 
+     * Appends the entries with startKey <= key <= endKey to results in key
+     * order (BETWEEN), or in reverse order when descending is set.
+     * 
+     * @param limit Stop after this many entries (0 for no limit)
+     * @return true if the index exists and is a B-tree index
+     */
     bool rangeSearch(const std::string& indexName, const std::string& startKey, const std::string& endKey,
+                    std::vector<std::pair<std::string, std::string>>& results,
+                    size_t limit = 0, bool descending = false) const;
+    
+    // First limit entries of a B-tree index in key order (ORDER BY ... LIMIT)
+    bool orderedScan(const std::string& indexName, size_t limit, bool descending,
                     std::vector<std::pair<std::string, std::string>>& results) const;
     
-    // Delete a key from an index
+    /**
+     * @brief Rows matching every predicate, from bitmap indexes
+     * 
+     * Combines the predicates' bitmaps with AND, OR (within an IN list) and
+     * AND NOT (negated predicates), most selective predicate first, instead
+     * of checking rows one by one. Bitmap indexes map each column value (the
+     * key) to the row ids inserted as its values.
+     * 
+     * @param rowIds Receives the matching row ids in ascending order
+     * @return false if there are no predicates or one names an index that is
+     *         not a bitmap index
+     */
+    bool filterBitmap(const std::vector<BitmapPredicate>& predicates, std::vector<uint32_t>& rowIds) const;
+    
+    // Number of rows filterBitmap would return, without listing them
+    bool countBitmapFilter(const std::vector<BitmapPredicate>& predicates, uint64_t& count) const;
+    
+    /**
+     * @brief Ranked term search in a full-text index
+     * 
+     * Full-text indexes take a document key (such as a row id) as the key
+     * and its text as the value; searchInIndex with a query as the key
+     * returns the keys of documents with every term, best first.
+     * 
+     * @param results Receives (document key, BM25 score) pairs, best first
+     * @param limit Return at most this many documents (0 for all)
+     * @param matchAll Only documents containing every query term; otherwise any
+     * @return true if the index exists and is a full-text index
+     */
+    bool fullTextSearch(const std::string& indexName, const std::string& query,
+                        std::vector<std::pair<std::string, double>>& results,
+                        size_t limit = 10, bool matchAll = true) const;
+    
+    /**
+     * @brief Create a B-tree index on an ordered tuple of columns, storing
+     *        includeColumns in each entry so queries reading only those
+     *        and the key columns are answered from the index alone
+     * 
+     * The index is named table_column1_column2..._idx. Keys are the key
+     * columns' values in an order-preserving encoding (see key_encoding.h)
+     * followed by the row id, so rows may share key values; with
+     * useCompression the shared leading columns are front-coded.
+     * 
+     * @return true if successful, false otherwise
+     */
+    bool createCompositeIndex(const std::string& tableName, const std::vector<IndexKeyColumn>& keyColumns,
+                              const std::vector<std::string>& includeColumns = {},
+                              const IndexConfig& config = IndexConfig{});
+    
+    /**
+     * @brief The key and value a row is stored under in a composite index,
+     *        for bulkInsert or an online build's scan
+     * 
+     * @return false if the value counts do not match the index's columns or
+     *         a value is not valid for its column's type
+     */
+    bool encodeIndexRow(const std::string& indexName, const std::vector<std::string>& keyValues,
+                        const std::string& rowId, const std::vector<std::string>& includeValues,
+                        std::string& key, std::string& value) const;
+    
+    // Add a row to a composite index
+    bool insertRow(const std::string& indexName, const std::vector<std::string>& keyValues,
+                   const std::string& rowId, const std::vector<std::string>& includeValues = {});
+    
+    // Remove a row from a composite index
+    bool deleteRow(const std::string& indexName, const std::vector<std::string>& keyValues,
+                   const std::string& rowId);
+    
+    /**
+     * @brief Rows of a composite index within range, in key order (or
+     *        reverse order when descending is set)
+     * 
+     * @param limit Stop after this many rows (0 for no limit)
+     * @return false if the index is not a composite index, range has more
+     *         values than key columns, or a value is invalid for its type
+     */
+    bool searchComposite(const std::string& indexName, const CompositeKeyRange& range,
+                         std::vector<IndexRow>& rows, size_t limit = 0, bool descending = false) const;
+    
+    // Whether a composite index holds every one of columns (as a key or
+    // INCLUDE column), so a query reading only them need not touch the table
+    bool coversColumns(const std::string& indexName, const std::vector<std::string>& columns) const;
+    
+    // Delete a key from an index; bitmap indexes need the row as well
     bool deleteFromIndex(const std::string& indexName, const std::string& key);
     
-    // Bulk insert for better performance
+    // Delete one row of a key: for a bitmap index the row id inserted
+    // under the column value, for other indexes (one value per key) the key
+    bool deleteFromIndex(const std::string& indexName, const std::string& key, const std::string& value);
+    
+    // Delete every row of a bitmap index's column value
+    bool deleteValueFromIndex(const std::string& indexName, const std::string& key);
+    
+    // Bulk insert for better performance; large batches build B-tree
+    // indexes bottom up instead of inserting one pair at a time
     bool bulkInsert(const std::string& indexName, 
                    const std::vector<std::pair<std::string, std::string>>& keyValuePairs);
     
@@ -109,13 +319,37 @@ public:
     // Update index configuration
     bool updateIndexConfig(const std::string& indexName, const IndexConfig& config);
     
-    // Flush index to persistent storage
-    bool flushIndex(const std::string& indexName);
+    // Directory for B-tree and hash index files (a private temporary
+    // directory, removed with the manager, until one is set)
+    bool setIndexDirectory(const std::string& directory);
+    const std::string& getIndexDirectory() const;
+    
+    /**
+     * @brief Write a B-tree or hash index to its index file (see
+     *        index_file.h); LSM-tree indexes flush their memtable
+     * 
+     * @param tableLsn Last lsn of the indexed table the index reflects
+     * @return true if successful, false otherwise
+     */
+    bool flushIndex(const std::string& indexName, uint64_t tableLsn = 0);
     
-    // Load index from persistent storage
-    bool loadIndex(const std::string& indexName);
+    /**
+     * @brief Replace a B-tree or hash index's entries with its index file
+     * 
+     * The file is mapped and serves the index's reads in place; the first
+     * write copies its entries into memory. It is rejected,
+     * leaving the index unchanged, if it is missing or corrupt or was
+     * flushed at another lsn than the table's last one; the index must
+     * then be rebuilt from the table.
+     * 
+     * @param tableLsn Last lsn of the indexed table
+     * @return true if the index was loaded
+     */
+    bool loadIndex(const std::string& indexName, uint64_t tableLsn = 0);
     
-    // Rebuild index for better performance
+    // Rebuild index for better performance (B-tree indexes are repacked
+    // to the configured fill factor; bitmap indexes store runs of row ids
+    // compactly; full-text indexes drop postings of removed documents)
     bool rebuildIndex(const std::string& indexName);
     
     // Analyze index for optimization suggestions
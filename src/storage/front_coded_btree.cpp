@@ -0,0 +1,432 @@
+#include "front_coded_btree.h"
+#include <algorithm>
+
+namespace phantomdb {
+namespace storage {
+
+namespace {
+
+const unsigned char* bytes(const std::string& data) {
+    return reinterpret_cast<const unsigned char*>(data.data());
+}
+
+// Bytes a string allocates beyond its own object (none when stored inline)
+size_t heapBytes(const std::string& value) {
+    const char* inline_ = reinterpret_cast<const char*>(&value);
+    bool isInline = value.data() >= inline_ && value.data() < inline_ + sizeof(value);
+    return isInline ? 0 : value.capacity() + 1;
+}
+
+} // anonymous namespace
+
+FrontCodedBTree::FrontCodedBTree() : size_(0), version_(0) {}
+
+FrontCodedBTree::~FrontCodedBTree() {
+    clear();
+}
+
+FrontCodedBTree::Page* FrontCodedBTree::findPage(const std::string& key, std::string* separator) const {
+    // The first page's separator is empty, so every key has a page
+    Page* page = nullptr;
+    pages_.searchFloor(key, page, separator);
+    return page;
+}
+
+FrontCodedBTree::Page* FrontCodedBTree::nextPage(const std::string& separator, std::string& nextSeparator) const {
+    auto cursor = pages_.upperBound(separator);
+    if (!cursor.valid()) {
+        return nullptr;
+    }
+    nextSeparator = cursor.key();
+    return cursor.value();
+}
+
+FrontCodedBTree::Page* FrontCodedBTree::prevPage(const std::string& separator, std::string& prevSeparator) const {
+    auto cursor = pages_.lowerBound(separator);
+    cursor.prev();
+    if (!cursor.valid()) {
+        return nullptr;
+    }
+    prevSeparator = cursor.key();
+    return cursor.value();
+}
+
+void FrontCodedBTree::store(Page& page, FrontCodedBlockBuilder& builder) {
+    page.count = builder.getEntryCount();
+    page.data = builder.finish();
+}
+
+bool FrontCodedBTree::search(const std::string& key, std::string& value) const {
+    if (size_ == 0) {
+        return false;
+    }
+    const Page* page = findPage(key, nullptr);
+    FrontCodedBlockIterator entries;
+    entries.init(bytes(page->data), page->data.size());
+    entries.seek(key);
+    if (entries.valid() && entries.key() == key) {
+        value.assign(entries.value().data(), entries.value().size());
+        return true;
+    }
+    return false;
+}
+
+void FrontCodedBTree::insert(const std::string& key, const std::string& value) {
+    version_++;
+    FrontCodedBlockBuilder builder;
+    if (size_ == 0) {
+        builder.add(key, value);
+        Page* page = new Page();
+        store(*page, builder);
+        pages_.insert(std::string(), page);
+        size_ = 1;
+        return;
+    }
+
+    // Copy the page with the entry added or replaced in its place
+    Page* page = findPage(key, nullptr);
+    builder.reserve(page->data.size() + key.size() + value.size() + 32);
+    FrontCodedBlockIterator entries;
+    entries.init(bytes(page->data), page->data.size());
+    bool added = false;
+    bool replaced = false;
+    for (entries.seekToFirst(); entries.valid(); entries.next()) {
+        if (!added && entries.key() >= key) {
+            builder.add(key, value);
+            added = true;
+            if (entries.key() == key) {
+                replaced = true;
+                continue;
+            }
+        }
+        builder.add(entries.key(), entries.value());
+    }
+    if (!added) {
+        builder.add(key, value);
+    }
+    store(*page, builder);
+    if (!replaced) {
+        size_++;
+    }
+    if (page->data.size() > PAGE_SIZE && page->count >= 2) {
+        split(page);
+    }
+}
+
+void FrontCodedBTree::split(Page* page) {
+    // Halve by bytes, so a page of a few long entries splits evenly too
+    FrontCodedBlockBuilder left;
+    FrontCodedBlockBuilder right;
+    left.reserve(page->data.size() / 2 + 64);
+    right.reserve(page->data.size() / 2 + 64);
+    size_t half = page->data.size() / 2;
+    std::string rightFirst;
+    FrontCodedBlockIterator entries;
+    entries.init(bytes(page->data), page->data.size());
+    for (entries.seekToFirst(); entries.valid(); entries.next()) {
+        bool toLeft = right.empty() && (left.empty() || (left.getSizeEstimate() < half &&
+                                                         left.getEntryCount() + 1 < page->count));
+        if (toLeft) {
+            left.add(entries.key(), entries.value());
+        } else {
+            if (right.empty()) {
+                rightFirst.assign(entries.key().data(), entries.key().size());
+            }
+            right.add(entries.key(), entries.value());
+        }
+    }
+    std::string separator = shortestSeparator(left.getLastKey(), rightFirst);
+    Page* sibling = new Page();
+    store(*sibling, right);
+    store(*page, left);
+    pages_.insert(separator, sibling);
+}
+
+bool FrontCodedBTree::remove(const std::string& key) {
+    if (size_ == 0) {
+        return false;
+    }
+    std::string separator;
+    Page* page = findPage(key, &separator);
+    FrontCodedBlockIterator entries;
+    entries.init(bytes(page->data), page->data.size());
+    entries.seek(key);
+    if (!entries.valid() || entries.key() != key) {
+        return false;
+    }
+
+    FrontCodedBlockBuilder builder;
+    builder.reserve(page->data.size());
+    for (entries.seekToFirst(); entries.valid(); entries.next()) {
+        if (entries.key() != key) {
+            builder.add(entries.key(), entries.value());
+        }
+    }
+    store(*page, builder);
+    size_--;
+    version_++;
+    if (page->data.size() < PAGE_SIZE / 4) {
+        shrink(page, separator);
+    }
+    return true;
+}
+
+void FrontCodedBTree::shrink(Page* page, const std::string& separator) {
+    if (page->count == 0) {
+        // The first page's separator stays empty, taken over by the next page
+        pages_.remove(separator);
+        delete page;
+        if (separator.empty()) {
+            std::string nextSeparator;
+            Page* next = nextPage(separator, nextSeparator);
+            if (next != nullptr) {
+                pages_.remove(nextSeparator);
+                pages_.insert(std::string(), next);
+            }
+        }
+        return;
+    }
+
+    // Take in the next page's entries if both fit in one page
+    std::string nextSeparator;
+    Page* next = nextPage(separator, nextSeparator);
+    if (next == nullptr || page->data.size() + next->data.size() > PAGE_SIZE) {
+        return;
+    }
+    FrontCodedBlockBuilder builder;
+    builder.reserve(page->data.size() + next->data.size());
+    for (const Page* source : {static_cast<const Page*>(page), static_cast<const Page*>(next)}) {
+        FrontCodedBlockIterator entries;
+        entries.init(bytes(source->data), source->data.size());
+        for (entries.seekToFirst(); entries.valid(); entries.next()) {
+            builder.add(entries.key(), entries.value());
+        }
+    }
+    store(*page, builder);
+    pages_.remove(nextSeparator);
+    delete next;
+}
+
+void FrontCodedBTree::clear() {
+    pages_.forEach([](const std::string&, Page* page) {
+        delete page;
+    });
+    pages_.clear();
+    size_ = 0;
+    version_++;
+}
+
+void FrontCodedBTree::bulkLoad(std::vector<std::pair<std::string, std::string>> entries, double fillFactor) {
+    clear();
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const std::pair<std::string, std::string>& a, const std::pair<std::string, std::string>& b) {
+                         return a.first < b.first;
+                     });
+
+    size_t target = static_cast<size_t>(PAGE_SIZE * std::min(1.0, std::max(0.5, fillFactor)));
+    std::vector<std::pair<std::string, Page*>> pages;
+    FrontCodedBlockBuilder builder;
+    std::string separator;
+    std::string lastKey;
+    auto finishPage = [&]() {
+        Page* page = new Page();
+        store(*page, builder);
+        pages.emplace_back(std::move(separator), page);
+    };
+    for (size_t i = 0; i < entries.size(); ++i) {
+        // Of a run of equal keys, only the last entry counts
+        if (i + 1 < entries.size() && entries[i + 1].first == entries[i].first) {
+            continue;
+        }
+        const auto& entry = entries[i];
+        if (!builder.empty() && builder.getSizeEstimate() + entry.first.size() + entry.second.size() > target) {
+            finishPage();
+            separator = shortestSeparator(lastKey, entry.first);
+        }
+        builder.add(entry.first, entry.second);
+        lastKey = entry.first;
+        size_++;
+    }
+    if (!builder.empty()) {
+        finishPage();
+    }
+    pages_.bulkLoad(std::move(pages));
+}
+
+FrontCodedBTree::Cursor FrontCodedBTree::seek(const std::string& key, bool upper) const {
+    Cursor cursor(this);
+    if (size_ == 0) {
+        return cursor;
+    }
+    std::string separator;
+    const Page* page = findPage(key, &separator);
+    cursor.entries_.init(bytes(page->data), page->data.size());
+    cursor.entries_.seek(key);
+    if (upper && cursor.entries_.valid() && cursor.entries_.key() == key) {
+        cursor.entries_.next();
+    }
+    if (!cursor.entries_.valid()) {
+        page = nextPage(separator, separator);
+        if (page != nullptr) {
+            cursor.entries_.init(bytes(page->data), page->data.size());
+            cursor.entries_.seekToFirst();
+        }
+    }
+    cursor.settle(page, separator);
+    return cursor;
+}
+
+FrontCodedBTree::Cursor FrontCodedBTree::seekBefore(const std::string& key) const {
+    Cursor cursor(this);
+    if (size_ == 0) {
+        return cursor;
+    }
+    std::string separator;
+    const Page* page = findPage(key, &separator);
+    cursor.entries_.init(bytes(page->data), page->data.size());
+    cursor.entries_.seekBefore(key);
+    if (!cursor.entries_.valid()) {
+        page = prevPage(separator, separator);
+        if (page != nullptr) {
+            cursor.entries_.init(bytes(page->data), page->data.size());
+            cursor.entries_.seekToLast();
+        }
+    }
+    cursor.settle(page, separator);
+    cursor.pastEnd_ = false;
+    return cursor;
+}
+
+FrontCodedBTree::Cursor FrontCodedBTree::first() const {
+    Cursor cursor = seek(std::string(), false);
+    cursor.pastEnd_ = false;
+    return cursor;
+}
+
+FrontCodedBTree::Cursor FrontCodedBTree::last() const {
+    Cursor cursor(this);
+    auto lastPage = pages_.last();
+    if (!lastPage.valid()) {
+        return cursor;
+    }
+    const Page* page = lastPage.value();
+    cursor.entries_.init(bytes(page->data), page->data.size());
+    cursor.entries_.seekToLast();
+    cursor.settle(page, lastPage.key());
+    return cursor;
+}
+
+FrontCodedBTree::Cursor FrontCodedBTree::lowerBound(const std::string& key) const {
+    return seek(key, false);
+}
+
+FrontCodedBTree::Cursor FrontCodedBTree::upperBound(const std::string& key) const {
+    return seek(key, true);
+}
+
+size_t FrontCodedBTree::getSize() const {
+    return size_;
+}
+
+int FrontCodedBTree::getHeight() const {
+    return size_ == 0 ? 0 : pages_.getHeight() + 1;
+}
+
+size_t FrontCodedBTree::getPageCount() const {
+    return pages_.getSize();
+}
+
+size_t FrontCodedBTree::getMemoryUsage() const {
+    size_t bytes = pages_.getMemoryUsage();
+    pages_.forEach([&bytes](const std::string& separator, const Page* page) {
+        bytes += heapBytes(separator) + sizeof(Page) + heapBytes(page->data);
+    });
+    return bytes;
+}
+
+FrontCodedBTree::Cursor::Cursor(const FrontCodedBTree* tree)
+    : tree_(tree), page_(nullptr), version_(tree->version_), hasKey_(false), pastEnd_(true) {}
+
+void FrontCodedBTree::Cursor::settle(const Page* page, const std::string& separator) const {
+    if (page == nullptr || !entries_.valid()) {
+        page_ = nullptr;
+        pastEnd_ = entries_.ok();
+        return;
+    }
+    page_ = page;
+    if (&separator != &separator_) {
+        separator_ = separator;
+    }
+    key_.assign(entries_.key().data(), entries_.key().size());
+    value_.assign(entries_.value().data(), entries_.value().size());
+    version_ = tree_->version_;
+    hasKey_ = true;
+    pastEnd_ = false;
+}
+
+void FrontCodedBTree::Cursor::refresh() const {
+    if (tree_ == nullptr || version_ == tree_->version_) {
+        return;
+    }
+    // Pages were rewritten: find the remembered key again
+    version_ = tree_->version_;
+    if (page_ == nullptr) {
+        return;
+    }
+    Cursor found = tree_->seek(key_, false);
+    if (found.page_ != nullptr && found.key_ == key_) {
+        page_ = found.page_;
+        separator_ = found.separator_;
+        entries_ = found.entries_;
+        value_ = found.value_;
+    } else {
+        page_ = nullptr;
+    }
+}
+
+bool FrontCodedBTree::Cursor::valid() const {
+    refresh();
+    return page_ != nullptr;
+}
+
+const std::string& FrontCodedBTree::Cursor::key() const {
+    return key_;
+}
+
+const std::string& FrontCodedBTree::Cursor::value() const {
+    refresh();
+    return value_;
+}
+
+void FrontCodedBTree::Cursor::next() {
+    if (tree_ == nullptr || (!hasKey_ && page_ == nullptr)) {
+        return;
+    }
+    refresh();
+    if (page_ != nullptr) {
+        entries_.next();
+        if (entries_.valid()) {
+            settle(page_, separator_);
+            return;
+        }
+    }
+    *this = tree_->seek(key_, true);
+}
+
+void FrontCodedBTree::Cursor::prev() {
+    if (tree_ == nullptr) {
+        return;
+    }
+    if (pastEnd_ && page_ == nullptr) {
+        *this = tree_->last();
+        return;
+    }
+    if (!hasKey_) {
+        return;
+    }
+    refresh();
+    *this = tree_->seekBefore(key_);
+}
+
+} // namespace storage
+} // namespace phantomdb
@@ -0,0 +1,232 @@
+#ifndef PHANTOMDB_FRONT_CODED_BTREE_H
+#define PHANTOMDB_FRONT_CODED_BTREE_H
+
+#include "bplus_tree.h"
+#include "front_coding.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <limits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * @brief B+tree over string keys and values with front-coded leaves
+ *
+ * Leaves are pages of about PAGE_SIZE bytes, each one front-coded block
+ * (see FrontCodedBlockBuilder), so keys sharing long prefixes, such as
+ * URLs or tenant-prefixed ids, are stored as little more than their
+ * distinct tails, and values sit next to them instead of in separate
+ * allocations. The inner levels are a BPlusTree from each page's
+ * separator to the page; separators are the shortest strings that tell a
+ * page from the one before it (the first page's is empty), which keeps the
+ * inner nodes small too.
+ *
+ * A lookup walks the inner tree, binary searches the page's restart keys
+ * and decodes at most one restart interval. A write rebuilds its page,
+ * splitting it in two when it outgrows PAGE_SIZE and merging it into its
+ * neighbour when it shrinks below a quarter of that. Keys are unique and
+ * the interface follows BPlusTree, except that forEach and scan pass
+ * std::string_view. Not thread safe.
+ */
+class FrontCodedBTree {
+private:
+    struct Page;
+
+public:
+    static const size_t PAGE_SIZE = 4096;
+
+    /**
+     * @brief Position on an entry, moved in key order in either direction
+     *
+     * As with BPlusTree cursors, a cursor remembers its key and finds it
+     * again once the tree has changed, so writes made while iterating
+     * never leave it dangling. The key and value are copies owned by the
+     * cursor.
+     */
+    class Cursor {
+    public:
+        Cursor() : tree_(nullptr), page_(nullptr), version_(0), hasKey_(false), pastEnd_(false) {}
+
+        // On an entry; key() and value() may only be called then
+        bool valid() const;
+
+        const std::string& key() const;
+        const std::string& value() const;
+
+        // Move to the next larger key; invalid after the last one
+        void next();
+
+        // Move to the next smaller key; invalid before the first one. A
+        // cursor past the last entry moves onto it
+        void prev();
+
+    private:
+        friend class FrontCodedBTree;
+
+        explicit Cursor(const FrontCodedBTree* tree);
+
+        void refresh() const;
+
+        // Take the entry entries_ is on in page, or become invalid
+        void settle(const Page* page, const std::string& separator) const;
+
+        const FrontCodedBTree* tree_;
+        mutable const Page* page_;  // Null when not on an entry
+        mutable std::string separator_;
+        mutable FrontCodedBlockIterator entries_;
+        mutable uint64_t version_;
+        mutable std::string key_;
+        mutable std::string value_;
+        mutable bool hasKey_;
+        mutable bool pastEnd_;
+    };
+
+    FrontCodedBTree();
+    ~FrontCodedBTree();
+
+    FrontCodedBTree(const FrontCodedBTree&) = delete;
+    FrontCodedBTree& operator=(const FrontCodedBTree&) = delete;
+
+    // Insert a key-value pair, replacing the value of an existing key
+    void insert(const std::string& key, const std::string& value);
+
+    // Search for a key
+    bool search(const std::string& key, std::string& value) const;
+
+    // Remove a key
+    bool remove(const std::string& key);
+
+    // Remove every key
+    void clear();
+
+    /**
+     * @brief Replace the contents with entries, packing pages in one pass
+     *
+     * For a repeated key the last entry wins, as with insert.
+     *
+     * @param fillFactor Share of each page to fill, clamped to [0.5, 1];
+     *        below 1 leaves room for later inserts without splits
+     */
+    void bulkLoad(std::vector<std::pair<std::string, std::string>> entries, double fillFactor = 1.0);
+
+    // Call fn(key, value) for every entry in key order
+    template<typename Fn>
+    void forEach(Fn fn) const;
+
+    /**
+     * @brief Call fn(key, value) for the keys in [low, high] in key order
+     *
+     * @param limit Stop after this many entries
+     * @return The number of entries visited
+     */
+    template<typename Fn>
+    size_t scan(const std::string& low, const std::string& high, Fn fn,
+                size_t limit = std::numeric_limits<size_t>::max()) const;
+
+    // Cursors on the smallest and largest keys (invalid when empty)
+    Cursor first() const;
+    Cursor last() const;
+
+    // Cursor on the first key >= key (lower) or > key (upper); it is past
+    // the end when there is none, so prev() moves onto the last key
+    Cursor lowerBound(const std::string& key) const;
+    Cursor upperBound(const std::string& key) const;
+
+    size_t getSize() const;
+
+    // Levels from the root to the pages (0 when empty)
+    int getHeight() const;
+
+    size_t getPageCount() const;
+
+    // Bytes held by the pages and the inner tree, separators included
+    size_t getMemoryUsage() const;
+
+private:
+    struct Page {
+        std::string data;  // One front-coded block
+        size_t count = 0;
+    };
+
+    using PageTree = BPlusTree<std::string, Page*>;
+
+    PageTree pages_;
+    size_t size_;
+    uint64_t version_;  // Bumped by every write, since any write rewrites a page
+
+    // The page that holds key, and its separator
+    Page* findPage(const std::string& key, std::string* separator) const;
+
+    // The page after (or before) the one with separator, and its separator
+    Page* nextPage(const std::string& separator, std::string& nextSeparator) const;
+    Page* prevPage(const std::string& separator, std::string& prevSeparator) const;
+
+    // Replace a page's contents with the builder's block
+    static void store(Page& page, FrontCodedBlockBuilder& builder);
+
+    // Split a page that outgrew PAGE_SIZE into two
+    void split(Page* page);
+
+    // Fold a page that shrank below a quarter of PAGE_SIZE into its right
+    // neighbour's place, or drop it once empty
+    void shrink(Page* page, const std::string& separator);
+
+    // Cursor on the first key >= key (or > key when upper is true)
+    Cursor seek(const std::string& key, bool upper) const;
+
+    // Cursor on the last key < key (invalid if none)
+    Cursor seekBefore(const std::string& key) const;
+};
+
+// Implementation
+template<typename Fn>
+void FrontCodedBTree::forEach(Fn fn) const {
+    pages_.forEach([&fn](const std::string&, Page* page) {
+        FrontCodedBlockIterator entries;
+        entries.init(reinterpret_cast<const unsigned char*>(page->data.data()), page->data.size());
+        for (entries.seekToFirst(); entries.valid(); entries.next()) {
+            fn(entries.key(), entries.value());
+        }
+    });
+}
+
+template<typename Fn>
+size_t FrontCodedBTree::scan(const std::string& low, const std::string& high, Fn fn, size_t limit) const {
+    size_t visited = 0;
+    if (size_ == 0 || high < low) {
+        return visited;
+    }
+    std::string separator;
+    const Page* page = findPage(low, &separator);
+    FrontCodedBlockIterator entries;
+    entries.init(reinterpret_cast<const unsigned char*>(page->data.data()), page->data.size());
+    entries.seek(low);
+    while (visited < limit) {
+        if (!entries.valid()) {
+            page = nextPage(separator, separator);
+            if (page == nullptr) {
+                break;
+            }
+            entries.init(reinterpret_cast<const unsigned char*>(page->data.data()), page->data.size());
+            entries.seekToFirst();
+            continue;
+        }
+        if (entries.key() > high) {
+            break;
+        }
+        fn(entries.key(), entries.value());
+        visited++;
+        entries.next();
+    }
+    return visited;
+}
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_FRONT_CODED_BTREE_H
@@ -0,0 +1,321 @@
+#include "front_coded_btree.h"
+#include "front_coding.h"
+#include "bplus_tree.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <map>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+using namespace phantomdb::storage;
+
+namespace {
+
+// Keys sharing long prefixes, in the shape of URLs
+std::string urlKey(int i) {
+    return "https://shop.example.com/tenants/" + std::to_string(i % 50) + "/orders/" + std::to_string(i);
+}
+
+} // anonymous namespace
+
+void testBlockCodec() {
+    std::cout << "Testing front-coded blocks..." << std::endl;
+
+    FrontCodedBlockBuilder builder(4);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 50; ++i) {
+        keys.push_back(urlKey(1000 + i * 2));
+    }
+    std::sort(keys.begin(), keys.end());
+    size_t raw = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        builder.add(keys[i], "v" + std::to_string(i), i % 7 == 0);
+        raw += keys[i].size();
+    }
+    assert(builder.getEntryCount() == keys.size());
+    std::string block = builder.finish();
+    assert(builder.empty());
+
+    // Shared prefixes are stored once per restart interval
+    assert(block.size() < raw / 2);
+
+    FrontCodedBlockIterator it;
+    assert(it.init(reinterpret_cast<const unsigned char*>(block.data()), block.size()));
+    size_t index = 0;
+    for (it.seekToFirst(); it.valid(); it.next()) {
+        assert(it.key() == keys[index]);
+        assert(it.value() == "v" + std::to_string(index));
+        assert(it.flag() == (index % 7 == 0));
+        index++;
+    }
+    assert(index == keys.size() && it.ok());
+
+    // Seeks land on the first key >= target, or the last one < target
+    for (size_t i = 0; i < keys.size(); ++i) {
+        it.seek(keys[i]);
+        assert(it.valid() && it.key() == keys[i]);
+        it.seek(keys[i] + "0");
+        assert(i + 1 == keys.size() ? !it.valid() : it.key() == keys[i + 1]);
+        it.seekBefore(keys[i]);
+        assert(i == 0 ? !it.valid() : it.key() == keys[i - 1]);
+    }
+    it.seek("");
+    assert(it.valid() && it.key() == keys.front());
+    it.seekBefore("zzz");
+    assert(it.valid() && it.key() == keys.back());
+    it.seekToLast();
+    assert(it.valid() && it.key() == keys.back());
+
+    // Truncated or garbled blocks are rejected without reading past the end
+    FrontCodedBlockIterator broken;
+    assert(!broken.init(reinterpret_cast<const unsigned char*>(block.data()), 3));
+    std::string garbled = block;
+    garbled[1] = static_cast<char>(0x7F);
+    if (broken.init(reinterpret_cast<const unsigned char*>(garbled.data()), garbled.size())) {
+        for (broken.seekToFirst(); broken.valid(); broken.next()) {
+        }
+    }
+
+    // Separators fall between their neighbours and are as short as possible
+    assert(shortestSeparator("apple", "apricot") == "apr");
+    assert(shortestSeparator("abc", "abcd") == "abcd");
+    assert(shortestSeparator("a", "b") == "b");
+    std::string separator = shortestSeparator(keys[10], keys[11]);
+    assert(keys[10] < separator && separator <= keys[11]);
+
+    std::cout << "Front-coded blocks test passed!" << std::endl;
+}
+
+void testBasicOperations() {
+    std::cout << "Testing basic front-coded B-tree operations..." << std::endl;
+
+    FrontCodedBTree tree;
+    std::string value;
+    assert(!tree.search("a", value));
+    assert(!tree.remove("a"));
+    assert(tree.getHeight() == 0);
+    assert(!tree.first().valid() && !tree.last().valid());
+
+    tree.insert("b", "two");
+    tree.insert("a", "one");
+    tree.insert("c", "three");
+    assert(tree.search("a", value) && value == "one");
+    assert(tree.search("c", value) && value == "three");
+    assert(!tree.search("d", value));
+    assert(!tree.search("", value));
+
+    // Keys are unique; inserting again replaces the value
+    tree.insert("b", "TWO");
+    assert(tree.search("b", value) && value == "TWO");
+    assert(tree.getSize() == 3);
+
+    // The empty key is a key like any other
+    tree.insert("", "empty");
+    assert(tree.search("", value) && value == "empty");
+    assert(tree.remove(""));
+
+    assert(tree.remove("b"));
+    assert(!tree.search("b", value));
+    assert(!tree.remove("b"));
+    assert(tree.remove("a") && tree.remove("c"));
+    assert(tree.getSize() == 0 && tree.getHeight() == 0);
+
+    std::cout << "Basic operations test passed!" << std::endl;
+}
+
+void testAgainstMap() {
+    std::cout << "Testing random operations against std::map..." << std::endl;
+
+    FrontCodedBTree tree;
+    std::map<std::string, std::string> expected;
+    std::mt19937 rng(11);
+    std::string value;
+    for (int round = 0; round < 60000; ++round) {
+        std::string key = urlKey(static_cast<int>(rng() % 8000));
+        switch (rng() % 4) {
+            case 0:
+            case 1:
+                {
+                    std::string newValue(static_cast<size_t>(rng() % 40), static_cast<char>('a' + rng() % 26));
+                    tree.insert(key, newValue);
+                    expected[key] = newValue;
+                }
+                break;
+            case 2:
+                assert(tree.remove(key) == (expected.erase(key) == 1));
+                break;
+            default:
+                {
+                    auto it = expected.find(key);
+                    assert(tree.search(key, value) == (it != expected.end()));
+                    assert(it == expected.end() || value == it->second);
+                }
+                break;
+        }
+    }
+    assert(tree.getSize() == expected.size());
+    assert(tree.getPageCount() > 1 && tree.getHeight() >= 2);
+
+    // Every entry comes back in order
+    auto it = expected.begin();
+    tree.forEach([&it](std::string_view key, std::string_view entryValue) {
+        assert(key == it->first && entryValue == it->second);
+        ++it;
+    });
+    assert(it == expected.end());
+
+    // Cursors walk every page in both directions
+    size_t count = 0;
+    for (auto cursor = tree.first(); cursor.valid(); cursor.next()) {
+        count++;
+    }
+    assert(count == expected.size());
+    auto reverse = expected.rbegin();
+    for (auto cursor = tree.last(); cursor.valid(); cursor.prev()) {
+        assert(cursor.key() == reverse->first && cursor.value() == reverse->second);
+        ++reverse;
+    }
+    assert(reverse == expected.rend());
+
+    // Ranges and bounds agree with the map
+    for (int i = 0; i < 200; ++i) {
+        std::string low = urlKey(static_cast<int>(rng() % 8000));
+        std::vector<std::string> found;
+        tree.scan(low, urlKey(static_cast<int>(rng() % 8000)), [&found](std::string_view key, std::string_view) {
+            found.emplace_back(key);
+        }, 25);
+        auto lower = tree.lowerBound(low);
+        auto mapLower = expected.lower_bound(low);
+        assert(lower.valid() == (mapLower != expected.end()));
+        assert(!lower.valid() || lower.key() == mapLower->first);
+        auto upper = tree.upperBound(low);
+        auto mapUpper = expected.upper_bound(low);
+        assert(upper.valid() == (mapUpper != expected.end()));
+        assert(!upper.valid() || upper.key() == mapUpper->first);
+        if (!upper.valid()) {
+            upper.prev();
+            assert(upper.valid() && upper.key() == expected.rbegin()->first);
+        }
+        for (size_t j = 0; j < found.size(); ++j) {
+            assert(found[j] == mapLower->first);
+            ++mapLower;
+        }
+    }
+
+    // Removing everything shrinks the tree back to nothing
+    for (const auto& pair : expected) {
+        assert(tree.remove(pair.first));
+    }
+    assert(tree.getSize() == 0 && tree.getPageCount() == 0);
+    assert(!tree.first().valid());
+
+    std::cout << "Random operations test passed!" << std::endl;
+}
+
+void testCursorsAcrossModifications() {
+    std::cout << "Testing cursors across modifications..." << std::endl;
+
+    FrontCodedBTree tree;
+    for (int i = 0; i < 2000; ++i) {
+        tree.insert(urlKey(i * 2), std::to_string(i));
+    }
+
+    // Removing every key as the cursor reaches it still visits all of them
+    std::map<std::string, std::string> remaining;
+    tree.forEach([&remaining](std::string_view key, std::string_view value) {
+        remaining.emplace(std::string(key), std::string(value));
+    });
+    size_t visited = 0;
+    auto cursor = tree.first();
+    while (cursor.valid()) {
+        std::string key = cursor.key();
+        assert(remaining.count(key) == 1);
+        visited++;
+        if (visited % 3 == 0) {
+            // Insert ahead of the cursor; it shows up later in the walk
+            tree.insert(key + "~", "new");
+            remaining[key + "~"] = "new";
+        }
+        assert(tree.remove(key));
+        remaining.erase(key);
+        assert(!cursor.valid());
+        cursor.next();
+    }
+    assert(remaining.empty() && tree.getSize() == 0);
+    assert(visited > 2000);
+
+    // A replaced value is seen through an existing cursor
+    tree.insert("k1", "a");
+    tree.insert("k2", "b");
+    auto onK1 = tree.lowerBound("k1");
+    tree.insert("k1", "c");
+    assert(onK1.valid() && onK1.key() == "k1" && onK1.value() == "c");
+    onK1.next();
+    assert(onK1.valid() && onK1.key() == "k2");
+
+    std::cout << "Cursors across modifications test passed!" << std::endl;
+}
+
+void testBulkLoadAndFootprint() {
+    std::cout << "Testing bulk load and memory footprint..." << std::endl;
+
+    const int count = 50000;
+    std::vector<std::pair<std::string, std::string>> entries;
+    for (int i = 0; i < count; ++i) {
+        entries.emplace_back(urlKey(i), std::to_string(i));
+    }
+    entries.emplace_back(urlKey(7), "replaced");
+    std::shuffle(entries.begin(), entries.end(), std::mt19937(3));
+
+    FrontCodedBTree tree;
+    tree.bulkLoad(entries, 0.8);
+    assert(tree.getSize() == static_cast<size_t>(count));
+    std::string value;
+    for (int i = 0; i < count; i += 97) {
+        assert(tree.search(urlKey(i), value));
+    }
+
+    // The later of two entries for a key wins, as with insert
+    std::string expectedSeven;
+    for (const auto& entry : entries) {
+        if (entry.first == urlKey(7)) {
+            expectedSeven = entry.second;
+        }
+    }
+    assert(tree.search(urlKey(7), value) && value == expectedSeven);
+
+    // Inserts after a partial fill split pages instead of failing
+    for (int i = 0; i < 5000; ++i) {
+        tree.insert(urlKey(i) + "/items", "x");
+    }
+    assert(tree.getSize() == static_cast<size_t>(count + 5000));
+    assert(tree.search(urlKey(4999) + "/items", value) && value == "x");
+
+    // The front-coded tree takes far less memory than whole strings in nodes
+    FrontCodedBTree packed;
+    BPlusTree<std::string, std::string> plain;
+    size_t plainStringBytes = 0;
+    for (int i = 0; i < count; ++i) {
+        plain.insert(urlKey(i), std::to_string(i));
+        plainStringBytes += urlKey(i).size() + 1;
+    }
+    packed.bulkLoad(entries);
+    assert(packed.getMemoryUsage() * 2 < plain.getMemoryUsage() + plainStringBytes);
+
+    std::cout << "Bulk load and memory footprint test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running front-coded B-tree tests..." << std::endl;
+
+    testBlockCodec();
+    testBasicOperations();
+    testAgainstMap();
+    testCursorsAcrossModifications();
+    testBulkLoadAndFootprint();
+
+    std::cout << "All front-coded B-tree tests passed!" << std::endl;
+    return 0;
+}
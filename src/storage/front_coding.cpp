@@ -0,0 +1,254 @@
+#include "front_coding.h"
+#include "utils.h"
+#include <algorithm>
+
+namespace phantomdb {
+namespace storage {
+
+namespace {
+
+using core::utils::putVarint;
+using core::utils::getVarint;
+using core::utils::putFixed32;
+using core::utils::getFixed;
+
+} // anonymous namespace
+
+size_t sharedPrefixLength(std::string_view a, std::string_view b) {
+    size_t limit = std::min(a.size(), b.size());
+    size_t shared = 0;
+    while (shared < limit && a[shared] == b[shared]) {
+        shared++;
+    }
+    return shared;
+}
+
+std::string shortestSeparator(std::string_view low, std::string_view high) {
+    // high differs from low at the first byte past their common prefix (or
+    // low ends there), so that prefix plus high's next byte is > low
+    size_t length = std::min(sharedPrefixLength(low, high) + 1, high.size());
+    return std::string(high.substr(0, length));
+}
+
+FrontCodedBlockBuilder::FrontCodedBlockBuilder(size_t restartInterval)
+    : restartInterval_(std::max<size_t>(restartInterval, 1)), entryCount_(0) {}
+
+void FrontCodedBlockBuilder::add(std::string_view key, std::string_view value, bool flag) {
+    size_t shared = 0;
+    if (entryCount_ % restartInterval_ == 0) {
+        restarts_.push_back(static_cast<uint32_t>(buffer_.size()));
+    } else {
+        shared = sharedPrefixLength(lastKey_, key);
+    }
+    putVarint(buffer_, shared);
+    putVarint(buffer_, key.size() - shared);
+    putVarint(buffer_, (static_cast<uint64_t>(value.size()) << 1) | (flag ? 1 : 0));
+    buffer_.append(key.data() + shared, key.size() - shared);
+    buffer_.append(value.data(), value.size());
+    lastKey_.assign(key.data(), key.size());
+    entryCount_++;
+}
+
+std::string FrontCodedBlockBuilder::finish() {
+    for (uint32_t offset : restarts_) {
+        putFixed32(buffer_, offset);
+    }
+    putFixed32(buffer_, static_cast<uint32_t>(restarts_.size()));
+    std::string block;
+    block.swap(buffer_);
+    reset();
+    return block;
+}
+
+void FrontCodedBlockBuilder::reset() {
+    buffer_.clear();
+    restarts_.clear();
+    lastKey_.clear();
+    entryCount_ = 0;
+}
+
+void FrontCodedBlockBuilder::reserve(size_t bytes) {
+    buffer_.reserve(bytes);
+}
+
+bool FrontCodedBlockBuilder::empty() const {
+    return entryCount_ == 0;
+}
+
+size_t FrontCodedBlockBuilder::getEntryCount() const {
+    return entryCount_;
+}
+
+size_t FrontCodedBlockBuilder::getSizeEstimate() const {
+    return buffer_.size() + 4 * (restarts_.size() + 1);
+}
+
+std::string_view FrontCodedBlockBuilder::getLastKey() const {
+    return lastKey_;
+}
+
+FrontCodedBlockIterator::FrontCodedBlockIterator()
+    : data_(nullptr), entriesEnd_(nullptr), restarts_(0), pos_(nullptr), flag_(false), valid_(false), ok_(true) {}
+
+bool FrontCodedBlockIterator::init(const unsigned char* data, size_t size) {
+    data_ = data;
+    valid_ = false;
+    ok_ = false;
+    restarts_ = 0;
+    entriesEnd_ = data;
+    pos_ = data;
+    if (size < 4) {
+        return false;
+    }
+    uint64_t restarts = getFixed(data + size - 4, 4);
+    if (restarts > (size - 4) / 4) {
+        return false;
+    }
+    entriesEnd_ = data + size - 4 - 4 * restarts;
+    restarts_ = static_cast<size_t>(restarts);
+    pos_ = entriesEnd_;
+    for (size_t i = 0; i < restarts_; ++i) {
+        if (restartOffset(i) >= static_cast<size_t>(entriesEnd_ - data_)) {
+            restarts_ = 0;
+            return false;
+        }
+    }
+    ok_ = true;
+    return true;
+}
+
+uint32_t FrontCodedBlockIterator::restartOffset(size_t index) const {
+    return static_cast<uint32_t>(getFixed(entriesEnd_ + 4 * index, 4));
+}
+
+bool FrontCodedBlockIterator::restartKey(size_t index, std::string_view& key) const {
+    const unsigned char* pos = data_ + restartOffset(index);
+    uint64_t shared, unshared, valueField;
+    if (!getVarint(pos, entriesEnd_, shared) || !getVarint(pos, entriesEnd_, unshared) ||
+        !getVarint(pos, entriesEnd_, valueField) || shared != 0 ||
+        unshared > static_cast<uint64_t>(entriesEnd_ - pos)) {
+        return false;
+    }
+    key = std::string_view(reinterpret_cast<const char*>(pos), static_cast<size_t>(unshared));
+    return true;
+}
+
+size_t FrontCodedBlockIterator::lastRestartBefore(std::string_view target) const {
+    // Restart keys are stored whole, so they compare without decoding
+    size_t low = 0;
+    size_t high = restarts_;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        std::string_view key;
+        if (!restartKey(middle, key)) {
+            return restarts_;
+        }
+        if (key < target) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low == 0 ? restarts_ : low - 1;
+}
+
+void FrontCodedBlockIterator::seekToRestart(size_t index) {
+    key_.clear();
+    pos_ = data_ + restartOffset(index);
+    decode();
+}
+
+void FrontCodedBlockIterator::decode() {
+    if (pos_ >= entriesEnd_) {
+        valid_ = false;
+        return;
+    }
+    uint64_t shared, unshared, valueField;
+    if (!getVarint(pos_, entriesEnd_, shared) || !getVarint(pos_, entriesEnd_, unshared) ||
+        !getVarint(pos_, entriesEnd_, valueField) || shared > key_.size() ||
+        unshared > static_cast<uint64_t>(entriesEnd_ - pos_) ||
+        (valueField >> 1) > static_cast<uint64_t>(entriesEnd_ - pos_) - unshared) {
+        valid_ = false;
+        ok_ = false;
+        return;
+    }
+    key_.resize(static_cast<size_t>(shared));
+    key_.append(reinterpret_cast<const char*>(pos_), static_cast<size_t>(unshared));
+    pos_ += unshared;
+    value_ = std::string_view(reinterpret_cast<const char*>(pos_), static_cast<size_t>(valueField >> 1));
+    pos_ += valueField >> 1;
+    flag_ = (valueField & 1) != 0;
+    valid_ = true;
+}
+
+void FrontCodedBlockIterator::seekToFirst() {
+    if (restarts_ == 0) {
+        valid_ = false;
+        return;
+    }
+    seekToRestart(0);
+}
+
+void FrontCodedBlockIterator::seekToLast() {
+    if (restarts_ == 0) {
+        valid_ = false;
+        return;
+    }
+    // Count the last interval's entries, then step to its final one
+    seekToRestart(restarts_ - 1);
+    size_t entries = 0;
+    while (valid_) {
+        entries++;
+        next();
+    }
+    if (!ok_) {
+        return;
+    }
+    seekToRestart(restarts_ - 1);
+    for (size_t i = 1; i < entries && valid_; ++i) {
+        next();
+    }
+}
+
+void FrontCodedBlockIterator::seek(std::string_view target) {
+    if (restarts_ == 0) {
+        valid_ = false;
+        return;
+    }
+    size_t restart = lastRestartBefore(target);
+    seekToRestart(restart == restarts_ ? 0 : restart);
+    while (valid_ && std::string_view(key_) < target) {
+        next();
+    }
+}
+
+void FrontCodedBlockIterator::seekBefore(std::string_view target) {
+    size_t restart = lastRestartBefore(target);
+    if (restart == restarts_) {
+        valid_ = false;
+        return;
+    }
+    // Count the entries < target from the restart, then step to the last one
+    seekToRestart(restart);
+    size_t below = 0;
+    while (valid_ && std::string_view(key_) < target) {
+        below++;
+        next();
+    }
+    if (!ok_) {
+        return;
+    }
+    seekToRestart(restart);
+    for (size_t i = 1; i < below && valid_; ++i) {
+        next();
+    }
+}
+
+void FrontCodedBlockIterator::next() {
+    if (valid_) {
+        decode();
+    }
+}
+
+} // namespace storage
+} // namespace phantomdb
@@ -0,0 +1,140 @@
+#ifndef PHANTOMDB_FRONT_CODING_H
+#define PHANTOMDB_FRONT_CODING_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * Front-coded block of sorted entries (all integers little-endian):
+ *
+ *   entries    per entry: varint shared | varint unshared |
+ *              varint (value length << 1 | flag) | unshared key bytes | value
+ *   restarts   u32 offset of every restart entry | u32 restart count
+ *
+ * Each key is stored as the length of the prefix it shares with the key
+ * before it plus the bytes that differ, so keys with long common prefixes
+ * (URLs, tenant-prefixed ids) cost little more than their distinct tails.
+ * Every restartInterval-th entry is a restart point that stores its key
+ * in full; a seek binary searches the restart keys and then decodes at
+ * most one interval of entries. The flag bit is the caller's (sorted
+ * tables mark tombstones with it).
+ */
+class FrontCodedBlockBuilder {
+public:
+    static const size_t DEFAULT_RESTART_INTERVAL = 16;
+
+    explicit FrontCodedBlockBuilder(size_t restartInterval = DEFAULT_RESTART_INTERVAL);
+
+    // Append an entry; keys must be strictly increasing
+    void add(std::string_view key, std::string_view value, bool flag = false);
+
+    // Append the restart array to the entries and return the block; the
+    // builder is then empty again
+    std::string finish();
+
+    // Drop everything added since the last finish()
+    void reset();
+
+    // Allocate room for a block of about bytes up front
+    void reserve(size_t bytes);
+
+    bool empty() const;
+    size_t getEntryCount() const;
+
+    // Size of the block finish() would return
+    size_t getSizeEstimate() const;
+
+    // Last key added (empty before the first)
+    std::string_view getLastKey() const;
+
+private:
+    size_t restartInterval_;
+    std::string buffer_;
+    std::vector<uint32_t> restarts_;
+    std::string lastKey_;
+    size_t entryCount_;
+};
+
+/**
+ * Iterator over a front-coded block. The block's bytes must outlive the
+ * iterator; the current key is rebuilt in a buffer the iterator owns, so
+ * key() is only valid until the iterator moves. Malformed input never reads
+ * past the block: the iterator becomes invalid and ok() turns false.
+ */
+class FrontCodedBlockIterator {
+public:
+    FrontCodedBlockIterator();
+
+    // Attach to a block; false (and invalid) if its restart array is malformed
+    bool init(const unsigned char* data, size_t size);
+
+    bool valid() const { return valid_; }
+
+    // false once a malformed entry was hit
+    bool ok() const { return ok_; }
+
+    std::string_view key() const { return key_; }
+    std::string_view value() const { return value_; }
+    bool flag() const { return flag_; }
+
+    void seekToFirst();
+
+    // Position on the last entry
+    void seekToLast();
+
+    // Position on the first entry with key >= target (invalid if none)
+    void seek(std::string_view target);
+
+    // Position on the last entry with key < target (invalid if none)
+    void seekBefore(std::string_view target);
+
+    void next();
+
+private:
+    uint32_t restartOffset(size_t index) const;
+
+    // Full key of restart point index, without moving the iterator
+    bool restartKey(size_t index, std::string_view& key) const;
+
+    // Last restart point whose key is < target, or restarts_ if there is none
+    size_t lastRestartBefore(std::string_view target) const;
+
+    void seekToRestart(size_t index);
+
+    // Decode the entry at pos_; sets valid_ and ok_
+    void decode();
+
+    const unsigned char* data_;
+    const unsigned char* entriesEnd_;
+    size_t restarts_;
+    const unsigned char* pos_;  // Start of the next entry to decode
+    std::string key_;
+    std::string_view value_;
+    bool flag_;
+    bool valid_;
+    bool ok_;
+};
+
+// Length of the common prefix of a and b
+size_t sharedPrefixLength(std::string_view a, std::string_view b);
+
+/**
+ * @brief Shortest key s with low < s <= high, for a separator between two
+ *        sorted runs; keeping separators short is prefix truncation of
+ *        the index above the runs
+ *
+ * @param low Largest key of the left run
+ * @param high Smallest key of the right run (low < high)
+ */
+std::string shortestSeparator(std::string_view low, std::string_view high);
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_FRONT_CODING_H
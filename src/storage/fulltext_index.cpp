@@ -0,0 +1,410 @@
+#include "fulltext_index.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace phantomdb {
+namespace storage {
+
+const size_t FullTextIndex::BLOCK_SIZE;
+constexpr double FullTextIndex::K1;
+constexpr double FullTextIndex::B;
+
+namespace {
+
+using core::utils::putVarint;
+using core::utils::getVarint;
+
+struct ScoredDocument {
+    uint32_t doc;
+    double score;
+};
+
+// Orders the heap of the best hits so far with the worst on top
+struct WorseHit {
+    bool operator()(const ScoredDocument& a, const ScoredDocument& b) const {
+        return a.score > b.score || (a.score == b.score && a.doc < b.doc);
+    }
+};
+
+} // anonymous namespace
+
+/**
+ * Forward cursor over one posting list, decoding a block at a time.
+ * advance() consults the skip entries before decoding anything.
+ */
+class FullTextIndex::PostingIterator {
+public:
+    explicit PostingIterator(const PostingList& list) : list_(&list), valid_(!list.skips.empty()) {
+        if (valid_) {
+            loadBlock(0);
+        }
+    }
+    
+    bool valid() const { return valid_; }
+    uint32_t doc() const { return doc_; }
+    uint32_t frequency() const { return frequency_; }
+    const PostingList& list() const { return *list_; }
+    
+    void next() {
+        if (remaining_ > 0) {
+            decode();
+        } else if (block_ + 1 < list_->skips.size()) {
+            loadBlock(block_ + 1);
+        } else {
+            valid_ = false;
+        }
+    }
+    
+    // Move to the first posting for a document >= target
+    void advance(uint32_t target) {
+        if (!valid_ || doc_ >= target) {
+            return;
+        }
+        if (list_->skips[block_].lastDoc < target) {
+            auto block = std::lower_bound(list_->skips.begin() + block_ + 1, list_->skips.end(), target,
+                                          [](const SkipEntry& entry, uint32_t doc) {
+                                              return entry.lastDoc < doc;
+                                          });
+            if (block == list_->skips.end()) {
+                valid_ = false;
+                return;
+            }
+            loadBlock(block - list_->skips.begin());
+        }
+        while (valid_ && doc_ < target) {
+            next();
+        }
+    }
+
+private:
+    void loadBlock(size_t block) {
+        block_ = block;
+        pos_ = list_->skips[block].offset;
+        doc_ = list_->skips[block].baseDoc;
+        remaining_ = std::min<size_t>(BLOCK_SIZE, list_->count - block * BLOCK_SIZE);
+        decode();
+    }
+    
+    void decode() {
+        const uint8_t* bytes = list_->bytes.data();
+        const uint8_t* pos = bytes + pos_;
+        const uint8_t* end = bytes + list_->bytes.size();
+        uint64_t delta = 0;
+        uint64_t frequency = 0;
+        getVarint(pos, end, delta);
+        getVarint(pos, end, frequency);
+        doc_ += static_cast<uint32_t>(delta);
+        frequency_ = static_cast<uint32_t>(frequency);
+        pos_ = static_cast<size_t>(pos - bytes);
+        remaining_--;
+    }
+    
+    const PostingList* list_;
+    size_t block_ = 0;
+    size_t pos_ = 0;
+    size_t remaining_ = 0;  // Postings of the block not decoded yet
+    uint32_t doc_ = 0;
+    uint32_t frequency_ = 0;
+    bool valid_;
+};
+
+FullTextIndex::FullTextIndex() : totalLength_(0), removedDocuments_(0) {}
+
+FullTextIndex::~FullTextIndex() = default;
+
+std::vector<std::string> FullTextIndex::tokenize(const std::string& text) {
+    std::vector<std::string> terms;
+    std::string term;
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        bool word = (byte >= 'a' && byte <= 'z') || (byte >= '0' && byte <= '9') || byte >= 0x80;
+        if (byte >= 'A' && byte <= 'Z') {
+            term += static_cast<char>(byte - 'A' + 'a');
+        } else if (word) {
+            term += c;
+        } else if (!term.empty()) {
+            terms.push_back(std::move(term));
+            term.clear();
+        }
+    }
+    if (!term.empty()) {
+        terms.push_back(std::move(term));
+    }
+    return terms;
+}
+
+void FullTextIndex::append(PostingList& list, uint32_t doc, uint32_t frequency) {
+    // Each block's first delta is from the previous block's last document,
+    // so a skip can land on any block and decode it
+    uint32_t previous;
+    if (list.count % BLOCK_SIZE == 0) {
+        previous = list.skips.empty() ? 0 : list.skips.back().lastDoc;
+        list.skips.push_back({doc, previous, static_cast<uint32_t>(list.bytes.size())});
+    } else {
+        previous = list.skips.back().lastDoc;
+    }
+    putVarint(list.bytes, doc - previous);
+    putVarint(list.bytes, frequency);
+    list.skips.back().lastDoc = doc;
+    list.count++;
+}
+
+void FullTextIndex::insert(const std::string& key, const std::string& text) {
+    remove(key);
+    
+    std::vector<std::string> tokens = tokenize(text);
+    std::unordered_map<std::string, uint32_t> frequencies;
+    for (const auto& token : tokens) {
+        frequencies[token]++;
+    }
+    
+    uint32_t doc = static_cast<uint32_t>(documents_.size());
+    Document document;
+    document.key = key;
+    document.length = static_cast<uint32_t>(tokens.size());
+    document.terms.reserve(frequencies.size());
+    for (const auto& entry : frequencies) {
+        auto it = termIds_.find(entry.first);
+        if (it == termIds_.end()) {
+            it = termIds_.emplace(entry.first, static_cast<uint32_t>(lists_.size())).first;
+            lists_.emplace_back();
+        }
+        PostingList& list = lists_[it->second];
+        append(list, doc, entry.second);
+        list.documentFrequency++;
+        document.terms.push_back(it->second);
+    }
+    
+    totalLength_ += document.length;
+    documents_.push_back(std::move(document));
+    docNumbers_[key] = doc;
+}
+
+bool FullTextIndex::remove(const std::string& key) {
+    auto it = docNumbers_.find(key);
+    if (it == docNumbers_.end()) {
+        return false;
+    }
+    
+    // Postings stay until compaction; searches skip documents no longer live
+    Document& document = documents_[it->second];
+    for (uint32_t term : document.terms) {
+        lists_[term].documentFrequency--;
+    }
+    totalLength_ -= document.length;
+    document.live = false;
+    document.terms.clear();
+    document.terms.shrink_to_fit();
+    docNumbers_.erase(it);
+    removedDocuments_++;
+    
+    if (removedDocuments_ > docNumbers_.size()) {
+        compact();
+    }
+    return true;
+}
+
+double FullTextIndex::idf(const PostingList& list) const {
+    double documents = static_cast<double>(docNumbers_.size());
+    double frequency = static_cast<double>(list.documentFrequency);
+    return std::log(1.0 + (documents - frequency + 0.5) / (frequency + 0.5));
+}
+
+std::vector<FullTextHit> FullTextIndex::search(const std::string& query, size_t limit, bool matchAll) const {
+    std::vector<std::string> terms = tokenize(query);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    
+    std::vector<PostingIterator> iterators;
+    std::vector<double> weights;
+    for (const auto& term : terms) {
+        auto it = termIds_.find(term);
+        if (it == termIds_.end() || lists_[it->second].documentFrequency == 0) {
+            if (matchAll) {
+                return {};
+            }
+            continue;
+        }
+        iterators.emplace_back(lists_[it->second]);
+    }
+    if (iterators.empty()) {
+        return {};
+    }
+    
+    // Rarest term first: it proposes the fewest candidates for the others to skip to
+    std::sort(iterators.begin(), iterators.end(), [](const PostingIterator& a, const PostingIterator& b) {
+        return a.list().count < b.list().count;
+    });
+    for (const auto& iterator : iterators) {
+        weights.push_back(idf(iterator.list()));
+    }
+    
+    double averageLength = docNumbers_.empty() ? 1.0 : static_cast<double>(totalLength_) / docNumbers_.size();
+    if (averageLength == 0.0) {
+        averageLength = 1.0;
+    }
+    auto termScore = [this, averageLength](uint32_t doc, uint32_t frequency, double weight) {
+        double norm = K1 * (1.0 - B + B * documents_[doc].length / averageLength);
+        return weight * frequency * (K1 + 1.0) / (frequency + norm);
+    };
+    
+    std::priority_queue<ScoredDocument, std::vector<ScoredDocument>, WorseHit> best;
+    auto offer = [&best, limit](uint32_t doc, double score) {
+        if (limit == 0 || best.size() < limit) {
+            best.push({doc, score});
+        } else if (WorseHit()(ScoredDocument{doc, score}, best.top())) {
+            best.pop();
+            best.push({doc, score});
+        }
+    };
+    
+    if (matchAll) {
+        // Leapfrog: every list skips ahead to the rarest list's candidate
+        PostingIterator& lead = iterators[0];
+        bool exhausted = false;
+        while (lead.valid() && !exhausted) {
+            uint32_t candidate = lead.doc();
+            bool matched = true;
+            for (size_t i = 1; i < iterators.size() && matched; ++i) {
+                iterators[i].advance(candidate);
+                if (!iterators[i].valid()) {
+                    exhausted = true;
+                    matched = false;
+                } else if (iterators[i].doc() > candidate) {
+                    lead.advance(iterators[i].doc());
+                    matched = false;
+                }
+            }
+            if (!matched) {
+                continue;
+            }
+            if (documents_[candidate].live) {
+                double score = 0.0;
+                for (size_t i = 0; i < iterators.size(); ++i) {
+                    score += termScore(candidate, iterators[i].frequency(), weights[i]);
+                }
+                offer(candidate, score);
+            }
+            lead.next();
+        }
+    } else {
+        // Document at a time: score the smallest document any list is on
+        while (true) {
+            uint32_t doc = std::numeric_limits<uint32_t>::max();
+            for (const auto& iterator : iterators) {
+                if (iterator.valid()) {
+                    doc = std::min(doc, iterator.doc());
+                }
+            }
+            if (doc == std::numeric_limits<uint32_t>::max()) {
+                break;
+            }
+            double score = 0.0;
+            for (size_t i = 0; i < iterators.size(); ++i) {
+                if (iterators[i].valid() && iterators[i].doc() == doc) {
+                    score += termScore(doc, iterators[i].frequency(), weights[i]);
+                    iterators[i].next();
+                }
+            }
+            if (documents_[doc].live) {
+                offer(doc, score);
+            }
+        }
+    }
+    
+    std::vector<FullTextHit> hits(best.size());
+    for (size_t i = hits.size(); i > 0; --i) {
+        hits[i - 1] = {documents_[best.top().doc].key, best.top().score};
+        best.pop();
+    }
+    return hits;
+}
+
+void FullTextIndex::compact() {
+    // Live documents keep their order under new, dense numbers
+    const uint32_t GONE = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> newDoc(documents_.size(), GONE);
+    std::vector<Document> documents;
+    documents.reserve(docNumbers_.size());
+    for (size_t doc = 0; doc < documents_.size(); ++doc) {
+        if (documents_[doc].live) {
+            newDoc[doc] = static_cast<uint32_t>(documents.size());
+            documents.push_back(std::move(documents_[doc]));
+        }
+    }
+    
+    // Terms left with no live document are dropped
+    std::vector<uint32_t> newTerm(lists_.size(), GONE);
+    std::vector<PostingList> lists;
+    for (size_t term = 0; term < lists_.size(); ++term) {
+        if (lists_[term].documentFrequency == 0) {
+            continue;
+        }
+        newTerm[term] = static_cast<uint32_t>(lists.size());
+        lists.emplace_back();
+        PostingList& list = lists.back();
+        list.documentFrequency = lists_[term].documentFrequency;
+        for (PostingIterator it(lists_[term]); it.valid(); it.next()) {
+            if (newDoc[it.doc()] != GONE) {
+                append(list, newDoc[it.doc()], it.frequency());
+            }
+        }
+    }
+    
+    for (auto it = termIds_.begin(); it != termIds_.end();) {
+        if (newTerm[it->second] == GONE) {
+            it = termIds_.erase(it);
+        } else {
+            it->second = newTerm[it->second];
+            ++it;
+        }
+    }
+    docNumbers_.clear();
+    for (size_t doc = 0; doc < documents.size(); ++doc) {
+        for (uint32_t& term : documents[doc].terms) {
+            term = newTerm[term];
+        }
+        docNumbers_[documents[doc].key] = static_cast<uint32_t>(doc);
+    }
+    documents_ = std::move(documents);
+    lists_ = std::move(lists);
+    removedDocuments_ = 0;
+}
+
+size_t FullTextIndex::getDocumentCount() const {
+    return docNumbers_.size();
+}
+
+size_t FullTextIndex::getTermCount() const {
+    return termIds_.size();
+}
+
+size_t FullTextIndex::getDocumentFrequency(const std::string& term) const {
+    std::vector<std::string> terms = tokenize(term);
+    if (terms.size() != 1) {
+        return 0;
+    }
+    auto it = termIds_.find(terms[0]);
+    return it == termIds_.end() ? 0 : lists_[it->second].documentFrequency;
+}
+
+size_t FullTextIndex::getMemoryUsage() const {
+    size_t bytes = lists_.capacity() * sizeof(PostingList) + documents_.capacity() * sizeof(Document);
+    for (const auto& list : lists_) {
+        bytes += list.bytes.capacity() + list.skips.capacity() * sizeof(SkipEntry);
+    }
+    for (const auto& document : documents_) {
+        bytes += document.key.capacity() + document.terms.capacity() * sizeof(uint32_t);
+    }
+    for (const auto& entry : termIds_) {
+        bytes += sizeof(entry) + entry.first.capacity();
+    }
+    return bytes + docNumbers_.size() * sizeof(std::pair<const std::string, uint32_t>);
+}
+
+} // namespace storage
+} // namespace phantomdb
@@ -0,0 +1,120 @@
+#ifndef PHANTOMDB_FULLTEXT_INDEX_H
+#define PHANTOMDB_FULLTEXT_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+namespace phantomdb {
+namespace storage {
+
+// A document matching a full-text query, with its BM25 score
+struct FullTextHit {
+    std::string key;
+    double score;
+};
+
+/**
+ * Inverted index over text documents, ranked with BM25.
+ * 
+ * Text is split into lowercase terms on anything that is not a letter or
+ * digit (bytes of UTF-8 sequences count as letters). Each term has a
+ * posting list of (document, term frequency) pairs in document order,
+ * delta and varint encoded in blocks of BLOCK_SIZE postings. A skip entry
+ * per block records its last document and byte offset, so intersecting
+ * terms jumps over whole blocks that cannot contain the next candidate.
+ * 
+ * Documents are numbered in insertion order, so new postings are always
+ * appended. Removing or replacing a document takes it out of the scoring
+ * statistics at once and leaves its postings to be skipped until
+ * compact() rewrites the lists, which happens on its own once removed
+ * documents outnumber live ones.
+ */
+class FullTextIndex {
+public:
+    static const size_t BLOCK_SIZE = 128;
+    
+    // BM25 parameters: term frequency saturation and length normalization
+    static constexpr double K1 = 1.2;
+    static constexpr double B = 0.75;
+    
+    FullTextIndex();
+    ~FullTextIndex();
+    
+    // Index a document under key, replacing any earlier text for key
+    void insert(const std::string& key, const std::string& text);
+    
+    // Remove a document; false if key is not indexed
+    bool remove(const std::string& key);
+    
+    /**
+     * @brief Rank documents for a query with BM25
+     * 
+     * @param query Free text, tokenized like documents
+     * @param limit Return at most this many hits (0 for all)
+     * @param matchAll Only documents containing every query term (AND);
+     *        otherwise documents containing any of them (OR)
+     * @return Hits, best score first
+     */
+    std::vector<FullTextHit> search(const std::string& query, size_t limit = 10, bool matchAll = true) const;
+    
+    // Rewrite posting lists without removed documents
+    void compact();
+    
+    // Live documents
+    size_t getDocumentCount() const;
+    
+    // Distinct terms, including ones only removed documents contained
+    size_t getTermCount() const;
+    
+    // Live documents containing term (which is tokenized first)
+    size_t getDocumentFrequency(const std::string& term) const;
+    
+    size_t getMemoryUsage() const;
+    
+    // Lowercase terms of text, in order, repeats included
+    static std::vector<std::string> tokenize(const std::string& text);
+
+private:
+    struct SkipEntry {
+        uint32_t lastDoc;   // Last document of the block
+        uint32_t baseDoc;   // Document the block's first delta is taken from
+        uint32_t offset;    // Where the block starts in bytes
+    };
+    
+    struct PostingList {
+        std::vector<uint8_t> bytes;     // Per posting: varint doc delta, varint frequency
+        std::vector<SkipEntry> skips;
+        uint32_t count = 0;             // Postings, removed documents included
+        uint32_t documentFrequency = 0; // Live documents only
+    };
+    
+    struct Document {
+        std::string key;
+        uint32_t length = 0;            // Terms, repeats included
+        std::vector<uint32_t> terms;    // Distinct term ids
+        bool live = true;
+    };
+    
+    class PostingIterator;
+    
+    // Add a posting after every existing one (doc is the largest yet)
+    static void append(PostingList& list, uint32_t doc, uint32_t frequency);
+    
+    // Inverse document frequency of a term, the BM25 weight of one match
+    double idf(const PostingList& list) const;
+    
+    std::unordered_map<std::string, uint32_t> termIds_;
+    std::vector<PostingList> lists_;
+    std::vector<Document> documents_;                       // By document number
+    std::unordered_map<std::string, uint32_t> docNumbers_;  // Live documents only
+    uint64_t totalLength_;                                  // Terms in live documents
+    size_t removedDocuments_;                               // Not live, until compact()
+};
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_FULLTEXT_INDEX_H
@@ -0,0 +1,204 @@
+#include "fulltext_index.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <set>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace phantomdb::storage;
+
+void testTokenize() {
+    std::cout << "Testing tokenizer..." << std::endl;
+    
+    auto terms = FullTextIndex::tokenize("Red wool-blend Sweater, size XL (2024)!");
+    assert((terms == std::vector<std::string>{"red", "wool", "blend", "sweater", "size", "xl", "2024"}));
+    assert(FullTextIndex::tokenize("  ...  ").empty());
+    assert((FullTextIndex::tokenize("café crème") == std::vector<std::string>{"café", "crème"}));
+    
+    std::cout << "Tokenizer test passed!" << std::endl;
+}
+
+void testRanking() {
+    std::cout << "Testing BM25 ranking..." << std::endl;
+    
+    FullTextIndex index;
+    index.insert("1", "Wireless mouse with USB receiver");
+    index.insert("2", "Wireless keyboard and wireless mouse combo, wireless range 10m");
+    index.insert("3", "Wired mouse");
+    index.insert("4", "USB cable");
+    assert(index.getDocumentCount() == 4);
+    assert(index.getDocumentFrequency("Mouse") == 3);
+    
+    // AND: only documents with both terms; more occurrences rank higher
+    auto hits = index.search("wireless mouse", 10, true);
+    assert(hits.size() == 2);
+    assert(hits[0].key == "2" && hits[1].key == "1");
+    assert(hits[0].score > hits[1].score);
+    
+    // OR: any term; the short document about mice beats the long one about cables
+    hits = index.search("mouse usb", 10, false);
+    assert(hits.size() == 4);
+    assert(hits[0].key == "1");
+    hits = index.search("mouse", 10, false);
+    assert(hits[0].key == "3");
+    
+    assert(index.search("mouse trackball", 10, true).empty());
+    assert(index.search("mouse trackball", 10, false).size() == 3);
+    assert(index.search("", 10, false).empty());
+    assert(index.search("mouse", 1, false).size() == 1);
+    
+    // Replacing and removing documents updates results and statistics at once
+    index.insert("3", "Wired keyboard");
+    assert(index.getDocumentFrequency("mouse") == 2);
+    assert(index.search("wired keyboard", 10, true)[0].key == "3");
+    assert(index.remove("2"));
+    assert(!index.remove("2"));
+    assert(index.search("wireless", 10, false).size() == 1);
+    assert(index.getDocumentCount() == 3);
+    
+    std::cout << "Ranking test passed!" << std::endl;
+}
+
+// Corpus statistics BM25 needs, computed directly from the documents
+struct Corpus {
+    double documents = 0;
+    double averageLength = 0;
+    std::map<std::string, double> documentFrequencies;
+    
+    explicit Corpus(const std::map<std::string, std::vector<std::string>>& texts) {
+        double totalLength = 0;
+        for (const auto& entry : texts) {
+            totalLength += entry.second.size();
+            for (const auto& token : std::set<std::string>(entry.second.begin(), entry.second.end())) {
+                documentFrequencies[token]++;
+            }
+        }
+        documents = static_cast<double>(texts.size());
+        averageLength = totalLength / texts.size();
+    }
+};
+
+// BM25 of one document, for comparison with the index
+double bruteForceScore(const Corpus& corpus, const std::vector<std::string>& document, const std::set<std::string>& terms) {
+    double score = 0.0;
+    for (const auto& term : terms) {
+        double frequency = 0;
+        for (const auto& token : document) {
+            frequency += token == term ? 1 : 0;
+        }
+        if (frequency == 0) {
+            continue;
+        }
+        double documentFrequency = corpus.documentFrequencies.at(term);
+        double idf = std::log(1.0 + (corpus.documents - documentFrequency + 0.5) / (documentFrequency + 0.5));
+        double norm = FullTextIndex::K1 * (1.0 - FullTextIndex::B + FullTextIndex::B * document.size() / corpus.averageLength);
+        score += idf * frequency * (FullTextIndex::K1 + 1.0) / (frequency + norm);
+    }
+    return score;
+}
+
+void testAgainstBruteForce() {
+    std::cout << "Testing searches against a brute-force scan..." << std::endl;
+    
+    // Skewed vocabulary: common terms span many posting blocks, rare ones few
+    std::mt19937 rng(17);
+    std::vector<std::string> vocabulary;
+    for (int i = 0; i < 300; ++i) {
+        vocabulary.push_back("w" + std::to_string(i));
+    }
+    auto randomWord = [&rng, &vocabulary]() {
+        size_t rank = static_cast<size_t>(std::pow(static_cast<double>(rng() % 10000) / 10000.0, 3) * vocabulary.size());
+        return vocabulary[rank];
+    };
+    
+    FullTextIndex index;
+    std::map<std::string, std::vector<std::string>> documents;
+    for (int round = 0; round < 6000; ++round) {
+        std::string key = std::to_string(rng() % 3000);
+        if (rng() % 5 == 0) {
+            assert(index.remove(key) == (documents.erase(key) == 1));
+            continue;
+        }
+        std::string text;
+        std::vector<std::string> tokens;
+        size_t length = 1 + rng() % 20;
+        for (size_t i = 0; i < length; ++i) {
+            tokens.push_back(randomWord());
+            text += tokens.back() + (i % 3 == 0 ? ", " : " ");
+        }
+        index.insert(key, text);
+        documents[key] = tokens;
+    }
+    assert(index.getDocumentCount() == documents.size());
+    Corpus corpus(documents);
+    
+    for (int query = 0; query < 200; ++query) {
+        std::set<std::string> terms;
+        size_t termCount = 1 + rng() % 3;
+        while (terms.size() < termCount) {
+            terms.insert(randomWord());
+        }
+        std::string text;
+        for (const auto& term : terms) {
+            text += term + " ";
+        }
+        bool matchAll = query % 2 == 0;
+        
+        std::map<std::string, double> expected;
+        for (const auto& entry : documents) {
+            size_t matched = 0;
+            for (const auto& term : terms) {
+                for (const auto& token : entry.second) {
+                    if (token == term) {
+                        matched++;
+                        break;
+                    }
+                }
+            }
+            if (matched == terms.size() || (!matchAll && matched > 0)) {
+                expected[entry.first] = bruteForceScore(corpus, entry.second, terms);
+            }
+        }
+        
+        auto hits = index.search(text, 0, matchAll);
+        assert(hits.size() == expected.size());
+        for (size_t i = 0; i < hits.size(); ++i) {
+            assert(std::fabs(hits[i].score - expected.at(hits[i].key)) < 1e-9);
+            assert(i == 0 || hits[i - 1].score >= hits[i].score);
+        }
+        
+        // The top hits are the best of the full list
+        auto top = index.search(text, 5, matchAll);
+        assert(top.size() == std::min<size_t>(5, hits.size()));
+        for (size_t i = 0; i < top.size(); ++i) {
+            assert(std::fabs(top[i].score - hits[i].score) < 1e-9);
+        }
+    }
+    
+    // Compaction keeps every result
+    auto before = index.search("w0 w1", 0, false);
+    size_t memoryBefore = index.getMemoryUsage();
+    index.compact();
+    auto after = index.search("w0 w1", 0, false);
+    assert(before.size() == after.size());
+    for (size_t i = 0; i < before.size(); ++i) {
+        assert(std::fabs(before[i].score - after[i].score) < 1e-9);
+    }
+    assert(index.getMemoryUsage() <= memoryBefore);
+    
+    std::cout << "Brute-force comparison test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running full-text index tests..." << std::endl;
+    
+    testTokenize();
+    testRanking();
+    testAgainstBruteForce();
+    
+    std::cout << "All full-text index tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,438 @@
+#include "index_file.h"
+#include "utils.h"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+
+namespace phantomdb {
+namespace storage {
+
+namespace {
+
+using core::utils::putVarint;
+using core::utils::getVarint;
+using core::utils::putFixed32;
+using core::utils::putFixed64;
+using core::utils::getFixed;
+
+const char HEADER_MAGIC[8] = {'P', 'H', 'D', 'B', 'I', 'D', 'X', '\0'};
+const uint32_t FORMAT_VERSION = 1;
+const size_t HEADER_SIZE = 60;  // Through the header checksum
+
+// Largest varint prefix of an entry: shared, unshared and value lengths
+const size_t MAX_ENTRY_OVERHEAD = 30;
+
+void putString(std::string& out, std::string_view value) {
+    putVarint(out, value.size());
+    out.append(value.data(), value.size());
+}
+
+bool getString(const unsigned char*& pos, const unsigned char* end, std::string_view& value) {
+    uint64_t length;
+    if (!getVarint(pos, end, length) || length > static_cast<uint64_t>(end - pos)) {
+        return false;
+    }
+    value = std::string_view(reinterpret_cast<const char*>(pos), static_cast<size_t>(length));
+    pos += length;
+    return true;
+}
+
+// Bytes up to the next page boundary
+size_t paddingFor(uint64_t offset) {
+    size_t remainder = static_cast<size_t>(offset % IndexFileWriter::PAGE_SIZE);
+    return remainder == 0 ? 0 : IndexFileWriter::PAGE_SIZE - remainder;
+}
+
+} // anonymous namespace
+
+IndexFileWriter::IndexFileWriter()
+    : file_(nullptr), kind_(IndexFileKind::B_TREE), tableLsn_(0), pageCount_(0), offset_(0), entryCount_(0),
+      ok_(false) {}
+
+IndexFileWriter::~IndexFileWriter() {
+    abort();
+}
+
+bool IndexFileWriter::open(const std::string& path, IndexFileKind kind, uint64_t tableLsn) {
+    abort();
+    path_ = path;
+    tempPath_ = path + ".tmp";
+    kind_ = kind;
+    tableLsn_ = tableLsn;
+    page_.reset();
+    pageFirstKey_.clear();
+    lastKey_.clear();
+    directory_.clear();
+    pageCount_ = 0;
+    entryCount_ = 0;
+
+    file_ = std::fopen(tempPath_.c_str(), "wb");
+    if (file_ == nullptr) {
+        std::cerr << "Failed to create index file: " << tempPath_ << std::endl;
+        return false;
+    }
+
+    // The header page is written last, once the directory's place is known
+    std::string header(PAGE_SIZE, '\0');
+    ok_ = std::fwrite(header.data(), 1, header.size(), file_) == header.size();
+    offset_ = PAGE_SIZE;
+    return ok_;
+}
+
+bool IndexFileWriter::add(std::string_view key, std::string_view value) {
+    if (file_ == nullptr || !ok_) {
+        return false;
+    }
+    if (entryCount_ > 0 && key <= std::string_view(lastKey_)) {
+        std::cerr << "Index file keys out of order: " << path_ << std::endl;
+        ok_ = false;
+        return false;
+    }
+
+    // Start a new page unless the entry surely fits in this one
+    if (!page_.empty() &&
+        page_.getSizeEstimate() + key.size() + value.size() + MAX_ENTRY_OVERHEAD + 4 > PAGE_SIZE &&
+        !flushPage()) {
+        return false;
+    }
+    if (page_.empty()) {
+        // Past the first page, the directory only needs a key that tells
+        // this page from the one before
+        pageFirstKey_ = entryCount_ == 0 ? std::string(key) : shortestSeparator(lastKey_, key);
+    }
+    page_.add(key, value);
+    lastKey_.assign(key.data(), key.size());
+    entryCount_++;
+    return true;
+}
+
+bool IndexFileWriter::flushPage() {
+    if (page_.empty()) {
+        return true;
+    }
+    std::string block = page_.finish();
+    putString(directory_, pageFirstKey_);
+    putFixed64(directory_, offset_);
+    putFixed32(directory_, static_cast<uint32_t>(block.size()));
+    putFixed32(directory_, core::utils::crc32(block.data(), block.size()));
+    pageCount_++;
+
+    block.append(paddingFor(block.size()), '\0');
+    ok_ = ok_ && std::fwrite(block.data(), 1, block.size(), file_) == block.size();
+    offset_ += block.size();
+    return ok_;
+}
+
+bool IndexFileWriter::finish() {
+    if (file_ == nullptr) {
+        return false;
+    }
+    flushPage();
+
+    std::string directory;
+    putVarint(directory, pageCount_);
+    directory.append(directory_);
+
+    std::string header(HEADER_MAGIC, sizeof(HEADER_MAGIC));
+    putFixed32(header, FORMAT_VERSION);
+    putFixed32(header, static_cast<uint32_t>(PAGE_SIZE));
+    putFixed32(header, static_cast<uint32_t>(kind_));
+    putFixed32(header, 0);
+    putFixed64(header, tableLsn_);
+    putFixed64(header, entryCount_);
+    putFixed64(header, offset_);
+    putFixed32(header, static_cast<uint32_t>(directory.size()));
+    putFixed32(header, core::utils::crc32(directory.data(), directory.size()));
+    putFixed32(header, core::utils::crc32(header.data(), header.size()));
+
+    bool ok = ok_;
+    ok = ok && std::fwrite(directory.data(), 1, directory.size(), file_) == directory.size();
+    ok = ok && std::fseek(file_, 0, SEEK_SET) == 0;
+    ok = ok && std::fwrite(header.data(), 1, header.size(), file_) == header.size();
+    ok = ok && std::fflush(file_) == 0 && core::utils::syncFile(file_);
+    ok = (std::fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    ok_ = false;
+
+    std::error_code ec;
+    if (!ok) {
+        std::cerr << "Failed to write index file: " << tempPath_ << std::endl;
+        std::filesystem::remove(tempPath_, ec);
+        return false;
+    }
+    std::filesystem::rename(tempPath_, path_, ec);
+    if (ec) {
+        std::cerr << "Failed to move index file into place: " << path_ << " (" << ec.message() << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void IndexFileWriter::abort() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+        std::error_code ec;
+        std::filesystem::remove(tempPath_, ec);
+    }
+    ok_ = false;
+}
+
+uint64_t IndexFileWriter::getEntryCount() const {
+    return entryCount_;
+}
+
+IndexFileReader::IndexFileReader() : kind_(IndexFileKind::B_TREE), tableLsn_(0), entryCount_(0) {}
+
+IndexFileReader::~IndexFileReader() {
+    close();
+}
+
+bool IndexFileReader::open(const std::string& path) {
+    close();
+    path_ = path;
+    if (!file_.open(path)) {
+        return false;
+    }
+    if (!readHeader()) {
+        std::cerr << "Not a valid index file: " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void IndexFileReader::close() {
+    file_.close();
+    pages_.clear();
+    verified_.reset();
+    kind_ = IndexFileKind::B_TREE;
+    tableLsn_ = 0;
+    entryCount_ = 0;
+}
+
+bool IndexFileReader::isOpen() const {
+    return file_.isOpen();
+}
+
+bool IndexFileReader::readHeader() {
+    const unsigned char* data = file_.data();
+    size_t size = file_.size();
+    if (size < IndexFileWriter::PAGE_SIZE ||
+        std::memcmp(data, HEADER_MAGIC, sizeof(HEADER_MAGIC)) != 0 ||
+        getFixed(data + HEADER_SIZE - 4, 4) != core::utils::crc32(data, HEADER_SIZE - 4) ||
+        getFixed(data + 8, 4) != FORMAT_VERSION ||
+        getFixed(data + 12, 4) != IndexFileWriter::PAGE_SIZE) {
+        return false;
+    }
+    uint64_t kind = getFixed(data + 16, 4);
+    if (kind != static_cast<uint64_t>(IndexFileKind::B_TREE) && kind != static_cast<uint64_t>(IndexFileKind::HASH)) {
+        return false;
+    }
+    kind_ = static_cast<IndexFileKind>(kind);
+    tableLsn_ = getFixed(data + 24, 8);
+    entryCount_ = getFixed(data + 32, 8);
+    uint64_t directoryOffset = getFixed(data + 40, 8);
+    uint64_t directoryLength = getFixed(data + 48, 4);
+    if (directoryOffset < IndexFileWriter::PAGE_SIZE || directoryOffset > size ||
+        directoryLength > size - directoryOffset ||
+        core::utils::crc32(data + directoryOffset, directoryLength) != getFixed(data + 52, 4)) {
+        return false;
+    }
+
+    const unsigned char* pos = data + directoryOffset;
+    const unsigned char* end = pos + directoryLength;
+    uint64_t count;
+    if (!getVarint(pos, end, count) || count > directoryLength) {
+        return false;
+    }
+    pages_.resize(static_cast<size_t>(count));
+    for (auto& page : pages_) {
+        if (!getString(pos, end, page.firstKey) || end - pos < 16) {
+            return false;
+        }
+        page.offset = getFixed(pos, 8);
+        page.length = static_cast<uint32_t>(getFixed(pos + 8, 4));
+        page.checksum = static_cast<uint32_t>(getFixed(pos + 12, 4));
+        pos += 16;
+        if (page.offset < IndexFileWriter::PAGE_SIZE || page.offset > directoryOffset ||
+            page.length > directoryOffset - page.offset) {
+            return false;
+        }
+    }
+
+    verified_.reset(new std::atomic<bool>[pages_.size()]);
+    for (size_t i = 0; i < pages_.size(); ++i) {
+        verified_[i].store(false, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool IndexFileReader::loadPage(size_t index, FrontCodedBlockIterator& entries) const {
+    const Page& page = pages_[index];
+    const unsigned char* start = file_.data() + page.offset;
+    if (!verified_[index].load(std::memory_order_acquire)) {
+        if (core::utils::crc32(start, page.length) != page.checksum) {
+            std::cerr << "Corrupt page " << index << " in index file: " << path_ << std::endl;
+            return false;
+        }
+        verified_[index].store(true, std::memory_order_release);
+    }
+    return entries.init(start, page.length);
+}
+
+bool IndexFileReader::get(std::string_view key, std::string& value) const {
+    // The last page whose first key is <= key is the only one that can hold it
+    if (pages_.empty() || key < pages_.front().firstKey) {
+        return false;
+    }
+    FrontCodedBlockIterator entries;
+    if (!loadPage(findPage(key), entries)) {
+        return false;
+    }
+    entries.seek(key);
+    if (!entries.valid() || entries.key() != key) {
+        return false;
+    }
+    value.assign(entries.value().data(), entries.value().size());
+    return true;
+}
+
+IndexFileKind IndexFileReader::getKind() const {
+    return kind_;
+}
+
+uint64_t IndexFileReader::getTableLsn() const {
+    return tableLsn_;
+}
+
+uint64_t IndexFileReader::getEntryCount() const {
+    return entryCount_;
+}
+
+size_t IndexFileReader::getPageCount() const {
+    return pages_.size();
+}
+
+uint64_t IndexFileReader::getFileSize() const {
+    return file_.size();
+}
+
+size_t IndexFileReader::getMemoryUsage() const {
+    return sizeof(*this) + pages_.capacity() * sizeof(Page) + pages_.size() * sizeof(std::atomic<bool>);
+}
+
+size_t IndexFileReader::findPage(std::string_view key) const {
+    auto it = std::upper_bound(pages_.begin(), pages_.end(), key,
+                               [](std::string_view target, const Page& page) { return target < page.firstKey; });
+    return it == pages_.begin() ? 0 : static_cast<size_t>(it - pages_.begin()) - 1;
+}
+
+IndexFileReader::Cursor IndexFileReader::seek(const std::string& key, bool upper) const {
+    Cursor cursor(this);
+    if (pages_.empty()) {
+        return cursor;
+    }
+    cursor.page_ = findPage(key);
+    if (!loadPage(cursor.page_, cursor.entries_)) {
+        return cursor;
+    }
+    cursor.entries_.seek(key);
+    if (upper && cursor.entries_.valid() && cursor.entries_.key() == key) {
+        cursor.entries_.next();
+    }
+    if (!cursor.entries_.valid() && cursor.entries_.ok()) {
+        cursor.enterPage(cursor.page_ + 1, false);
+    }
+    cursor.settle();
+    return cursor;
+}
+
+IndexFileReader::Cursor IndexFileReader::first() const {
+    Cursor cursor(this);
+    cursor.enterPage(0, false);
+    cursor.settle();
+    cursor.pastEnd_ = false;
+    return cursor;
+}
+
+IndexFileReader::Cursor IndexFileReader::last() const {
+    Cursor cursor(this);
+    if (!pages_.empty()) {
+        cursor.enterPage(pages_.size() - 1, true);
+    }
+    cursor.settle();
+    cursor.pastEnd_ = false;
+    return cursor;
+}
+
+IndexFileReader::Cursor IndexFileReader::lowerBound(const std::string& key) const {
+    return seek(key, false);
+}
+
+IndexFileReader::Cursor IndexFileReader::upperBound(const std::string& key) const {
+    return seek(key, true);
+}
+
+bool IndexFileReader::Cursor::enterPage(size_t index, bool atEnd) {
+    if (index >= reader_->pages_.size()) {
+        pastEnd_ = true;
+        return false;
+    }
+    page_ = index;
+    if (!reader_->loadPage(index, entries_)) {
+        return false;
+    }
+    if (atEnd) {
+        entries_.seekToLast();
+    } else {
+        entries_.seekToFirst();
+    }
+    return true;
+}
+
+void IndexFileReader::Cursor::settle() {
+    valid_ = entries_.valid() && !pastEnd_;
+    if (valid_) {
+        key_.assign(entries_.key().data(), entries_.key().size());
+        value_.assign(entries_.value().data(), entries_.value().size());
+    }
+}
+
+void IndexFileReader::Cursor::next() {
+    if (!valid_) {
+        return;
+    }
+    entries_.next();
+    if (!entries_.valid() && entries_.ok()) {
+        enterPage(page_ + 1, false);
+    }
+    settle();
+}
+
+void IndexFileReader::Cursor::prev() {
+    if (reader_ == nullptr) {
+        return;
+    }
+    if (!valid_) {
+        if (pastEnd_) {
+            *this = reader_->last();
+        }
+        return;
+    }
+    
+    // Block iterators only move forward: seek to the last key before this one
+    entries_.seekBefore(key_);
+    if (!entries_.valid() && entries_.ok()) {
+        if (page_ == 0) {
+            valid_ = false;
+            return;
+        }
+        enterPage(page_ - 1, true);
+    }
+    settle();
+}
+
+} // namespace storage
+} // namespace phantomdb
@@ -0,0 +1,286 @@
+#ifndef PHANTOMDB_INDEX_FILE_H
+#define PHANTOMDB_INDEX_FILE_H
+
+#include "front_coding.h"
+#include "mapped_file.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <limits>
+#include <cstdint>
+#include <cstdio>
+
+namespace phantomdb {
+namespace storage {
+
+// The index structure an index file was written from
+enum class IndexFileKind : uint32_t {
+    B_TREE = 1,
+    HASH = 2
+};
+
+/**
+ * Persistent index file layout (all integers little-endian), in pages of
+ * PAGE_SIZE bytes:
+ *
+ *   page 0       header: "PHDBIDX\0" | u32 version | u32 page size |
+ *                u32 kind | u32 reserved | u64 table lsn | u64 entry count |
+ *                u64 directory offset | u32 directory length |
+ *                u32 directory crc32 | u32 crc32 of the header bytes before it,
+ *                zero-padded to a page
+ *   data pages   one FrontCodedBlockBuilder block per page, entries in key
+ *                order, zero-padded to a page; an entry too large for one
+ *                page gets a run of pages to itself
+ *   directory    varint page count | per page: string first key |
+ *                u64 offset | u32 length | u32 crc32
+ *
+ * The file is a two-level B+tree: the directory is the root, read whole
+ * when the file is opened, and the pages are its leaves, so a lookup is a
+ * binary search of the directory and a seek within one page. Hash indexes
+ * are written in key order as well, so one reader serves both kinds.
+ *
+ * The header records the table lsn the index was flushed at. An index is
+ * only current if its table has not logged anything since, so loaders
+ * compare it with the table's last lsn before trusting the file.
+ */
+class IndexFileWriter {
+public:
+    static const size_t PAGE_SIZE = 4096;
+
+    IndexFileWriter();
+    ~IndexFileWriter();
+
+    IndexFileWriter(const IndexFileWriter&) = delete;
+    IndexFileWriter& operator=(const IndexFileWriter&) = delete;
+
+    /**
+     * @brief Start a file; nothing is visible at the path until finish()
+     *
+     * @param path The destination file
+     * @param kind The index structure being written
+     * @param tableLsn Last lsn of the indexed table the entries reflect
+     * @return true if successful, false otherwise
+     */
+    bool open(const std::string& path, IndexFileKind kind, uint64_t tableLsn);
+
+    /**
+     * @brief Append an entry; keys must be strictly increasing
+     *
+     * @return true if successful, false otherwise
+     */
+    bool add(std::string_view key, std::string_view value);
+
+    /**
+     * @brief Write the directory and header, fsync and rename into place
+     *
+     * @return true if successful, false otherwise
+     */
+    bool finish();
+
+    /**
+     * @brief Discard an unfinished file (also done by the destructor)
+     */
+    void abort();
+
+    uint64_t getEntryCount() const;
+
+private:
+    bool flushPage();
+
+    std::FILE* file_;
+    std::string path_;
+    std::string tempPath_;
+    IndexFileKind kind_;
+    uint64_t tableLsn_;
+    FrontCodedBlockBuilder page_;
+    std::string pageFirstKey_;
+    std::string lastKey_;
+    std::string directory_;
+    uint64_t pageCount_;
+    uint64_t offset_;
+    uint64_t entryCount_;
+    bool ok_;
+};
+
+/**
+ * Read-only view of an index file. open() maps the file and checks the
+ * header and directory, which is all the reading startup does; pages are
+ * checksummed the first time they are read. Safe for concurrent readers.
+ *
+ * Lookups, scans and cursors follow BPlusTree's interface, so a loaded
+ * index can serve reads straight from the mapping.
+ */
+class IndexFileReader {
+public:
+    /**
+     * Position among the entries in key order. The key and value are
+     * copies owned by the cursor; a corrupt page ends the iteration.
+     */
+    class Cursor {
+    public:
+        Cursor() : reader_(nullptr), page_(0), valid_(false), pastEnd_(false) {}
+
+        // On an entry; key() and value() may only be called then
+        bool valid() const { return valid_; }
+
+        const std::string& key() const { return key_; }
+        const std::string& value() const { return value_; }
+
+        // Move to the next larger key; invalid after the last one
+        void next();
+
+        // Move to the next smaller key; invalid before the first one. A
+        // cursor past the last entry moves onto it
+        void prev();
+
+    private:
+        friend class IndexFileReader;
+
+        explicit Cursor(const IndexFileReader* reader) : reader_(reader), page_(0), valid_(false), pastEnd_(false) {}
+
+        // Move to the first entry of page index (false past the last page)
+        bool enterPage(size_t index, bool atEnd);
+
+        // Take the entry entries_ is on, or become invalid
+        void settle();
+
+        const IndexFileReader* reader_;
+        size_t page_;
+        FrontCodedBlockIterator entries_;
+        std::string key_;
+        std::string value_;
+        bool valid_;
+        bool pastEnd_;
+    };
+
+    IndexFileReader();
+    ~IndexFileReader();
+
+    IndexFileReader(const IndexFileReader&) = delete;
+    IndexFileReader& operator=(const IndexFileReader&) = delete;
+
+    /**
+     * @brief Map a file and validate its header and directory
+     *
+     * @return false if the file is missing, truncated or corrupt
+     */
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen() const;
+
+    /**
+     * @brief Look up a key
+     *
+     * @return false if the key is absent or its page is corrupt
+     */
+    bool get(std::string_view key, std::string& value) const;
+
+    bool search(const std::string& key, std::string& value) const { return get(key, value); }
+
+    // Cursors on the smallest and largest keys (invalid when empty)
+    Cursor first() const;
+    Cursor last() const;
+
+    // Cursor on the first key >= key (lower) or > key (upper)
+    Cursor lowerBound(const std::string& key) const;
+    Cursor upperBound(const std::string& key) const;
+
+    /**
+     * @brief Call fn(key, value) for the keys in [low, high] in key order
+     *
+     * @param limit Stop after this many entries
+     * @return The number of entries visited
+     */
+    template<typename Fn>
+    size_t scan(const std::string& low, const std::string& high, Fn fn,
+                size_t limit = std::numeric_limits<size_t>::max()) const;
+
+    /**
+     * @brief Call fn(key, value) for every entry in key order; the views
+     *        are only valid during the call
+     *
+     * @return false if a page failed its checksum or did not decode
+     */
+    template<typename Fn>
+    bool forEach(Fn fn) const;
+
+    IndexFileKind getKind() const;
+    uint64_t getTableLsn() const;
+    uint64_t getEntryCount() const;
+    size_t getPageCount() const;
+    uint64_t getFileSize() const;
+
+    size_t getSize() const { return static_cast<size_t>(entryCount_); }
+
+    // Heap used by the directory; the pages stay in the page cache
+    size_t getMemoryUsage() const;
+
+private:
+    struct Page {
+        std::string_view firstKey;
+        uint64_t offset;
+        uint32_t length;
+        uint32_t checksum;
+    };
+
+    bool readHeader();
+
+    // Page that can hold key: the last whose first key is <= key (or 0)
+    size_t findPage(std::string_view key) const;
+
+    Cursor seek(const std::string& key, bool upper) const;
+
+    // Attach entries to page index; false if its checksum does not match
+    bool loadPage(size_t index, FrontCodedBlockIterator& entries) const;
+
+    std::string path_;
+    MappedFile file_;
+    IndexFileKind kind_;
+    uint64_t tableLsn_;
+    uint64_t entryCount_;
+    std::vector<Page> pages_;
+
+    // Set once a page's checksum has been verified
+    std::unique_ptr<std::atomic<bool>[]> verified_;
+};
+
+// Implementation
+template<typename Fn>
+bool IndexFileReader::forEach(Fn fn) const {
+    FrontCodedBlockIterator entries;
+    for (size_t i = 0; i < pages_.size(); ++i) {
+        if (!loadPage(i, entries)) {
+            return false;
+        }
+        for (entries.seekToFirst(); entries.valid(); entries.next()) {
+            fn(entries.key(), entries.value());
+        }
+        if (!entries.ok()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Fn>
+size_t IndexFileReader::scan(const std::string& low, const std::string& high, Fn fn, size_t limit) const {
+    size_t visited = 0;
+    if (high < low) {
+        return visited;
+    }
+    for (Cursor cursor = lowerBound(low); cursor.valid() && visited < limit && !(high < cursor.key());
+         cursor.next()) {
+        fn(cursor.key(), cursor.value());
+        visited++;
+    }
+    return visited;
+}
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_INDEX_FILE_H
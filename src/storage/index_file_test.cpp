@@ -0,0 +1,195 @@
+#include "index_file.h"
+#include "sstable.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <filesystem>
+
+using namespace phantomdb::storage;
+
+namespace {
+
+std::string orderKey(int i) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "orders/%08d", i);
+    return buffer;
+}
+
+// Flip one byte of a file in place
+void corruptByte(const std::string& path, std::streamoff offset) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(offset);
+    char byte = 0;
+    file.get(byte);
+    file.seekp(offset);
+    file.put(static_cast<char>(byte ^ 0x5A));
+}
+
+} // anonymous namespace
+
+void testRoundTrip(const std::string& directory) {
+    std::cout << "Testing index file round trip..." << std::endl;
+
+    std::string path = directory + "/orders.idx";
+    std::map<std::string, std::string> expected;
+    IndexFileWriter writer;
+    assert(writer.open(path, IndexFileKind::B_TREE, 42));
+    for (int i = 0; i < 20000; ++i) {
+        std::string value = "row-" + std::to_string(i * 3);
+        if (i % 5000 == 7) {
+            // Entries larger than a page get pages of their own
+            value = std::string(3 * IndexFileWriter::PAGE_SIZE, static_cast<char>('a' + i % 26));
+        }
+        assert(writer.add(orderKey(i), value));
+        expected[orderKey(i)] = value;
+    }
+    assert(!std::filesystem::exists(path));
+    assert(writer.finish());
+
+    IndexFileReader reader;
+    assert(reader.open(path));
+    assert(reader.getKind() == IndexFileKind::B_TREE);
+    assert(reader.getTableLsn() == 42);
+    assert(reader.getEntryCount() == expected.size());
+    assert(reader.getPageCount() > 1);
+
+    // Point lookups read one page each
+    std::string value;
+    for (int i = 0; i < 20000; i += 13) {
+        assert(reader.get(orderKey(i), value) && value == expected[orderKey(i)]);
+    }
+    assert(reader.get(orderKey(7), value) && value.size() == 3 * IndexFileWriter::PAGE_SIZE);
+    assert(!reader.get("orders/", value));
+    assert(!reader.get(orderKey(20000), value));
+    assert(!reader.get(orderKey(5) + "x", value));
+
+    // Every entry comes back in key order
+    auto it = expected.begin();
+    assert(reader.forEach([&it](std::string_view key, std::string_view entryValue) {
+        assert(key == it->first && entryValue == it->second);
+        ++it;
+    }));
+    assert(it == expected.end());
+
+    // Cursors cross page boundaries in both directions
+    auto forward = reader.first();
+    for (const auto& entry : expected) {
+        assert(forward.valid() && forward.key() == entry.first && forward.value() == entry.second);
+        forward.next();
+    }
+    assert(!forward.valid());
+    forward.prev();
+    assert(forward.valid() && forward.key() == orderKey(19999));
+    auto backward = reader.last();
+    for (auto rit = expected.rbegin(); rit != expected.rend(); ++rit) {
+        assert(backward.valid() && backward.key() == rit->first);
+        backward.prev();
+    }
+    assert(!backward.valid());
+    assert(reader.lowerBound(orderKey(5) + "x").key() == orderKey(6));
+    assert(reader.upperBound(orderKey(6)).key() == orderKey(7));
+    assert(reader.lowerBound("a").key() == orderKey(0));
+    assert(!reader.upperBound(orderKey(19999)).valid());
+
+    // Range scans stop at the high key or the limit
+    std::vector<std::string> scanned;
+    auto collect = [&scanned](const std::string& key, const std::string&) { scanned.push_back(key); };
+    assert(reader.scan(orderKey(4990), orderKey(5010), collect) == 21);
+    assert(scanned.front() == orderKey(4990) && scanned.back() == orderKey(5010));
+    assert(reader.scan(orderKey(100), orderKey(200), collect, 3) == 3);
+    assert(reader.scan(orderKey(9), orderKey(8), collect) == 0);
+    assert(reader.getSize() == expected.size());
+
+    // Keys must be added in order
+    IndexFileWriter unordered;
+    assert(unordered.open(directory + "/unordered.idx", IndexFileKind::HASH, 1));
+    assert(unordered.add("b", "1"));
+    assert(!unordered.add("a", "2"));
+    unordered.abort();
+    assert(!std::filesystem::exists(directory + "/unordered.idx"));
+
+    std::cout << "Round trip test passed!" << std::endl;
+}
+
+void testEmptyFile(const std::string& directory) {
+    std::cout << "Testing empty index file..." << std::endl;
+
+    std::string path = directory + "/empty.idx";
+    IndexFileWriter writer;
+    assert(writer.open(path, IndexFileKind::HASH, 0));
+    assert(writer.finish());
+
+    IndexFileReader reader;
+    assert(reader.open(path));
+    assert(reader.getKind() == IndexFileKind::HASH);
+    assert(reader.getEntryCount() == 0 && reader.getPageCount() == 0);
+    std::string value;
+    assert(!reader.get("anything", value));
+    size_t visited = 0;
+    assert(reader.forEach([&visited](std::string_view, std::string_view) { visited++; }));
+    assert(visited == 0);
+    assert(!reader.first().valid() && !reader.last().valid() && !reader.lowerBound("a").valid());
+
+    std::cout << "Empty index file test passed!" << std::endl;
+}
+
+void testCorruption(const std::string& directory) {
+    std::cout << "Testing corrupt index files..." << std::endl;
+
+    std::string path = directory + "/corrupt.idx";
+    auto write = [&path]() {
+        IndexFileWriter writer;
+        assert(writer.open(path, IndexFileKind::B_TREE, 9));
+        for (int i = 0; i < 2000; ++i) {
+            assert(writer.add(orderKey(i), std::to_string(i)));
+        }
+        assert(writer.finish());
+    };
+
+    // A damaged header or directory is caught when the file is opened
+    write();
+    corruptByte(path, 30);
+    IndexFileReader reader;
+    assert(!reader.open(path));
+    write();
+    corruptByte(path, static_cast<std::streamoff>(std::filesystem::file_size(path)) - 3);
+    assert(!reader.open(path));
+
+    // A damaged page is caught the first time it is read
+    write();
+    corruptByte(path, IndexFileWriter::PAGE_SIZE + 40);
+    assert(reader.open(path));
+    std::string value;
+    assert(!reader.get(orderKey(0), value));
+    assert(reader.get(orderKey(1999), value) && value == "1999");
+    assert(!reader.forEach([](std::string_view, std::string_view) {}));
+
+    // Truncated files and other files are not index files
+    write();
+    std::filesystem::resize_file(path, IndexFileWriter::PAGE_SIZE / 2);
+    assert(!reader.open(path));
+    std::ofstream(directory + "/text.idx") << "not an index file";
+    assert(!reader.open(directory + "/text.idx"));
+    assert(!reader.open(directory + "/missing.idx"));
+    assert(!reader.isOpen());
+
+    std::cout << "Corrupt index files test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running index file tests..." << std::endl;
+
+    std::string directory = createTemporaryTableDirectory("phantomdb_index_file_test_");
+    assert(!directory.empty());
+
+    testRoundTrip(directory);
+    testEmptyFile(directory);
+    testCorruption(directory);
+
+    std::filesystem::remove_all(directory);
+    std::cout << "All index file tests passed!" << std::endl;
+    return 0;
+}
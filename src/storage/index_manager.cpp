@@ -1,6 +1,6 @@
 #include "index_manager.h"
-#include "btree.h"
-#include "hash_table.h"
+#include "bplus_tree.h"
+#include "swiss_table.h"
 #include "lsm_tree.h"
 #include <iostream>
 #include <unordered_map>
@@ -29,7 +29,7 @@ public:
             case IndexType::B_TREE:
                 {
                     // Create a B-tree index
-                    auto btreeIndex = std::make_unique<BTree<int, std::string>>();
+                    auto btreeIndex = std::make_unique<BPlusTree<int, std::string>>();
                     btreeIndexes[indexName] = std::move(btreeIndex);
                     indexes[indexName] = {tableName, columnName, type};
                     std::cout << "Created B-tree index: " << indexName << std::endl;
@@ -38,7 +38,7 @@ public:
             case IndexType::HASH:
                 {
                     // Create a Hash table index
-                    auto hashIndex = std::make_unique<HashTable<int, std::string>>();
+                    auto hashIndex = std::make_unique<SwissTable<int, std::string>>();
                     hashIndexes[indexName] = std::move(hashIndex);
                     indexes[indexName] = {tableName, columnName, type};
                     std::cout << "Created Hash index: " << indexName << std::endl;
@@ -260,8 +260,8 @@ private:
     }
     
     std::unordered_map<std::string, IndexInfo> indexes;
-    std::unordered_map<std::string, std::unique_ptr<BTree<int, std::string>>> btreeIndexes;
-    std::unordered_map<std::string, std::unique_ptr<HashTable<int, std::string>>> hashIndexes;
+    std::unordered_map<std::string, std::unique_ptr<BPlusTree<int, std::string>>> btreeIndexes;
+    std::unordered_map<std::string, std::unique_ptr<SwissTable<int, std::string>>> hashIndexes;
     std::unordered_map<std::string, std::unique_ptr<LSMTREE<int, std::string>>> lsmTreeIndexes;
     
     // Auto-indexing configuration
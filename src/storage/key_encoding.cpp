@@ -0,0 +1,203 @@
+#include "key_encoding.h"
+#include "utils.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace phantomdb {
+namespace storage {
+
+namespace {
+
+using core::utils::putVarint;
+using core::utils::getVarint;
+
+const uint64_t SIGN_BIT = 0x8000000000000000ULL;
+
+void putBigEndian(std::string& out, uint64_t value) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+uint64_t getBigEndian(const unsigned char* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+bool parseInt64(std::string_view text, int64_t& value) {
+    std::string digits(text);
+    if (digits.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    long long parsed = std::strtoll(digits.c_str(), &end, 10);
+    if (errno != 0 || end != digits.c_str() + digits.size()) {
+        return false;
+    }
+    value = static_cast<int64_t>(parsed);
+    return true;
+}
+
+bool parseDouble(std::string_view text, double& value) {
+    std::string digits(text);
+    if (digits.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtod(digits.c_str(), &end);
+    return errno != ERANGE && end == digits.c_str() + digits.size() && !std::isnan(value);
+}
+
+} // anonymous namespace
+
+bool appendKeyColumn(std::string& out, KeyColumnType type, std::string_view value) {
+    switch (type) {
+        case KeyColumnType::STRING:
+            for (char c : value) {
+                out.push_back(c);
+                if (c == '\0') {
+                    out.push_back(static_cast<char>(0xFF));
+                }
+            }
+            out.push_back('\0');
+            out.push_back('\x01');
+            return true;
+        case KeyColumnType::INT64:
+            {
+                int64_t number;
+                if (!parseInt64(value, number)) {
+                    return false;
+                }
+                putBigEndian(out, static_cast<uint64_t>(number) ^ SIGN_BIT);
+                return true;
+            }
+        case KeyColumnType::DOUBLE:
+            {
+                double number;
+                if (!parseDouble(value, number)) {
+                    return false;
+                }
+                if (number == 0.0) {
+                    number = 0.0;  // -0.0 and 0.0 are equal, so encode them alike
+                }
+                uint64_t bits;
+                std::memcpy(&bits, &number, sizeof(bits));
+                putBigEndian(out, (bits & SIGN_BIT) ? ~bits : bits ^ SIGN_BIT);
+                return true;
+            }
+    }
+    return false;
+}
+
+bool encodeTupleKey(const std::vector<KeyColumnType>& types, const std::vector<std::string>& values,
+                    std::string& out) {
+    if (values.size() > types.size()) {
+        return false;
+    }
+    out.clear();
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (!appendKeyColumn(out, types[i], values[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool decodeTupleKey(std::string_view key, const std::vector<KeyColumnType>& types,
+                    std::vector<std::string>& values, std::string_view* rest) {
+    values.clear();
+    const unsigned char* pos = reinterpret_cast<const unsigned char*>(key.data());
+    const unsigned char* end = pos + key.size();
+    for (KeyColumnType type : types) {
+        if (type == KeyColumnType::STRING) {
+            std::string value;
+            while (true) {
+                if (end - pos < 2) {
+                    return false;
+                }
+                if (pos[0] != 0) {
+                    value.push_back(static_cast<char>(*pos++));
+                } else if (pos[1] == 0xFF) {
+                    value.push_back('\0');
+                    pos += 2;
+                } else if (pos[1] == 0x01) {
+                    pos += 2;
+                    break;
+                } else {
+                    return false;
+                }
+            }
+            values.push_back(std::move(value));
+            continue;
+        }
+
+        if (end - pos < 8) {
+            return false;
+        }
+        uint64_t bits = getBigEndian(pos);
+        pos += 8;
+        if (type == KeyColumnType::INT64) {
+            values.push_back(std::to_string(static_cast<int64_t>(bits ^ SIGN_BIT)));
+        } else {
+            bits = (bits & SIGN_BIT) ? bits ^ SIGN_BIT : ~bits;
+            double number;
+            std::memcpy(&number, &bits, sizeof(number));
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.17g", number);
+            values.push_back(buffer);
+        }
+    }
+    if (rest != nullptr) {
+        *rest = std::string_view(reinterpret_cast<const char*>(pos), static_cast<size_t>(end - pos));
+    }
+    return true;
+}
+
+std::string prefixSuccessor(std::string_view prefix) {
+    std::string successor(prefix);
+    while (!successor.empty()) {
+        unsigned char last = static_cast<unsigned char>(successor.back());
+        if (last != 0xFF) {
+            successor.back() = static_cast<char>(last + 1);
+            return successor;
+        }
+        successor.pop_back();
+    }
+    return successor;
+}
+
+std::string encodeValueList(const std::vector<std::string>& values) {
+    std::string out;
+    for (const auto& value : values) {
+        putVarint(out, value.size());
+        out.append(value);
+    }
+    return out;
+}
+
+bool decodeValueList(std::string_view data, std::vector<std::string>& values) {
+    values.clear();
+    const unsigned char* pos = reinterpret_cast<const unsigned char*>(data.data());
+    const unsigned char* end = pos + data.size();
+    while (pos < end) {
+        uint64_t length;
+        if (!getVarint(pos, end, length) || length > static_cast<uint64_t>(end - pos)) {
+            return false;
+        }
+        values.emplace_back(reinterpret_cast<const char*>(pos), static_cast<size_t>(length));
+        pos += length;
+    }
+    return true;
+}
+
+} // namespace storage
+} // namespace phantomdb
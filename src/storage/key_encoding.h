@@ -0,0 +1,76 @@
+#ifndef PHANTOMDB_KEY_ENCODING_H
+#define PHANTOMDB_KEY_ENCODING_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace phantomdb {
+namespace storage {
+
+// How the values of one key column compare
+enum class KeyColumnType {
+    STRING,  // Bytewise
+    INT64,   // Signed 64-bit integers, given in decimal
+    DOUBLE   // IEEE doubles (not NaN)
+};
+
+/**
+ * Order-preserving encoding of tuple keys: comparing two encoded keys with
+ * memcmp (or std::string's operator<) orders them like the tuples they
+ * encode, column by column. Each column is encoded by its type:
+ *
+ *   STRING   the bytes with 0x00 escaped as 0x00 0xFF, then 0x00 0x01
+ *   INT64    8 bytes big-endian with the sign bit flipped
+ *   DOUBLE   8 bytes big-endian: the sign bit flipped for positive
+ *            values, every bit flipped for negative ones
+ *
+ * The string terminator sorts below every escaped byte, so a string sorts
+ * before the strings it is a prefix of. Every column is self-delimiting,
+ * so the encoding of the first n columns is a byte prefix of the encoding
+ * of the whole tuple: all keys with given leading values form one range.
+ */
+
+/**
+ * @brief Append one column's encoding to out
+ *
+ * @return false if value is not a valid INT64 or DOUBLE
+ */
+bool appendKeyColumn(std::string& out, KeyColumnType type, std::string_view value);
+
+/**
+ * @brief Encode the first values.size() columns of a tuple key
+ *
+ * @return false if there are more values than types or one is invalid
+ */
+bool encodeTupleKey(const std::vector<KeyColumnType>& types, const std::vector<std::string>& values,
+                    std::string& out);
+
+/**
+ * @brief Split a key encoded with types back into column values
+ *
+ * Numbers come back in a canonical form (INT64 in decimal, DOUBLE with
+ * the digits needed to round-trip), which may differ from the text they
+ * were encoded from. Decoding stops after the last type; the rest of the
+ * key is returned in rest.
+ *
+ * @return false if the key is not a valid encoding
+ */
+bool decodeTupleKey(std::string_view key, const std::vector<KeyColumnType>& types,
+                    std::vector<std::string>& values, std::string_view* rest = nullptr);
+
+/**
+ * @brief The smallest key greater than every key starting with prefix
+ *
+ * @return Empty if there is none (prefix is empty or all 0xFF bytes)
+ */
+std::string prefixSuccessor(std::string_view prefix);
+
+// Length-prefixed list of values (INCLUDE columns of an index entry)
+std::string encodeValueList(const std::vector<std::string>& values);
+bool decodeValueList(std::string_view data, std::vector<std::string>& values);
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_KEY_ENCODING_H
@@ -0,0 +1,147 @@
+#include "key_encoding.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <tuple>
+
+using namespace phantomdb::storage;
+
+namespace {
+
+std::string encode(const std::vector<KeyColumnType>& types, const std::vector<std::string>& values) {
+    std::string key;
+    assert(encodeTupleKey(types, values, key));
+    return key;
+}
+
+} // anonymous namespace
+
+void testColumnOrder() {
+    std::cout << "Testing encoded column order..." << std::endl;
+
+    // Strings: bytewise, prefixes first, embedded zero bytes kept in order
+    std::vector<std::string> strings = {"", std::string(1, '\0'), std::string("a\0", 2), "a", "a\x01", "ab",
+                                        "b", "\xff", "\xff\xff"};
+    std::sort(strings.begin(), strings.end());
+    for (size_t i = 1; i < strings.size(); ++i) {
+        assert(encode({KeyColumnType::STRING}, {strings[i - 1]}) < encode({KeyColumnType::STRING}, {strings[i]}));
+    }
+
+    // Integers: numerically, across the sign
+    std::vector<int64_t> integers = {INT64_MIN, -1000000, -2, -1, 0, 1, 255, 256, 1000000, INT64_MAX};
+    for (size_t i = 1; i < integers.size(); ++i) {
+        assert(encode({KeyColumnType::INT64}, {std::to_string(integers[i - 1])}) <
+               encode({KeyColumnType::INT64}, {std::to_string(integers[i])}));
+    }
+
+    // Doubles: numerically, with -0 equal to 0
+    std::vector<std::string> doubles = {"-inf", "-1e300", "-2.5", "-1", "-1e-300", "0", "1e-300", "0.5", "1",
+                                        "2.5", "1e300", "inf"};
+    for (size_t i = 1; i < doubles.size(); ++i) {
+        assert(encode({KeyColumnType::DOUBLE}, {doubles[i - 1]}) < encode({KeyColumnType::DOUBLE}, {doubles[i]}));
+    }
+    assert(encode({KeyColumnType::DOUBLE}, {"-0"}) == encode({KeyColumnType::DOUBLE}, {"0"}));
+
+    // Values that are not numbers are rejected
+    std::string key;
+    assert(!encodeTupleKey({KeyColumnType::INT64}, {"12x"}, key));
+    assert(!encodeTupleKey({KeyColumnType::INT64}, {""}, key));
+    assert(!encodeTupleKey({KeyColumnType::INT64}, {"99999999999999999999"}, key));
+    assert(!encodeTupleKey({KeyColumnType::DOUBLE}, {"nan"}, key));
+    assert(!encodeTupleKey({KeyColumnType::STRING}, {"a", "b"}, key));
+
+    std::cout << "Encoded column order test passed!" << std::endl;
+}
+
+void testTupleOrder() {
+    std::cout << "Testing encoded tuple order..." << std::endl;
+
+    // Random (string, int64, double) tuples sort like their encodings
+    std::vector<KeyColumnType> types = {KeyColumnType::STRING, KeyColumnType::INT64, KeyColumnType::DOUBLE};
+    std::mt19937 rng(25);
+    std::vector<std::tuple<std::string, int64_t, double>> tuples;
+    for (int i = 0; i < 3000; ++i) {
+        std::string s(static_cast<size_t>(rng() % 4), 'a');
+        for (auto& c : s) {
+            c = static_cast<char>(rng() % 3);  // Zero bytes included
+        }
+        tuples.emplace_back(s, static_cast<int64_t>(rng() % 21) - 10, (static_cast<int>(rng() % 9) - 4) * 0.75);
+    }
+    std::vector<std::pair<std::string, size_t>> encoded;
+    for (size_t i = 0; i < tuples.size(); ++i) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%g", std::get<2>(tuples[i]));
+        encoded.emplace_back(encode(types, {std::get<0>(tuples[i]), std::to_string(std::get<1>(tuples[i])), number}), i);
+    }
+    std::sort(encoded.begin(), encoded.end());
+    for (size_t i = 1; i < encoded.size(); ++i) {
+        assert(!(tuples[encoded[i].second] < tuples[encoded[i - 1].second]));
+        assert((encoded[i - 1].first == encoded[i].first) == (tuples[encoded[i - 1].second] == tuples[encoded[i].second]));
+    }
+
+    // Keys round trip, with the bytes after the last type left over
+    for (const auto& entry : encoded) {
+        std::vector<std::string> values;
+        std::string_view rest;
+        std::string key = entry.first + "row-1";
+        assert(decodeTupleKey(key, types, values, &rest));
+        const auto& tuple = tuples[entry.second];
+        assert(values.size() == 3 && values[0] == std::get<0>(tuple));
+        assert(values[1] == std::to_string(std::get<1>(tuple)));
+        assert(std::stod(values[2]) == std::get<2>(tuple));
+        assert(rest == "row-1");
+    }
+    std::vector<std::string> values;
+    assert(decodeTupleKey(encode(types, {"x", "-7", "0.1"}), types, values));
+    assert(values[1] == "-7" && std::stod(values[2]) == 0.1);
+
+    // Truncated keys do not decode
+    std::string key = encode(types, {"abc", "1", "2"});
+    for (size_t length = 0; length < key.size(); ++length) {
+        assert(!decodeTupleKey(std::string_view(key.data(), length), types, values));
+    }
+
+    std::cout << "Encoded tuple order test passed!" << std::endl;
+}
+
+void testPrefixes() {
+    std::cout << "Testing key prefixes..." << std::endl;
+
+    // Leading columns encode to a byte prefix of the whole key
+    std::vector<KeyColumnType> types = {KeyColumnType::INT64, KeyColumnType::STRING};
+    std::string tenant = encode(types, {"42"});
+    std::string full = encode(types, {"42", "2024-01-01"});
+    assert(full.compare(0, tenant.size(), tenant) == 0);
+
+    // Everything starting with a prefix falls below its successor
+    std::string end = prefixSuccessor(tenant);
+    assert(tenant < full && full < end);
+    assert(encode(types, {"43", ""}) >= end);
+    assert(prefixSuccessor("ab\xff\xff") == "ac");
+    assert(prefixSuccessor("\xff").empty() && prefixSuccessor("").empty());
+
+    // Value lists round trip, empty values included
+    std::vector<std::string> list = {"", "view", std::string("a\0b", 3), std::string(300, 'x')};
+    std::vector<std::string> decoded;
+    assert(decodeValueList(encodeValueList(list), decoded) && decoded == list);
+    assert(decodeValueList("", decoded) && decoded.empty());
+    std::string broken = encodeValueList({"abcdef"});
+    broken.pop_back();
+    assert(!decodeValueList(broken, decoded));
+
+    std::cout << "Key prefixes test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running key encoding tests..." << std::endl;
+
+    testColumnOrder();
+    testTupleOrder();
+    testPrefixes();
+
+    std::cout << "All key encoding tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef PHANTOMDB_LOCK_STRIPING_H
+#define PHANTOMDB_LOCK_STRIPING_H
+
+#include <cstddef>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * Helpers for structures split into a power-of-two number of independently
+ * locked stripes (ConcurrentHashTable, LookupCache).
+ *
+ * A key's stripe is picked by the top bits of its hash. SwissTable picks
+ * groups with the low bits, so a stripe's table still sees evenly spread
+ * hashes. Every stripe hashes the same way, so callers hash a key once,
+ * before taking any lock, and pass the hash down.
+ */
+
+// Stripes are aligned (and so padded) to this, so the locks of
+// neighbouring stripes do not share a cache line
+const size_t STRIPE_ALIGNMENT = 64;
+
+// log2 of the smallest power of two >= requested (0 for one stripe)
+inline int stripeBits(size_t requested) {
+    int bits = 0;
+    while ((static_cast<size_t>(1) << bits) < requested) {
+        bits++;
+    }
+    return bits;
+}
+
+// Stripe of hash among 2^bits stripes
+inline size_t stripeOf(size_t hash, int bits) {
+    // Shifting a size_t by its full width is undefined, so one stripe is special
+    return bits == 0 ? 0 : hash >> (sizeof(size_t) * 8 - bits);
+}
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_LOCK_STRIPING_H
@@ -0,0 +1,554 @@
+#ifndef PHANTOMDB_LOOKUP_CACHE_H
+#define PHANTOMDB_LOOKUP_CACHE_H
+
+#include "swiss_table.h"
+#include "lock_striping.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * @brief Bounded cache of hot index lookups, split into locked shards
+ *
+ * Sits in front of an index whose lookups are comparatively expensive (a
+ * B-tree walk, or an LSM-tree search through several sorted tables) and
+ * keeps the values of keys looked up often. Keys are spread over a
+ * power-of-two number of shards (see lock_striping.h), each holding an
+ * equal share of the capacity. Small caches use fewer shards; growing the
+ * capacity spreads the keys over more of them, up to the requested count.
+ *
+ * Eviction is CLOCK: a shard's entries sit in a ring, a hit only sets the
+ * entry's reference bit, and the clock hand clears bits until it reaches
+ * an entry not hit since the hand last passed. Unlike LRU, a hit moves
+ * nothing, so hits share the shard lock with each other.
+ *
+ * Admission is TinyLFU: every lookup, hit or miss, is counted in a
+ * count-min sketch per shard, whose counters saturate at 15 and are halved
+ * after ten lookups per sketch column so that old popularity fades. A key
+ * loaded after a miss replaces the clock's victim only if it has been
+ * looked up more often, so a scan over many cold keys passes by without
+ * flushing the hot ones.
+ *
+ * Whoever changes a key in the index must erase() it here afterwards. A
+ * load that overlapped an erase in its shard is returned but not cached,
+ * so a stale value is never put back.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class LookupCache {
+public:
+    static const size_t DEFAULT_SHARDS = 16;
+
+    // Shards are not split below this capacity, so small caches have fewer
+    static const size_t MIN_SHARD_CAPACITY = 32;
+
+    /**
+     * @brief Construct an empty cache
+     * @param capacity Entries to keep; 0 caches nothing until setCapacity()
+     * @param requestedShards Most independently locked shards to use, rounded
+     *        up to a power of two; all are allocated, for the largest capacity
+     */
+    explicit LookupCache(size_t capacity, size_t requestedShards = DEFAULT_SHARDS);
+
+    LookupCache(const LookupCache&) = delete;
+    LookupCache& operator=(const LookupCache&) = delete;
+
+    /**
+     * @brief Look up a key, asking load on a miss
+     *
+     * @param load Called as load(value) with no lock held; returns whether
+     *        the index has the key, and a value it finds is offered for caching
+     * @return true if the key was cached or load found it
+     */
+    template<typename Loader>
+    bool lookup(const Key& key, Value& value, Loader load);
+
+    // Forget a key, e.g. because its value changed; false if it was not cached
+    bool erase(const Key& key);
+
+    // Forget every key; lookup counts and frequencies are kept
+    void clear();
+
+    // Change the capacity, evicting entries when it shrinks and changing
+    // the number of shards in use when it crosses a multiple of MIN_SHARD_CAPACITY
+    void setCapacity(size_t capacity);
+
+    size_t getCapacity() const;
+
+    // Number of cached entries
+    size_t getCount() const;
+
+    // Lookups answered from the cache
+    uint64_t getHits() const;
+
+    // Lookups passed on to the loader
+    uint64_t getMisses() const;
+
+    // Bytes held by the rings, their hash tables and the sketches, not
+    // counting memory keys and values allocate themselves
+    size_t getMemoryUsage() const;
+
+    // Number of shards in use
+    size_t getShardCount() const;
+
+private:
+    static const size_t SKETCH_ROWS = 4;
+    static const uint8_t SKETCH_MAX = 15;
+    static const size_t SKETCH_MIN_WIDTH = 16;
+
+    struct Entry {
+        Key key;
+        Value value;
+        bool occupied = false;
+        std::atomic<bool> referenced{false};  // Set by hits under the shared lock
+    };
+
+    struct alignas(STRIPE_ALIGNMENT) Shard {
+        mutable std::shared_mutex mutex;
+        SwissTable<Key, uint32_t, Hash> slots;  // Key -> its place in entries
+        std::unique_ptr<Entry[]> entries;       // The clock's ring
+        std::vector<uint32_t> freeSlots;        // Unoccupied places in entries
+        size_t capacity = 0;
+        size_t count = 0;
+        size_t hand = 0;
+        uint64_t epoch = 0;                     // Bumped by every erase and clear
+
+        // Count-min sketch, SKETCH_ROWS rows of sketchWidth counters
+        std::unique_ptr<std::atomic<uint8_t>[]> sketch;
+        size_t sketchWidth = 0;
+        int sketchShift = 0;                    // 64 - log2(sketchWidth)
+        std::atomic<uint64_t> samples{0};       // Lookups counted since the last halving
+
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
+
+    using SharedLock = std::shared_lock<std::shared_mutex>;
+    using ExclusiveLock = std::unique_lock<std::shared_mutex>;
+
+    std::unique_ptr<Shard[]> shards;
+    size_t maxShards;
+
+    // log2 of the shards in use; changed only with every shard locked
+    std::atomic<int> shardBits;
+    std::atomic<size_t> totalCapacity;
+
+    // Held by setCapacity throughout, so shardBits is stable there
+    std::mutex capacityMutex;
+
+    // Shards to use for a capacity, as log2
+    int shardBitsFor(size_t capacity) const;
+
+    // Lock the shard hash belongs to, retrying if setCapacity moved it meanwhile
+    template<typename Lock>
+    Shard& lockShard(size_t hash, Lock& lock) const;
+
+    // Counter of the sketch row for hash
+    static std::atomic<uint8_t>& counter(const Shard& shard, size_t row, size_t hash);
+
+    // Count a lookup of hash (safe under the shared lock)
+    static void recordAccess(Shard& shard, size_t hash);
+
+    // Estimated lookups of hash since the sketch was last halved (roughly)
+    static uint8_t frequency(const Shard& shard, size_t hash);
+
+    // Halve every counter once enough lookups have been counted
+    static void age(Shard& shard);
+
+    // Cache a loaded value if there is room or it beats the clock's victim
+    void admit(Shard& shard, const Key& key, const Value& value, size_t hash);
+
+    // Place of the next entry to evict; the shard must not be empty
+    static size_t clockVictim(Shard& shard);
+
+    // Store an entry in a free place; the shard must have one
+    static void place(Shard& shard, const Key& key, const Value& value, size_t hash, bool referenced);
+
+    // Remove the entry at slot (already gone from the slots table)
+    static void release(Shard& shard, size_t slot);
+
+    // Give a shard a new capacity, keeping the entries the clock would keep
+    void resize(Shard& shard, size_t newCapacity);
+
+    // Use 2^bits shards, moving the cached entries to their new shards
+    void respread(int bits, size_t newCapacity);
+};
+
+// Implementation
+template<typename Key, typename Value, typename Hash>
+LookupCache<Key, Value, Hash>::LookupCache(size_t capacity, size_t requestedShards)
+    : maxShards(static_cast<size_t>(1) << stripeBits(requestedShards)), shardBits(0), totalCapacity(0) {
+    shards.reset(new Shard[maxShards]);
+    setCapacity(capacity);
+}
+
+template<typename Key, typename Value, typename Hash>
+int LookupCache<Key, Value, Hash>::shardBitsFor(size_t capacity) const {
+    int bits = 0;
+    while ((static_cast<size_t>(2) << bits) <= maxShards &&
+           capacity / (static_cast<size_t>(2) << bits) >= MIN_SHARD_CAPACITY) {
+        bits++;
+    }
+    return bits;
+}
+
+template<typename Key, typename Value, typename Hash>
+template<typename Lock>
+typename LookupCache<Key, Value, Hash>::Shard&
+LookupCache<Key, Value, Hash>::lockShard(size_t hash, Lock& lock) const {
+    for (;;) {
+        int bits = shardBits.load(std::memory_order_acquire);
+        Shard& shard = shards[stripeOf(hash, bits)];
+        lock = Lock(shard.mutex);
+        if (shardBits.load(std::memory_order_relaxed) == bits) {
+            return shard;
+        }
+        lock.unlock();
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+std::atomic<uint8_t>& LookupCache<Key, Value, Hash>::counter(const Shard& shard, size_t row, size_t hash) {
+    // A different multiplicative hash per row, keeping the top bits
+    static const uint64_t seeds[SKETCH_ROWS] = {
+        0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL
+    };
+    size_t column = static_cast<size_t>((static_cast<uint64_t>(hash) * seeds[row]) >> shard.sketchShift);
+    return shard.sketch[row * shard.sketchWidth + column];
+}
+
+template<typename Key, typename Value, typename Hash>
+void LookupCache<Key, Value, Hash>::recordAccess(Shard& shard, size_t hash) {
+    for (size_t row = 0; row < SKETCH_ROWS; ++row) {
+        std::atomic<uint8_t>& cell = counter(shard, row, hash);
+        uint8_t current = cell.load(std::memory_order_relaxed);
+        while (current < SKETCH_MAX &&
+               !cell.compare_exchange_weak(current, static_cast<uint8_t>(current + 1), std::memory_order_relaxed)) {
+        }
+    }
+    shard.samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename Key, typename Value, typename Hash>
+uint8_t LookupCache<Key, Value, Hash>::frequency(const Shard& shard, size_t hash) {
+    uint8_t estimate = SKETCH_MAX;
+    for (size_t row = 0; row < SKETCH_ROWS; ++row) {
+        estimate = std::min(estimate, counter(shard, row, hash).load(std::memory_order_relaxed));
+    }
+    return estimate;
+}
+
+template<typename Key, typename Value, typename Hash>
+void LookupCache<Key, Value, Hash>::age(Shard& shard) {
+    if (shard.samples.load(std::memory_order_relaxed) < 10 * shard.sketchWidth) {
+        return;
+    }
+    for (size_t i = 0; i < SKETCH_ROWS * shard.sketchWidth; ++i) {
+        shard.sketch[i].store(shard.sketch[i].load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+    }
+    shard.samples.store(0, std::memory_order_relaxed);
+}
+
+template<typename Key, typename Value, typename Hash>
+template<typename Loader>
+bool LookupCache<Key, Value, Hash>::lookup(const Key& key, Value& value, Loader load) {
+    size_t hash = shards[0].slots.hashOf(key);
+    Shard* owner;
+    uint64_t epoch;
+    {
+        SharedLock lock;
+        Shard& shard = lockShard(hash, lock);
+        owner = &shard;
+        recordAccess(shard, hash);
+        uint32_t slot;
+        if (shard.slots.search(key, slot, hash)) {
+            Entry& entry = shard.entries[slot];
+            value = entry.value;
+            entry.referenced.store(true, std::memory_order_relaxed);
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        epoch = shard.epoch;
+    }
+
+    // The index is searched without the lock, so a slow lookup blocks no one
+    if (!load(value)) {
+        return false;
+    }
+
+    // Moving keys between shards bumps every epoch, so the shard is still right
+    ExclusiveLock lock(owner->mutex);
+    if (owner->epoch == epoch) {
+        admit(*owner, key, value, hash);
+    }
+    return true;
+}
+
+template<typename Key, typename Value, typename Hash>
+void LookupCache<Key, Value, Hash>::admit(Shard& shard, const Key& key, const Value& value, size_t hash) {
+    if (shard.capacity == 0) {
+        return;
+    }
+    age(shard);
+
+    // Another thread may have loaded the same key meanwhile
+    uint32_t slot;
+    if (shard.slots.search(key, slot, hash)) {
+        return;
+    }
+
+    if (shard.freeSlots.empty()) {
+        size_t victim = clockVictim(shard);
+        Entry& entry = shard.entries[victim];
+        if (frequency(shard, hash) <= frequency(shard, shard.slots.hashOf(entry.key))) {
+            return;
+        }
+        shard.slots.remove(entry.key);
+        release(shard, victim);
+        shard.hand = (victim + 1) % shard.capacity;
+    }
+
+    place(shard, key, value, hash, false);
+}
+
+template<typename Key, typename Value, typename Hash>
+void LookupCache<Key, Value, Hash>::place(Shard& shard, const Key& key, const Value& value, size_t hash,
+                                          bool referenced) {
+    uint32_t slot = shard.freeSlots.back();
+    shard.freeSlots.pop_back();
+    Entry& entry = shard.entries[slot];
+    entry.key = key;
+    entry.value = value;
+    entry.occupied = true;
+    entry.referenced.store(referenced, std::memory_order_relaxed);
+    shard.slots.insert(key, slot, hash);
+    shard.count++;
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t LookupCache<Key, Value, Hash>::clockVictim(Shard& shard) {
+    for (;;) {
+        Entry& entry = shard.entries[shard.hand];
+        if (entry.occupied && !entry.referenced.load(std::memory_order_relaxed)) {
+            return shard.hand;
+        }
+        entry.referenced.store(false, std::memory_order_relaxed);
+        shard.hand = (shard.hand + 1) % shard.capacity;
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+void LookupCache<Key, Value, Hash>::release(Shard& shard, size_t slot) {
+    Entry& entry = shard.entries[slot];
+    entry.key = Key();
+    entry.value = Value();
+    entry.occupied = false;
+    entry.referenced.store(false, std::memory_order_relaxed);
+    shard.freeSlots.push_back(static_cast<uint32_t>(slot));
+    shard.count--;
+}
+
+template<typename Key, typename Value, typename Hash>
+bool LookupCache<Key, Value, Hash>::erase(const Key& key) {
+    size_t hash = shards[0].slots.hashOf(key);
+    ExclusiveLock lock;
+    Shard& shard = lockShard(hash, lock);
+    shard.epoch++;
+    uint32_t slot;
+    if (!shard.slots.search(key, slot, hash)) {
+        return false;
+    }
+    shard.slots.remove(key, hash);
+    release(shard, slot);
+    return true;
+}
+
+template<typename Key, typename Value, typename Hash>
+void LookupCache<Key, Value, Hash>::clear() {
+    for (size_t i = 0; i < maxShards; ++i) {
+        Shard& shard = shards[i];
+        ExclusiveLock lock(shard.mutex);
+        shard.epoch++;
+        for (size_t slot = 0; slot < shard.capacity; ++slot) {
+            if (shard.entries[slot].occupied) {
+                release(shard, slot);
+            }
+        }
+        shard.slots.clear();
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+void LookupCache<Key, Value, Hash>::setCapacity(size_t newCapacity) {
+    std::lock_guard<std::mutex> guard(capacityMutex);
+    int bits = shardBitsFor(newCapacity);
+    if (bits != shardBits.load(std::memory_order_relaxed)) {
+        respread(bits, newCapacity);
+    } else {
+        size_t shardCount = static_cast<size_t>(1) << bits;
+        for (size_t i = 0; i < shardCount; ++i) {
+            ExclusiveLock lock(shards[i].mutex);
+            resize(shards[i], newCapacity / shardCount + (i < newCapacity % shardCount ? 1 : 0));
+        }
+    }
+    totalCapacity.store(newCapacity, std::memory_order_relaxed);
+}
+
+template<typename Key, typename Value, typename Hash>
+void LookupCache<Key, Value, Hash>::respread(int bits, size_t newCapacity) {
+    // Lock every shard, in order, so no lookup or erase runs meanwhile
+    std::vector<ExclusiveLock> locks;
+    locks.reserve(maxShards);
+    for (size_t i = 0; i < maxShards; ++i) {
+        locks.emplace_back(shards[i].mutex);
+    }
+
+    // Take out the cached entries, referenced ones first so they are the
+    // ones kept if the new shards have less room
+    struct Survivor {
+        Key key;
+        Value value;
+        size_t hash;
+        bool referenced;
+    };
+    std::vector<Survivor> survivors;
+    for (size_t i = 0; i < maxShards; ++i) {
+        Shard& shard = shards[i];
+        for (size_t slot = 0; slot < shard.capacity; ++slot) {
+            Entry& entry = shard.entries[slot];
+            if (entry.occupied) {
+                size_t hash = shard.slots.hashOf(entry.key);
+                survivors.push_back({std::move(entry.key), std::move(entry.value), hash,
+                                     entry.referenced.load(std::memory_order_relaxed)});
+                release(shard, slot);
+            }
+        }
+        shard.slots.clear();
+        shard.epoch++;
+    }
+    std::stable_partition(survivors.begin(), survivors.end(),
+                          [](const Survivor& survivor) { return survivor.referenced; });
+
+    size_t shardCount = static_cast<size_t>(1) << bits;
+    for (size_t i = 0; i < maxShards; ++i) {
+        resize(shards[i], i < shardCount ? newCapacity / shardCount + (i < newCapacity % shardCount ? 1 : 0) : 0);
+    }
+    shardBits.store(bits, std::memory_order_release);
+    for (const auto& survivor : survivors) {
+        Shard& shard = shards[stripeOf(survivor.hash, bits)];
+        if (shard.count < shard.capacity) {
+            place(shard, survivor.key, survivor.value, survivor.hash, survivor.referenced);
+        }
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+void LookupCache<Key, Value, Hash>::resize(Shard& shard, size_t newCapacity) {
+    // Evict down to the new size first, so the survivors are the clock's choice
+    while (shard.count > newCapacity) {
+        size_t victim = clockVictim(shard);
+        shard.slots.remove(shard.entries[victim].key);
+        release(shard, victim);
+    }
+
+    // Move the survivors to a new ring in clock order, starting at the hand
+    std::unique_ptr<Entry[]> entries(new Entry[newCapacity]);
+    size_t moved = 0;
+    for (size_t i = 0; i < shard.capacity; ++i) {
+        Entry& old = shard.entries[(shard.hand + i) % shard.capacity];
+        if (!old.occupied) {
+            continue;
+        }
+        Entry& entry = entries[moved];
+        entry.key = std::move(old.key);
+        entry.value = std::move(old.value);
+        entry.occupied = true;
+        entry.referenced.store(old.referenced.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        shard.slots.insert(entry.key, static_cast<uint32_t>(moved));
+        moved++;
+    }
+    shard.entries = std::move(entries);
+    shard.capacity = newCapacity;
+    shard.hand = 0;
+    shard.freeSlots.clear();
+    for (size_t slot = newCapacity; slot > moved; --slot) {
+        shard.freeSlots.push_back(static_cast<uint32_t>(slot - 1));
+    }
+
+    // A sketch about as wide as the shard; its counts start over
+    size_t width = SKETCH_MIN_WIDTH;
+    int bits = 4;
+    while (width < newCapacity) {
+        width <<= 1;
+        bits++;
+    }
+    if (width != shard.sketchWidth) {
+        shard.sketch.reset(new std::atomic<uint8_t>[SKETCH_ROWS * width]());
+        shard.sketchWidth = width;
+        shard.sketchShift = 64 - bits;
+        shard.samples.store(0, std::memory_order_relaxed);
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t LookupCache<Key, Value, Hash>::getCapacity() const {
+    return totalCapacity.load(std::memory_order_relaxed);
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t LookupCache<Key, Value, Hash>::getCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < maxShards; ++i) {
+        SharedLock lock(shards[i].mutex);
+        count += shards[i].count;
+    }
+    return count;
+}
+
+template<typename Key, typename Value, typename Hash>
+uint64_t LookupCache<Key, Value, Hash>::getHits() const {
+    uint64_t hits = 0;
+    for (size_t i = 0; i < maxShards; ++i) {
+        hits += shards[i].hits.load(std::memory_order_relaxed);
+    }
+    return hits;
+}
+
+template<typename Key, typename Value, typename Hash>
+uint64_t LookupCache<Key, Value, Hash>::getMisses() const {
+    uint64_t misses = 0;
+    for (size_t i = 0; i < maxShards; ++i) {
+        misses += shards[i].misses.load(std::memory_order_relaxed);
+    }
+    return misses;
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t LookupCache<Key, Value, Hash>::getMemoryUsage() const {
+    size_t bytes = sizeof(Shard) * maxShards;
+    for (size_t i = 0; i < maxShards; ++i) {
+        SharedLock lock(shards[i].mutex);
+        const Shard& shard = shards[i];
+        bytes += shard.capacity * sizeof(Entry) + shard.freeSlots.capacity() * sizeof(uint32_t) +
+                 shard.slots.getMemoryUsage() + SKETCH_ROWS * shard.sketchWidth;
+    }
+    return bytes;
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t LookupCache<Key, Value, Hash>::getShardCount() const {
+    return static_cast<size_t>(1) << shardBits.load(std::memory_order_relaxed);
+}
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_LOOKUP_CACHE_H
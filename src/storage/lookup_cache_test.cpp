@@ -0,0 +1,226 @@
+#include "lookup_cache.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <unordered_map>
+#include <random>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+using namespace phantomdb::storage;
+
+void testBasicOperations() {
+    std::cout << "Testing basic lookup cache operations..." << std::endl;
+
+    LookupCache<int, int> cache(60, 4);
+    assert(cache.getShardCount() == 1);
+    assert(cache.getCapacity() == 60);
+    int loads = 0;
+    auto square = [&loads](int key) {
+        return [&loads, key](int& value) {
+            loads++;
+            if (key < 0) {
+                return false;
+            }
+            value = key * key;
+            return true;
+        };
+    };
+
+    // The first lookup loads and caches, the second is a hit
+    int value = 0;
+    assert(cache.lookup(7, value, square(7)) && value == 49);
+    assert(cache.lookup(7, value, square(7)) && value == 49);
+    assert(loads == 1);
+    assert(cache.getHits() == 1 && cache.getMisses() == 1);
+    assert(cache.getCount() == 1);
+
+    // Keys the loader does not find are not cached
+    assert(!cache.lookup(-1, value, square(-1)));
+    assert(!cache.lookup(-1, value, square(-1)));
+    assert(loads == 3);
+    assert(cache.getCount() == 1);
+
+    // Erased keys are loaded again
+    assert(cache.erase(7));
+    assert(!cache.erase(7));
+    assert(cache.lookup(7, value, square(7)) && value == 49);
+    assert(loads == 4);
+
+    cache.clear();
+    assert(cache.getCount() == 0);
+    assert(cache.lookup(7, value, square(7)));
+    assert(loads == 5);
+
+    // A zero capacity caches nothing but still counts misses
+    LookupCache<int, int> disabled(0);
+    assert(disabled.lookup(3, value, square(3)) && value == 9);
+    assert(disabled.lookup(3, value, square(3)));
+    assert(disabled.getCount() == 0);
+    assert(disabled.getHits() == 0 && disabled.getMisses() == 2);
+
+    // Larger caches are sharded, up to the requested count
+    LookupCache<int, int> sharded(100000);
+    assert((sharded.getShardCount() == LookupCache<int, int>::DEFAULT_SHARDS));
+
+    // Growing spreads the keys over more shards, keeping them cached
+    LookupCache<int, int> grown(0);
+    assert(grown.getShardCount() == 1);
+    grown.setCapacity(40);
+    for (int key = 0; key < 30; ++key) {
+        assert(grown.lookup(key, value, square(key)));
+    }
+    assert(grown.getCount() == 30);
+    grown.setCapacity(100000);
+    assert((grown.getShardCount() == LookupCache<int, int>::DEFAULT_SHARDS));
+    assert(grown.getCount() == 30);
+    int loadsBefore = loads;
+    for (int key = 0; key < 30; ++key) {
+        assert(grown.lookup(key, value, square(key)) && value == key * key);
+    }
+    assert(loads == loadsBefore);
+    grown.setCapacity(10);
+    assert(grown.getShardCount() == 1 && grown.getCount() == 10);
+
+    std::cout << "Basic operations test passed!" << std::endl;
+}
+
+void testCapacityAndAdmission() {
+    std::cout << "Testing capacity and admission..." << std::endl;
+
+    const int capacity = 1000;
+    LookupCache<int, int> cache(capacity);
+    auto identity = [](int key) {
+        return [key](int& value) {
+            value = key;
+            return true;
+        };
+    };
+    int value;
+
+    // A hot set looked up a few times each settles in the cache
+    for (int round = 0; round < 4; ++round) {
+        for (int key = 0; key < capacity / 2; ++key) {
+            assert(cache.lookup(key, value, identity(key)) && value == key);
+        }
+    }
+
+    // A scan over three times as many keys, each seen once, is not admitted
+    // over the hot set (an LRU cache would keep only the scan's tail)
+    for (int key = 100000; key < 100000 + 3 * capacity; ++key) {
+        cache.lookup(key, value, identity(key));
+        assert(cache.getCount() <= static_cast<size_t>(capacity));
+    }
+    uint64_t hitsBefore = cache.getHits();
+    for (int key = 0; key < capacity / 2; ++key) {
+        cache.lookup(key, value, identity(key));
+    }
+    assert(cache.getHits() - hitsBefore >= static_cast<uint64_t>(capacity / 2 * 9 / 10));
+
+    // Under a skewed workload the cache answers most lookups
+    LookupCache<int, int> skewed(capacity);
+    std::mt19937 rng(5);
+    std::vector<double> weights;
+    for (int key = 1; key <= 100000; ++key) {
+        weights.push_back(1.0 / key);
+    }
+    std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+    for (int i = 0; i < 200000; ++i) {
+        int key = zipf(rng);
+        assert(skewed.lookup(key, value, identity(key)) && value == key);
+    }
+    double hitRate = static_cast<double>(skewed.getHits()) / (skewed.getHits() + skewed.getMisses());
+    assert(hitRate > 0.5);
+
+    // Shrinking keeps the capacity bound; growing makes room again
+    cache.setCapacity(100);
+    assert(cache.getCapacity() == 100);
+    assert(cache.getCount() <= 100);
+    cache.setCapacity(5000);
+    for (int key = 0; key < 3000; ++key) {
+        cache.lookup(key, value, identity(key));
+        cache.lookup(key, value, identity(key));
+    }
+    assert(cache.getCount() > 1000 && cache.getCount() <= 5000);
+    for (int key = 0; key < 3000; ++key) {
+        assert(cache.lookup(key, value, identity(key)) && value == key);
+    }
+    cache.setCapacity(0);
+    assert(cache.getCount() == 0);
+
+    std::cout << "Capacity and admission test passed!" << std::endl;
+}
+
+void testConcurrentLookupsAndWrites() {
+    std::cout << "Testing concurrent lookups and writes..." << std::endl;
+
+    // A locked map stands in for the index; writers update it, then erase
+    std::unordered_map<int, int> index;
+    std::mutex indexMutex;
+    const int keyCount = 2000;
+    for (int key = 0; key < keyCount; ++key) {
+        index[key] = 0;
+    }
+    LookupCache<int, int> cache(500, 8);
+    auto load = [&index, &indexMutex](int key) {
+        return [&index, &indexMutex, key](int& value) {
+            std::lock_guard<std::mutex> lock(indexMutex);
+            value = index.at(key);
+            return true;
+        };
+    };
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, &load, &stop, t]() {
+            std::mt19937 rng(t);
+            int value;
+            while (!stop.load()) {
+                int key = static_cast<int>(rng() % 200 == 0 ? rng() % keyCount : rng() % 100);
+                assert(cache.lookup(key, value, load(key)));
+            }
+        });
+    }
+    std::thread writer([&]() {
+        std::mt19937 rng(99);
+        for (int i = 1; i <= 20000; ++i) {
+            int key = static_cast<int>(rng() % 120);
+            {
+                std::lock_guard<std::mutex> lock(indexMutex);
+                index[key] = i;
+            }
+            cache.erase(key);
+            if (i % 5000 == 0) {
+                cache.setCapacity(i % 10000 == 0 ? 500 : 50);
+            }
+        }
+        stop.store(true);
+    });
+    writer.join();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Nothing stale survived: every cached value is the index's current one
+    for (int key = 0; key < keyCount; ++key) {
+        int value;
+        assert(cache.lookup(key, value, load(key)));
+        assert(value == index.at(key));
+    }
+
+    std::cout << "Concurrent lookups and writes test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running lookup cache tests..." << std::endl;
+
+    testBasicOperations();
+    testCapacityAndAdmission();
+    testConcurrentLookupsAndWrites();
+
+    std::cout << "All lookup cache tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,238 @@
+#include "lsm_compaction.h"
+#include "utils.h"
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+
+namespace phantomdb {
+namespace storage {
+
+class CompactionRateLimiter::Impl {
+public:
+    mutable std::mutex mutex;
+    uint64_t bytesPerSecond = 0;
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+};
+
+CompactionRateLimiter::CompactionRateLimiter() : pImpl(std::make_unique<Impl>()) {}
+
+CompactionRateLimiter::~CompactionRateLimiter() = default;
+
+void CompactionRateLimiter::setBytesPerSecond(uint64_t bytesPerSecond) {
+    std::lock_guard<std::mutex> lock(pImpl->mutex);
+    pImpl->bytesPerSecond = bytesPerSecond;
+    pImpl->next = std::chrono::steady_clock::now();
+}
+
+uint64_t CompactionRateLimiter::getBytesPerSecond() const {
+    std::lock_guard<std::mutex> lock(pImpl->mutex);
+    return pImpl->bytesPerSecond;
+}
+
+void CompactionRateLimiter::request(uint64_t bytes) {
+    std::chrono::steady_clock::time_point start;
+    {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        if (pImpl->bytesPerSecond == 0) {
+            return;
+        }
+        
+        // Each request takes the next slot of bytes / rate; it may start
+        // once every earlier slot has elapsed
+        auto now = std::chrono::steady_clock::now();
+        start = std::max(pImpl->next, now);
+        auto cost = std::chrono::nanoseconds(
+            static_cast<int64_t>(static_cast<double>(bytes) * 1e9 / static_cast<double>(pImpl->bytesPerSecond)));
+        pImpl->next = start + cost;
+    }
+    std::this_thread::sleep_until(start);
+}
+
+class LSMCompactionScheduler::Impl {
+public:
+    ~Impl() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+    
+    // Start workers up to the target; the caller holds the mutex
+    void startWorkers() {
+        while (running < targetThreads && running < jobs.size()) {
+            running++;
+            workers.emplace_back(&Impl::workerLoop, this);
+        }
+    }
+    
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait(lock, [this] { return stopping || !jobs.empty() || running > targetThreads; });
+            
+            // Queued jobs still run when stopping: trees wait for their jobs
+            if (jobs.empty() || running > targetThreads) {
+                if (stopping || running > targetThreads) {
+                    running--;
+                    return;
+                }
+                continue;
+            }
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+    
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> workers;
+    size_t targetThreads = DEFAULT_BACKGROUND_THREADS;
+    size_t running = 0;
+    bool stopping = false;
+    CompactionRateLimiter rateLimiter;
+};
+
+LSMCompactionScheduler::LSMCompactionScheduler() : pImpl(std::make_unique<Impl>()) {}
+
+LSMCompactionScheduler::~LSMCompactionScheduler() = default;
+
+LSMCompactionScheduler& LSMCompactionScheduler::instance() {
+    static LSMCompactionScheduler scheduler;
+    return scheduler;
+}
+
+void LSMCompactionScheduler::schedule(std::function<void()> job, bool highPriority) {
+    {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        if (highPriority) {
+            pImpl->jobs.push_front(std::move(job));
+        } else {
+            pImpl->jobs.push_back(std::move(job));
+        }
+        pImpl->startWorkers();
+    }
+    pImpl->cv.notify_one();
+}
+
+void LSMCompactionScheduler::setBackgroundThreads(size_t threads) {
+    {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        pImpl->targetThreads = std::max<size_t>(threads, 1);
+        pImpl->startWorkers();
+    }
+    pImpl->cv.notify_all();
+}
+
+size_t LSMCompactionScheduler::getBackgroundThreads() const {
+    std::lock_guard<std::mutex> lock(pImpl->mutex);
+    return pImpl->targetThreads;
+}
+
+size_t LSMCompactionScheduler::getPendingJobs() const {
+    std::lock_guard<std::mutex> lock(pImpl->mutex);
+    return pImpl->jobs.size();
+}
+
+CompactionRateLimiter& LSMCompactionScheduler::getRateLimiter() {
+    return pImpl->rateLimiter;
+}
+
+const char* const LSMManifest::FILE_NAME = "MANIFEST";
+
+bool LSMManifest::load(const std::string& directory) {
+    std::ifstream file(std::filesystem::path(directory) / FILE_NAME, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+    
+    // The last line is "crc <crc32 of everything before it>"
+    size_t crcLine = text.rfind("crc ");
+    unsigned long stored = 0;
+    if (crcLine == std::string::npos || std::sscanf(text.c_str() + crcLine, "crc %lx", &stored) != 1 ||
+        core::utils::crc32(text.data(), crcLine) != static_cast<uint32_t>(stored)) {
+        std::cerr << "Corrupt LSM-tree manifest in " << directory << std::endl;
+        return false;
+    }
+    
+    std::istringstream lines(text.substr(0, crcLine));
+    std::string magic;
+    int version = 0;
+    if (!(lines >> magic >> version) || magic != "PHDBLSM" || version != 1) {
+        std::cerr << "Unsupported LSM-tree manifest in " << directory << std::endl;
+        return false;
+    }
+    std::string word;
+    tables.clear();
+    while (lines >> word) {
+        if (word == "next") {
+            lines >> nextFileNumber;
+        } else if (word == "table") {
+            Table table;
+            lines >> table.number >> table.level;
+            tables.push_back(table);
+        }
+        if (!lines) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LSMManifest::save(const std::string& directory, bool sync) const {
+    std::ostringstream text;
+    text << "PHDBLSM 1\n";
+    text << "next " << nextFileNumber << "\n";
+    for (const auto& table : tables) {
+        text << "table " << table.number << " " << table.level << "\n";
+    }
+    std::string body = text.str();
+    char crc[32];
+    std::snprintf(crc, sizeof(crc), "crc %08x\n", core::utils::crc32(body.data(), body.size()));
+    body += crc;
+    
+    auto path = std::filesystem::path(directory) / FILE_NAME;
+    std::string tempPath = path.string() + ".tmp";
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Failed to write LSM-tree manifest: " << tempPath << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(body.data(), 1, body.size(), file) == body.size();
+    ok = ok && (!sync || core::utils::syncFile(file));
+    ok = std::fclose(file) == 0 && ok;
+    
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tempPath, path, ec);
+    }
+    if (!ok || ec) {
+        std::cerr << "Failed to write LSM-tree manifest: " << path.string() << std::endl;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace storage
+} // namespace phantomdb
@@ -0,0 +1,209 @@
+#ifndef PHANTOMDB_LSM_COMPACTION_H
+#define PHANTOMDB_LSM_COMPACTION_H
+
+#include "sstable.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+namespace phantomdb {
+namespace storage {
+
+// How an LSM-tree decides which sorted tables to merge
+enum class LSMCompactionStyle {
+    LEVELED,      // Level 0 plus non-overlapping levels, each ~10x the previous
+    SIZE_TIERED   // Runs of similarly sized tables are merged into one
+};
+
+/**
+ * @brief Tuning knobs for LSM-tree tables and compaction
+ * 
+ * Leveled compaction keeps freshly flushed tables in level 0, where they
+ * may overlap. Deeper levels are sorted runs of tables with disjoint key
+ * ranges; level 1 holds up to maxBytesForLevelBase and every level after
+ * it levelSizeMultiplier times more. A level over its budget pushes one
+ * table into the next level, rewriting only the tables it overlaps.
+ * 
+ * Size-tiered compaction keeps one stack of tables ordered by age and
+ * merges between minMergeWidth and maxMergeWidth adjacent tables whose
+ * sizes lie within [bucketLow, bucketHigh] times their average.
+ * 
+ * Every table carries a bloom filter of bloomBitsPerKey bits per key; 10
+ * bits give about 1% false positives, and every two more bits halve that.
+ * BLOCKED filters keep a key's bits in one cache line at a slightly
+ * higher rate than STANDARD ones.
+ */
+struct LSMCompactionOptions {
+    LSMCompactionStyle style = LSMCompactionStyle::LEVELED;
+    
+    // Tables
+    int bloomBitsPerKey = SSTableWriter::DEFAULT_BLOOM_BITS_PER_KEY;  // 0 disables the filters
+    BloomFilterLayout bloomLayout = BloomFilterLayout::BLOCKED;
+    bool frontCoding = false;  // Front-code data blocks; pays off for keys with long shared prefixes
+    
+    // Merge on the shared background scheduler; false merges inline after each flush
+    bool background = true;
+    
+    // Leveled
+    size_t level0CompactionTrigger = 4;        // Level 0 tables that start a merge into level 1
+    size_t level0StopWritesTrigger = 12;       // Level 0 tables at which writers wait for compaction
+    uint64_t targetFileSize = 2 * 1024 * 1024; // Merge output is split into tables of about this size
+    uint64_t maxBytesForLevelBase = 10 * 1024 * 1024;
+    double levelSizeMultiplier = 10.0;
+    int maxLevels = 7;
+    
+    // Size-tiered
+    size_t minMergeWidth = 4;
+    size_t maxMergeWidth = 32;
+    double bucketLow = 0.5;
+    double bucketHigh = 1.5;
+};
+
+// Counters describing the flush and compaction work of one LSM-tree
+struct LSMCompactionStats {
+    uint64_t flushes = 0;
+    uint64_t bytesFlushed = 0;           // Table bytes written by memtable flushes
+    uint64_t compactions = 0;            // Merges that rewrote data
+    uint64_t trivialMoves = 0;           // Tables moved down a level without a rewrite
+    uint64_t bytesRead = 0;              // Table bytes read by merges
+    uint64_t bytesWritten = 0;           // Table bytes written by merges
+    uint64_t entriesDropped = 0;         // Shadowed versions and tombstones merged away
+    uint64_t pendingCompactionBytes = 0; // Estimated bytes compaction still has to rewrite
+    uint64_t writeStalls = 0;            // Writes that waited for level 0 to drain
+    uint64_t stallMicros = 0;
+    
+    // Bytes written to disk per byte flushed: (flushed + compacted) / flushed
+    double writeAmplification() const {
+        return bytesFlushed == 0 ? 0.0 : static_cast<double>(bytesFlushed + bytesWritten) / bytesFlushed;
+    }
+};
+
+// Counters describing how point lookups got past the sorted tables
+struct LSMLookupStats {
+    uint64_t lookups = 0;              // Lookups that reached the tables, writes' checks included
+    uint64_t tablesProbed = 0;         // Tables whose data block was read
+    uint64_t fenceSkips = 0;           // Tables (or whole levels) whose key range excludes the key
+    uint64_t bloomSkips = 0;           // Tables ruled out by their bloom filter
+    uint64_t bloomFalsePositives = 0;  // Filter passed but the table did not hold the key
+    
+    uint64_t tablesSkipped() const {
+        return fenceSkips + bloomSkips;
+    }
+    
+    // Share of filter checks for absent keys that still read a block
+    double bloomFalsePositiveRate() const {
+        uint64_t absent = bloomSkips + bloomFalsePositives;
+        return absent == 0 ? 0.0 : static_cast<double>(bloomFalsePositives) / absent;
+    }
+};
+
+/**
+ * @brief Token bucket limiting the bytes compaction writes per second
+ * 
+ * Callers charge bytes before writing them and are delayed so the long
+ * run rate stays at or below the limit. A limit of 0 means unlimited.
+ */
+class CompactionRateLimiter {
+public:
+    CompactionRateLimiter();
+    ~CompactionRateLimiter();
+    
+    void setBytesPerSecond(uint64_t bytesPerSecond);
+    uint64_t getBytesPerSecond() const;
+    
+    /**
+     * @brief Wait until bytes may be written
+     */
+    void request(uint64_t bytes);
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
+
+/**
+ * @brief Worker threads shared by every LSM-tree for background compaction
+ * 
+ * Trees schedule a job when a flush leaves them needing compaction; each
+ * job runs one merge and reschedules itself if more work remains, so
+ * trees take turns on the workers. Workers start with the first job.
+ */
+class LSMCompactionScheduler {
+public:
+    static const size_t DEFAULT_BACKGROUND_THREADS = 2;
+    
+    LSMCompactionScheduler();
+    ~LSMCompactionScheduler();
+    
+    LSMCompactionScheduler(const LSMCompactionScheduler&) = delete;
+    LSMCompactionScheduler& operator=(const LSMCompactionScheduler&) = delete;
+    
+    // The scheduler used by LSMTREE
+    static LSMCompactionScheduler& instance();
+    
+    /**
+     * @brief Queue a job for a worker thread
+     * 
+     * @param job The work to run
+     * @param highPriority Run before queued normal jobs (memtable flushes,
+     *        which writers may be waiting for)
+     */
+    void schedule(std::function<void()> job, bool highPriority = false);
+    
+    /**
+     * @brief Set the number of worker threads (takes effect for idle workers)
+     */
+    void setBackgroundThreads(size_t threads);
+    size_t getBackgroundThreads() const;
+    
+    // Jobs queued but not yet started
+    size_t getPendingJobs() const;
+    
+    // Limit shared by all compactions run by this scheduler
+    CompactionRateLimiter& getRateLimiter();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
+
+/**
+ * @brief The set of live tables of an LSM-tree, stored in its directory
+ * 
+ * Written to a temporary file, synced and renamed over MANIFEST after
+ * every flush and compaction, so a crash leaves either the old or the new
+ * table set. Table files not listed are leftovers and may be deleted.
+ */
+struct LSMManifest {
+    struct Table {
+        uint64_t number;
+        int level;
+    };
+    
+    static const char* const FILE_NAME;
+    
+    uint64_t nextFileNumber = 1;
+    std::vector<Table> tables;  // Level 0 oldest first, then the deeper levels
+    
+    /**
+     * @brief Read the manifest of a directory
+     * 
+     * @return false if there is none or it is corrupt
+     */
+    bool load(const std::string& directory);
+    
+    /**
+     * @brief Atomically replace the manifest of a directory
+     * 
+     * @param sync fsync the file before renaming it into place
+     * @return true if successful, false otherwise
+     */
+    bool save(const std::string& directory, bool sync = true) const;
+};
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_LSM_COMPACTION_H
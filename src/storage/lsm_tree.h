@@ -1,200 +1,1319 @@
 #ifndef PHANTOMDB_LSM_TREE_H
 #define PHANTOMDB_LSM_TREE_H
 
+#include "sstable.h"
+#include "lsm_compaction.h"
+#include "memtable.h"
 #include <vector>
+#include <map>
 #include <memory>
 #include <string>
-#include <map>
-#include <deque>
+#include <string_view>
 #include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <type_traits>
+#include <cstdio>
 
 namespace phantomdb {
 namespace storage {
 
+/**
+ * Byte encodings for keys and values stored in sorted table files. Encoded
+ * keys compare with memcmp in the same order as the keys themselves, so
+ * the memtable's order is the file order. Specialize for other types.
+ */
+template<typename T, typename Enable = void>
+struct LSMCodec;
+
+// Integers: big-endian with the sign bit flipped
+template<typename T>
+struct LSMCodec<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+    static std::string encode(const T& value) {
+        using Unsigned = typename std::make_unsigned<T>::type;
+        auto bits = static_cast<Unsigned>(value);
+        if (std::is_signed<T>::value) {
+            bits ^= static_cast<Unsigned>(Unsigned(1) << (sizeof(T) * 8 - 1));
+        }
+        std::string out(sizeof(T), '\0');
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            out[i] = static_cast<char>((bits >> (8 * (sizeof(T) - 1 - i))) & 0xFF);
+        }
+        return out;
+    }
+    
+    static bool decode(std::string_view in, T& value) {
+        using Unsigned = typename std::make_unsigned<T>::type;
+        if (in.size() != sizeof(T)) {
+            return false;
+        }
+        Unsigned bits = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            bits = static_cast<Unsigned>((bits << 8) | static_cast<unsigned char>(in[i]));
+        }
+        if (std::is_signed<T>::value) {
+            bits ^= static_cast<Unsigned>(Unsigned(1) << (sizeof(T) * 8 - 1));
+        }
+        value = static_cast<T>(bits);
+        return true;
+    }
+};
+
+// Strings: the bytes themselves (std::string compares like memcmp)
+template<>
+struct LSMCodec<std::string> {
+    static std::string encode(const std::string& value) {
+        return value;
+    }
+    
+    static bool decode(std::string_view in, std::string& value) {
+        value.assign(in.data(), in.size());
+        return true;
+    }
+};
+
+/**
+ * @brief Log-structured merge tree over immutable sorted table files
+ * 
+ * Writes go to a concurrent skiplist memtable (see memtable.h). When it
+ * reaches memtableSize entries it becomes the immutable memtable, a fresh
+ * one takes the writes, and the immutable one is written out in the
+ * background as a sorted table file (see sstable.h) with a sparse block
+ * index and a bloom filter. Lookups check the memtable, the immutable
+ * memtable, then level 0 from newest to oldest table, then one table per
+ * deeper level; each table is memory-mapped, so only the blocks a lookup
+ * touches are paged in. Removing a key writes a tombstone that shadows
+ * older values until compaction merges it away.
+ * 
+ * Reads and writes hold a shared lock only to keep the memtables and the
+ * table set in place, so any number of them run in parallel; only
+ * switching memtables and installing flushed or merged tables take it
+ * exclusively. Writers wait only if the memtable fills up again before
+ * the previous one is written out, or if level 0 reaches
+ * level0StopWritesTrigger tables.
+ * 
+ * Compaction follows LSMCompactionOptions and by default runs on the
+ * shared LSMCompactionScheduler, so writers only pay for flushes. Merges
+ * stream their inputs and are rate limited by the scheduler's
+ * CompactionRateLimiter. The set of live tables is kept in a MANIFEST so
+ * a reopened tree finds every table at its level.
+ */
 template<typename Key, typename Value>
 class LSMTREE {
 public:
     static const int DEFAULT_MEMTABLE_SIZE = 1000;
     
-    explicit LSMTREE(int memtableSize = DEFAULT_MEMTABLE_SIZE);
+    /**
+     * @param memtableSize Entries buffered in memory before a flush
+     * @param directory Where table files are kept. Tables already there are
+     *        opened, and the memtable is flushed on destruction. If empty,
+     *        a private temporary directory is used and removed with the tree.
+     * @param options Compaction policy and tuning
+     */
+    explicit LSMTREE(int memtableSize = DEFAULT_MEMTABLE_SIZE, const std::string& directory = "",
+                     const LSMCompactionOptions& options = LSMCompactionOptions());
     ~LSMTREE();
     
+    LSMTREE(const LSMTREE&) = delete;
+    LSMTREE& operator=(const LSMTREE&) = delete;
+    
     void insert(const Key& key, const Value& value);
     bool search(const Key& key, Value& value) const;
     bool remove(const Key& key);
     int getSize() const;
+    
+    // Live keys, counted on demand by merging the tables so that inserts
+    // need no lookup; takes time linear in the size of the tree
     int getCount() const;
     
+    // Write the memtables out as sorted tables now
+    bool flush();
+    
+    /**
+     * @brief Wait until no flush or compaction is running or needed
+     * 
+     * @return false if a compaction failed
+     */
+    bool waitForCompactions();
+    
+    // Number of sorted table files, in total or in one level
+    size_t getTableCount() const;
+    size_t getTableCount(int level) const;
+    
+    // Total size of the sorted table files in bytes
+    uint64_t getDiskUsage() const;
+    
+    // Bytes held by the memtables
+    size_t getMemoryUsage() const;
+    
+    // Flush and compaction counters, with pendingCompactionBytes filled in
+    LSMCompactionStats getCompactionStats() const;
+    
+    // How lookups used the fence keys and bloom filters of the tables
+    LSMLookupStats getLookupStats() const;
+    
+    const LSMCompactionOptions& getCompactionOptions() const;
+    
+    const std::string& getDirectory() const;
+
 private:
     struct SSTable {
-        std::map<Key, Value> data;
+        SSTableReader reader;
+        uint64_t number;  // File number, unique within the directory
         int level;
     };
     
-    mutable std::mutex mtx_;
-    std::map<Key, Value> memtable_;  // In-memory table
-    std::deque<std::shared_ptr<SSTable>> sstables_;  // Sorted String Tables on disk
+    using TableList = std::vector<std::shared_ptr<SSTable>>;
+    using SharedLock = std::shared_lock<std::shared_mutex>;
+    using ExclusiveLock = std::unique_lock<std::shared_mutex>;
+    
+    // One merge chosen by pickCompaction()
+    struct Compaction {
+        int level = 0;                 // Level the inputs are pushed down from
+        int outputLevel = 0;
+        std::vector<TableList> runs;   // Inputs as sorted runs, oldest first
+        bool dropTombstones = false;   // Nothing older than the inputs overlaps them
+        bool trivialMove = false;      // A single table moves down without a rewrite
+        size_t tierBegin = 0;          // SIZE_TIERED: the inputs are levels_[0][tierBegin, tierEnd)
+        size_t tierEnd = 0;
+    };
+    
+    // Rate limiter charges are made in chunks of this many bytes
+    static const uint64_t RATE_LIMIT_CHUNK = 64 * 1024;
+    
+    // Guards the memtable pointers, the table set and the fields below them
+    mutable std::shared_mutex mutex_;
+    std::condition_variable_any cv_;
+    std::shared_ptr<MemTable> mem_;  // Takes the writes
+    std::shared_ptr<MemTable> imm_;  // Full, being written out; null if none
+    std::vector<TableList> levels_;  // Level 0 oldest first; deeper levels sorted by key, disjoint
+    std::vector<std::string> compactPointers_;  // Per level: largest key last pushed down
+    LSMCompactionOptions options_;
+    LSMCompactionStats stats_;
     int memtableSize_;
-    int count_;
-    mutable int size_;
+    std::atomic<int> size_;
+    std::atomic<uint64_t> sequence_;
+    std::string directory_;
+    bool ownsDirectory_;
+    std::atomic<uint64_t> nextFileNumber_;
+    bool flushRunning_;
+    bool compactionRunning_;
+    bool compactionFailed_;
+    bool closing_;
+    
+    // Lookup counters; updated without the lock
+    mutable std::atomic<uint64_t> tableLookups_;
+    mutable std::atomic<uint64_t> tablesProbed_;
+    mutable std::atomic<uint64_t> fenceSkips_;
+    mutable std::atomic<uint64_t> bloomSkips_;
+    mutable std::atomic<uint64_t> bloomFalsePositives_;
+    
+    // Memtables; makeRoomForWrite() takes the lock itself, the rest expect it held
+    void makeRoomForWrite();
+    void backgroundFlush();
+    bool flushImmutable(ExclusiveLock& lock, bool unlockWhileWriting);
+    bool flushAll(ExclusiveLock& lock);
+    bool writeMemTable(const MemTable& memtable, bool dropTombstones, uint64_t number,
+                       std::shared_ptr<SSTable>& table) const;
+    
+    // Compaction; everything but runCompaction() expects the lock to be held exclusively
+    void maybeScheduleCompaction();
+    void backgroundCompaction();
+    bool pickCompaction(Compaction& compaction) const;
+    bool pickLeveledCompaction(Compaction& compaction) const;
+    bool pickSizeTieredCompaction(Compaction& compaction) const;
+    bool findTier(size_t from, size_t& begin, size_t& end) const;
+    bool runCompaction(const Compaction& compaction, TableList& outputs, LSMCompactionStats& work);
+    void installCompaction(const Compaction& compaction, const TableList& outputs, const LSMCompactionStats& work);
+    uint64_t maxBytesForLevel(int level) const;
+    uint64_t levelBytes(int level) const;
+    TableList overlappingTables(int level, std::string_view smallest, std::string_view largest) const;
+    void sortLevel(int level);
+    bool hasTables() const;
+    
+    void openTables();
+    bool saveManifest() const;
+    std::shared_ptr<SSTable> openTable(const std::string& path, uint64_t number, int level) const;
+    std::string tablePath(uint64_t number) const;
+    void removeTable(const std::shared_ptr<SSTable>& table) const;
+    std::vector<TableList> allRuns() const;
+    
+    // Lookups below the active memtable: the immutable memtable, then the tables
+    SSTableLookup searchBelow(const std::string& encodedKey, std::string& value) const;
+    SSTableLookup searchTables(const std::string& encodedKey, std::string& value) const;
     
-    void flushMemtable();
-    std::shared_ptr<SSTable> mergeSSTables(const std::shared_ptr<SSTable>& sst1, 
-                                           const std::shared_ptr<SSTable>& sst2) const;
-    void compact();
+    /**
+     * @brief Stream the merged contents of several sorted runs in key order
+     * 
+     * A run is one table or a level of tables with disjoint key ranges.
+     * Where runs hold the same key, the newest one wins.
+     * 
+     * @param runs The runs, oldest first
+     * @param dropTombstones Skip tombstones (nothing older remains to shadow)
+     * @param sink Called with key, value and tombstone flag; false stops the merge
+     * @return false if a table is corrupt or the sink stopped the merge
+     */
+    template<typename Sink>
+    static bool mergeTables(const std::vector<TableList>& runs, bool dropTombstones, Sink sink);
 };
 
 // Implementation
 template<typename Key, typename Value>
-LSMTREE<Key, Value>::LSMTREE(int memtableSize) : memtableSize_(memtableSize), count_(0), size_(0) {}
+const int LSMTREE<Key, Value>::DEFAULT_MEMTABLE_SIZE;
 
 template<typename Key, typename Value>
-LSMTREE<Key, Value>::~LSMTREE() {}
+LSMTREE<Key, Value>::LSMTREE(int memtableSize, const std::string& directory, const LSMCompactionOptions& options)
+    : mem_(std::make_shared<MemTable>()), options_(options), memtableSize_(std::max(memtableSize, 1)),
+      size_(0), sequence_(1), directory_(directory), ownsDirectory_(directory.empty()),
+      nextFileNumber_(1), flushRunning_(false), compactionRunning_(false), compactionFailed_(false),
+      closing_(false), tableLookups_(0), tablesProbed_(0), fenceSkips_(0), bloomSkips_(0),
+      bloomFalsePositives_(0) {
+    int levels = options_.style == LSMCompactionStyle::LEVELED ? std::max(options_.maxLevels, 2) : 1;
+    levels_.resize(levels);
+    compactPointers_.resize(levels);
+    if (ownsDirectory_) {
+        directory_ = createTemporaryTableDirectory("phantomdb_lsm_");
+    } else {
+        std::error_code ec;
+        std::filesystem::create_directories(directory_, ec);
+        openTables();
+    }
+}
+
+template<typename Key, typename Value>
+LSMTREE<Key, Value>::~LSMTREE() {
+    ExclusiveLock lock(mutex_);
+    closing_ = true;
+    cv_.wait(lock, [this] { return !flushRunning_ && !compactionRunning_; });
+    if (ownsDirectory_) {
+        levels_.clear();
+        std::error_code ec;
+        std::filesystem::remove_all(directory_, ec);
+    } else {
+        flushAll(lock);
+    }
+}
 
 template<typename Key, typename Value>
 void LSMTREE<Key, Value>::insert(const Key& key, const Value& value) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    memtable_[key] = value;
-    count_++;
+    std::string encodedKey = LSMCodec<Key>::encode(key);
+    std::string encodedValue = LSMCodec<Value>::encode(value);
+    SharedLock lock(mutex_);
+    mem_->add(sequence_++, encodedKey, encodedValue, false);
     size_++;
     
-    // Check if memtable needs to be flushed
-    if (memtable_.size() >= memtableSize_) {
-        flushMemtable();
+    // Flush when full
+    if (mem_->getEntryCount() >= static_cast<size_t>(memtableSize_)) {
+        lock.unlock();
+        makeRoomForWrite();
     }
 }
 
 template<typename Key, typename Value>
 bool LSMTREE<Key, Value>::search(const Key& key, Value& value) const {
-    std::lock_guard<std::mutex> lock(mtx_);
+    std::string encodedKey = LSMCodec<Key>::encode(key);
+    std::string encoded;
+    SharedLock lock(mutex_);
     
-    // First check memtable
-    auto it = memtable_.find(key);
-    if (it != memtable_.end()) {
-        value = it->second;
-        return true;
+    // First check memtable, then what lies below it, newest first
+    SSTableLookup result = mem_->get(encodedKey, encoded);
+    if (result == SSTableLookup::NOT_FOUND) {
+        result = searchBelow(encodedKey, encoded);
+    }
+    lock.unlock();
+    return result == SSTableLookup::FOUND && LSMCodec<Value>::decode(encoded, value);
+}
+
+template<typename Key, typename Value>
+bool LSMTREE<Key, Value>::remove(const Key& key) {
+    std::string encodedKey = LSMCodec<Key>::encode(key);
+    SharedLock lock(mutex_);
+    std::string value;
+    SSTableLookup state = mem_->get(encodedKey, value);
+    if (state == SSTableLookup::NOT_FOUND) {
+        state = searchBelow(encodedKey, value);
+    }
+    if (state != SSTableLookup::FOUND) {
+        return false;
     }
     
-    // Then check SSTables in reverse order (newest first)
-    for (auto rit = sstables_.rbegin(); rit != sstables_.rend(); ++rit) {
-        auto sst_it = (*rit)->data.find(key);
-        if (sst_it != (*rit)->data.end()) {
-            value = sst_it->second;
-            return true;
+    // Only a tombstone hides values below the memtable; with nothing
+    // below, the flush drops it
+    mem_->add(sequence_++, encodedKey, std::string_view(), true);
+    if (mem_->getEntryCount() >= static_cast<size_t>(memtableSize_)) {
+        lock.unlock();
+        makeRoomForWrite();
+    }
+    return true;
+}
+
+template<typename Key, typename Value>
+int LSMTREE<Key, Value>::getSize() const {
+    return size_;
+}
+
+template<typename Key, typename Value>
+int LSMTREE<Key, Value>::getCount() const {
+    // Keys in the memtables count by their newest version there; the
+    // tables only add keys the memtables do not hold
+    std::map<std::string, bool> recent;
+    std::vector<TableList> runs;
+    {
+        SharedLock lock(mutex_);
+        for (const auto& memtable : {imm_, mem_}) {
+            if (!memtable) {
+                continue;
+            }
+            std::string previous;
+            bool first = true;
+            for (auto it = memtable->begin(); it.valid(); it.next()) {
+                if (first || it.key() != previous) {
+                    previous.assign(it.key().data(), it.key().size());
+                    recent[previous] = !it.isTombstone();
+                    first = false;
+                }
+            }
         }
+        runs = allRuns();
     }
     
-    return false;
+    int count = 0;
+    for (const auto& entry : recent) {
+        count += entry.second ? 1 : 0;
+    }
+    auto next = recent.begin();
+    mergeTables(runs, true, [&](std::string_view key, std::string_view, bool) {
+        while (next != recent.end() && std::string_view(next->first) < key) {
+            ++next;
+        }
+        if (next == recent.end() || next->first != key) {
+            count++;
+        }
+        return true;
+    });
+    return count;
 }
 
 template<typename Key, typename Value>
-bool LSMTREE<Key, Value>::remove(const Key& key) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    bool removed = false;
+bool LSMTREE<Key, Value>::flush() {
+    ExclusiveLock lock(mutex_);
+    cv_.wait(lock, [this] { return !flushRunning_; });
+    return flushAll(lock);
+}
+
+template<typename Key, typename Value>
+bool LSMTREE<Key, Value>::waitForCompactions() {
+    ExclusiveLock lock(mutex_);
+    compactionFailed_ = false;
+    while (true) {
+        cv_.wait(lock, [this] { return !flushRunning_ && !compactionRunning_; });
+        Compaction compaction;
+        if (closing_ || compactionFailed_ || !pickCompaction(compaction)) {
+            return !compactionFailed_;
+        }
+        maybeScheduleCompaction();
+    }
+}
+
+template<typename Key, typename Value>
+size_t LSMTREE<Key, Value>::getTableCount() const {
+    SharedLock lock(mutex_);
+    size_t count = 0;
+    for (const auto& level : levels_) {
+        count += level.size();
+    }
+    return count;
+}
+
+template<typename Key, typename Value>
+size_t LSMTREE<Key, Value>::getTableCount(int level) const {
+    SharedLock lock(mutex_);
+    return level >= 0 && level < static_cast<int>(levels_.size()) ? levels_[level].size() : 0;
+}
+
+template<typename Key, typename Value>
+uint64_t LSMTREE<Key, Value>::getDiskUsage() const {
+    SharedLock lock(mutex_);
+    uint64_t bytes = 0;
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        bytes += levelBytes(static_cast<int>(level));
+    }
+    return bytes;
+}
+
+template<typename Key, typename Value>
+size_t LSMTREE<Key, Value>::getMemoryUsage() const {
+    SharedLock lock(mutex_);
+    return mem_->getMemoryUsage() + (imm_ ? imm_->getMemoryUsage() : 0);
+}
+
+template<typename Key, typename Value>
+LSMCompactionStats LSMTREE<Key, Value>::getCompactionStats() const {
+    SharedLock lock(mutex_);
+    LSMCompactionStats stats = stats_;
+    stats.pendingCompactionBytes = 0;
+    if (options_.style == LSMCompactionStyle::LEVELED) {
+        // Level 0 once it triggers, and every level's overflow
+        if (levels_[0].size() >= options_.level0CompactionTrigger) {
+            stats.pendingCompactionBytes += levelBytes(0);
+        }
+        for (int level = 1; level + 1 < static_cast<int>(levels_.size()); ++level) {
+            uint64_t bytes = levelBytes(level);
+            if (bytes > maxBytesForLevel(level)) {
+                stats.pendingCompactionBytes += bytes - maxBytesForLevel(level);
+            }
+        }
+    } else {
+        // Every run of tables that is ready to merge
+        size_t begin = 0, end = 0;
+        for (size_t from = 0; findTier(from, begin, end); from = end) {
+            for (size_t i = begin; i < end; ++i) {
+                stats.pendingCompactionBytes += levels_[0][i]->reader.getFileSize();
+            }
+        }
+    }
+    return stats;
+}
+
+template<typename Key, typename Value>
+LSMLookupStats LSMTREE<Key, Value>::getLookupStats() const {
+    LSMLookupStats stats;
+    stats.lookups = tableLookups_.load(std::memory_order_relaxed);
+    stats.tablesProbed = tablesProbed_.load(std::memory_order_relaxed);
+    stats.fenceSkips = fenceSkips_.load(std::memory_order_relaxed);
+    stats.bloomSkips = bloomSkips_.load(std::memory_order_relaxed);
+    stats.bloomFalsePositives = bloomFalsePositives_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+template<typename Key, typename Value>
+const LSMCompactionOptions& LSMTREE<Key, Value>::getCompactionOptions() const {
+    return options_;
+}
+
+template<typename Key, typename Value>
+const std::string& LSMTREE<Key, Value>::getDirectory() const {
+    return directory_;
+}
+
+template<typename Key, typename Value>
+SSTableLookup LSMTREE<Key, Value>::searchBelow(const std::string& encodedKey, std::string& value) const {
+    if (imm_) {
+        SSTableLookup result = imm_->get(encodedKey, value);
+        if (result != SSTableLookup::NOT_FOUND) {
+            return result;
+        }
+    }
+    // Bloom filters keep this from reading blocks for most absent keys
+    return searchTables(encodedKey, value);
+}
+
+template<typename Key, typename Value>
+SSTableLookup LSMTREE<Key, Value>::searchTables(const std::string& encodedKey, std::string& value) const {
+    if (!hasTables()) {
+        return SSTableLookup::NOT_FOUND;
+    }
+    
+    // Counted locally and published once per lookup
+    LSMLookupStats probes;
+    SSTableLookup result = SSTableLookup::NOT_FOUND;
+    std::string_view key(encodedKey);
+    auto probe = [&](const SSTable& table) {
+        if (!table.reader.inKeyRange(key)) {
+            probes.fenceSkips++;
+            return false;
+        }
+        if (!table.reader.mayContain(key)) {
+            probes.bloomSkips++;
+            return false;
+        }
+        probes.tablesProbed++;
+        result = table.reader.get(key, value, false);
+        if (result == SSTableLookup::NOT_FOUND && table.reader.hasBloomFilter()) {
+            probes.bloomFalsePositives++;
+        }
+        return result != SSTableLookup::NOT_FOUND;
+    };
     
-    // Remove from memtable
-    auto it = memtable_.find(key);
-    if (it != memtable_.end()) {
-        memtable_.erase(it);
-        removed = true;
-        count_--;
+    // Level 0 tables may overlap: newest first
+    bool done = false;
+    for (auto rit = levels_[0].rbegin(); !done && rit != levels_[0].rend(); ++rit) {
+        done = probe(**rit);
     }
     
-    // Mark as deleted in SSTables (in a real implementation, we would add tombstones)
-    for (auto& sst : sstables_) {
-        auto sst_it = sst->data.find(key);
-        if (sst_it != sst->data.end()) {
-            // In a real implementation, we would mark with a tombstone
-            // For simplicity, we'll just note that it was found
-            removed = true;
+    // Deeper levels hold at most one table covering the key; the fence
+    // keys find it, and a level with none is skipped outright
+    for (size_t level = 1; !done && level < levels_.size(); ++level) {
+        const TableList& tables = levels_[level];
+        if (tables.empty()) {
+            continue;
+        }
+        auto it = std::lower_bound(tables.begin(), tables.end(), key,
+            [](const std::shared_ptr<SSTable>& table, std::string_view k) {
+                return table->reader.getLargestKey() < k;
+            });
+        if (it == tables.end() || (*it)->reader.getSmallestKey() > key) {
+            probes.fenceSkips++;
+        } else {
+            done = probe(**it);
         }
     }
     
-    return removed;
+    tableLookups_.fetch_add(1, std::memory_order_relaxed);
+    if (probes.tablesProbed > 0) {
+        tablesProbed_.fetch_add(probes.tablesProbed, std::memory_order_relaxed);
+    }
+    if (probes.fenceSkips > 0) {
+        fenceSkips_.fetch_add(probes.fenceSkips, std::memory_order_relaxed);
+    }
+    if (probes.bloomSkips > 0) {
+        bloomSkips_.fetch_add(probes.bloomSkips, std::memory_order_relaxed);
+    }
+    if (probes.bloomFalsePositives > 0) {
+        bloomFalsePositives_.fetch_add(probes.bloomFalsePositives, std::memory_order_relaxed);
+    }
+    return result;
 }
 
 template<typename Key, typename Value>
-int LSMTREE<Key, Value>::getSize() const {
-    std::lock_guard<std::mutex> lock(mtx_);
-    return size_;
+void LSMTREE<Key, Value>::makeRoomForWrite() {
+    ExclusiveLock lock(mutex_);
+    auto start = std::chrono::steady_clock::now();
+    bool stalled = false;
+    while (!closing_ && mem_->getEntryCount() >= static_cast<size_t>(memtableSize_)) {
+        // Level 0 is searched table by table, so writers wait rather than
+        // let it grow without bound while a merge into level 1 is running
+        bool level0Full = options_.style == LSMCompactionStyle::LEVELED && compactionRunning_ &&
+                          levels_[0].size() >= options_.level0StopWritesTrigger;
+        if (flushRunning_ || level0Full) {
+            stalled = true;
+            cv_.wait(lock);
+        } else if (imm_) {
+            // Left over from a failed flush; the writer retries it
+            if (!flushImmutable(lock, false)) {
+                break;
+            }
+        } else {
+            imm_ = mem_;
+            mem_ = std::make_shared<MemTable>();
+            if (options_.background) {
+                flushRunning_ = true;
+                LSMCompactionScheduler::instance().schedule([this] { backgroundFlush(); }, true);
+            } else {
+                flushImmutable(lock, false);
+            }
+        }
+    }
+    if (stalled) {
+        stats_.writeStalls++;
+        stats_.stallMicros += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
 }
 
 template<typename Key, typename Value>
-int LSMTREE<Key, Value>::getCount() const {
-    std::lock_guard<std::mutex> lock(mtx_);
-    return count_;
+void LSMTREE<Key, Value>::backgroundFlush() {
+    ExclusiveLock lock(mutex_);
+    flushImmutable(lock, true);
+    flushRunning_ = false;
+    cv_.notify_all();
 }
 
 template<typename Key, typename Value>
-void LSMTREE<Key, Value>::flushMemtable() {
-    // Create a new SSTable from current memtable
-    auto sstable = std::make_shared<SSTable>();
-    sstable->data = memtable_;
-    sstable->level = 0;
+bool LSMTREE<Key, Value>::flushImmutable(ExclusiveLock& lock, bool unlockWhileWriting) {
+    // With no older tables there is nothing for a tombstone to hide, so
+    // tombstones are dropped. Only this flush can add the first table.
+    std::shared_ptr<MemTable> immutable = imm_;
+    bool dropTombstones = !hasTables();
+    uint64_t number = nextFileNumber_++;
+    std::shared_ptr<SSTable> sstable;
+    if (unlockWhileWriting) {
+        lock.unlock();
+    }
+    bool ok = writeMemTable(*immutable, dropTombstones, number, sstable);
+    if (unlockWhileWriting) {
+        lock.lock();
+    }
+    if (!ok) {
+        // Keep the memtable; the next write that needs room tries again
+        std::cerr << "Failed to flush LSM-tree memtable to " << tablePath(number) << std::endl;
+        return false;
+    }
     
-    // Clear memtable
-    memtable_.clear();
+    imm_.reset();
+    if (sstable) {
+        levels_[0].push_back(sstable);
+        stats_.flushes++;
+        stats_.bytesFlushed += sstable->reader.getFileSize();
+        saveManifest();
+        
+        // Trigger compaction if needed
+        maybeScheduleCompaction();
+    }
+    return true;
+}
+
+template<typename Key, typename Value>
+bool LSMTREE<Key, Value>::flushAll(ExclusiveLock& lock) {
+    if (imm_ && !flushImmutable(lock, false)) {
+        return false;
+    }
+    if (mem_->getEntryCount() == 0) {
+        return true;
+    }
+    imm_ = mem_;
+    mem_ = std::make_shared<MemTable>();
+    return flushImmutable(lock, false);
+}
+
+template<typename Key, typename Value>
+bool LSMTREE<Key, Value>::writeMemTable(const MemTable& memtable, bool dropTombstones, uint64_t number,
+                                       std::shared_ptr<SSTable>& table) const {
+    // Write the newest version of every key, in key order
+    std::string path = tablePath(number);
+    SSTableWriter writer;
+    bool ok = writer.open(path, SSTableWriter::DEFAULT_BLOCK_SIZE, options_.bloomBitsPerKey, options_.bloomLayout,
+                          options_.frontCoding);
+    std::string_view previous;
+    bool first = true;
+    for (auto it = memtable.begin(); ok && it.valid(); it.next()) {
+        if (!first && it.key() == previous) {
+            continue;
+        }
+        first = false;
+        previous = it.key();
+        if (!(it.isTombstone() && dropTombstones)) {
+            ok = writer.add(it.key(), it.value(), it.isTombstone());
+        }
+    }
     
-    // Add to SSTables
-    sstables_.push_back(sstable);
+    if (ok && writer.getEntryCount() == 0) {
+        // Nothing left worth a file
+        writer.abort();
+        return true;
+    }
+    if (!ok || !writer.finish()) {
+        return false;
+    }
+    table = openTable(path, number, 0);
+    return table != nullptr;
+}
+
+template<typename Key, typename Value>
+void LSMTREE<Key, Value>::maybeScheduleCompaction() {
+    if (closing_ || compactionRunning_) {
+        return;
+    }
+    Compaction compaction;
+    if (!options_.background) {
+        // Merge inline, holding the lock throughout
+        while (pickCompaction(compaction)) {
+            TableList outputs;
+            LSMCompactionStats work;
+            if (!compaction.trivialMove && !runCompaction(compaction, outputs, work)) {
+                compactionFailed_ = true;
+                return;
+            }
+            installCompaction(compaction, outputs, work);
+            compaction = Compaction();
+        }
+        return;
+    }
+    if (pickCompaction(compaction)) {
+        compactionRunning_ = true;
+        LSMCompactionScheduler::instance().schedule([this] { backgroundCompaction(); });
+    }
+}
+
+template<typename Key, typename Value>
+void LSMTREE<Key, Value>::backgroundCompaction() {
+    ExclusiveLock lock(mutex_);
+    Compaction compaction;
+    if (!closing_ && pickCompaction(compaction)) {
+        TableList outputs;
+        LSMCompactionStats work;
+        bool ok = true;
+        if (!compaction.trivialMove) {
+            // The inputs are immutable and stay listed until the merge is
+            // installed, so readers and flushes carry on meanwhile
+            lock.unlock();
+            ok = runCompaction(compaction, outputs, work);
+            lock.lock();
+        }
+        if (ok) {
+            installCompaction(compaction, outputs, work);
+        } else {
+            compactionFailed_ = true;
+            std::cerr << "LSM-tree compaction failed in " << directory_ << std::endl;
+        }
+        
+        // One merge per job so trees take turns on the workers
+        compactionRunning_ = false;
+        if (ok) {
+            maybeScheduleCompaction();
+        }
+    } else {
+        compactionRunning_ = false;
+    }
+    cv_.notify_all();
+}
+
+template<typename Key, typename Value>
+bool LSMTREE<Key, Value>::pickCompaction(Compaction& compaction) const {
+    if (options_.style == LSMCompactionStyle::LEVELED) {
+        return pickLeveledCompaction(compaction);
+    }
+    return pickSizeTieredCompaction(compaction);
+}
+
+template<typename Key, typename Value>
+bool LSMTREE<Key, Value>::pickLeveledCompaction(Compaction& compaction) const {
+    // Score each level against its budget; the last level has no budget
+    int lastLevel = static_cast<int>(levels_.size()) - 1;
+    int best = 0;
+    double bestScore = static_cast<double>(levels_[0].size()) / std::max<size_t>(options_.level0CompactionTrigger, 1);
+    for (int level = 1; level < lastLevel; ++level) {
+        double score = static_cast<double>(levelBytes(level)) / maxBytesForLevel(level);
+        if (score > bestScore) {
+            best = level;
+            bestScore = score;
+        }
+    }
+    if (bestScore < 1.0 || levels_[best].empty()) {
+        return false;
+    }
+    
+    compaction.level = best;
+    compaction.outputLevel = best + 1;
+    TableList inputs;
+    if (best == 0) {
+        // Level 0 tables overlap, so all of them go down together
+        inputs = levels_[0];
+    } else {
+        // Take turns through the key space, starting after the last table pushed down
+        const TableList& tables = levels_[best];
+        const std::string& pointer = compactPointers_[best];
+        auto it = std::find_if(tables.begin(), tables.end(), [&pointer](const std::shared_ptr<SSTable>& table) {
+            return table->reader.getSmallestKey() > pointer;
+        });
+        inputs.push_back(it != tables.end() ? *it : tables.front());
+    }
+    
+    std::string_view smallest = inputs.front()->reader.getSmallestKey();
+    std::string_view largest = inputs.front()->reader.getLargestKey();
+    for (const auto& table : inputs) {
+        smallest = std::min(smallest, table->reader.getSmallestKey());
+        largest = std::max(largest, table->reader.getLargestKey());
+    }
+    TableList overlapping = overlappingTables(compaction.outputLevel, smallest, largest);
+    
+    if (best > 0 && overlapping.empty()) {
+        compaction.trivialMove = true;
+        compaction.runs.push_back(inputs);
+        return true;
+    }
+    
+    // The next level is older than anything above it
+    if (!overlapping.empty()) {
+        compaction.runs.push_back(overlapping);
+    }
+    for (const auto& table : inputs) {
+        compaction.runs.push_back(TableList{table});
+    }
+    compaction.dropTombstones = true;
+    for (int level = compaction.outputLevel + 1; level <= lastLevel; ++level) {
+        compaction.dropTombstones = compaction.dropTombstones && overlappingTables(level, smallest, largest).empty();
+    }
+    return true;
+}
+
+template<typename Key, typename Value>
+bool LSMTREE<Key, Value>::pickSizeTieredCompaction(Compaction& compaction) const {
+    // Of all runs of similarly sized tables, merge the one with the smallest tables
+    size_t begin = 0, end = 0;
+    bool found = false;
+    double bestAverage = 0.0;
+    for (size_t from = 0; findTier(from, begin, end); from = begin + 1) {
+        uint64_t bytes = 0;
+        for (size_t i = begin; i < end; ++i) {
+            bytes += levels_[0][i]->reader.getFileSize();
+        }
+        double average = static_cast<double>(bytes) / (end - begin);
+        if (!found || average < bestAverage) {
+            found = true;
+            bestAverage = average;
+            compaction.tierBegin = begin;
+            compaction.tierEnd = end;
+        }
+    }
+    if (!found) {
+        return false;
+    }
     
-    // Trigger compaction if needed
-    compact();
+    for (size_t i = compaction.tierBegin; i < compaction.tierEnd; ++i) {
+        compaction.runs.push_back(TableList{levels_[0][i]});
+    }
+    compaction.level = 0;
+    compaction.outputLevel = 0;
+    // Only a run that includes the oldest table has nothing older to shadow
+    compaction.dropTombstones = compaction.tierBegin == 0;
+    for (size_t level = 1; level < levels_.size(); ++level) {
+        compaction.dropTombstones = compaction.dropTombstones && levels_[level].empty();
+    }
+    return true;
+}
+
+template<typename Key, typename Value>
+bool LSMTREE<Key, Value>::findTier(size_t from, size_t& begin, size_t& end) const {
+    // Tables must be adjacent in age so the merged table can take their place
+    const TableList& tables = levels_[0];
+    for (begin = from; begin < tables.size(); ++begin) {
+        uint64_t bytes = tables[begin]->reader.getFileSize();
+        for (end = begin + 1; end < tables.size() && end - begin < options_.maxMergeWidth; ++end) {
+            double average = static_cast<double>(bytes) / (end - begin);
+            double size = static_cast<double>(tables[end]->reader.getFileSize());
+            if (size < average * options_.bucketLow || size > average * options_.bucketHigh) {
+                break;
+            }
+            bytes += tables[end]->reader.getFileSize();
+        }
+        if (end - begin >= std::max<size_t>(options_.minMergeWidth, 2)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 template<typename Key, typename Value>
-std::shared_ptr<typename LSMTREE<Key, Value>::SSTable> 
-LSMTREE<Key, Value>::mergeSSTables(const std::shared_ptr<SSTable>& sst1, 
-                                  const std::shared_ptr<SSTable>& sst2) const {
-    auto merged = std::make_shared<SSTable>();
-    merged->level = std::max(sst1->level, sst2->level) + 1;
+bool LSMTREE<Key, Value>::runCompaction(const Compaction& compaction, TableList& outputs,
+                                       LSMCompactionStats& work) {
+    // Leveled output is cut into tables of about targetFileSize so later
+    // merges only rewrite the part of a level they overlap
+    uint64_t splitSize = options_.style == LSMCompactionStyle::LEVELED ? options_.targetFileSize : 0;
+    CompactionRateLimiter& limiter = LSMCompactionScheduler::instance().getRateLimiter();
+    SSTableWriter writer;
+    std::string path;
+    uint64_t number = 0;
+    uint64_t charged = 0;
+    bool writing = false;
+    
+    auto finishOutput = [&]() {
+        writing = false;
+        limiter.request(writer.getDataSize() - charged);
+        charged = 0;
+        auto table = writer.finish() ? openTable(path, number, compaction.outputLevel) : nullptr;
+        if (!table) {
+            return false;
+        }
+        outputs.push_back(table);
+        return true;
+    };
     
-    // Merge the two SSTables
-    auto it1 = sst1->data.begin();
-    auto it2 = sst2->data.begin();
+    bool ok = mergeTables(compaction.runs, compaction.dropTombstones,
+        [&](std::string_view key, std::string_view value, bool tombstone) {
+            if (!writing) {
+                number = nextFileNumber_++;
+                path = tablePath(number);
+                if (!writer.open(path, SSTableWriter::DEFAULT_BLOCK_SIZE, options_.bloomBitsPerKey,
+                                 options_.bloomLayout, options_.frontCoding)) {
+                    return false;
+                }
+                writing = true;
+            }
+            if (!writer.add(key, value, tombstone)) {
+                return false;
+            }
+            uint64_t written = writer.getDataSize();
+            if (written - charged >= RATE_LIMIT_CHUNK) {
+                limiter.request(written - charged);
+                charged = written;
+            }
+            return splitSize == 0 || written < splitSize || finishOutput();
+        });
+    if (ok && writing) {
+        ok = finishOutput();
+    }
+    if (!ok) {
+        writer.abort();
+        for (const auto& table : outputs) {
+            removeTable(table);
+        }
+        outputs.clear();
+        return false;
+    }
     
-    while (it1 != sst1->data.end() && it2 != sst2->data.end()) {
-        if (it1->first <= it2->first) {
-            merged->data[it1->first] = it1->second;
-            ++it1;
+    uint64_t entriesIn = 0, entriesOut = 0;
+    for (const auto& run : compaction.runs) {
+        for (const auto& table : run) {
+            work.bytesRead += table->reader.getFileSize();
+            entriesIn += table->reader.getEntryCount();
+        }
+    }
+    for (const auto& table : outputs) {
+        work.bytesWritten += table->reader.getFileSize();
+        entriesOut += table->reader.getEntryCount();
+    }
+    work.entriesDropped = entriesIn - entriesOut;
+    return true;
+}
+
+template<typename Key, typename Value>
+void LSMTREE<Key, Value>::installCompaction(const Compaction& compaction, const TableList& outputs,
+                                           const LSMCompactionStats& work) {
+    TableList inputs;
+    for (const auto& run : compaction.runs) {
+        inputs.insert(inputs.end(), run.begin(), run.end());
+    }
+    auto isInput = [&inputs](const std::shared_ptr<SSTable>& table) {
+        return std::find(inputs.begin(), inputs.end(), table) != inputs.end();
+    };
+    
+    if (compaction.level == compaction.outputLevel) {
+        // Size-tiered: the merged table takes the place of its inputs.
+        // Flushes only append, so the positions still hold.
+        TableList& tables = levels_[0];
+        tables.erase(tables.begin() + compaction.tierBegin, tables.begin() + compaction.tierEnd);
+        tables.insert(tables.begin() + compaction.tierBegin, outputs.begin(), outputs.end());
+    } else {
+        // Leveled: the last run is the table pushed down from above level 0
+        if (compaction.level > 0) {
+            compactPointers_[compaction.level] = std::string(compaction.runs.back().front()->reader.getLargestKey());
+        }
+        for (int level : {compaction.level, compaction.outputLevel}) {
+            TableList& tables = levels_[level];
+            tables.erase(std::remove_if(tables.begin(), tables.end(), isInput), tables.end());
+        }
+        TableList& output = levels_[compaction.outputLevel];
+        if (compaction.trivialMove) {
+            inputs.front()->level = compaction.outputLevel;
+            output.push_back(inputs.front());
         } else {
-            merged->data[it2->first] = it2->second;
-            ++it2;
+            output.insert(output.end(), outputs.begin(), outputs.end());
         }
+        sortLevel(compaction.outputLevel);
     }
     
-    // Add remaining elements
-    while (it1 != sst1->data.end()) {
-        merged->data[it1->first] = it1->second;
-        ++it1;
+    if (compaction.trivialMove) {
+        stats_.trivialMoves++;
+    } else {
+        stats_.compactions++;
+        stats_.bytesRead += work.bytesRead;
+        stats_.bytesWritten += work.bytesWritten;
+        stats_.entriesDropped += work.entriesDropped;
+    }
+    
+    // Drop the inputs only once the manifest no longer lists them
+    if (!saveManifest()) {
+        return;
+    }
+    if (!compaction.trivialMove) {
+        for (const auto& table : inputs) {
+            removeTable(table);
+        }
+    }
+}
+
+template<typename Key, typename Value>
+uint64_t LSMTREE<Key, Value>::maxBytesForLevel(int level) const {
+    double bytes = static_cast<double>(options_.maxBytesForLevelBase);
+    for (int i = 1; i < level; ++i) {
+        bytes *= options_.levelSizeMultiplier;
+    }
+    return static_cast<uint64_t>(bytes);
+}
+
+template<typename Key, typename Value>
+uint64_t LSMTREE<Key, Value>::levelBytes(int level) const {
+    uint64_t bytes = 0;
+    for (const auto& table : levels_[level]) {
+        bytes += table->reader.getFileSize();
+    }
+    return bytes;
+}
+
+template<typename Key, typename Value>
+typename LSMTREE<Key, Value>::TableList
+LSMTREE<Key, Value>::overlappingTables(int level, std::string_view smallest, std::string_view largest) const {
+    TableList overlapping;
+    const TableList& tables = levels_[level];
+    auto it = std::lower_bound(tables.begin(), tables.end(), smallest,
+        [](const std::shared_ptr<SSTable>& table, std::string_view k) {
+            return table->reader.getLargestKey() < k;
+        });
+    for (; it != tables.end() && (*it)->reader.getSmallestKey() <= largest; ++it) {
+        overlapping.push_back(*it);
+    }
+    return overlapping;
+}
+
+template<typename Key, typename Value>
+void LSMTREE<Key, Value>::sortLevel(int level) {
+    std::sort(levels_[level].begin(), levels_[level].end(),
+        [](const std::shared_ptr<SSTable>& a, const std::shared_ptr<SSTable>& b) {
+            return a->reader.getSmallestKey() < b->reader.getSmallestKey();
+        });
+}
+
+template<typename Key, typename Value>
+bool LSMTREE<Key, Value>::hasTables() const {
+    for (const auto& level : levels_) {
+        if (!level.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename Key, typename Value>
+std::string LSMTREE<Key, Value>::tablePath(uint64_t number) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%08llu.sst", static_cast<unsigned long long>(number));
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+template<typename Key, typename Value>
+std::shared_ptr<typename LSMTREE<Key, Value>::SSTable>
+LSMTREE<Key, Value>::openTable(const std::string& path, uint64_t number, int level) const {
+    auto sstable = std::make_shared<SSTable>();
+    sstable->number = number;
+    sstable->level = level;
+    if (!sstable->reader.open(path)) {
+        return nullptr;
+    }
+    return sstable;
+}
+
+template<typename Key, typename Value>
+void LSMTREE<Key, Value>::removeTable(const std::shared_ptr<SSTable>& table) const {
+    // Unmap first: Windows won't delete a mapped file
+    std::string path = table->reader.getPath();
+    table->reader.close();
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+template<typename Key, typename Value>
+bool LSMTREE<Key, Value>::saveManifest() const {
+    // A temporary tree is never reopened
+    if (ownsDirectory_) {
+        return true;
+    }
+    LSMManifest manifest;
+    manifest.nextFileNumber = nextFileNumber_;
+    for (const auto& level : levels_) {
+        for (const auto& table : level) {
+            manifest.tables.push_back(LSMManifest::Table{table->number, table->level});
+        }
+    }
+    return manifest.save(directory_);
+}
+
+template<typename Key, typename Value>
+void LSMTREE<Key, Value>::openTables() {
+    // Table files are "<number>.sst"; trees written before the manifest
+    // existed named them "<sequence>-L<level>.sst"
+    struct Found {
+        uint64_t number;
+        int level;
+        std::string path;
+    };
+    std::vector<Found> found;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_, ec)) {
+        std::string name = entry.path().filename().string();
+        unsigned long long number;
+        int level = 0;
+        int consumed = 0;
+        if (entry.path().extension() == ".tmp") {
+            std::filesystem::remove(entry.path(), ec); // An interrupted flush, merge or manifest update
+            continue;
+        }
+        bool table = std::sscanf(name.c_str(), "%llu.sst%n", &number, &consumed) == 1 &&
+                     consumed == static_cast<int>(name.size());
+        if (!table) {
+            consumed = 0;
+            table = std::sscanf(name.c_str(), "%llu-L%d.sst%n", &number, &level, &consumed) == 2 &&
+                    consumed == static_cast<int>(name.size());
+        }
+        if (table) {
+            found.push_back(Found{number, level, entry.path().string()});
+        }
     }
     
-    while (it2 != sst2->data.end()) {
-        merged->data[it2->first] = it2->second;
-        ++it2;
+    LSMManifest manifest;
+    bool hasManifest = std::filesystem::exists(std::filesystem::path(directory_) / LSMManifest::FILE_NAME);
+    if (hasManifest && manifest.load(directory_)) {
+        // Files the manifest does not list are leftovers of an interrupted
+        // flush or of a merge whose inputs were not yet removed
+        for (const auto& file : found) {
+            auto listed = std::find_if(manifest.tables.begin(), manifest.tables.end(),
+                [&file](const LSMManifest::Table& table) { return table.number == file.number; });
+            if (listed == manifest.tables.end() || file.path != tablePath(file.number)) {
+                std::filesystem::remove(file.path, ec);
+            }
+        }
+        nextFileNumber_ = manifest.nextFileNumber;
+        for (const auto& table : manifest.tables) {
+            if (table.level >= static_cast<int>(levels_.size())) {
+                levels_.resize(table.level + 1);
+                compactPointers_.resize(table.level + 1);
+            }
+            auto sstable = openTable(tablePath(table.number), table.number, table.level);
+            if (sstable) {
+                levels_[table.level].push_back(sstable);
+            } else {
+                std::cerr << "Skipping unreadable LSM-tree table: " << tablePath(table.number) << std::endl;
+            }
+            nextFileNumber_ = std::max<uint64_t>(nextFileNumber_, table.number + 1);
+        }
+        for (size_t level = 1; level < levels_.size(); ++level) {
+            sortLevel(static_cast<int>(level));
+        }
+    } else {
+        if (hasManifest) {
+            std::cerr << "Reopening LSM-tree tables in " << directory_ << " by file number" << std::endl;
+        }
+        
+        // Without a manifest every table goes to level 0, oldest first. A
+        // merge interrupted before removing its inputs leaves the merged
+        // table and its newer input with the same sequence; the merged one,
+        // being older, goes first. Tables are renumbered in that order.
+        std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) {
+            return a.number != b.number ? a.number < b.number : a.level > b.level;
+        });
+        std::vector<std::string> renamed;
+        for (const auto& file : found) {
+            uint64_t number = nextFileNumber_++;
+            std::string path = tablePath(number);
+            if (path != file.path) {
+                std::filesystem::rename(file.path, path, ec);
+                if (ec) {
+                    path = file.path;
+                }
+            }
+            auto sstable = openTable(path, number, 0);
+            if (sstable) {
+                levels_[0].push_back(sstable);
+            } else {
+                std::cerr << "Skipping unreadable LSM-tree table: " << path << std::endl;
+            }
+        }
+        if (!found.empty()) {
+            saveManifest();
+        }
     }
     
-    return merged;
+    size_ = getCount();
+}
+
+template<typename Key, typename Value>
+std::vector<typename LSMTREE<Key, Value>::TableList> LSMTREE<Key, Value>::allRuns() const {
+    // Oldest first: the deepest level, up to level 1, then level 0 table by table
+    std::vector<TableList> runs;
+    for (size_t level = levels_.size() - 1; level >= 1; --level) {
+        if (!levels_[level].empty()) {
+            runs.push_back(levels_[level]);
+        }
+    }
+    for (const auto& table : levels_[0]) {
+        runs.push_back(TableList{table});
+    }
+    return runs;
 }
 
 template<typename Key, typename Value>
-void LSMTREE<Key, Value>::compact() {
-    // Simple compaction strategy: merge SSTables when we have too many
-    const int COMPACTION_THRESHOLD = 4;
+template<typename Sink>
+bool LSMTREE<Key, Value>::mergeTables(const std::vector<TableList>& runs, bool dropTombstones, Sink sink) {
+    // A cursor over one run; tables of a run follow each other in key order
+    struct Cursor {
+        const TableList* run;
+        size_t table;
+        SSTableReader::Iterator iterator;
+        bool ok;
+        
+        bool valid() const {
+            return iterator.valid();
+        }
+        
+        void settle() {
+            while (!iterator.valid()) {
+                ok = ok && iterator.ok();
+                if (++table >= run->size()) {
+                    return;
+                }
+                iterator = (*run)[table]->reader.begin();
+            }
+        }
+        
+        void next() {
+            iterator.next();
+            settle();
+        }
+    };
+    
+    std::vector<Cursor> cursors;
+    cursors.reserve(runs.size());
+    for (const auto& run : runs) {
+        if (!run.empty()) {
+            cursors.push_back(Cursor{&run, 0, run.front()->reader.begin(), true});
+            cursors.back().settle();
+        }
+    }
     
-    if (sstables_.size() >= COMPACTION_THRESHOLD) {
-        // Merge the oldest SSTables
-        auto sst1 = sstables_.front();
-        sstables_.pop_front();
-        auto sst2 = sstables_.front();
-        sstables_.pop_front();
+    // Min-heap on the key; among equal keys the newest run comes first
+    auto later = [&cursors](size_t a, size_t b) {
+        int order = cursors[a].iterator.key().compare(cursors[b].iterator.key());
+        return order != 0 ? order > 0 : a < b;
+    };
+    std::vector<size_t> heap;
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        if (cursors[i].valid()) {
+            heap.push_back(i);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+    
+    auto advance = [&]() {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        Cursor& cursor = cursors[heap.back()];
+        cursor.next();
+        if (cursor.valid()) {
+            std::push_heap(heap.begin(), heap.end(), later);
+        } else {
+            heap.pop_back();
+        }
+    };
+    
+    std::string key;
+    while (!heap.empty()) {
+        const Cursor& newest = cursors[heap.front()];
+        if (!(dropTombstones && newest.iterator.isTombstone()) &&
+            !sink(newest.iterator.key(), newest.iterator.value(), newest.iterator.isTombstone())) {
+            return false;
+        }
         
-        auto merged = mergeSSTables(sst1, sst2);
-        sstables_.push_back(merged);
+        // Move past the key in every run. Front-coded tables rebuild keys
+        // inside their iterators, so the key is copied before they move on.
+        key.assign(newest.iterator.key().data(), newest.iterator.key().size());
+        do {
+            advance();
+        } while (!heap.empty() && cursors[heap.front()].iterator.key() == key);
+    }
+    
+    for (const auto& cursor : cursors) {
+        if (!cursor.ok) {
+            return false;
+        }
     }
+    return true;
 }
 
 } // namespace storage
 } // namespace phantomdb
 
-#endif // PHANTOMDB_LSM_TREE_H
\ No newline at end of file
+#endif // PHANTOMDB_LSM_TREE_H
@@ -2,6 +2,12 @@
 #include <iostream>
 #include <cassert>
 #include <string>
+#include <filesystem>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <thread>
 
 using namespace phantomdb::storage;
 
@@ -92,6 +98,460 @@ void testSizeAndCount() {
     std::cout << "Size and count test passed!" << std::endl;
 }
 
+void testTombstones() {
+    std::cout << "Testing tombstones..." << std::endl;
+    
+    LSMTREE<int, std::string> lsmTree(4);
+    for (int i = 0; i < 20; ++i) {
+        lsmTree.insert(i, "value" + std::to_string(i));
+    }
+    assert(lsmTree.getTableCount() > 0);
+    
+    // Keys already flushed to disk are hidden by a tombstone
+    assert(lsmTree.remove(3));
+    assert(lsmTree.remove(17));
+    assert(!lsmTree.remove(3));
+    assert(!lsmTree.remove(100));
+    assert(lsmTree.getCount() == 18);
+    
+    // Push the tombstones through flushes and compactions
+    for (int i = 20; i < 60; ++i) {
+        lsmTree.insert(i, "value" + std::to_string(i));
+    }
+    std::string value;
+    assert(!lsmTree.search(3, value));
+    assert(!lsmTree.search(17, value));
+    assert(lsmTree.search(4, value) && value == "value4");
+    
+    // A removed key can come back
+    lsmTree.insert(3, "again");
+    assert(lsmTree.search(3, value) && value == "again");
+    assert(lsmTree.getCount() == 59);
+    
+    std::cout << "Tombstones test passed!" << std::endl;
+}
+
+void testNewestVersionWins() {
+    std::cout << "Testing newest version across tables..." << std::endl;
+    
+    LSMTREE<std::string, std::string> lsmTree(8);
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 8; ++i) {
+            lsmTree.insert("key" + std::to_string(i), "round" + std::to_string(round));
+        }
+    }
+    
+    // Every round was flushed and the tables merged repeatedly
+    assert(lsmTree.waitForCompactions());
+    assert(lsmTree.getTableCount() < 10);
+    for (int i = 0; i < 8; ++i) {
+        std::string value;
+        assert(lsmTree.search("key" + std::to_string(i), value));
+        assert(value == "round9");
+    }
+    assert(lsmTree.getCount() == 8);
+    
+    // Overwriting keys that are in the tables never reads them
+    LSMLookupStats before = lsmTree.getLookupStats();
+    for (int i = 0; i < 8; ++i) {
+        lsmTree.insert("key" + std::to_string(i), "round10");
+    }
+    assert(lsmTree.getLookupStats().lookups == before.lookups);
+    assert(lsmTree.getCount() == 8);
+    
+    std::cout << "Newest version test passed!" << std::endl;
+}
+
+void testDiskTables() {
+    std::cout << "Testing disk-backed tables..." << std::endl;
+    
+    const std::string directory = "./lsm_tree_test_data";
+    std::filesystem::remove_all(directory);
+    {
+        LSMTREE<int, std::string> lsmTree(100, directory);
+        for (int i = -5000; i < 5000; ++i) {
+            lsmTree.insert(i, "value" + std::to_string(i));
+        }
+        for (int i = 0; i < 100; ++i) {
+            assert(lsmTree.remove(i * 7));
+        }
+        
+        // Most of the data lives in files, not the memtable
+        assert(lsmTree.getDiskUsage() > 100000);
+        assert(lsmTree.getTableCount() >= 1);
+        
+        std::string value;
+        assert(lsmTree.search(-5000, value) && value == "value-5000");
+        assert(lsmTree.search(4999, value) && value == "value4999");
+        assert(!lsmTree.search(7, value));
+        assert(!lsmTree.search(5000, value));
+    }
+    
+    // Reopening the directory finds the same data, memtable included
+    {
+        LSMTREE<int, std::string> lsmTree(100, directory);
+        assert(lsmTree.getCount() == 9900);
+        std::string value;
+        assert(lsmTree.search(-1, value) && value == "value-1");
+        assert(lsmTree.search(8, value) && value == "value8");
+        assert(!lsmTree.search(693, value));
+    }
+    std::filesystem::remove_all(directory);
+    
+    // A temporary tree cleans up after itself
+    std::string temporary;
+    {
+        LSMTREE<int, int> lsmTree(10);
+        temporary = lsmTree.getDirectory();
+        for (int i = 0; i < 100; ++i) {
+            lsmTree.insert(i, i * i);
+        }
+        int value = 0;
+        assert(lsmTree.search(9, value) && value == 81);
+        assert(std::filesystem::exists(temporary));
+    }
+    assert(!std::filesystem::exists(temporary));
+    
+    std::cout << "Disk-backed tables test passed!" << std::endl;
+}
+
+void testLeveledCompaction() {
+    std::cout << "Testing leveled compaction..." << std::endl;
+    
+    const std::string directory = "./lsm_tree_leveled_data";
+    std::filesystem::remove_all(directory);
+    LSMCompactionOptions options;
+    options.targetFileSize = 16 * 1024;
+    options.maxBytesForLevelBase = 64 * 1024;
+    options.levelSizeMultiplier = 4;
+    
+    std::vector<int> keys(20000);
+    for (int i = 0; i < 20000; ++i) {
+        keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    std::vector<size_t> levels;
+    {
+        LSMTREE<int, std::string> lsmTree(200, directory, options);
+        for (int key : keys) {
+            lsmTree.insert(key, "value" + std::to_string(key));
+        }
+        for (int i = 0; i < 20000; i += 10) {
+            lsmTree.insert(i, "updated" + std::to_string(i));
+            assert(lsmTree.remove(i + 1));
+        }
+        assert(lsmTree.waitForCompactions());
+        
+        // Level 0 drained below its trigger and data moved several levels down
+        assert(lsmTree.getTableCount(0) < options.level0CompactionTrigger);
+        assert(lsmTree.getTableCount(2) > 0);
+        for (int level = 0; level < options.maxLevels; ++level) {
+            levels.push_back(lsmTree.getTableCount(level));
+        }
+        
+        LSMCompactionStats stats = lsmTree.getCompactionStats();
+        assert(stats.compactions > 0);
+        assert(stats.entriesDropped > 0);
+        assert(stats.writeAmplification() > 1.0);
+        assert(stats.pendingCompactionBytes == 0);
+        assert(lsmTree.getCount() == 18000);
+        
+        std::string value;
+        assert(lsmTree.search(0, value) && value == "updated0");
+        assert(!lsmTree.search(1, value));
+        assert(lsmTree.search(19999, value) && value == "value19999");
+    }
+    
+    // The manifest puts every table back at its level
+    {
+        LSMTREE<int, std::string> lsmTree(200, directory, options);
+        for (int level = 0; level < options.maxLevels; ++level) {
+            assert(lsmTree.getTableCount(level) == levels[level]);
+        }
+        assert(lsmTree.getCount() == 18000);
+        std::string value;
+        for (int i = 0; i < 20000; i += 97) {
+            bool found = lsmTree.search(i, value);
+            if (i % 10 == 1) {
+                assert(!found);
+            } else {
+                assert(found && value == (i % 10 == 0 ? "updated" : "value") + std::to_string(i));
+            }
+        }
+    }
+    std::filesystem::remove_all(directory);
+    
+    std::cout << "Leveled compaction test passed!" << std::endl;
+}
+
+void testSizeTieredCompaction() {
+    std::cout << "Testing size-tiered compaction..." << std::endl;
+    
+    LSMCompactionOptions options;
+    options.style = LSMCompactionStyle::SIZE_TIERED;
+    options.background = false;
+    LSMTREE<int, int> lsmTree(100, "", options);
+    for (int i = 0; i < 6400; ++i) {
+        lsmTree.insert(i, i);
+    }
+    
+    // 64 flushes of equal size merge into tiers of 4, 16 and 64 tables
+    LSMCompactionStats stats = lsmTree.getCompactionStats();
+    assert(stats.flushes == 64);
+    assert(stats.compactions == 21);
+    assert(lsmTree.getTableCount() == 1);
+    assert(stats.pendingCompactionBytes == 0);
+    
+    // Removing everything leaves tombstones until they reach the oldest table
+    for (int i = 0; i < 6400; ++i) {
+        assert(lsmTree.remove(i));
+    }
+    assert(lsmTree.flush());
+    assert(lsmTree.getCount() == 0);
+    int value;
+    assert(!lsmTree.search(1234, value));
+    
+    std::cout << "Size-tiered compaction test passed!" << std::endl;
+}
+
+void testInlineTombstoneCompaction() {
+    std::cout << "Testing tombstones merged away..." << std::endl;
+    
+    LSMCompactionOptions options;
+    options.background = false;
+    LSMTREE<int, int> lsmTree(100, "", options);
+    for (int i = 0; i < 1000; ++i) {
+        lsmTree.insert(i, i);
+    }
+    uint64_t fullSize = lsmTree.getDiskUsage();
+    for (int i = 0; i < 1000; ++i) {
+        assert(lsmTree.remove(i));
+    }
+    assert(lsmTree.flush());
+    
+    // Merging into the bottom level drops the values and their tombstones
+    LSMCompactionStats stats = lsmTree.getCompactionStats();
+    assert(stats.entriesDropped >= 2000);
+    assert(lsmTree.getDiskUsage() < fullSize);
+    assert(lsmTree.getCount() == 0);
+    
+    std::cout << "Tombstone compaction test passed!" << std::endl;
+}
+
+void testFrontCodedTables() {
+    std::cout << "Testing front-coded tables..." << std::endl;
+    
+    // The same URL-like keys, written to plain and to front-coded tables
+    auto url = [](int i) {
+        return "https://shop.example.com/tenants/" + std::to_string(i % 20) + "/orders/" + std::to_string(i);
+    };
+    const std::string directory = "./lsm_tree_front_coded_data";
+    std::filesystem::remove_all(directory);
+    LSMCompactionOptions plainOptions;
+    plainOptions.background = false;
+    LSMCompactionOptions frontCodedOptions = plainOptions;
+    frontCodedOptions.frontCoding = true;
+    uint64_t plainSize = 0;
+    {
+        LSMTREE<std::string, std::string> plain(500, "", plainOptions);
+        LSMTREE<std::string, std::string> frontCoded(500, directory, frontCodedOptions);
+        for (int i = 0; i < 20000; ++i) {
+            plain.insert(url(i), std::to_string(i));
+            frontCoded.insert(url(i), std::to_string(i));
+        }
+        for (int i = 0; i < 20000; i += 10) {
+            assert(frontCoded.remove(url(i)));
+        }
+        assert(plain.flush() && frontCoded.flush());
+        plainSize = plain.getDiskUsage();
+        
+        // Merges read and write front-coded tables, tombstones included
+        assert(frontCoded.getCompactionStats().compactions > 0);
+        std::string value;
+        assert(frontCoded.search(url(1), value) && value == "1");
+        assert(frontCoded.search(url(19999), value) && value == "19999");
+        assert(!frontCoded.search(url(10), value));
+        assert(!frontCoded.search(url(20000), value));
+        assert(!frontCoded.search("https://shop.example.com/tenants/3/orders/", value));
+        assert(frontCoded.getCount() == 18000);
+    }
+    
+    // Reopened tables are recognised as front-coded and found again
+    {
+        LSMTREE<std::string, std::string> frontCoded(500, directory, frontCodedOptions);
+        assert(frontCoded.getCount() == 18000);
+        std::string value;
+        assert(frontCoded.search(url(12345), value) && value == "12345");
+        assert(!frontCoded.search(url(12340), value));
+        
+        // Shared prefixes are stored once per restart, so the tables shrink
+        assert(frontCoded.getDiskUsage() * 2 < plainSize);
+    }
+    std::filesystem::remove_all(directory);
+    
+    std::cout << "Front-coded tables test passed!" << std::endl;
+}
+
+void testCompactionRateLimiter() {
+    std::cout << "Testing compaction rate limiter..." << std::endl;
+    
+    CompactionRateLimiter limiter;
+    limiter.setBytesPerSecond(1024 * 1024);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 9; ++i) {
+        limiter.request(64 * 1024);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    
+    // The first request goes straight through, each later one waits 1/16 s
+    assert(elapsed >= std::chrono::milliseconds(450));
+    
+    limiter.setBytesPerSecond(0);
+    start = std::chrono::steady_clock::now();
+    limiter.request(1ull << 40);
+    assert(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100));
+    
+    std::cout << "Compaction rate limiter test passed!" << std::endl;
+}
+
+void testMemTable() {
+    std::cout << "Testing skiplist memtable..." << std::endl;
+    
+    MemTable memtable;
+    auto added = memtable.add(1, "b", "one", false);
+    assert(added.newest && !added.hasOlder);
+    added = memtable.add(2, "b", "two", false);
+    assert(added.newest && added.hasOlder && added.olderLive);
+    added = memtable.add(3, "a", "", true);
+    assert(added.newest && !added.hasOlder);
+    
+    // An older version linked after a newer one replaces nothing
+    added = memtable.add(0, "b", "zero", false);
+    assert(!added.newest);
+    
+    std::string value;
+    assert(memtable.get("b", value) == SSTableLookup::FOUND && value == "two");
+    assert(memtable.get("a", value) == SSTableLookup::DELETED);
+    assert(memtable.get("c", value) == SSTableLookup::NOT_FOUND);
+    assert(memtable.getEntryCount() == 4);
+    
+    // Key order, newest version first
+    std::vector<std::pair<std::string, uint64_t>> order;
+    for (auto it = memtable.begin(); it.valid(); it.next()) {
+        order.emplace_back(std::string(it.key()), it.sequence());
+    }
+    std::vector<std::pair<std::string, uint64_t>> expected = {{"a", 3}, {"b", 2}, {"b", 1}, {"b", 0}};
+    assert(order == expected);
+    
+    std::cout << "Skiplist memtable test passed!" << std::endl;
+}
+
+void testConcurrentAccess() {
+    std::cout << "Testing concurrent inserts and lookups..." << std::endl;
+    
+    // A small memtable keeps flushes and compactions running under the writers
+    LSMTREE<int, std::string> lsmTree(256);
+    const int threads = 4;
+    const int perThread = 5000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&lsmTree, t] {
+            std::string value;
+            for (int i = 0; i < perThread; ++i) {
+                int key = i * threads + t;
+                lsmTree.insert(key, "value" + std::to_string(key));
+                assert(lsmTree.search(key, value) && value == "value" + std::to_string(key));
+                
+                // Everyone overwrites and removes the same shared keys
+                lsmTree.insert(-(i % 100) - 1, "shared");
+                if (i % 7 == 0) {
+                    lsmTree.remove(-(i % 100) - 1);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    assert(lsmTree.waitForCompactions());
+    
+    int shared = 0;
+    std::string value;
+    for (int key = -100; key < 0; ++key) {
+        shared += lsmTree.search(key, value) ? 1 : 0;
+    }
+    for (int key = 0; key < threads * perThread; ++key) {
+        assert(lsmTree.search(key, value) && value == "value" + std::to_string(key));
+    }
+    assert(lsmTree.getCount() == threads * perThread + shared);
+    assert(lsmTree.getTableCount() > 0);
+    
+    std::cout << "Concurrent access test passed!" << std::endl;
+}
+
+void testBloomFilters() {
+    std::cout << "Testing bloom filters and fence keys..." << std::endl;
+    
+    std::string directory = createTemporaryTableDirectory("phantomdb_bloom_test_");
+    auto falsePositiveRate = [&directory](BloomFilterLayout layout, int bitsPerKey) {
+        std::string path = directory + "/filter.sst";
+        SSTableWriter writer;
+        assert(writer.open(path, SSTableWriter::DEFAULT_BLOCK_SIZE, bitsPerKey, layout));
+        for (int i = 0; i < 20000; ++i) {
+            assert(writer.add(LSMCodec<int>::encode(i * 2), "v"));
+        }
+        assert(writer.finish());
+        
+        SSTableReader reader;
+        assert(reader.open(path));
+        assert(reader.hasBloomFilter() == (bitsPerKey > 0));
+        for (int i = 0; i < 20000; ++i) {
+            assert(reader.mayContain(LSMCodec<int>::encode(i * 2)));
+        }
+        int positives = 0;
+        for (int i = 0; i < 20000; ++i) {
+            positives += reader.mayContain(LSMCodec<int>::encode(i * 2 + 1)) ? 1 : 0;
+        }
+        assert(reader.inKeyRange(LSMCodec<int>::encode(1)));
+        assert(!reader.inKeyRange(LSMCodec<int>::encode(40000)));
+        return positives / 20000.0;
+    };
+    
+    double standard = falsePositiveRate(BloomFilterLayout::STANDARD, 10);
+    double blocked = falsePositiveRate(BloomFilterLayout::BLOCKED, 10);
+    double blockedLarge = falsePositiveRate(BloomFilterLayout::BLOCKED, 16);
+    assert(standard < 0.02);
+    assert(blocked < 0.025);
+    assert(blockedLarge < blocked);
+    assert(falsePositiveRate(BloomFilterLayout::BLOCKED, 0) == 1.0);
+    std::filesystem::remove_all(directory);
+    
+    // Absent keys inside the range are stopped by the filters, keys past
+    // it by the fence keys
+    LSMCompactionOptions options;
+    options.background = false;
+    options.bloomBitsPerKey = 12;
+    LSMTREE<int, std::string> lsmTree(1000, "", options);
+    for (int i = 0; i < 10000; ++i) {
+        lsmTree.insert(i * 2, "value");
+    }
+    assert(lsmTree.flush());
+    LSMLookupStats before = lsmTree.getLookupStats();
+    std::string value;
+    for (int i = 0; i < 10000; ++i) {
+        assert(!lsmTree.search(i * 2 + 1, value));
+        assert(!lsmTree.search(100000 + i, value));
+    }
+    LSMLookupStats stats = lsmTree.getLookupStats();
+    assert(stats.lookups - before.lookups == 20000);
+    assert(stats.fenceSkips - before.fenceSkips >= 10000);
+    assert(stats.bloomSkips > stats.bloomFalsePositives * 20);
+    assert(stats.bloomFalsePositiveRate() < 0.05);
+    assert(stats.tablesSkipped() == stats.fenceSkips + stats.bloomSkips);
+    
+    std::cout << "Bloom filter test passed!" << std::endl;
+}
+
 int main() {
     std::cout << "Running LSM-tree tests..." << std::endl;
     
@@ -99,6 +559,17 @@ int main() {
     testMemtableFlush();
     testUpdate();
     testSizeAndCount();
+    testTombstones();
+    testNewestVersionWins();
+    testDiskTables();
+    testLeveledCompaction();
+    testSizeTieredCompaction();
+    testInlineTombstoneCompaction();
+    testFrontCodedTables();
+    testCompactionRateLimiter();
+    testMemTable();
+    testConcurrentAccess();
+    testBloomFilters();
     
     std::cout << "All LSM-tree tests passed!" << std::endl;
     return 0;
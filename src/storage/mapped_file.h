@@ -0,0 +1,44 @@
+#ifndef PHANTOMDB_MAPPED_FILE_H
+#define PHANTOMDB_MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * Read-only memory mapping of a whole file. Pages are read in by the OS
+ * as they are touched, so opening costs the same for any file size and
+ * the bytes are shared with the page cache instead of copied.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the file at path; false if it is missing, empty or cannot be mapped
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;     // HANDLEs, kept opaque so windows.h stays out of headers
+    void* mappingHandle_ = nullptr;
+#endif
+};
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_MAPPED_FILE_H
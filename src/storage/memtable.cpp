@@ -0,0 +1,277 @@
+#include "memtable.h"
+#include <algorithm>
+#include <new>
+#include <random>
+#include <thread>
+#include <cstring>
+#include <cstddef>
+
+namespace phantomdb {
+namespace storage {
+
+namespace {
+
+const size_t ALIGNMENT = alignof(std::max_align_t) < 8 ? 8 : alignof(std::max_align_t);
+
+size_t alignUp(size_t bytes) {
+    return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+} // anonymous namespace
+
+struct Arena::Block {
+    std::atomic<size_t> used;
+    size_t size;
+    char* data;
+};
+
+Arena::Arena(size_t blockSize)
+    : blockSize_(std::max<size_t>(blockSize, 4096)), current_(nullptr), memoryUsage_(0) {
+    current_.store(newBlock(blockSize_));
+}
+
+Arena::~Arena() {
+    for (Block* block : blocks_) {
+        ::operator delete(block->data);
+        delete block;
+    }
+}
+
+Arena::Block* Arena::newBlock(size_t size) {
+    Block* block = new Block;
+    block->used.store(0);
+    block->size = size;
+    block->data = static_cast<char*>(::operator new(size));
+    blocks_.push_back(block);
+    memoryUsage_ += size;
+    return block;
+}
+
+char* Arena::allocate(size_t bytes) {
+    bytes = alignUp(std::max<size_t>(bytes, 1));
+    
+    // Large requests get a block of their own so the current one keeps its tail
+    if (bytes > blockSize_ / 4) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return newBlock(bytes)->data;
+    }
+    
+    while (true) {
+        Block* block = current_.load(std::memory_order_acquire);
+        size_t offset = block->used.fetch_add(bytes, std::memory_order_relaxed);
+        if (offset + bytes <= block->size) {
+            return block->data + offset;
+        }
+        
+        // The block is full; the first thread here replaces it
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (current_.load(std::memory_order_relaxed) == block) {
+            current_.store(newBlock(blockSize_), std::memory_order_release);
+        }
+    }
+}
+
+size_t Arena::getMemoryUsage() const {
+    return memoryUsage_.load(std::memory_order_relaxed);
+}
+
+/**
+ * Node layout in the arena: this header, one link per level of the node,
+ * then the key and value bytes.
+ */
+struct MemTable::Node {
+    uint64_t sequence;
+    uint32_t keyLength;
+    uint32_t valueLength;
+    int height;
+    bool tombstone;
+    
+    static size_t linkOffset() {
+        return alignUp(sizeof(Node));
+    }
+    
+    std::atomic<Node*>& next(int level) {
+        return reinterpret_cast<std::atomic<Node*>*>(reinterpret_cast<char*>(this) + linkOffset())[level];
+    }
+    
+    const std::atomic<Node*>& next(int level) const {
+        return reinterpret_cast<const std::atomic<Node*>*>(reinterpret_cast<const char*>(this) + linkOffset())[level];
+    }
+    
+    const char* payload() const {
+        return reinterpret_cast<const char*>(this) + linkOffset() + height * sizeof(std::atomic<Node*>);
+    }
+    
+    std::string_view key() const {
+        return std::string_view(payload(), keyLength);
+    }
+    
+    std::string_view value() const {
+        return std::string_view(payload() + keyLength, valueLength);
+    }
+    
+    // Lay out a node with its links cleared; the caller copies the payload
+    static Node* create(char* memory, uint64_t sequence, size_t keyLength, size_t valueLength,
+                        int height, bool tombstone) {
+        Node* node = new (memory) Node;
+        node->sequence = sequence;
+        node->keyLength = static_cast<uint32_t>(keyLength);
+        node->valueLength = static_cast<uint32_t>(valueLength);
+        node->height = height;
+        node->tombstone = tombstone;
+        for (int i = 0; i < height; ++i) {
+            new (&node->next(i)) std::atomic<Node*>(nullptr);
+        }
+        return node;
+    }
+};
+
+MemTable::MemTable(size_t arenaBlockSize)
+    : arena_(arenaBlockSize), head_(nullptr), maxHeight_(1), entryCount_(0) {
+    char* memory = arena_.allocate(Node::linkOffset() + MAX_HEIGHT * sizeof(std::atomic<Node*>));
+    head_ = Node::create(memory, 0, 0, 0, MAX_HEIGHT, false);
+}
+
+MemTable::~MemTable() = default;
+
+int MemTable::randomHeight() {
+    // Each level holds a quarter of the nodes of the one below
+    thread_local std::minstd_rand generator(
+        static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+    int height = 1;
+    while (height < MAX_HEIGHT && (generator() & 3) == 0) {
+        height++;
+    }
+    return height;
+}
+
+bool MemTable::before(const Node* a, std::string_view key, uint64_t sequence) {
+    int order = a->key().compare(key);
+    return order < 0 || (order == 0 && a->sequence > sequence);
+}
+
+MemTable::AddResult MemTable::add(uint64_t sequence, std::string_view key, std::string_view value, bool tombstone) {
+    if (tombstone) {
+        value = std::string_view();
+    }
+    int height = randomHeight();
+    size_t headerBytes = Node::linkOffset() + height * sizeof(std::atomic<Node*>);
+    char* memory = arena_.allocate(headerBytes + key.size() + value.size());
+    Node* node = Node::create(memory, sequence, key.size(), value.size(), height, tombstone);
+    // Empty views may have a null data() (tombstones always do), which
+    // memcpy must not be given even for zero bytes
+    if (!key.empty()) {
+        std::memcpy(memory + headerBytes, key.data(), key.size());
+    }
+    if (!value.empty()) {
+        std::memcpy(memory + headerBytes + key.size(), value.data(), value.size());
+    }
+    
+    int maxHeight = maxHeight_.load(std::memory_order_relaxed);
+    while (height > maxHeight && !maxHeight_.compare_exchange_weak(maxHeight, height)) {
+    }
+    maxHeight = std::max(maxHeight, height);
+    
+    // Find the neighbours on every level, top down
+    Node* prev[MAX_HEIGHT];
+    Node* next[MAX_HEIGHT];
+    Node* x = head_;
+    for (int level = maxHeight - 1; level >= 0; --level) {
+        Node* n = x->next(level).load(std::memory_order_acquire);
+        while (n != nullptr && before(n, key, sequence)) {
+            x = n;
+            n = x->next(level).load(std::memory_order_acquire);
+        }
+        prev[level] = x;
+        next[level] = n;
+    }
+    
+    // Link bottom up. A failed CAS means a writer slipped a node in next
+    // to ours; search again from our predecessor on that level.
+    AddResult result{true, false, false};
+    for (int level = 0; level < height; ++level) {
+        while (true) {
+            node->next(level).store(next[level], std::memory_order_relaxed);
+            if (prev[level]->next(level).compare_exchange_strong(next[level], node, std::memory_order_release,
+                                                                 std::memory_order_acquire)) {
+                break;
+            }
+            x = prev[level];
+            Node* n = x->next(level).load(std::memory_order_acquire);
+            while (n != nullptr && before(n, key, sequence)) {
+                x = n;
+                n = x->next(level).load(std::memory_order_acquire);
+            }
+            prev[level] = x;
+            next[level] = n;
+        }
+        
+        // Versions of a key are adjacent, so the level 0 neighbours at the
+        // moment of linking tell what this version replaced
+        if (level == 0) {
+            result.newest = prev[0] == head_ || prev[0]->key() != key;
+            result.hasOlder = next[0] != nullptr && next[0]->key() == key;
+            result.olderLive = result.hasOlder && !next[0]->tombstone;
+        }
+    }
+    entryCount_.fetch_add(1, std::memory_order_relaxed);
+    return result;
+}
+
+SSTableLookup MemTable::get(std::string_view key, std::string& value) const {
+    // The first node not before (key, newest possible sequence)
+    Node* x = head_;
+    Node* n = nullptr;
+    for (int level = maxHeight_.load(std::memory_order_acquire) - 1; level >= 0; --level) {
+        n = x->next(level).load(std::memory_order_acquire);
+        while (n != nullptr && before(n, key, UINT64_MAX)) {
+            x = n;
+            n = x->next(level).load(std::memory_order_acquire);
+        }
+    }
+    if (n == nullptr || n->key() != key) {
+        return SSTableLookup::NOT_FOUND;
+    }
+    if (n->tombstone) {
+        return SSTableLookup::DELETED;
+    }
+    value.assign(n->value().data(), n->value().size());
+    return SSTableLookup::FOUND;
+}
+
+MemTable::Iterator MemTable::begin() const {
+    Iterator it;
+    it.node_ = head_->next(0).load(std::memory_order_acquire);
+    return it;
+}
+
+size_t MemTable::getEntryCount() const {
+    return entryCount_.load(std::memory_order_relaxed);
+}
+
+size_t MemTable::getMemoryUsage() const {
+    return arena_.getMemoryUsage();
+}
+
+void MemTable::Iterator::next() {
+    node_ = static_cast<const Node*>(node_)->next(0).load(std::memory_order_acquire);
+}
+
+std::string_view MemTable::Iterator::key() const {
+    return static_cast<const Node*>(node_)->key();
+}
+
+std::string_view MemTable::Iterator::value() const {
+    return static_cast<const Node*>(node_)->value();
+}
+
+bool MemTable::Iterator::isTombstone() const {
+    return static_cast<const Node*>(node_)->tombstone;
+}
+
+uint64_t MemTable::Iterator::sequence() const {
+    return static_cast<const Node*>(node_)->sequence;
+}
+
+} // namespace storage
+} // namespace phantomdb
@@ -0,0 +1,139 @@
+#ifndef PHANTOMDB_MEMTABLE_H
+#define PHANTOMDB_MEMTABLE_H
+
+#include "sstable.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * @brief Bump allocator for memtable entries
+ * 
+ * Memory is carved out of large blocks and only released when the arena
+ * is destroyed. Allocation is thread safe; the common case is a single
+ * atomic add on the current block.
+ */
+class Arena {
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+    
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~Arena();
+    
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    
+    /**
+     * @brief Allocate bytes aligned for any scalar or pointer
+     */
+    char* allocate(size_t bytes);
+    
+    // Bytes reserved from the system, including unused block tails
+    size_t getMemoryUsage() const;
+
+private:
+    struct Block;
+    
+    Block* newBlock(size_t size);
+    
+    size_t blockSize_;
+    std::atomic<Block*> current_;
+    std::atomic<size_t> memoryUsage_;
+    std::mutex mutex_;  // Guards blocks_ and the switch to a new block
+    std::vector<Block*> blocks_;
+};
+
+/**
+ * @brief Concurrent skiplist memtable holding encoded keys and values
+ * 
+ * Entries are never changed in place: every write adds a node tagged with
+ * a sequence number, and nodes are ordered by key and then newest first,
+ * so a lookup finds the latest version of a key at the first node not
+ * before it. Readers follow the links without locks. Writers link a new
+ * node level by level with compare-and-swap and retry a level only if
+ * another writer linked a neighbour first. Nodes live in an Arena and
+ * are freed together with the memtable.
+ */
+class MemTable {
+public:
+    static const int MAX_HEIGHT = 12;
+    
+    // What add() found next to the new entry
+    struct AddResult {
+        bool newest;       // No newer version of the key is in the memtable
+        bool hasOlder;     // An older version of the key is in the memtable
+        bool olderLive;    // That older version is a value, not a tombstone
+    };
+    
+    // Walks the entries in key order, newest version of a key first
+    class Iterator {
+    public:
+        bool valid() const { return node_ != nullptr; }
+        void next();
+        
+        std::string_view key() const;
+        std::string_view value() const;
+        bool isTombstone() const;
+        uint64_t sequence() const;
+    
+    private:
+        friend class MemTable;
+        const void* node_ = nullptr;
+    };
+    
+    explicit MemTable(size_t arenaBlockSize = Arena::DEFAULT_BLOCK_SIZE);
+    ~MemTable();
+    
+    MemTable(const MemTable&) = delete;
+    MemTable& operator=(const MemTable&) = delete;
+    
+    /**
+     * @brief Add a version of a key; safe to call from several threads
+     * 
+     * @param sequence Orders versions of the same key; unique per memtable
+     * @param key The encoded key
+     * @param value The encoded value (ignored for a tombstone)
+     * @param tombstone Whether this version deletes the key
+     * @return The neighbours of the entry at the moment it was linked in
+     */
+    AddResult add(uint64_t sequence, std::string_view key, std::string_view value, bool tombstone);
+    
+    /**
+     * @brief Look up the newest version of a key
+     * 
+     * @return FOUND (value set), DELETED or NOT_FOUND
+     */
+    SSTableLookup get(std::string_view key, std::string& value) const;
+    
+    Iterator begin() const;
+    
+    // Versions added, counting every overwrite
+    size_t getEntryCount() const;
+    
+    size_t getMemoryUsage() const;
+
+private:
+    struct Node;
+    
+    int randomHeight();
+    
+    // Whether node a sorts before (key, sequence)
+    static bool before(const Node* a, std::string_view key, uint64_t sequence);
+    
+    Arena arena_;
+    Node* head_;
+    std::atomic<int> maxHeight_;
+    std::atomic<size_t> entryCount_;
+};
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_MEMTABLE_H
@@ -0,0 +1,661 @@
+#include "roaring_bitmap.h"
+#include <algorithm>
+#include <utility>
+#include <iterator>
+#include <initializer_list>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace phantomdb {
+namespace storage {
+
+const uint32_t RoaringBitmap::ARRAY_MAX_SIZE;
+const size_t RoaringBitmap::BITSET_WORDS;
+
+namespace {
+
+// Gallop through the larger array when it is this many times the smaller
+const size_t GALLOP_RATIO = 32;
+
+enum class WordOp {
+    AND,
+    OR,
+    ANDNOT
+};
+
+inline uint32_t popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_popcountll(word));
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<uint32_t>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline int lowestBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// out = a op b over count words; returns the bits set in out
+template<WordOp Op>
+uint32_t combineWords(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t count) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= count; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i result;
+        if (Op == WordOp::AND) {
+            result = _mm256_and_si256(x, y);
+        } else if (Op == WordOp::OR) {
+            result = _mm256_or_si256(x, y);
+        } else {
+            result = _mm256_andnot_si256(y, x);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    for (; i + 2 <= count; i += 2) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i result;
+        if (Op == WordOp::AND) {
+            result = _mm_and_si128(x, y);
+        } else if (Op == WordOp::OR) {
+            result = _mm_or_si128(x, y);
+        } else {
+            result = _mm_andnot_si128(y, x);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+    }
+#endif
+    for (; i < count; ++i) {
+        if (Op == WordOp::AND) {
+            out[i] = a[i] & b[i];
+        } else if (Op == WordOp::OR) {
+            out[i] = a[i] | b[i];
+        } else {
+            out[i] = a[i] & ~b[i];
+        }
+    }
+    
+    uint32_t bits = 0;
+    for (i = 0; i < count; ++i) {
+        bits += popcount64(out[i]);
+    }
+    return bits;
+}
+
+inline bool testBit(const std::vector<uint64_t>& words, uint16_t low) {
+    return (words[low >> 6] >> (low & 63)) & 1;
+}
+
+// Set bits first..last inclusive
+void setRange(std::vector<uint64_t>& words, uint32_t first, uint32_t last) {
+    for (uint32_t word = first >> 6; word <= (last >> 6); ++word) {
+        uint32_t from = word == (first >> 6) ? (first & 63) : 0;
+        uint32_t to = word == (last >> 6) ? (last & 63) : 63;
+        uint64_t mask = (to - from == 63) ? ~0ULL : (((1ULL << (to - from + 1)) - 1) << from);
+        words[word] |= mask;
+    }
+}
+
+void intersectArrays(const std::vector<uint16_t>& a, const std::vector<uint16_t>& b, std::vector<uint16_t>& out) {
+    const std::vector<uint16_t>& small = a.size() <= b.size() ? a : b;
+    const std::vector<uint16_t>& large = a.size() <= b.size() ? b : a;
+    out.reserve(small.size());
+    if (small.size() * GALLOP_RATIO >= large.size()) {
+        std::set_intersection(small.begin(), small.end(), large.begin(), large.end(), std::back_inserter(out));
+        return;
+    }
+    
+    // Everything before pos is below the current value; double the step
+    // until passing it, then binary search the last step
+    size_t pos = 0;
+    for (uint16_t value : small) {
+        size_t bound = 1;
+        while (pos + bound < large.size() && large[pos + bound] < value) {
+            bound *= 2;
+        }
+        size_t low = pos + bound / 2;
+        size_t high = std::min(pos + bound + 1, large.size());
+        pos = std::lower_bound(large.begin() + low, large.begin() + high, value) - large.begin();
+        if (pos == large.size()) {
+            break;
+        }
+        if (large[pos] == value) {
+            out.push_back(value);
+        }
+    }
+}
+
+} // anonymous namespace
+
+RoaringBitmap::RoaringBitmap() = default;
+
+RoaringBitmap::~RoaringBitmap() = default;
+
+size_t RoaringBitmap::findContainer(uint16_t key) const {
+    return std::lower_bound(keys_.begin(), keys_.end(), key) - keys_.begin();
+}
+
+void RoaringBitmap::normalize(Container& container) {
+    if (container.type == ContainerType::BITSET && container.cardinality <= ARRAY_MAX_SIZE) {
+        toArray(container);
+    } else if (container.type == ContainerType::ARRAY && container.cardinality > ARRAY_MAX_SIZE) {
+        toBitset(container);
+    }
+}
+
+void RoaringBitmap::toBitset(Container& container) {
+    std::vector<uint64_t> words(BITSET_WORDS, 0);
+    forEachInContainer(container, [&words](uint16_t low) {
+        words[low >> 6] |= 1ULL << (low & 63);
+    });
+    container.type = ContainerType::BITSET;
+    container.words = std::move(words);
+    container.values.clear();
+    container.values.shrink_to_fit();
+}
+
+void RoaringBitmap::toArray(Container& container) {
+    std::vector<uint16_t> values;
+    values.reserve(container.cardinality);
+    forEachInContainer(container, [&values](uint16_t low) {
+        values.push_back(low);
+    });
+    container.type = ContainerType::ARRAY;
+    container.values = std::move(values);
+    container.words.clear();
+    container.words.shrink_to_fit();
+}
+
+RoaringBitmap::Container RoaringBitmap::expand(const Container& container) {
+    Container result;
+    result.cardinality = container.cardinality;
+    if (container.cardinality <= ARRAY_MAX_SIZE) {
+        result.type = ContainerType::ARRAY;
+        result.values.reserve(container.cardinality);
+        forEachInContainer(container, [&result](uint16_t low) {
+            result.values.push_back(low);
+        });
+    } else {
+        result.type = ContainerType::BITSET;
+        result.words.assign(BITSET_WORDS, 0);
+        for (size_t i = 0; i < container.values.size(); i += 2) {
+            setRange(result.words, container.values[i], container.values[i] + container.values[i + 1]);
+        }
+    }
+    return result;
+}
+
+template<typename Fn>
+void RoaringBitmap::forEachInContainer(const Container& container, Fn fn) {
+    switch (container.type) {
+        case ContainerType::ARRAY:
+            for (uint16_t low : container.values) {
+                fn(low);
+            }
+            break;
+        case ContainerType::BITSET:
+            for (size_t word = 0; word < container.words.size(); ++word) {
+                for (uint64_t bits = container.words[word]; bits != 0; bits &= bits - 1) {
+                    fn(static_cast<uint16_t>(word * 64 + lowestBit(bits)));
+                }
+            }
+            break;
+        case ContainerType::RUN:
+            for (size_t i = 0; i < container.values.size(); i += 2) {
+                uint32_t last = static_cast<uint32_t>(container.values[i]) + container.values[i + 1];
+                for (uint32_t low = container.values[i]; low <= last; ++low) {
+                    fn(static_cast<uint16_t>(low));
+                }
+            }
+            break;
+    }
+}
+
+bool RoaringBitmap::containerContains(const Container& container, uint16_t low) {
+    switch (container.type) {
+        case ContainerType::ARRAY:
+            return std::binary_search(container.values.begin(), container.values.end(), low);
+        case ContainerType::BITSET:
+            return testBit(container.words, low);
+        case ContainerType::RUN: {
+            // The last run starting at or before low
+            size_t first = 0;
+            size_t count = container.values.size() / 2;
+            while (count > 0) {
+                size_t half = count / 2;
+                if (container.values[(first + half) * 2] <= low) {
+                    first += half + 1;
+                    count -= half + 1;
+                } else {
+                    count = half;
+                }
+            }
+            if (first == 0) {
+                return false;
+            }
+            size_t run = (first - 1) * 2;
+            return low <= static_cast<uint32_t>(container.values[run]) + container.values[run + 1];
+        }
+    }
+    return false;
+}
+
+RoaringBitmap::Container RoaringBitmap::intersectContainers(const Container& a, const Container& b) {
+    if (a.type == ContainerType::RUN) {
+        return intersectContainers(expand(a), b);
+    }
+    if (b.type == ContainerType::RUN) {
+        return intersectContainers(a, expand(b));
+    }
+    
+    Container result;
+    if (a.type == ContainerType::ARRAY && b.type == ContainerType::ARRAY) {
+        intersectArrays(a.values, b.values, result.values);
+    } else if (a.type == ContainerType::ARRAY || b.type == ContainerType::ARRAY) {
+        const Container& array = a.type == ContainerType::ARRAY ? a : b;
+        const Container& bitset = a.type == ContainerType::ARRAY ? b : a;
+        for (uint16_t low : array.values) {
+            if (testBit(bitset.words, low)) {
+                result.values.push_back(low);
+            }
+        }
+    } else {
+        result.type = ContainerType::BITSET;
+        result.words.resize(BITSET_WORDS);
+        result.cardinality = combineWords<WordOp::AND>(a.words.data(), b.words.data(), result.words.data(), BITSET_WORDS);
+        normalize(result);
+        return result;
+    }
+    result.cardinality = static_cast<uint32_t>(result.values.size());
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::uniteContainers(const Container& a, const Container& b) {
+    if (a.type == ContainerType::RUN) {
+        return uniteContainers(expand(a), b);
+    }
+    if (b.type == ContainerType::RUN) {
+        return uniteContainers(a, expand(b));
+    }
+    
+    Container result;
+    if (a.type == ContainerType::ARRAY && b.type == ContainerType::ARRAY) {
+        if (a.cardinality + b.cardinality <= ARRAY_MAX_SIZE) {
+            std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                           std::back_inserter(result.values));
+            result.cardinality = static_cast<uint32_t>(result.values.size());
+            return result;
+        }
+        result.type = ContainerType::BITSET;
+        result.words.assign(BITSET_WORDS, 0);
+        for (const Container* array : {&a, &b}) {
+            for (uint16_t low : array->values) {
+                result.words[low >> 6] |= 1ULL << (low & 63);
+            }
+        }
+        for (uint64_t word : result.words) {
+            result.cardinality += popcount64(word);
+        }
+        normalize(result);
+    } else if (a.type == ContainerType::ARRAY || b.type == ContainerType::ARRAY) {
+        const Container& array = a.type == ContainerType::ARRAY ? a : b;
+        result = a.type == ContainerType::ARRAY ? b : a;
+        for (uint16_t low : array.values) {
+            uint64_t bit = 1ULL << (low & 63);
+            if ((result.words[low >> 6] & bit) == 0) {
+                result.words[low >> 6] |= bit;
+                result.cardinality++;
+            }
+        }
+    } else {
+        result.type = ContainerType::BITSET;
+        result.words.resize(BITSET_WORDS);
+        result.cardinality = combineWords<WordOp::OR>(a.words.data(), b.words.data(), result.words.data(), BITSET_WORDS);
+    }
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::subtractContainers(const Container& a, const Container& b) {
+    if (a.type == ContainerType::RUN) {
+        return subtractContainers(expand(a), b);
+    }
+    if (b.type == ContainerType::RUN) {
+        return subtractContainers(a, expand(b));
+    }
+    
+    Container result;
+    if (a.type == ContainerType::ARRAY && b.type == ContainerType::ARRAY) {
+        std::set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                            std::back_inserter(result.values));
+        result.cardinality = static_cast<uint32_t>(result.values.size());
+    } else if (a.type == ContainerType::ARRAY) {
+        for (uint16_t low : a.values) {
+            if (!testBit(b.words, low)) {
+                result.values.push_back(low);
+            }
+        }
+        result.cardinality = static_cast<uint32_t>(result.values.size());
+    } else if (b.type == ContainerType::ARRAY) {
+        result = a;
+        for (uint16_t low : b.values) {
+            uint64_t bit = 1ULL << (low & 63);
+            if ((result.words[low >> 6] & bit) != 0) {
+                result.words[low >> 6] &= ~bit;
+                result.cardinality--;
+            }
+        }
+        normalize(result);
+    } else {
+        result.type = ContainerType::BITSET;
+        result.words.resize(BITSET_WORDS);
+        result.cardinality = combineWords<WordOp::ANDNOT>(a.words.data(), b.words.data(), result.words.data(), BITSET_WORDS);
+        normalize(result);
+    }
+    return result;
+}
+
+uint64_t RoaringBitmap::intersectCount(const Container& a, const Container& b) {
+    if (a.type == ContainerType::RUN) {
+        return intersectCount(expand(a), b);
+    }
+    if (b.type == ContainerType::RUN) {
+        return intersectCount(a, expand(b));
+    }
+    
+    uint64_t count = 0;
+    if (a.type == ContainerType::ARRAY && b.type == ContainerType::ARRAY) {
+        std::vector<uint16_t> common;
+        intersectArrays(a.values, b.values, common);
+        count = common.size();
+    } else if (a.type == ContainerType::ARRAY || b.type == ContainerType::ARRAY) {
+        const Container& array = a.type == ContainerType::ARRAY ? a : b;
+        const Container& bitset = a.type == ContainerType::ARRAY ? b : a;
+        for (uint16_t low : array.values) {
+            count += testBit(bitset.words, low) ? 1 : 0;
+        }
+    } else {
+        for (size_t i = 0; i < BITSET_WORDS; ++i) {
+            count += popcount64(a.words[i] & b.words[i]);
+        }
+    }
+    return count;
+}
+
+bool RoaringBitmap::add(uint32_t value) {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+    size_t index = findContainer(key);
+    if (index == keys_.size() || keys_[index] != key) {
+        keys_.insert(keys_.begin() + index, key);
+        containers_.insert(containers_.begin() + index, Container());
+    }
+    
+    Container& container = containers_[index];
+    if (container.type == ContainerType::RUN) {
+        if (containerContains(container, low)) {
+            return false;
+        }
+        container = expand(container);
+    }
+    if (container.type == ContainerType::ARRAY) {
+        auto it = std::lower_bound(container.values.begin(), container.values.end(), low);
+        if (it != container.values.end() && *it == low) {
+            return false;
+        }
+        container.values.insert(it, low);
+    } else {
+        uint64_t bit = 1ULL << (low & 63);
+        if ((container.words[low >> 6] & bit) != 0) {
+            return false;
+        }
+        container.words[low >> 6] |= bit;
+    }
+    container.cardinality++;
+    normalize(container);
+    return true;
+}
+
+bool RoaringBitmap::remove(uint32_t value) {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+    size_t index = findContainer(key);
+    if (index == keys_.size() || keys_[index] != key || !containerContains(containers_[index], low)) {
+        return false;
+    }
+    
+    Container& container = containers_[index];
+    if (container.type == ContainerType::RUN) {
+        container = expand(container);
+    }
+    if (container.type == ContainerType::ARRAY) {
+        container.values.erase(std::lower_bound(container.values.begin(), container.values.end(), low));
+    } else {
+        container.words[low >> 6] &= ~(1ULL << (low & 63));
+    }
+    container.cardinality--;
+    
+    if (container.cardinality == 0) {
+        keys_.erase(keys_.begin() + index);
+        containers_.erase(containers_.begin() + index);
+    } else {
+        normalize(container);
+    }
+    return true;
+}
+
+bool RoaringBitmap::contains(uint32_t value) const {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    size_t index = findContainer(key);
+    return index < keys_.size() && keys_[index] == key &&
+           containerContains(containers_[index], static_cast<uint16_t>(value & 0xFFFF));
+}
+
+uint64_t RoaringBitmap::cardinality() const {
+    uint64_t total = 0;
+    for (const Container& container : containers_) {
+        total += container.cardinality;
+    }
+    return total;
+}
+
+bool RoaringBitmap::isEmpty() const {
+    return containers_.empty();
+}
+
+void RoaringBitmap::clear() {
+    keys_.clear();
+    containers_.clear();
+}
+
+RoaringBitmap RoaringBitmap::intersect(const RoaringBitmap& other) const {
+    RoaringBitmap result;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < keys_.size() && j < other.keys_.size()) {
+        if (keys_[i] < other.keys_[j]) {
+            i++;
+        } else if (other.keys_[j] < keys_[i]) {
+            j++;
+        } else {
+            Container container = intersectContainers(containers_[i], other.containers_[j]);
+            if (container.cardinality > 0) {
+                result.keys_.push_back(keys_[i]);
+                result.containers_.push_back(std::move(container));
+            }
+            i++;
+            j++;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::unite(const RoaringBitmap& other) const {
+    RoaringBitmap result;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < keys_.size() || j < other.keys_.size()) {
+        if (j == other.keys_.size() || (i < keys_.size() && keys_[i] < other.keys_[j])) {
+            result.keys_.push_back(keys_[i]);
+            result.containers_.push_back(containers_[i++]);
+        } else if (i == keys_.size() || other.keys_[j] < keys_[i]) {
+            result.keys_.push_back(other.keys_[j]);
+            result.containers_.push_back(other.containers_[j++]);
+        } else {
+            result.keys_.push_back(keys_[i]);
+            result.containers_.push_back(uniteContainers(containers_[i++], other.containers_[j++]));
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::subtract(const RoaringBitmap& other) const {
+    RoaringBitmap result;
+    size_t j = 0;
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        while (j < other.keys_.size() && other.keys_[j] < keys_[i]) {
+            j++;
+        }
+        if (j == other.keys_.size() || other.keys_[j] != keys_[i]) {
+            result.keys_.push_back(keys_[i]);
+            result.containers_.push_back(containers_[i]);
+            continue;
+        }
+        Container container = subtractContainers(containers_[i], other.containers_[j]);
+        if (container.cardinality > 0) {
+            result.keys_.push_back(keys_[i]);
+            result.containers_.push_back(std::move(container));
+        }
+    }
+    return result;
+}
+
+uint64_t RoaringBitmap::intersectCardinality(const RoaringBitmap& other) const {
+    uint64_t count = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < keys_.size() && j < other.keys_.size()) {
+        if (keys_[i] < other.keys_[j]) {
+            i++;
+        } else if (other.keys_[j] < keys_[i]) {
+            j++;
+        } else {
+            count += intersectCount(containers_[i++], other.containers_[j++]);
+        }
+    }
+    return count;
+}
+
+size_t RoaringBitmap::runOptimize() {
+    size_t runContainers = 0;
+    for (Container& container : containers_) {
+        if (container.type == ContainerType::RUN) {
+            runContainers++;
+            continue;
+        }
+        
+        // A run starts at each value whose predecessor is absent
+        size_t runs = 0;
+        if (container.type == ContainerType::ARRAY) {
+            for (size_t i = 0; i < container.values.size(); ++i) {
+                if (i == 0 || container.values[i] != container.values[i - 1] + 1) {
+                    runs++;
+                }
+            }
+        } else {
+            uint64_t carry = 0;
+            for (uint64_t word : container.words) {
+                runs += popcount64(word & ~((word << 1) | carry));
+                carry = word >> 63;
+            }
+        }
+        
+        // Four bytes per run against two per value or 8 KB of bits
+        size_t currentBytes = container.type == ContainerType::ARRAY ? container.cardinality * 2 : BITSET_WORDS * 8;
+        if (runs * 4 >= currentBytes) {
+            continue;
+        }
+        std::vector<uint16_t> pairs;
+        pairs.reserve(runs * 2);
+        uint32_t previous = 0;
+        forEachInContainer(container, [&pairs, &previous](uint16_t low) {
+            if (!pairs.empty() && low == previous + 1) {
+                pairs.back()++;
+            } else {
+                pairs.push_back(low);
+                pairs.push_back(0);
+            }
+            previous = low;
+        });
+        container.type = ContainerType::RUN;
+        container.values = std::move(pairs);
+        container.words.clear();
+        container.words.shrink_to_fit();
+        runContainers++;
+    }
+    return runContainers;
+}
+
+void RoaringBitmap::forEach(const std::function<void(uint32_t)>& fn) const {
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        uint32_t high = static_cast<uint32_t>(keys_[i]) << 16;
+        forEachInContainer(containers_[i], [&fn, high](uint16_t low) {
+            fn(high | low);
+        });
+    }
+}
+
+std::vector<uint32_t> RoaringBitmap::toVector() const {
+    std::vector<uint32_t> values;
+    values.reserve(cardinality());
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        uint32_t high = static_cast<uint32_t>(keys_[i]) << 16;
+        forEachInContainer(containers_[i], [&values, high](uint16_t low) {
+            values.push_back(high | low);
+        });
+    }
+    return values;
+}
+
+size_t RoaringBitmap::getMemoryUsage() const {
+    size_t bytes = keys_.capacity() * sizeof(uint16_t) + containers_.capacity() * sizeof(Container);
+    for (const Container& container : containers_) {
+        bytes += container.values.capacity() * sizeof(uint16_t) + container.words.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+bool RoaringBitmap::operator==(const RoaringBitmap& other) const {
+    if (keys_ != other.keys_) {
+        return false;
+    }
+    // The same chunk may be stored as different container types
+    for (size_t i = 0; i < containers_.size(); ++i) {
+        if (containers_[i].cardinality != other.containers_[i].cardinality ||
+            intersectCount(containers_[i], other.containers_[i]) != containers_[i].cardinality) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace storage
+} // namespace phantomdb
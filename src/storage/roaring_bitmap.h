@@ -0,0 +1,138 @@
+#ifndef PHANTOMDB_ROARING_BITMAP_H
+#define PHANTOMDB_ROARING_BITMAP_H
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * Compressed set of 32-bit integers (row ids) in the Roaring layout.
+ * 
+ * Values are split by their high 16 bits into chunks of 65536, and each
+ * non-empty chunk has a container for its low 16 bits, picked by density:
+ * 
+ *   array   sorted uint16 values, for chunks of up to 4096 values
+ *   bitset  65536 bits in 1024 words, for denser chunks
+ *   run     sorted (start, length - 1) pairs; only made by runOptimize(),
+ *           for chunks that are mostly long runs of consecutive values
+ * 
+ * Set operations work container by container. Bitset containers are
+ * combined 256 bits at a time with AVX2 (128 with SSE2); arrays are merged,
+ * galloping through the longer one when sizes are skewed. Run containers
+ * are expanded to an array or bitset first, as is any run container that
+ * is modified.
+ * 
+ * Every container keeps its cardinality, so cardinality() costs one add
+ * per container, and intersectCardinality() counts an AND without
+ * building it.
+ */
+class RoaringBitmap {
+public:
+    RoaringBitmap();
+    ~RoaringBitmap();
+    
+    RoaringBitmap(const RoaringBitmap&) = default;
+    RoaringBitmap& operator=(const RoaringBitmap&) = default;
+    RoaringBitmap(RoaringBitmap&&) = default;
+    RoaringBitmap& operator=(RoaringBitmap&&) = default;
+    
+    // Add a value; false if it was already present
+    bool add(uint32_t value);
+    
+    // Remove a value; false if it was not present
+    bool remove(uint32_t value);
+    
+    bool contains(uint32_t value) const;
+    
+    // Number of values
+    uint64_t cardinality() const;
+    
+    bool isEmpty() const;
+    
+    void clear();
+    
+    // Values in both bitmaps (AND)
+    RoaringBitmap intersect(const RoaringBitmap& other) const;
+    
+    // Values in either bitmap (OR)
+    RoaringBitmap unite(const RoaringBitmap& other) const;
+    
+    // Values in this bitmap but not in other (AND NOT)
+    RoaringBitmap subtract(const RoaringBitmap& other) const;
+    
+    // Size of intersect(other), without materializing it
+    uint64_t intersectCardinality(const RoaringBitmap& other) const;
+    
+    /**
+     * @brief Store chunks of consecutive values as runs where that is smaller
+     * 
+     * Worth calling once a bitmap is built, e.g. for columns loaded in
+     * sorted order. Later changes to a chunk expand it again.
+     * 
+     * @return The number of run containers afterwards
+     */
+    size_t runOptimize();
+    
+    // Call fn(value) for every value in ascending order
+    void forEach(const std::function<void(uint32_t)>& fn) const;
+    
+    // Every value in ascending order
+    std::vector<uint32_t> toVector() const;
+    
+    // Approximate bytes held by the containers
+    size_t getMemoryUsage() const;
+    
+    bool operator==(const RoaringBitmap& other) const;
+    bool operator!=(const RoaringBitmap& other) const { return !(*this == other); }
+
+private:
+    static const uint32_t ARRAY_MAX_SIZE = 4096;
+    static const size_t BITSET_WORDS = 1024;
+    
+    enum class ContainerType : uint8_t {
+        ARRAY,
+        BITSET,
+        RUN
+    };
+    
+    struct Container {
+        ContainerType type = ContainerType::ARRAY;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> values;  // ARRAY: sorted values; RUN: start, length - 1 pairs
+        std::vector<uint64_t> words;   // BITSET: BITSET_WORDS words
+    };
+    
+    // Index of the container for key, or where it would be inserted
+    size_t findContainer(uint16_t key) const;
+    
+    // Convert to the cheaper of array and bitset for the cardinality
+    static void normalize(Container& container);
+    static void toBitset(Container& container);
+    static void toArray(Container& container);
+    
+    // A copy of a run container as an array or bitset
+    static Container expand(const Container& container);
+    
+    // Call fn(low) for each value of a container in ascending order
+    template<typename Fn>
+    static void forEachInContainer(const Container& container, Fn fn);
+    
+    static bool containerContains(const Container& container, uint16_t low);
+    static Container intersectContainers(const Container& a, const Container& b);
+    static Container uniteContainers(const Container& a, const Container& b);
+    static Container subtractContainers(const Container& a, const Container& b);
+    static uint64_t intersectCount(const Container& a, const Container& b);
+    
+    // Sorted high 16 bits of each chunk, parallel to containers_
+    std::vector<uint16_t> keys_;
+    std::vector<Container> containers_;
+};
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_ROARING_BITMAP_H
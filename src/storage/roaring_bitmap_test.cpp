@@ -0,0 +1,178 @@
+#include "roaring_bitmap.h"
+#include <iostream>
+#include <cassert>
+#include <set>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+using namespace phantomdb::storage;
+
+// Values spread over a few chunks: sparse ones stay arrays, dense ones become bitsets
+std::set<uint32_t> randomValues(std::mt19937& rng, uint32_t chunks, uint32_t perChunk) {
+    std::set<uint32_t> values;
+    for (uint32_t chunk = 0; chunk < chunks; ++chunk) {
+        for (uint32_t i = 0; i < perChunk; ++i) {
+            values.insert((chunk << 16) | (rng() & 0xFFFF));
+        }
+    }
+    return values;
+}
+
+RoaringBitmap toBitmap(const std::set<uint32_t>& values) {
+    RoaringBitmap bitmap;
+    for (uint32_t value : values) {
+        assert(bitmap.add(value));
+    }
+    return bitmap;
+}
+
+std::vector<uint32_t> toVector(const std::set<uint32_t>& values) {
+    return std::vector<uint32_t>(values.begin(), values.end());
+}
+
+void testBasicOperations() {
+    std::cout << "Testing basic Roaring bitmap operations..." << std::endl;
+    
+    RoaringBitmap bitmap;
+    assert(bitmap.isEmpty() && bitmap.cardinality() == 0);
+    assert(bitmap.add(7));
+    assert(!bitmap.add(7));
+    assert(bitmap.add(70000));
+    assert(bitmap.add(0xFFFFFFFF));
+    assert(bitmap.contains(7) && bitmap.contains(70000) && bitmap.contains(0xFFFFFFFF));
+    assert(!bitmap.contains(8) && !bitmap.contains(65536 + 7));
+    assert(bitmap.cardinality() == 3);
+    assert((bitmap.toVector() == std::vector<uint32_t>{7, 70000, 0xFFFFFFFF}));
+    
+    assert(bitmap.remove(70000));
+    assert(!bitmap.remove(70000));
+    assert(bitmap.cardinality() == 2);
+    
+    // Growing a chunk past 4096 values switches it to a bitset and back
+    std::mt19937 rng(1);
+    std::set<uint32_t> reference{7, 0xFFFFFFFF};
+    for (int i = 0; i < 20000; ++i) {
+        uint32_t value = rng() & 0x1FFFF;
+        assert(bitmap.add(value) == reference.insert(value).second);
+    }
+    assert(bitmap.cardinality() == reference.size());
+    assert(bitmap.toVector() == toVector(reference));
+    for (int i = 0; i < 30000; ++i) {
+        uint32_t value = rng() & 0x1FFFF;
+        assert(bitmap.remove(value) == (reference.erase(value) == 1));
+    }
+    assert(bitmap.cardinality() == reference.size());
+    assert(bitmap.toVector() == toVector(reference));
+    
+    bitmap.clear();
+    assert(bitmap.isEmpty());
+    
+    std::cout << "Basic operations test passed!" << std::endl;
+}
+
+void testSetOperations() {
+    std::cout << "Testing AND, OR and ANDNOT across container types..." << std::endl;
+    
+    std::mt19937 rng(2);
+    
+    // Sparse, dense and mixed inputs cover array-array, array-bitset and bitset-bitset
+    std::vector<std::set<uint32_t>> inputs = {
+        randomValues(rng, 4, 100),
+        randomValues(rng, 4, 30000),
+        randomValues(rng, 6, 3000),
+        randomValues(rng, 3, 8000),
+        {}
+    };
+    
+    // Long runs of consecutive values, stored as run containers after runOptimize
+    std::set<uint32_t> runs;
+    for (uint32_t start = 0; start < 200000; start += 5000) {
+        for (uint32_t value = start; value < start + 3000; ++value) {
+            runs.insert(value);
+        }
+    }
+    inputs.push_back(runs);
+    
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        for (size_t j = 0; j < inputs.size(); ++j) {
+            RoaringBitmap a = toBitmap(inputs[i]);
+            RoaringBitmap b = toBitmap(inputs[j]);
+            if (i == inputs.size() - 1) {
+                assert(a.runOptimize() > 0);
+            }
+            
+            std::vector<uint32_t> expected;
+            std::set_intersection(inputs[i].begin(), inputs[i].end(), inputs[j].begin(), inputs[j].end(),
+                                  std::back_inserter(expected));
+            RoaringBitmap both = a.intersect(b);
+            assert(both.toVector() == expected);
+            assert(both.cardinality() == expected.size());
+            assert(a.intersectCardinality(b) == expected.size());
+            
+            expected.clear();
+            std::set_union(inputs[i].begin(), inputs[i].end(), inputs[j].begin(), inputs[j].end(),
+                           std::back_inserter(expected));
+            RoaringBitmap either = a.unite(b);
+            assert(either.toVector() == expected);
+            assert(either.cardinality() == expected.size());
+            
+            expected.clear();
+            std::set_difference(inputs[i].begin(), inputs[i].end(), inputs[j].begin(), inputs[j].end(),
+                                std::back_inserter(expected));
+            RoaringBitmap difference = a.subtract(b);
+            assert(difference.toVector() == expected);
+            assert(difference.cardinality() == expected.size());
+        }
+    }
+    
+    std::cout << "Set operations test passed!" << std::endl;
+}
+
+void testRunContainers() {
+    std::cout << "Testing run containers..." << std::endl;
+    
+    // Rows loaded in order: one long run per chunk plus a gap
+    RoaringBitmap bitmap;
+    for (uint32_t value = 1000; value < 150000; ++value) {
+        if (value != 5000) {
+            bitmap.add(value);
+        }
+    }
+    RoaringBitmap copy = bitmap;
+    size_t before = bitmap.getMemoryUsage();
+    assert(bitmap.runOptimize() == 3);
+    assert(bitmap.getMemoryUsage() * 10 < before);
+    assert(bitmap == copy);
+    assert(bitmap.cardinality() == 149000 - 1);
+    assert(bitmap.contains(1000) && bitmap.contains(4999) && !bitmap.contains(5000));
+    assert(bitmap.contains(149999) && !bitmap.contains(150000) && !bitmap.contains(999));
+    
+    // Changing a run container expands it
+    assert(bitmap.add(5000));
+    assert(!bitmap.add(5001));
+    assert(bitmap.remove(1000));
+    assert(!bitmap.contains(1000) && bitmap.contains(5000));
+    assert(bitmap.cardinality() == 149000 - 1);
+    
+    // Sparse values are not worth storing as runs
+    RoaringBitmap sparse;
+    for (uint32_t value = 0; value < 100000; value += 7) {
+        sparse.add(value);
+    }
+    assert(sparse.runOptimize() == 0);
+    
+    std::cout << "Run containers test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running Roaring bitmap tests..." << std::endl;
+    
+    testBasicOperations();
+    testSetOperations();
+    testRunContainers();
+    
+    std::cout << "All Roaring bitmap tests passed!" << std::endl;
+    return 0;
+}
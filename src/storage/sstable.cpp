@@ -0,0 +1,669 @@
+#include "sstable.h"
+#include "mapped_file.h"
+#include "utils.h"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace phantomdb {
+namespace storage {
+
+namespace {
+
+using core::utils::putVarint;
+using core::utils::getVarint;
+using core::utils::putFixed32;
+using core::utils::putFixed64;
+using core::utils::getFixed;
+
+const char FOOTER_MAGIC[8] = {'P', 'H', 'D', 'B', 'S', 'S', 'T', '\0'};
+const char FRONT_CODED_FOOTER_MAGIC[8] = {'P', 'H', 'D', 'B', 'S', 'S', 'T', '\1'};
+const size_t FOOTER_SIZE = 48;
+const uint8_t KIND_VALUE = 0;
+const uint8_t KIND_TOMBSTONE = 1;
+const int MAX_BLOOM_PROBES = 30;
+
+// Blocked filters: tag byte, then blocks of eight 32-bit words
+const uint8_t BLOCKED_BLOOM_TAG = 0x80;
+const size_t BLOOM_BLOCK_BYTES = 32;
+const size_t BLOOM_BLOCK_BITS = BLOOM_BLOCK_BYTES * 8;
+
+// Odd multipliers, one per word of a block, that pick the bit set in it
+const uint32_t BLOOM_SALTS[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+void putString(std::string& out, std::string_view value) {
+    putVarint(out, value.size());
+    out.append(value.data(), value.size());
+}
+
+bool getString(const unsigned char*& pos, const unsigned char* end, std::string_view& value) {
+    uint64_t length;
+    if (!getVarint(pos, end, length) || length > static_cast<uint64_t>(end - pos)) {
+        return false;
+    }
+    value = std::string_view(reinterpret_cast<const char*>(pos), static_cast<size_t>(length));
+    pos += length;
+    return true;
+}
+
+// Decode one data block entry; false if the entry runs past the block
+bool getEntry(const unsigned char*& pos, const unsigned char* end,
+              std::string_view& key, std::string_view& value, bool& tombstone) {
+    if (pos >= end) {
+        return false;
+    }
+    uint8_t kind = *pos++;
+    uint64_t keyLength, valueLength;
+    if (kind > KIND_TOMBSTONE || !getVarint(pos, end, keyLength) || !getVarint(pos, end, valueLength) ||
+        keyLength > static_cast<uint64_t>(end - pos) || valueLength > static_cast<uint64_t>(end - pos) - keyLength) {
+        return false;
+    }
+    key = std::string_view(reinterpret_cast<const char*>(pos), static_cast<size_t>(keyLength));
+    pos += keyLength;
+    value = std::string_view(reinterpret_cast<const char*>(pos), static_cast<size_t>(valueLength));
+    pos += valueLength;
+    tombstone = kind == KIND_TOMBSTONE;
+    return true;
+}
+
+// 64-bit FNV-1a with a final avalanche, stable across runs and platforms
+uint64_t hashKey(std::string_view key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Bloom filter probes use double hashing: h1 + i * h2
+std::string buildBloomFilter(const std::vector<uint64_t>& hashes, int bitsPerKey) {
+    std::string filter;
+    if (bitsPerKey <= 0 || hashes.empty()) {
+        return filter;
+    }
+    int probes = std::max(1, std::min(MAX_BLOOM_PROBES, static_cast<int>(bitsPerKey * 0.69)));
+    size_t bits = std::max<size_t>(64, hashes.size() * static_cast<size_t>(bitsPerKey));
+    size_t bytes = (bits + 7) / 8;
+    bits = bytes * 8;
+    
+    filter.assign(bytes + 1, '\0');
+    filter[0] = static_cast<char>(probes);
+    for (uint64_t hash : hashes) {
+        uint64_t delta = (hash >> 32) | (hash << 32);
+        for (int i = 0; i < probes; ++i) {
+            size_t bit = static_cast<size_t>(hash % bits);
+            filter[1 + bit / 8] |= static_cast<char>(1 << (bit % 8));
+            hash += delta;
+        }
+    }
+    return filter;
+}
+
+// The high half of the hash picks the block, the low half the bits in it
+size_t bloomBlock(uint64_t hash, size_t blocks) {
+    return static_cast<size_t>(((hash >> 32) * blocks) >> 32);
+}
+
+std::string buildBlockedBloomFilter(const std::vector<uint64_t>& hashes, int bitsPerKey) {
+    std::string filter;
+    if (bitsPerKey <= 0 || hashes.empty()) {
+        return filter;
+    }
+    size_t blocks = (hashes.size() * static_cast<size_t>(bitsPerKey) + BLOOM_BLOCK_BITS - 1) / BLOOM_BLOCK_BITS;
+    std::vector<uint32_t> words(blocks * 8, 0);
+    for (uint64_t hash : hashes) {
+        uint32_t* block = &words[bloomBlock(hash, blocks) * 8];
+        auto key = static_cast<uint32_t>(hash);
+        for (int i = 0; i < 8; ++i) {
+            block[i] |= 1U << ((key * BLOOM_SALTS[i]) >> 27);
+        }
+    }
+    
+    filter.reserve(1 + blocks * BLOOM_BLOCK_BYTES);
+    filter.push_back(static_cast<char>(BLOCKED_BLOOM_TAG));
+    for (uint32_t word : words) {
+        putFixed32(filter, word);
+    }
+    return filter;
+}
+
+bool blockedBloomMayContain(const unsigned char* filter, size_t length, uint64_t hash) {
+    size_t blocks = (length - 1) / BLOOM_BLOCK_BYTES;
+    if (blocks == 0) {
+        return true;
+    }
+    const unsigned char* block = filter + 1 + bloomBlock(hash, blocks) * BLOOM_BLOCK_BYTES;
+    auto key = static_cast<uint32_t>(hash);
+#if defined(__AVX2__)
+    // Words are stored little-endian, as x86 loads them
+    __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i salts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(BLOOM_SALTS));
+    __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(key)), salts), 27);
+    __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+    return _mm256_testc_si256(words, mask) != 0;
+#else
+    for (int i = 0; i < 8; ++i) {
+        auto word = static_cast<uint32_t>(getFixed(block + 4 * i, 4));
+        if ((word & (1U << ((key * BLOOM_SALTS[i]) >> 27))) == 0) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+bool bloomMayContain(const unsigned char* filter, size_t length, uint64_t hash) {
+    if (length < 2) {
+        return true; // No filter
+    }
+    if (filter[0] == BLOCKED_BLOOM_TAG) {
+        return blockedBloomMayContain(filter, length, hash);
+    }
+    int probes = filter[0];
+    size_t bits = (length - 1) * 8;
+    uint64_t delta = (hash >> 32) | (hash << 32);
+    for (int i = 0; i < probes; ++i) {
+        size_t bit = static_cast<size_t>(hash % bits);
+        if ((filter[1 + bit / 8] & (1 << (bit % 8))) == 0) {
+            return false;
+        }
+        hash += delta;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+SSTableWriter::SSTableWriter()
+    : file_(nullptr), blockSize_(DEFAULT_BLOCK_SIZE), bloomBitsPerKey_(DEFAULT_BLOOM_BITS_PER_KEY),
+      bloomLayout_(BloomFilterLayout::BLOCKED), frontCoding_(false), indexCount_(0), offset_(0), entryCount_(0), ok_(false) {}
+
+SSTableWriter::~SSTableWriter() {
+    abort();
+}
+
+bool SSTableWriter::open(const std::string& path, size_t blockSize, int bloomBitsPerKey,
+                         BloomFilterLayout bloomLayout, bool frontCoding) {
+    abort();
+    path_ = path;
+    tempPath_ = path + ".tmp";
+    blockSize_ = std::max<size_t>(blockSize, 64);
+    bloomBitsPerKey_ = bloomBitsPerKey;
+    bloomLayout_ = bloomLayout;
+    frontCoding_ = frontCoding;
+    block_.clear();
+    frontCodedBlock_.reset();
+    blockFirstKey_.clear();
+    lastKey_.clear();
+    index_.clear();
+    indexCount_ = 0;
+    keyHashes_.clear();
+    offset_ = 0;
+    entryCount_ = 0;
+    
+    file_ = std::fopen(tempPath_.c_str(), "wb");
+    if (file_ == nullptr) {
+        std::cerr << "Failed to create sorted table: " << tempPath_ << std::endl;
+        return false;
+    }
+    ok_ = true;
+    return true;
+}
+
+bool SSTableWriter::add(std::string_view key, std::string_view value, bool tombstone) {
+    if (file_ == nullptr || !ok_) {
+        return false;
+    }
+    if (entryCount_ > 0 && key <= std::string_view(lastKey_)) {
+        std::cerr << "Sorted table keys out of order: " << path_ << std::endl;
+        ok_ = false;
+        return false;
+    }
+    
+    if (frontCoding_) {
+        // Past the first block, the index only needs a key that tells this
+        // block from the one before
+        if (frontCodedBlock_.empty()) {
+            blockFirstKey_ = entryCount_ == 0 ? std::string(key) : shortestSeparator(lastKey_, key);
+        }
+        frontCodedBlock_.add(key, value, tombstone);
+    } else {
+        if (block_.empty()) {
+            blockFirstKey_.assign(key.data(), key.size());
+        }
+        block_.push_back(static_cast<char>(tombstone ? KIND_TOMBSTONE : KIND_VALUE));
+        putVarint(block_, key.size());
+        putVarint(block_, value.size());
+        block_.append(key.data(), key.size());
+        block_.append(value.data(), value.size());
+    }
+    lastKey_.assign(key.data(), key.size());
+    keyHashes_.push_back(hashKey(key));
+    entryCount_++;
+    
+    if ((frontCoding_ ? frontCodedBlock_.getSizeEstimate() : block_.size()) >= blockSize_) {
+        return flushBlock();
+    }
+    return true;
+}
+
+bool SSTableWriter::flushBlock() {
+    if (frontCoding_ && !frontCodedBlock_.empty()) {
+        block_ = frontCodedBlock_.finish();
+    }
+    if (block_.empty()) {
+        return true;
+    }
+    putString(index_, blockFirstKey_);
+    putFixed64(index_, offset_);
+    putFixed32(index_, static_cast<uint32_t>(block_.size()));
+    putFixed32(index_, core::utils::crc32(block_.data(), block_.size()));
+    indexCount_++;
+    
+    ok_ = ok_ && std::fwrite(block_.data(), 1, block_.size(), file_) == block_.size();
+    offset_ += block_.size();
+    block_.clear();
+    return ok_;
+}
+
+bool SSTableWriter::finish() {
+    if (file_ == nullptr) {
+        return false;
+    }
+    flushBlock();
+    
+    std::string index;
+    putVarint(index, indexCount_);
+    index.append(index_);
+    putString(index, lastKey_);
+    std::string bloom = bloomLayout_ == BloomFilterLayout::BLOCKED
+        ? buildBlockedBloomFilter(keyHashes_, bloomBitsPerKey_)
+        : buildBloomFilter(keyHashes_, bloomBitsPerKey_);
+    
+    std::string footer;
+    putFixed64(footer, offset_);
+    putFixed32(footer, static_cast<uint32_t>(index.size()));
+    putFixed32(footer, core::utils::crc32(index.data(), index.size()));
+    putFixed64(footer, offset_ + index.size());
+    putFixed32(footer, static_cast<uint32_t>(bloom.size()));
+    putFixed32(footer, core::utils::crc32(bloom.data(), bloom.size()));
+    putFixed64(footer, entryCount_);
+    footer.append(frontCoding_ ? FRONT_CODED_FOOTER_MAGIC : FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+    
+    bool ok = ok_;
+    ok = ok && std::fwrite(index.data(), 1, index.size(), file_) == index.size();
+    ok = ok && std::fwrite(bloom.data(), 1, bloom.size(), file_) == bloom.size();
+    ok = ok && std::fwrite(footer.data(), 1, footer.size(), file_) == footer.size();
+    ok = ok && std::fflush(file_) == 0 && core::utils::syncFile(file_);
+    ok = (std::fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    ok_ = false;
+    
+    std::error_code ec;
+    if (!ok) {
+        std::cerr << "Failed to write sorted table: " << tempPath_ << std::endl;
+        std::filesystem::remove(tempPath_, ec);
+        return false;
+    }
+    std::filesystem::rename(tempPath_, path_, ec);
+    if (ec) {
+        std::cerr << "Failed to move sorted table into place: " << path_ << " (" << ec.message() << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SSTableWriter::abort() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+        std::error_code ec;
+        std::filesystem::remove(tempPath_, ec);
+    }
+    ok_ = false;
+}
+
+uint64_t SSTableWriter::getEntryCount() const {
+    return entryCount_;
+}
+
+uint64_t SSTableWriter::getDataSize() const {
+    return offset_ + (frontCoding_ ? frontCodedBlock_.getSizeEstimate() : block_.size());
+}
+
+class SSTableReader::Impl {
+public:
+    struct Block {
+        std::string_view firstKey;
+        uint64_t offset;
+        uint32_t length;
+        uint32_t checksum;
+    };
+    
+    std::string path;
+    MappedFile file;
+    const unsigned char* data = nullptr;  // The mapped file's bytes
+    size_t size = 0;
+    std::vector<Block> blocks;
+    std::string_view lastKey;
+    const unsigned char* bloom = nullptr;
+    size_t bloomLength = 0;
+    uint64_t entryCount = 0;
+    bool frontCoded = false;
+    
+    // Set once a block's checksum has been verified
+    std::unique_ptr<std::atomic<bool>[]> verified;
+    
+    bool map(const std::string& filePath) {
+        if (!file.open(filePath)) {
+            return false;
+        }
+        data = file.data();
+        size = file.size();
+        return true;
+    }
+    
+    void unmap() {
+        file.close();
+        data = nullptr;
+        size = 0;
+        blocks.clear();
+        lastKey = std::string_view();
+        bloom = nullptr;
+        bloomLength = 0;
+        entryCount = 0;
+        frontCoded = false;
+        verified.reset();
+    }
+    
+    bool readFooter() {
+        if (size < FOOTER_SIZE) {
+            return false;
+        }
+        const unsigned char* footer = data + size - FOOTER_SIZE;
+        frontCoded = std::memcmp(footer + 40, FRONT_CODED_FOOTER_MAGIC, sizeof(FRONT_CODED_FOOTER_MAGIC)) == 0;
+        if (!frontCoded && std::memcmp(footer + 40, FOOTER_MAGIC, sizeof(FOOTER_MAGIC)) != 0) {
+            return false;
+        }
+        uint64_t indexOffset = getFixed(footer, 8);
+        uint64_t indexLength = getFixed(footer + 8, 4);
+        auto indexChecksum = static_cast<uint32_t>(getFixed(footer + 12, 4));
+        uint64_t bloomOffset = getFixed(footer + 16, 8);
+        bloomLength = static_cast<size_t>(getFixed(footer + 24, 4));
+        auto bloomChecksum = static_cast<uint32_t>(getFixed(footer + 28, 4));
+        entryCount = getFixed(footer + 32, 8);
+        
+        uint64_t limit = size - FOOTER_SIZE;
+        if (indexOffset > limit || indexLength > limit - indexOffset ||
+            bloomOffset > limit || bloomLength > limit - bloomOffset ||
+            core::utils::crc32(data + indexOffset, indexLength) != indexChecksum ||
+            core::utils::crc32(data + bloomOffset, bloomLength) != bloomChecksum) {
+            return false;
+        }
+        bloom = data + bloomOffset;
+        
+        const unsigned char* pos = data + indexOffset;
+        const unsigned char* end = pos + indexLength;
+        uint64_t count;
+        if (!getVarint(pos, end, count) || count > indexLength) {
+            return false;
+        }
+        blocks.resize(static_cast<size_t>(count));
+        for (auto& block : blocks) {
+            if (!getString(pos, end, block.firstKey) || end - pos < 16) {
+                return false;
+            }
+            block.offset = getFixed(pos, 8);
+            block.length = static_cast<uint32_t>(getFixed(pos + 8, 4));
+            block.checksum = static_cast<uint32_t>(getFixed(pos + 12, 4));
+            pos += 16;
+            if (block.offset > indexOffset || block.length > indexOffset - block.offset) {
+                return false;
+            }
+        }
+        if (!getString(pos, end, lastKey)) {
+            return false;
+        }
+        
+        verified.reset(new std::atomic<bool>[blocks.size()]);
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            verified[i].store(false, std::memory_order_relaxed);
+        }
+        return true;
+    }
+    
+    // Bytes of a data block, or null if its checksum does not match
+    const unsigned char* blockData(size_t index) const {
+        const Block& block = blocks[index];
+        const unsigned char* start = data + block.offset;
+        if (!verified[index].load(std::memory_order_acquire)) {
+            if (core::utils::crc32(start, block.length) != block.checksum) {
+                std::cerr << "Corrupt block " << index << " in sorted table: " << path << std::endl;
+                return nullptr;
+            }
+            verified[index].store(true, std::memory_order_release);
+        }
+        return start;
+    }
+};
+
+void SSTableReader::Iterator::loadBlock() {
+    const auto& impl = *reader_->pImpl;
+    while (block_ < impl.blocks.size()) {
+        pos_ = impl.blockData(block_);
+        if (pos_ == nullptr) {
+            ok_ = false;
+            break;
+        }
+        end_ = pos_ + impl.blocks[block_].length;
+        if (frontCoded_) {
+            if (!entries_.init(pos_, impl.blocks[block_].length)) {
+                ok_ = false;
+                break;
+            }
+            entries_.seekToFirst();
+            if (entries_.valid()) {
+                return;
+            }
+            if (!entries_.ok()) {
+                ok_ = false;
+                break;
+            }
+        } else if (pos_ < end_) {
+            return;
+        }
+        block_++;
+    }
+    valid_ = false;
+}
+
+void SSTableReader::Iterator::next() {
+    if (!valid_) {
+        return;
+    }
+    if (frontCoded_) {
+        entries_.next();
+        if (!entries_.valid()) {
+            if (!entries_.ok()) {
+                ok_ = false;
+                valid_ = false;
+                return;
+            }
+            block_++;
+            loadBlock();
+        }
+        return;
+    }
+    if (pos_ >= end_) {
+        block_++;
+        loadBlock();
+        if (!valid_) {
+            return;
+        }
+    }
+    if (!getEntry(pos_, end_, key_, value_, tombstone_)) {
+        ok_ = false;
+        valid_ = false;
+    }
+}
+
+SSTableReader::SSTableReader() : pImpl(std::make_unique<Impl>()) {}
+
+SSTableReader::~SSTableReader() {
+    close();
+}
+
+bool SSTableReader::open(const std::string& path) {
+    close();
+    pImpl->path = path;
+    if (!pImpl->map(path)) {
+        return false;
+    }
+    if (!pImpl->readFooter()) {
+        std::cerr << "Not a valid sorted table: " << path << std::endl;
+        pImpl->unmap();
+        return false;
+    }
+    return true;
+}
+
+void SSTableReader::close() {
+    pImpl->unmap();
+}
+
+bool SSTableReader::isOpen() const {
+    return pImpl->data != nullptr;
+}
+
+bool SSTableReader::mayContain(std::string_view key) const {
+    return bloomMayContain(pImpl->bloom, pImpl->bloomLength, hashKey(key));
+}
+
+bool SSTableReader::inKeyRange(std::string_view key) const {
+    return !pImpl->blocks.empty() && key >= pImpl->blocks.front().firstKey && key <= pImpl->lastKey;
+}
+
+bool SSTableReader::hasBloomFilter() const {
+    return pImpl->bloomLength >= 2;
+}
+
+bool SSTableReader::isFrontCoded() const {
+    return pImpl->frontCoded;
+}
+
+SSTableLookup SSTableReader::get(std::string_view key, std::string& value, bool useFilter) const {
+    const auto& impl = *pImpl;
+    if (!inKeyRange(key) || (useFilter && !mayContain(key))) {
+        return SSTableLookup::NOT_FOUND;
+    }
+    
+    // The last block whose first key is <= key
+    auto it = std::upper_bound(impl.blocks.begin(), impl.blocks.end(), key,
+                               [](std::string_view k, const Impl::Block& block) { return k < block.firstKey; });
+    size_t index = static_cast<size_t>(it - impl.blocks.begin()) - 1;
+    const unsigned char* pos = impl.blockData(index);
+    if (pos == nullptr) {
+        return SSTableLookup::NOT_FOUND;
+    }
+    const unsigned char* end = pos + impl.blocks[index].length;
+    
+    if (impl.frontCoded) {
+        // Binary search the block's restart keys, then decode a few entries
+        FrontCodedBlockIterator entries;
+        if (entries.init(pos, impl.blocks[index].length)) {
+            entries.seek(key);
+            if (entries.valid() && entries.key() == key) {
+                if (entries.flag()) {
+                    return SSTableLookup::DELETED;
+                }
+                value.assign(entries.value().data(), entries.value().size());
+                return SSTableLookup::FOUND;
+            }
+        }
+        return SSTableLookup::NOT_FOUND;
+    }
+    
+    std::string_view entryKey, entryValue;
+    bool tombstone;
+    while (getEntry(pos, end, entryKey, entryValue, tombstone)) {
+        if (entryKey == key) {
+            if (tombstone) {
+                return SSTableLookup::DELETED;
+            }
+            value.assign(entryValue.data(), entryValue.size());
+            return SSTableLookup::FOUND;
+        }
+        if (entryKey > key) {
+            break;
+        }
+    }
+    return SSTableLookup::NOT_FOUND;
+}
+
+SSTableReader::Iterator SSTableReader::begin() const {
+    Iterator it;
+    it.reader_ = this;
+    it.frontCoded_ = pImpl->frontCoded;
+    it.valid_ = true;
+    it.loadBlock();
+    if (it.valid_ && !it.frontCoded_ && !getEntry(it.pos_, it.end_, it.key_, it.value_, it.tombstone_)) {
+        it.ok_ = false;
+        it.valid_ = false;
+    }
+    return it;
+}
+
+std::string_view SSTableReader::getSmallestKey() const {
+    return pImpl->blocks.empty() ? std::string_view() : pImpl->blocks.front().firstKey;
+}
+
+std::string_view SSTableReader::getLargestKey() const {
+    return pImpl->lastKey;
+}
+
+uint64_t SSTableReader::getEntryCount() const {
+    return pImpl->entryCount;
+}
+
+uint64_t SSTableReader::getFileSize() const {
+    return pImpl->size;
+}
+
+const std::string& SSTableReader::getPath() const {
+    return pImpl->path;
+}
+
+std::string createTemporaryTableDirectory(const std::string& prefix) {
+    static std::atomic<uint64_t> counter{0};
+    std::error_code ec;
+    auto base = std::filesystem::temp_directory_path(ec);
+    if (ec) {
+        base = ".";
+    }
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        auto directory = base / (prefix + std::to_string(stamp) + "_" + std::to_string(counter++));
+        if (std::filesystem::create_directories(directory, ec)) {
+            return directory.string();
+        }
+    }
+    std::cerr << "Failed to create a temporary directory under " << base.string() << std::endl;
+    return std::string();
+}
+
+} // namespace storage
+} // namespace phantomdb
@@ -0,0 +1,239 @@
+#ifndef PHANTOMDB_SSTABLE_H
+#define PHANTOMDB_SSTABLE_H
+
+#include "front_coding.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+
+namespace phantomdb {
+namespace storage {
+
+// Outcome of a point lookup in one sorted table
+enum class SSTableLookup {
+    NOT_FOUND,   // The table holds nothing for the key
+    FOUND,       // The table holds a value for the key
+    DELETED      // The table holds a tombstone for the key
+};
+
+// How a table's bloom filter spreads the bits of one key
+enum class BloomFilterLayout {
+    STANDARD,    // Probes anywhere in the filter: lowest false-positive rate
+    BLOCKED      // All probes in one 32-byte block: one cache line per lookup
+};
+
+/**
+ * Immutable sorted table file layout (all integers little-endian):
+ * 
+ *   data blocks  entries back to back, about blockSize bytes per block:
+ *                u8 kind (0 = value, 1 = tombstone) | varint key length |
+ *                varint value length | key | value
+ *   index block  varint block count | per block: string first key |
+ *                u64 offset | u32 length | u32 crc32 | string last key of the table
+ *   bloom block  u8 probe count | filter bits (STANDARD), or
+ *                u8 0x80 | 32-byte blocks of eight u32 words (BLOCKED)
+ *   footer       u64 index offset | u32 index length | u32 index crc32 |
+ *                u64 bloom offset | u32 bloom length | u32 bloom crc32 |
+ *                u64 entry count | "PHDBSST\0" (or "PHDBSST\1" if front-coded)
+ * 
+ * Keys are compared as raw bytes (memcmp order) and must be added in
+ * strictly increasing order. The index is sparse: one key per block.
+ * 
+ * A front-coded table stores each data block as a FrontCodedBlockBuilder
+ * block instead (tombstones in the flag bit), so a key costs only the
+ * bytes that differ from the key before it. Its index keys, past the
+ * first, are the shortest separators between neighbouring blocks rather
+ * than whole first keys.
+ * 
+ * A blocked filter sets one bit in each word of a single block per key,
+ * so a lookup reads one cache line and its eight probes run as one SIMD
+ * multiply, shift and test where AVX2 is available.
+ */
+class SSTableWriter {
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 4096;
+    static const int DEFAULT_BLOOM_BITS_PER_KEY = 10;
+    
+    SSTableWriter();
+    ~SSTableWriter();
+    
+    SSTableWriter(const SSTableWriter&) = delete;
+    SSTableWriter& operator=(const SSTableWriter&) = delete;
+    
+    /**
+     * @brief Start a table; nothing is visible at the path until finish()
+     * 
+     * @param path The destination file
+     * @param blockSize Target size of a data block in bytes
+     * @param bloomBitsPerKey Bloom filter size per key (0 disables the filter)
+     * @param bloomLayout How the filter places a key's bits
+     * @param frontCoding Front-code the data blocks (see above)
+     * @return true if successful, false otherwise
+     */
+    bool open(const std::string& path,
+              size_t blockSize = DEFAULT_BLOCK_SIZE,
+              int bloomBitsPerKey = DEFAULT_BLOOM_BITS_PER_KEY,
+              BloomFilterLayout bloomLayout = BloomFilterLayout::BLOCKED,
+              bool frontCoding = false);
+    
+    /**
+     * @brief Append an entry; keys must be strictly increasing
+     * 
+     * @return true if successful, false otherwise
+     */
+    bool add(std::string_view key, std::string_view value, bool tombstone = false);
+    
+    /**
+     * @brief Write the index, filter and footer, fsync and rename into place
+     * 
+     * @return true if successful, false otherwise
+     */
+    bool finish();
+    
+    /**
+     * @brief Discard an unfinished table (also done by the destructor)
+     */
+    void abort();
+    
+    uint64_t getEntryCount() const;
+    
+    // Bytes of data written so far; the index, filter and footer come on top
+    uint64_t getDataSize() const;
+
+private:
+    bool flushBlock();
+    
+    std::FILE* file_;
+    std::string path_;
+    std::string tempPath_;
+    size_t blockSize_;
+    int bloomBitsPerKey_;
+    BloomFilterLayout bloomLayout_;
+    bool frontCoding_;
+    std::string block_;
+    FrontCodedBlockBuilder frontCodedBlock_;
+    std::string blockFirstKey_;
+    std::string lastKey_;
+    std::string index_;
+    uint64_t indexCount_;
+    std::vector<uint64_t> keyHashes_;
+    uint64_t offset_;
+    uint64_t entryCount_;
+    bool ok_;
+};
+
+/**
+ * Memory-mapped reader for sorted table files. Opening verifies the index
+ * and bloom filter; data blocks are checksummed the first time they are
+ * read. Lookups touch at most one data block and are safe to run from
+ * several threads at once.
+ */
+class SSTableReader {
+public:
+    // Forward iterator over every entry, tombstones included, in key order
+    class Iterator {
+    public:
+        bool valid() const { return valid_; }
+        void next();
+        
+        // Keys of front-coded tables live in the iterator, not the mapped
+        // file, so they are only valid until the iterator moves
+        std::string_view key() const { return frontCoded_ ? entries_.key() : key_; }
+        std::string_view value() const { return frontCoded_ ? entries_.value() : value_; }
+        bool isTombstone() const { return frontCoded_ ? entries_.flag() : tombstone_; }
+        
+        // false if iteration stopped early at a corrupt block
+        bool ok() const { return ok_; }
+    
+    private:
+        friend class SSTableReader;
+        
+        // Move to the first non-empty block from block_ on; a front-coded
+        // block is positioned on its first entry
+        void loadBlock();
+        
+        const SSTableReader* reader_ = nullptr;
+        size_t block_ = 0;
+        const unsigned char* pos_ = nullptr;
+        const unsigned char* end_ = nullptr;
+        std::string_view key_;
+        std::string_view value_;
+        bool tombstone_ = false;
+        bool frontCoded_ = false;
+        FrontCodedBlockIterator entries_;
+        bool valid_ = false;
+        bool ok_ = true;
+    };
+    
+    SSTableReader();
+    ~SSTableReader();
+    
+    SSTableReader(const SSTableReader&) = delete;
+    SSTableReader& operator=(const SSTableReader&) = delete;
+    
+    /**
+     * @brief Map a table file and verify its index and filter
+     * 
+     * @param path The table file
+     * @return false if the file is missing, not a table or corrupt
+     */
+    bool open(const std::string& path);
+    
+    void close();
+    
+    bool isOpen() const;
+    
+    /**
+     * @brief Look up one key
+     * 
+     * @param key The encoded key
+     * @param value Receives the value if FOUND
+     * @param useFilter Check the bloom filter first; false if the caller
+     *        already did
+     * @return FOUND, DELETED (tombstone) or NOT_FOUND
+     */
+    SSTableLookup get(std::string_view key, std::string& value, bool useFilter = true) const;
+    
+    /**
+     * @brief Check the bloom filter; false means the key is definitely absent
+     */
+    bool mayContain(std::string_view key) const;
+    
+    // Whether the key lies within the table's smallest and largest keys
+    bool inKeyRange(std::string_view key) const;
+    
+    bool hasBloomFilter() const;
+    
+    // Whether the data blocks are front-coded
+    bool isFrontCoded() const;
+    
+    Iterator begin() const;
+    
+    // Key range of the table (empty views for an empty table)
+    std::string_view getSmallestKey() const;
+    std::string_view getLargestKey() const;
+    
+    uint64_t getEntryCount() const;
+    uint64_t getFileSize() const;
+    const std::string& getPath() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
+
+/**
+ * @brief Create a fresh, uniquely named directory under the system temp path
+ * 
+ * @param prefix Start of the directory name
+ * @return The directory path, or an empty string on failure
+ */
+std::string createTemporaryTableDirectory(const std::string& prefix);
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_SSTABLE_H
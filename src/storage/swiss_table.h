@@ -0,0 +1,483 @@
+#ifndef PHANTOMDB_SWISS_TABLE_H
+#define PHANTOMDB_SWISS_TABLE_H
+
+#include <memory>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace phantomdb {
+namespace storage {
+
+/**
+ * @brief Open-addressing hash map in the style of Abseil's Swiss tables
+ * 
+ * Slots are split into groups of GROUP_WIDTH, and every slot has a control
+ * byte: empty, deleted (a tombstone), or the low 7 bits of the hash of the
+ * key it holds. A lookup hashes to a group and compares all of its control
+ * bytes with one SSE2 (16 slots) or AVX2 (32 slots) instruction, then
+ * compares keys only in the slots whose byte matched; nearly every lookup
+ * settles in its first group. A group with an empty byte ends the probe.
+ * 
+ * The table grows at 7/8 full. Growing is incremental: a larger table is
+ * allocated, and each later insert or remove moves a few groups of the old
+ * one across, so no single operation pays for rehashing everything. Until
+ * that finishes, lookups check both tables. A table clogged with
+ * tombstones is rebuilt at the same size the same way.
+ * 
+ * Keys are unique: inserting an existing key replaces its value. Not
+ * thread safe.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class SwissTable {
+public:
+#if defined(__AVX2__)
+    static const size_t GROUP_WIDTH = 32;
+#else
+    static const size_t GROUP_WIDTH = 16;
+#endif
+
+    // Old groups moved to the new table per insert or remove while resizing
+    static const size_t MIGRATE_GROUPS_PER_OPERATION = 2;
+    
+    SwissTable();
+    ~SwissTable();
+    
+    SwissTable(const SwissTable&) = delete;
+    SwissTable& operator=(const SwissTable&) = delete;
+    
+    // Insert a key-value pair, replacing the value of an existing key
+    void insert(const Key& key, const Value& value);
+    
+    // Search for a key
+    bool search(const Key& key, Value& value) const;
+    
+    // Remove a key
+    bool remove(const Key& key);
+    
+    // The mixed hash the table uses for key
+    size_t hashOf(const Key& key) const;
+    
+    // The same operations with hash = hashOf(key) already computed
+    void insert(const Key& key, const Value& value, size_t hash);
+    bool search(const Key& key, Value& value, size_t hash) const;
+    bool remove(const Key& key, size_t hash);
+    
+    // Remove every key
+    void clear();
+    
+    // Call fn(key, value) for every entry, in no particular order
+    template<typename Fn>
+    void forEach(Fn fn) const;
+    
+    // Number of entries
+    size_t getCount() const;
+    
+    // Slots in the current table
+    size_t getCapacity() const;
+    
+    // Bytes held by control bytes and slots, of both tables while resizing
+    size_t getMemoryUsage() const;
+    
+    // Whether an incremental resize is under way
+    bool isResizing() const;
+
+private:
+    static const int8_t EMPTY = -128;   // 0b10000000
+    static const int8_t DELETED = -2;   // 0b11111110
+    // Full slots hold the 7-bit hash suffix, 0b0xxxxxxx
+    
+    struct alignas(GROUP_WIDTH) ControlGroup {
+        int8_t bytes[GROUP_WIDTH];
+    };
+    
+    struct Entry {
+        Key key;
+        Value value;
+        
+        Entry(const Key& k, const Value& v) : key(k), value(v) {}
+    };
+    
+    // Raw storage; an entry is constructed only while its control byte is full
+    union Slot {
+        Entry entry;
+        
+        Slot() {}
+        ~Slot() {}
+    };
+    
+    struct Table {
+        std::unique_ptr<ControlGroup[]> control;
+        std::unique_ptr<Slot[]> slots;
+        size_t groups = 0;
+        size_t count = 0;
+        size_t tombstones = 0;
+        size_t growthLeft = 0;  // Empty slots that may still be filled before a resize
+        
+        size_t capacity() const {
+            return groups * GROUP_WIDTH;
+        }
+    };
+    
+    Table current;
+    Table old;              // The table being drained while resizing
+    size_t migratedGroups;  // Groups of old already moved
+    
+    Hash hasher;
+    
+    // Bit i is set where byte i of the group equals h2 / is empty / is empty or deleted
+    static uint32_t matchByte(const ControlGroup& group, int8_t h2);
+    static uint32_t matchEmpty(const ControlGroup& group);
+    static uint32_t matchEmptyOrDeleted(const ControlGroup& group);
+    static int lowestBit(uint32_t mask);
+    
+    // The slot holding key in table, or -1
+    ptrdiff_t find(const Table& table, const Key& key, size_t hash) const;
+    
+    // Place an entry known to be absent; returns its slot
+    size_t insertNew(Table& table, size_t hash, const Key& key, const Value& value);
+    
+    // Empty a full slot, leaving a tombstone only when a probe may pass it
+    void erase(Table& table, size_t slot);
+    
+    static void allocate(Table& table, size_t groups);
+    static void destroy(Table& table);
+    
+    // Start moving into a table of the given number of groups
+    void startResize(size_t groups);
+    
+    // Move up to groups old groups into the current table
+    void migrate(size_t groups);
+};
+
+// Implementation
+template<typename Key, typename Value, typename Hash>
+SwissTable<Key, Value, Hash>::SwissTable() : migratedGroups(0) {
+    allocate(current, 1);
+}
+
+template<typename Key, typename Value, typename Hash>
+SwissTable<Key, Value, Hash>::~SwissTable() {
+    destroy(current);
+    destroy(old);
+}
+
+template<typename Key, typename Value, typename Hash>
+uint32_t SwissTable<Key, Value, Hash>::matchByte(const ControlGroup& group, int8_t h2) {
+#if defined(__AVX2__)
+    __m256i control = _mm256_load_si256(reinterpret_cast<const __m256i*>(group.bytes));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_set1_epi8(h2), control)));
+#elif defined(__SSE2__) || defined(_M_X64)
+    __m128i control = _mm_load_si128(reinterpret_cast<const __m128i*>(group.bytes));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), control)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_WIDTH; ++i) {
+        mask |= static_cast<uint32_t>(group.bytes[i] == h2) << i;
+    }
+    return mask;
+#endif
+}
+
+template<typename Key, typename Value, typename Hash>
+uint32_t SwissTable<Key, Value, Hash>::matchEmpty(const ControlGroup& group) {
+    return matchByte(group, EMPTY);
+}
+
+template<typename Key, typename Value, typename Hash>
+uint32_t SwissTable<Key, Value, Hash>::matchEmptyOrDeleted(const ControlGroup& group) {
+    // Exactly the empty and deleted bytes have the high bit set
+#if defined(__AVX2__)
+    return static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(group.bytes))));
+#elif defined(__SSE2__) || defined(_M_X64)
+    return static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(group.bytes))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_WIDTH; ++i) {
+        mask |= static_cast<uint32_t>(group.bytes[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+template<typename Key, typename Value, typename Hash>
+int SwissTable<Key, Value, Hash>::lowestBit(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#else
+    int bit = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t SwissTable<Key, Value, Hash>::hashOf(const Key& key) const {
+    // std::hash is the identity for integers; mix so both the group index
+    // (high bits) and the control byte (low 7 bits) see every input bit
+    uint64_t hash = static_cast<uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+template<typename Key, typename Value, typename Hash>
+ptrdiff_t SwissTable<Key, Value, Hash>::find(const Table& table, const Key& key, size_t hash) const {
+    if (table.groups == 0) {
+        return -1;
+    }
+    int8_t h2 = static_cast<int8_t>(hash & 0x7F);
+    size_t mask = table.groups - 1;
+    size_t group = (hash >> 7) & mask;
+    for (size_t step = 1; step <= table.groups; ++step) {
+        const ControlGroup& control = table.control[group];
+        for (uint32_t match = matchByte(control, h2); match != 0; match &= match - 1) {
+            size_t slot = group * GROUP_WIDTH + lowestBit(match);
+            if (table.slots[slot].entry.key == key) {
+                return static_cast<ptrdiff_t>(slot);
+            }
+        }
+        if (matchEmpty(control) != 0) {
+            return -1;
+        }
+        // Triangular steps visit every group of a power-of-two table
+        group = (group + step) & mask;
+    }
+    return -1;
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t SwissTable<Key, Value, Hash>::insertNew(Table& table, size_t hash, const Key& key, const Value& value) {
+    size_t mask = table.groups - 1;
+    size_t group = (hash >> 7) & mask;
+    for (size_t step = 1;; ++step) {
+        uint32_t free = matchEmptyOrDeleted(table.control[group]);
+        if (free != 0) {
+            size_t index = lowestBit(free);
+            size_t slot = group * GROUP_WIDTH + index;
+            int8_t& control = table.control[group].bytes[index];
+            if (control == DELETED) {
+                table.tombstones--;
+            } else {
+                table.growthLeft--;
+            }
+            control = static_cast<int8_t>(hash & 0x7F);
+            new (&table.slots[slot].entry) Entry(key, value);
+            table.count++;
+            return slot;
+        }
+        group = (group + step) & mask;
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+void SwissTable<Key, Value, Hash>::erase(Table& table, size_t slot) {
+    table.slots[slot].entry.~Entry();
+    table.count--;
+    ControlGroup& group = table.control[slot / GROUP_WIDTH];
+    
+    // A probe stops at a group with an empty slot, so if this group
+    // already has one, no probe continues past it and the slot can be empty
+    if (matchEmpty(group) != 0) {
+        group.bytes[slot % GROUP_WIDTH] = EMPTY;
+        table.growthLeft++;
+    } else {
+        group.bytes[slot % GROUP_WIDTH] = DELETED;
+        table.tombstones++;
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+void SwissTable<Key, Value, Hash>::allocate(Table& table, size_t groups) {
+    table.control.reset(new ControlGroup[groups]);
+    std::memset(table.control.get(), EMPTY, groups * sizeof(ControlGroup));
+    table.slots.reset(new Slot[groups * GROUP_WIDTH]);
+    table.groups = groups;
+    table.count = 0;
+    table.tombstones = 0;
+    table.growthLeft = table.capacity() * 7 / 8;
+}
+
+template<typename Key, typename Value, typename Hash>
+void SwissTable<Key, Value, Hash>::destroy(Table& table) {
+    // A drained old table has nothing to destroy; skip scanning it
+    for (size_t slot = 0; table.count != 0 && slot < table.capacity(); ++slot) {
+        if (table.control[slot / GROUP_WIDTH].bytes[slot % GROUP_WIDTH] >= 0) {
+            table.slots[slot].entry.~Entry();
+        }
+    }
+    table.control.reset();
+    table.slots.reset();
+    table.groups = 0;
+    table.count = 0;
+    table.tombstones = 0;
+    table.growthLeft = 0;
+}
+
+template<typename Key, typename Value, typename Hash>
+void SwissTable<Key, Value, Hash>::startResize(size_t groups) {
+    // A resize that comes due before the last one finished completes it first
+    migrate(old.groups);
+    old = std::move(current);
+    current = Table();
+    allocate(current, groups);
+    migratedGroups = 0;
+}
+
+template<typename Key, typename Value, typename Hash>
+void SwissTable<Key, Value, Hash>::migrate(size_t groups) {
+    if (old.groups == 0) {
+        return;
+    }
+    size_t end = std::min(old.groups, migratedGroups + groups);
+    for (; migratedGroups < end; ++migratedGroups) {
+        for (size_t index = 0; index < GROUP_WIDTH; ++index) {
+            if (old.control[migratedGroups].bytes[index] < 0) {
+                continue;
+            }
+            size_t slot = migratedGroups * GROUP_WIDTH + index;
+            Entry& entry = old.slots[slot].entry;
+            insertNew(current, hashOf(entry.key), entry.key, entry.value);
+            entry.~Entry();
+            // A tombstone, not empty: probes for keys still in old may pass here
+            old.control[migratedGroups].bytes[index] = DELETED;
+            old.count--;
+        }
+    }
+    if (migratedGroups == old.groups) {
+        destroy(old);
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+void SwissTable<Key, Value, Hash>::insert(const Key& key, const Value& value) {
+    insert(key, value, hashOf(key));
+}
+
+template<typename Key, typename Value, typename Hash>
+void SwissTable<Key, Value, Hash>::insert(const Key& key, const Value& value, size_t hash) {
+    ptrdiff_t slot = find(current, key, hash);
+    if (slot >= 0) {
+        current.slots[slot].entry.value = value;
+        return;
+    }
+    slot = find(old, key, hash);
+    if (slot >= 0) {
+        // Not migrated yet; overwriting in place keeps it where lookups look
+        old.slots[slot].entry.value = value;
+        migrate(MIGRATE_GROUPS_PER_OPERATION);
+        return;
+    }
+    
+    if (current.growthLeft == 0) {
+        // Rebuild at the same size when tombstones, not entries, fill the table
+        size_t live = current.count + old.count;
+        size_t groups = live * 2 <= current.capacity() * 7 / 8 ? current.groups : current.groups * 2;
+        startResize(groups);
+    }
+    insertNew(current, hash, key, value);
+    migrate(MIGRATE_GROUPS_PER_OPERATION);
+}
+
+template<typename Key, typename Value, typename Hash>
+bool SwissTable<Key, Value, Hash>::search(const Key& key, Value& value) const {
+    return search(key, value, hashOf(key));
+}
+
+template<typename Key, typename Value, typename Hash>
+bool SwissTable<Key, Value, Hash>::search(const Key& key, Value& value, size_t hash) const {
+    ptrdiff_t slot = find(current, key, hash);
+    if (slot >= 0) {
+        value = current.slots[slot].entry.value;
+        return true;
+    }
+    slot = find(old, key, hash);
+    if (slot >= 0) {
+        value = old.slots[slot].entry.value;
+        return true;
+    }
+    return false;
+}
+
+template<typename Key, typename Value, typename Hash>
+bool SwissTable<Key, Value, Hash>::remove(const Key& key) {
+    return remove(key, hashOf(key));
+}
+
+template<typename Key, typename Value, typename Hash>
+bool SwissTable<Key, Value, Hash>::remove(const Key& key, size_t hash) {
+    bool removed = false;
+    ptrdiff_t slot = find(current, key, hash);
+    if (slot >= 0) {
+        erase(current, static_cast<size_t>(slot));
+        removed = true;
+    } else {
+        slot = find(old, key, hash);
+        if (slot >= 0) {
+            erase(old, static_cast<size_t>(slot));
+            removed = true;
+        }
+    }
+    migrate(MIGRATE_GROUPS_PER_OPERATION);
+    return removed;
+}
+
+template<typename Key, typename Value, typename Hash>
+void SwissTable<Key, Value, Hash>::clear() {
+    destroy(current);
+    destroy(old);
+    migratedGroups = 0;
+    allocate(current, 1);
+}
+
+template<typename Key, typename Value, typename Hash>
+template<typename Fn>
+void SwissTable<Key, Value, Hash>::forEach(Fn fn) const {
+    for (const Table* table : {&old, &current}) {
+        for (size_t slot = 0; slot < table->capacity(); ++slot) {
+            if (table->control[slot / GROUP_WIDTH].bytes[slot % GROUP_WIDTH] >= 0) {
+                const Entry& entry = table->slots[slot].entry;
+                fn(entry.key, entry.value);
+            }
+        }
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t SwissTable<Key, Value, Hash>::getCount() const {
+    return current.count + old.count;
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t SwissTable<Key, Value, Hash>::getCapacity() const {
+    return current.capacity();
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t SwissTable<Key, Value, Hash>::getMemoryUsage() const {
+    return (current.capacity() + old.capacity()) * (sizeof(Slot) + 1);
+}
+
+template<typename Key, typename Value, typename Hash>
+bool SwissTable<Key, Value, Hash>::isResizing() const {
+    return old.groups != 0;
+}
+
+} // namespace storage
+} // namespace phantomdb
+
+#endif // PHANTOMDB_SWISS_TABLE_H
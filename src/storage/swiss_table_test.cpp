@@ -0,0 +1,146 @@
+#include "swiss_table.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <unordered_map>
+#include <random>
+#include <vector>
+
+using namespace phantomdb::storage;
+
+// Sends every key to the same group and control byte, so every lookup probes
+struct CollidingHash {
+    size_t operator()(int) const {
+        return 0;
+    }
+};
+
+void testBasicOperations() {
+    std::cout << "Testing basic Swiss table operations..." << std::endl;
+    
+    SwissTable<std::string, int> table;
+    int value;
+    assert(!table.search("one", value));
+    assert(!table.remove("one"));
+    
+    table.insert("one", 1);
+    table.insert("two", 2);
+    table.insert("three", 3);
+    assert(table.getCount() == 3);
+    assert(table.search("two", value) && value == 2);
+    
+    table.insert("two", 22);
+    assert(table.getCount() == 3);
+    assert(table.search("two", value) && value == 22);
+    
+    assert(table.remove("one"));
+    assert(!table.search("one", value));
+    assert(table.search("three", value) && value == 3);
+    assert(table.getCount() == 2);
+    
+    table.clear();
+    assert(table.getCount() == 0);
+    assert(!table.search("three", value));
+    
+    std::cout << "Basic operations test passed!" << std::endl;
+}
+
+void testGrowthAndRemoval() {
+    std::cout << "Testing growth, tombstones and incremental resizing..." << std::endl;
+    
+    SwissTable<int, int> table;
+    std::unordered_map<int, int> reference;
+    std::mt19937 rng(3);
+    bool sawResize = false;
+    for (int i = 0; i < 300000; ++i) {
+        int key = static_cast<int>(rng() % 100000);
+        int value;
+        switch (rng() % 4) {
+            case 0:
+                assert(table.remove(key) == (reference.erase(key) == 1));
+                break;
+            case 1:
+                assert(table.search(key, value) == (reference.count(key) == 1));
+                if (reference.count(key) == 1) {
+                    assert(value == reference[key]);
+                }
+                break;
+            default:
+                table.insert(key, i);
+                reference[key] = i;
+                break;
+        }
+        sawResize = sawResize || table.isResizing();
+        assert(table.getCount() == reference.size());
+    }
+    assert(sawResize);
+    
+    size_t visited = 0;
+    table.forEach([&reference, &visited](int key, int value) {
+        assert(reference.at(key) == value);
+        visited++;
+    });
+    assert(visited == reference.size());
+    
+    // Churn over a fixed set of keys must not keep growing the table
+    SwissTable<int, int> churn;
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 0; i < 1000; ++i) {
+            churn.insert(round * 1000 + i, i);
+        }
+        for (int i = 0; i < 1000; ++i) {
+            assert(churn.remove(round * 1000 + i));
+        }
+    }
+    assert(churn.getCount() == 0);
+    assert(churn.getCapacity() <= 4096);
+    
+    std::cout << "Growth and removal test passed!" << std::endl;
+}
+
+void testCollisions() {
+    std::cout << "Testing probing with colliding hashes..." << std::endl;
+    
+    // Every key lands in one group, so lookups walk the whole probe sequence
+    SwissTable<int, int, CollidingHash> table;
+    int value;
+    for (int i = 0; i < 2000; ++i) {
+        table.insert(i, i * 3);
+        
+        // Keys not yet moved out of the old table must stay reachable mid-resize
+        if (table.isResizing()) {
+            for (int key = 0; key <= i; ++key) {
+                assert(table.search(key, value) && value == key * 3);
+            }
+        }
+    }
+    for (int i = 0; i < 2000; i += 2) {
+        assert(table.remove(i));
+    }
+    for (int i = 0; i < 2000; ++i) {
+        assert(table.search(i, value) == (i % 2 == 1));
+        if (i % 2 == 1) {
+            assert(value == i * 3);
+        }
+    }
+    
+    // Tombstones are reused for new keys
+    for (int i = 0; i < 2000; i += 2) {
+        table.insert(i, -i);
+    }
+    assert(table.getCount() == 2000);
+    assert(table.search(1000, value) && value == -1000);
+    
+    std::cout << "Collisions test passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Running Swiss table tests..." << std::endl;
+    
+    testBasicOperations();
+    testGrowthAndRemoval();
+    testCollisions();
+    
+    std::cout << "All Swiss table tests passed!" << std::endl;
+    return 0;
+}
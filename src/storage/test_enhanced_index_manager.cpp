@@ -2,6 +2,11 @@
 #include <iostream>
 #include <cassert>
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
 
 int main() {
     std::cout << "Testing Enhanced Index Manager..." << std::endl;
@@ -75,6 +80,16 @@ int main() {
     std::cout << "\n--- Testing Range Search ---" << std::endl;
     std::vector<std::pair<std::string, std::string>> rangeResults;
     assert(indexManager.rangeSearch("users_id_idx", "1001", "1003", rangeResults));
+    assert(rangeResults.size() == 3);
+    assert(rangeResults.front().first == "1001" && rangeResults.back().first == "1003");
+    rangeResults.clear();
+    assert(indexManager.rangeSearch("users_id_idx", "1000", "1999", rangeResults, 2, true));
+    assert(rangeResults.size() == 2 && rangeResults[0].first == "1003" && rangeResults[1].first == "1002");
+    rangeResults.clear();
+    assert(indexManager.orderedScan("users_id_idx", 1, false, rangeResults));
+    assert(rangeResults.size() == 1 && rangeResults[0].second == "John Doe");
+    rangeResults.clear();
+    assert(!indexManager.rangeSearch("users_email_idx", "a", "z", rangeResults));
     std::cout << "Range search completed successfully" << std::endl;
     
     // Test bulk insert
@@ -87,6 +102,15 @@ int main() {
     assert(indexManager.bulkInsert("users_id_idx", bulkData));
     std::cout << "Bulk insert of 3 items completed successfully" << std::endl;
     
+    // The batch was merged into the B-tree alongside the earlier keys
+    rangeResults.clear();
+    assert(indexManager.rangeSearch("users_id_idx", "1001", "1006", rangeResults));
+    assert(rangeResults.size() == 6 && rangeResults[3].second == "Alice Brown");
+    assert(indexManager.getIndexStats("users_id_idx").keyCount == 6);
+    assert(indexManager.rebuildIndex("users_id_idx"));
+    assert(indexManager.searchInIndex("users_id_idx", "1006", value) && value == "Diana Lee");
+    assert(indexManager.searchInIndex("users_id_idx", "1001", value) && value == "John Doe");
+    
     // Test index statistics
     std::cout << "\n--- Testing Index Statistics ---" << std::endl;
     auto stats = indexManager.getIndexStats("users_id_idx");
@@ -96,6 +120,139 @@ int main() {
     std::cout << "Average lookup time: " << stats.avgLookupTime << " microseconds" << std::endl;
     std::cout << "Average insert time: " << stats.avgInsertTime << " microseconds" << std::endl;
     
+    // LSM-tree indexes also report their compaction work
+    std::vector<std::pair<std::string, std::string>> logData;
+    for (int i = 0; i < 5000; ++i) {
+        logData.emplace_back("2023-12-02T" + std::to_string(100000 + i), "Log entry " + std::to_string(i));
+    }
+    assert(indexManager.bulkInsert("logs_timestamp_idx", logData));
+    for (int i = 0; i < 10; ++i) {
+        assert(!indexManager.searchInIndex("logs_timestamp_idx", "2023-12-03T" + std::to_string(i), value));
+    }
+    auto lsmStats = indexManager.getIndexStats("logs_timestamp_idx");
+    assert(lsmStats.diskUsage > 0);
+    assert(lsmStats.writeAmplification >= 1.0);
+    assert(lsmStats.tablesSkipped >= 10);
+    std::cout << "LSM-tree write amplification: " << lsmStats.writeAmplification << std::endl;
+    std::cout << "LSM-tree pending compaction bytes: " << lsmStats.pendingCompactionBytes << std::endl;
+    std::cout << "LSM-tree compactions: " << lsmStats.compactionCount << std::endl;
+    std::cout << "LSM-tree tables skipped: " << lsmStats.tablesSkipped
+              << ", bloom false-positive rate: " << lsmStats.bloomFalsePositiveRate << std::endl;
+    
+    // Test bitmap filters over low-cardinality columns
+    std::cout << "\n--- Testing Bitmap Filters ---" << std::endl;
+    assert(indexManager.createIndex("orders", "status", phantomdb::storage::IndexType::BITMAP));
+    assert(indexManager.createIndex("orders", "region", phantomdb::storage::IndexType::BITMAP));
+    const char* statuses[] = {"open", "shipped", "closed"};
+    const char* regions[] = {"eu", "us", "apac", "latam"};
+    std::vector<std::pair<std::string, std::string>> statusRows;
+    std::vector<std::pair<std::string, std::string>> regionRows;
+    for (int row = 0; row < 10000; ++row) {
+        statusRows.emplace_back(statuses[row % 3], std::to_string(row));
+        regionRows.emplace_back(regions[row % 4], std::to_string(row));
+    }
+    assert(indexManager.bulkInsert("orders_status_idx", statusRows));
+    assert(indexManager.bulkInsert("orders_region_idx", regionRows));
+    assert(!indexManager.insertIntoIndex("orders_status_idx", "open", "not-a-row"));
+    
+    // WHERE status IN ('open', 'shipped') AND region = 'eu'
+    std::vector<uint32_t> rowIds;
+    std::vector<phantomdb::storage::BitmapPredicate> predicates = {
+        {"orders_status_idx", {"open", "shipped"}, false},
+        {"orders_region_idx", {"eu"}, false}
+    };
+    assert(indexManager.filterBitmap(predicates, rowIds));
+    size_t expected = 0;
+    for (int row = 0; row < 10000; ++row) {
+        expected += (row % 3 != 2 && row % 4 == 0) ? 1 : 0;
+    }
+    assert(rowIds.size() == expected && rowIds[0] == 0 && rowIds[1] == 4);
+    uint64_t count = 0;
+    assert(indexManager.countBitmapFilter(predicates, count) && count == expected);
+    
+    // ... AND region NOT IN ('eu', 'us'), which leaves nothing
+    predicates.push_back({"orders_region_idx", {"eu", "us"}, true});
+    assert(indexManager.filterBitmap(predicates, rowIds) && rowIds.empty());
+    
+    // WHERE status <> 'closed' on its own
+    assert(indexManager.countBitmapFilter({{"orders_status_idx", {"closed"}, true}}, count));
+    assert(count == 10000 - 3333);
+    assert(indexManager.countBitmapFilter({{"orders_status_idx", {"closed", "lost"}, false}}, count));
+    assert(count == 3333);
+    assert(!indexManager.filterBitmap({{"users_id_idx", {"1001"}, false}}, rowIds));
+    
+    assert(indexManager.searchInIndex("orders_region_idx", "latam", value));
+    assert(value.compare(0, 9, "3,7,11,15") == 0);
+    assert(indexManager.rebuildIndex("orders_status_idx"));
+    assert(indexManager.getIndexStats("orders_status_idx").memoryUsage > 0);
+    
+    // Deleting a row of a value keeps the value's other rows
+    size_t regionKeys = indexManager.getIndexStats("orders_region_idx").keyCount;
+    assert(regionKeys == 10000);
+    assert(!indexManager.deleteFromIndex("orders_region_idx", "latam"));
+    assert(indexManager.deleteFromIndex("orders_region_idx", "latam", "3"));
+    assert(!indexManager.deleteFromIndex("orders_region_idx", "latam", "3"));
+    assert(!indexManager.deleteFromIndex("orders_region_idx", "latam", "not-a-row"));
+    assert(indexManager.searchInIndex("orders_region_idx", "latam", value));
+    assert(value.compare(0, 8, "7,11,15,") == 0);
+    assert(indexManager.getIndexStats("orders_region_idx").keyCount == regionKeys - 1);
+    
+    // Removing all of them is a separate call
+    assert(indexManager.deleteValueFromIndex("orders_region_idx", "latam"));
+    assert(!indexManager.searchInIndex("orders_region_idx", "latam", value));
+    assert(indexManager.getIndexStats("orders_region_idx").keyCount == regionKeys - 2500);
+    assert(!indexManager.deleteValueFromIndex("users_id_idx", "1001"));
+    std::cout << "Bitmap filter matched " << expected << " rows" << std::endl;
+    
+    // Test full-text search over a description column
+    std::cout << "\n--- Testing Full-text Search ---" << std::endl;
+    assert(indexManager.createIndex("products", "description", phantomdb::storage::IndexType::FULLTEXT));
+    assert(indexManager.insertIntoIndex("products_description_idx", "1", "Wireless optical mouse"));
+    assert(indexManager.insertIntoIndex("products_description_idx", "2", "Wireless keyboard with wireless mouse"));
+    assert(indexManager.insertIntoIndex("products_description_idx", "3", "Mechanical keyboard"));
+    std::vector<std::pair<std::string, double>> textResults;
+    assert(indexManager.fullTextSearch("products_description_idx", "wireless mouse", textResults));
+    assert(textResults.size() == 2);
+    assert(textResults[0].second >= textResults[1].second);
+    textResults.clear();
+    assert(indexManager.fullTextSearch("products_description_idx", "keyboard mouse", textResults, 10, false));
+    assert(textResults.size() == 3);
+    assert(indexManager.searchInIndex("products_description_idx", "Keyboard", value) && value == "3,2");
+    assert(indexManager.deleteFromIndex("products_description_idx", "2"));
+    assert(indexManager.searchInIndex("products_description_idx", "keyboard", value) && value == "3");
+    assert(indexManager.rebuildIndex("products_description_idx"));
+    assert(!indexManager.fullTextSearch("users_id_idx", "john", textResults));
+    std::cout << "Full-text search completed successfully" << std::endl;
+    
+    // Repeated lookups are answered by the lookup cache in front of the B-tree
+    std::cout << "\n--- Testing Lookup Cache ---" << std::endl;
+    auto beforeLookups = indexManager.getIndexStats("users_id_idx");
+    for (int i = 0; i < 3; ++i) {
+        assert(indexManager.searchInIndex("users_id_idx", "1002", value) && value == "Jane Smith");
+    }
+    auto afterLookups = indexManager.getIndexStats("users_id_idx");
+    assert(afterLookups.lookupCount == beforeLookups.lookupCount + 3);
+    assert(afterLookups.cacheHits == beforeLookups.cacheHits + 2);
+    assert(afterLookups.cacheMisses == beforeLookups.cacheMisses + 1);
+    
+    // A write is seen by the next lookup, not hidden by the cached value
+    assert(indexManager.insertIntoIndex("users_id_idx", "1002", "Jane Doe"));
+    assert(indexManager.searchInIndex("users_id_idx", "1002", value) && value == "Jane Doe");
+    
+    // Shrinking the cache to nothing through the configuration disables it
+    phantomdb::storage::IndexConfig noCacheConfig = indexManager.getIndexConfig("logs_timestamp_idx");
+    noCacheConfig.cacheSize = 0;
+    assert(indexManager.updateIndexConfig("logs_timestamp_idx", noCacheConfig));
+    size_t logHits = indexManager.getIndexStats("logs_timestamp_idx").cacheHits;
+    for (int i = 0; i < 3; ++i) {
+        assert(indexManager.searchInIndex("logs_timestamp_idx", "2023-12-01T11:00:00Z", value) && value == "Log entry 2");
+    }
+    assert(indexManager.getIndexStats("logs_timestamp_idx").cacheHits == logHits);
+    
+    // Hash indexes answer in one probe anyway and have no cache
+    assert(indexManager.getIndexStats("users_email_idx").cacheHits == 0);
+    std::cout << "Lookup cache completed successfully" << std::endl;
+    
     // Test index configuration
     std::cout << "\n--- Testing Index Configuration ---" << std::endl;
     auto config = indexManager.getIndexConfig("users_id_idx");
@@ -108,6 +265,19 @@ int main() {
     assert(indexManager.updateIndexConfig("users_id_idx", newConfig));
     std::cout << "Updated cache size to 5000" << std::endl;
     
+    // Turning compression off and on again rebuilds the B-tree without
+    // losing entries; compressed nodes front-code the keys
+    newConfig.useCompression = false;
+    assert(indexManager.updateIndexConfig("users_id_idx", newConfig));
+    assert(indexManager.searchInIndex("users_id_idx", "1002", value) && value == "Jane Doe");
+    newConfig.useCompression = true;
+    assert(indexManager.updateIndexConfig("users_id_idx", newConfig));
+    rangeResults.clear();
+    assert(indexManager.rangeSearch("users_id_idx", "1001", "1003", rangeResults));
+    assert(rangeResults.size() == 3 && rangeResults[1].second == "Jane Doe");
+    assert(indexManager.getIndexStats("users_id_idx").memoryUsage > 0);
+    std::cout << "Compression toggled successfully" << std::endl;
+    
     // Test auto-indexing
     std::cout << "\n--- Testing Auto-Indexing ---" << std::endl;
     std::vector<std::string> autoColumns = {"name", "age"};
@@ -128,6 +298,248 @@ int main() {
     assert(indexManager.rebuildIndex("users_id_idx"));
     std::cout << "Index operations completed successfully" << std::endl;
     
+    // Index files let a restarted manager attach indexes without the table
+    std::cout << "\n--- Testing Index Files ---" << std::endl;
+    assert(indexManager.flushIndex("users_id_idx", 77));
+    assert(indexManager.flushIndex("users_email_idx", 77));
+    assert(indexManager.getIndexStats("users_id_idx").diskUsage > 0);
+    assert(!indexManager.flushIndex("orders_status_idx"));
+    {
+        phantomdb::storage::EnhancedIndexManager restarted;
+        assert(restarted.setIndexDirectory(indexManager.getIndexDirectory()));
+        assert(restarted.createIndex("users", "id", phantomdb::storage::IndexType::B_TREE, btreeConfig));
+        assert(restarted.createIndex("users", "email", phantomdb::storage::IndexType::HASH, hashConfig));
+        
+        // A file flushed at another lsn than the table's last is stale
+        assert(!restarted.loadIndex("users_id_idx", 78));
+        assert(!restarted.searchInIndex("users_id_idx", "1002", value));
+        
+        assert(restarted.loadIndex("users_id_idx", 77));
+        assert(restarted.loadIndex("users_email_idx", 77));
+        assert(restarted.searchInIndex("users_id_idx", "1002", value) && value == "Jane Doe");
+        assert(restarted.searchInIndex("users_email_idx", "jane@example.com", value) && value == "1002");
+        assert(restarted.getIndexStats("users_id_idx").keyCount ==
+               indexManager.getIndexStats("users_id_idx").keyCount);
+        rangeResults.clear();
+        assert(restarted.rangeSearch("users_id_idx", "1001", "1003", rangeResults) && rangeResults.size() == 3);
+        
+        // Reads are served from the mapped file until the first write
+        std::vector<std::pair<std::string, std::string>> mappedResults;
+        assert(restarted.rangeSearch("users_id_idx", "1001", "1003", mappedResults, 0, true));
+        assert(mappedResults.size() == 3 && mappedResults[0].first == "1003" && mappedResults[2].first == "1001");
+        mappedResults.clear();
+        assert(restarted.orderedScan("users_id_idx", 2, true, mappedResults) && mappedResults.size() == 2);
+        size_t mappedMemory = restarted.getIndexStats("users_id_idx").memoryUsage;
+        assert(restarted.insertIntoIndex("users_id_idx", "1000", "Ann Lee"));
+        assert(restarted.getIndexStats("users_id_idx").memoryUsage > mappedMemory);
+        rangeResults.clear();
+        assert(restarted.rangeSearch("users_id_idx", "1000", "1003", rangeResults) && rangeResults.size() == 4);
+        assert(rangeResults[0].second == "Ann Lee" && rangeResults[2].second == "Jane Doe");
+        assert(restarted.insertIntoIndex("users_email_idx", "ann@example.com", "1000"));
+        assert(restarted.searchInIndex("users_email_idx", "jane@example.com", value) && value == "1002");
+        assert(restarted.searchInIndex("users_email_idx", "ann@example.com", value) && value == "1000");
+        
+        // Dropping an index deletes its file
+        assert(restarted.dropIndex("users_email_idx"));
+        assert(restarted.createIndex("users", "email", phantomdb::storage::IndexType::HASH, hashConfig));
+        assert(!restarted.loadIndex("users_email_idx", 77));
+    }
+    std::cout << "Index files completed successfully" << std::endl;
+    
+    // Online builds index a live table while writes keep coming
+    std::cout << "\n--- Testing Online Index Builds ---" << std::endl;
+    std::vector<std::pair<std::string, std::string>> snapshot;
+    for (int i = 0; i < 20000; ++i) {
+        snapshot.emplace_back("sku-" + std::to_string(i), "row-" + std::to_string(i));
+    }
+    std::atomic<bool> released{false};
+    auto scan = [&snapshot, &released](size_t partition, size_t partitionCount,
+                                       const std::function<void(const std::string&, const std::string&)>& emit) {
+        while (!released) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        for (size_t row = partition; row < snapshot.size(); row += partitionCount) {
+            emit(snapshot[row].first, snapshot[row].second);
+        }
+    };
+    assert(indexManager.createIndexOnline("inventory", "sku", phantomdb::storage::IndexType::B_TREE,
+                                          phantomdb::storage::IndexConfig{}, scan, 4, snapshot.size()));
+    
+    // Until the build is done, lookups fail and writes go to the side log
+    assert(!indexManager.isIndexReady("inventory_sku_idx"));
+    assert(!indexManager.searchInIndex("inventory_sku_idx", "sku-1", value));
+    assert(!indexManager.rangeSearch("inventory_sku_idx", "sku-1", "sku-2", rangeResults));
+    assert(indexManager.insertIntoIndex("inventory_sku_idx", "sku-new", "row-new"));
+    assert(indexManager.insertIntoIndex("inventory_sku_idx", "sku-1", "row-1-updated"));
+    assert(indexManager.deleteFromIndex("inventory_sku_idx", "sku-2"));
+    assert(!indexManager.rebuildIndex("inventory_sku_idx"));
+    auto building = indexManager.getIndexStats("inventory_sku_idx");
+    assert(building.buildPhase == phantomdb::storage::IndexBuildPhase::SCANNING);
+    assert(building.buildProgress < 1.0 && building.sideLogEntries == 3);
+    
+    released = true;
+    assert(indexManager.waitForIndexBuild("inventory_sku_idx"));
+    assert(indexManager.isIndexReady("inventory_sku_idx"));
+    auto built = indexManager.getIndexStats("inventory_sku_idx");
+    assert(built.buildPhase == phantomdb::storage::IndexBuildPhase::READY && built.buildProgress == 1.0);
+    assert(built.keyCount == snapshot.size());
+    assert(indexManager.searchInIndex("inventory_sku_idx", "sku-19999", value) && value == "row-19999");
+    assert(indexManager.searchInIndex("inventory_sku_idx", "sku-new", value) && value == "row-new");
+    assert(indexManager.searchInIndex("inventory_sku_idx", "sku-1", value) && value == "row-1-updated");
+    assert(!indexManager.searchInIndex("inventory_sku_idx", "sku-2", value));
+    
+    // Hash indexes build the same way; a failed scan leaves the index unusable
+    assert(indexManager.createIndexOnline("inventory", "barcode", phantomdb::storage::IndexType::HASH,
+                                          phantomdb::storage::IndexConfig{}, scan));
+    assert(indexManager.waitForIndexBuild("inventory_barcode_idx"));
+    assert(indexManager.searchInIndex("inventory_barcode_idx", "sku-42", value) && value == "row-42");
+    auto failingScan = [](size_t, size_t, const std::function<void(const std::string&, const std::string&)>&) {
+        throw std::runtime_error("table dropped");
+    };
+    assert(indexManager.createIndexOnline("inventory", "bin", phantomdb::storage::IndexType::B_TREE,
+                                          phantomdb::storage::IndexConfig{}, failingScan, 2));
+    assert(!indexManager.waitForIndexBuild("inventory_bin_idx"));
+    assert(indexManager.getIndexStats("inventory_bin_idx").buildPhase == phantomdb::storage::IndexBuildPhase::FAILED);
+    assert(!indexManager.insertIntoIndex("inventory_bin_idx", "a", "b"));
+    assert(indexManager.dropIndex("inventory_bin_idx"));
+    assert(!indexManager.createIndexOnline("inventory", "log", phantomdb::storage::IndexType::LSM_TREE,
+                                           phantomdb::storage::IndexConfig{}, scan));
+    
+    // Lookups from other threads while two threads race to switch the build in
+    assert(indexManager.createIndexOnline("inventory", "lot", phantomdb::storage::IndexType::HASH,
+                                          phantomdb::storage::IndexConfig{}, scan, 2));
+    std::atomic<int> readersDone{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&indexManager, &readersDone, t]() {
+            std::string found;
+            std::string key = "sku-" + std::to_string(t * 1000);
+            while (!indexManager.searchInIndex("inventory_lot_idx", key, found)) {
+                std::this_thread::yield();
+            }
+            assert(found == "row-" + std::to_string(t * 1000));
+            readersDone++;
+        });
+    }
+    for (int t = 0; t < 2; ++t) {
+        workers.emplace_back([&indexManager]() {
+            while (!indexManager.finishIndexBuild("inventory_lot_idx")) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    assert(readersDone == 4);
+    assert(indexManager.isIndexReady("inventory_lot_idx"));
+    assert(indexManager.getIndexStats("inventory_lot_idx").keyCount == snapshot.size());
+    assert(indexManager.waitForIndexBuild("inventory_lot_idx"));
+    std::cout << "Online index builds completed successfully" << std::endl;
+    
+    // Concurrent lookups all get counted
+    std::cout << "\n--- Testing Concurrent Lookups ---" << std::endl;
+    size_t hashLookups = indexManager.getIndexStats("inventory_lot_idx").lookupCount;
+    size_t btreeLookups = indexManager.getIndexStats("users_id_idx").lookupCount;
+    std::vector<std::thread> searchers;
+    for (int t = 0; t < 4; ++t) {
+        searchers.emplace_back([&indexManager, t]() {
+            std::string found;
+            for (int i = 0; i < 500; ++i) {
+                std::string key = "sku-" + std::to_string((t * 500 + i) % 20000);
+                assert(indexManager.searchInIndex("inventory_lot_idx", key, found) && found[0] == 'r');
+                assert(indexManager.searchInIndex("users_id_idx", i % 2 ? "1002" : "1001", found));
+            }
+        });
+    }
+    for (auto& searcher : searchers) {
+        searcher.join();
+    }
+    auto lotStats = indexManager.getIndexStats("inventory_lot_idx");
+    assert(lotStats.lookupCount == hashLookups + 2000 && lotStats.avgLookupTime >= 0.0);
+    assert(indexManager.getIndexStats("users_id_idx").lookupCount == btreeLookups + 2000);
+    std::cout << "Concurrent lookups completed successfully" << std::endl;
+    
+    // Test composite and covering indexes
+    std::cout << "\n--- Testing Composite Indexes ---" << std::endl;
+    using phantomdb::storage::KeyColumnType;
+    phantomdb::storage::IndexConfig compositeConfig;
+    compositeConfig.useCompression = true;
+    assert(indexManager.createCompositeIndex("events", {{"tenant_id", KeyColumnType::INT64},
+                                                        {"created_at", KeyColumnType::STRING}},
+                                             {"kind", "amount"}, compositeConfig));
+    const std::string eventsIdx = "events_tenant_id_created_at_idx";
+    for (int i = 0; i < 300; ++i) {
+        std::string day = "2024-01-" + std::string(i % 30 < 9 ? "0" : "") + std::to_string(i % 30 + 1);
+        assert(indexManager.insertRow(eventsIdx, {std::to_string(i % 3 - 1), day}, "row-" + std::to_string(i),
+                                      {i % 2 ? "click" : "view", std::to_string(i)}));
+    }
+    
+    // Tenant 1 of (tenant_id, created_at) with created_at in a week: the
+    // index alone answers it, in key order
+    phantomdb::storage::CompositeKeyRange week;
+    week.prefix = {"1"};
+    week.hasLower = true;
+    week.lower = "2024-01-10";
+    week.hasUpper = true;
+    week.upper = "2024-01-16";
+    std::vector<phantomdb::storage::IndexRow> rows;
+    assert(indexManager.searchComposite(eventsIdx, week, rows));
+    assert(rows.size() == 20);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        assert(rows[i].keyValues.size() == 2 && rows[i].keyValues[0] == "1");
+        assert(rows[i].keyValues[1] >= "2024-01-10" && rows[i].keyValues[1] <= "2024-01-16");
+        assert(i == 0 || rows[i - 1].keyValues[1] <= rows[i].keyValues[1]);
+        int row = std::stoi(rows[i].rowId.substr(4));
+        assert(rows[i].includeValues.size() == 2 && rows[i].includeValues[1] == std::to_string(row));
+        assert(rows[i].includeValues[0] == (row % 2 ? "click" : "view"));
+    }
+    assert(indexManager.coversColumns(eventsIdx, {"tenant_id", "created_at", "amount"}));
+    assert(!indexManager.coversColumns(eventsIdx, {"tenant_id", "payload"}));
+    assert(!indexManager.coversColumns("users_id_idx", {"id"}));
+    
+    // Integers order numerically, negative ones first
+    phantomdb::storage::CompositeKeyRange all;
+    rows.clear();
+    assert(indexManager.searchComposite(eventsIdx, all, rows, 0, true));
+    assert(rows.size() == 300 && rows.front().keyValues[0] == "1" && rows.back().keyValues[0] == "-1");
+    rows.clear();
+    phantomdb::storage::CompositeKeyRange tenant;
+    tenant.prefix = {"-1"};
+    assert(indexManager.searchComposite(eventsIdx, tenant, rows, 5));
+    assert(rows.size() == 5 && rows[0].keyValues[0] == "-1" && rows[0].keyValues[1] == "2024-01-01");
+    
+    // Rows sharing key values are told apart by row id
+    rows.clear();
+    tenant.prefix = {"0"};
+    assert(indexManager.searchComposite(eventsIdx, tenant, rows));
+    size_t tenantRows = rows.size();
+    assert(indexManager.deleteRow(eventsIdx, {rows[0].keyValues[0], rows[0].keyValues[1]}, rows[0].rowId));
+    rows.clear();
+    assert(indexManager.searchComposite(eventsIdx, tenant, rows) && rows.size() == tenantRows - 1);
+    
+    // Bad rows and ranges are rejected
+    assert(!indexManager.insertRow(eventsIdx, {"ten", "2024-01-01"}, "row-x", {"view", "1"}));
+    assert(!indexManager.insertRow(eventsIdx, {"1"}, "row-x", {"view", "1"}));
+    assert(!indexManager.insertRow(eventsIdx, {"1", "2024-01-01"}, "row-x"));
+    phantomdb::storage::CompositeKeyRange tooLong;
+    tooLong.prefix = {"1", "2024-01-01"};
+    tooLong.hasLower = true;
+    assert(!indexManager.searchComposite(eventsIdx, tooLong, rows));
+    assert(!indexManager.searchComposite("users_id_idx", all, rows));
+    
+    // Encoded rows load in bulk like any other entries
+    std::vector<std::pair<std::string, std::string>> encodedRows(1);
+    assert(indexManager.encodeIndexRow(eventsIdx, {"7", "2024-02-01"}, "row-b", {"view", "5"},
+                                       encodedRows[0].first, encodedRows[0].second));
+    assert(indexManager.bulkInsert(eventsIdx, encodedRows));
+    rows.clear();
+    tenant.prefix = {"7"};
+    assert(indexManager.searchComposite(eventsIdx, tenant, rows) && rows.size() == 1 && rows[0].rowId == "row-b");
+    indexManager.listIndexes();
+    assert(indexManager.dropIndex(eventsIdx));
+    std::cout << "Composite indexes completed successfully" << std::endl;
+    
     // Test deleting data from indexes
     std::cout << "\n--- Testing Data Deletion ---" << std::endl;
     assert(indexManager.deleteFromIndex("users_id_idx", "1001"));
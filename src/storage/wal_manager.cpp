@@ -1,132 +1,837 @@
 #include "wal_manager.h"
-#include <fstream>
+#include "utils.h"
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <mutex>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace phantomdb {
 namespace storage {
 
+namespace {
+
+using core::utils::putVarint;
+using core::utils::getVarint;
+using core::utils::putFixed32;
+using core::utils::putFixed64;
+using core::utils::getFixed;
+
+const size_t RECORD_HEADER_SIZE = 16;
+
+// Segment header block: "PHDBWAL\0" | u64 segment id | u64 lsn before the
+// segment | u32 crc32 of the preceding 24 bytes, zero-padded to one block
+const size_t SEGMENT_HEADER_SIZE = 4096;
+const char SEGMENT_MAGIC[8] = {'P', 'H', 'D', 'B', 'W', 'A', 'L', '\0'};
+const size_t DIRECT_IO_ALIGNMENT = 4096;
+const size_t MAX_SPARE_SEGMENTS = 4;
+const char* const SPARE_SUFFIX = "spare.";
+
+std::string segmentSuffix(uint64_t id) {
+    char digits[32];
+    std::snprintf(digits, sizeof(digits), "%08llu", static_cast<unsigned long long>(id));
+    return digits;
+}
+
+// Copy bytes into a block-aligned buffer for O_DIRECT writes
+class AlignedBuffer {
+public:
+    char* assign(const std::string& bytes) {
+        storage_.resize(bytes.size() + DIRECT_IO_ALIGNMENT);
+        auto address = reinterpret_cast<uintptr_t>(storage_.data());
+        char* aligned = storage_.data() + (DIRECT_IO_ALIGNMENT - address % DIRECT_IO_ALIGNMENT) % DIRECT_IO_ALIGNMENT;
+        std::memcpy(aligned, bytes.data(), bytes.size());
+        return aligned;
+    }
+
+private:
+    std::vector<char> storage_;
+};
+
+// Raw file descriptor: the log needs positioned writes, preallocation and
+// fdatasync, none of which stdio offers
+class SegmentFile {
+public:
+    SegmentFile() : fd_(-1), direct_(false) {}
+    ~SegmentFile() { close(); }
+    
+    SegmentFile(const SegmentFile&) = delete;
+    SegmentFile& operator=(const SegmentFile&) = delete;
+    
+    bool open(const std::string& path, bool direct) {
+        close();
+#ifdef _WIN32
+        (void)direct;
+        fd_ = ::_open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        int flags = O_RDWR | O_CREAT;
+#ifdef O_DIRECT
+        if (direct) {
+            fd_ = ::open(path.c_str(), flags | O_DIRECT, 0644);
+            direct_ = fd_ >= 0;
+        }
+#else
+        (void)direct;
+#endif
+        if (fd_ < 0) {
+            // Not every file system supports O_DIRECT (tmpfs, for one)
+            fd_ = ::open(path.c_str(), flags, 0644);
+        }
+#endif
+        return fd_ >= 0;
+    }
+    
+    bool isOpen() const { return fd_ >= 0; }
+    bool isDirect() const { return direct_; }
+    
+    // Allocate blocks up front so appends never extend the file
+    bool preallocate(uint64_t size) {
+#ifdef _WIN32
+        return ::_chsize_s(fd_, static_cast<long long>(size)) == 0;
+#else
+        struct stat info;
+        if (::fstat(fd_, &info) == 0 && static_cast<uint64_t>(info.st_size) >= size) {
+            return true;
+        }
+#ifdef __linux__
+        return ::posix_fallocate(fd_, 0, static_cast<off_t>(size)) == 0;
+#else
+        return ::ftruncate(fd_, static_cast<off_t>(size)) == 0;
+#endif
+#endif
+    }
+    
+    bool writeAt(uint64_t offset, const char* data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            if (::_lseeki64(fd_, static_cast<long long>(offset), SEEK_SET) < 0) {
+                return false;
+            }
+            int written = ::_write(fd_, data, static_cast<unsigned int>(size));
+#else
+            ssize_t written = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<uint64_t>(written);
+        }
+        return true;
+    }
+    
+    bool sync() {
+#ifdef _WIN32
+        return ::_commit(fd_) == 0;
+#elif defined(__APPLE__)
+        return ::fsync(fd_) == 0;
+#else
+        return ::fdatasync(fd_) == 0;
+#endif
+    }
+    
+    void close() {
+        if (fd_ >= 0) {
+#ifdef _WIN32
+            ::_close(fd_);
+#else
+            ::close(fd_);
+#endif
+            fd_ = -1;
+        }
+        direct_ = false;
+    }
+
+private:
+    int fd_;
+    bool direct_;
+};
+
+// Make a new or renamed file name durable
+void syncDirectory(const std::string& directory) {
+#ifndef _WIN32
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)directory;
+#endif
+}
+
+void putString(std::string& out, const std::string& value) {
+    putVarint(out, value.size());
+    out.append(value);
+}
+
+bool getString(const std::string& in, size_t& pos, std::string& value) {
+    uint64_t length;
+    if (!getVarint(in, pos, length) || length > in.size() - pos) {
+        return false;
+    }
+    value.assign(in, pos, length);
+    pos += length;
+    return true;
+}
+
+void putFields(std::string& out, const WALRecord::Fields& fields) {
+    putVarint(out, fields.size());
+    for (const auto& field : fields) {
+        putString(out, field.first);
+        putString(out, field.second);
+    }
+}
+
+bool getFields(const std::string& in, size_t& pos, WALRecord::Fields& fields) {
+    uint64_t count;
+    if (!getVarint(in, pos, count)) {
+        return false;
+    }
+    fields.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string key, value;
+        if (!getString(in, pos, key) || !getString(in, pos, value)) {
+            return false;
+        }
+        fields.emplace_back(std::move(key), std::move(value));
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+std::string WALRecord::encode() const {
+    std::string payload;
+    payload.push_back(static_cast<char>(type));
+    putVarint(payload, static_cast<uint64_t>(timestamp));
+    if (type == WALRecordType::CUSTOM) {
+        putString(payload, operation);
+    }
+    putString(payload, table);
+    putFields(payload, columns);
+    putFields(payload, data);
+    putFields(payload, condition);
+    return payload;
+}
+
+bool WALRecord::decode(const std::string& payload) {
+    if (payload.empty() || static_cast<uint8_t>(payload[0]) > static_cast<uint8_t>(WALRecordType::DELETE)) {
+        return false;
+    }
+    type = static_cast<WALRecordType>(payload[0]);
+    
+    size_t pos = 1;
+    uint64_t micros;
+    if (!getVarint(payload, pos, micros)) {
+        return false;
+    }
+    timestamp = static_cast<int64_t>(micros);
+    
+    if (type == WALRecordType::CUSTOM) {
+        if (!getString(payload, pos, operation)) {
+            return false;
+        }
+    } else {
+        operation = typeName(type);
+    }
+    return getString(payload, pos, table) &&
+           getFields(payload, pos, columns) &&
+           getFields(payload, pos, data) &&
+           getFields(payload, pos, condition) &&
+           pos == payload.size();
+}
+
+const char* WALRecord::typeName(WALRecordType type) {
+    switch (type) {
+        case WALRecordType::CREATE_DATABASE: return "CREATE_DATABASE";
+        case WALRecordType::DROP_DATABASE: return "DROP_DATABASE";
+        case WALRecordType::CREATE_TABLE: return "CREATE_TABLE";
+        case WALRecordType::DROP_TABLE: return "DROP_TABLE";
+        case WALRecordType::INSERT: return "INSERT";
+        case WALRecordType::UPDATE: return "UPDATE";
+        case WALRecordType::DELETE: return "DELETE";
+        default: return "CUSTOM";
+    }
+}
+
+WALRecordType WALRecord::typeFromName(const std::string& operation) {
+    for (uint8_t i = 1; i <= static_cast<uint8_t>(WALRecordType::DELETE); ++i) {
+        auto type = static_cast<WALRecordType>(i);
+        if (operation == typeName(type)) {
+            return type;
+        }
+    }
+    return WALRecordType::CUSTOM;
+}
+
 class WALManager::Impl {
 public:
-    Impl() : logFileName_("wal.log"), isOpen_(false) {}
+    struct Segment {
+        uint64_t id = 0;
+        std::string path;
+        uint64_t prevLsn = 0;       // Last lsn before this segment
+        uint64_t lastLsn = 0;       // Last lsn appended to this segment
+        uint64_t appendOffset = 0;  // End of the appended records
+        
+        // Owned by the commit leader
+        SegmentFile file;
+        std::string tail;           // Direct I/O: the last partial block as on disk
+        bool dirty = false;         // Written since the last sync
+        bool complete = false;      // Sealed and fully written
+    };
+    
+    // Bytes appended to a segment, waiting for a commit leader
+    struct PendingWrite {
+        std::shared_ptr<Segment> segment;
+        uint64_t offset;
+        std::string bytes;
+        bool final;                 // The segment was sealed after these bytes
+    };
+    
+    // Outcome of scanning one segment
+    struct ScanResult {
+        uint64_t validEnd = SEGMENT_HEADER_SIZE;
+        uint64_t lastLsn = 0;
+        bool clean = true;          // Ended at a terminator or end of file, not a torn record
+    };
+    
+    explicit Impl(const std::string& logFileName)
+        : logFileName_(logFileName),
+          segmentSize_(DEFAULT_SEGMENT_SIZE),
+          directIO_(false),
+          isOpen_(false),
+          nextSegmentId_(1),
+          bufferOffset_(0),
+          lastLsn_(0),
+          writtenLsn_(0),
+          durableLsn_(0),
+          leaderActive_(false),
+          failed_(false) {}
+    
     ~Impl() {
-        if (isOpen_) {
-            closeLog();
-        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        closeLog(lock, false);
     }
     
+    // All members below are guarded by mutex_ unless noted otherwise
     bool openLog() {
         if (isOpen_) {
             return true;
         }
         
-        fileStream_.open(logFileName_, std::ios::binary | std::ios::app);
-        if (!fileStream_.is_open()) {
-            std::cerr << "Failed to open WAL log file: " << logFileName_ << std::endl;
-            return false;
+        std::filesystem::path pathObj(logFileName_);
+        std::filesystem::path directory = pathObj.has_parent_path() ? pathObj.parent_path() : std::filesystem::path(".");
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        
+        // Find segment files and spares
+        std::string prefix = pathObj.filename().string() + ".";
+        std::vector<std::pair<uint64_t, std::string>> files;
+        spares_.clear();
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+            std::string name = entry.path().filename().string();
+            if (name.compare(0, prefix.size(), prefix) != 0) {
+                continue;
+            }
+            std::string suffix = name.substr(prefix.size());
+            if (suffix.compare(0, std::strlen(SPARE_SUFFIX), SPARE_SUFFIX) == 0) {
+                spares_.push_back(entry.path().string());
+            } else if (!suffix.empty() && suffix.find_first_not_of("0123456789") == std::string::npos) {
+                files.emplace_back(std::stoull(suffix), entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        
+        // Follow the chain until a segment does not continue where the
+        // previous one ended. A segment cut short by a torn record is only
+        // followed by one started after the crash.
+        segments_.clear();
+        uint64_t lastLsn = 0;
+        bool broken = false;
+        bool torn = false;
+        size_t chained = 0;
+        for (const auto& file : files) {
+            nextSegmentId_ = std::max(nextSegmentId_, file.first + 1);
+            if (broken) {
+                continue;
+            }
+            
+            auto segment = std::make_shared<Segment>();
+            segment->id = file.first;
+            segment->path = file.second;
+            if (!readHeader(*segment) || (chained > 0 && segment->prevLsn != lastLsn)) {
+                broken = true;
+                continue;
+            }
+            if (chained == 0) {
+                lastLsn = segment->prevLsn;
+            }
+            
+            ScanResult result;
+            if (!scanSegment(*segment, lastLsn, nullptr, 0, result)) {
+                return false;
+            }
+            segment->lastLsn = result.lastLsn;
+            segment->appendOffset = result.validEnd;
+            segment->complete = true;
+            lastLsn = result.lastLsn;
+            segments_.push_back(segment);
+            chained++;
+            torn = !result.clean;
+            if (torn) {
+                std::cerr << "WAL segment " << segment->path << " ends in a torn record at offset "
+                          << result.validEnd << std::endl;
+            }
+        }
+        
+        // Segments past the break hold nothing that was ever committed
+        for (size_t i = chained; i < files.size(); ++i) {
+            releaseFile(files[i].second, files[i].first);
         }
         
+        lastLsn_ = writtenLsn_ = durableLsn_ = lastLsn;
+        if (segments_.empty() || torn) {
+            // Never append behind a torn write: stale bytes after it could
+            // otherwise be read back as records
+            if (!startSegment()) {
+                return false;
+            }
+        } else {
+            auto& active = segments_.back();
+            active->complete = false;
+            if (!active->file.open(active->path, directIO_) || !loadTail(*active)) {
+                std::cerr << "Failed to open WAL segment: " << active->path << std::endl;
+                return false;
+            }
+        }
+        bufferOffset_ = segments_.back()->appendOffset;
         isOpen_ = true;
-        std::cout << "WAL log opened successfully: " << logFileName_ << std::endl;
         return true;
     }
     
-    bool closeLog() {
+    void closeLog(std::unique_lock<std::mutex>& lock, bool syncData) {
         if (!isOpen_) {
-            return true;
+            return;
         }
-        
-        fileStream_.close();
+        writeOut(lock, lastLsn_, syncData);
+        cv_.wait(lock, [this]() { return !leaderActive_; });
+        for (auto& segment : segments_) {
+            segment->file.close();
+        }
+        segments_.clear();
         isOpen_ = false;
-        std::cout << "WAL log closed successfully" << std::endl;
+    }
+    
+    bool append(uint64_t lsn, const std::string& payload) {
+        if (lsn <= lastLsn_) {
+            std::cerr << "WAL lsn " << lsn << " is not above the last lsn " << lastLsn_ << std::endl;
+            return false;
+        }
+        
+        std::string frame;
+        frame.reserve(RECORD_HEADER_SIZE + payload.size());
+        putFixed32(frame, static_cast<uint32_t>(payload.size()));
+        uint32_t crc = 0;
+        putFixed32(frame, crc); // Checksum placeholder
+        putFixed64(frame, lsn);
+        crc = core::utils::crc32(frame.data() + 8, 8);
+        crc = core::utils::crc32(payload.data(), payload.size(), crc);
+        for (int i = 0; i < 4; ++i) {
+            frame[4 + i] = static_cast<char>((crc >> (8 * i)) & 0xFF);
+        }
+        frame.append(payload);
+        
+        // A record that does not fit goes to a fresh segment, unless it
+        // would not fit into any segment
+        auto active = segments_.back();
+        if (active->appendOffset > SEGMENT_HEADER_SIZE && active->appendOffset + frame.size() > segmentSize_) {
+            pending_.push_back({active, bufferOffset_, std::move(buffer_), true});
+            buffer_.clear();
+            if (!startSegment()) {
+                failed_ = true;
+                return false;
+            }
+            active = segments_.back();
+            bufferOffset_ = active->appendOffset;
+        }
+        
+        buffer_.append(frame);
+        active->appendOffset += frame.size();
+        active->lastLsn = lsn;
+        lastLsn_ = lsn;
+        stats_.recordsAppended++;
         return true;
     }
     
-    bool writeLogEntry(const std::string& data) {
-        if (!isOpen_) {
-            if (!openLog()) {
+    /**
+     * @brief Wait until records up to target are written (and synced)
+     * 
+     * The first thread to find no leader at work becomes the leader: it
+     * takes every buffered byte, writes and syncs outside the lock, then
+     * publishes the new durable lsn. Threads arriving meanwhile append to
+     * the next batch and wait; one of them leads the following round.
+     */
+    bool writeOut(std::unique_lock<std::mutex>& lock, uint64_t target, bool syncData) {
+        while (true) {
+            if (failed_) {
                 return false;
             }
+            if (syncData ? durableLsn_ >= target : writtenLsn_ >= target) {
+                return true;
+            }
+            if (leaderActive_) {
+                cv_.wait(lock);
+                continue;
+            }
+            
+            leaderActive_ = true;
+            std::vector<PendingWrite> writes = std::move(pending_);
+            pending_.clear();
+            if (!buffer_.empty()) {
+                writes.push_back({segments_.back(), bufferOffset_, std::move(buffer_), false});
+                bufferOffset_ += writes.back().bytes.size();
+                buffer_.clear();
+            }
+            uint64_t batchLsn = lastLsn_;
+            lock.unlock();
+            
+            bool ok = true;
+            uint64_t bytes = 0;
+            for (auto& write : writes) {
+                ok = writeChunk(*write.segment, write.offset, write.bytes) && ok;
+                bytes += write.bytes.size();
+                write.segment->complete = write.final;
+                if (!write.segment->dirty) {
+                    write.segment->dirty = true;
+                    dirty_.push_back(write.segment);
+                }
+            }
+            bool synced = false;
+            if (syncData && !dirty_.empty()) {
+                for (auto& segment : dirty_) {
+                    if (segment->file.isOpen()) { // Closed if recycled meanwhile
+                        ok = segment->file.sync() && ok;
+                    }
+                    segment->dirty = false;
+                    if (segment->complete) {
+                        segment->file.close();
+                    }
+                }
+                dirty_.clear();
+                synced = true;
+            }
+            
+            lock.lock();
+            leaderActive_ = false;
+            if (!ok) {
+                std::cerr << "Failed to write WAL segment for " << logFileName_ << std::endl;
+                failed_ = true;
+            }
+            writtenLsn_ = batchLsn;
+            if (syncData) {
+                durableLsn_ = batchLsn;
+            }
+            stats_.bytesWritten += bytes;
+            stats_.syncs += synced ? 1 : 0;
+            cv_.notify_all();
+        }
+    }
+    
+    bool replay(std::unique_lock<std::mutex>& lock, const ReplayHandler& handler, uint64_t fromLsn) {
+        if (!writeOut(lock, lastLsn_, false)) {
+            return false;
         }
+        // Don't read bytes a leader is writing right now
+        cv_.wait(lock, [this]() { return !leaderActive_; });
         
-        // Get current timestamp
-        auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
+        uint64_t lastLsn = segments_.empty() ? 0 : segments_.front()->prevLsn;
+        for (size_t i = 0; i < segments_.size(); ++i) {
+            // A segment followed by one starting at or below fromLsn has nothing to replay
+            if (i + 1 < segments_.size() && segments_[i + 1]->prevLsn <= fromLsn) {
+                lastLsn = segments_[i + 1]->prevLsn;
+                continue;
+            }
+            
+            ScanResult result;
+            if (!scanSegment(*segments_[i], lastLsn, &handler, fromLsn, result)) {
+                return false;
+            }
+            lastLsn = result.lastLsn;
+            if (!result.clean && (i + 1 == segments_.size() || segments_[i + 1]->prevLsn != lastLsn)) {
+                std::cerr << "WAL replay stopped at a torn or corrupt record at offset " << result.validEnd
+                          << ": " << segments_[i]->path << std::endl;
+                break;
+            }
+        }
+        return true;
+    }
+    
+    size_t recycle(std::unique_lock<std::mutex>& lock, uint64_t lsn) {
+        cv_.wait(lock, [this]() { return !leaderActive_; });
         
-        // Create log entry format: [timestamp][data_length][data]
-        uint32_t dataLength = static_cast<uint32_t>(data.length());
+        size_t released = 0;
+        // Records covered by the checkpoint need not be durable themselves,
+        // but a sealed segment must have been written out in full
+        while (segments_.size() > 1 && segments_.front()->lastLsn <= lsn && segments_.front()->complete) {
+            auto segment = segments_.front();
+            segments_.erase(segments_.begin());
+            segment->file.close();
+            releaseFile(segment->path, segment->id);
+            stats_.segmentsRecycled++;
+            released++;
+        }
+        return released;
+    }
+    
+    std::string segmentPath(uint64_t id) const {
+        return logFileName_ + "." + segmentSuffix(id);
+    }
+    
+    // Keep a retired segment file as a spare, or delete it if there are enough
+    void releaseFile(const std::string& path, uint64_t id) {
+        std::error_code ec;
+        if (spares_.size() < MAX_SPARE_SEGMENTS) {
+            std::string sparePath = logFileName_ + "." + SPARE_SUFFIX + segmentSuffix(id);
+            std::filesystem::rename(path, sparePath, ec);
+            if (!ec) {
+                spares_.push_back(sparePath);
+                return;
+            }
+        }
+        std::filesystem::remove(path, ec);
+    }
+    
+    // Begin a new active segment, reusing a spare file when there is one
+    bool startSegment() {
+        auto segment = std::make_shared<Segment>();
+        segment->id = nextSegmentId_++;
+        segment->path = segmentPath(segment->id);
+        segment->prevLsn = lastLsn_;
+        segment->lastLsn = lastLsn_;
+        segment->appendOffset = SEGMENT_HEADER_SIZE;
         
-        fileStream_.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
-        fileStream_.write(reinterpret_cast<const char*>(&dataLength), sizeof(dataLength));
-        fileStream_.write(data.c_str(), dataLength);
+        bool reused = false;
+        while (!spares_.empty() && !reused) {
+            std::error_code ec;
+            std::filesystem::rename(spares_.back(), segment->path, ec);
+            spares_.pop_back();
+            reused = !ec;
+        }
         
-        // Flush to ensure durability
-        fileStream_.flush();
+        if (!segment->file.open(segment->path, directIO_) || !segment->file.preallocate(segmentSize_)) {
+            std::cerr << "Failed to create WAL segment: " << segment->path << std::endl;
+            return false;
+        }
         
-        if (fileStream_.bad()) {
-            std::cerr << "Failed to write to WAL log" << std::endl;
+        // Header block plus a zeroed block: a reused file must not show its
+        // old records where the first new one will go
+        std::string header(SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+        putFixed64(header, segment->id);
+        putFixed64(header, segment->prevLsn);
+        putFixed32(header, core::utils::crc32(header.data(), header.size()));
+        header.resize(SEGMENT_HEADER_SIZE + DIRECT_IO_ALIGNMENT, '\0');
+        AlignedBuffer aligned;
+        if (!segment->file.writeAt(0, aligned.assign(header), header.size()) || !segment->file.sync()) {
+            std::cerr << "Failed to write WAL segment header: " << segment->path << std::endl;
             return false;
         }
+        syncDirectory(std::filesystem::path(segment->path).parent_path().string());
         
+        segments_.push_back(segment);
+        if (reused) {
+            stats_.segmentsReused++;
+        } else {
+            stats_.segmentsCreated++;
+        }
         return true;
     }
     
-    bool replayLogs() {
-        if (isOpen_) {
-            closeLog();
+    bool readHeader(Segment& segment) const {
+        std::FILE* in = std::fopen(segment.path.c_str(), "rb");
+        if (in == nullptr) {
+            return false;
         }
-        
-        std::ifstream replayStream(logFileName_, std::ios::binary);
-        if (!replayStream.is_open()) {
-            std::cout << "No WAL log file to replay" << std::endl;
+        unsigned char header[28];
+        bool ok = std::fread(header, 1, sizeof(header), in) == sizeof(header);
+        std::fclose(in);
+        if (!ok || std::memcmp(header, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0 ||
+            getFixed(header + 24, 4) != core::utils::crc32(header, 24) ||
+            getFixed(header + 8, 8) != segment.id) {
+            return false;
+        }
+        segment.prevLsn = getFixed(header + 16, 8);
+        return true;
+    }
+    
+    // Direct I/O rewrites the last partial block, so keep its bytes
+    bool loadTail(Segment& segment) {
+        segment.tail.clear();
+        if (!segment.file.isDirect()) {
             return true;
         }
+        uint64_t blockStart = segment.appendOffset - segment.appendOffset % DIRECT_IO_ALIGNMENT;
+        segment.tail.resize(segment.appendOffset - blockStart);
+        std::FILE* in = std::fopen(segment.path.c_str(), "rb");
+        if (in == nullptr) {
+            return false;
+        }
+        bool ok = std::fseek(in, static_cast<long>(blockStart), SEEK_SET) == 0 &&
+                  std::fread(&segment.tail[0], 1, segment.tail.size(), in) == segment.tail.size();
+        std::fclose(in);
+        return ok;
+    }
+    
+    // Leader only. Every write ends with a zeroed record header, which marks
+    // the end of the log until the next write replaces it.
+    bool writeChunk(Segment& segment, uint64_t offset, const std::string& bytes) {
+        if (!segment.file.isOpen() && !segment.file.open(segment.path, directIO_)) {
+            return false;
+        }
+        if (!segment.file.isDirect()) {
+            std::string data = bytes;
+            data.append(RECORD_HEADER_SIZE, '\0');
+            return segment.file.writeAt(offset, data.data(), data.size());
+        }
         
-        std::cout << "Starting WAL log replay" << std::endl;
+        // O_DIRECT needs whole aligned blocks: start at the partial block
+        // left by the previous write and pad the end with zeros
+        uint64_t blockStart = offset - segment.tail.size();
+        std::string data = segment.tail + bytes;
+        size_t used = data.size();
+        data.append(RECORD_HEADER_SIZE, '\0');
+        data.resize((data.size() + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT, '\0');
         
-        while (replayStream.good()) {
-            // Read timestamp
-            int64_t timestamp;
-            replayStream.read(reinterpret_cast<char*>(&timestamp), sizeof(timestamp));
-            if (replayStream.eof()) break;
-            if (replayStream.gcount() != sizeof(timestamp)) {
-                std::cerr << "Incomplete timestamp in WAL log" << std::endl;
+        AlignedBuffer aligned;
+        if (!segment.file.writeAt(blockStart, aligned.assign(data), data.size())) {
+            return false;
+        }
+        size_t tailStart = used - used % DIRECT_IO_ALIGNMENT;
+        segment.tail = data.substr(tailStart, used - tailStart);
+        return true;
+    }
+    
+    /**
+     * @brief Verify the records of one segment
+     * 
+     * @param segment The segment to read
+     * @param lastLsn The lsn before the segment; records must exceed it
+     * @param handler Receives records above fromLsn (may be null)
+     * @param result Receives where and how the records end
+     * @return false if the file can't be read
+     */
+    bool scanSegment(const Segment& segment, uint64_t lastLsn, const ReplayHandler* handler,
+                     uint64_t fromLsn, ScanResult& result) const {
+        result = ScanResult();
+        result.lastLsn = lastLsn;
+        
+        std::FILE* in = std::fopen(segment.path.c_str(), "rb");
+        if (in == nullptr) {
+            std::cerr << "Failed to open WAL segment for reading: " << segment.path << std::endl;
+            return false;
+        }
+        std::error_code ec;
+        uint64_t fileSize = std::filesystem::file_size(segment.path, ec);
+        if (ec || std::fseek(in, static_cast<long>(SEGMENT_HEADER_SIZE), SEEK_SET) != 0) {
+            std::fclose(in);
+            return false;
+        }
+        
+        std::string payload;
+        WALRecord record;
+        while (true) {
+            unsigned char header[RECORD_HEADER_SIZE] = {};
+            size_t got = std::fread(header, 1, RECORD_HEADER_SIZE, in);
+            bool zero = std::all_of(header, header + got, [](unsigned char byte) { return byte == 0; });
+            if (got < RECORD_HEADER_SIZE || zero) {
+                // A terminator or the end of the file; anything else is torn
+                result.clean = zero;
                 break;
             }
             
-            // Read data length
-            uint32_t dataLength;
-            replayStream.read(reinterpret_cast<char*>(&dataLength), sizeof(dataLength));
-            if (replayStream.gcount() != sizeof(dataLength)) {
-                std::cerr << "Incomplete data length in WAL log" << std::endl;
+            uint64_t length = getFixed(header, 4);
+            auto checksum = static_cast<uint32_t>(getFixed(header + 4, 4));
+            uint64_t lsn = getFixed(header + 8, 8);
+            if (length > fileSize - result.validEnd - RECORD_HEADER_SIZE || lsn <= result.lastLsn) {
+                result.clean = false;
+                break;
+            }
+            payload.resize(length);
+            if (length > 0 && std::fread(&payload[0], 1, length, in) != length) {
+                result.clean = false;
                 break;
             }
             
-            // Read data
-            std::string data(dataLength, '\0');
-            replayStream.read(&data[0], dataLength);
-            if (replayStream.gcount() != dataLength) {
-                std::cerr << "Incomplete data in WAL log" << std::endl;
+            uint32_t crc = core::utils::crc32(header + 8, 8);
+            crc = core::utils::crc32(payload.data(), payload.size(), crc);
+            if (crc != checksum) {
+                result.clean = false;
                 break;
             }
             
-            // Process the log entry (in a real implementation, this would apply the changes)
-            std::cout << "Replaying log entry: timestamp=" << timestamp << ", data=" << data << std::endl;
+            if (handler != nullptr && lsn > fromLsn) {
+                if (!record.decode(payload)) {
+                    result.clean = false;
+                    break;
+                }
+                record.lsn = lsn;
+                (*handler)(record);
+            }
+            result.lastLsn = lsn;
+            result.validEnd += RECORD_HEADER_SIZE + length;
         }
         
-        replayStream.close();
-        std::cout << "WAL log replay completed" << std::endl;
+        std::fclose(in);
         return true;
     }
     
-private:
     std::string logFileName_;
-    std::fstream fileStream_;
+    uint64_t segmentSize_;
+    bool directIO_;
     bool isOpen_;
+    std::vector<std::shared_ptr<Segment>> segments_;  // The live chain; back() is active
+    std::vector<std::string> spares_;
+    uint64_t nextSegmentId_;
+    
+    // Appended but not yet taken by a leader
+    std::vector<PendingWrite> pending_;  // Tails of segments sealed since the last round
+    std::string buffer_;                 // Bytes for the active segment
+    uint64_t bufferOffset_;              // Where buffer_ goes in the active segment
+    
+    uint64_t lastLsn_;
+    uint64_t writtenLsn_;
+    uint64_t durableLsn_;
+    bool leaderActive_;
+    bool failed_;
+    std::vector<std::shared_ptr<Segment>> dirty_;  // Owned by the leader
+    WALStats stats_;
+    
+    std::mutex mutex_;
+    std::condition_variable cv_;
 };
 
-WALManager::WALManager() : pImpl(std::make_unique<Impl>()) {
+WALManager::WALManager() : WALManager("wal.log") {
+}
+
+WALManager::WALManager(const std::string& logFileName) : pImpl(std::make_unique<Impl>(logFileName)) {
     std::cout << "PhantomDB WAL Manager initialized" << std::endl;
 }
 
@@ -142,16 +847,124 @@ bool WALManager::initialize() {
 
 void WALManager::shutdown() {
     std::cout << "Shutting down PhantomDB WAL Manager" << std::endl;
-    // Cleanup will happen in destructor
+    std::unique_lock<std::mutex> lock(pImpl->mutex_);
+    pImpl->closeLog(lock, true);
 }
 
 bool WALManager::writeLogEntry(const std::string& data) {
-    return pImpl->writeLogEntry(data);
+    WALRecord record;
+    record.operation = "LOG_ENTRY";
+    record.data.emplace_back("entry", data);
+    
+    uint64_t lsn = appendRecord(record);
+    return lsn != 0 && commit(lsn);
 }
 
 bool WALManager::replayLogs() {
-    return pImpl->replayLogs();
+    std::cout << "Starting WAL log replay" << std::endl;
+    bool result = replay([](const WALRecord& record) {
+        // Process the log entry (in a real implementation, this would apply the changes)
+        std::cout << "Replaying log entry: lsn=" << record.lsn << ", timestamp=" << record.timestamp
+                  << ", operation=" << record.operation;
+        if (!record.table.empty()) {
+            std::cout << ", table=" << record.table;
+        }
+        for (const auto& field : record.data) {
+            std::cout << ", " << field.first << "=" << field.second;
+        }
+        std::cout << std::endl;
+    });
+    std::cout << "WAL log replay completed" << std::endl;
+    return result;
+}
+
+void WALManager::setSegmentSize(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    pImpl->segmentSize_ = std::max<uint64_t>(bytes, SEGMENT_HEADER_SIZE + DIRECT_IO_ALIGNMENT);
+}
+
+void WALManager::setDirectIO(bool enabled) {
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    pImpl->directIO_ = enabled;
+}
+
+bool WALManager::open() {
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    return pImpl->openLog();
+}
+
+uint64_t WALManager::appendRecord(const WALRecord& record) {
+    WALRecord stamped = record;
+    if (stamped.timestamp == 0) {
+        stamped.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    std::string payload = stamped.encode();
+    
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    if (!pImpl->openLog()) {
+        return 0;
+    }
+    uint64_t lsn = record.lsn != 0 ? record.lsn : pImpl->lastLsn_ + 1;
+    return pImpl->append(lsn, payload) ? lsn : 0;
+}
+
+bool WALManager::append(uint64_t lsn, const std::string& payload) {
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    return pImpl->openLog() && pImpl->append(lsn, payload);
+}
+
+bool WALManager::commit(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(pImpl->mutex_);
+    if (!pImpl->isOpen_) {
+        return lsn == 0;
+    }
+    return pImpl->writeOut(lock, std::min(lsn, pImpl->lastLsn_), true);
+}
+
+bool WALManager::flush() {
+    std::unique_lock<std::mutex> lock(pImpl->mutex_);
+    return !pImpl->isOpen_ || pImpl->writeOut(lock, pImpl->lastLsn_, false);
+}
+
+bool WALManager::sync() {
+    std::unique_lock<std::mutex> lock(pImpl->mutex_);
+    return !pImpl->isOpen_ || pImpl->writeOut(lock, pImpl->lastLsn_, true);
+}
+
+bool WALManager::replay(const ReplayHandler& handler, uint64_t fromLsn) {
+    std::unique_lock<std::mutex> lock(pImpl->mutex_);
+    return pImpl->openLog() && pImpl->replay(lock, handler, fromLsn);
+}
+
+size_t WALManager::recycleSegments(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(pImpl->mutex_);
+    return pImpl->isOpen_ ? pImpl->recycle(lock, lsn) : 0;
+}
+
+uint64_t WALManager::getLastLsn() const {
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    return pImpl->lastLsn_;
+}
+
+uint64_t WALManager::getDurableLsn() const {
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    return pImpl->durableLsn_;
+}
+
+size_t WALManager::getSegmentCount() const {
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    return pImpl->segments_.size();
+}
+
+WALStats WALManager::getStats() const {
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    return pImpl->stats_;
+}
+
+const std::string& WALManager::getLogFileName() const {
+    return pImpl->logFileName_;
 }
 
 } // namespace storage
-} // namespace phantomdb
\ No newline at end of file
+} // namespace phantomdb
@@ -2,14 +2,100 @@
 #define PHANTOMDB_WAL_MANAGER_H
 
 #include <string>
+#include <vector>
 #include <memory>
+#include <functional>
+#include <cstdint>
 
 namespace phantomdb {
 namespace storage {
 
+// Kind of change a WAL record describes
+enum class WALRecordType : uint8_t {
+    CUSTOM = 0,           // Free-form entry named by WALRecord::operation
+    CREATE_DATABASE = 1,
+    DROP_DATABASE = 2,
+    CREATE_TABLE = 3,     // columns holds the schema in declaration order
+    DROP_TABLE = 4,
+    INSERT = 5,           // data holds the new row
+    UPDATE = 6,           // data holds the new values, condition the row filter
+    DELETE = 7            // condition holds the row filter
+};
+
+/**
+ * @brief A typed write-ahead log record
+ * 
+ * On disk every record is framed as
+ *   [u32 payload length][u32 crc32 of lsn + payload][u64 lsn][payload]
+ * and the payload is
+ *   u8 type | varint timestamp | [string operation, CUSTOM only] | string table |
+ *   fields columns | fields data | fields condition
+ * where a string is varint length + bytes and fields are a varint count
+ * followed by key/value strings.
+ */
+struct WALRecord {
+    using Fields = std::vector<std::pair<std::string, std::string>>;
+    
+    uint64_t lsn = 0;
+    int64_t timestamp = 0;   // Microseconds since the Unix epoch
+    WALRecordType type = WALRecordType::CUSTOM;
+    std::string operation;   // Set to the type name for typed records
+    std::string table;
+    Fields columns;
+    Fields data;
+    Fields condition;
+    
+    /**
+     * @brief Encode the record payload (everything except the lsn)
+     */
+    std::string encode() const;
+    
+    /**
+     * @brief Decode a record payload; the lsn is left unchanged
+     * 
+     * @return false if the payload is malformed
+     */
+    bool decode(const std::string& payload);
+    
+    // Map between operation names and record types; unknown names are CUSTOM
+    static const char* typeName(WALRecordType type);
+    static WALRecordType typeFromName(const std::string& operation);
+};
+
+// Counters describing the work a WALManager has done since it was opened
+struct WALStats {
+    uint64_t recordsAppended = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t syncs = 0;              // fdatasync calls; recordsAppended / syncs is the group size
+    uint64_t segmentsCreated = 0;    // New segment files preallocated
+    uint64_t segmentsReused = 0;     // Recycled segment files put back into use
+    uint64_t segmentsRecycled = 0;   // Segments released after a checkpoint
+};
+
+/**
+ * @brief Segmented write-ahead log with group commit
+ * 
+ * The log is a chain of fixed-size segment files named
+ * <logFileName>.00000001, <logFileName>.00000002, ... Each segment is
+ * preallocated when created and starts with a 4 KiB header holding its
+ * id and the lsn of the last record before it; records follow back to
+ * back. Segments released by recycleSegments() are renamed to spares and
+ * reused for later segments, so steady-state writes overwrite allocated
+ * blocks and fdatasync has no file size metadata to flush.
+ * 
+ * Any number of threads may append and commit. appendRecord() only
+ * buffers; commit() makes the calling thread either the commit leader,
+ * which writes everything buffered so far with one write per segment and
+ * one fdatasync, or a follower that waits for a leader covering its lsn.
+ */
 class WALManager {
 public:
+    using ReplayHandler = std::function<void(const WALRecord&)>;
+    
+    static const uint64_t DEFAULT_SEGMENT_SIZE = 16 * 1024 * 1024;
+    
     WALManager();
+    explicit WALManager(const std::string& logFileName);
     ~WALManager();
     
     // Initialize the WAL manager
@@ -18,12 +104,109 @@ public:
     // Shutdown the WAL manager
     void shutdown();
     
-    // Write a log entry
+    // Write a log entry and wait until it is durable
     bool writeLogEntry(const std::string& data);
     
     // Replay log entries
     bool replayLogs();
     
+    /**
+     * @brief Set the size of new segment files (before the log is opened)
+     */
+    void setSegmentSize(uint64_t bytes);
+    
+    /**
+     * @brief Write with O_DIRECT where supported (before the log is opened)
+     * 
+     * Records then bypass the page cache; the last partial block is
+     * rewritten by the next commit. Falls back to buffered writes if the
+     * file system rejects O_DIRECT. fdatasync is still issued per commit.
+     */
+    void setDirectIO(bool enabled);
+    
+    /**
+     * @brief Open the log for appending
+     * 
+     * The segment chain is validated and recovery-style cleanup is done:
+     * segments after a torn or corrupt record are discarded, and if the
+     * active segment ends in a torn write, appending continues in a new
+     * segment so no stale record can be mistaken for a later one.
+     * Appending opens the log implicitly.
+     * 
+     * @return true if successful, false otherwise
+     */
+    bool open();
+    
+    /**
+     * @brief Append a typed record
+     * 
+     * The record is buffered; call commit() to make it durable.
+     * 
+     * @param record The record to append; an lsn of 0 means "next after the last"
+     * @return The lsn of the record, or 0 on failure
+     */
+    uint64_t appendRecord(const WALRecord& record);
+    
+    /**
+     * @brief Append an already encoded record payload
+     * 
+     * @param lsn The log sequence number; must be above every lsn in the log
+     * @param payload The output of WALRecord::encode()
+     * @return true if successful, false otherwise
+     */
+    bool append(uint64_t lsn, const std::string& payload);
+    
+    /**
+     * @brief Wait until every record up to lsn is durable (group commit)
+     * 
+     * @param lsn The lsn returned by appendRecord(), or any lower one
+     * @return false if a write or sync failed
+     */
+    bool commit(uint64_t lsn);
+    
+    // Write buffered records to the segment files without syncing
+    bool flush();
+    
+    // Commit everything appended so far
+    bool sync();
+    
+    /**
+     * @brief Read back every intact record of the log in order
+     * 
+     * Reading stops at the first torn or corrupt record. Segments that end
+     * at or before fromLsn are skipped without being read. Records still
+     * buffered are written out first.
+     * 
+     * @param handler Called for each record with an lsn above fromLsn
+     * @param fromLsn Records up to and including this lsn are skipped
+     * @return false if the log could not be read
+     */
+    bool replay(const ReplayHandler& handler, uint64_t fromLsn = 0);
+    
+    /**
+     * @brief Release segments whose records are all covered by a checkpoint
+     * 
+     * Only whole segments at the head of the chain are released, and never
+     * the active one. Released files are kept as spares for reuse.
+     * 
+     * @param lsn The checkpoint lsn; records up to it are no longer needed
+     * @return The number of segments released
+     */
+    size_t recycleSegments(uint64_t lsn);
+    
+    // The highest lsn appended (0 if empty or not yet opened)
+    uint64_t getLastLsn() const;
+    
+    // The highest lsn known to be durable
+    uint64_t getDurableLsn() const;
+    
+    // Number of segments in the live chain
+    size_t getSegmentCount() const;
+    
+    WALStats getStats() const;
+    
+    const std::string& getLogFileName() const;
+
 private:
     class Impl;
     std::unique_ptr<Impl> pImpl;
@@ -32,4 +215,4 @@ private:
 } // namespace storage
 } // namespace phantomdb
 
-#endif // PHANTOMDB_WAL_MANAGER_H
\ No newline at end of file
+#endif // PHANTOMDB_WAL_MANAGER_H
@@ -1,26 +1,235 @@
 #include "wal_manager.h"
 #include <iostream>
 #include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using phantomdb::storage::WALManager;
+using phantomdb::storage::WALRecord;
+
+namespace {
+
+const std::string dataDir = "./wal_test_data";
+
+WALRecord entry(const std::string& value) {
+    WALRecord record;
+    record.operation = "LOG_ENTRY";
+    record.data.emplace_back("entry", value);
+    return record;
+}
+
+std::vector<WALRecord> readAll(WALManager& log, uint64_t fromLsn = 0) {
+    std::vector<WALRecord> records;
+    assert(log.replay([&records](const WALRecord& record) { records.push_back(record); }, fromLsn));
+    return records;
+}
+
+// Overwrite every occurrence of marker in the segment files with zeros
+bool eraseMarker(const std::string& logFileName, const std::string& marker) {
+    bool found = false;
+    std::string prefix = std::filesystem::path(logFileName).filename().string() + ".";
+    for (const auto& file : std::filesystem::directory_iterator(dataDir)) {
+        if (file.path().filename().string().compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        std::string bytes;
+        {
+            std::ifstream in(file.path(), std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        size_t pos = bytes.find(marker);
+        if (pos == std::string::npos) {
+            continue;
+        }
+        std::fstream out(file.path(), std::ios::binary | std::ios::in | std::ios::out);
+        out.seekp(static_cast<std::streamoff>(pos));
+        out.write(std::string(marker.size(), '\0').data(), static_cast<std::streamsize>(marker.size()));
+        found = true;
+    }
+    return found;
+}
+
+} // anonymous namespace
 
 int main() {
     std::cout << "Testing WAL Manager..." << std::endl;
     
-    phantomdb::storage::WALManager walManager;
+    {
+        phantomdb::storage::WALManager walManager;
+        
+        // Test initialization
+        assert(walManager.initialize());
+        std::cout << "Initialization test passed" << std::endl;
+        
+        // Test writing log entries
+        assert(walManager.writeLogEntry("First log entry"));
+        assert(walManager.writeLogEntry("Second log entry"));
+        assert(walManager.writeLogEntry("Third log entry"));
+        std::cout << "Write log entries test passed" << std::endl;
+        
+        // Test log replay
+        assert(walManager.replayLogs());
+        std::cout << "Log replay test passed" << std::endl;
+    }
+    
+    std::filesystem::remove_all(dataDir);
+    std::filesystem::create_directories(dataDir);
+    const std::string logName = dataDir + "/segments.log";
+    const uint64_t segmentSize = 8 * 1024;
+    
+    // Test segment rotation and lsn continuation across reopen
+    {
+        WALManager log(logName);
+        log.setSegmentSize(segmentSize);
+        for (int i = 1; i <= 500; ++i) {
+            assert(log.appendRecord(entry("record " + std::to_string(i))) == static_cast<uint64_t>(i));
+        }
+        assert(log.commit(500));
+        assert(log.getDurableLsn() == 500);
+        assert(log.getSegmentCount() > 3);
+    }
+    {
+        WALManager log(logName);
+        log.setSegmentSize(segmentSize);
+        auto records = readAll(log);
+        assert(records.size() == 500);
+        for (size_t i = 0; i < records.size(); ++i) {
+            assert(records[i].lsn == i + 1);
+            assert(records[i].data[0].second == "record " + std::to_string(i + 1));
+        }
+        assert(readAll(log, 450).size() == 50);
+        assert(log.appendRecord(entry("after reopen")) == 501);
+        assert(log.commit(501));
+    }
+    std::cout << "Segment rotation test passed" << std::endl;
+    
+    // Test recycling segments covered by a checkpoint
+    {
+        WALManager log(logName);
+        log.setSegmentSize(segmentSize);
+        assert(log.open());
+        size_t before = log.getSegmentCount();
+        size_t released = log.recycleSegments(400);
+        assert(released > 0 && log.getSegmentCount() == before - released);
+        
+        // Records after the checkpoint are all still there
+        auto records = readAll(log, 400);
+        assert(records.size() == 101 && records.back().lsn == 501);
+        
+        // New segments reuse the released files
+        for (int i = 0; i < 300; ++i) {
+            log.appendRecord(entry("more " + std::to_string(i)));
+        }
+        assert(log.sync());
+        assert(log.getStats().segmentsReused > 0);
+    }
+    {
+        WALManager log(logName);
+        log.setSegmentSize(segmentSize);
+        auto records = readAll(log, 400);
+        assert(records.size() == 401 && records.back().lsn == 801);
+    }
+    std::cout << "Segment recycling test passed" << std::endl;
+    
+    // Test concurrent commits: lsns are unique and every commit is durable
+    {
+        const std::string concurrentName = dataDir + "/concurrent.log";
+        const int threadCount = 8;
+        const int commitsPerThread = 200;
+        {
+            WALManager log(concurrentName);
+            std::vector<std::thread> threads;
+            for (int t = 0; t < threadCount; ++t) {
+                threads.emplace_back([&log, t]() {
+                    for (int i = 0; i < commitsPerThread; ++i) {
+                        uint64_t lsn = log.appendRecord(entry(std::to_string(t) + ":" + std::to_string(i)));
+                        assert(lsn != 0);
+                        assert(log.commit(lsn));
+                        assert(log.getDurableLsn() >= lsn);
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            auto stats = log.getStats();
+            assert(stats.recordsAppended == threadCount * commitsPerThread);
+            assert(stats.syncs > 0 && stats.syncs <= stats.recordsAppended);
+        }
+        
+        WALManager log(concurrentName);
+        auto records = readAll(log);
+        assert(records.size() == threadCount * commitsPerThread);
+        for (size_t i = 0; i < records.size(); ++i) {
+            assert(records[i].lsn == i + 1);
+        }
+    }
+    std::cout << "Concurrent group commit test passed" << std::endl;
     
-    // Test initialization
-    assert(walManager.initialize());
-    std::cout << "Initialization test passed" << std::endl;
+    // Test that a torn record ends the log and later writes stay readable
+    {
+        const std::string tornName = dataDir + "/torn.log";
+        {
+            WALManager log(tornName);
+            log.appendRecord(entry("intact"));
+            log.appendRecord(entry("TORN-RECORD-MARKER"));
+            assert(log.sync());
+        }
+        assert(eraseMarker(tornName, "TORN-RECORD-MARKER"));
+        {
+            WALManager log(tornName);
+            auto records = readAll(log);
+            assert(records.size() == 1 && records[0].data[0].second == "intact");
+            assert(log.appendRecord(entry("after crash")) == 2);
+            assert(log.sync());
+            assert(log.getSegmentCount() == 2);
+        }
+        
+        WALManager log(tornName);
+        auto records = readAll(log);
+        assert(records.size() == 2 && records[1].data[0].second == "after crash");
+    }
+    std::cout << "Torn record test passed" << std::endl;
     
-    // Test writing log entries
-    assert(walManager.writeLogEntry("First log entry"));
-    assert(walManager.writeLogEntry("Second log entry"));
-    assert(walManager.writeLogEntry("Third log entry"));
-    std::cout << "Write log entries test passed" << std::endl;
+    // Test direct I/O (falls back to buffered writes where unsupported)
+    {
+        const std::string directName = dataDir + "/direct.log";
+        {
+            WALManager log(directName);
+            log.setDirectIO(true);
+            log.setSegmentSize(segmentSize);
+            for (int i = 0; i < 300; ++i) {
+                uint64_t lsn = log.appendRecord(entry("direct " + std::to_string(i)));
+                if (i % 7 == 0) {
+                    assert(log.commit(lsn));
+                }
+            }
+            assert(log.sync());
+        }
+        {
+            // Reopening continues in the partially written block
+            WALManager log(directName);
+            log.setDirectIO(true);
+            log.setSegmentSize(segmentSize);
+            assert(log.appendRecord(entry("direct tail")) == 301);
+            assert(log.sync());
+        }
+        WALManager log(directName);
+        auto records = readAll(log);
+        assert(records.size() == 301);
+        for (size_t i = 0; i < 300; ++i) {
+            assert(records[i].data[0].second == "direct " + std::to_string(i));
+        }
+        assert(records.back().data[0].second == "direct tail");
+    }
+    std::cout << "Direct I/O test passed" << std::endl;
     
-    // Test log replay
-    assert(walManager.replayLogs());
-    std::cout << "Log replay test passed" << std::endl;
+    std::filesystem::remove_all(dataDir);
     
     std::cout << "All WAL Manager tests passed!" << std::endl;
     return 0;
-}
\ No newline at end of file
+}